@@ -0,0 +1,1416 @@
+/**
+ * file: bench_apx_es_link.c
+ * description: host-side simulation of embedded APX nodes. Every node runs apx_es_fileManager (built with APX_EMBEDDED)
+ *              on the device end of an emulated serial link, a pipe pair, a socketpair or a pty. The host end of the link
+ *              is relayed by a gateway to apx_server over loopback TCP (already running or started with --server).
+ *              The device side of the link is shaped to a given baud rate and the device transmit buffer and frame
+ *              length can be limited, which emulates UART or SPI links.
+ *              Node n requires the signals provided by node n-1. Each signal write carries a sequence number in its
+ *              first four bytes, which gives the update latency from apx_nodeData_outPortDataNotify on one device to
+ *              inPortDataWritten on the other device.
+ *              Reports payload efficiency (port data bytes vs bytes on the link), update latency, superseded and lost
+ *              values and message queue usage for each signal size given with --sizes.
+ *              POSIX only.
+ */
+//////////////////////////////////////////////////////////////////////////////
+// DEFINES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE //ppoll, posix_openpt
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "apx_es_fileManager.h"
+#include "apx_nodeData.h"
+#include "apx_file.h"
+#include "headerutil.h"
+#include "pack.h"
+#include "rmf.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_NUM_NODES          2u
+#define DEFAULT_NUM_SIGNALS        16u
+#define DEFAULT_RATE               200u //signal writes per second and node
+#define DEFAULT_DURATION           5.0  //seconds
+#define DEFAULT_TCP_PORT           5000u
+#define DEFAULT_BAUD               115200u
+#define DEFAULT_FIFO_SIZE          256u //bytes
+#define DEFAULT_QUEUE_LEN          16u //messages
+#define DEFAULT_RECEIVE_BUF_LEN    256u
+#define DEFAULT_SIGNAL_SIZE        4u
+
+#define BENCH_LINK_PIPE            1u
+#define BENCH_LINK_SOCKETPAIR      2u
+#define BENCH_LINK_PTY             3u
+
+#define BENCH_SEQ_SIZE             4u //every signal starts with the sequence number of the write
+#define BENCH_MAX_SIGNAL_SIZE      1024u
+#define BENCH_MAX_SIZES            16
+#define BENCH_SEQ_RING_LEN         8192u //must be a power of 2
+#define BENCH_MAX_LATENCY_SAMPLES  (1u << 20)
+#define BENCH_MAX_NAME_LEN         32u
+#define BENCH_MAX_FRAME_HEADER     4u
+//file info commands are never fragmented, they must fit in one frame (node name, file extension and null terminator)
+#define BENCH_MIN_FRAME_SIZE       (BENCH_MAX_FRAME_HEADER + RMF_HIGH_ADDRESS_SIZE + CMD_FILE_INFO_BASE_SIZE + BENCH_MAX_NAME_LEN + 5u)
+#define BENCH_CONNECT_TIMEOUT      10.0 //seconds
+#define BENCH_DRAIN_TIMEOUT        5.0  //seconds
+#define BENCH_MAX_WAIT             0.001 //longest time the main loop sleeps
+#define BENCH_BURST_TIME           0.002 //the link may catch up on this much lost time at once (coarse scheduling)
+#define BENCH_IO_CHUNK             4096u
+#define BENCH_GREETING             RMF_GREETING_START RMF_NUMHEADER_FORMAT "32\n\n"
+
+typedef struct benchConfig_tag
+{
+   uint32_t numNodes;
+   uint32_t numSignals;
+   uint32_t rate;
+   double duration;
+   uint8_t link;
+   uint32_t baud;
+   double bytesPerSec; //0 when the link is not shaped
+   uint32_t frameSize; //longest frame (length header and message) produced by the device
+   uint32_t fifoSize;
+   uint16_t queueLen;
+   uint16_t receiveBufLen;
+   uint32_t signalSizes[BENCH_MAX_SIZES];
+   int numSizes;
+   uint16_t tcpPort;
+   const char *serverPath;
+   const char *jsonFile;
+}benchConfig_t;
+
+/**
+ * growable byte buffer, data is appended at the end and consumed from the beginning
+ */
+typedef struct benchBuf_tag
+{
+   uint8_t *data;
+   uint32_t len;
+   uint32_t capacity;
+}benchBuf_t;
+
+typedef struct esNode_tag
+{
+   uint32_t id;
+   char name[BENCH_MAX_NAME_LEN];
+   const benchConfig_t *cfg;
+   uint32_t signalSize;
+   //device side
+   apx_nodeData_t nodeData;
+   apx_file_t definitionFile;
+   apx_file_t outDataFile;
+   apx_file_t inDataFile;
+   apx_es_fileManager_t fileManager;
+   char *definition;
+   uint32_t definitionLen;
+   uint32_t dataLen; //length of both the .out and the .in file
+   uint8_t *outData;
+   uint8_t *inData;
+   uint8_t *inShadow;
+   uint8_t *messageQueueBuf;
+   uint8_t *receiveBuf;
+   uint8_t *frameBuf; //send buffer handed to the fileManager, one frame at a time
+   benchBuf_t txFifo; //device transmit buffer, drained onto the link at the link rate
+   benchBuf_t rxBuf; //bytes read from the link and not yet parsed
+   double txCredit; //bytes the link can carry right now, per direction
+   double rxCredit;
+   double lastShapeTime;
+   bool isAckSeen;
+   bool isInReceived;
+   bool isConnected;
+   double connectStart;
+   double connectTime;
+   //link, the fds are the same for both directions except for the pipe link
+   int devTxFd;
+   int devRxFd;
+   int hostRxFd;
+   int hostTxFd;
+   //gateway
+   int brokerFd;
+   benchBuf_t toBroker;
+   benchBuf_t toDevice;
+   //traffic
+   uint32_t nextSeq;
+   uint32_t sendSeq[BENCH_SEQ_RING_LEN];
+   double sendTime[BENCH_SEQ_RING_LEN];
+   uint32_t *lastSent; //last value written to each provided signal
+   uint32_t *lastSeq; //last value received for each required signal
+   uint64_t numSent;
+   uint64_t numReceived;
+   uint64_t wireBytesTx;
+   uint64_t payloadBytesTx;
+   uint64_t wireBytesRx;
+   uint64_t payloadBytesRx;
+   uint64_t numFramesTx;
+   uint64_t numFragmentsTx;
+   uint16_t queueHighWater;
+   uint64_t numQueueFull; //writes made while the message queue was full
+   struct esNode_tag *provider; //the node providing the signals this node requires
+}esNode_t;
+
+typedef struct benchResult_tag
+{
+   uint32_t signalSize;
+   double elapsed;
+   uint64_t numSent;
+   uint64_t numReceived;
+   uint64_t numSuperseded; //values overwritten by a newer value of the same signal before they were sent
+   uint32_t numLost; //signals whose last value never arrived
+   uint64_t wireBytesTx;
+   uint64_t payloadBytesTx;
+   uint64_t wireBytesRx;
+   uint64_t payloadBytesRx;
+   uint64_t numFramesTx;
+   uint64_t numFragmentsTx;
+   double txEfficiency;
+   double rxEfficiency;
+   double linkLoad; //share of the link capacity used in the device transmit direction
+   double latencyP50;
+   double latencyP99;
+   double latencyMax;
+   uint32_t numLatencySamples;
+   uint16_t queueHighWater;
+   uint64_t numQueueFull;
+   double connectAvg;
+}benchResult_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static int parseArgs(int argc, char **argv, benchConfig_t *cfg);
+static void printUsage(const char *name);
+static int runScenario(const benchConfig_t *cfg, uint32_t signalSize, benchResult_t *result);
+static void printResult(const benchResult_t *result);
+static int writeJson(const char *fileName, const benchConfig_t *cfg, const benchResult_t *results, int numResults);
+static const char *linkName(uint8_t link);
+static double getTimeSec(void);
+static pid_t startServer(const char *path, uint16_t port);
+static void stopServer(pid_t pid);
+static int compareDouble(const void *a, const void *b);
+static double percentile(const double *sorted, uint32_t len, double p);
+static void setNonBlocking(int fd);
+
+static int8_t benchBuf_append(benchBuf_t *self, const uint8_t *data, uint32_t len);
+static void benchBuf_consume(benchBuf_t *self, uint32_t len);
+static void benchBuf_destroy(benchBuf_t *self);
+
+static int8_t esNode_create(esNode_t *self, uint32_t id, uint32_t prevId, const benchConfig_t *cfg, uint32_t signalSize);
+static void esNode_destroy(esNode_t *self);
+static int8_t esNode_openLink(esNode_t *self);
+static int8_t esNode_connect(esNode_t *self);
+static void esNode_disconnect(esNode_t *self);
+static void esNode_writeSignal(esNode_t *self);
+static void esNode_run(esNode_t *self);
+static uint32_t esNode_serviceLink(esNode_t *self, double now);
+static uint32_t esNode_receive(esNode_t *self);
+static void esNode_resetCounters(esNode_t *self);
+static bool esNode_isSettled(const esNode_t *self);
+static int32_t esNode_getSendAvail(void *arg);
+static uint8_t *esNode_getSendBuffer(void *arg, int32_t msgLen);
+static int32_t esNode_send(void *arg, int32_t offset, int32_t msgLen);
+static void esNode_inPortDataWritten(void *arg, apx_nodeData_t *nodeData, uint32_t offset, uint32_t len);
+
+static void waitForData(esNode_t *nodes, uint32_t numNodes, double timeout);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static double *m_latencySamples;
+static uint32_t m_numLatencySamples;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+   benchConfig_t cfg;
+   benchResult_t results[BENCH_MAX_SIZES];
+   int numResults = 0;
+   int retval = 0;
+   int i;
+   if (parseArgs(argc, argv, &cfg) != 0)
+   {
+      printUsage(argv[0]);
+      return 1;
+   }
+   signal(SIGPIPE, SIG_IGN);
+   m_latencySamples = (double*) malloc(BENCH_MAX_LATENCY_SAMPLES*sizeof(double));
+   if (m_latencySamples == 0)
+   {
+      printf("Failed to allocate latency samples\n");
+      return 1;
+   }
+   printf("apx es link: %u nodes, %u signals/node, %u writes/s/node, %.1f s, %s link",
+         (unsigned int) cfg.numNodes, (unsigned int) cfg.numSignals, (unsigned int) cfg.rate, cfg.duration, linkName(cfg.link));
+   if (cfg.baud > 0)
+   {
+      printf(" at %u baud", (unsigned int) cfg.baud);
+   }
+   printf("\n");
+   printf("device: fifo %u bytes, frame %u bytes, queue %u messages, receive buffer %u bytes, fragmentation threshold %u bytes\n",
+         (unsigned int) cfg.fifoSize, (unsigned int) cfg.frameSize, (unsigned int) cfg.queueLen,
+         (unsigned int) cfg.receiveBufLen, (unsigned int) APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD);
+   printf("%6s %10s %10s %10s %6s %8s %8s %8s %10s %10s %10s %8s %8s\n", "size", "sent", "received", "superseded", "lost",
+         "tx eff", "rx eff", "load", "p50 (ms)", "p99 (ms)", "max (ms)", "queue hw", "q full");
+   for (i=0; i<cfg.numSizes; i++)
+   {
+      if (runScenario(&cfg, cfg.signalSizes[i], &results[numResults]) == 0)
+      {
+         printResult(&results[numResults++]);
+      }
+      else
+      {
+         retval = 1;
+      }
+   }
+   if ( (cfg.jsonFile != 0) && (numResults > 0) )
+   {
+      if (writeJson(cfg.jsonFile, &cfg, results, numResults) != 0)
+      {
+         printf("Failed to write %s\n", cfg.jsonFile);
+         retval = 1;
+      }
+   }
+   free(m_latencySamples);
+   return retval;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static int parseArgs(int argc, char **argv, benchConfig_t *cfg)
+{
+   int i;
+   memset(cfg, 0, sizeof(benchConfig_t));
+   cfg->numNodes = DEFAULT_NUM_NODES;
+   cfg->numSignals = DEFAULT_NUM_SIGNALS;
+   cfg->rate = DEFAULT_RATE;
+   cfg->duration = DEFAULT_DURATION;
+   cfg->link = BENCH_LINK_PIPE;
+   cfg->baud = DEFAULT_BAUD;
+   cfg->fifoSize = DEFAULT_FIFO_SIZE;
+   cfg->queueLen = DEFAULT_QUEUE_LEN;
+   cfg->receiveBufLen = DEFAULT_RECEIVE_BUF_LEN;
+   cfg->tcpPort = DEFAULT_TCP_PORT;
+   for (i=1; i<argc; i++)
+   {
+      const char *arg = argv[i];
+      if (strncmp(arg, "--nodes=", 8) == 0)
+      {
+         cfg->numNodes = (uint32_t) strtoul(&arg[8], 0, 10);
+      }
+      else if (strncmp(arg, "--signals=", 10) == 0)
+      {
+         cfg->numSignals = (uint32_t) strtoul(&arg[10], 0, 10);
+      }
+      else if (strncmp(arg, "--rate=", 7) == 0)
+      {
+         cfg->rate = (uint32_t) strtoul(&arg[7], 0, 10);
+      }
+      else if (strncmp(arg, "--duration=", 11) == 0)
+      {
+         cfg->duration = strtod(&arg[11], 0);
+      }
+      else if (strncmp(arg, "--link=", 7) == 0)
+      {
+         if (strcmp(&arg[7], "pipe") == 0)
+         {
+            cfg->link = BENCH_LINK_PIPE;
+         }
+         else if (strcmp(&arg[7], "socketpair") == 0)
+         {
+            cfg->link = BENCH_LINK_SOCKETPAIR;
+         }
+         else if (strcmp(&arg[7], "pty") == 0)
+         {
+            cfg->link = BENCH_LINK_PTY;
+         }
+         else
+         {
+            return -1;
+         }
+      }
+      else if (strncmp(arg, "--baud=", 7) == 0)
+      {
+         cfg->baud = (uint32_t) strtoul(&arg[7], 0, 10);
+      }
+      else if (strncmp(arg, "--frame=", 8) == 0)
+      {
+         cfg->frameSize = (uint32_t) strtoul(&arg[8], 0, 10);
+      }
+      else if (strncmp(arg, "--fifo=", 7) == 0)
+      {
+         cfg->fifoSize = (uint32_t) strtoul(&arg[7], 0, 10);
+      }
+      else if (strncmp(arg, "--queue=", 8) == 0)
+      {
+         cfg->queueLen = (uint16_t) strtoul(&arg[8], 0, 10);
+      }
+      else if (strncmp(arg, "--rxbuf=", 8) == 0)
+      {
+         cfg->receiveBufLen = (uint16_t) strtoul(&arg[8], 0, 10);
+      }
+      else if (strncmp(arg, "--sizes=", 8) == 0)
+      {
+         const char *pNext = &arg[8];
+         while ( (*pNext != 0) && (cfg->numSizes < BENCH_MAX_SIZES) )
+         {
+            char *pEnd;
+            cfg->signalSizes[cfg->numSizes++] = (uint32_t) strtoul(pNext, &pEnd, 10);
+            if (*pEnd == ',')
+            {
+               pEnd++;
+            }
+            else if ( (*pEnd != 0) || (pEnd == pNext) )
+            {
+               return -1;
+            }
+            pNext = pEnd;
+         }
+      }
+      else if (strncmp(arg, "--port=", 7) == 0)
+      {
+         cfg->tcpPort = (uint16_t) strtoul(&arg[7], 0, 10);
+      }
+      else if (strncmp(arg, "--server=", 9) == 0)
+      {
+         cfg->serverPath = &arg[9];
+      }
+      else if (strncmp(arg, "--json=", 7) == 0)
+      {
+         cfg->jsonFile = &arg[7];
+      }
+      else
+      {
+         return -1;
+      }
+   }
+   if (cfg->numSizes == 0)
+   {
+      cfg->signalSizes[cfg->numSizes++] = DEFAULT_SIGNAL_SIZE;
+   }
+   for (i=0; i<cfg->numSizes; i++)
+   {
+      if ( (cfg->signalSizes[i] < BENCH_SEQ_SIZE) || (cfg->signalSizes[i] > BENCH_MAX_SIGNAL_SIZE) )
+      {
+         return -1;
+      }
+   }
+   if (cfg->frameSize == 0)
+   {
+      cfg->frameSize = cfg->fifoSize;
+   }
+   cfg->bytesPerSec = ((double) cfg->baud) / 10.0; //start bit, 8 data bits, stop bit
+   if ( (cfg->numNodes < 2) || (cfg->numSignals == 0) || (cfg->rate == 0) || (cfg->duration <= 0.0) ||
+        (cfg->tcpPort == 0) || (cfg->queueLen == 0) || (cfg->receiveBufLen == 0) ||
+        (cfg->frameSize < BENCH_MIN_FRAME_SIZE) || (cfg->frameSize > cfg->fifoSize) )
+   {
+      return -1;
+   }
+   return 0;
+}
+
+static void printUsage(const char *name)
+{
+   printf("%s [options]\n", name);
+   printf("  --nodes=<n>        number of simulated embedded nodes, at least 2 (default %u)\n", DEFAULT_NUM_NODES);
+   printf("  --signals=<n>      signals provided by each node (default %u)\n", DEFAULT_NUM_SIGNALS);
+   printf("  --sizes=<n,...>    signal sizes in bytes to run, %u..%u (default %u)\n", BENCH_SEQ_SIZE, BENCH_MAX_SIGNAL_SIZE,
+         DEFAULT_SIGNAL_SIZE);
+   printf("  --rate=<n>         signal writes per second and node (default %u)\n", DEFAULT_RATE);
+   printf("  --duration=<sec>   length of traffic phase (default %.0f)\n", DEFAULT_DURATION);
+   printf("  --link=<l>         pipe, socketpair or pty (default pipe)\n");
+   printf("  --baud=<n>         link speed, 10 bits per byte, 0 for unlimited (default %u)\n", DEFAULT_BAUD);
+   printf("  --fifo=<n>         device transmit buffer in bytes (default %u)\n", DEFAULT_FIFO_SIZE);
+   printf("  --frame=<n>        longest frame sent by the device, at least %u (default: fifo size)\n", BENCH_MIN_FRAME_SIZE);
+   printf("  --queue=<n>        fileManager message queue length (default %u)\n", DEFAULT_QUEUE_LEN);
+   printf("  --rxbuf=<n>        fileManager receive buffer length (default %u)\n", DEFAULT_RECEIVE_BUF_LEN);
+   printf("  --port=<n>         TCP port of the broker (default %u)\n", DEFAULT_TCP_PORT);
+   printf("  --server=<path>    start this apx_server executable for each run\n");
+   printf("  --json=<file>      write results as JSON\n");
+   printf("APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD and the other apx_es_fileManager_cfg.h settings are compile time\n");
+   printf("options, rebuild with -D<name>=<value> to compare them.\n");
+}
+
+static int runScenario(const benchConfig_t *cfg, uint32_t signalSize, benchResult_t *result)
+{
+   esNode_t *nodes;
+   pid_t serverPid = 0;
+   uint32_t numNodes = cfg->numNodes;
+   uint32_t numConnected = 0;
+   double start;
+   double stop;
+   double now;
+   double connectSum = 0.0;
+   uint32_t i;
+   int retval = 0;
+
+   memset(result, 0, sizeof(benchResult_t));
+   result->signalSize = signalSize;
+   nodes = (esNode_t*) calloc(numNodes, sizeof(esNode_t));
+   if (nodes == 0)
+   {
+      printf("Failed to allocate nodes\n");
+      return -1;
+   }
+   for (i=0; i<numNodes; i++)
+   {
+      uint32_t prevId = (i + numNodes - 1u) % numNodes;
+      if (esNode_create(&nodes[i], i, prevId, cfg, signalSize) != 0)
+      {
+         printf("Failed to create node %u\n", (unsigned int) i);
+         numNodes = i+1u;
+         retval = -1;
+         break;
+      }
+   }
+   for (i=0; i<numNodes; i++)
+   {
+      nodes[i].provider = &nodes[(i + numNodes - 1u) % numNodes];
+   }
+   m_numLatencySamples = 0;
+   if ( (retval == 0) && (cfg->serverPath != 0) )
+   {
+      serverPid = startServer(cfg->serverPath, cfg->tcpPort);
+      if (serverPid <= 0)
+      {
+         printf("Failed to start %s\n", cfg->serverPath);
+         retval = -1;
+      }
+   }
+
+   //connect phase, the devices greet the broker and exchange files through their links
+   for (i=0; (retval == 0) && (i<numNodes); i++)
+   {
+      if (esNode_connect(&nodes[i]) != 0)
+      {
+         printf("node %u failed to connect\n", (unsigned int) i);
+         retval = -1;
+      }
+   }
+   start = getTimeSec();
+   while ( (retval == 0) && (numConnected < numNodes) )
+   {
+      uint32_t numEvents = 0;
+      now = getTimeSec();
+      if (now - start > BENCH_CONNECT_TIMEOUT)
+      {
+         printf("timeout, %u of %u nodes connected\n", (unsigned int) numConnected, (unsigned int) numNodes);
+         retval = -1;
+         break;
+      }
+      numConnected = 0;
+      for (i=0; i<numNodes; i++)
+      {
+         esNode_run(&nodes[i]);
+         numEvents += esNode_serviceLink(&nodes[i], now);
+         if (nodes[i].isConnected)
+         {
+            numConnected++;
+         }
+      }
+      if (numEvents == 0)
+      {
+         waitForData(nodes, numNodes, BENCH_MAX_WAIT);
+      }
+   }
+
+   //traffic phase
+   if (retval == 0)
+   {
+      for (i=0; i<numNodes; i++)
+      {
+         esNode_resetCounters(&nodes[i]);
+      }
+      start = getTimeSec();
+      now = start;
+      while (now - start < cfg->duration)
+      {
+         uint32_t numEvents = 0;
+         uint64_t due = (uint64_t) ( (now - start) * (double) cfg->rate );
+         for (i=0; i<numNodes; i++)
+         {
+            while (nodes[i].numSent < due)
+            {
+               esNode_writeSignal(&nodes[i]);
+            }
+            esNode_run(&nodes[i]);
+            numEvents += esNode_serviceLink(&nodes[i], now);
+         }
+         if (numEvents == 0)
+         {
+            double next = start + ((double) (due+1u)) / (double) cfg->rate;
+            now = getTimeSec();
+            if (next > now)
+            {
+               waitForData(nodes, numNodes, (next-now < BENCH_MAX_WAIT)? next-now : BENCH_MAX_WAIT);
+            }
+         }
+         now = getTimeSec();
+      }
+      //let the devices and the broker deliver what is still queued
+      stop = getTimeSec();
+      while (getTimeSec() - stop < BENCH_DRAIN_TIMEOUT)
+      {
+         uint32_t numSettled = 0;
+         uint32_t numEvents = 0;
+         for (i=0; i<numNodes; i++)
+         {
+            if (esNode_isSettled(&nodes[i]))
+            {
+               numSettled++;
+            }
+         }
+         if (numSettled == numNodes)
+         {
+            break;
+         }
+         now = getTimeSec();
+         for (i=0; i<numNodes; i++)
+         {
+            esNode_run(&nodes[i]);
+            numEvents += esNode_serviceLink(&nodes[i], now);
+         }
+         if (numEvents == 0)
+         {
+            waitForData(nodes, numNodes, BENCH_MAX_WAIT);
+         }
+      }
+      stop = getTimeSec();
+
+      result->elapsed = stop-start;
+      for (i=0; i<numNodes; i++)
+      {
+         esNode_t *node = &nodes[i];
+         esNode_t *provider = node->provider;
+         uint32_t k;
+         result->numSent += node->numSent;
+         result->numReceived += node->numReceived;
+         result->wireBytesTx += node->wireBytesTx;
+         result->payloadBytesTx += node->payloadBytesTx;
+         result->wireBytesRx += node->wireBytesRx;
+         result->payloadBytesRx += node->payloadBytesRx;
+         result->numFramesTx += node->numFramesTx;
+         result->numFragmentsTx += node->numFragmentsTx;
+         result->numQueueFull += node->numQueueFull;
+         if (node->queueHighWater > result->queueHighWater)
+         {
+            result->queueHighWater = node->queueHighWater;
+         }
+         connectSum += node->connectTime*1e3;
+         for (k=0; k<cfg->numSignals; k++)
+         {
+            if (node->lastSeq[k] != provider->lastSent[k])
+            {
+               result->numLost++;
+            }
+         }
+      }
+      if (result->numSent > result->numReceived + result->numLost)
+      {
+         result->numSuperseded = result->numSent - result->numReceived - result->numLost;
+      }
+      result->connectAvg = connectSum / (double) numNodes;
+      if (result->wireBytesTx > 0)
+      {
+         result->txEfficiency = ((double) result->payloadBytesTx) / (double) result->wireBytesTx;
+      }
+      if (result->wireBytesRx > 0)
+      {
+         result->rxEfficiency = ((double) result->payloadBytesRx) / (double) result->wireBytesRx;
+      }
+      if (cfg->bytesPerSec > 0.0)
+      {
+         result->linkLoad = ((double) result->wireBytesTx) / (cfg->bytesPerSec * result->elapsed * (double) numNodes);
+      }
+      result->numLatencySamples = m_numLatencySamples;
+      if (m_numLatencySamples > 0)
+      {
+         qsort(m_latencySamples, m_numLatencySamples, sizeof(double), compareDouble);
+         result->latencyP50 = percentile(m_latencySamples, m_numLatencySamples, 0.5);
+         result->latencyP99 = percentile(m_latencySamples, m_numLatencySamples, 0.99);
+         result->latencyMax = m_latencySamples[m_numLatencySamples-1];
+      }
+   }
+
+   for (i=0; i<numNodes; i++)
+   {
+      esNode_disconnect(&nodes[i]);
+      esNode_destroy(&nodes[i]);
+   }
+   if (serverPid > 0)
+   {
+      stopServer(serverPid);
+   }
+   free(nodes);
+   return retval;
+}
+
+static void printResult(const benchResult_t *result)
+{
+   printf("%6u %10lu %10lu %10lu %6u %7.1f%% %7.1f%% %7.1f%% %10.2f %10.2f %10.2f %8u %8lu\n",
+         (unsigned int) result->signalSize, (unsigned long) result->numSent, (unsigned long) result->numReceived,
+         (unsigned long) result->numSuperseded, (unsigned int) result->numLost, result->txEfficiency*100.0,
+         result->rxEfficiency*100.0, result->linkLoad*100.0, result->latencyP50, result->latencyP99, result->latencyMax,
+         (unsigned int) result->queueHighWater, (unsigned long) result->numQueueFull);
+}
+
+static int writeJson(const char *fileName, const benchConfig_t *cfg, const benchResult_t *results, int numResults)
+{
+   int i;
+   FILE *fh = fopen(fileName, "w");
+   if (fh == 0)
+   {
+      return -1;
+   }
+   fprintf(fh, "[\n");
+   for (i=0; i<numResults; i++)
+   {
+      const benchResult_t *result = &results[i];
+      fprintf(fh, "  {\n");
+      fprintf(fh, "    \"link\": \"%s\",\n", linkName(cfg->link));
+      fprintf(fh, "    \"baud\": %u,\n", (unsigned int) cfg->baud);
+      fprintf(fh, "    \"fifoSize\": %u,\n", (unsigned int) cfg->fifoSize);
+      fprintf(fh, "    \"frameSize\": %u,\n", (unsigned int) cfg->frameSize);
+      fprintf(fh, "    \"queueLength\": %u,\n", (unsigned int) cfg->queueLen);
+      fprintf(fh, "    \"receiveBufferLength\": %u,\n", (unsigned int) cfg->receiveBufLen);
+      fprintf(fh, "    \"fragmentationThreshold\": %u,\n", (unsigned int) APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD);
+      fprintf(fh, "    \"nodes\": %u,\n", (unsigned int) cfg->numNodes);
+      fprintf(fh, "    \"signalsPerNode\": %u,\n", (unsigned int) cfg->numSignals);
+      fprintf(fh, "    \"signalSize\": %u,\n", (unsigned int) result->signalSize);
+      fprintf(fh, "    \"ratePerNode\": %u,\n", (unsigned int) cfg->rate);
+      fprintf(fh, "    \"elapsed\": %.3f,\n", result->elapsed);
+      fprintf(fh, "    \"valuesSent\": %lu,\n", (unsigned long) result->numSent);
+      fprintf(fh, "    \"valuesReceived\": %lu,\n", (unsigned long) result->numReceived);
+      fprintf(fh, "    \"valuesSuperseded\": %lu,\n", (unsigned long) result->numSuperseded);
+      fprintf(fh, "    \"signalsLost\": %u,\n", (unsigned int) result->numLost);
+      fprintf(fh, "    \"tx\": {\"wireBytes\": %lu, \"payloadBytes\": %lu, \"frames\": %lu, \"fragments\": %lu, \"efficiency\": %.4f, \"load\": %.4f},\n",
+            (unsigned long) result->wireBytesTx, (unsigned long) result->payloadBytesTx, (unsigned long) result->numFramesTx,
+            (unsigned long) result->numFragmentsTx, result->txEfficiency, result->linkLoad);
+      fprintf(fh, "    \"rx\": {\"wireBytes\": %lu, \"payloadBytes\": %lu, \"efficiency\": %.4f},\n",
+            (unsigned long) result->wireBytesRx, (unsigned long) result->payloadBytesRx, result->rxEfficiency);
+      fprintf(fh, "    \"latencyMs\": {\"samples\": %u, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n",
+            (unsigned int) result->numLatencySamples, result->latencyP50, result->latencyP99, result->latencyMax);
+      fprintf(fh, "    \"queue\": {\"highWater\": %u, \"fullCount\": %lu},\n", (unsigned int) result->queueHighWater,
+            (unsigned long) result->numQueueFull);
+      fprintf(fh, "    \"connectMsAvg\": %.2f\n", result->connectAvg);
+      fprintf(fh, "  }%s\n", (i+1 < numResults)? "," : "");
+   }
+   fprintf(fh, "]\n");
+   fclose(fh);
+   return 0;
+}
+
+static const char *linkName(uint8_t link)
+{
+   return (link == BENCH_LINK_PTY)? "pty" : ((link == BENCH_LINK_SOCKETPAIR)? "socketpair" : "pipe");
+}
+
+static double getTimeSec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((double) ts.tv_sec) + ((double) ts.tv_nsec)*1e-9;
+}
+
+static pid_t startServer(const char *path, uint16_t port)
+{
+   pid_t pid = fork();
+   if (pid == 0)
+   {
+      char portArg[16];
+      sprintf(portArg, "-p%u", (unsigned int) port);
+      execl(path, path, portArg, (char*) 0);
+      _exit(127);
+   }
+   return pid;
+}
+
+static void stopServer(pid_t pid)
+{
+   kill(pid, SIGTERM);
+   waitpid(pid, 0, 0);
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+   double lhs = *(const double*) a;
+   double rhs = *(const double*) b;
+   return (lhs < rhs)? -1 : ((lhs > rhs)? 1 : 0);
+}
+
+static double percentile(const double *sorted, uint32_t len, double p)
+{
+   uint32_t index = (uint32_t) (p * (double) len);
+   if (index >= len)
+   {
+      index = len-1;
+   }
+   return sorted[index];
+}
+
+static void setNonBlocking(int fd)
+{
+   fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+static int8_t benchBuf_append(benchBuf_t *self, const uint8_t *data, uint32_t len)
+{
+   if (self->len + len > self->capacity)
+   {
+      uint32_t capacity = (self->capacity == 0)? BENCH_IO_CHUNK : self->capacity;
+      uint8_t *newData;
+      while (capacity < self->len + len)
+      {
+         capacity *= 2u;
+      }
+      newData = (uint8_t*) realloc(self->data, capacity);
+      if (newData == 0)
+      {
+         return -1;
+      }
+      self->data = newData;
+      self->capacity = capacity;
+   }
+   memcpy(&self->data[self->len], data, len);
+   self->len += len;
+   return 0;
+}
+
+static void benchBuf_consume(benchBuf_t *self, uint32_t len)
+{
+   if (len >= self->len)
+   {
+      self->len = 0;
+   }
+   else
+   {
+      memmove(self->data, &self->data[len], self->len-len);
+      self->len -= len;
+   }
+}
+
+static void benchBuf_destroy(benchBuf_t *self)
+{
+   free(self->data);
+   memset(self, 0, sizeof(benchBuf_t));
+}
+
+/**
+ * sets up the embedded side of a node: definition, port data buffers, files and the fileManager.
+ * All signals have the same size. Signal k is found at offset k*signalSize in both the .out and the .in file.
+ */
+static int8_t esNode_create(esNode_t *self, uint32_t id, uint32_t prevId, const benchConfig_t *cfg, uint32_t signalSize)
+{
+   apx_transmitHandler_t transmitHandler;
+   apx_nodeDataHandlerTable_t handlerTable;
+   char typeCode[16];
+   char *p;
+   uint32_t k;
+   self->id = id;
+   self->cfg = cfg;
+   self->signalSize = signalSize;
+   self->devTxFd = -1;
+   self->devRxFd = -1;
+   self->hostRxFd = -1;
+   self->hostTxFd = -1;
+   self->brokerFd = -1;
+   self->nextSeq = 1u; //zero is the init value of the signals
+   snprintf(self->name, BENCH_MAX_NAME_LEN, "EsNode%u", (unsigned int) id);
+   if (signalSize == 4u)
+   {
+      strcpy(typeCode, "L");
+   }
+   else
+   {
+      sprintf(typeCode, "C[%u]", (unsigned int) signalSize);
+   }
+   self->dataLen = cfg->numSignals*signalSize;
+   self->definition = (char*) malloc(((size_t) cfg->numSignals*2u + 4u)*BENCH_MAX_NAME_LEN*2u);
+   self->outData = (uint8_t*) calloc(self->dataLen, 1u);
+   self->inData = (uint8_t*) calloc(self->dataLen, 1u);
+   self->inShadow = (uint8_t*) calloc(self->dataLen, 1u);
+   self->lastSent = (uint32_t*) calloc(cfg->numSignals, sizeof(uint32_t));
+   self->lastSeq = (uint32_t*) calloc(cfg->numSignals, sizeof(uint32_t));
+   self->messageQueueBuf = (uint8_t*) malloc((size_t) cfg->queueLen*sizeof(apx_msg_t));
+   self->receiveBuf = (uint8_t*) malloc(cfg->receiveBufLen);
+   self->frameBuf = (uint8_t*) malloc(cfg->frameSize);
+   if ( (self->definition == 0) || (self->outData == 0) || (self->inData == 0) || (self->inShadow == 0) ||
+        (self->lastSent == 0) || (self->lastSeq == 0) || (self->messageQueueBuf == 0) || (self->receiveBuf == 0) || (self->frameBuf == 0) )
+   {
+      return -1;
+   }
+   p = self->definition;
+   p += sprintf(p, "APX/1.2\nN\"%s\"\n", self->name);
+   for (k=0; k<cfg->numSignals; k++)
+   {
+      p += sprintf(p, "P\"EsSignal%u_%u\"%s\n", (unsigned int) id, (unsigned int) k, typeCode);
+   }
+   for (k=0; k<cfg->numSignals; k++)
+   {
+      p += sprintf(p, "R\"EsSignal%u_%u\"%s\n", (unsigned int) prevId, (unsigned int) k, typeCode);
+   }
+   p += sprintf(p, "\n");
+   self->definitionLen = (uint32_t) (p-self->definition);
+
+   apx_nodeData_create(&self->nodeData, self->name, (uint8_t*) self->definition, self->definitionLen, self->inData, 0,
+         self->dataLen, self->outData, 0, self->dataLen);
+   memset(&handlerTable, 0, sizeof(handlerTable));
+   handlerTable.arg = self;
+   handlerTable.inPortDataWritten = esNode_inPortDataWritten;
+   apx_nodeData_setHandlerTable(&self->nodeData, &handlerTable);
+   if ( (apx_file_createLocalFile(&self->outDataFile, APX_OUTDATA_FILE, &self->nodeData) != 0) ||
+        (apx_file_createLocalFile(&self->definitionFile, APX_DEFINITION_FILE, &self->nodeData) != 0) ||
+        (apx_file_createLocalFile(&self->inDataFile, APX_INDATA_FILE, &self->nodeData) != 0) )
+   {
+      return -1;
+   }
+   apx_nodeData_setOutPortDataFile(&self->nodeData, &self->outDataFile);
+   apx_nodeData_setInPortDataFile(&self->nodeData, &self->inDataFile);
+   if (apx_es_fileManager_create(&self->fileManager, self->messageQueueBuf, cfg->queueLen, self->receiveBuf,
+         cfg->receiveBufLen) != 0)
+   {
+      return -1;
+   }
+   apx_nodeData_setFileManager(&self->nodeData, &self->fileManager);
+   //the .out file must be known by the broker before it parses the definition
+   apx_es_fileManager_attachLocalFile(&self->fileManager, &self->outDataFile);
+   apx_es_fileManager_attachLocalFile(&self->fileManager, &self->definitionFile);
+   apx_es_fileManager_requestRemoteFile(&self->fileManager, &self->inDataFile);
+   if (apx_es_fileManager_setReceiveShadow(&self->fileManager, &self->inDataFile, self->inShadow, self->dataLen) != 0)
+   {
+      return -1;
+   }
+   transmitHandler.arg = self;
+   transmitHandler.getSendAvail = esNode_getSendAvail;
+   transmitHandler.getSendBuffer = esNode_getSendBuffer;
+   transmitHandler.send = esNode_send;
+   apx_es_fileManager_setTransmitHandler(&self->fileManager, &transmitHandler);
+   return 0;
+}
+
+static void esNode_destroy(esNode_t *self)
+{
+   benchBuf_destroy(&self->txFifo);
+   benchBuf_destroy(&self->rxBuf);
+   benchBuf_destroy(&self->toBroker);
+   benchBuf_destroy(&self->toDevice);
+   free(self->definition);
+   free(self->outData);
+   free(self->inData);
+   free(self->inShadow);
+   free(self->lastSent);
+   free(self->lastSeq);
+   free(self->messageQueueBuf);
+   free(self->receiveBuf);
+   free(self->frameBuf);
+}
+
+/**
+ * creates the emulated serial link. The device end is devTxFd/devRxFd, the gateway end is hostRxFd/hostTxFd.
+ */
+static int8_t esNode_openLink(esNode_t *self)
+{
+   if (self->cfg->link == BENCH_LINK_PIPE)
+   {
+      int up[2];
+      int down[2];
+      if (pipe(up) != 0)
+      {
+         return -1;
+      }
+      if (pipe(down) != 0)
+      {
+         close(up[0]);
+         close(up[1]);
+         return -1;
+      }
+      self->devTxFd = up[1];
+      self->hostRxFd = up[0];
+      self->hostTxFd = down[1];
+      self->devRxFd = down[0];
+   }
+   else if (self->cfg->link == BENCH_LINK_SOCKETPAIR)
+   {
+      int sv[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+      {
+         return -1;
+      }
+      self->devTxFd = self->devRxFd = sv[0];
+      self->hostRxFd = self->hostTxFd = sv[1];
+   }
+   else
+   {
+      struct termios tio;
+      int master = posix_openpt(O_RDWR | O_NOCTTY);
+      int slave = -1;
+      if (master < 0)
+      {
+         return -1;
+      }
+      if ( (grantpt(master) == 0) && (unlockpt(master) == 0) )
+      {
+         slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+      }
+      if (slave < 0)
+      {
+         close(master);
+         return -1;
+      }
+      //no line discipline, bytes pass unchanged in both directions
+      tcgetattr(slave, &tio);
+      cfmakeraw(&tio);
+      tcsetattr(slave, TCSANOW, &tio);
+      self->devTxFd = self->devRxFd = slave;
+      self->hostRxFd = self->hostTxFd = master;
+   }
+   setNonBlocking(self->devTxFd);
+   setNonBlocking(self->devRxFd);
+   setNonBlocking(self->hostRxFd);
+   setNonBlocking(self->hostTxFd);
+   return 0;
+}
+
+/**
+ * connects the gateway to the broker, opens the link and queues the greeting on the device
+ */
+static int8_t esNode_connect(esNode_t *self)
+{
+   struct sockaddr_in addr;
+   int flag = 1;
+   uint8_t header[1];
+   double start;
+   if (esNode_openLink(self) != 0)
+   {
+      return -1;
+   }
+   start = getTimeSec();
+   self->connectStart = start;
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_port = htons(self->cfg->tcpPort);
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   for(;;)
+   {
+      self->brokerFd = socket(AF_INET, SOCK_STREAM, 0);
+      if (self->brokerFd < 0)
+      {
+         return -1;
+      }
+      if (connect(self->brokerFd, (struct sockaddr*) &addr, sizeof(addr)) == 0)
+      {
+         break;
+      }
+      close(self->brokerFd);
+      self->brokerFd = -1;
+      //the broker may still be starting up
+      if ( (errno != ECONNREFUSED) || (getTimeSec() - start > BENCH_CONNECT_TIMEOUT) )
+      {
+         return -1;
+      }
+      usleep(10000);
+      self->connectStart = getTimeSec();
+   }
+   setsockopt(self->brokerFd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+   setNonBlocking(self->brokerFd);
+   self->lastShapeTime = self->connectStart;
+   //the greeting is framed like any other message
+   header[0] = (uint8_t) strlen(BENCH_GREETING);
+   if (benchBuf_append(&self->txFifo, header, 1u) != 0)
+   {
+      return -1;
+   }
+   return benchBuf_append(&self->txFifo, (const uint8_t*) BENCH_GREETING, (uint32_t) strlen(BENCH_GREETING));
+}
+
+static void esNode_disconnect(esNode_t *self)
+{
+   if (self->brokerFd >= 0)
+   {
+      close(self->brokerFd);
+   }
+   if (self->devTxFd >= 0)
+   {
+      close(self->devTxFd);
+   }
+   if ( (self->devRxFd >= 0) && (self->devRxFd != self->devTxFd) )
+   {
+      close(self->devRxFd);
+   }
+   if (self->hostRxFd >= 0)
+   {
+      close(self->hostRxFd);
+   }
+   if ( (self->hostTxFd >= 0) && (self->hostTxFd != self->hostRxFd) )
+   {
+      close(self->hostTxFd);
+   }
+   self->brokerFd = self->devTxFd = self->devRxFd = self->hostRxFd = self->hostTxFd = -1;
+   apx_es_fileManager_onDisconnected(&self->fileManager);
+}
+
+/**
+ * writes the next sequence number into the next signal, the way generated code writes a provide port
+ */
+static void esNode_writeSignal(esNode_t *self)
+{
+   uint8_t value[BENCH_MAX_SIGNAL_SIZE];
+   uint32_t seq = self->nextSeq++;
+   uint32_t k = seq % self->cfg->numSignals;
+   uint32_t offset = k*self->signalSize;
+   uint32_t ringIndex = seq & (BENCH_SEQ_RING_LEN-1u);
+   self->lastSent[k] = seq;
+   memset(value, (int) (seq & 0xFFu), self->signalSize);
+   packLE(value, seq, (uint8_t) BENCH_SEQ_SIZE);
+   self->sendSeq[ringIndex] = seq;
+   self->sendTime[ringIndex] = getTimeSec();
+   if (rbfs_free(&self->fileManager.messageQueue) == 0)
+   {
+      //the write notification waits in the dirty ranges of the file until the link catches up
+      self->numQueueFull++;
+   }
+   apx_nodeData_writeOutPortData(&self->nodeData, value, offset, self->signalSize);
+   apx_nodeData_outPortDataNotify(&self->nodeData, offset, self->signalSize);
+   self->numSent++;
+}
+
+static void esNode_run(esNode_t *self)
+{
+   uint16_t queueSize;
+   apx_es_fileManager_run(&self->fileManager);
+   if ( (!self->isConnected) && self->isInReceived && apx_file_isOpen(&self->outDataFile) )
+   {
+      self->isConnected = true;
+      self->connectTime = getTimeSec() - self->connectStart;
+   }
+   queueSize = rbfs_size(&self->fileManager.messageQueue);
+   if (queueSize > self->queueHighWater)
+   {
+      self->queueHighWater = queueSize;
+   }
+}
+
+/**
+ * moves bytes between the device, the link, the gateway and the broker. Returns the number of transfers made.
+ */
+static uint32_t esNode_serviceLink(esNode_t *self, double now)
+{
+   uint8_t chunk[BENCH_IO_CHUNK];
+   uint32_t numEvents = 0;
+   uint32_t maxLen;
+   ssize_t result;
+   double bytesPerSec = self->cfg->bytesPerSec;
+   if (bytesPerSec > 0.0)
+   {
+      double maxCredit = bytesPerSec*BENCH_BURST_TIME + 1.0;
+      double elapsed = now - self->lastShapeTime;
+      self->txCredit += elapsed*bytesPerSec;
+      self->rxCredit += elapsed*bytesPerSec;
+      self->txCredit = (self->txCredit > maxCredit)? maxCredit : self->txCredit;
+      self->rxCredit = (self->rxCredit > maxCredit)? maxCredit : self->rxCredit;
+   }
+   self->lastShapeTime = now;
+
+   //device transmit buffer -> link
+   maxLen = self->txFifo.len;
+   if ( (bytesPerSec > 0.0) && (maxLen > (uint32_t) self->txCredit) )
+   {
+      maxLen = (uint32_t) self->txCredit;
+   }
+   if (maxLen > 0)
+   {
+      result = write(self->devTxFd, self->txFifo.data, maxLen);
+      if (result > 0)
+      {
+         benchBuf_consume(&self->txFifo, (uint32_t) result);
+         self->txCredit -= (double) result;
+         numEvents++;
+      }
+   }
+   //link -> gateway -> broker
+   result = read(self->hostRxFd, chunk, sizeof(chunk));
+   if (result > 0)
+   {
+      benchBuf_append(&self->toBroker, chunk, (uint32_t) result);
+      numEvents++;
+   }
+   if (self->toBroker.len > 0)
+   {
+      result = send(self->brokerFd, self->toBroker.data, self->toBroker.len, 0);
+      if (result > 0)
+      {
+         benchBuf_consume(&self->toBroker, (uint32_t) result);
+      }
+   }
+   //broker -> gateway -> link
+   result = recv(self->brokerFd, chunk, sizeof(chunk), 0);
+   if (result > 0)
+   {
+      benchBuf_append(&self->toDevice, chunk, (uint32_t) result);
+      numEvents++;
+   }
+   if (self->toDevice.len > 0)
+   {
+      result = write(self->hostTxFd, self->toDevice.data, self->toDevice.len);
+      if (result > 0)
+      {
+         benchBuf_consume(&self->toDevice, (uint32_t) result);
+      }
+   }
+   //link -> device
+   maxLen = (uint32_t) sizeof(chunk);
+   if ( (bytesPerSec > 0.0) && (maxLen > (uint32_t) self->rxCredit) )
+   {
+      maxLen = (uint32_t) self->rxCredit;
+   }
+   if (maxLen > 0)
+   {
+      result = read(self->devRxFd, chunk, maxLen);
+      if (result > 0)
+      {
+         self->rxCredit -= (double) result;
+         self->wireBytesRx += (uint64_t) result;
+         benchBuf_append(&self->rxBuf, chunk, (uint32_t) result);
+         numEvents += esNode_receive(self);
+      }
+   }
+   return numEvents;
+}
+
+/**
+ * parses complete frames in rxBuf and hands them to the fileManager. Returns number of parsed messages
+ */
+static uint32_t esNode_receive(esNode_t *self)
+{
+   uint32_t numMessages = 0;
+   const uint8_t *pBegin = self->rxBuf.data;
+   const uint8_t *pEnd = pBegin + self->rxBuf.len;
+   const uint8_t *pNext = pBegin;
+   while (pNext < pEnd)
+   {
+      uint32_t msgLen;
+      rmf_msg_t msg;
+      const uint8_t *pResult = headerutil_numDecode32(pNext, pEnd, &msgLen);
+      if ( (pResult <= pNext) || (pResult+msgLen > pEnd) )
+      {
+         break;
+      }
+      if (!self->isAckSeen)
+      {
+         //the first message from the broker acknowledges the greeting
+         self->isAckSeen = true;
+         apx_es_fileManager_onConnected(&self->fileManager);
+      }
+      if ( (rmf_unpackMsg(pResult, (int32_t) msgLen, &msg) > 0) && (self->inDataFile.isOpen) &&
+           (msg.address >= self->inDataFile.fileInfo.address) &&
+           (msg.address < self->inDataFile.fileInfo.address + self->dataLen) )
+      {
+         self->payloadBytesRx += msg.dataLen;
+      }
+      apx_es_fileManager_onMsgReceived(&self->fileManager, pResult, (int32_t) msgLen);
+      pNext = pResult+msgLen;
+      numMessages++;
+   }
+   if (pNext > pBegin)
+   {
+      benchBuf_consume(&self->rxBuf, (uint32_t) (pNext-pBegin));
+   }
+   return numMessages;
+}
+
+/**
+ * link statistics only cover the traffic phase
+ */
+/**
+ * true when the last value written to each required signal has been received
+ */
+static bool esNode_isSettled(const esNode_t *self)
+{
+   uint32_t k;
+   for (k=0; k<self->cfg->numSignals; k++)
+   {
+      if (self->lastSeq[k] != self->provider->lastSent[k])
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+static void esNode_resetCounters(esNode_t *self)
+{
+   self->wireBytesTx = 0;
+   self->payloadBytesTx = 0;
+   self->wireBytesRx = 0;
+   self->payloadBytesRx = 0;
+   self->numFramesTx = 0;
+   self->numFragmentsTx = 0;
+   self->queueHighWater = 0;
+   self->numQueueFull = 0;
+}
+
+/**
+ * free space in the device transmit buffer, limited by the frame size and less the length header
+ */
+static int32_t esNode_getSendAvail(void *arg)
+{
+   esNode_t *self = (esNode_t*) arg;
+   uint32_t space = (self->cfg->fifoSize > self->txFifo.len)? (self->cfg->fifoSize - self->txFifo.len) : 0u;
+   if (space > self->cfg->frameSize)
+   {
+      space = self->cfg->frameSize;
+   }
+   //the length header is one byte for messages up to 127 bytes and four bytes otherwise
+   if (space <= HEADERUTIL32_MAX_NUM_SHORT+1u)
+   {
+      return (space > 1u)? (int32_t) space-1 : 0;
+   }
+   return (int32_t) (space - BENCH_MAX_FRAME_HEADER);
+}
+
+static uint8_t *esNode_getSendBuffer(void *arg, int32_t msgLen)
+{
+   esNode_t *self = (esNode_t*) arg;
+   if ( (msgLen <= 0) || ((uint32_t) msgLen > self->cfg->frameSize) )
+   {
+      return 0;
+   }
+   return self->frameBuf;
+}
+
+static int32_t esNode_send(void *arg, int32_t offset, int32_t msgLen)
+{
+   esNode_t *self = (esNode_t*) arg;
+   uint8_t header[BENCH_MAX_FRAME_HEADER];
+   uint8_t *headerEnd = headerutil_numEncode32(header, (uint32_t) sizeof(header), (uint32_t) msgLen);
+   const uint8_t *msgBuf = &self->frameBuf[offset];
+   rmf_msg_t msg;
+   if ( (headerEnd <= header) || (benchBuf_append(&self->txFifo, header, (uint32_t) (headerEnd-header)) != 0) ||
+        (benchBuf_append(&self->txFifo, msgBuf, (uint32_t) msgLen) != 0) )
+   {
+      return -1;
+   }
+   self->numFramesTx++;
+   self->wireBytesTx += (uint64_t) (headerEnd-header) + (uint64_t) msgLen;
+   if ( (rmf_unpackMsg(msgBuf, msgLen, &msg) > 0) && (msg.address < RMF_CMD_START_ADDR) )
+   {
+      if (msg.more_bit)
+      {
+         self->numFragmentsTx++;
+      }
+      if ( (msg.address >= self->outDataFile.fileInfo.address) &&
+           (msg.address < self->outDataFile.fileInfo.address + self->dataLen) )
+      {
+         self->payloadBytesTx += msg.dataLen;
+      }
+   }
+   return msgLen;
+}
+
+/**
+ * the first write is the initial content of the whole .in file. After that every signal that holds a new sequence
+ * number is a delivered value, signals in the same write that did not change are skipped.
+ */
+static void esNode_inPortDataWritten(void *arg, apx_nodeData_t *nodeData, uint32_t offset, uint32_t len)
+{
+   esNode_t *self = (esNode_t*) arg;
+   esNode_t *provider = self->provider;
+   uint32_t k = (offset + self->signalSize - 1u) / self->signalSize;
+   double now = getTimeSec();
+   if (!self->isInReceived)
+   {
+      self->isInReceived = true;
+      return;
+   }
+   while ( (k < self->cfg->numSignals) && ((k+1u)*self->signalSize <= offset+len) )
+   {
+      uint32_t seq = (uint32_t) unpackLE(&nodeData->inPortDataBuf[k*self->signalSize], (uint8_t) BENCH_SEQ_SIZE);
+      if (seq > self->lastSeq[k])
+      {
+         uint32_t ringIndex = seq & (BENCH_SEQ_RING_LEN-1u);
+         self->lastSeq[k] = seq;
+         self->numReceived++;
+         if ( (provider->sendSeq[ringIndex] == seq) && (m_numLatencySamples < BENCH_MAX_LATENCY_SAMPLES) )
+         {
+            m_latencySamples[m_numLatencySamples++] = (now - provider->sendTime[ringIndex])*1e3;
+         }
+      }
+      k++;
+   }
+}
+
+/**
+ * waits until any link or broker socket has data, or until the timeout (in seconds) expires
+ */
+static void waitForData(esNode_t *nodes, uint32_t numNodes, double timeout)
+{
+   struct pollfd *pfds = (struct pollfd*) malloc(numNodes*3u*sizeof(struct pollfd));
+   struct timespec ts;
+   uint32_t numFds = 0;
+   uint32_t i;
+   if (pfds == 0)
+   {
+      return;
+   }
+   for (i=0; i<numNodes; i++)
+   {
+      int fds[3];
+      int j;
+      double byteTime = (nodes[i].cfg->bytesPerSec > 0.0)? 1.0/nodes[i].cfg->bytesPerSec : 0.0;
+      fds[0] = nodes[i].devRxFd;
+      if ( (byteTime > 0.0) && (nodes[i].rxCredit < 1.0) )
+      {
+         //the link is busy receiving, wake up when the next byte can be read
+         fds[0] = -1;
+         timeout = (byteTime < timeout)? byteTime : timeout;
+      }
+      fds[1] = nodes[i].hostRxFd;
+      fds[2] = nodes[i].brokerFd;
+      for (j=0; j<3; j++)
+      {
+         if (fds[j] >= 0)
+         {
+            pfds[numFds].fd = fds[j];
+            pfds[numFds].events = POLLIN;
+            pfds[numFds].revents = 0;
+            numFds++;
+         }
+      }
+      if (nodes[i].txFifo.len > 0)
+      {
+         //the link is busy sending, wake up when the next byte can go
+         timeout = (byteTime < timeout)? byteTime : timeout;
+      }
+   }
+   ts.tv_sec = (time_t) timeout;
+   ts.tv_nsec = (long) ((timeout - (double) ts.tv_sec)*1e9);
+   ppoll(pfds, numFds, &ts, 0);
+   free(pfds);
+}
@@ -11,7 +11,10 @@
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
 
+//capacity of each file map (local and remote files), can be overridden from the build system
+#ifndef APX_ES_FILEMAP_MAX_NUM_FILES
 #define APX_ES_FILEMAP_MAX_NUM_FILES           10
+#endif
 #define APX_MAX_NAME_LEN 256
 
 
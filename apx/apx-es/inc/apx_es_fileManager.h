@@ -30,6 +30,37 @@ typedef struct apx_es_file_write_tag
    uint32_t remain;
 } apx_es_file_write_t;
 
+/**
+ * Second data buffer of a remote file. Fragmented writes to the file are received directly into shadowBuf and
+ * committed on the last fragment by swapping shadowBuf with the data buffer of the file's nodeData.
+ * Outside of [staleBegin, staleEnd) the shadow buffer holds the same data as the file.
+ */
+typedef struct apx_es_receiveShadow_tag
+{
+   apx_file_t *file;
+   uint8_t *shadowBuf;
+   uint32_t dataLen; // Length of the file data (and the shadow buffer)
+   uint32_t staleBegin;
+   uint32_t staleEnd;
+   uint32_t generation; // Incremented every time a fragmented write is committed (the data buffers are swapped)
+} apx_es_receiveShadow_t;
+
+typedef struct apx_es_dirtyRange_tag
+{
+   uint32_t offset;
+   uint32_t length;
+} apx_es_dirtyRange_t;
+
+/**
+ * Parts of a local file written since the last call to apx_es_fileManager_run(), sorted by offset and non-overlapping
+ */
+typedef struct apx_es_dirtyFile_tag
+{
+   apx_file_t *file;
+   uint8_t numRanges;
+   apx_es_dirtyRange_t ranges[APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES];
+} apx_es_dirtyFile_t;
+
 typedef struct apx_es_fileManager_tag
 {
    rbfs_t messageQueue; //internal message queue (contains apx_msg_t object)
@@ -38,6 +69,9 @@ typedef struct apx_es_fileManager_tag
    uint32_t receiveBufLen; //length of receive buffer
    uint32_t receiveBufOffset; //current write position (and length) of receive buffer
    uint32_t receiveStartAddress;
+   apx_es_receiveShadow_t receiveShadows[APX_ES_FILEMANAGER_MAX_NUM_RECEIVE_SHADOWS];
+   uint16_t numReceiveShadows;
+   apx_es_receiveShadow_t *curShadow; // Shadow of curFile when a fragmented write is received in place
 
    apx_es_fileMap_t localFileMap;
    apx_es_fileMap_t remoteFileMap;
@@ -55,7 +89,8 @@ typedef struct apx_es_fileManager_tag
    bool isConnected; // When fileManager is connected to an underlying communication device (like a TCP socket or SPI stream)
    apx_file_t *curFile; // Weak pointer to last accessed file
 
-   apx_msg_t queuedWriteNotify; // Last write notification waiting for more data (until apx_es_fileManager_run() is called)
+   apx_es_dirtyFile_t dirtyFiles[APX_ES_FILEMANAGER_MAX_NUM_DIRTY_FILES]; // Write notifications waiting for apx_es_fileManager_run()
+   uint8_t numDirtyFiles;
    apx_msg_t pendingMsg; // Message taken out of the queue and not yet serialized
    apx_es_file_write_t fileWriteInfo;
 }apx_es_fileManager_t;
@@ -73,8 +108,17 @@ int8_t apx_es_fileManager_create(apx_es_fileManager_t *self, uint8_t *messageQue
 // Files added will be kept track of thur connect/disconnect events
 // The fileManager will open/close these files as requested by the server
 void apx_es_fileManager_attachLocalFile(apx_es_fileManager_t *self, apx_file_t *localFile);
+// Uses a const table of local files with precomputed addresses (generated by apx_codegen -t) instead of attachLocalFile.
+// fileTable must be sorted by address and stay valid for the lifetime of the fileManager.
+int8_t apx_es_fileManager_setLocalFileTable(apx_es_fileManager_t *self, apx_file_t * const *fileTable, int32_t numFiles);
 void apx_es_fileManager_requestRemoteFile(apx_es_fileManager_t *self, apx_file_t *requestedFile);
 
+// Fragmented writes to file are written directly into shadowBuf and committed atomically when the last fragment arrives,
+// after which shadowBuf is the data buffer of the file's nodeData and the previous data buffer is the new shadow.
+// The size of such writes is bounded by the file size instead of receiveBufLen.
+// shadowBuf must be at least as large as the file data, the application must not keep pointers into the data buffer.
+int8_t apx_es_fileManager_setReceiveShadow(apx_es_fileManager_t *self, apx_file_t *file, uint8_t *shadowBuf, uint32_t shadowBufLen);
+
 // Ensure the transmitHandler normally can provide a MAX(APX_ES_FILEMANAGER_MAX_CMD_BUF_SIZE,
 // APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD) sized send buffer
 // The transmitHandler arg is used to set optimal write size (currently not supported by apx-server)
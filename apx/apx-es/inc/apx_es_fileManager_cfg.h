@@ -28,6 +28,29 @@
 #define APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD (RMF_HIGH_ADDRESS_SIZE + sizeof(uint64_t))
 #endif
 
+#ifndef APX_ES_FILEMANAGER_MAX_NUM_RECEIVE_SHADOWS
+// Number of remote files that can have a shadow buffer for in-place reception of fragmented writes
+// (see apx_es_fileManager_setReceiveShadow)
+#define APX_ES_FILEMANAGER_MAX_NUM_RECEIVE_SHADOWS 2
+#endif
+
+#ifndef APX_ES_FILEMANAGER_MAX_NUM_DIRTY_FILES
+// Number of local files that can collect write notifications between calls to apx_es_fileManager_run()
+// Write notifications for further files are queued directly
+#define APX_ES_FILEMANAGER_MAX_NUM_DIRTY_FILES 2
+#endif
+
+#ifndef APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES
+// Number of separate dirty ranges per file, when exceeded the two closest ranges are merged
+#define APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES 8
+#endif
+
+#ifndef APX_ES_FILEMANAGER_DIRTY_RANGE_GAP_THRESHOLD
+// Dirty ranges separated by at most this many unchanged bytes are sent in the same write
+// (sending the gap is cheaper than the header of another write)
+#define APX_ES_FILEMANAGER_DIRTY_RANGE_GAP_THRESHOLD RMF_LOW_ADDRESS_SIZE
+#endif
+
 #ifndef APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS
 // When set to 1 the fileManager avoids adding duplicates to the message queue
 #define APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS 1
@@ -14,9 +14,11 @@
 //////////////////////////////////////////////////////////////////////////////
 typedef struct apx_es_fileMap_tag
 {
-   apx_file_t *fileList[APX_ES_FILEMAP_MAX_NUM_FILES]; //list of weak references to apx_file_t
+   apx_file_t *fileList[APX_ES_FILEMAP_MAX_NUM_FILES]; //list of weak references to apx_file_t, sorted by address
+   apx_file_t * const *files; //points to fileList or to the const table given to apx_es_fileMap_createStatic
    int32_t curLen;
-   int32_t lastIndex;
+   int32_t lastIndex; //index of latest file found by address, checked first on next lookup
+   bool isStatic; //files is a const table, insert and remove are not allowed
 }apx_es_fileMap_t;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -28,6 +30,7 @@ typedef struct apx_es_fileMap_tag
 // GLOBAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 void apx_es_fileMap_create(apx_es_fileMap_t *self);
+int8_t apx_es_fileMap_createStatic(apx_es_fileMap_t *self, apx_file_t * const *fileTable, int32_t numFiles);
 
 int8_t apx_es_fileMap_autoInsert(apx_es_fileMap_t *self, apx_file_t *pFile);
 int8_t apx_es_fileMap_insert(apx_es_fileMap_t *self, apx_file_t *pFile);
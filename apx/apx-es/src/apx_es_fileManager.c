@@ -25,7 +25,8 @@
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
-
+// Adjacent or nearby dirty ranges are not merged beyond this length (to avoid fragmented writes)
+#define DIRTY_RANGE_MAX_MERGED_LEN (APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD - RMF_HIGH_ADDRESS_SIZE)
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
@@ -35,6 +36,14 @@ static int32_t apx_es_fileManager_processPendingMessage(apx_es_fileManager_t *se
 static void apx_es_fileManager_parseCmdMsg(apx_es_fileManager_t *self, const uint8_t *msgBuf, int32_t msgLen);
 static void apx_es_fileManager_parseDataMsg(apx_es_fileManager_t *self, uint32_t address, const uint8_t *dataBuf, int32_t dataLen, bool more_bit);
 static void apx_es_fileManager_processOpenFile(apx_es_fileManager_t *self, const rmf_cmdOpenFile_t *cmdOpenFile);
+static apx_es_receiveShadow_t *apx_es_findReceiveShadow(apx_es_fileManager_t *self, const apx_file_t *file);
+static uint8_t **apx_es_getFileDataBuf(apx_file_t *file, uint32_t *dataLen);
+#ifndef APX_EMBEDDED
+static SPINLOCK_T *apx_es_getFileDataLock(apx_file_t *file);
+#endif
+static void apx_es_extendShadowStaleRange(apx_es_receiveShadow_t *shadow, uint32_t offset, uint32_t length);
+static int8_t apx_es_receiveIntoShadow(apx_es_fileManager_t *self, uint32_t offset, const uint8_t *dataBuf, uint32_t dataLen);
+static void apx_es_commitShadow(apx_es_fileManager_t *self, uint32_t offset, uint32_t length);
 static int32_t apx_es_processPendingWrite(apx_es_fileManager_t *self);
 static inline int32_t apx_es_genFileSendMsg(uint8_t* msgBuf, uint32_t headerLen,
                                             apx_es_fileManager_t* self,
@@ -43,7 +52,11 @@ static inline int32_t apx_es_genFileSendMsg(uint8_t* msgBuf, uint32_t headerLen,
                                             bool moreFragmentsPending);
 static inline uint8_t apx_es_calcHeaderLenForAddress(uint32_t address);
 static inline bool apx_es_isPendingMessage(const apx_msg_t* msg);
-static void apx_es_processQueuedWriteNotify(apx_es_fileManager_t *self);
+static void apx_es_flushDirtyRanges(apx_es_fileManager_t *self);
+static void apx_es_queueWriteNotify(apx_es_fileManager_t *self, const apx_msg_t *msg);
+static apx_es_dirtyFile_t *apx_es_getDirtyFile(apx_es_fileManager_t *self, apx_file_t *file);
+static void apx_es_dirtyFile_insert(apx_es_dirtyFile_t *dirtyFile, uint32_t offset, uint32_t length);
+static void apx_es_dirtyFile_coalesce(apx_es_dirtyFile_t *dirtyFile, bool force);
 static void apx_es_resetConnectionState(apx_es_fileManager_t *self);
 static void apx_es_transmitMsg(apx_es_fileManager_t *self, uint32_t msgSize);
 static void apx_es_setupTransmitBuf(apx_es_fileManager_t *self);
@@ -52,9 +65,6 @@ static void apx_es_createPendingWriteFromPendingMessage(apx_es_fileManager_t *se
                                                         uint32_t readOffset,
                                                         uint32_t writeAddress,
                                                         uint32_t remainingLen);
-#if APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS == 1
-static void apx_es_queueWriteNotifyUnlessPrevQueued(apx_es_fileManager_t *self);
-#endif
 #ifndef UNIT_TEST
 DYN_STATIC int8_t apx_es_fileManager_removeRequestedAt(apx_es_fileManager_t *self, int32_t removeIndex);
 DYN_STATIC void apx_es_fileManager_processRemoteFileInfo(apx_es_fileManager_t *self, const rmf_fileInfo_t *fileInfo);
@@ -80,6 +90,7 @@ int8_t apx_es_fileManager_create(apx_es_fileManager_t *self, uint8_t *messageQue
       apx_es_fileMap_create(&self->remoteFileMap);
       apx_es_fileManager_setTransmitHandler(self, 0);
       self->numRequestedFiles = 0;
+      self->numReceiveShadows = 0;
       apx_es_resetConnectionState(self);
       retval = 0;
    }
@@ -94,6 +105,15 @@ void apx_es_fileManager_attachLocalFile(apx_es_fileManager_t *self, apx_file_t *
    }
 }
 
+int8_t apx_es_fileManager_setLocalFileTable(apx_es_fileManager_t *self, apx_file_t * const *fileTable, int32_t numFiles)
+{
+   if (self != 0)
+   {
+      return apx_es_fileMap_createStatic(&self->localFileMap, fileTable, numFiles);
+   }
+   return -1;
+}
+
 void apx_es_fileManager_requestRemoteFile(apx_es_fileManager_t *self, apx_file_t *requestedFile)
 {
    if ( (self != 0) && (requestedFile != 0) )
@@ -116,6 +136,40 @@ void apx_es_fileManager_requestRemoteFile(apx_es_fileManager_t *self, apx_file_t
    }
 }
 
+/**
+ * returns 0 on success, -1 when the file has no data buffer, the shadow buffer is too small or the shadow table is full
+ */
+int8_t apx_es_fileManager_setReceiveShadow(apx_es_fileManager_t *self, apx_file_t *file, uint8_t *shadowBuf, uint32_t shadowBufLen)
+{
+   if ( (self != 0) && (file != 0) && (shadowBuf != 0) )
+   {
+      uint32_t dataLen = 0u;
+      uint8_t **ppDataBuf = apx_es_getFileDataBuf(file, &dataLen);
+      apx_es_receiveShadow_t *shadow;
+      if ( (ppDataBuf == 0) || (*ppDataBuf == 0) || (shadowBufLen < dataLen) || (self->curShadow != 0) )
+      {
+         return -1;
+      }
+      shadow = apx_es_findReceiveShadow(self, file);
+      if (shadow == 0)
+      {
+         if (self->numReceiveShadows >= APX_ES_FILEMANAGER_MAX_NUM_RECEIVE_SHADOWS)
+         {
+            return -1;
+         }
+         shadow = &self->receiveShadows[self->numReceiveShadows++];
+      }
+      shadow->file = file;
+      shadow->shadowBuf = shadowBuf;
+      shadow->dataLen = dataLen;
+      shadow->staleBegin = 0u; //content of a new shadow buffer is unknown
+      shadow->staleEnd = dataLen;
+      shadow->generation = 0u;
+      return 0;
+   }
+   return -1;
+}
+
 void apx_es_fileManager_setTransmitHandler(apx_es_fileManager_t *self, apx_transmitHandler_t *handler)
 {
    if (self != 0)
@@ -233,64 +287,20 @@ void apx_es_fileManager_onFileUpdate(apx_es_fileManager_t *self, apx_file_t *fil
 {
    if ( (self != 0) && (file != 0) && (length > 0) && apx_file_isOpen(file))
    {
-      apx_msg_t msg = {RMF_MSG_WRITE_NOTIFY, 0, 0, 0}; //{msgType,msgData1,msgData2,msgData3}
-      msg.msgData1 = offset;
-      msg.msgData2 = length;
-      msg.msgData3 = (void*)file;
-      if (self->queuedWriteNotify.msgType == RMF_MSG_WRITE_NOTIFY)
-      {
-         // Check if sequential write to the same file as last received fileUpdate
-         const uint32_t lengthOfQueuedFileUpdate     = self->queuedWriteNotify.msgData2;
-         const uint32_t potentialSequentialWriteSize = lengthOfQueuedFileUpdate + length;
-         const uint32_t offsetOfQueuedFileUpdate     = self->queuedWriteNotify.msgData1;
-         const uint32_t oneBytePastQueuedFileUpdate  = offsetOfQueuedFileUpdate +
-                                                       lengthOfQueuedFileUpdate;
-         const bool smallEnoughToAllowAlign = potentialSequentialWriteSize <=
-            (APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD - RMF_HIGH_ADDRESS_SIZE);
-         const bool sameFileAsQueued = (void*)file == self->queuedWriteNotify.msgData3;
-         if ( sameFileAsQueued &&
-              ( oneBytePastQueuedFileUpdate == offset) &&
-              smallEnoughToAllowAlign )
-         {
-            // The write aligns. Just update the size
-            self->queuedWriteNotify.msgData2 = potentialSequentialWriteSize;
-         }
-         else
-         {
-#if APX_DEBUG_ENABLE
-            if (rbfs_free(&self->messageQueue) <= APX_MSQ_QUEUE_WARN_THRESHOLD)
-            {
-                fprintf(stderr, "messageQueue fill warning for RMF_MSG_WRITE_NOTIFY. Free before add: %d\n", rbfs_free(&self->messageQueue));
-            }
-#endif
-#if APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS == 1
-            if ( sameFileAsQueued &&
-                 (offsetOfQueuedFileUpdate <= offset) &&
-                 ((offset + length) <= oneBytePastQueuedFileUpdate))
-            {
-               // File written to same location multiple times before run()
-               // This can happen for instance if run() is starved by sending
-               // some other large file via pendingWrite
-               // In this case there is no need to queue multiple apx_file reads
-               // since all reads in the queue would read the same data
-            }
-            else
-            {
-               // Not writing fully inside the same fileUpdate as queued (or too large to align)
-               // Send queuedWriteNotify to the queue
-               apx_es_queueWriteNotifyUnlessPrevQueued(self);
-#else
-            {
-               rbfs_insert(&self->messageQueue,(const uint8_t*) &self->queuedWriteNotify);
-#endif
-               self->queuedWriteNotify = msg;
-            }
-         }
+      apx_es_dirtyFile_t *dirtyFile = apx_es_getDirtyFile(self, file);
+      if (dirtyFile != 0)
+      {
+         // Collect until apx_es_fileManager_run(), regardless of the order ports are written in
+         apx_es_dirtyFile_insert(dirtyFile, offset, length);
       }
       else
       {
-         // First Write notify after run()
-         self->queuedWriteNotify = msg;
+         // No room to track another file
+         apx_msg_t msg = {RMF_MSG_WRITE_NOTIFY, 0, 0, 0}; //{msgType,msgData1,msgData2,msgData3}
+         msg.msgData1 = offset;
+         msg.msgData2 = length;
+         msg.msgData3 = (void*)file;
+         apx_es_queueWriteNotify(self, &msg);
       }
    }
 }
@@ -340,10 +350,10 @@ void apx_es_fileManager_run(apx_es_fileManager_t *self)
                 self->pendingWrite);
       }
    }
-   if (self->queuedWriteNotify.msgType == RMF_MSG_WRITE_NOTIFY)
+   if (self->numDirtyFiles > 0)
    {
       // Add any pending write notifications to the msg queue
-      apx_es_processQueuedWriteNotify(self);
+      apx_es_flushDirtyRanges(self);
    }
 
    // Trigger refresh of the transmitBufLen before loop
@@ -400,9 +410,10 @@ static void apx_es_resetConnectionState(apx_es_fileManager_t *self)
    rbfs_clear(&self->messageQueue);
    self->receiveBufOffset = 0;
    self->receiveStartAddress = RMF_INVALID_ADDRESS;
+   self->curShadow = 0;
    self->transmitBuf = 0;
    self->transmitBufLen = 0;
-   self->queuedWriteNotify.msgType = RMF_CMD_INVALID_MSG;
+   self->numDirtyFiles = 0;
    self->pendingMsg.msgType = RMF_CMD_INVALID_MSG;
    self->pendingWrite = false;
    self->dropMessage = false;
@@ -411,32 +422,166 @@ static void apx_es_resetConnectionState(apx_es_fileManager_t *self)
    memset(&self->fileWriteInfo, 0, sizeof(apx_es_file_write_t));
 }
 
-static void apx_es_processQueuedWriteNotify(apx_es_fileManager_t *self)
+static void apx_es_flushDirtyRanges(apx_es_fileManager_t *self)
+{
+   uint8_t i;
+   uint8_t numKept = 0;
+   for (i=0; i<self->numDirtyFiles; i++)
+   {
+      apx_es_dirtyFile_t *dirtyFile = &self->dirtyFiles[i];
+      uint8_t j = 0;
+      while ( (j < dirtyFile->numRanges) && (rbfs_free(&self->messageQueue) > 0) )
+      {
+         apx_msg_t msg = {RMF_MSG_WRITE_NOTIFY, 0, 0, 0};
+         msg.msgData1 = dirtyFile->ranges[j].offset;
+         msg.msgData2 = dirtyFile->ranges[j].length;
+         msg.msgData3 = (void*) dirtyFile->file;
+         apx_es_queueWriteNotify(self, &msg);
+         j++;
+      }
+      if (j < dirtyFile->numRanges)
+      {
+         // The message queue is full, keep the rest until the next call to apx_es_fileManager_run()
+         memmove(&dirtyFile->ranges[0], &dirtyFile->ranges[j], (dirtyFile->numRanges - j) * sizeof(apx_es_dirtyRange_t));
+         dirtyFile->numRanges = (uint8_t) (dirtyFile->numRanges - j);
+         if (numKept != i)
+         {
+            self->dirtyFiles[numKept] = *dirtyFile;
+         }
+         numKept++;
+      }
+   }
+   self->numDirtyFiles = numKept;
+}
+
+static void apx_es_queueWriteNotify(apx_es_fileManager_t *self, const apx_msg_t *msg)
 {
 #if APX_DEBUG_ENABLE
    if (rbfs_free(&self->messageQueue) <= APX_MSQ_QUEUE_WARN_THRESHOLD)
    {
-      fprintf(stderr, "messageQueue fill warning for delayed RMF_MSG_WRITE_NOTIFY. Free before add: %d\n", rbfs_free(&self->messageQueue));
+      fprintf(stderr, "messageQueue fill warning for RMF_MSG_WRITE_NOTIFY. Free before add: %d\n", rbfs_free(&self->messageQueue));
    }
 #endif
 #if APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS == 1
-   apx_es_queueWriteNotifyUnlessPrevQueued(self);
-#else
-   rbfs_insert(&self->messageQueue, (const uint8_t*) &self->queuedWriteNotify);
+   // All queued reads of the same range would read the same data
+   if (E_BUF_UNDERFLOW == rbfs_exists(&self->messageQueue, (const uint8_t*) msg))
 #endif
-   self->queuedWriteNotify.msgType = RMF_CMD_INVALID_MSG;
+   {
+      rbfs_insert(&self->messageQueue, (const uint8_t*) msg);
+   }
 }
 
-#if APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS == 1
-static void apx_es_queueWriteNotifyUnlessPrevQueued(apx_es_fileManager_t *self)
+static apx_es_dirtyFile_t *apx_es_getDirtyFile(apx_es_fileManager_t *self, apx_file_t *file)
 {
-   if (E_BUF_UNDERFLOW == rbfs_exists(&self->messageQueue,
-                                      (uint8_t*) &self->queuedWriteNotify))
+   uint8_t i;
+   apx_es_dirtyFile_t *dirtyFile;
+   for (i=0; i<self->numDirtyFiles; i++)
    {
-      rbfs_insert(&self->messageQueue, (uint8_t*) &self->queuedWriteNotify);
+      if (self->dirtyFiles[i].file == file)
+      {
+         return &self->dirtyFiles[i];
+      }
+   }
+   if (self->numDirtyFiles >= APX_ES_FILEMANAGER_MAX_NUM_DIRTY_FILES)
+   {
+      return 0;
+   }
+   dirtyFile = &self->dirtyFiles[self->numDirtyFiles++];
+   dirtyFile->file = file;
+   dirtyFile->numRanges = 0;
+   return dirtyFile;
+}
+
+/**
+ * adds [offset, offset+length) to the sorted range list and merges it with its neighbours where possible
+ */
+static void apx_es_dirtyFile_insert(apx_es_dirtyFile_t *dirtyFile, uint32_t offset, uint32_t length)
+{
+   uint8_t i;
+   if (dirtyFile->numRanges >= APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES)
+   {
+      // Make room by merging the two closest ranges
+      apx_es_dirtyFile_coalesce(dirtyFile, true);
+   }
+   i = dirtyFile->numRanges;
+   while ( (i > 0) && (dirtyFile->ranges[i-1].offset > offset) )
+   {
+      dirtyFile->ranges[i] = dirtyFile->ranges[i-1];
+      i--;
+   }
+   dirtyFile->ranges[i].offset = offset;
+   dirtyFile->ranges[i].length = length;
+   dirtyFile->numRanges++;
+   apx_es_dirtyFile_coalesce(dirtyFile, false);
+}
+
+/**
+ * Merges neighbouring ranges that overlap, or that are at most APX_ES_FILEMANAGER_DIRTY_RANGE_GAP_THRESHOLD bytes apart
+ * as long as the result is not longer than DIRTY_RANGE_MAX_MERGED_LEN.
+ * When force is true only the two ranges with the smallest gap are merged (regardless of length).
+ */
+static void apx_es_dirtyFile_coalesce(apx_es_dirtyFile_t *dirtyFile, bool force)
+{
+   uint8_t i = 0;
+   uint8_t closest = 0;
+   uint32_t closestGap = UINT32_MAX;
+   while ( (i+1) < dirtyFile->numRanges )
+   {
+      apx_es_dirtyRange_t *left = &dirtyFile->ranges[i];
+      const apx_es_dirtyRange_t *right = &dirtyFile->ranges[i+1];
+      uint32_t leftEnd = left->offset + left->length;
+      uint32_t rightEnd = right->offset + right->length;
+      uint32_t mergedEnd = (rightEnd > leftEnd)? rightEnd : leftEnd;
+      uint32_t gap = (right->offset > leftEnd)? (right->offset - leftEnd) : 0u;
+      bool merge = false;
+      if (force)
+      {
+         if (gap < closestGap)
+         {
+            closestGap = gap;
+            closest = i;
+         }
+      }
+      else if ( (right->offset < leftEnd) ||
+                ( (gap <= APX_ES_FILEMANAGER_DIRTY_RANGE_GAP_THRESHOLD) &&
+                  ((mergedEnd - left->offset) <= DIRTY_RANGE_MAX_MERGED_LEN) ) )
+      {
+         merge = true;
+      }
+      else
+      {
+         // Keep separate
+      }
+      if (merge)
+      {
+         uint8_t j;
+         left->length = mergedEnd - left->offset;
+         for (j=i+1; (j+1)<dirtyFile->numRanges; j++)
+         {
+            dirtyFile->ranges[j] = dirtyFile->ranges[j+1];
+         }
+         dirtyFile->numRanges--;
+      }
+      else
+      {
+         i++;
+      }
+   }
+   if (force && (dirtyFile->numRanges > 1))
+   {
+      apx_es_dirtyRange_t *left = &dirtyFile->ranges[closest];
+      const apx_es_dirtyRange_t *right = &dirtyFile->ranges[closest+1];
+      uint32_t leftEnd = left->offset + left->length;
+      uint32_t rightEnd = right->offset + right->length;
+      uint8_t j;
+      left->length = ((rightEnd > leftEnd)? rightEnd : leftEnd) - left->offset;
+      for (j=closest+1; (j+1)<dirtyFile->numRanges; j++)
+      {
+         dirtyFile->ranges[j] = dirtyFile->ranges[j+1];
+      }
+      dirtyFile->numRanges--;
    }
 }
-#endif
 
 /**
  * runs internal event loop
@@ -768,10 +913,26 @@ static void apx_es_fileManager_parseDataMsg(apx_es_fileManager_t *self, uint32_t
          apx_file_t *remoteFile = apx_es_fileMap_findByAddress(&self->remoteFileMap, address);
          if ( (remoteFile != 0) && remoteFile->isOpen)
          {
+            apx_es_receiveShadow_t *shadow = apx_es_findReceiveShadow(self, remoteFile);
             offset=address-remoteFile->fileInfo.address;
             if (!more_bit)
             {
-               apx_file_write(remoteFile, dataBuf, offset, dataLen);
+               if ( (apx_file_write(remoteFile, dataBuf, offset, dataLen) == 0) && (shadow != 0) )
+               {
+                  apx_es_extendShadowStaleRange(shadow, offset, (uint32_t) dataLen);
+               }
+            }
+            else if (shadow != 0)
+            {
+               //start fragmented message reception directly into the shadow buffer of the file
+               self->curFile = remoteFile;
+               self->curShadow = shadow;
+               self->receiveStartAddress = address;
+               self->receiveBufOffset = 0;
+               if (apx_es_receiveIntoShadow(self, offset, dataBuf, (uint32_t) dataLen) != 0)
+               {
+                  self->dropMessage = true; //message outside of file
+               }
             }
             else if(((uint32_t)dataLen) <= self->receiveBufLen)
             {
@@ -794,22 +955,30 @@ static void apx_es_fileManager_parseDataMsg(apx_es_fileManager_t *self, uint32_t
       }
       else
       {
+         //offset relative to the start of the reception
+         offset = address-self->receiveStartAddress;
          if (self->dropMessage)
          {
-            // Avoid curFile deref - keep dropping message
-            offset = self->receiveBufLen;
+            // Keep dropping message until the last fragment
          }
-         else
-         {
-            offset = address-self->curFile->fileInfo.address;
-         }
-         if (offset != self->receiveBufOffset)
+         else if (offset != self->receiveBufOffset)
          {
             self->dropMessage = true; //drop message since offsets don't match
 #if APX_DEBUG_ENABLE
             fprintf(stderr, "[APX_ES_FILEMANAGER] invalid offset (%u), message dropped\n",offset);
 #endif
          }
+         else if (self->curShadow != 0)
+         {
+            uint32_t fileOffset = self->receiveStartAddress-self->curFile->fileInfo.address;
+            if (apx_es_receiveIntoShadow(self, fileOffset+offset, dataBuf, (uint32_t) dataLen) != 0)
+            {
+               self->dropMessage = true; //message outside of file
+#if APX_DEBUG_ENABLE
+               fprintf(stderr, "[APX_ES_FILEMANAGER] message too long (%d bytes), message dropped\n",dataLen);
+#endif
+            }
+         }
          else if((offset+dataLen) <= self->receiveBufLen)
          {
             //copy data
@@ -823,22 +992,28 @@ static void apx_es_fileManager_parseDataMsg(apx_es_fileManager_t *self, uint32_t
             fprintf(stderr, "[APX_ES_FILEMANAGER] message too long (%d bytes), message dropped\n",dataLen);
 #endif
          }
-
-         if (!more_bit)
+      }
+      if ( (!more_bit) && (self->receiveStartAddress != RMF_INVALID_ADDRESS) )
+      {
+         if (!self->dropMessage)
          {
-            if (!self->dropMessage)
+            //send message to upper layer
+            uint32_t startOffset=self->receiveStartAddress-self->curFile->fileInfo.address;
+            if (self->curShadow != 0)
+            {
+               apx_es_commitShadow(self, startOffset, self->receiveBufOffset);
+            }
+            else
             {
-               //send message to upper layer
-               uint32_t startOffset=self->receiveStartAddress-self->curFile->fileInfo.address;
                apx_file_write(self->curFile, self->receiveBuf, startOffset, self->receiveBufOffset);
             }
-            //reset variables for next reception
-            self->dropMessage=false;
-            self->curFile=0;
-            self->receiveStartAddress=RMF_INVALID_ADDRESS;
-            self->receiveBufOffset=0;
          }
-
+         //reset variables for next reception
+         self->dropMessage=false;
+         self->curFile=0;
+         self->curShadow=0;
+         self->receiveStartAddress=RMF_INVALID_ADDRESS;
+         self->receiveBufOffset=0;
       }
       //printf("apx_es_fileManager_parseDataMsg %08X, %d, %d\n",address, (int) dataLen, (int) more_bit);
    }
@@ -993,6 +1168,146 @@ static int32_t apx_es_processPendingWrite(apx_es_fileManager_t *self)
    return -1;
 }
 
+static apx_es_receiveShadow_t *apx_es_findReceiveShadow(apx_es_fileManager_t *self, const apx_file_t *file)
+{
+   uint16_t i;
+   for (i=0; i<self->numReceiveShadows; i++)
+   {
+      if (self->receiveShadows[i].file == file)
+      {
+         return &self->receiveShadows[i];
+      }
+   }
+   return 0;
+}
+
+/**
+ * returns a pointer to the nodeData member that points to the data of file, or NULL if the file type has no such buffer
+ */
+static uint8_t **apx_es_getFileDataBuf(apx_file_t *file, uint32_t *dataLen)
+{
+   apx_nodeData_t *nodeData = file->nodeData;
+   if (nodeData != 0)
+   {
+      switch(file->fileType)
+      {
+      case APX_DEFINITION_FILE: //fall-through
+      case APX_DEFINITION_BIN_FILE:
+         *dataLen = nodeData->definitionDataLen;
+         return &nodeData->definitionDataBuf;
+      case APX_INDATA_FILE:
+         *dataLen = nodeData->inPortDataLen;
+         return &nodeData->inPortDataBuf;
+      case APX_OUTDATA_FILE:
+         *dataLen = nodeData->outPortDataLen;
+         return &nodeData->outPortDataBuf;
+      default:
+         break;
+      }
+   }
+   return 0;
+}
+
+#ifndef APX_EMBEDDED
+/**
+ * returns the nodeData lock that protects the data buffer returned by apx_es_getFileDataBuf
+ */
+static SPINLOCK_T *apx_es_getFileDataLock(apx_file_t *file)
+{
+   apx_nodeData_t *nodeData = file->nodeData;
+   switch(file->fileType)
+   {
+   case APX_INDATA_FILE:
+      return &nodeData->inPortDataLock;
+   case APX_OUTDATA_FILE:
+      return &nodeData->outPortDataLock;
+   default:
+      return &nodeData->definitionDataLock;
+   }
+}
+#endif
+
+static void apx_es_extendShadowStaleRange(apx_es_receiveShadow_t *shadow, uint32_t offset, uint32_t length)
+{
+   if (shadow->staleBegin == shadow->staleEnd)
+   {
+      shadow->staleBegin = offset;
+      shadow->staleEnd = offset + length;
+   }
+   else
+   {
+      if (offset < shadow->staleBegin)
+      {
+         shadow->staleBegin = offset;
+      }
+      if ( (offset + length) > shadow->staleEnd)
+      {
+         shadow->staleEnd = offset + length;
+      }
+   }
+}
+
+/**
+ * copies one fragment into the shadow buffer of curFile. offset is the file offset.
+ * returns -1 if the fragment does not fit inside the file
+ */
+static int8_t apx_es_receiveIntoShadow(apx_es_fileManager_t *self, uint32_t offset, const uint8_t *dataBuf, uint32_t dataLen)
+{
+   apx_es_receiveShadow_t *shadow = self->curShadow;
+   if ( (offset > shadow->dataLen) || (dataLen > (shadow->dataLen - offset)) )
+   {
+      return -1;
+   }
+   memcpy(&shadow->shadowBuf[offset], dataBuf, dataLen);
+   apx_es_extendShadowStaleRange(shadow, offset, dataLen);
+   self->receiveBufOffset += dataLen;
+   return 0;
+}
+
+/**
+ * makes the shadow buffer of curFile the data buffer of the file. [offset, offset+length) is the range that was received,
+ * the rest of the stale range is first brought up to date from the current data buffer.
+ */
+static void apx_es_commitShadow(apx_es_fileManager_t *self, uint32_t offset, uint32_t length)
+{
+   apx_es_receiveShadow_t *shadow = self->curShadow;
+   apx_file_t *file = shadow->file;
+   uint32_t dataLen = 0u;
+   uint8_t **ppDataBuf = apx_es_getFileDataBuf(file, &dataLen);
+   uint32_t end = offset + length;
+   uint8_t *prevDataBuf;
+#ifndef APX_EMBEDDED
+   SPINLOCK_T *dataLock = apx_es_getFileDataLock(file);
+#endif
+   assert( (ppDataBuf != 0) && (dataLen == shadow->dataLen) );
+   if (shadow->staleBegin < offset)
+   {
+      memcpy(&shadow->shadowBuf[shadow->staleBegin], &(*ppDataBuf)[shadow->staleBegin], offset - shadow->staleBegin);
+   }
+   if (shadow->staleEnd > end)
+   {
+      memcpy(&shadow->shadowBuf[end], &(*ppDataBuf)[end], shadow->staleEnd - end);
+   }
+#ifndef APX_EMBEDDED
+   //readers copy from the data buffer while holding the same lock, see apx_nodeData_readInPortData
+   SPINLOCK_ENTER(*dataLock);
+#endif
+   prevDataBuf = *ppDataBuf;
+   *ppDataBuf = shadow->shadowBuf;
+   shadow->shadowBuf = prevDataBuf;
+#ifndef APX_EMBEDDED
+   SPINLOCK_LEAVE(*dataLock);
+#endif
+   //the previous data buffer lacks only what was just received
+   shadow->staleBegin = offset;
+   shadow->staleEnd = end;
+   shadow->generation++;
+   if (file->fileType == APX_INDATA_FILE)
+   {
+      apx_nodeData_triggerInPortDataWritten(file->nodeData, offset, length);
+   }
+}
+
 /**
  * returns -1 on failure, 0 on success
  */
@@ -1,6 +1,7 @@
 /**
  * embedded version of apx_fileMap.c. This version uses fixed-size linear list instead of a dynamic linked list (no malloc required)
- *
+ * The list is kept sorted by address so that files can be found using binary search.
+ * Alternatively the map can be backed by a const table of files with precomputed addresses (see apx_es_fileMap_createStatic).
  */
 //////////////////////////////////////////////////////////////////////////////
 // INCLUDES
@@ -16,7 +17,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #define PORT_DATA_START      0x0u
 #define PORT_DATA_BOUNDARY   0x400u //1KB, this must be a power of 2
-#define DEFINITION_START     0x4000000 //64MB, this must be a pointer of 2
+#define DEFINITION_START     0x4000000 //64MB, this must be a power of 2
 #define DEFINITION_BOUNDARY  0x100000u //1MB, this must be a power of 2
 #define USER_DATA_START      0x20000000 //512MB, this must be a power of 2
 #define USER_DATA_END        0x3FFFFC00 //Start of remote file cmd message area
@@ -29,6 +30,8 @@
 static int8_t apx_es_fileMap_autoInsertInternal(apx_es_fileMap_t *self, apx_file_t *pFile, uint32_t start_address, uint32_t end_address, uint32_t address_boundary);
 static int8_t apx_es_fileMap_insertAt(apx_es_fileMap_t *self, apx_file_t *pFile, int32_t index);
 static int8_t apx_es_fileMap_removeAt(apx_es_fileMap_t *self, int32_t index);
+static int32_t apx_es_fileMap_upperBound(const apx_es_fileMap_t *self, uint32_t address);
+static bool apx_es_fileMap_contains(const apx_file_t *file, uint32_t address);
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL VARIABLES
@@ -43,21 +46,75 @@ void apx_es_fileMap_create(apx_es_fileMap_t *self)
    if (self != 0)
    {
       memset(self->fileList,0,sizeof(self->fileList));
+      self->files=&self->fileList[0];
       self->curLen=0;
       self->lastIndex=-1;
+      self->isStatic=false;
    }
 }
 
+/**
+ * Uses fileTable as the content of the map. fileTable must be sorted by address with non-overlapping files.
+ * The table is typically generated at build time (see apx_codegen -t) and placed in flash, the addresses of its files
+ * are already set. The map is read-only after this call.
+ */
+int8_t apx_es_fileMap_createStatic(apx_es_fileMap_t *self, apx_file_t * const *fileTable, int32_t numFiles)
+{
+   if ( (self != 0) && (fileTable != 0) && (numFiles >= 0) )
+   {
+      int32_t i;
+      for (i=0; i<numFiles; i++)
+      {
+         if (fileTable[i] == 0)
+         {
+            errno = EINVAL;
+            return -1;
+         }
+         if (i > 0)
+         {
+            const apx_file_t *prev = fileTable[i-1];
+            if ( (prev->fileInfo.address >= fileTable[i]->fileInfo.address) ||
+                 ( (fileTable[i]->fileInfo.address - prev->fileInfo.address) < prev->fileInfo.length) )
+            {
+               errno = EINVAL;
+               return -1; //not sorted or overlapping
+            }
+         }
+      }
+      apx_es_fileMap_create(self);
+      self->files=fileTable;
+      self->curLen=numFiles;
+      self->isStatic=true;
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
 int8_t apx_es_fileMap_autoInsert(apx_es_fileMap_t *self, apx_file_t *pFile)
 {
    if ( (self != 0) && (pFile != 0) )
    {
+      if (self->isStatic)
+      {
+         int32_t i;
+         for (i=0; i<self->curLen; i++)
+         {
+            if (self->files[i] == pFile)
+            {
+               return 0; //address was assigned when the table was generated
+            }
+         }
+         errno = EPERM;
+         return -1;
+      }
       switch(pFile->fileType)
       {
          case APX_OUTDATA_FILE: //fall-through
          case APX_INDATA_FILE:
             return apx_es_fileMap_autoInsertInternal(self, pFile, PORT_DATA_START, DEFINITION_START, PORT_DATA_BOUNDARY);
-         case APX_DEFINITION_FILE:
+         case APX_DEFINITION_FILE: //fall-through
+         case APX_DEFINITION_BIN_FILE:
             return apx_es_fileMap_autoInsertInternal(self, pFile, DEFINITION_START, USER_DATA_START, DEFINITION_BOUNDARY);
          case APX_USER_DATA_FILE:
             return apx_es_fileMap_autoInsertInternal(self, pFile, USER_DATA_START, USER_DATA_END, USER_DATA_BOUNDARY);
@@ -73,27 +130,12 @@ int8_t apx_es_fileMap_insert(apx_es_fileMap_t *self, apx_file_t *pFile)
 {
    if ( (self != 0) && (pFile != 0) )
    {
-      int32_t i;
-      int32_t placementIndex=-1;
-      if (self->curLen == 0)
+      if (self->isStatic)
       {
-         placementIndex=0;
+         errno = EPERM;
+         return -1;
       }
-      else
-      {
-         apx_file_t *pCurrent=0;
-         placementIndex=self->curLen;
-         for(i=0;i<self->curLen;i++)
-         {
-            pCurrent = self->fileList[i];
-            if (pCurrent->fileInfo.address > pFile->fileInfo.address )
-            {
-               placementIndex = i;
-               break;
-            }
-         }
-      }
-      return apx_es_fileMap_insertAt(self, pFile, placementIndex);
+      return apx_es_fileMap_insertAt(self, pFile, apx_es_fileMap_upperBound(self, pFile->fileInfo.address));
    }
    return -1;
 }
@@ -104,6 +146,11 @@ int8_t apx_es_fileMap_remove(apx_es_fileMap_t *self, apx_file_t *pFile)
    {
       int32_t i;
       apx_file_t *pCurrent=0;
+      if (self->isStatic)
+      {
+         errno = EPERM;
+         return -1;
+      }
       for(i=0;i<self->curLen;i++)
       {
          pCurrent = self->fileList[i];
@@ -120,7 +167,14 @@ void apx_es_fileMap_clear(apx_es_fileMap_t *self)
 {
    if (self != 0)
    {
-      apx_es_fileMap_create(self);
+      if (self->isStatic)
+      {
+         self->lastIndex=-1; //a const table cannot be cleared
+      }
+      else
+      {
+         apx_es_fileMap_create(self);
+      }
    }
 }
 
@@ -128,34 +182,37 @@ apx_file_t *apx_es_fileMap_findByAddress(apx_es_fileMap_t *self, uint32_t addres
 {
    if (self != 0)
    {
-      uint32_t startAddress;
-      uint32_t endAddress;
-      int32_t i;
-      if ( (self->lastIndex>=0) && (self->lastIndex<self->curLen) )
+      int32_t index;
+      if ( (self->lastIndex>=0) && (self->lastIndex<self->curLen) &&
+           (apx_es_fileMap_contains(self->files[self->lastIndex], address)) )
       {
-         apx_file_t *file = self->fileList[self->lastIndex];
-         startAddress = file->fileInfo.address;
-         endAddress = startAddress+file->fileInfo.length;
-         if ( (address >= startAddress) && (address < endAddress) )
-         {
-            return self->fileList[self->lastIndex];
-         }
+         return self->files[self->lastIndex];
+      }
+      index = apx_es_fileMap_upperBound(self, address) - 1; //last file starting at or before address
+      if ( (index >= 0) && (apx_es_fileMap_contains(self->files[index], address)) )
+      {
+         self->lastIndex = index;
+         return self->files[index];
       }
+   }
+   return (apx_file_t*) 0;
+}
+
+apx_file_t *apx_es_fileMap_findByName(apx_es_fileMap_t *self, const char *name)
+{
+   if ( (self != 0) && (name != 0) )
+   {
+      int32_t i;
       for (i=0; i<self->curLen; i++)
       {
-         apx_file_t *file = self->fileList[i];
-         startAddress = file->fileInfo.address;
-         endAddress = startAddress+file->fileInfo.length;
-         if ( (address >= startAddress) && (address < endAddress) )
+         if (strcmp(self->files[i]->fileInfo.name, name) == 0)
          {
-            self->lastIndex = i;
-            return file;
+            return self->files[i];
          }
       }
    }
    return (apx_file_t*) 0;
 }
-apx_file_t *apx_es_fileMap_findByName(apx_es_fileMap_t *self, const char *name);
 
 int32_t apx_es_fileMap_length(apx_es_fileMap_t *self)
 {
@@ -170,7 +227,7 @@ apx_file_t *apx_es_fileMap_get(apx_es_fileMap_t *self, int32_t index)
 {
    if ( (self != 0) && (index>=0) && (index<self->curLen) )
    {
-      return self->fileList[index];
+      return self->files[index];
    }
    return (apx_file_t*) 0;
 }
@@ -192,27 +249,13 @@ static int8_t apx_es_fileMap_autoInsertInternal(apx_es_fileMap_t *self, apx_file
       }
       else
       {
-         apx_file_t *pCurrent=0;
          uint32_t placement_address = start_address;
-         placementIndex = 0;
-         for(i=0;i<self->curLen;i++)
+         //a file placed into an empty area goes after all files in lower areas to keep the list sorted
+         placementIndex = (start_address == 0u)? 0 : apx_es_fileMap_upperBound(self, start_address-1u);
+         i = apx_es_fileMap_upperBound(self, end_address-1u) - 1; //last file in the area
+         if (i >= placementIndex)
          {
-            pCurrent = self->fileList[i];
-            if (pCurrent != 0)
-            {
-               if( pCurrent->fileInfo.address >= end_address)
-               {
-                  break; //we have passed into the next area, break and use latest seen value of found
-               }
-               else if(pCurrent->fileInfo.address >= start_address)
-               {
-                  found = i; //update pFound
-               }
-               else
-               {
-                  //pCurrent doesn't match range and is ignored
-               }
-            }
+            found = i;
          }
          if (found >= 0)
          {
@@ -281,6 +324,7 @@ static int8_t apx_es_fileMap_removeAt(apx_es_fileMap_t *self, int32_t index)
    if ( (self != 0) && (self->curLen>0) && (index >= 0) && (index < self->curLen) )
    {
       int32_t i;
+      self->lastIndex=-1;
       for (i=index;i<self->curLen-1;i++)
       {
          self->fileList[i]=self->fileList[i+1];
@@ -290,3 +334,30 @@ static int8_t apx_es_fileMap_removeAt(apx_es_fileMap_t *self, int32_t index)
    }
    return -1;
 }
+
+/**
+ * returns index of the first file with a start address greater than address (curLen if there is none)
+ */
+static int32_t apx_es_fileMap_upperBound(const apx_es_fileMap_t *self, uint32_t address)
+{
+   int32_t low = 0;
+   int32_t high = self->curLen;
+   while (low < high)
+   {
+      int32_t mid = low + ( (high - low) >> 1);
+      if (self->files[mid]->fileInfo.address > address)
+      {
+         high = mid;
+      }
+      else
+      {
+         low = mid + 1;
+      }
+   }
+   return low;
+}
+
+static bool apx_es_fileMap_contains(const apx_file_t *file, uint32_t address)
+{
+   return ( (address >= file->fileInfo.address) && ( (address - file->fileInfo.address) < file->fileInfo.length) );
+}
@@ -26,9 +26,11 @@
 //////////////////////////////////////////////////////////////////////////////
 static void apx_es_filemanager_create(CuTest* tc);
 static void apx_es_filemanager_write_notify(CuTest* tc);
+static void apx_es_filemanager_dirty_range_limit(CuTest* tc);
 static void apx_es_filemanager_serialize_all_commands(CuTest* tc);
 static void apx_es_filemanager_request_files(CuTest* tc);
 static void apx_es_filemanager_enter_pending_mode_when_buffer_is_full(CuTest* tc);
+static void apx_es_filemanager_receive_fragmented_write_into_shadow(CuTest* tc);
 static int32_t TestStub_getSendAvail(void *arg);
 static uint8_t* TestStub_getSendBuffer(void *arg, int32_t msgLen);
 static int32_t TestStub_send(void *arg, int32_t offset, int32_t msgLen);
@@ -60,9 +62,11 @@ CuSuite* testsuite_apx_es_filemanager(void)
 
    SUITE_ADD_TEST(suite, apx_es_filemanager_create);
    SUITE_ADD_TEST(suite, apx_es_filemanager_write_notify);
+   SUITE_ADD_TEST(suite, apx_es_filemanager_dirty_range_limit);
    SUITE_ADD_TEST(suite, apx_es_filemanager_serialize_all_commands);
    SUITE_ADD_TEST(suite, apx_es_filemanager_request_files);
    SUITE_ADD_TEST(suite, apx_es_filemanager_enter_pending_mode_when_buffer_is_full);
+   SUITE_ADD_TEST(suite, apx_es_filemanager_receive_fragmented_write_into_shadow);
 
 
    return suite;
@@ -86,7 +90,7 @@ static void apx_es_filemanager_create(CuTest* tc)
    CuAssertTrue(tc, !fileManager.dropMessage);
    CuAssertTrue(tc, !fileManager.pendingWrite);
 
-   CuAssertUIntEquals(tc, RMF_CMD_INVALID_MSG, fileManager.queuedWriteNotify.msgType);
+   CuAssertUIntEquals(tc, 0, fileManager.numDirtyFiles);
    CuAssertUIntEquals(tc, RMF_CMD_INVALID_MSG, fileManager.pendingMsg.msgType);
 
    CuAssertUIntEquals(tc, 0, fileManager.transmitBufLen);
@@ -109,11 +113,6 @@ static void apx_es_filemanager_write_notify(CuTest* tc)
    apx_nodeData_t node;
    uint8_t data[FILE_WRITE_NOTIFY_SIZE];
    apx_msg_t topOfQueue;
-   apx_msg_t prevQueued;
-   uint8_t expected_write_notify_size1 = 0;
-   uint8_t expected_write_notify_size2 = 0;
-   uint8_t expected_write_notify_size3 = 0;
-   uint8_t expected_write_notify_size4 = 0;
    const uint8_t one_byte_write = 1u;
    apx_es_fileManager_create(&fileManager,
                              messageQueueBuf, APX_FILE_MANAGER_MAX_NUM_MESSAGES,
@@ -147,98 +146,131 @@ static void apx_es_filemanager_write_notify(CuTest* tc)
    CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
    apx_nodeData_outPortDataNotify(&node, 0, 1);
    apx_es_fileManager_onFileUpdate(&fileManager, data, 0, 1);
-   expected_write_notify_size1 = 1 + RMF_LOW_ADDRESS_SIZE;
    CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
+   CuAssertUIntEquals(tc, 0, fileManager.numDirtyFiles);
 
-   // First write shall be put aside for update if file is open
+   // Writes are collected in the dirty range set of the file until run()
    file.isOpen = true;
    apx_nodeData_outPortDataNotify(&node, 0, one_byte_write);
    CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
-   CuAssertUIntEquals(tc, RMF_MSG_WRITE_NOTIFY, fileManager.queuedWriteNotify.msgType);
+   CuAssertUIntEquals(tc, 1, fileManager.numDirtyFiles);
+   CuAssertPtrEquals(tc, &file, fileManager.dirtyFiles[0].file);
+   CuAssertUIntEquals(tc, 1, fileManager.dirtyFiles[0].numRanges);
 
-   // Next shall put queuedWiriteNotify on the message queue unless write aligns
-   prevQueued = fileManager.queuedWriteNotify;
-   apx_nodeData_outPortDataNotify(&node, 2, one_byte_write);
-
-   rbfs_peek(&fileManager.messageQueue, &topOfQueue);
-   CuAssertUIntEquals(tc, 1, rbfs_size(&fileManager.messageQueue));
-   CuAssertIntEquals(tc, 0, memcmp(&topOfQueue, &prevQueued, sizeof(apx_msg_t)));
-   CuAssertUIntEquals(tc, one_byte_write, fileManager.queuedWriteNotify.msgData2);
-
-   // Test write align does not trigger any message to be appended
-   apx_nodeData_outPortDataNotify(&node, 3, one_byte_write);
-
-   rbfs_peek(&fileManager.messageQueue, &topOfQueue);
-   CuAssertUIntEquals(tc, 1, rbfs_size(&fileManager.messageQueue));
-   CuAssertIntEquals(tc, 0, memcmp(&topOfQueue, &prevQueued, sizeof(apx_msg_t)));
-   CuAssertUIntEquals(tc, one_byte_write + one_byte_write, fileManager.queuedWriteNotify.msgData2);
-   expected_write_notify_size2 = 2 + RMF_LOW_ADDRESS_SIZE;
+   // Ranges further apart than the gap threshold are kept separate
+   apx_nodeData_outPortDataNotify(&node, 5, one_byte_write);
+   CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
+   CuAssertUIntEquals(tc, 2, fileManager.dirtyFiles[0].numRanges);
+   CuAssertUIntEquals(tc, 5, fileManager.dirtyFiles[0].ranges[1].offset);
 
-   // With APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS enabled write to the same location twice shall not trigger queued item
+   // Writes in any order are merged when bridging the gap is cheaper than another header
    apx_nodeData_outPortDataNotify(&node, 2, one_byte_write);
-   apx_nodeData_outPortDataNotify(&node, 3, one_byte_write);
-   apx_nodeData_outPortDataNotify(&node, 2, one_byte_write + one_byte_write);
-   CuAssertUIntEquals(tc, 1, rbfs_size(&fileManager.messageQueue));
+   apx_nodeData_outPortDataNotify(&node, 7, one_byte_write);
+   CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
+   CuAssertUIntEquals(tc, 1, fileManager.dirtyFiles[0].numRanges);
+   CuAssertUIntEquals(tc, 0, fileManager.dirtyFiles[0].ranges[0].offset);
+   CuAssertUIntEquals(tc, 8, fileManager.dirtyFiles[0].ranges[0].length);
 
-   // With APX_ES_FILEMANAGER_OPTIMIZE_WRITE_NOTIFICATIONS enabled write to the same location as in the queue shall not trigger adding it to the queue again,
-   // It will however move the queuedWriteNotify onto the queue
-   apx_nodeData_outPortDataNotify(&node, 0, one_byte_write);
-   CuAssertUIntEquals(tc, 2, rbfs_size(&fileManager.messageQueue));
-   CuAssertUIntEquals(tc, RMF_MSG_WRITE_NOTIFY, fileManager.queuedWriteNotify.msgType);
-   CuAssertUIntEquals(tc, 0, fileManager.queuedWriteNotify.msgData1);
-   CuAssertUIntEquals(tc, one_byte_write, fileManager.queuedWriteNotify.msgData2);
-   apx_nodeData_outPortDataNotify(&node, 0, one_byte_write);
-   CuAssertUIntEquals(tc, 2, rbfs_size(&fileManager.messageQueue));
-   CuAssertUIntEquals(tc, RMF_MSG_WRITE_NOTIFY, fileManager.queuedWriteNotify.msgType);
-   CuAssertUIntEquals(tc, 0, fileManager.queuedWriteNotify.msgData1);
-   CuAssertUIntEquals(tc, one_byte_write, fileManager.queuedWriteNotify.msgData2);
+   // Writing the same location again changes nothing
+   apx_nodeData_outPortDataNotify(&node, 2, one_byte_write);
+   apx_nodeData_outPortDataNotify(&node, 3, one_byte_write + one_byte_write);
+   CuAssertUIntEquals(tc, 1, fileManager.dirtyFiles[0].numRanges);
+   CuAssertUIntEquals(tc, 8, fileManager.dirtyFiles[0].ranges[0].length);
+
+   // Merges are not built larger than APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD - RMF_HIGH_ADDRESS_SIZE
+   apx_nodeData_outPortDataNotify(&node, 9, one_byte_write);
+   CuAssertUIntEquals(tc, 2, fileManager.dirtyFiles[0].numRanges);
+   CuAssertUIntEquals(tc, 9, fileManager.dirtyFiles[0].ranges[1].offset);
+
+   // Overlapping ranges are always merged
+   apx_nodeData_outPortDataNotify(&node, 7, 3);
+   CuAssertUIntEquals(tc, 1, fileManager.dirtyFiles[0].numRanges);
+   CuAssertUIntEquals(tc, 0, fileManager.dirtyFiles[0].ranges[0].offset);
+   CuAssertUIntEquals(tc, 10, fileManager.dirtyFiles[0].ranges[0].length);
+   apx_nodeData_outPortDataNotify(&node, 14, 2);
+   CuAssertUIntEquals(tc, 2, fileManager.dirtyFiles[0].numRanges);
+
+   // run() flushes one message per range
+   m_test_send_avail = 10 + RMF_LOW_ADDRESS_SIZE;
+   m_test_data_written = -1;
+   apx_es_fileManager_run(&fileManager);
+   CuAssertUIntEquals(tc, 0, fileManager.numDirtyFiles);
+   CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
+   CuAssertIntEquals(tc, 2 + RMF_LOW_ADDRESS_SIZE, m_test_data_written);
+   CuAssertTrue(tc, !fileManager.pendingWrite);
 
-   apx_nodeData_outPortDataNotify(&node, 5, one_byte_write);
-   CuAssertUIntEquals(tc, 2, rbfs_size(&fileManager.messageQueue));
-   CuAssertUIntEquals(tc, RMF_MSG_WRITE_NOTIFY, fileManager.queuedWriteNotify.msgType);
-   CuAssertUIntEquals(tc, 5, fileManager.queuedWriteNotify.msgData1);
-   CuAssertUIntEquals(tc, one_byte_write, fileManager.queuedWriteNotify.msgData2);
-
-   /* Aligned writes larger than APX_ES_FILE_WRITE_MSG_FRAGMENTATION_THRESHOLD - RMF_HIGH_ADDRESS_SIZE shall not be aligned */
-   // Setup
-   apx_nodeData_outPortDataNotify(&node, 1, sizeof(uint64_t));
-   expected_write_notify_size3 = 1 + RMF_LOW_ADDRESS_SIZE;
-   // Allow previously to be added even it the new write completely covers it...
-   CuAssertUIntEquals(tc, 3, rbfs_size(&fileManager.messageQueue));
-
-   // Up to limit is shall be aligned
-   apx_nodeData_outPortDataNotify(&node, 1, sizeof(uint64_t));
-   CuAssertUIntEquals(tc, 3, rbfs_size(&fileManager.messageQueue));
-
-   // Ensure not building larger than limit
-   apx_nodeData_outPortDataNotify(&node, 1 + sizeof(uint64_t), one_byte_write);
-   expected_write_notify_size4 = 1 + RMF_LOW_ADDRESS_SIZE;
-   CuAssertUIntEquals(tc, 4, rbfs_size(&fileManager.messageQueue));
-
-   // Check how data is transmitted for write notify
-   m_test_send_avail = expected_write_notify_size1;
+   // A range larger than the send buffer becomes a pending (fragmented) write
+   apx_nodeData_outPortDataNotify(&node, 0, 10);
+   m_test_send_avail = 1 + RMF_LOW_ADDRESS_SIZE;
    m_test_data_written = -1;
    apx_es_fileManager_run(&fileManager);
-   CuAssertUIntEquals(tc, 3, rbfs_size(&fileManager.messageQueue)); // Without optimal write size expect one send per loop
-   CuAssertIntEquals(tc, expected_write_notify_size1, m_test_data_written);
+   CuAssertIntEquals(tc, -1, m_test_data_written);
    CuAssertTrue(tc, fileManager.pendingWrite);
-   CuAssertUIntEquals(tc, expected_write_notify_size2 - RMF_LOW_ADDRESS_SIZE, fileManager.fileWriteInfo.remain);
-   m_test_data_written = -1;
+   CuAssertUIntEquals(tc, 10, fileManager.fileWriteInfo.remain);
    // Nothing should happen if trying again with if no larger buffer provided
    apx_es_fileManager_run(&fileManager);
-   CuAssertUIntEquals(tc, 3, rbfs_size(&fileManager.messageQueue)); // Without optimal write size expect one send per loop
    CuAssertIntEquals(tc, -1, m_test_data_written);
    CuAssertTrue(tc, fileManager.pendingWrite);
-   CuAssertUIntEquals(tc, expected_write_notify_size2 - RMF_LOW_ADDRESS_SIZE, fileManager.fileWriteInfo.remain);
-   m_test_data_written = -1;
-   m_test_send_avail = SEND_BUFFER_MAX; // all of them fit in full buffer
+   m_test_send_avail = SEND_BUFFER_MAX;
    apx_es_fileManager_run(&fileManager);
-   // Ensure last message is sent
-   CuAssertIntEquals(tc, expected_write_notify_size4, m_test_data_written);
+   CuAssertIntEquals(tc, 10 + RMF_LOW_ADDRESS_SIZE, m_test_data_written);
    CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
    CuAssertTrue(tc, !fileManager.pendingWrite);
 }
 
+static void apx_es_filemanager_dirty_range_limit(CuTest* tc)
+{
+#define DIRTY_RANGE_QUEUE_LEN 4
+   apx_es_fileManager_t fileManager;
+   uint8_t messageQueueBuf[APX_FILE_MANAGER_MSG_QUEUE_SIZE];
+   uint8_t receiveBuffer[RECEIVE_BUFFER_LEN];
+   apx_file_t file;
+   apx_nodeData_t node;
+   uint8_t data[FILE_WRITE_NOTIFY_SIZE*8];
+   uint32_t i;
+   apx_es_fileManager_create(&fileManager,
+                             messageQueueBuf, DIRTY_RANGE_QUEUE_LEN,
+                             receiveBuffer, RECEIVE_BUFFER_LEN);
+   apx_nodeData_create(&node,"node",NULL,0,NULL,0,0,&data[0],NULL,sizeof(data));
+   apx_file_createLocalFile(&file, APX_OUTDATA_FILE, &node);
+   apx_nodeData_setFileManager(&node, &fileManager);
+   apx_nodeData_setOutPortDataFile(&node, &file);
+   file.isOpen = true;
+
+   // Every fourth byte, backwards. More ranges than can be stored separately
+   for (i=0; i<(APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES+2); i++)
+   {
+      apx_nodeData_outPortDataNotify(&node, (APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES+1-i)*4, 1);
+   }
+   CuAssertUIntEquals(tc, APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES, fileManager.dirtyFiles[0].numRanges);
+   CuAssertUIntEquals(tc, 0, fileManager.dirtyFiles[0].ranges[0].offset);
+   for (i=1; i<APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES; i++)
+   {
+      const apx_es_dirtyRange_t *prev = &fileManager.dirtyFiles[0].ranges[i-1];
+      CuAssertTrue(tc, prev->offset + prev->length < fileManager.dirtyFiles[0].ranges[i].offset);
+   }
+   i = APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES-1;
+   CuAssertUIntEquals(tc, (APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES+1)*4+1,
+         fileManager.dirtyFiles[0].ranges[i].offset + fileManager.dirtyFiles[0].ranges[i].length);
+
+   // Ranges that do not fit in the message queue stay dirty until the next run()
+   TestHelper_resetAndConnectTransmitHandler(&fileManager);
+   apx_es_fileManager_onConnected(&fileManager);
+   m_test_send_avail = 0;
+   i = fileManager.dirtyFiles[0].ranges[DIRTY_RANGE_QUEUE_LEN].offset;
+   apx_es_fileManager_run(&fileManager);
+   CuAssertUIntEquals(tc, 1, fileManager.numDirtyFiles);
+   CuAssertUIntEquals(tc, APX_ES_FILEMANAGER_MAX_NUM_DIRTY_RANGES-DIRTY_RANGE_QUEUE_LEN, fileManager.dirtyFiles[0].numRanges);
+   CuAssertUIntEquals(tc, i, fileManager.dirtyFiles[0].ranges[0].offset);
+   m_test_send_avail = SEND_BUFFER_MAX;
+   apx_es_fileManager_run(&fileManager);
+   CuAssertUIntEquals(tc, 1, fileManager.numDirtyFiles);
+   apx_es_fileManager_run(&fileManager);
+   CuAssertUIntEquals(tc, 0, fileManager.numDirtyFiles);
+   apx_es_fileManager_run(&fileManager);
+   CuAssertUIntEquals(tc, 0, rbfs_size(&fileManager.messageQueue));
+}
+
 
 static void apx_es_filemanager_serialize_all_commands(CuTest* tc)
 {
@@ -509,6 +541,83 @@ static void apx_es_filemanager_enter_pending_mode_when_buffer_is_full(CuTest* tc
    CuAssertIntEquals(tc, -1, m_test_data_written);
 }
 
+static void apx_es_filemanager_receive_fragmented_write_into_shadow(CuTest* tc)
+{
+#define SHADOW_FILE_SIZE 64
+#define SHADOW_RECEIVE_BUFFER_LEN 8
+#define SHADOW_FILE_ADDRESS 0x400
+   apx_file_t file;
+   apx_nodeData_t node;
+   uint8_t data[SHADOW_FILE_SIZE];
+   uint8_t shadow[SHADOW_FILE_SIZE];
+   uint8_t expected[SHADOW_FILE_SIZE];
+   uint8_t msgBuf[RMF_HIGH_ADDRESS_SIZE+SHADOW_FILE_SIZE];
+   apx_es_fileManager_t fileManager;
+   uint8_t messageQueueBuf[APX_FILE_MANAGER_MSG_QUEUE_SIZE];
+   uint8_t receiveBuffer[SHADOW_RECEIVE_BUFFER_LEN];
+   int32_t headerLen;
+   uint32_t i;
+
+   memset(data, 0, SHADOW_FILE_SIZE);
+   memset(shadow, 0xFF, SHADOW_FILE_SIZE);
+   for (i=0; i<SHADOW_FILE_SIZE; i++)
+   {
+      expected[i] = (uint8_t) i;
+   }
+   apx_nodeData_create(&node,"node",0,0,&data[0],0,SHADOW_FILE_SIZE,0,0,0);
+   apx_file_createLocalFile(&file, APX_INDATA_FILE, &node);
+   file.fileInfo.address = SHADOW_FILE_ADDRESS;
+   apx_es_fileManager_create(&fileManager, messageQueueBuf, APX_FILE_MANAGER_MAX_NUM_MESSAGES, receiveBuffer, SHADOW_RECEIVE_BUFFER_LEN);
+   apx_es_fileMap_insert(&fileManager.remoteFileMap, &file);
+   apx_file_open(&file);
+   CuAssertIntEquals(tc, -1, apx_es_fileManager_setReceiveShadow(&fileManager, &file, shadow, SHADOW_FILE_SIZE-1));
+   CuAssertIntEquals(tc, 0, apx_es_fileManager_setReceiveShadow(&fileManager, &file, shadow, SHADOW_FILE_SIZE));
+
+   //whole file in three fragments, larger than the receive buffer
+   for (i=0; i<3; i++)
+   {
+      uint32_t fragmentOffset = i*24;
+      uint32_t fragmentLen = (i < 2)? 24 : SHADOW_FILE_SIZE-48;
+      headerLen = rmf_packHeader(msgBuf, RMF_HIGH_ADDRESS_SIZE, SHADOW_FILE_ADDRESS+fragmentOffset, (i < 2));
+      memcpy(&msgBuf[headerLen], &expected[fragmentOffset], fragmentLen);
+      apx_es_fileManager_onMsgReceived(&fileManager, msgBuf, headerLen+(int32_t) fragmentLen);
+      if (i < 2)
+      {
+         //nothing is visible before the last fragment
+         CuAssertPtrEquals(tc, data, node.inPortDataBuf);
+      }
+   }
+   CuAssertPtrEquals(tc, shadow, node.inPortDataBuf);
+   CuAssertTrue(tc, memcmp(expected, node.inPortDataBuf, SHADOW_FILE_SIZE) == 0);
+   CuAssertUIntEquals(tc, 1, fileManager.receiveShadows[0].generation);
+
+   //partial write into the middle of the file, the rest must be carried over from the previous buffer
+   expected[30] = 0xA0;
+   expected[31] = 0xA1;
+   expected[32] = 0xA2;
+   headerLen = rmf_packHeader(msgBuf, RMF_HIGH_ADDRESS_SIZE, SHADOW_FILE_ADDRESS+30, true);
+   memcpy(&msgBuf[headerLen], &expected[30], 2);
+   apx_es_fileManager_onMsgReceived(&fileManager, msgBuf, headerLen+2);
+   headerLen = rmf_packHeader(msgBuf, RMF_HIGH_ADDRESS_SIZE, SHADOW_FILE_ADDRESS+32, false);
+   memcpy(&msgBuf[headerLen], &expected[32], 1);
+   apx_es_fileManager_onMsgReceived(&fileManager, msgBuf, headerLen+1);
+   CuAssertPtrEquals(tc, data, node.inPortDataBuf);
+   CuAssertTrue(tc, memcmp(expected, node.inPortDataBuf, SHADOW_FILE_SIZE) == 0);
+   CuAssertUIntEquals(tc, 2, fileManager.receiveShadows[0].generation);
+
+   //fragments outside the file are dropped
+   headerLen = rmf_packHeader(msgBuf, RMF_HIGH_ADDRESS_SIZE, SHADOW_FILE_ADDRESS+48, true);
+   memset(&msgBuf[headerLen], 0x55, 16);
+   apx_es_fileManager_onMsgReceived(&fileManager, msgBuf, headerLen+16);
+   headerLen = rmf_packHeader(msgBuf, RMF_HIGH_ADDRESS_SIZE, SHADOW_FILE_ADDRESS+64, false);
+   memset(&msgBuf[headerLen], 0x55, 4);
+   apx_es_fileManager_onMsgReceived(&fileManager, msgBuf, headerLen+4);
+   CuAssertPtrEquals(tc, data, node.inPortDataBuf);
+   CuAssertTrue(tc, memcmp(expected, node.inPortDataBuf, SHADOW_FILE_SIZE) == 0);
+   CuAssertUIntEquals(tc, 2, fileManager.receiveShadows[0].generation);
+   CuAssertTrue(tc, !fileManager.dropMessage);
+}
+
 static void TestHelper_resetAndConnectTransmitHandler(apx_es_fileManager_t* fileManager)
 {
    memset(&m_transmitHandler, 0, sizeof(m_transmitHandler));
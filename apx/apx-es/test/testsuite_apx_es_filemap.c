@@ -19,6 +19,10 @@
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void apx_es_filemap_insert(CuTest* tc);
+static void apx_es_filemap_autoInsertKeepsOrder(CuTest* tc);
+static void apx_es_filemap_findByAddress(CuTest* tc);
+static void apx_es_filemap_findByName(CuTest* tc);
+static void apx_es_filemap_staticTable(CuTest* tc);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -39,6 +43,10 @@ CuSuite* testsuite_apx_es_filemap(void)
    CuSuite* suite = CuSuiteNew();
 
    SUITE_ADD_TEST(suite, apx_es_filemap_insert);
+   SUITE_ADD_TEST(suite, apx_es_filemap_autoInsertKeepsOrder);
+   SUITE_ADD_TEST(suite, apx_es_filemap_findByAddress);
+   SUITE_ADD_TEST(suite, apx_es_filemap_findByName);
+   SUITE_ADD_TEST(suite, apx_es_filemap_staticTable);
 
    return suite;
 }
@@ -72,4 +80,118 @@ static void apx_es_filemap_insert(CuTest* tc)
    CuAssertPtrEquals(tc, &file2, localMap.fileList[1]);
 }
 
+static void apx_es_filemap_autoInsertKeepsOrder(CuTest* tc)
+{
+   apx_es_fileMap_t localMap;
+   apx_file_t outFile1;
+   apx_file_t outFile2;
+   apx_file_t definitionFile;
+   memset(&outFile1,0,sizeof(apx_file_t));
+   memset(&outFile2,0,sizeof(apx_file_t));
+   memset(&definitionFile,0,sizeof(apx_file_t));
+   outFile1.fileType = APX_OUTDATA_FILE;
+   outFile1.fileInfo.length = 1500;
+   outFile2.fileType = APX_OUTDATA_FILE;
+   outFile2.fileInfo.length = 10;
+   definitionFile.fileType = APX_DEFINITION_FILE;
+   definitionFile.fileInfo.length = 300;
+   apx_es_fileMap_create(&localMap);
+   CuAssertIntEquals(tc, 0, apx_es_fileMap_autoInsert(&localMap, &definitionFile));
+   CuAssertIntEquals(tc, 0, apx_es_fileMap_autoInsert(&localMap, &outFile1));
+   CuAssertIntEquals(tc, 0, apx_es_fileMap_autoInsert(&localMap, &outFile2));
+   CuAssertIntEquals(tc, 3, apx_es_fileMap_length(&localMap));
+   CuAssertUIntEquals(tc, 0x4000000, definitionFile.fileInfo.address);
+   CuAssertUIntEquals(tc, 0, outFile1.fileInfo.address);
+   CuAssertUIntEquals(tc, 0x800, outFile2.fileInfo.address);
+   CuAssertPtrEquals(tc, &outFile1, apx_es_fileMap_get(&localMap, 0));
+   CuAssertPtrEquals(tc, &outFile2, apx_es_fileMap_get(&localMap, 1));
+   CuAssertPtrEquals(tc, &definitionFile, apx_es_fileMap_get(&localMap, 2));
+}
+
+static void apx_es_filemap_findByAddress(CuTest* tc)
+{
+   apx_es_fileMap_t remoteMap;
+   apx_file_t files[APX_ES_FILEMAP_MAX_NUM_FILES];
+   int32_t i;
+   apx_es_fileMap_create(&remoteMap);
+   for (i=APX_ES_FILEMAP_MAX_NUM_FILES-1; i>=0; i--)
+   {
+      memset(&files[i],0,sizeof(apx_file_t));
+      files[i].fileInfo.address = (uint32_t) i*0x400u;
+      files[i].fileInfo.length = 100;
+      CuAssertIntEquals(tc, 0, apx_es_fileMap_insert(&remoteMap, &files[i]));
+   }
+   CuAssertIntEquals(tc, -1, apx_es_fileMap_insert(&remoteMap, &files[0]));
+   for (i=0; i<APX_ES_FILEMAP_MAX_NUM_FILES; i++)
+   {
+      uint32_t address = (uint32_t) i*0x400u;
+      CuAssertPtrEquals(tc, &files[i], apx_es_fileMap_get(&remoteMap, i));
+      CuAssertPtrEquals(tc, &files[i], apx_es_fileMap_findByAddress(&remoteMap, address));
+      CuAssertIntEquals(tc, i, remoteMap.lastIndex);
+      CuAssertPtrEquals(tc, &files[i], apx_es_fileMap_findByAddress(&remoteMap, address+99));
+      CuAssertPtrEquals(tc, 0, apx_es_fileMap_findByAddress(&remoteMap, address+100));
+      CuAssertIntEquals(tc, i, remoteMap.lastIndex);
+   }
+   CuAssertPtrEquals(tc, 0, apx_es_fileMap_findByAddress(&remoteMap, 0xFFFFFFFF));
+   CuAssertIntEquals(tc, 0, apx_es_fileMap_remove(&remoteMap, &files[0]));
+   CuAssertPtrEquals(tc, 0, apx_es_fileMap_findByAddress(&remoteMap, 0));
+   CuAssertPtrEquals(tc, &files[1], apx_es_fileMap_findByAddress(&remoteMap, 0x400));
+}
+
+static void apx_es_filemap_findByName(CuTest* tc)
+{
+   apx_es_fileMap_t remoteMap;
+   apx_file_t file1;
+   apx_file_t file2;
+   memset(&file1,0,sizeof(apx_file_t));
+   memset(&file2,0,sizeof(apx_file_t));
+   strcpy(file1.fileInfo.name, "TestNode.out");
+   file1.fileInfo.address=0;
+   file1.fileInfo.length=10;
+   strcpy(file2.fileInfo.name, "TestNode.in");
+   file2.fileInfo.address=0x400;
+   file2.fileInfo.length=10;
+   apx_es_fileMap_create(&remoteMap);
+   apx_es_fileMap_insert(&remoteMap, &file1);
+   apx_es_fileMap_insert(&remoteMap, &file2);
+   CuAssertPtrEquals(tc, &file2, apx_es_fileMap_findByName(&remoteMap, "TestNode.in"));
+   CuAssertPtrEquals(tc, &file1, apx_es_fileMap_findByName(&remoteMap, "TestNode.out"));
+   CuAssertPtrEquals(tc, 0, apx_es_fileMap_findByName(&remoteMap, "TestNode.apx"));
+}
 
+static void apx_es_filemap_staticTable(CuTest* tc)
+{
+   apx_es_fileMap_t localMap;
+   apx_file_t outFile;
+   apx_file_t definitionFile;
+   apx_file_t otherFile;
+   apx_file_t * const fileTable[2] = {&outFile, &definitionFile};
+   apx_file_t * const unsortedTable[2] = {&definitionFile, &outFile};
+   memset(&outFile,0,sizeof(apx_file_t));
+   memset(&definitionFile,0,sizeof(apx_file_t));
+   memset(&otherFile,0,sizeof(apx_file_t));
+   outFile.fileType = APX_OUTDATA_FILE;
+   outFile.fileInfo.address = 0;
+   outFile.fileInfo.length = 8;
+   definitionFile.fileType = APX_DEFINITION_FILE;
+   definitionFile.fileInfo.address = 0x4000000;
+   definitionFile.fileInfo.length = 200;
+   otherFile.fileType = APX_OUTDATA_FILE;
+   otherFile.fileInfo.length = 8;
+
+   CuAssertIntEquals(tc, -1, apx_es_fileMap_createStatic(&localMap, unsortedTable, 2));
+   CuAssertIntEquals(tc, 0, apx_es_fileMap_createStatic(&localMap, fileTable, 2));
+   CuAssertIntEquals(tc, 2, apx_es_fileMap_length(&localMap));
+   CuAssertPtrEquals(tc, &definitionFile, apx_es_fileMap_get(&localMap, 1));
+   CuAssertPtrEquals(tc, &outFile, apx_es_fileMap_findByAddress(&localMap, 7));
+   CuAssertPtrEquals(tc, &definitionFile, apx_es_fileMap_findByAddress(&localMap, 0x4000000+199));
+   CuAssertPtrEquals(tc, 0, apx_es_fileMap_findByAddress(&localMap, 8));
+   //files in the table keep their precomputed addresses, other files cannot be added
+   CuAssertIntEquals(tc, 0, apx_es_fileMap_autoInsert(&localMap, &definitionFile));
+   CuAssertUIntEquals(tc, 0x4000000, definitionFile.fileInfo.address);
+   CuAssertIntEquals(tc, -1, apx_es_fileMap_autoInsert(&localMap, &otherFile));
+   CuAssertIntEquals(tc, -1, apx_es_fileMap_insert(&localMap, &otherFile));
+   CuAssertIntEquals(tc, -1, apx_es_fileMap_remove(&localMap, &outFile));
+   apx_es_fileMap_clear(&localMap);
+   CuAssertIntEquals(tc, 2, apx_es_fileMap_length(&localMap));
+}
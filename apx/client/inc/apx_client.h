@@ -17,6 +17,7 @@ typedef struct apx_client_tag
 {
    apx_clientConnection_t *connection;
    apx_nodeManager_t nodeManager;
+   apx_capture_t *capture; //weak pointer, 0 when traffic capture is disabled
 }apx_client_t;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -35,5 +36,6 @@ void apx_client_vdelete(void *arg);
 
 int8_t apx_client_connect_tcp(apx_client_t *self, const char *address, uint16_t port);
 void apx_client_attachLocalNode(apx_client_t *self, apx_nodeData_t *nodeData);
+void apx_client_setCapture(apx_client_t *self, apx_capture_t *capture);
 
 #endif //APX_CLIENT_H
@@ -9,6 +9,7 @@
 #include "adt_bytearray.h"
 #include "apx_fileManager.h"
 #include "apx_nodeManager.h"
+#include "apx_capture.h"
 #include "msocket.h"
 
 //////////////////////////////////////////////////////////////////////////////
@@ -28,6 +29,8 @@ typedef struct apx_clientConnection_tag
    adt_bytearray_t sendBuffer;
    uint8_t maxMsgHeaderSize;
    struct apx_client_tag *client;
+   apx_capture_t *capture; //weak pointer, 0 when traffic capture is disabled
+   uint32_t captureId;
 }apx_clientConnection_t;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -44,6 +47,7 @@ apx_clientConnection_t *apx_clientConnection_new(msocket_t *msocket, struct apx_
 void apx_clientConnection_delete(apx_clientConnection_t *self);
 void apx_clientConnection_vdelete(void *arg);
 void apx_clientConnection_start(apx_clientConnection_t *self);
+void apx_clientConnection_setCapture(apx_clientConnection_t *self, apx_capture_t *capture);
 int8_t apx_clientConnection_dataReceived(apx_clientConnection_t *self, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen);
 
 
@@ -17,13 +17,30 @@
 #include <semaphore.h>
 #endif
 #include "osmacro.h"
-#include "apx_clientConnection.h"
+#include "ringbuf.h"
 #include "apx_sessionCmd.h"
 
 
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#ifndef APX_CLIENT_SESSION_MAX_MESSAGES
+#define APX_CLIENT_SESSION_MAX_MESSAGES 64 //must be a power of two
+#endif
+
+#ifndef APX_CLIENT_SESSION_MAX_PENDING
+#define APX_CLIENT_SESSION_MAX_PENDING 32 //maximum number of commands in flight
+#endif
+
+#define APX_CLIENT_SESSION_NO_TIMEOUT     0u
+#define APX_CLIENT_SESSION_INVALID_ID     0u //never used as requestId
+
+/**
+ * Called from the session worker thread when a command finishes.
+ * result is APX_NO_ERROR or an APX error code (see apx_error.h).
+ * data is the response payload given to apx_clientSession_onResponse, it is only valid during the call.
+ */
+typedef void (*apx_sessionCallback_t)(void *arg, uint32_t requestId, int32_t result, void *data);
 
 typedef struct apx_clientSessionHandler_tag
 {
@@ -32,35 +49,81 @@ typedef struct apx_clientSessionHandler_tag
    void (*error)(void *arg, const apx_cmd_t *cmd, int32_t errorCode);
 } apx_clientSessionHandler_t;
 
+/**
+ * Puts commands on the wire. request is called from the session worker thread and must not wait for the response,
+ * the connection reports it later through apx_clientSession_onResponse.
+ * It returns APX_NO_ERROR or an error code that fails the command immediately.
+ */
+typedef struct apx_clientSessionTransport_tag
+{
+   void *arg;
+   int32_t (*request)(void *arg, uint32_t requestId, const apx_cmd_t *cmd);
+} apx_clientSessionTransport_t;
+
+/**
+ * Blocking alternative to a callback. Pass apx_sessionFuture_callback and the future as callback argument.
+ */
+typedef struct apx_sessionFuture_tag
+{
+   SEMAPHORE_T semaphore;
+   uint32_t requestId;
+   int32_t result;
+} apx_sessionFuture_t;
+
+typedef struct apx_clientSessionMsg_tag
+{
+   uint8_t msgType;
+   uint32_t requestId;
+   int32_t result; //command result, or userCode of APX_CMD_COMPLETE
+   uint32_t timeoutMs;
+   apx_cmd_t cmd; //command to send, or the response payload
+   apx_sessionCallback_t callback;
+   void *callbackArg;
+} apx_clientSessionMsg_t;
+
+typedef struct apx_clientSessionRequest_tag
+{
+   uint32_t requestId;
+   apx_cmd_t cmd;
+   uint64_t deadlineMs; //0 when the command has no timeout
+   bool isSent; //false while the command waits for the connection
+   apx_sessionCallback_t callback;
+   void *callbackArg;
+   int32_t userCode; //APX_CMD_COMPLETE only
+} apx_clientSessionRequest_t;
 
 /**
  * APX clientSession - A class used for clients to programmatically control a connection to an APX server
+ *
+ * Commands are queued to a worker thread which sleeps until a command or a connection event arrives, or until the
+ * nearest command timeout expires. Commands are sent as soon as they arrive without waiting for earlier responses.
  */
 typedef struct apx_clientSession_tag
 {
    THREAD_T workerThread; //local worker thread
-   SPINLOCK_T lock;  //variable lock
-   SEMAPHORE_T semaphore; //thread semaphore
+   SPINLOCK_T lock;  //protects handler, transport, nextRequestId and isStopRequested
+   SEMAPHORE_T semaphore; //posted once for every message inserted into messages and once by apx_clientSession_stop
 
-   rbfs_t messages; //pending messages (ringbuffer)
+   rbf32_t messages; //pending messages (ringbuffer)
    size_t ringbufferLen;
    uint8_t *ringbufferData;
-   bool isRunning; //when false it's time to shut down
    bool workerThreadValid; //true if workerThread is a valid variable
+   bool isStopRequested; //checked by the worker thread after every wakeup
 
-   apx_cmd_t nextCmd;
-   apx_cmd_t currentCmd;
+   uint32_t nextRequestId;
+   //the following members are only accessed by the worker thread while it runs
+   apx_clientSessionRequest_t pending[APX_CLIENT_SESSION_MAX_PENDING]; //in the order the commands were issued
+   uint32_t numPending;
+   bool isConnected;
 
-   apx_clientConnection_t *clientConnection;
    apx_clientSessionHandler_t handler;
+   apx_clientSessionTransport_t transport;
 #ifdef _WIN32
    unsigned int threadId;
 #endif
 } apx_clientSession_t;
 
-
-#define APX_CLIENT_SESSION_MAX_MESSAGES 10
-#define APX_CLIENT_SESSION_MESSAGE_SIZE sizeof(apx_cmd_t)
+#define APX_CLIENT_SESSION_MESSAGE_SIZE sizeof(apx_clientSessionMsg_t)
 
 //////////////////////////////////////////////////////////////////////////////
 // FUNCTION PROTOTYPES
@@ -73,10 +136,27 @@ void apx_clientSession_vdelete(void *arg);
 void apx_clientSession_start(apx_clientSession_t *self);
 void apx_clientSession_stop(apx_clientSession_t *self);
 void apx_clientSession_setSessionHandler(apx_clientSession_t *self, apx_clientSessionHandler_t *sessionHandler);
-void apx_clientSession_connectCmd(apx_clientSession_t *self);
-void apx_clientSession_disconnectCmd(apx_clientSession_t *self);
-void apx_clientSession_completedCmd(apx_clientSession_t *self, int32_t userCode);
-void apx_clientSession_pingNodeByNameCmd(apx_clientSession_t *self, const char *nodeName);
+void apx_clientSession_setTransport(apx_clientSession_t *self, apx_clientSessionTransport_t *transport);
+
+//commands, each returns the requestId or APX_CLIENT_SESSION_INVALID_ID (with errno set) when it could not be queued
+uint32_t apx_clientSession_connectTcpCmd(apx_clientSession_t *self, const char *tcp_hostname, uint16_t tcp_port, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+uint32_t apx_clientSession_connectLocalCmd(apx_clientSession_t *self, const char *lsock_path, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+uint32_t apx_clientSession_disconnectCmd(apx_clientSession_t *self, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+uint32_t apx_clientSession_completedCmd(apx_clientSession_t *self, int32_t userCode);
+uint32_t apx_clientSession_listNodesCmd(apx_clientSession_t *self, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+uint32_t apx_clientSession_openNodeCmd(apx_clientSession_t *self, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+uint32_t apx_clientSession_closeNodeCmd(apx_clientSession_t *self, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+uint32_t apx_clientSession_pingNodeByNameCmd(apx_clientSession_t *self, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+
+//connection events, may be called from any thread
+void apx_clientSession_onResponse(apx_clientSession_t *self, uint32_t requestId, int32_t result, void *data, void (*dataDestructor)(void*));
+void apx_clientSession_onConnected(apx_clientSession_t *self);
+void apx_clientSession_onDisconnected(apx_clientSession_t *self);
+
+int8_t apx_sessionFuture_create(apx_sessionFuture_t *self);
+void apx_sessionFuture_destroy(apx_sessionFuture_t *self);
+int32_t apx_sessionFuture_wait(apx_sessionFuture_t *self, uint32_t timeoutMs);
+void apx_sessionFuture_callback(void *arg, uint32_t requestId, int32_t result, void *data);
 
 
 #endif //APX_CLIENT_SESSION_H
@@ -42,6 +42,7 @@ int8_t apx_client_create(apx_client_t *self)
    if( self != 0 )
    {
       self->connection = 0;
+      self->capture = (apx_capture_t*) 0;
       apx_nodeManager_create(&self->nodeManager);
    }
    errno=EINVAL;
@@ -100,6 +101,10 @@ int8_t apx_client_connect_tcp(apx_client_t *self, const char *address, uint16_t
       msocket_handler_t handlerTable;
       self->connection = apx_clientConnection_new(msocket,self);
       assert(self->connection != 0);
+      if (self->capture != 0)
+      {
+         apx_clientConnection_setCapture(self->connection, self->capture);
+      }
       memset(&handlerTable,0,sizeof(handlerTable));
       handlerTable.tcp_connected=tcp_client_connected;
       handlerTable.tcp_data=tcp_client_data;
@@ -129,6 +134,17 @@ void apx_client_attachLocalNode(apx_client_t *self, apx_nodeData_t *nodeData)
    }
 }
 
+/**
+ * captures all traffic of connections created after this call into capture (see apx_capture.h)
+ */
+void apx_client_setCapture(apx_client_t *self, apx_capture_t *capture)
+{
+   if (self != 0)
+   {
+      self->capture = capture;
+   }
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
@@ -50,6 +50,8 @@ int8_t apx_clientConnection_create(apx_clientConnection_t *self, msocket_t *msoc
       self->isAcknowledgeSeen = false;
       self->client = client;
       self->maxMsgHeaderSize = (uint8_t) sizeof(uint32_t);
+      self->capture = (apx_capture_t*) 0;
+      self->captureId = 0u;
       apx_fileManager_create(&self->fileManager, APX_FILEMANAGER_CLIENT_MODE);
       adt_bytearray_create(&self->sendBuffer, SEND_BUFFER_GROW_SIZE);
       return 0;
@@ -163,6 +165,18 @@ int8_t apx_clientConnection_dataReceived(apx_clientConnection_t *self, const uin
    return -1;
 }
 
+/**
+ * enables capture of all frames received and sent on this connection. Must be called before the connection is started.
+ */
+void apx_clientConnection_setCapture(apx_clientConnection_t *self, apx_capture_t *capture)
+{
+   if (self != 0)
+   {
+      self->capture = capture;
+      self->captureId = apx_capture_newConnectionId(capture);
+   }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
@@ -211,7 +225,11 @@ static int8_t apx_clientConnection_parseMessage(apx_clientConnection_t *self, co
          if (parseLen != 0)
          {
             *parseLen=headerLen+msgLen;
-         }         
+         }
+         if (self->capture != 0)
+         {
+            apx_capture_write(self->capture, self->captureId, APX_CAPTURE_RX, pBegin, headerLen+msgLen);
+         }
          if (self->isAcknowledgeSeen == false)
          {
             if (msgLen == 8)
@@ -311,7 +329,11 @@ static int32_t apx_clientConnection_send(void *arg, int32_t offset, int32_t msgL
          }
          //place header just before user data begin
          pBegin = sendBuffer+(self->maxMsgHeaderSize+offset-headerLen); //the part in the parenthesis is where the user data begins
-         memcpy(pBegin, header, headerLen);         
+         memcpy(pBegin, header, headerLen);
+         if (self->capture != 0)
+         {
+            apx_capture_write(self->capture, self->captureId, APX_CAPTURE_TX, pBegin, msgLen+headerLen);
+         }
          msocket_send(self->msocket, pBegin, msgLen+headerLen);
          return 0;
       }
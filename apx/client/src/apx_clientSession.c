@@ -1,10 +1,16 @@
 //////////////////////////////////////////////////////////////////////////////
 // INCLUDES
 //////////////////////////////////////////////////////////////////////////////
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE //sem_clockwait
+#endif
 #include "apx_clientSession.h"
 #include <malloc.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "apx_error.h"
 #include "apx_logging.h"
 #ifdef _MSC_VER
 #include <process.h>
@@ -13,13 +19,27 @@
 #include "CMemLeak.h"
 #endif
 
+#ifdef _MSC_VER
+#define STRDUP _strdup
+#else
+#define STRDUP strdup
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
 
-#define STATE_IDLE             0
-#define STATE_WAITING          1
+#define MSG_TYPE_COMMAND       1
+#define MSG_TYPE_RESPONSE      2
+#define MSG_TYPE_CONNECTED     3
+#define MSG_TYPE_DISCONNECTED  4
+
+//sem_clockwait waits against CLOCK_MONOTONIC, sem_timedwait only accepts CLOCK_REALTIME deadlines
+#if defined(__GLIBC__) && ( (__GLIBC__ > 2) || ( (__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 30) ) )
+#define APX_CLIENT_SESSION_SEM_CLOCKWAIT 1
+#else
+#define APX_CLIENT_SESSION_SEM_CLOCKWAIT 0
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
@@ -27,9 +47,24 @@
 static void apx_clientSession_startThread(apx_clientSession_t *self);
 static void apx_clientSession_stopThread(apx_clientSession_t *self);
 static THREAD_PROTO(threadTask,arg);
-static int8_t apx_clientSession_getNextCmd(apx_clientSession_t *self);
-static bool apx_clientSession_startNextCmd(apx_clientSession_t *self);
-static bool apx_clientSession_abortCurrentCmd(apx_clientSession_t *self);
+static uint32_t apx_clientSession_issueCmd(apx_clientSession_t *self, int32_t cmdType, void *cmdAny, void (*cmdDestructor)(void*), uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+static uint32_t apx_clientSession_issueNodeCmd(apx_clientSession_t *self, int32_t cmdType, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg);
+static uint32_t apx_clientSession_queueCmd(apx_clientSession_t *self, apx_clientSessionMsg_t *msg);
+static void apx_clientSession_postEvent(apx_clientSession_t *self, apx_clientSessionMsg_t *msg);
+static void apx_clientSession_processMessage(apx_clientSession_t *self);
+static void apx_clientSession_startCmd(apx_clientSession_t *self, apx_clientSessionMsg_t *msg);
+static bool apx_clientSession_sendCmd(apx_clientSession_t *self, uint32_t index);
+static void apx_clientSession_sendDeferredCmds(apx_clientSession_t *self);
+static void apx_clientSession_finishCmd(apx_clientSession_t *self, uint32_t index, int32_t result, void *data);
+static void apx_clientSession_completeRequest(apx_clientSession_t *self, apx_clientSessionRequest_t *request, int32_t result, void *data);
+static void apx_clientSession_failExpiredCmds(apx_clientSession_t *self, uint64_t nowMs);
+static void apx_clientSession_failAllCmds(apx_clientSession_t *self, int32_t errorCode);
+static void apx_clientSession_failQueuedCmds(apx_clientSession_t *self, int32_t errorCode);
+static void apx_clientSession_runBarriers(apx_clientSession_t *self);
+static void apx_clientSession_notifyCompleted(apx_clientSession_t *self, int32_t userCode);
+static uint32_t apx_clientSession_calcWaitTime(const apx_clientSession_t *self, uint64_t nowMs);
+static uint64_t apx_clientSession_getTimeMs(void);
+static int8_t apx_clientSession_waitSemaphore(SEMAPHORE_T *semaphore, uint32_t timeoutMs);
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL VARIABLES
@@ -41,23 +76,31 @@ static bool apx_clientSession_abortCurrentCmd(apx_clientSession_t *self);
 //////////////////////////////////////////////////////////////////////////////
 int8_t apx_clientSession_create(apx_clientSession_t *self, apx_clientSessionHandler_t *sessionHandler)
 {
+   if (self == 0)
+   {
+      return -1;
+   }
 #ifdef _MSC_VER
    self->workerThread = INVALID_HANDLE_VALUE;
 #else
    self->workerThread = 0;
 #endif
    self->workerThreadValid=false;
-   SPINLOCK_INIT(self->lock);
-   SEMAPHORE_CREATE(self->semaphore);
+   self->isStopRequested=false;
    self->ringbufferLen = APX_CLIENT_SESSION_MAX_MESSAGES;
    self->ringbufferData = (uint8_t*) malloc(APX_CLIENT_SESSION_MAX_MESSAGES*APX_CLIENT_SESSION_MESSAGE_SIZE);
    if (self->ringbufferData == 0)
    {
+      errno = ENOMEM;
       return -1;
    }
-   rbfs_create(&self->messages, self->ringbufferData,(uint16_t) APX_CLIENT_SESSION_MAX_MESSAGES,(uint8_t) APX_CLIENT_SESSION_MESSAGE_SIZE);
-   apx_cmd_create(&self->nextCmd);
-   apx_cmd_create(&self->currentCmd);
+   SPINLOCK_INIT(self->lock);
+   SEMAPHORE_CREATE(self->semaphore);
+   rbf32_create(&self->messages, self->ringbufferData, APX_CLIENT_SESSION_MAX_MESSAGES, (uint32_t) APX_CLIENT_SESSION_MESSAGE_SIZE);
+   self->nextRequestId = 1u;
+   self->numPending = 0u;
+   self->isConnected = false;
+   memset(&self->transport, 0, sizeof(apx_clientSessionTransport_t));
    apx_clientSession_setSessionHandler(self, sessionHandler);
    return 0;
 }
@@ -66,14 +109,16 @@ void apx_clientSession_destroy(apx_clientSession_t *self)
 {
    if (self != 0)
    {
+      apx_clientSession_stop(self);
+      //commands issued after the worker thread stopped (or while it never ran) still get their callbacks
+      apx_clientSession_failAllCmds(self, APX_NOT_CONNECTED_ERROR);
+      apx_clientSession_failQueuedCmds(self, APX_NOT_CONNECTED_ERROR);
       if (self->ringbufferData != 0)
       {
          free(self->ringbufferData);
       }
       SEMAPHORE_DESTROY(self->semaphore);
       SPINLOCK_DESTROY(self->lock);
-      apx_cmd_destroy(&self->nextCmd);
-      apx_cmd_create(&self->currentCmd);
    }
 }
 
@@ -82,7 +127,11 @@ apx_clientSession_t* apx_clientSession_new(apx_clientSessionHandler_t *sessionHa
    apx_clientSession_t *self = (apx_clientSession_t*) malloc(sizeof(apx_clientSession_t));
    if(self != 0)
    {
-      apx_clientSession_create(self, sessionHandler);
+      if (apx_clientSession_create(self, sessionHandler) != 0)
+      {
+         free(self);
+         self = 0;
+      }
    }
    else
    {
@@ -113,6 +162,10 @@ void apx_clientSession_start(apx_clientSession_t *self)
    }
 }
 
+/**
+ * Stops the worker thread. Commands that have not finished, including those still waiting in the message queue,
+ * are completed with APX_NOT_CONNECTED_ERROR.
+ */
 void apx_clientSession_stop(apx_clientSession_t *self)
 {
    if( (self != 0) && (self->workerThreadValid == true) )
@@ -138,27 +191,207 @@ void apx_clientSession_setSessionHandler(apx_clientSession_t *self, apx_clientSe
    }
 }
 
-void apx_clientSession_connectCmd(apx_clientSession_t *self)
+void apx_clientSession_setTransport(apx_clientSession_t *self, apx_clientSessionTransport_t *transport)
+{
+   if (self != 0)
+   {
+      SPINLOCK_ENTER(self->lock);
+      if (transport == 0)
+      {
+         memset(&self->transport, 0, sizeof(apx_clientSessionTransport_t));
+      }
+      else
+      {
+         memcpy(&self->transport, transport, sizeof(apx_clientSessionTransport_t));
+      }
+      SPINLOCK_LEAVE(self->lock);
+   }
+}
+
+uint32_t apx_clientSession_connectTcpCmd(apx_clientSession_t *self, const char *tcp_hostname, uint16_t tcp_port, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
+{
+   apx_connectCmd_t *connectCmd;
+   if ( (self == 0) || (tcp_hostname == 0) )
+   {
+      errno = EINVAL;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   connectCmd = apx_connectCmd_newTcpSock(tcp_hostname, tcp_port);
+   if ( (connectCmd == 0) || (connectCmd->hostname_or_path == 0) )
+   {
+      apx_connectCmd_delete(connectCmd);
+      errno = ENOMEM;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   return apx_clientSession_issueCmd(self, APX_CMD_CONNECT, connectCmd, apx_connectCmd_vdelete, timeoutMs, callback, arg);
+}
+
+uint32_t apx_clientSession_connectLocalCmd(apx_clientSession_t *self, const char *lsock_path, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
+{
+   apx_connectCmd_t *connectCmd;
+   if ( (self == 0) || (lsock_path == 0) )
+   {
+      errno = EINVAL;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   connectCmd = apx_connectCmd_newLocalSock(lsock_path);
+   if ( (connectCmd == 0) || (connectCmd->hostname_or_path == 0) )
+   {
+      apx_connectCmd_delete(connectCmd);
+      errno = ENOMEM;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   return apx_clientSession_issueCmd(self, APX_CMD_CONNECT, connectCmd, apx_connectCmd_vdelete, timeoutMs, callback, arg);
+}
+
+uint32_t apx_clientSession_disconnectCmd(apx_clientSession_t *self, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
+{
+   return apx_clientSession_issueCmd(self, APX_CMD_DISCONNECT, 0, 0, timeoutMs, callback, arg);
+}
+
+/**
+ * Calls handler.completed with userCode once all commands issued before this one have finished
+ */
+uint32_t apx_clientSession_completedCmd(apx_clientSession_t *self, int32_t userCode)
+{
+   if (self == 0)
+   {
+      errno = EINVAL;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   else
+   {
+      apx_clientSessionMsg_t msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msgType = MSG_TYPE_COMMAND;
+      msg.result = userCode;
+      apx_cmd_create(&msg.cmd);
+      msg.cmd.cmdType = APX_CMD_COMPLETE;
+      return apx_clientSession_queueCmd(self, &msg);
+   }
+}
+
+uint32_t apx_clientSession_listNodesCmd(apx_clientSession_t *self, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
+{
+   return apx_clientSession_issueCmd(self, APX_CMD_LIST_NODES, 0, 0, timeoutMs, callback, arg);
+}
+
+uint32_t apx_clientSession_openNodeCmd(apx_clientSession_t *self, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
 {
+   return apx_clientSession_issueNodeCmd(self, APX_CMD_OPEN_NODE, nodeName, timeoutMs, callback, arg);
+}
 
+uint32_t apx_clientSession_closeNodeCmd(apx_clientSession_t *self, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
+{
+   return apx_clientSession_issueNodeCmd(self, APX_CMD_CLOSE_NODE, nodeName, timeoutMs, callback, arg);
 }
 
-void apx_clientSession_disconnectCmd(apx_clientSession_t *self)
+uint32_t apx_clientSession_pingNodeByNameCmd(apx_clientSession_t *self, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
 {
+   return apx_clientSession_issueNodeCmd(self, APX_CMD_PING_NODE, nodeName, timeoutMs, callback, arg);
+}
 
+/**
+ * Completes the command with the given requestId. Ownership of data is transferred to the session,
+ * it is passed to the command callback and then released using dataDestructor (if set).
+ * Responses to commands that already timed out are discarded.
+ */
+void apx_clientSession_onResponse(apx_clientSession_t *self, uint32_t requestId, int32_t result, void *data, void (*dataDestructor)(void*))
+{
+   if (self != 0)
+   {
+      apx_clientSessionMsg_t msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msgType = MSG_TYPE_RESPONSE;
+      msg.requestId = requestId;
+      msg.result = result;
+      apx_cmd_create(&msg.cmd);
+      msg.cmd.cmdAny = data;
+      msg.cmd.cmdDestructor = dataDestructor;
+      apx_clientSession_postEvent(self, &msg);
+   }
 }
 
-void apx_clientSession_completedCmd(apx_clientSession_t *self, int32_t userCode)
+/**
+ * Sends all commands that were issued while the session was disconnected
+ */
+void apx_clientSession_onConnected(apx_clientSession_t *self)
 {
+   if (self != 0)
+   {
+      apx_clientSessionMsg_t msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msgType = MSG_TYPE_CONNECTED;
+      apx_cmd_create(&msg.cmd);
+      apx_clientSession_postEvent(self, &msg);
+   }
+}
 
+/**
+ * Fails all unfinished commands with APX_NOT_CONNECTED_ERROR. The transport shall report this event after a failed
+ * connect attempt as well as after a lost connection.
+ */
+void apx_clientSession_onDisconnected(apx_clientSession_t *self)
+{
+   if (self != 0)
+   {
+      apx_clientSessionMsg_t msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msgType = MSG_TYPE_DISCONNECTED;
+      apx_cmd_create(&msg.cmd);
+      apx_clientSession_postEvent(self, &msg);
+   }
 }
 
-void apx_clientSession_pingNodeByNameCmd(apx_clientSession_t *self, const char *nodeName)
+int8_t apx_sessionFuture_create(apx_sessionFuture_t *self)
 {
+   if (self != 0)
+   {
+      SEMAPHORE_CREATE(self->semaphore);
+      self->requestId = APX_CLIENT_SESSION_INVALID_ID;
+      self->result = APX_NO_ERROR;
+      return 0;
+   }
+   return -1;
+}
 
+void apx_sessionFuture_destroy(apx_sessionFuture_t *self)
+{
+   if (self != 0)
+   {
+      SEMAPHORE_DESTROY(self->semaphore);
+   }
 }
 
+/**
+ * Waits for the command to finish and returns its result. A timeoutMs of 0 waits forever.
+ * Returns APX_TIMEOUT_ERROR when timeoutMs expires first, the future must then be kept alive until the command finishes.
+ */
+int32_t apx_sessionFuture_wait(apx_sessionFuture_t *self, uint32_t timeoutMs)
+{
+   if (self != 0)
+   {
+      int8_t result = apx_clientSession_waitSemaphore(&self->semaphore, timeoutMs);
+      if (result == 0)
+      {
+         return self->result;
+      }
+      return (result > 0)? APX_TIMEOUT_ERROR : APX_UNSUPPORTED_ERROR;
+   }
+   return APX_VALUE_ERROR;
+}
 
+void apx_sessionFuture_callback(void *arg, uint32_t requestId, int32_t result, void *data)
+{
+   apx_sessionFuture_t *self = (apx_sessionFuture_t*) arg;
+   (void) data;
+   if (self != 0)
+   {
+      self->requestId = requestId;
+      self->result = result;
+      SEMAPHORE_POST(self->semaphore);
+   }
+}
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
@@ -167,6 +400,7 @@ static void apx_clientSession_startThread(apx_clientSession_t *self)
 {
    if( (self != 0) && (self->workerThreadValid == false) ){
       self->workerThreadValid = true;
+      self->isStopRequested = false;
 #ifdef _WIN32
       THREAD_CREATE(self->workerThread,threadTask,self,self->threadId);
       if(self->workerThread == INVALID_HANDLE_VALUE){
@@ -179,7 +413,7 @@ static void apx_clientSession_startThread(apx_clientSession_t *self)
          self->workerThreadValid = false;
       }
 #endif
-      //from this point forward all access to self must be protected by self->lock
+      //from this point forward pending, numPending and isConnected belong to the worker thread
    }
 }
 
@@ -190,9 +424,9 @@ void apx_clientSession_stopThread(apx_clientSession_t *self)
 #ifdef _MSC_VER
       DWORD result;
 #endif
-      apx_cmd_t msg = {RMF_MSG_EXIT,0,0}; //{msgType, msgData, msgDestructor}
+      //not a queued message, a full message queue must not prevent the worker thread from stopping
       SPINLOCK_ENTER(self->lock);
-      rbfs_insert(&self->messages,(const uint8_t*) &msg);
+      self->isStopRequested = true;
       SPINLOCK_LEAVE(self->lock);
       SEMAPHORE_POST(self->semaphore);
 #ifdef _MSC_VER
@@ -232,7 +466,7 @@ void apx_clientSession_stopThread(apx_clientSession_t *self)
 }
 
 static THREAD_PROTO(threadTask,arg)
-      {
+{
    if(arg!=0)
    {
       apx_clientSession_t *self;
@@ -241,107 +475,490 @@ static THREAD_PROTO(threadTask,arg)
 
       while(isRunning == true)
       {
-#ifdef _MSC_VER
-         DWORD result = WaitForSingleObject(self->semaphore, 0);
-         if (result == WAIT_OBJECT_0)
-#else
-         int result = sem_trywait(&self->semaphore);
-         if (result == 0)
-#endif
+         uint64_t nowMs = apx_clientSession_getTimeMs();
+         int8_t result;
+         bool isStopRequested;
+         apx_clientSession_failExpiredCmds(self, nowMs);
+         //sleeps until a message arrives, or until the nearest command deadline when commands are in flight
+         result = apx_clientSession_waitSemaphore(&self->semaphore, apx_clientSession_calcWaitTime(self, nowMs));
+         SPINLOCK_ENTER(self->lock);
+         isStopRequested = self->isStopRequested;
+         SPINLOCK_LEAVE(self->lock);
+         if (isStopRequested == true)
          {
-            int8_t i8Result = apx_clientSession_getNextCmd(self);
-            if (i8Result == 0)
-            {
-               if(self->nextCmd.cmdType == APX_CMD_EXIT)
-               {
-                  isRunning=apx_clientSession_abortCurrentCmd(self);
-                  APX_LOG_DEBUG("[APX_CLIENT_SESSION]: Exit command");
-               }
-            }
-            else
-            {
-               isRunning = false;
-               APX_LOG_ERROR("[APX_CLIENT_SESSION]: Failed to call apx_clientSession_getNextCmd");
-            }
+            APX_LOG_DEBUG("[APX_CLIENT_SESSION]: Stop requested");
+            isRunning = false;
          }
-         if (isRunning == true)
+         else if (result == 0)
          {
-            if (self->currentCmd.cmdType == APX_CMD_NONE)
-            {
-               APX_LOG_DEBUG("[APX_CLIENT_SESSION]: Idle");
-               if (self->nextCmd.cmdType != APX_CMD_NONE)
-               {
-                  isRunning = apx_clientSession_startNextCmd(self);
-               }
-            }
-            else
-            {
-               APX_LOG_DEBUG("[APX_CLIENT_SESSION]: Waiting for command to finish");
-            }
-            SLEEP(100);
+            apx_clientSession_processMessage(self);
+         }
+         else if (result < 0)
+         {
+            APX_LOG_ERROR("[APX_CLIENT_SESSION] failure while waiting for semaphore");
+            isRunning = false;
          }
       }
+      apx_clientSession_failAllCmds(self, APX_NOT_CONNECTED_ERROR);
+      apx_clientSession_failQueuedCmds(self, APX_NOT_CONNECTED_ERROR);
    }
    THREAD_RETURN(0);
 }
 
+/**
+ * Takes ownership of cmdAny
+ */
+static uint32_t apx_clientSession_issueCmd(apx_clientSession_t *self, int32_t cmdType, void *cmdAny, void (*cmdDestructor)(void*), uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
+{
+   apx_clientSessionMsg_t msg;
+   memset(&msg, 0, sizeof(msg));
+   msg.msgType = MSG_TYPE_COMMAND;
+   msg.timeoutMs = timeoutMs;
+   msg.cmd.cmdType = cmdType;
+   msg.cmd.cmdAny = cmdAny;
+   msg.cmd.cmdDestructor = cmdDestructor;
+   msg.callback = callback;
+   msg.callbackArg = arg;
+   if (self == 0)
+   {
+      apx_cmd_destroy(&msg.cmd);
+      errno = EINVAL;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   return apx_clientSession_queueCmd(self, &msg);
+}
 
+/**
+ * Allocates the requestId and queues the command to the worker thread
+ */
+static uint32_t apx_clientSession_queueCmd(apx_clientSession_t *self, apx_clientSessionMsg_t *msg)
+{
+   uint32_t requestId = APX_CLIENT_SESSION_INVALID_ID;
+   uint8_t result;
+   //requestIds are allocated in the same order as the commands enter the queue
+   SPINLOCK_ENTER(self->lock);
+   msg->requestId = self->nextRequestId;
+#if(RBF32_ATOMIC_ENABLE)
+   result = rbf32_mpsc_insert(&self->messages, (const uint8_t*) msg);
+#else
+   result = rbf32_insert(&self->messages, (const uint8_t*) msg);
+#endif
+   if (result == E_BUF_OK)
+   {
+      requestId = msg->requestId;
+      self->nextRequestId++;
+      if (self->nextRequestId == APX_CLIENT_SESSION_INVALID_ID)
+      {
+         self->nextRequestId = 1u;
+      }
+   }
+   SPINLOCK_LEAVE(self->lock);
+   if (requestId != APX_CLIENT_SESSION_INVALID_ID)
+   {
+      SEMAPHORE_POST(self->semaphore);
+   }
+   else
+   {
+      apx_cmd_destroy(&msg->cmd);
+      errno = ENOBUFS;
+   }
+   return requestId;
+}
 
+static uint32_t apx_clientSession_issueNodeCmd(apx_clientSession_t *self, int32_t cmdType, const char *nodeName, uint32_t timeoutMs, apx_sessionCallback_t callback, void *arg)
+{
+   char *name;
+   if ( (self == 0) || (nodeName == 0) )
+   {
+      errno = EINVAL;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   name = STRDUP(nodeName);
+   if (name == 0)
+   {
+      errno = ENOMEM;
+      return APX_CLIENT_SESSION_INVALID_ID;
+   }
+   return apx_clientSession_issueCmd(self, cmdType, name, free, timeoutMs, callback, arg);
+}
 
+static void apx_clientSession_postEvent(apx_clientSession_t *self, apx_clientSessionMsg_t *msg)
+{
+   uint8_t result;
+#if(RBF32_ATOMIC_ENABLE)
+   result = rbf32_mpsc_insert(&self->messages, (const uint8_t*) msg);
+#else
+   SPINLOCK_ENTER(self->lock);
+   result = rbf32_insert(&self->messages, (const uint8_t*) msg);
+   SPINLOCK_LEAVE(self->lock);
+#endif
+   if (result == E_BUF_OK)
+   {
+      SEMAPHORE_POST(self->semaphore);
+   }
+   else
+   {
+      APX_LOG_ERROR("[APX_CLIENT_SESSION] message queue full, dropped message of type %d", (int) msg->msgType);
+      apx_cmd_destroy(&msg->cmd);
+   }
+}
 
 /**
- * returns -1 on error, 0 success
+ * processes one message from the queue
  */
-static int8_t apx_clientSession_getNextCmd(apx_clientSession_t *self)
+static void apx_clientSession_processMessage(apx_clientSession_t *self)
 {
-   if (self != 0)
+   apx_clientSessionMsg_t msg;
+   uint32_t i;
+   if (rbf32_remove(&self->messages, (uint8_t*) &msg) != E_BUF_OK)
+   {
+      //left over from a previous stop, either its own post or posts of messages that were failed without processing
+      return;
+   }
+   switch(msg.msgType)
    {
-      int8_t retval = 0;
+   case MSG_TYPE_COMMAND:
+      apx_clientSession_startCmd(self, &msg);
+      break;
+   case MSG_TYPE_RESPONSE:
+      for (i = 0; i < self->numPending; i++)
       {
-         uint8_t result;
-         SPINLOCK_ENTER(self->lock);
-         result = rbfs_remove(&self->messages,(uint8_t*) &self->nextCmd);
-         SPINLOCK_LEAVE(self->lock);
-         if (result != 0)
+         if ( (self->pending[i].requestId == msg.requestId) && (self->pending[i].isSent == true) )
          {
-            retval = -1;
+            apx_clientSession_finishCmd(self, i, msg.result, msg.cmd.cmdAny);
+            break;
          }
       }
-      return retval;
+      if (i == self->numPending)
+      {
+         APX_LOG_DEBUG("[APX_CLIENT_SESSION]: Discarded response to request %u", (unsigned int) msg.requestId);
+      }
+      apx_cmd_destroy(&msg.cmd);
+      break;
+   case MSG_TYPE_CONNECTED:
+      self->isConnected = true;
+      apx_clientSession_sendDeferredCmds(self);
+      break;
+   case MSG_TYPE_DISCONNECTED:
+      self->isConnected = false;
+      apx_clientSession_failAllCmds(self, APX_NOT_CONNECTED_ERROR);
+      break;
+   default:
+      APX_LOG_ERROR("[APX_CLIENT_SESSION]: Unknown message type: %d", (int) msg.msgType);
+      apx_cmd_destroy(&msg.cmd);
    }
-   return -1;
+   apx_clientSession_runBarriers(self);
 }
 
 /**
- * returns true if the processing thread should continue or false if it should abort
+ * Adds the command to the pending table. It is sent right away unless it requires a connection that is not yet
+ * established, earlier commands are not waited for.
  */
-static bool apx_clientSession_startNextCmd(apx_clientSession_t *self)
+static void apx_clientSession_startCmd(apx_clientSession_t *self, apx_clientSessionMsg_t *msg)
 {
-   if(self != 0)
+   apx_clientSessionRequest_t *request;
+   if (self->numPending == APX_CLIENT_SESSION_MAX_PENDING)
    {
-      bool retval = true;
-      apx_cmd_destroy(&self->currentCmd);
-      self->currentCmd = self->nextCmd;
-      switch(self->currentCmd.cmdType)
+      apx_clientSessionRequest_t rejected;
+      memset(&rejected, 0, sizeof(rejected));
+      rejected.requestId = msg->requestId;
+      rejected.cmd = msg->cmd;
+      rejected.callback = msg->callback;
+      rejected.callbackArg = msg->callbackArg;
+      apx_clientSession_completeRequest(self, &rejected, APX_QUEUE_FULL_ERROR, 0);
+      return;
+   }
+   request = &self->pending[self->numPending++];
+   request->requestId = msg->requestId;
+   request->cmd = msg->cmd;
+   request->deadlineMs = (msg->timeoutMs == APX_CLIENT_SESSION_NO_TIMEOUT)? 0u : apx_clientSession_getTimeMs() + msg->timeoutMs;
+   request->isSent = false;
+   request->callback = msg->callback;
+   request->callbackArg = msg->callbackArg;
+   request->userCode = msg->result;
+   switch(request->cmd.cmdType)
+   {
+   case APX_CMD_COMPLETE:
+      request->isSent = true; //finished by apx_clientSession_runBarriers
+      break;
+   case APX_CMD_CONNECT:
+   case APX_CMD_DISCONNECT:
+      (void) apx_clientSession_sendCmd(self, self->numPending-1);
+      break;
+   default:
+      if (self->isConnected == true)
       {
-      case APX_CMD_CONNECT:
-         APX_LOG_DEBUG("[APX_CLIENT_SESSION]: APX_CMD_CONNECT");
-         break;
-      default:
-         APX_LOG_ERROR("[APX_CLIENT_SESSION]: Unknown command type: %d", self->currentCmd.cmdType);
+         (void) apx_clientSession_sendCmd(self, self->numPending-1);
       }
-      return retval;
    }
-   return false;
 }
 
-static bool apx_clientSession_abortCurrentCmd(apx_clientSession_t *self)
+/**
+ * returns false if the command failed immediately and has been removed from the pending table
+ */
+static bool apx_clientSession_sendCmd(apx_clientSession_t *self, uint32_t index)
+{
+   apx_clientSessionTransport_t transport;
+   int32_t result = APX_NOT_CONNECTED_ERROR;
+   SPINLOCK_ENTER(self->lock);
+   transport = self->transport;
+   SPINLOCK_LEAVE(self->lock);
+   self->pending[index].isSent = true;
+   if (transport.request != 0)
+   {
+      result = transport.request(transport.arg, self->pending[index].requestId, &self->pending[index].cmd);
+   }
+   if (result != APX_NO_ERROR)
+   {
+      apx_clientSession_finishCmd(self, index, result, 0);
+      return false;
+   }
+   return true;
+}
+
+static void apx_clientSession_sendDeferredCmds(apx_clientSession_t *self)
 {
-   if(self != 0)
+   uint32_t i = 0u;
+   while (i < self->numPending)
+   {
+      if ( (self->pending[i].isSent == true) || (apx_clientSession_sendCmd(self, i) == true) )
+      {
+         i++;
+      }
+   }
+}
+
+/**
+ * Removes pending[index] and reports its result
+ */
+static void apx_clientSession_finishCmd(apx_clientSession_t *self, uint32_t index, int32_t result, void *data)
+{
+   apx_clientSessionRequest_t request = self->pending[index];
+   self->numPending--;
+   memmove(&self->pending[index], &self->pending[index+1], (self->numPending-index)*sizeof(apx_clientSessionRequest_t));
+   apx_clientSession_completeRequest(self, &request, result, data);
+}
+
+static void apx_clientSession_completeRequest(apx_clientSession_t *self, apx_clientSessionRequest_t *request, int32_t result, void *data)
+{
+   apx_clientSessionHandler_t handler;
+   SPINLOCK_ENTER(self->lock);
+   handler = self->handler;
+   SPINLOCK_LEAVE(self->lock);
+   if ( (result != APX_NO_ERROR) && (handler.error != 0) )
+   {
+      handler.error(handler.arg, &request->cmd, result);
+   }
+   if (request->callback != 0)
+   {
+      request->callback(request->callbackArg, request->requestId, result, data);
+   }
+   apx_cmd_destroy(&request->cmd);
+}
+
+static void apx_clientSession_failExpiredCmds(apx_clientSession_t *self, uint64_t nowMs)
+{
+   uint32_t i = 0u;
+   bool isExpired = false;
+   while (i < self->numPending)
    {
-      //TODO: Placeholder logic, implement later
-      bool retval = false;
-      return retval;
+      if ( (self->pending[i].deadlineMs != 0u) && (self->pending[i].deadlineMs <= nowMs) )
+      {
+         apx_clientSession_finishCmd(self, i, APX_TIMEOUT_ERROR, 0);
+         isExpired = true;
+      }
+      else
+      {
+         i++;
+      }
+   }
+   if (isExpired == true)
+   {
+      apx_clientSession_runBarriers(self);
+   }
+}
+
+static void apx_clientSession_failAllCmds(apx_clientSession_t *self, int32_t errorCode)
+{
+   uint32_t i = 0u;
+   while (i < self->numPending)
+   {
+      if (self->pending[i].cmd.cmdType == APX_CMD_COMPLETE)
+      {
+         i++;
+      }
+      else
+      {
+         apx_clientSession_finishCmd(self, i, errorCode, 0);
+      }
    }
-   return false;
+   apx_clientSession_runBarriers(self);
+}
+
+/**
+ * Empties the message queue without starting any command. Commands are completed with errorCode in the order they
+ * were issued, completedCmd barriers run when their turn comes since everything ahead of them has already finished.
+ * Must be called after apx_clientSession_failAllCmds and only when the worker thread is not processing messages.
+ */
+static void apx_clientSession_failQueuedCmds(apx_clientSession_t *self, int32_t errorCode)
+{
+   apx_clientSessionMsg_t msg;
+   while (rbf32_remove(&self->messages, (uint8_t*) &msg) == E_BUF_OK)
+   {
+      if (msg.msgType != MSG_TYPE_COMMAND)
+      {
+         apx_cmd_destroy(&msg.cmd);
+      }
+      else if (msg.cmd.cmdType == APX_CMD_COMPLETE)
+      {
+         apx_clientSession_notifyCompleted(self, msg.result);
+      }
+      else
+      {
+         apx_clientSessionRequest_t request;
+         memset(&request, 0, sizeof(request));
+         request.requestId = msg.requestId;
+         request.cmd = msg.cmd;
+         request.callback = msg.callback;
+         request.callbackArg = msg.callbackArg;
+         apx_clientSession_completeRequest(self, &request, errorCode, 0);
+      }
+   }
+}
+
+/**
+ * Runs completedCmd barriers that no longer have unfinished commands ahead of them
+ */
+static void apx_clientSession_runBarriers(apx_clientSession_t *self)
+{
+   while ( (self->numPending > 0u) && (self->pending[0].cmd.cmdType == APX_CMD_COMPLETE) )
+   {
+      int32_t userCode = self->pending[0].userCode;
+      self->numPending--;
+      memmove(&self->pending[0], &self->pending[1], self->numPending*sizeof(apx_clientSessionRequest_t));
+      apx_clientSession_notifyCompleted(self, userCode);
+   }
+}
+
+static void apx_clientSession_notifyCompleted(apx_clientSession_t *self, int32_t userCode)
+{
+   apx_clientSessionHandler_t handler;
+   SPINLOCK_ENTER(self->lock);
+   handler = self->handler;
+   SPINLOCK_LEAVE(self->lock);
+   if (handler.completed != 0)
+   {
+      handler.completed(handler.arg, userCode);
+   }
+}
+
+/**
+ * returns the time in milliseconds until the nearest command deadline, 0 when no command has a deadline
+ */
+static uint32_t apx_clientSession_calcWaitTime(const apx_clientSession_t *self, uint64_t nowMs)
+{
+   uint64_t waitMs = 0u;
+   uint32_t i;
+   for (i = 0; i < self->numPending; i++)
+   {
+      uint64_t deadlineMs = self->pending[i].deadlineMs;
+      if (deadlineMs != 0u)
+      {
+         uint64_t remainingMs = (deadlineMs > nowMs)? (deadlineMs - nowMs) : 1u;
+         if ( (waitMs == 0u) || (remainingMs < waitMs) )
+         {
+            waitMs = remainingMs;
+         }
+      }
+   }
+   return (waitMs > UINT32_MAX)? UINT32_MAX : (uint32_t) waitMs;
+}
+
+static uint64_t apx_clientSession_getTimeMs(void)
+{
+#ifdef _MSC_VER
+   return (uint64_t) GetTickCount64();
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t) ts.tv_sec)*1000u + ((uint64_t) ts.tv_nsec)/1000000u;
+#endif
+}
+
+/**
+ * returns 0 when the semaphore was taken, 1 on timeout and -1 on failure. A timeoutMs of 0 waits forever.
+ * The timeout is measured on the monotonic clock, wall clock adjustments neither shorten nor extend it.
+ */
+static int8_t apx_clientSession_waitSemaphore(SEMAPHORE_T *semaphore, uint32_t timeoutMs)
+{
+#ifdef _MSC_VER
+   DWORD result = WaitForSingleObject(*semaphore, (timeoutMs == 0u)? INFINITE : (DWORD) timeoutMs);
+   if (result == WAIT_OBJECT_0)
+   {
+      return 0;
+   }
+   return (result == WAIT_TIMEOUT)? 1 : -1;
+#else
+   int result;
+   if (timeoutMs == 0u)
+   {
+      do
+      {
+         result = sem_wait(semaphore);
+      } while ( (result != 0) && (errno == EINTR) );
+   }
+   else
+   {
+# if(APX_CLIENT_SESSION_SEM_CLOCKWAIT)
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      ts.tv_sec += (time_t) (timeoutMs / 1000u);
+      ts.tv_nsec += (long) (timeoutMs % 1000u) * 1000000L;
+      if (ts.tv_nsec >= 1000000000L)
+      {
+         ts.tv_sec++;
+         ts.tv_nsec -= 1000000000L;
+      }
+      do
+      {
+         result = sem_clockwait(semaphore, CLOCK_MONOTONIC, &ts);
+      } while ( (result != 0) && (errno == EINTR) );
+# else
+      //sem_timedwait only takes CLOCK_REALTIME deadlines, the deadline is rebuilt from the monotonic clock after every
+      //wakeup so that a wall clock step does not end the wait early
+      uint64_t deadlineMs = apx_clientSession_getTimeMs() + timeoutMs;
+      for (;;)
+      {
+         struct timespec ts;
+         uint64_t nowMs = apx_clientSession_getTimeMs();
+         uint32_t remainingMs;
+         if (nowMs >= deadlineMs)
+         {
+            result = -1;
+            errno = ETIMEDOUT;
+            break;
+         }
+         remainingMs = (uint32_t) (deadlineMs - nowMs);
+         clock_gettime(CLOCK_REALTIME, &ts);
+         ts.tv_sec += (time_t) (remainingMs / 1000u);
+         ts.tv_nsec += (long) (remainingMs % 1000u) * 1000000L;
+         if (ts.tv_nsec >= 1000000000L)
+         {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+         }
+         result = sem_timedwait(semaphore, &ts);
+         if ( (result == 0) || ( (errno != ETIMEDOUT) && (errno != EINTR) ) )
+         {
+            break;
+         }
+      }
+# endif
+   }
+   if (result == 0)
+   {
+      return 0;
+   }
+   return (errno == ETIMEDOUT)? 1 : -1;
+#endif
 }
@@ -8,6 +8,7 @@
 #include <string.h>
 #include "CuTest.h"
 #include "apx_clientSession.h"
+#include "apx_error.h"
 #include "apx_testServer.h"
 #ifdef _WIN32
 #include <Windows.h>
@@ -23,11 +24,64 @@
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#define MAX_NUM_REQUESTS 10
+#define FUTURE_TIMEOUT_MS 2000u
+
+typedef struct testTransport_tag
+{
+   apx_sessionFuture_t requestEvent; //posted once for every request
+   uint32_t numRequests;
+   uint32_t requestIds[MAX_NUM_REQUESTS];
+   int32_t cmdTypes[MAX_NUM_REQUESTS];
+   char nodeNames[MAX_NUM_REQUESTS][32];
+   int32_t result; //returned from request
+}testTransport_t;
+
+typedef struct testHandler_tag
+{
+   uint32_t numCompleted;
+   int32_t lastUserCode;
+   uint32_t numErrors;
+   int32_t lastErrorCode;
+   int32_t lastErrorCmdType;
+   apx_sessionFuture_t completedEvent;
+}testHandler_t;
+
+typedef struct testCounter_tag
+{
+   uint32_t numCalls;
+   uint32_t numNotConnected;
+}testCounter_t;
+
+typedef struct testResult_tag
+{
+   apx_sessionFuture_t future;
+   char data[32];
+}testResult_t;
+
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void test_apx_clientSession_create(CuTest* tc);
+static void test_apx_clientSession_pipelinedCommands(CuTest* tc);
+static void test_apx_clientSession_timeout(CuTest* tc);
+static void test_apx_clientSession_deferUntilConnected(CuTest* tc);
+static void test_apx_clientSession_completedCmd(CuTest* tc);
+static void test_apx_clientSession_noTransport(CuTest* tc);
+static void test_apx_clientSession_stopWithFullQueue(CuTest* tc);
+static void test_apx_clientSession_destroyCompletesQueuedCmds(CuTest* tc);
+static void test_apx_clientSession_destroyStopsWorker(CuTest* tc);
+static void testTransport_create(testTransport_t *self);
+static void testTransport_destroy(testTransport_t *self);
+static int32_t testTransport_request(void *arg, uint32_t requestId, const apx_cmd_t *cmd);
+static int32_t testTransport_slowRequest(void *arg, uint32_t requestId, const apx_cmd_t *cmd);
+static void testHandler_create(testHandler_t *self, apx_clientSessionHandler_t *handler);
+static void testHandler_completed(void *arg, int32_t userCode);
+static void testHandler_error(void *arg, const apx_cmd_t *cmd, int32_t errorCode);
+static void testResult_callback(void *arg, uint32_t requestId, int32_t result, void *data);
+static void testCounter_callback(void *arg, uint32_t requestId, int32_t result, void *data);
+static void startSession(apx_clientSession_t *session, testTransport_t *transport, testHandler_t *testHandler);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -48,6 +102,14 @@ CuSuite* testSuite_apx_clientSession(void)
    CuSuite* suite = CuSuiteNew();
 
    SUITE_ADD_TEST(suite, test_apx_clientSession_create);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_pipelinedCommands);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_timeout);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_deferUntilConnected);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_completedCmd);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_noTransport);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_stopWithFullQueue);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_destroyCompletesQueuedCmds);
+   SUITE_ADD_TEST(suite, test_apx_clientSession_destroyStopsWorker);
 
    return suite;
 }
@@ -63,3 +125,352 @@ static void test_apx_clientSession_create(CuTest* tc)
    apx_clientSession_delete(session);
 }
 
+static void test_apx_clientSession_pipelinedCommands(CuTest* tc)
+{
+   apx_clientSession_t session;
+   testTransport_t transport;
+   testHandler_t handler;
+   testResult_t listResult;
+   apx_sessionFuture_t openFuture;
+   apx_sessionFuture_t pingFuture;
+   uint32_t listId;
+   uint32_t openId;
+   uint32_t pingId;
+   uint32_t i;
+   startSession(&session, &transport, &handler);
+   apx_clientSession_onConnected(&session);
+   apx_sessionFuture_create(&listResult.future);
+   apx_sessionFuture_create(&openFuture);
+   apx_sessionFuture_create(&pingFuture);
+   listId = apx_clientSession_listNodesCmd(&session, 0u, testResult_callback, &listResult);
+   openId = apx_clientSession_openNodeCmd(&session, "TestNode1", 0u, apx_sessionFuture_callback, &openFuture);
+   pingId = apx_clientSession_pingNodeByNameCmd(&session, "TestNode2", 0u, apx_sessionFuture_callback, &pingFuture);
+   CuAssertTrue(tc, listId != APX_CLIENT_SESSION_INVALID_ID);
+   CuAssertTrue(tc, openId > listId);
+   CuAssertTrue(tc, pingId > openId);
+   //all three requests are sent before any response has arrived
+   for (i = 0; i < 3; i++)
+   {
+      CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   }
+   CuAssertUIntEquals(tc, 3, transport.numRequests);
+   CuAssertUIntEquals(tc, listId, transport.requestIds[0]);
+   CuAssertIntEquals(tc, APX_CMD_LIST_NODES, transport.cmdTypes[0]);
+   CuAssertIntEquals(tc, APX_CMD_OPEN_NODE, transport.cmdTypes[1]);
+   CuAssertStrEquals(tc, "TestNode1", transport.nodeNames[1]);
+   CuAssertIntEquals(tc, APX_CMD_PING_NODE, transport.cmdTypes[2]);
+   CuAssertStrEquals(tc, "TestNode2", transport.nodeNames[2]);
+   //responses arrive out of order
+   apx_clientSession_onResponse(&session, pingId, APX_NO_ERROR, 0, 0);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&pingFuture, FUTURE_TIMEOUT_MS));
+   CuAssertUIntEquals(tc, pingId, pingFuture.requestId);
+   apx_clientSession_onResponse(&session, openId, APX_PARSE_ERROR, 0, 0);
+   CuAssertIntEquals(tc, APX_PARSE_ERROR, apx_sessionFuture_wait(&openFuture, FUTURE_TIMEOUT_MS));
+   apx_clientSession_onResponse(&session, listId, APX_NO_ERROR, strdup("TestNode1,TestNode2"), free);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&listResult.future, FUTURE_TIMEOUT_MS));
+   CuAssertStrEquals(tc, "TestNode1,TestNode2", listResult.data);
+   //a second response to the same request is discarded
+   apx_clientSession_onResponse(&session, listId, APX_NO_ERROR, strdup("late"), free);
+   apx_clientSession_stop(&session);
+   CuAssertUIntEquals(tc, 1, handler.numErrors);
+   CuAssertIntEquals(tc, APX_PARSE_ERROR, handler.lastErrorCode);
+   CuAssertIntEquals(tc, APX_CMD_OPEN_NODE, handler.lastErrorCmdType);
+   apx_clientSession_destroy(&session);
+   apx_sessionFuture_destroy(&listResult.future);
+   apx_sessionFuture_destroy(&openFuture);
+   apx_sessionFuture_destroy(&pingFuture);
+   testTransport_destroy(&transport);
+   apx_sessionFuture_destroy(&handler.completedEvent);
+}
+
+static void test_apx_clientSession_timeout(CuTest* tc)
+{
+   apx_clientSession_t session;
+   testTransport_t transport;
+   testHandler_t handler;
+   apx_sessionFuture_t slowFuture;
+   apx_sessionFuture_t fastFuture;
+   uint32_t fastId;
+   startSession(&session, &transport, &handler);
+   apx_clientSession_onConnected(&session);
+   apx_sessionFuture_create(&slowFuture);
+   apx_sessionFuture_create(&fastFuture);
+   apx_clientSession_pingNodeByNameCmd(&session, "TestNode1", 50u, apx_sessionFuture_callback, &slowFuture);
+   fastId = apx_clientSession_pingNodeByNameCmd(&session, "TestNode1", 1000u, apx_sessionFuture_callback, &fastFuture);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   apx_clientSession_onResponse(&session, fastId, APX_NO_ERROR, 0, 0);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&fastFuture, FUTURE_TIMEOUT_MS));
+   CuAssertIntEquals(tc, APX_TIMEOUT_ERROR, apx_sessionFuture_wait(&slowFuture, FUTURE_TIMEOUT_MS));
+   apx_clientSession_stop(&session);
+   CuAssertUIntEquals(tc, 1, handler.numErrors);
+   CuAssertIntEquals(tc, APX_TIMEOUT_ERROR, handler.lastErrorCode);
+   apx_clientSession_destroy(&session);
+   apx_sessionFuture_destroy(&slowFuture);
+   apx_sessionFuture_destroy(&fastFuture);
+   testTransport_destroy(&transport);
+   apx_sessionFuture_destroy(&handler.completedEvent);
+}
+
+static void test_apx_clientSession_deferUntilConnected(CuTest* tc)
+{
+   apx_clientSession_t session;
+   testTransport_t transport;
+   testHandler_t handler;
+   apx_sessionFuture_t connectFuture;
+   apx_sessionFuture_t listFuture;
+   apx_sessionFuture_t pingFuture;
+   uint32_t connectId;
+   startSession(&session, &transport, &handler);
+   apx_sessionFuture_create(&connectFuture);
+   apx_sessionFuture_create(&listFuture);
+   apx_sessionFuture_create(&pingFuture);
+   connectId = apx_clientSession_connectTcpCmd(&session, "localhost", 5000u, 0u, apx_sessionFuture_callback, &connectFuture);
+   apx_clientSession_listNodesCmd(&session, 0u, apx_sessionFuture_callback, &listFuture);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   CuAssertIntEquals(tc, APX_CMD_CONNECT, transport.cmdTypes[0]);
+   apx_clientSession_onResponse(&session, connectId, APX_NO_ERROR, 0, 0);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&connectFuture, FUTURE_TIMEOUT_MS));
+   CuAssertUIntEquals(tc, 1, transport.numRequests);
+   apx_clientSession_onConnected(&session);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   CuAssertIntEquals(tc, APX_CMD_LIST_NODES, transport.cmdTypes[1]);
+   apx_clientSession_pingNodeByNameCmd(&session, "TestNode1", 0u, apx_sessionFuture_callback, &pingFuture);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   //connection lost, both requests in flight fail
+   apx_clientSession_onDisconnected(&session);
+   CuAssertIntEquals(tc, APX_NOT_CONNECTED_ERROR, apx_sessionFuture_wait(&listFuture, FUTURE_TIMEOUT_MS));
+   CuAssertIntEquals(tc, APX_NOT_CONNECTED_ERROR, apx_sessionFuture_wait(&pingFuture, FUTURE_TIMEOUT_MS));
+   apx_clientSession_stop(&session);
+   CuAssertUIntEquals(tc, 3, transport.numRequests);
+   CuAssertUIntEquals(tc, 2, handler.numErrors);
+   apx_clientSession_destroy(&session);
+   apx_sessionFuture_destroy(&connectFuture);
+   apx_sessionFuture_destroy(&listFuture);
+   apx_sessionFuture_destroy(&pingFuture);
+   testTransport_destroy(&transport);
+   apx_sessionFuture_destroy(&handler.completedEvent);
+}
+
+static void test_apx_clientSession_completedCmd(CuTest* tc)
+{
+   apx_clientSession_t session;
+   testTransport_t transport;
+   testHandler_t handler;
+   apx_sessionFuture_t pingFuture;
+   uint32_t pingId;
+   startSession(&session, &transport, &handler);
+   apx_clientSession_onConnected(&session);
+   apx_sessionFuture_create(&pingFuture);
+   pingId = apx_clientSession_pingNodeByNameCmd(&session, "TestNode1", 0u, apx_sessionFuture_callback, &pingFuture);
+   CuAssertTrue(tc, apx_clientSession_completedCmd(&session, 42) != APX_CLIENT_SESSION_INVALID_ID);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   //completed is held back by the ping that is still in flight
+   CuAssertIntEquals(tc, APX_TIMEOUT_ERROR, apx_sessionFuture_wait(&handler.completedEvent, 20u));
+   CuAssertUIntEquals(tc, 0, handler.numCompleted);
+   apx_clientSession_onResponse(&session, pingId, APX_NO_ERROR, 0, 0);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&pingFuture, FUTURE_TIMEOUT_MS));
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&handler.completedEvent, FUTURE_TIMEOUT_MS));
+   CuAssertUIntEquals(tc, 1, handler.numCompleted);
+   CuAssertIntEquals(tc, 42, handler.lastUserCode);
+   //with nothing in flight completed runs right away
+   apx_clientSession_completedCmd(&session, 43);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&handler.completedEvent, FUTURE_TIMEOUT_MS));
+   CuAssertIntEquals(tc, 43, handler.lastUserCode);
+   apx_clientSession_stop(&session);
+   apx_clientSession_destroy(&session);
+   apx_sessionFuture_destroy(&pingFuture);
+   testTransport_destroy(&transport);
+   apx_sessionFuture_destroy(&handler.completedEvent);
+}
+
+static void test_apx_clientSession_noTransport(CuTest* tc)
+{
+   apx_clientSession_t session;
+   apx_sessionFuture_t future;
+   CuAssertIntEquals(tc, 0, apx_clientSession_create(&session, 0));
+   apx_sessionFuture_create(&future);
+   apx_clientSession_start(&session);
+   CuAssertTrue(tc, apx_clientSession_connectLocalCmd(&session, "/tmp/apx_server.socket", 0u, apx_sessionFuture_callback, &future) != APX_CLIENT_SESSION_INVALID_ID);
+   CuAssertIntEquals(tc, APX_NOT_CONNECTED_ERROR, apx_sessionFuture_wait(&future, FUTURE_TIMEOUT_MS));
+   CuAssertUIntEquals(tc, APX_CLIENT_SESSION_INVALID_ID, apx_clientSession_pingNodeByNameCmd(&session, 0, 0u, 0, 0));
+   apx_clientSession_stop(&session);
+   apx_clientSession_destroy(&session);
+   apx_sessionFuture_destroy(&future);
+}
+
+static void test_apx_clientSession_stopWithFullQueue(CuTest* tc)
+{
+   apx_clientSession_t session;
+   testTransport_t transport;
+   testHandler_t handler;
+   testCounter_t counter;
+   apx_clientSessionTransport_t slowTransport;
+   uint32_t numIssued = 0u;
+   startSession(&session, &transport, &handler);
+   slowTransport.arg = &transport;
+   slowTransport.request = testTransport_slowRequest;
+   apx_clientSession_setTransport(&session, &slowTransport);
+   memset(&counter, 0, sizeof(counter));
+   apx_clientSession_onConnected(&session);
+   CuAssertTrue(tc, apx_clientSession_pingNodeByNameCmd(&session, "TestNode1", 0u, testCounter_callback, &counter) != APX_CLIENT_SESSION_INVALID_ID);
+   numIssued++;
+   //the worker thread is now busy in the transport, fill the message queue behind it
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_sessionFuture_wait(&transport.requestEvent, FUTURE_TIMEOUT_MS));
+   while (apx_clientSession_pingNodeByNameCmd(&session, "TestNode1", 0u, testCounter_callback, &counter) != APX_CLIENT_SESSION_INVALID_ID)
+   {
+      numIssued++;
+   }
+   CuAssertTrue(tc, numIssued > 1u);
+   apx_clientSession_stop(&session);
+   CuAssertTrue(tc, session.workerThreadValid == false);
+   CuAssertUIntEquals(tc, numIssued, counter.numCalls);
+   CuAssertUIntEquals(tc, numIssued, counter.numNotConnected);
+   apx_clientSession_destroy(&session);
+   testTransport_destroy(&transport);
+   apx_sessionFuture_destroy(&handler.completedEvent);
+}
+
+static void test_apx_clientSession_destroyCompletesQueuedCmds(CuTest* tc)
+{
+   apx_clientSession_t session;
+   testHandler_t handler;
+   apx_clientSessionHandler_t sessionHandler;
+   testCounter_t counter;
+   memset(&counter, 0, sizeof(counter));
+   testHandler_create(&handler, &sessionHandler);
+   CuAssertIntEquals(tc, 0, apx_clientSession_create(&session, &sessionHandler));
+   //the worker thread is never started
+   apx_clientSession_listNodesCmd(&session, 0u, testCounter_callback, &counter);
+   apx_clientSession_completedCmd(&session, 7);
+   apx_clientSession_openNodeCmd(&session, "TestNode1", 0u, testCounter_callback, &counter);
+   apx_clientSession_destroy(&session);
+   CuAssertUIntEquals(tc, 2, counter.numCalls);
+   CuAssertUIntEquals(tc, 2, counter.numNotConnected);
+   CuAssertUIntEquals(tc, 2, handler.numErrors);
+   CuAssertUIntEquals(tc, 1, handler.numCompleted);
+   CuAssertIntEquals(tc, 7, handler.lastUserCode);
+   apx_sessionFuture_destroy(&handler.completedEvent);
+}
+
+static void test_apx_clientSession_destroyStopsWorker(CuTest* tc)
+{
+   apx_clientSession_t session;
+   testTransport_t transport;
+   testHandler_t handler;
+   testCounter_t counter;
+   memset(&counter, 0, sizeof(counter));
+   startSession(&session, &transport, &handler);
+   CuAssertTrue(tc, session.workerThreadValid == true);
+   apx_clientSession_listNodesCmd(&session, 0u, testCounter_callback, &counter);
+   //no apx_clientSession_stop
+   apx_clientSession_destroy(&session);
+   CuAssertTrue(tc, session.workerThreadValid == false);
+   CuAssertUIntEquals(tc, 1, counter.numCalls);
+   testTransport_destroy(&transport);
+   apx_sessionFuture_destroy(&handler.completedEvent);
+}
+
+static void testTransport_create(testTransport_t *self)
+{
+   memset(self, 0, sizeof(testTransport_t));
+   apx_sessionFuture_create(&self->requestEvent);
+   self->result = APX_NO_ERROR;
+}
+
+static void testTransport_destroy(testTransport_t *self)
+{
+   apx_sessionFuture_destroy(&self->requestEvent);
+}
+
+static int32_t testTransport_request(void *arg, uint32_t requestId, const apx_cmd_t *cmd)
+{
+   testTransport_t *self = (testTransport_t*) arg;
+   if (self->numRequests < MAX_NUM_REQUESTS)
+   {
+      self->requestIds[self->numRequests] = requestId;
+      self->cmdTypes[self->numRequests] = cmd->cmdType;
+      if ( (cmd->cmdType == APX_CMD_OPEN_NODE) || (cmd->cmdType == APX_CMD_PING_NODE) )
+      {
+         strncpy(self->nodeNames[self->numRequests], (const char*) cmd->cmdAny, sizeof(self->nodeNames[0])-1);
+      }
+      self->numRequests++;
+   }
+   apx_sessionFuture_callback(&self->requestEvent, requestId, APX_NO_ERROR, 0);
+   return self->result;
+}
+
+/**
+ * records the request like testTransport_request, then keeps the worker thread busy for 100ms
+ */
+static int32_t testTransport_slowRequest(void *arg, uint32_t requestId, const apx_cmd_t *cmd)
+{
+   int32_t result = testTransport_request(arg, requestId, cmd);
+   apx_sessionFuture_t delay;
+   apx_sessionFuture_create(&delay);
+   (void) apx_sessionFuture_wait(&delay, 100u);
+   apx_sessionFuture_destroy(&delay);
+   return result;
+}
+
+static void testHandler_create(testHandler_t *self, apx_clientSessionHandler_t *handler)
+{
+   memset(self, 0, sizeof(testHandler_t));
+   apx_sessionFuture_create(&self->completedEvent);
+   handler->arg = self;
+   handler->completed = testHandler_completed;
+   handler->error = testHandler_error;
+}
+
+static void testHandler_completed(void *arg, int32_t userCode)
+{
+   testHandler_t *self = (testHandler_t*) arg;
+   self->numCompleted++;
+   self->lastUserCode = userCode;
+   apx_sessionFuture_callback(&self->completedEvent, 0u, APX_NO_ERROR, 0);
+}
+
+static void testHandler_error(void *arg, const apx_cmd_t *cmd, int32_t errorCode)
+{
+   testHandler_t *self = (testHandler_t*) arg;
+   self->numErrors++;
+   self->lastErrorCode = errorCode;
+   self->lastErrorCmdType = cmd->cmdType;
+}
+
+static void testResult_callback(void *arg, uint32_t requestId, int32_t result, void *data)
+{
+   testResult_t *self = (testResult_t*) arg;
+   self->data[0] = '\0';
+   if (data != 0)
+   {
+      strncpy(self->data, (const char*) data, sizeof(self->data)-1);
+      self->data[sizeof(self->data)-1] = '\0';
+   }
+   apx_sessionFuture_callback(&self->future, requestId, result, 0);
+}
+
+static void testCounter_callback(void *arg, uint32_t requestId, int32_t result, void *data)
+{
+   testCounter_t *self = (testCounter_t*) arg;
+   (void) requestId;
+   (void) data;
+   self->numCalls++;
+   if (result == APX_NOT_CONNECTED_ERROR)
+   {
+      self->numNotConnected++;
+   }
+}
+
+static void startSession(apx_clientSession_t *session, testTransport_t *transport, testHandler_t *testHandler)
+{
+   apx_clientSessionHandler_t handler;
+   apx_clientSessionTransport_t sessionTransport;
+   testHandler_create(testHandler, &handler);
+   testTransport_create(transport);
+   sessionTransport.arg = transport;
+   sessionTransport.request = testTransport_request;
+   apx_clientSession_create(session, &handler);
+   apx_clientSession_setTransport(session, &sessionTransport);
+   apx_clientSession_start(session);
+}
@@ -0,0 +1,51 @@
+/**
+ * file: apx_codeGenerator.h
+ * description: apx_codeGenerator generates typed C accessors (header and source) for an apx node.
+ *              The generated code has compile-time constant port offsets/lengths, a precomputed init data blob and
+ *              static inline read/write functions which pack/unpack little-endian data directly into the port data buffers.
+ */
+#ifndef APX_CODE_GENERATOR_H
+#define APX_CODE_GENERATOR_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+#include "apx_node.h"
+#include "apx_portDataMap.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_CODEGEN_MAX_NAME_LEN        128
+#define APX_CODEGEN_MAX_EXPR_LEN        512
+#define APX_CODEGEN_INIT_DATA_PER_LINE  16
+
+typedef struct apx_codeGenerator_tag
+{
+   apx_node_t *node; //weak reference
+   const char *definitionText; //weak reference, the APX text the node was parsed from
+   uint32_t definitionLen;
+   apx_portDataMap_t inPortDataMap;
+   apx_portDataMap_t outPortDataMap;
+}apx_codeGenerator_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void apx_codeGenerator_create(apx_codeGenerator_t *self);
+void apx_codeGenerator_destroy(apx_codeGenerator_t *self);
+apx_codeGenerator_t *apx_codeGenerator_new(void);
+void apx_codeGenerator_delete(apx_codeGenerator_t *self);
+
+int8_t apx_codeGenerator_setNode(apx_codeGenerator_t *self, apx_node_t *node, const char *definitionText, uint32_t definitionLen);
+int8_t apx_codeGenerator_writeHeader(apx_codeGenerator_t *self, FILE *fp);
+int8_t apx_codeGenerator_writeSource(apx_codeGenerator_t *self, FILE *fp, const char *headerName);
+
+#endif //APX_CODE_GENERATOR_H
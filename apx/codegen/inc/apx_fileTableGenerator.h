@@ -0,0 +1,56 @@
+/**
+ * file: apx_fileTableGenerator.h
+ * description: apx_fileTableGenerator generates the local file table of an embedded (apx-es) client as C code.
+ *              The out port data file and definition file of each node are statically initialized with precomputed
+ *              addresses and are referenced from a const table sorted by address, see apx_es_fileManager_setLocalFileTable.
+ *              Addresses are assigned using the same layout as apx_es_fileMap_autoInsert.
+ */
+#ifndef APX_FILE_TABLE_GENERATOR_H
+#define APX_FILE_TABLE_GENERATOR_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+#include "apx_codeGenerator.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_FILETABLE_MAX_NUM_NODES     64
+
+typedef struct apx_fileTableNode_tag
+{
+   char nodeName[APX_CODEGEN_MAX_NAME_LEN];
+   uint32_t outPortDataLen; //no out port data file is generated when this is 0
+   uint32_t definitionLen;
+   uint32_t outDataAddress;
+   uint32_t definitionAddress;
+}apx_fileTableNode_t;
+
+typedef struct apx_fileTableGenerator_tag
+{
+   char tableName[APX_CODEGEN_MAX_NAME_LEN];
+   apx_fileTableNode_t nodes[APX_FILETABLE_MAX_NUM_NODES];
+   int32_t numNodes;
+   int32_t numFiles;
+   uint32_t outDataEndAddress; //end of latest placed out port data file
+   uint32_t definitionEndAddress; //end of latest placed definition file
+}apx_fileTableGenerator_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+int8_t apx_fileTableGenerator_create(apx_fileTableGenerator_t *self, const char *tableName);
+
+int8_t apx_fileTableGenerator_addNode(apx_fileTableGenerator_t *self, const char *nodeName, uint32_t outPortDataLen, uint32_t definitionLen);
+int8_t apx_fileTableGenerator_writeHeader(apx_fileTableGenerator_t *self, FILE *fp);
+int8_t apx_fileTableGenerator_writeSource(apx_fileTableGenerator_t *self, FILE *fp, const char *headerName);
+
+#endif //APX_FILE_TABLE_GENERATOR_H
@@ -0,0 +1,800 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <malloc.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include "apx_codeGenerator.h"
+#include "apx_error.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * byte offset of a value inside a port, expressed as a constant part and a (possibly empty) loop-dependent part
+ */
+typedef struct apx_codeGenOffset_tag
+{
+   uint32_t base;
+   char var[APX_CODEGEN_MAX_EXPR_LEN];
+}apx_codeGenOffset_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void apx_codeGenerator_writePackFunctions(FILE *fp);
+static void apx_codeGenerator_writePortDefines(FILE *fp, const char *upperNodeName, apx_portDataMap_t *dataMap);
+static void apx_codeGenerator_writeRecordTypes(FILE *fp, const char *nodeName, apx_portDataMap_t *dataMap);
+static void apx_codeGenerator_writeStructFields(FILE *fp, const apx_dataElement_t *dataElement, int indent);
+static int8_t apx_codeGenerator_writeAccessor(FILE *fp, const char *nodeName, const char *upperNodeName, apx_port_t *port, uint8_t isWrite);
+static int8_t apx_codeGenerator_writeElement(FILE *fp, const apx_dataElement_t *dataElement, const char *valExpr, const apx_codeGenOffset_t *offset, int depth, uint8_t isWrite, int indent);
+static int8_t apx_codeGenerator_writeRecordFields(FILE *fp, const apx_dataElement_t *dataElement, const char *prefix, const apx_codeGenOffset_t *offset, int depth, uint8_t isWrite, int indent);
+static int8_t apx_codeGenerator_writeIntValue(FILE *fp, const apx_dataElement_t *dataElement, const char *valExpr, const apx_codeGenOffset_t *offset, uint8_t isWrite, int indent);
+static void apx_codeGenerator_writeInitData(FILE *fp, const char *varName, const char *lenMacro, const uint8_t *data, uint32_t len);
+static void apx_codeGenerator_writeDefinitionText(FILE *fp, const char *text, uint32_t len);
+static void apx_codeGenerator_writeIndent(FILE *fp, int indent);
+static void apx_codeGenerator_formatOffset(char *buf, size_t bufLen, const apx_codeGenOffset_t *offset);
+static void apx_codeGenerator_addLoopOffset(apx_codeGenOffset_t *dest, const apx_codeGenOffset_t *src, int depth, uint32_t stride);
+static void apx_codeGenerator_toUpper(char *dest, const char *src, size_t destLen);
+static int apx_codeGenerator_loopDepth(const apx_dataElement_t *dataElement);
+static const char *apx_codeGenerator_intTypeName(int8_t baseType);
+static uint8_t apx_codeGenerator_intWidth(int8_t baseType);
+static uint8_t apx_codeGenerator_isSigned(int8_t baseType);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void apx_codeGenerator_create(apx_codeGenerator_t *self)
+{
+   if (self != 0)
+   {
+      self->node = (apx_node_t*) 0;
+      self->definitionText = (const char*) 0;
+      self->definitionLen = 0u;
+      apx_portDataMap_create(&self->inPortDataMap);
+      apx_portDataMap_create(&self->outPortDataMap);
+   }
+}
+
+void apx_codeGenerator_destroy(apx_codeGenerator_t *self)
+{
+   if (self != 0)
+   {
+      apx_portDataMap_destroy(&self->inPortDataMap);
+      apx_portDataMap_destroy(&self->outPortDataMap);
+   }
+}
+
+apx_codeGenerator_t *apx_codeGenerator_new(void)
+{
+   apx_codeGenerator_t *self = (apx_codeGenerator_t*) malloc(sizeof(apx_codeGenerator_t));
+   if(self != 0)
+   {
+      apx_codeGenerator_create(self);
+   }
+   else
+   {
+      errno = ENOMEM;
+   }
+   return self;
+}
+
+void apx_codeGenerator_delete(apx_codeGenerator_t *self)
+{
+   if (self != 0)
+   {
+      apx_codeGenerator_destroy(self);
+      free(self);
+   }
+}
+
+/**
+ * Prepares code generation for node. Builds the port data maps, init data is taken from the finalized node.
+ * definitionText is the APX text that shall be embedded into the generated source file. It must be valid until code
+ * generation is complete.
+ */
+int8_t apx_codeGenerator_setNode(apx_codeGenerator_t *self, apx_node_t *node, const char *definitionText, uint32_t definitionLen)
+{
+   if ( (self != 0) && (node != 0) && (node->name != 0) && (definitionText != 0) )
+   {
+      if (node->isFinalized == false)
+      {
+         if (apx_node_finalize(node) != 0)
+         {
+            return -1;
+         }
+      }
+      self->node = node;
+      self->definitionText = definitionText;
+      self->definitionLen = definitionLen;
+      if ( (apx_portDataMap_build(&self->inPortDataMap, node, APX_REQUIRE_PORT) != 0) ||
+           (apx_portDataMap_build(&self->outPortDataMap, node, APX_PROVIDE_PORT) != 0) )
+      {
+         return -1;
+      }
+      if ( (apx_node_getInPortDataLen(node) != (uint32_t) self->inPortDataMap.totalLen) ||
+           (apx_node_getOutPortDataLen(node) != (uint32_t) self->outPortDataMap.totalLen) )
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return -1;
+      }
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+int8_t apx_codeGenerator_writeHeader(apx_codeGenerator_t *self, FILE *fp)
+{
+   if ( (self != 0) && (self->node != 0) && (fp != 0) )
+   {
+      int32_t i;
+      int32_t numPorts;
+      char upperNodeName[APX_CODEGEN_MAX_NAME_LEN];
+      const char *nodeName = self->node->name;
+      apx_codeGenerator_toUpper(upperNodeName, nodeName, sizeof(upperNodeName));
+
+      fprintf(fp, "#ifndef APXNODE_%s_H\n", upperNodeName);
+      fprintf(fp, "#define APXNODE_%s_H\n\n", upperNodeName);
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// INCLUDES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "#include <stdint.h>\n");
+      fprintf(fp, "#include <string.h>\n");
+      fprintf(fp, "#include \"apx_nodeData.h\"\n\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// CONSTANTS AND DATA TYPES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "#define APXNODE_%s_DEFINITION_LEN %uu\n", upperNodeName, (unsigned int) self->definitionLen);
+      fprintf(fp, "#define APXNODE_%s_IN_PORT_DATA_LEN %uu\n", upperNodeName, (unsigned int) apx_node_getInPortDataLen(self->node));
+      fprintf(fp, "#define APXNODE_%s_OUT_PORT_DATA_LEN %uu\n\n", upperNodeName, (unsigned int) apx_node_getOutPortDataLen(self->node));
+      apx_codeGenerator_writePortDefines(fp, upperNodeName, &self->inPortDataMap);
+      apx_codeGenerator_writePortDefines(fp, upperNodeName, &self->outPortDataMap);
+      apx_codeGenerator_writeRecordTypes(fp, nodeName, &self->inPortDataMap);
+      apx_codeGenerator_writeRecordTypes(fp, nodeName, &self->outPortDataMap);
+      apx_codeGenerator_writePackFunctions(fp);
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// GLOBAL VARIABLES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      if (apx_node_getInPortDataLen(self->node) > 0)
+      {
+         fprintf(fp, "extern uint8_t ApxNode_%s_inPortData[APXNODE_%s_IN_PORT_DATA_LEN];\n", nodeName, upperNodeName);
+      }
+      if (apx_node_getOutPortDataLen(self->node) > 0)
+      {
+         fprintf(fp, "extern uint8_t ApxNode_%s_outPortData[APXNODE_%s_OUT_PORT_DATA_LEN];\n", nodeName, upperNodeName);
+      }
+      fprintf(fp, "extern apx_nodeData_t ApxNode_%s_nodeData;\n\n", nodeName);
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// FUNCTION PROTOTYPES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "void ApxNode_Init_%s(void);\n", nodeName);
+      fprintf(fp, "apx_nodeData_t * ApxNode_GetNodeData_%s(void);\n\n", nodeName);
+
+      numPorts = apx_portDataMap_getNumEntries(&self->inPortDataMap);
+      for (i=0; i<numPorts; i++)
+      {
+         apx_portDataMapEntry_t *entry = apx_portDataMap_getEntry(&self->inPortDataMap, i);
+         if (apx_codeGenerator_writeAccessor(fp, nodeName, upperNodeName, entry->port, 0) != 0)
+         {
+            return -1;
+         }
+      }
+      numPorts = apx_portDataMap_getNumEntries(&self->outPortDataMap);
+      for (i=0; i<numPorts; i++)
+      {
+         apx_portDataMapEntry_t *entry = apx_portDataMap_getEntry(&self->outPortDataMap, i);
+         if (apx_codeGenerator_writeAccessor(fp, nodeName, upperNodeName, entry->port, 1) != 0)
+         {
+            return -1;
+         }
+      }
+      fprintf(fp, "#endif //APXNODE_%s_H\n", upperNodeName);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+int8_t apx_codeGenerator_writeSource(apx_codeGenerator_t *self, FILE *fp, const char *headerName)
+{
+   if ( (self != 0) && (self->node != 0) && (fp != 0) && (headerName != 0) )
+   {
+      char upperNodeName[APX_CODEGEN_MAX_NAME_LEN];
+      char lenMacro[APX_CODEGEN_MAX_NAME_LEN+32];
+      const char *nodeName = self->node->name;
+      uint32_t inPortDataLen = apx_node_getInPortDataLen(self->node);
+      uint32_t outPortDataLen = apx_node_getOutPortDataLen(self->node);
+      apx_codeGenerator_toUpper(upperNodeName, nodeName, sizeof(upperNodeName));
+
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// INCLUDES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "#include <string.h>\n");
+      fprintf(fp, "#include \"%s\"\n\n", headerName);
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// LOCAL VARIABLES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      if (inPortDataLen > 0)
+      {
+         snprintf(lenMacro, sizeof(lenMacro), "APXNODE_%s_IN_PORT_DATA_LEN", upperNodeName);
+         apx_codeGenerator_writeInitData(fp, "m_inPortInitData", lenMacro, apx_node_getInPortInitData(self->node), inPortDataLen);
+         fprintf(fp, "static uint8_t m_inPortDirtyFlags[%s];\n", lenMacro);
+      }
+      if (outPortDataLen > 0)
+      {
+         snprintf(lenMacro, sizeof(lenMacro), "APXNODE_%s_OUT_PORT_DATA_LEN", upperNodeName);
+         apx_codeGenerator_writeInitData(fp, "m_outPortInitData", lenMacro, apx_node_getOutPortInitData(self->node), outPortDataLen);
+         fprintf(fp, "static uint8_t m_outPortDirtyFlags[%s];\n", lenMacro);
+      }
+      fprintf(fp, "static const char m_apxDefinitionData[APXNODE_%s_DEFINITION_LEN+1]=\n", upperNodeName);
+      apx_codeGenerator_writeDefinitionText(fp, self->definitionText, self->definitionLen);
+      fprintf(fp, "\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// GLOBAL VARIABLES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      if (inPortDataLen > 0)
+      {
+         fprintf(fp, "uint8_t ApxNode_%s_inPortData[APXNODE_%s_IN_PORT_DATA_LEN];\n", nodeName, upperNodeName);
+      }
+      if (outPortDataLen > 0)
+      {
+         fprintf(fp, "uint8_t ApxNode_%s_outPortData[APXNODE_%s_OUT_PORT_DATA_LEN];\n", nodeName, upperNodeName);
+      }
+      fprintf(fp, "apx_nodeData_t ApxNode_%s_nodeData;\n\n", nodeName);
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// GLOBAL FUNCTIONS\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "void ApxNode_Init_%s(void)\n{\n", nodeName);
+      if (inPortDataLen > 0)
+      {
+         fprintf(fp, "   memcpy(&ApxNode_%s_inPortData[0], &m_inPortInitData[0], APXNODE_%s_IN_PORT_DATA_LEN);\n", nodeName, upperNodeName);
+         fprintf(fp, "   memset(&m_inPortDirtyFlags[0], 0, sizeof(m_inPortDirtyFlags));\n");
+      }
+      if (outPortDataLen > 0)
+      {
+         fprintf(fp, "   memcpy(&ApxNode_%s_outPortData[0], &m_outPortInitData[0], APXNODE_%s_OUT_PORT_DATA_LEN);\n", nodeName, upperNodeName);
+         fprintf(fp, "   memset(&m_outPortDirtyFlags[0], 0, sizeof(m_outPortDirtyFlags));\n");
+      }
+      fprintf(fp, "   apx_nodeData_create(&ApxNode_%s_nodeData, \"%s\", (uint8_t*) &m_apxDefinitionData[0], APXNODE_%s_DEFINITION_LEN, ",
+            nodeName, nodeName, upperNodeName);
+      if (inPortDataLen > 0)
+      {
+         fprintf(fp, "&ApxNode_%s_inPortData[0], &m_inPortDirtyFlags[0], APXNODE_%s_IN_PORT_DATA_LEN, ", nodeName, upperNodeName);
+      }
+      else
+      {
+         fprintf(fp, "0, 0, 0, ");
+      }
+      if (outPortDataLen > 0)
+      {
+         fprintf(fp, "&ApxNode_%s_outPortData[0], &m_outPortDirtyFlags[0], APXNODE_%s_OUT_PORT_DATA_LEN);\n", nodeName, upperNodeName);
+      }
+      else
+      {
+         fprintf(fp, "0, 0, 0);\n");
+      }
+      fprintf(fp, "}\n\n");
+      fprintf(fp, "apx_nodeData_t * ApxNode_GetNodeData_%s(void)\n{\n", nodeName);
+      fprintf(fp, "   return &ApxNode_%s_nodeData;\n}\n\n", nodeName);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void apx_codeGenerator_writePackFunctions(FILE *fp)
+{
+   fprintf(fp, "#ifndef APXNODE_PACK_FUNCTIONS\n");
+   fprintf(fp, "#define APXNODE_PACK_FUNCTIONS\n");
+   fprintf(fp, "#ifdef _MSC_VER\n");
+   fprintf(fp, "#define APXNODE_INLINE static __inline\n");
+   fprintf(fp, "#else\n");
+   fprintf(fp, "#define APXNODE_INLINE static inline\n");
+   fprintf(fp, "#endif\n");
+   fprintf(fp, "APXNODE_INLINE void ApxNode_packU8(uint8_t *p, uint8_t v) { p[0] = v; }\n");
+   fprintf(fp, "APXNODE_INLINE void ApxNode_packU16LE(uint8_t *p, uint16_t v) { p[0] = (uint8_t) v; p[1] = (uint8_t) (v >> 8); }\n");
+   fprintf(fp, "APXNODE_INLINE void ApxNode_packU32LE(uint8_t *p, uint32_t v) { p[0] = (uint8_t) v; p[1] = (uint8_t) (v >> 8); p[2] = (uint8_t) (v >> 16); p[3] = (uint8_t) (v >> 24); }\n");
+   fprintf(fp, "APXNODE_INLINE void ApxNode_packU64LE(uint8_t *p, uint64_t v) { ApxNode_packU32LE(p, (uint32_t) v); ApxNode_packU32LE(p+4, (uint32_t) (v >> 32)); }\n");
+   fprintf(fp, "APXNODE_INLINE uint8_t ApxNode_unpackU8(const uint8_t *p) { return p[0]; }\n");
+   fprintf(fp, "APXNODE_INLINE uint16_t ApxNode_unpackU16LE(const uint8_t *p) { return (uint16_t) (((uint16_t) p[0]) | (((uint16_t) p[1]) << 8)); }\n");
+   fprintf(fp, "APXNODE_INLINE uint32_t ApxNode_unpackU32LE(const uint8_t *p) { return ((uint32_t) p[0]) | (((uint32_t) p[1]) << 8) | (((uint32_t) p[2]) << 16) | (((uint32_t) p[3]) << 24); }\n");
+   fprintf(fp, "APXNODE_INLINE uint64_t ApxNode_unpackU64LE(const uint8_t *p) { return ((uint64_t) ApxNode_unpackU32LE(p)) | (((uint64_t) ApxNode_unpackU32LE(p+4)) << 32); }\n");
+   fprintf(fp, "APXNODE_INLINE void ApxNode_packStr(uint8_t *p, const char *v, uint32_t n) { uint32_t i; for (i = 0u; (i < n) && (v[i] != 0); i++) { p[i] = (uint8_t) v[i]; } for (; i < n; i++) { p[i] = 0u; } }\n");
+   fprintf(fp, "#endif //APXNODE_PACK_FUNCTIONS\n\n");
+}
+
+static void apx_codeGenerator_writePortDefines(FILE *fp, const char *upperNodeName, apx_portDataMap_t *dataMap)
+{
+   int32_t i;
+   int32_t numPorts = apx_portDataMap_getNumEntries(dataMap);
+   for (i=0; i<numPorts; i++)
+   {
+      char upperPortName[APX_CODEGEN_MAX_NAME_LEN];
+      apx_portDataMapEntry_t *entry = apx_portDataMap_getEntry(dataMap, i);
+      apx_codeGenerator_toUpper(upperPortName, entry->port->name, sizeof(upperPortName));
+      fprintf(fp, "#define APXNODE_%s_%s_OFFSET %uu\n", upperNodeName, upperPortName, (unsigned int) entry->offset);
+      fprintf(fp, "#define APXNODE_%s_%s_LEN %uu\n", upperNodeName, upperPortName, (unsigned int) entry->length);
+   }
+   if (numPorts > 0)
+   {
+      fprintf(fp, "\n");
+   }
+}
+
+static void apx_codeGenerator_writeRecordTypes(FILE *fp, const char *nodeName, apx_portDataMap_t *dataMap)
+{
+   int32_t i;
+   int32_t numPorts = apx_portDataMap_getNumEntries(dataMap);
+   for (i=0; i<numPorts; i++)
+   {
+      apx_portDataMapEntry_t *entry = apx_portDataMap_getEntry(dataMap, i);
+      const apx_dataElement_t *dataElement = entry->port->derivedDsg.dataElement;
+      if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+      {
+         fprintf(fp, "typedef struct ApxNode_%s_%s_tag\n{\n", nodeName, entry->port->name);
+         apx_codeGenerator_writeStructFields(fp, dataElement, 1);
+         fprintf(fp, "} ApxNode_%s_%s_T;\n\n", nodeName, entry->port->name);
+      }
+   }
+}
+
+static void apx_codeGenerator_writeStructFields(FILE *fp, const apx_dataElement_t *dataElement, int indent)
+{
+   int32_t i;
+   int32_t numChild = adt_ary_length(dataElement->childElements);
+   for (i=0; i<numChild; i++)
+   {
+      const apx_dataElement_t *child = (const apx_dataElement_t*) *adt_ary_get(dataElement->childElements, i);
+      apx_codeGenerator_writeIndent(fp, indent);
+      if (child->baseType == APX_BASE_TYPE_RECORD)
+      {
+         fprintf(fp, "struct\n");
+         apx_codeGenerator_writeIndent(fp, indent);
+         fprintf(fp, "{\n");
+         apx_codeGenerator_writeStructFields(fp, child, indent+1);
+         apx_codeGenerator_writeIndent(fp, indent);
+         fprintf(fp, "} %s", child->name);
+      }
+      else if (child->baseType == APX_BASE_TYPE_STRING)
+      {
+         fprintf(fp, "char %s", child->name);
+      }
+      else
+      {
+         fprintf(fp, "%s %s", apx_codeGenerator_intTypeName(child->baseType), child->name);
+      }
+      if (child->baseType == APX_BASE_TYPE_STRING)
+      {
+         fprintf(fp, "[%u]", (unsigned int) child->arrayLen + 1u); //room for the null terminator added by Read
+      }
+      else if (child->arrayLen > 0)
+      {
+         fprintf(fp, "[%u]", (unsigned int) child->arrayLen);
+      }
+      fprintf(fp, ";\n");
+   }
+}
+
+/**
+ * writes ApxNode_Read_<node>_<port> (isWrite==0) or ApxNode_Write_<node>_<port> (isWrite==1)
+ */
+static int8_t apx_codeGenerator_writeAccessor(FILE *fp, const char *nodeName, const char *upperNodeName, apx_port_t *port, uint8_t isWrite)
+{
+   char upperPortName[APX_CODEGEN_MAX_NAME_LEN];
+   char typeName[APX_CODEGEN_MAX_NAME_LEN*2+16];
+   const char *lockName = isWrite? "OutPortData" : "InPortData";
+   const char *bufName = isWrite? "outPortData" : "inPortData";
+   const apx_dataElement_t *dataElement = port->derivedDsg.dataElement;
+   apx_codeGenOffset_t offset;
+   int loopDepth;
+   int i;
+   int8_t result;
+
+   apx_codeGenerator_toUpper(upperPortName, port->name, sizeof(upperPortName));
+   if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+   {
+      snprintf(typeName, sizeof(typeName), "ApxNode_%s_%s_T", nodeName, port->name);
+   }
+   else if (dataElement->baseType == APX_BASE_TYPE_STRING)
+   {
+      snprintf(typeName, sizeof(typeName), "char");
+   }
+   else
+   {
+      const char *intTypeName = apx_codeGenerator_intTypeName(dataElement->baseType);
+      if (intTypeName == 0)
+      {
+         apx_setError(APX_UNSUPPORTED_ERROR);
+         return -1;
+      }
+      snprintf(typeName, sizeof(typeName), "%s", intTypeName);
+   }
+   if ( (isWrite != 0) && (dataElement->baseType != APX_BASE_TYPE_RECORD) && (dataElement->baseType != APX_BASE_TYPE_STRING) &&
+        (dataElement->arrayLen == 0) )
+   {
+      //scalar integers are passed by value
+      fprintf(fp, "APXNODE_INLINE void ApxNode_Write_%s_%s(%s val)\n{\n", nodeName, port->name, typeName);
+   }
+   else
+   {
+      if ( (isWrite == 0) && (dataElement->baseType == APX_BASE_TYPE_STRING) )
+      {
+         fprintf(fp, "//val must hold APXNODE_%s_%s_LEN+1 bytes, the string is always null-terminated\n", upperNodeName, upperPortName);
+      }
+      fprintf(fp, "APXNODE_INLINE void ApxNode_%s_%s_%s(%s%s *val)\n{\n", isWrite? "Write" : "Read", nodeName, port->name,
+            isWrite? "const " : "", typeName);
+   }
+   fprintf(fp, "   %suint8_t *p = &ApxNode_%s_%s[APXNODE_%s_%s_OFFSET];\n", isWrite? "" : "const ", nodeName, bufName, upperNodeName, upperPortName);
+   loopDepth = apx_codeGenerator_loopDepth(dataElement);
+   for (i=0; i<loopDepth; i++)
+   {
+      fprintf(fp, "   uint32_t i%d;\n", i);
+   }
+   fprintf(fp, "   apx_nodeData_lock%s(&ApxNode_%s_nodeData);\n", lockName, nodeName);
+   offset.base = 0u;
+   offset.var[0] = '\0';
+   if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+   {
+      if (dataElement->arrayLen > 0)
+      {
+         apx_codeGenOffset_t recordOffset;
+         fprintf(fp, "   for (i0 = 0u; i0 < %uu; i0++)\n   {\n", (unsigned int) dataElement->arrayLen);
+         apx_codeGenerator_addLoopOffset(&recordOffset, &offset, 0, dataElement->packLen / dataElement->arrayLen);
+         result = apx_codeGenerator_writeRecordFields(fp, dataElement, "val[i0].", &recordOffset, 1, isWrite, 2);
+         fprintf(fp, "   }\n");
+      }
+      else
+      {
+         result = apx_codeGenerator_writeRecordFields(fp, dataElement, "val->", &offset, 0, isWrite, 1);
+      }
+   }
+   else if ( (isWrite == 0) && (dataElement->baseType != APX_BASE_TYPE_STRING) && (dataElement->arrayLen == 0) )
+   {
+      result = apx_codeGenerator_writeElement(fp, dataElement, "*val", &offset, 0, isWrite, 1);
+   }
+   else
+   {
+      result = apx_codeGenerator_writeElement(fp, dataElement, "val", &offset, 0, isWrite, 1);
+   }
+   fprintf(fp, "   apx_nodeData_unlock%s(&ApxNode_%s_nodeData);\n", lockName, nodeName);
+   if (isWrite != 0)
+   {
+      fprintf(fp, "   apx_nodeData_outPortDataNotify(&ApxNode_%s_nodeData, APXNODE_%s_%s_OFFSET, APXNODE_%s_%s_LEN);\n",
+            nodeName, upperNodeName, upperPortName, upperNodeName, upperPortName);
+   }
+   fprintf(fp, "}\n\n");
+   return result;
+}
+
+static int8_t apx_codeGenerator_writeElement(FILE *fp, const apx_dataElement_t *dataElement, const char *valExpr, const apx_codeGenOffset_t *offset, int depth, uint8_t isWrite, int indent)
+{
+   char offsetStr[APX_CODEGEN_MAX_EXPR_LEN];
+   if (dataElement->baseType == APX_BASE_TYPE_STRING)
+   {
+      apx_codeGenerator_formatOffset(offsetStr, sizeof(offsetStr), offset);
+      apx_codeGenerator_writeIndent(fp, indent);
+      if (isWrite != 0)
+      {
+         fprintf(fp, "ApxNode_packStr(&p[%s], &%s[0], %uu);\n", offsetStr, valExpr, (unsigned int) dataElement->arrayLen);
+      }
+      else
+      {
+         fprintf(fp, "memcpy(&%s[0], &p[%s], %uu);\n", valExpr, offsetStr, (unsigned int) dataElement->arrayLen);
+         apx_codeGenerator_writeIndent(fp, indent);
+         fprintf(fp, "%s[%uu] = '\\0';\n", valExpr, (unsigned int) dataElement->arrayLen);
+      }
+      return 0;
+   }
+   else if (depth >= APX_PACK_PROGRAM_MAX_DEPTH)
+   {
+      apx_setError(APX_UNSUPPORTED_ERROR);
+      return -1;
+   }
+   else if (dataElement->arrayLen > 0)
+   {
+      int8_t result;
+      char elemExpr[APX_CODEGEN_MAX_EXPR_LEN];
+      apx_codeGenOffset_t elemOffset;
+      uint32_t stride = dataElement->packLen / dataElement->arrayLen;
+      apx_codeGenerator_writeIndent(fp, indent);
+      fprintf(fp, "for (i%d = 0u; i%d < %uu; i%d++)\n", depth, depth, (unsigned int) dataElement->arrayLen, depth);
+      apx_codeGenerator_writeIndent(fp, indent);
+      fprintf(fp, "{\n");
+      snprintf(elemExpr, sizeof(elemExpr), "%s[i%d]", valExpr, depth);
+      apx_codeGenerator_addLoopOffset(&elemOffset, offset, depth, stride);
+      if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+      {
+         char prefix[APX_CODEGEN_MAX_EXPR_LEN];
+         snprintf(prefix, sizeof(prefix), "%s.", elemExpr);
+         result = apx_codeGenerator_writeRecordFields(fp, dataElement, prefix, &elemOffset, depth+1, isWrite, indent+1);
+      }
+      else
+      {
+         result = apx_codeGenerator_writeIntValue(fp, dataElement, elemExpr, &elemOffset, isWrite, indent+1);
+      }
+      apx_codeGenerator_writeIndent(fp, indent);
+      fprintf(fp, "}\n");
+      return result;
+   }
+   else if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+   {
+      char prefix[APX_CODEGEN_MAX_EXPR_LEN];
+      snprintf(prefix, sizeof(prefix), "%s.", valExpr);
+      return apx_codeGenerator_writeRecordFields(fp, dataElement, prefix, offset, depth, isWrite, indent);
+   }
+   return apx_codeGenerator_writeIntValue(fp, dataElement, valExpr, offset, isWrite, indent);
+}
+
+static int8_t apx_codeGenerator_writeRecordFields(FILE *fp, const apx_dataElement_t *dataElement, const char *prefix, const apx_codeGenOffset_t *offset, int depth, uint8_t isWrite, int indent)
+{
+   int32_t i;
+   int32_t numChild = adt_ary_length(dataElement->childElements);
+   apx_codeGenOffset_t childOffset;
+   memcpy(&childOffset, offset, sizeof(apx_codeGenOffset_t));
+   for (i=0; i<numChild; i++)
+   {
+      char childExpr[APX_CODEGEN_MAX_EXPR_LEN];
+      const apx_dataElement_t *child = (const apx_dataElement_t*) *adt_ary_get(dataElement->childElements, i);
+      snprintf(childExpr, sizeof(childExpr), "%s%s", prefix, child->name);
+      if (apx_codeGenerator_writeElement(fp, child, childExpr, &childOffset, depth, isWrite, indent) != 0)
+      {
+         return -1;
+      }
+      childOffset.base += child->packLen;
+   }
+   return 0;
+}
+
+static int8_t apx_codeGenerator_writeIntValue(FILE *fp, const apx_dataElement_t *dataElement, const char *valExpr, const apx_codeGenOffset_t *offset, uint8_t isWrite, int indent)
+{
+   char offsetStr[APX_CODEGEN_MAX_EXPR_LEN];
+   const char *typeName = apx_codeGenerator_intTypeName(dataElement->baseType);
+   uint8_t width = apx_codeGenerator_intWidth(dataElement->baseType);
+   const char *suffix;
+   if (typeName == 0)
+   {
+      apx_setError(APX_UNSUPPORTED_ERROR);
+      return -1;
+   }
+   switch(width)
+   {
+   case 1:
+      suffix = "U8";
+      break;
+   case 2:
+      suffix = "U16LE";
+      break;
+   case 4:
+      suffix = "U32LE";
+      break;
+   default:
+      suffix = "U64LE";
+      break;
+   }
+   apx_codeGenerator_formatOffset(offsetStr, sizeof(offsetStr), offset);
+   apx_codeGenerator_writeIndent(fp, indent);
+   if (isWrite != 0)
+   {
+      fprintf(fp, "ApxNode_pack%s(&p[%s], (uint%d_t) %s);\n", suffix, offsetStr, width*8, valExpr);
+   }
+   else
+   {
+      if (apx_codeGenerator_isSigned(dataElement->baseType) != 0)
+      {
+         fprintf(fp, "%s = (%s) ApxNode_unpack%s(&p[%s]);\n", valExpr, typeName, suffix, offsetStr);
+      }
+      else
+      {
+         fprintf(fp, "%s = ApxNode_unpack%s(&p[%s]);\n", valExpr, suffix, offsetStr);
+      }
+   }
+   return 0;
+}
+
+static void apx_codeGenerator_writeInitData(FILE *fp, const char *varName, const char *lenMacro, const uint8_t *data, uint32_t len)
+{
+   uint32_t i;
+   fprintf(fp, "static const uint8_t %s[%s]= {\n", varName, lenMacro);
+   for (i=0; i<len; i++)
+   {
+      if ( (i % APX_CODEGEN_INIT_DATA_PER_LINE) == 0)
+      {
+         fprintf(fp, "   ");
+      }
+      fprintf(fp, "%u", (unsigned int) data[i]);
+      if (i+1 < len)
+      {
+         fprintf(fp, ((i % APX_CODEGEN_INIT_DATA_PER_LINE) == (APX_CODEGEN_INIT_DATA_PER_LINE-1))? ",\n" : ", ");
+      }
+   }
+   fprintf(fp, "\n};\n");
+}
+
+/**
+ * writes definition text as a C string literal, one literal per line of text
+ */
+static void apx_codeGenerator_writeDefinitionText(FILE *fp, const char *text, uint32_t len)
+{
+   uint32_t i;
+   uint8_t lineOpen = 0;
+   for (i=0; i<len; i++)
+   {
+      char c = text[i];
+      if (lineOpen == 0)
+      {
+         fprintf(fp, "\"");
+         lineOpen = 1;
+      }
+      if (c == '\n')
+      {
+         fprintf(fp, "\\n\"\n");
+         lineOpen = 0;
+      }
+      else if ( (c == '"') || (c == '\\') )
+      {
+         fprintf(fp, "\\%c", c);
+      }
+      else if ( (c < ' ') || (c > '~') )
+      {
+         //octal escape sequences are at most three digits long, which is not the case for hex escape sequences
+         fprintf(fp, "\\%03o", (unsigned int) (uint8_t) c);
+      }
+      else
+      {
+         fputc(c, fp);
+      }
+   }
+   if (lineOpen != 0)
+   {
+      fprintf(fp, "\"\n");
+   }
+   else if (len == 0)
+   {
+      fprintf(fp, "\"\"\n");
+   }
+   fprintf(fp, ";\n");
+}
+
+static void apx_codeGenerator_writeIndent(FILE *fp, int indent)
+{
+   int i;
+   for (i=0; i<indent; i++)
+   {
+      fprintf(fp, "   ");
+   }
+}
+
+static void apx_codeGenerator_formatOffset(char *buf, size_t bufLen, const apx_codeGenOffset_t *offset)
+{
+   if (offset->var[0] == '\0')
+   {
+      snprintf(buf, bufLen, "%uu", (unsigned int) offset->base);
+   }
+   else if (offset->base == 0u)
+   {
+      snprintf(buf, bufLen, "%s", offset->var);
+   }
+   else
+   {
+      snprintf(buf, bufLen, "%s + %uu", offset->var, (unsigned int) offset->base);
+   }
+}
+
+static void apx_codeGenerator_addLoopOffset(apx_codeGenOffset_t *dest, const apx_codeGenOffset_t *src, int depth, uint32_t stride)
+{
+   dest->base = src->base;
+   if (src->var[0] == '\0')
+   {
+      snprintf(dest->var, sizeof(dest->var), "i%d*%uu", depth, (unsigned int) stride);
+   }
+   else
+   {
+      snprintf(dest->var, sizeof(dest->var), "%s + i%d*%uu", src->var, depth, (unsigned int) stride);
+   }
+}
+
+static void apx_codeGenerator_toUpper(char *dest, const char *src, size_t destLen)
+{
+   size_t i;
+   for (i=0; (i+1<destLen) && (src[i] != '\0'); i++)
+   {
+      dest[i] = (char) toupper((unsigned char) src[i]);
+   }
+   dest[i] = '\0';
+}
+
+/**
+ * returns the number of nested loop variables needed to visit all values of dataElement
+ */
+static int apx_codeGenerator_loopDepth(const apx_dataElement_t *dataElement)
+{
+   int depth = 0;
+   if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+   {
+      int32_t i;
+      int32_t numChild = adt_ary_length(dataElement->childElements);
+      for (i=0; i<numChild; i++)
+      {
+         int childDepth = apx_codeGenerator_loopDepth((const apx_dataElement_t*) *adt_ary_get(dataElement->childElements, i));
+         if (childDepth > depth)
+         {
+            depth = childDepth;
+         }
+      }
+   }
+   if ( (dataElement->arrayLen > 0) && (dataElement->baseType != APX_BASE_TYPE_STRING) )
+   {
+      depth++;
+   }
+   return depth;
+}
+
+static const char *apx_codeGenerator_intTypeName(int8_t baseType)
+{
+   switch(baseType)
+   {
+   case APX_BASE_TYPE_UINT8:
+      return "uint8_t";
+   case APX_BASE_TYPE_UINT16:
+      return "uint16_t";
+   case APX_BASE_TYPE_UINT32:
+      return "uint32_t";
+   case APX_BASE_TYPE_UINT64:
+      return "uint64_t";
+   case APX_BASE_TYPE_SINT8:
+      return "int8_t";
+   case APX_BASE_TYPE_SINT16:
+      return "int16_t";
+   case APX_BASE_TYPE_SINT32:
+      return "int32_t";
+   case APX_BASE_TYPE_SINT64:
+      return "int64_t";
+   default:
+      break;
+   }
+   return (const char*) 0;
+}
+
+static uint8_t apx_codeGenerator_intWidth(int8_t baseType)
+{
+   switch(baseType)
+   {
+   case APX_BASE_TYPE_UINT8:
+   case APX_BASE_TYPE_SINT8:
+      return 1u;
+   case APX_BASE_TYPE_UINT16:
+   case APX_BASE_TYPE_SINT16:
+      return 2u;
+   case APX_BASE_TYPE_UINT32:
+   case APX_BASE_TYPE_SINT32:
+      return 4u;
+   case APX_BASE_TYPE_UINT64:
+   case APX_BASE_TYPE_SINT64:
+      return 8u;
+   default:
+      break;
+   }
+   return 0u;
+}
+
+static uint8_t apx_codeGenerator_isSigned(int8_t baseType)
+{
+   return ( (baseType >= APX_BASE_TYPE_SINT8) && (baseType <= APX_BASE_TYPE_SINT64) )? 1u : 0u;
+}
@@ -0,0 +1,279 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include "apx_fileTableGenerator.h"
+#include "apx_file.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+//address layout, must match apx_es_fileMap.c
+#define PORT_DATA_START      0x0u
+#define PORT_DATA_BOUNDARY   0x400u //1KB, this must be a power of 2
+#define DEFINITION_START     0x4000000 //64MB, this must be a power of 2
+#define DEFINITION_BOUNDARY  0x100000u //1MB, this must be a power of 2
+#define USER_DATA_START      0x20000000 //512MB, this must be a power of 2
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static int8_t apx_fileTableGenerator_placeFile(uint32_t *endAddress, uint32_t length, uint32_t areaEnd, uint32_t boundary, uint32_t *address);
+static void apx_fileTableGenerator_writeFile(FILE *fp, const char *nodeName, const char *fileVar, uint32_t address,
+                                             const char *lenMacro, const char *ext, const char *fileType);
+static void apx_fileTableGenerator_toUpper(char *dest, const char *src, size_t destLen);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int8_t apx_fileTableGenerator_create(apx_fileTableGenerator_t *self, const char *tableName)
+{
+   if ( (self != 0) && (tableName != 0) && (tableName[0] != '\0') && (strlen(tableName) < sizeof(self->tableName)) )
+   {
+      strcpy(self->tableName, tableName);
+      self->numNodes = 0;
+      self->numFiles = 0;
+      self->outDataEndAddress = PORT_DATA_START;
+      self->definitionEndAddress = DEFINITION_START;
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * Adds the local files of a node to the table. Files are placed in the order the nodes are added, this gives the same
+ * addresses as calling apx_es_fileMap_autoInsert for the out port data file and definition file of each node in that order.
+ */
+int8_t apx_fileTableGenerator_addNode(apx_fileTableGenerator_t *self, const char *nodeName, uint32_t outPortDataLen, uint32_t definitionLen)
+{
+   if ( (self != 0) && (nodeName != 0) && (definitionLen > 0u) )
+   {
+      apx_fileTableNode_t *node;
+      size_t nameLen = strlen(nodeName);
+      if ( (nameLen >= sizeof(node->nodeName)) || ( (nameLen + APX_MAX_FILE_EXT_LEN) > RMF_MAX_FILE_NAME) )
+      {
+         errno = EINVAL;
+         return -1;
+      }
+      if (self->numNodes >= APX_FILETABLE_MAX_NUM_NODES)
+      {
+         errno = ENOMEM;
+         return -1;
+      }
+      node = &self->nodes[self->numNodes];
+      strcpy(node->nodeName, nodeName);
+      node->outPortDataLen = outPortDataLen;
+      node->definitionLen = definitionLen;
+      node->outDataAddress = RMF_INVALID_ADDRESS;
+      if (outPortDataLen > 0u)
+      {
+         if (apx_fileTableGenerator_placeFile(&self->outDataEndAddress, outPortDataLen, DEFINITION_START, PORT_DATA_BOUNDARY, &node->outDataAddress) != 0)
+         {
+            return -1;
+         }
+         self->numFiles++;
+      }
+      if (apx_fileTableGenerator_placeFile(&self->definitionEndAddress, definitionLen, USER_DATA_START, DEFINITION_BOUNDARY, &node->definitionAddress) != 0)
+      {
+         return -1;
+      }
+      self->numFiles++;
+      self->numNodes++;
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+int8_t apx_fileTableGenerator_writeHeader(apx_fileTableGenerator_t *self, FILE *fp)
+{
+   if ( (self != 0) && (fp != 0) )
+   {
+      int32_t i;
+      char upperTableName[APX_CODEGEN_MAX_NAME_LEN];
+      char upperNodeName[APX_CODEGEN_MAX_NAME_LEN];
+      const char *tableName = self->tableName;
+      apx_fileTableGenerator_toUpper(upperTableName, tableName, sizeof(upperTableName));
+
+      fprintf(fp, "#ifndef APXFILETABLE_%s_H\n", upperTableName);
+      fprintf(fp, "#define APXFILETABLE_%s_H\n\n", upperTableName);
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// INCLUDES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "#include <stdint.h>\n");
+      fprintf(fp, "#include \"apx_file.h\"\n");
+      fprintf(fp, "#include \"apx_es_fileManager.h\"\n\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// CONSTANTS AND DATA TYPES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "#define APXFILETABLE_%s_NUM_FILES %uu\n", upperTableName, (unsigned int) self->numFiles);
+      for (i=0; i<self->numNodes; i++)
+      {
+         apx_fileTableNode_t *node = &self->nodes[i];
+         apx_fileTableGenerator_toUpper(upperNodeName, node->nodeName, sizeof(upperNodeName));
+         if (node->outPortDataLen > 0u)
+         {
+            fprintf(fp, "#define APXFILETABLE_%s_%s_OUT_DATA_ADDRESS 0x%08Xu\n", upperTableName, upperNodeName, (unsigned int) node->outDataAddress);
+         }
+         fprintf(fp, "#define APXFILETABLE_%s_%s_DEFINITION_ADDRESS 0x%08Xu\n", upperTableName, upperNodeName, (unsigned int) node->definitionAddress);
+      }
+      fprintf(fp, "\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// GLOBAL VARIABLES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      for (i=0; i<self->numNodes; i++)
+      {
+         apx_fileTableNode_t *node = &self->nodes[i];
+         if (node->outPortDataLen > 0u)
+         {
+            fprintf(fp, "extern apx_file_t ApxFileTable_%s_%s_outDataFile;\n", tableName, node->nodeName);
+         }
+         fprintf(fp, "extern apx_file_t ApxFileTable_%s_%s_definitionFile;\n", tableName, node->nodeName);
+      }
+      fprintf(fp, "extern apx_file_t * const ApxFileTable_%s_files[APXFILETABLE_%s_NUM_FILES];\n\n", tableName, upperTableName);
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// FUNCTION PROTOTYPES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "int8_t ApxFileTable_Init_%s(apx_es_fileManager_t *fileManager);\n\n", tableName);
+      fprintf(fp, "#endif //APXFILETABLE_%s_H\n", upperTableName);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+int8_t apx_fileTableGenerator_writeSource(apx_fileTableGenerator_t *self, FILE *fp, const char *headerName)
+{
+   if ( (self != 0) && (fp != 0) && (headerName != 0) )
+   {
+      int32_t i;
+      char upperTableName[APX_CODEGEN_MAX_NAME_LEN];
+      char upperNodeName[APX_CODEGEN_MAX_NAME_LEN];
+      char lenMacro[APX_CODEGEN_MAX_NAME_LEN+32];
+      char fileVar[APX_CODEGEN_MAX_NAME_LEN*2+32];
+      const char *tableName = self->tableName;
+      apx_fileTableGenerator_toUpper(upperTableName, tableName, sizeof(upperTableName));
+
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// INCLUDES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "#include \"%s\"\n", headerName);
+      for (i=0; i<self->numNodes; i++)
+      {
+         fprintf(fp, "#include \"ApxNode_%s.h\"\n", self->nodes[i].nodeName);
+      }
+      fprintf(fp, "\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// GLOBAL VARIABLES\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      for (i=0; i<self->numNodes; i++)
+      {
+         apx_fileTableNode_t *node = &self->nodes[i];
+         apx_fileTableGenerator_toUpper(upperNodeName, node->nodeName, sizeof(upperNodeName));
+         if (node->outPortDataLen > 0u)
+         {
+            snprintf(fileVar, sizeof(fileVar), "ApxFileTable_%s_%s_outDataFile", tableName, node->nodeName);
+            snprintf(lenMacro, sizeof(lenMacro), "APXNODE_%s_OUT_PORT_DATA_LEN", upperNodeName);
+            apx_fileTableGenerator_writeFile(fp, node->nodeName, fileVar, node->outDataAddress, lenMacro, APX_OUTDATA_FILE_EXT, "APX_OUTDATA_FILE");
+         }
+         snprintf(fileVar, sizeof(fileVar), "ApxFileTable_%s_%s_definitionFile", tableName, node->nodeName);
+         snprintf(lenMacro, sizeof(lenMacro), "APXNODE_%s_DEFINITION_LEN", upperNodeName);
+         apx_fileTableGenerator_writeFile(fp, node->nodeName, fileVar, node->definitionAddress, lenMacro, APX_DEFINITION_FILE_EXT, "APX_DEFINITION_FILE");
+      }
+      //out port data files are placed below all definition files, node order is kept within each area
+      fprintf(fp, "apx_file_t * const ApxFileTable_%s_files[APXFILETABLE_%s_NUM_FILES] =\n{\n", tableName, upperTableName);
+      for (i=0; i<self->numNodes; i++)
+      {
+         if (self->nodes[i].outPortDataLen > 0u)
+         {
+            fprintf(fp, "   &ApxFileTable_%s_%s_outDataFile,\n", tableName, self->nodes[i].nodeName);
+         }
+      }
+      for (i=0; i<self->numNodes; i++)
+      {
+         fprintf(fp, "   &ApxFileTable_%s_%s_definitionFile,\n", tableName, self->nodes[i].nodeName);
+      }
+      fprintf(fp, "};\n\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "// GLOBAL FUNCTIONS\n");
+      fprintf(fp, "//////////////////////////////////////////////////////////////////////////////\n");
+      fprintf(fp, "int8_t ApxFileTable_Init_%s(apx_es_fileManager_t *fileManager)\n{\n", tableName);
+      for (i=0; i<self->numNodes; i++)
+      {
+         apx_fileTableNode_t *node = &self->nodes[i];
+         fprintf(fp, "   ApxNode_Init_%s();\n", node->nodeName);
+         if (node->outPortDataLen > 0u)
+         {
+            fprintf(fp, "   apx_nodeData_setOutPortDataFile(&ApxNode_%s_nodeData, &ApxFileTable_%s_%s_outDataFile);\n", node->nodeName, tableName, node->nodeName);
+         }
+         fprintf(fp, "   apx_nodeData_setFileManager(&ApxNode_%s_nodeData, fileManager);\n", node->nodeName);
+      }
+      fprintf(fp, "   return apx_es_fileManager_setLocalFileTable(fileManager, &ApxFileTable_%s_files[0], APXFILETABLE_%s_NUM_FILES);\n", tableName, upperTableName);
+      fprintf(fp, "}\n\n");
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * places a file of length bytes at the next boundary after *endAddress and moves *endAddress to the end of the file
+ */
+static int8_t apx_fileTableGenerator_placeFile(uint32_t *endAddress, uint32_t length, uint32_t areaEnd, uint32_t boundary, uint32_t *address)
+{
+   uint32_t placementAddress = (*endAddress + (boundary-1u)) & (~(boundary-1u));
+   if ( (placementAddress >= areaEnd) || (length > (areaEnd - placementAddress)) )
+   {
+      errno = ENOMEM;
+      return -1;
+   }
+   *address = placementAddress;
+   *endAddress = placementAddress + length;
+   return 0;
+}
+
+static void apx_fileTableGenerator_writeFile(FILE *fp, const char *nodeName, const char *fileVar, uint32_t address,
+                                             const char *lenMacro, const char *ext, const char *fileType)
+{
+   fprintf(fp, "apx_file_t %s =\n{\n", fileVar);
+   fprintf(fp, "   .isRemoteFile = false,\n");
+   fprintf(fp, "   .nodeData = &ApxNode_%s_nodeData,\n", nodeName);
+   fprintf(fp, "   .fileInfo = {\n");
+   fprintf(fp, "      .address = 0x%08Xu,\n", (unsigned int) address);
+   fprintf(fp, "      .length = %s,\n", lenMacro);
+   fprintf(fp, "      .fileType = RMF_FILE_TYPE_FIXED,\n");
+   fprintf(fp, "      .digestType = RMF_DIGEST_TYPE_NONE,\n");
+   fprintf(fp, "      .name = \"%s%s\"\n", nodeName, ext);
+   fprintf(fp, "   },\n");
+   fprintf(fp, "   .fileType = %s,\n", fileType);
+   fprintf(fp, "   .isOpen = false\n");
+   fprintf(fp, "};\n\n");
+}
+
+static void apx_fileTableGenerator_toUpper(char *dest, const char *src, size_t destLen)
+{
+   size_t i;
+   for (i=0; (i+1<destLen) && (src[i] != '\0'); i++)
+   {
+      dest[i] = (char) toupper((unsigned char) src[i]);
+   }
+   dest[i] = '\0';
+}
@@ -0,0 +1,361 @@
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "apx_codeGenerator.h"
+#include "apx_fileTableGenerator.h"
+#include "apx_parser.h"
+#include "apx_binaryDefinition.h"
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_PATH_LEN 1024
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static int parse_args(int argc, char **argv);
+static void printUsage(char *name);
+static char *readTextFile(const char *filename, uint32_t *len);
+static int processFile(const char *inputFile, apx_fileTableGenerator_t *tableGenerator);
+static int generateFiles(apx_codeGenerator_t *generator, const char *nodeName);
+static int generateFileTable(apx_fileTableGenerator_t *tableGenerator);
+static int generateBinaryDefinition(apx_node_t *node, const char *definitionText, uint32_t definitionLen);
+static int checkBinaryDefinition(const char *nodeName, const char *definitionText, uint32_t definitionLen);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+int8_t g_debug; // Global so apx_logging can use it from everywhere
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_inputFiles[APX_FILETABLE_MAX_NUM_NODES];
+static int m_numInputFiles;
+static const char *m_outputDir;
+static const char *m_tableName;
+static int m_generateBinary;
+static int m_checkBinary;
+static const char *SW_VERSION_STR = SW_VERSION_LITERAL;
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+   int retval = 0;
+   int i;
+   apx_fileTableGenerator_t *tableGenerator = 0;
+   g_debug = 0;
+   m_numInputFiles = 0;
+   m_outputDir = ".";
+   m_tableName = 0;
+   m_generateBinary = 0;
+   m_checkBinary = 0;
+   printf("APX Code Generator %s\n", SW_VERSION_STR);
+   if (parse_args(argc, argv) != 0)
+   {
+      return 1;
+   }
+   if ( (m_numInputFiles == 0) || ( (m_numInputFiles > 1) && (m_tableName == 0) ) )
+   {
+      printUsage(argv[0]);
+      return 1;
+   }
+   if (m_tableName != 0)
+   {
+      tableGenerator = (apx_fileTableGenerator_t*) malloc(sizeof(apx_fileTableGenerator_t));
+      if ( (tableGenerator == 0) || (apx_fileTableGenerator_create(tableGenerator, m_tableName) != 0) )
+      {
+         printf("Invalid table name %s\n", m_tableName);
+         free(tableGenerator);
+         return 1;
+      }
+   }
+   for (i=0; (i<m_numInputFiles) && (retval == 0); i++)
+   {
+      retval = processFile(m_inputFiles[i], tableGenerator);
+   }
+   if ( (retval == 0) && (tableGenerator != 0) && (m_checkBinary == 0) )
+   {
+      retval = generateFileTable(tableGenerator);
+   }
+   free(tableGenerator);
+   return retval;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static int parse_args(int argc, char **argv)
+{
+   int i;
+   for(i=1;i<argc;i++)
+   {
+      if (strncmp(argv[i],"-o=",3)==0)
+      {
+         m_outputDir = &argv[i][3];
+      }
+      else if (strncmp(argv[i],"-o",2)==0)
+      {
+         m_outputDir = &argv[i][2];
+      }
+      else if (strcmp(argv[i],"-b")==0)
+      {
+         m_generateBinary = 1;
+      }
+      else if (strcmp(argv[i],"-c")==0)
+      {
+         m_checkBinary = 1;
+      }
+      else if (strncmp(argv[i],"-t=",3)==0)
+      {
+         m_tableName = &argv[i][3];
+      }
+      else if (strncmp(argv[i],"-t",2)==0)
+      {
+         m_tableName = &argv[i][2];
+      }
+      else if (strncmp(argv[i], "-h", 2) == 0)
+      {
+         printUsage(argv[0]);
+         return -1;
+      }
+      else if (argv[i][0] != '-')
+      {
+         if (m_numInputFiles >= APX_FILETABLE_MAX_NUM_NODES)
+         {
+            printf("Too many input files\n");
+            return -1;
+         }
+         m_inputFiles[m_numInputFiles++] = argv[i];
+      }
+      else
+      {
+         printf("Unknown argument %s\n", argv[i]);
+         printUsage(argv[0]);
+         return -1;
+      }
+   }
+   return 0;
+}
+
+static void printUsage(char *name)
+{
+   printf("%s <file.apx> [-o<output directory>] [-b]\n",name);
+   printf("%s <file1.apx> [<file2.apx> ...] -c [-o<output directory>]\n",name);
+   printf("%s <file1.apx> [<file2.apx> ...] -t<table name> [-o<output directory>] [-b]\n",name);
+   printf("   -b: also write precompiled binary definition <node>.apb\n");
+   printf("   -c: only check that <node>.apb in the output directory was compiled from <file.apx>, nothing is written\n");
+   printf("   -t: also write ApxFileTable_<table name>.h/.c, the local files of all nodes with precomputed addresses for apx-es\n");
+}
+
+static char *readTextFile(const char *filename, uint32_t *len)
+{
+   char *data = 0;
+   long fileLen;
+   FILE *fp = fopen(filename, "rb");
+   if (fp == 0)
+   {
+      return 0;
+   }
+   if ( (fseek(fp, 0, SEEK_END) == 0) && ( (fileLen = ftell(fp)) >= 0) && (fseek(fp, 0, SEEK_SET) == 0) )
+   {
+      data = (char*) malloc( (size_t) fileLen + 1);
+      if (data != 0)
+      {
+         if (fread(data, 1, (size_t) fileLen, fp) != (size_t) fileLen)
+         {
+            free(data);
+            data = 0;
+         }
+         else
+         {
+            data[fileLen] = '\0';
+            *len = (uint32_t) fileLen;
+         }
+      }
+   }
+   fclose(fp);
+   return data;
+}
+
+static int processFile(const char *inputFile, apx_fileTableGenerator_t *tableGenerator)
+{
+   int retval = 0;
+   apx_parser_t parser;
+   apx_node_t *node;
+   apx_codeGenerator_t generator;
+   char *definitionText;
+   uint32_t definitionLen = 0;
+   definitionText = readTextFile(inputFile, &definitionLen);
+   if (definitionText == 0)
+   {
+      printf("Failed to read %s\n", inputFile);
+      return 1;
+   }
+   apx_parser_create(&parser);
+   apx_codeGenerator_create(&generator);
+   node = apx_parser_parseFile(&parser, inputFile);
+   if (node == 0)
+   {
+      printf("Failed to parse %s\n", inputFile);
+      retval = 1;
+   }
+   else if (apx_parser_getNumNodes(&parser) != 1)
+   {
+      printf("%s must contain exactly one node\n", inputFile);
+      retval = 1;
+   }
+   else if (apx_codeGenerator_setNode(&generator, node, definitionText, definitionLen) != 0)
+   {
+      printf("Failed to process node %s\n", node->name);
+      retval = 1;
+   }
+   else if (m_checkBinary != 0)
+   {
+      retval = checkBinaryDefinition(node->name, definitionText, definitionLen);
+   }
+   else
+   {
+      retval = generateFiles(&generator, node->name);
+      if ( (retval == 0) && (m_generateBinary != 0) )
+      {
+         retval = generateBinaryDefinition(node, definitionText, definitionLen);
+      }
+      if ( (retval == 0) && (tableGenerator != 0) &&
+           (apx_fileTableGenerator_addNode(tableGenerator, node->name, apx_node_getOutPortDataLen(node), definitionLen) != 0) )
+      {
+         printf("Failed to add node %s to file table\n", node->name);
+         retval = 1;
+      }
+   }
+   apx_codeGenerator_destroy(&generator);
+   apx_parser_destroy(&parser);
+   free(definitionText);
+   return retval;
+}
+
+static int generateFiles(apx_codeGenerator_t *generator, const char *nodeName)
+{
+   int retval = 0;
+   char headerName[MAX_PATH_LEN];
+   char path[MAX_PATH_LEN];
+   FILE *fp;
+   snprintf(headerName, sizeof(headerName), "ApxNode_%s.h", nodeName);
+   snprintf(path, sizeof(path), "%s/%s", m_outputDir, headerName);
+   fp = fopen(path, "w");
+   if ( (fp == 0) || (apx_codeGenerator_writeHeader(generator, fp) != 0) )
+   {
+      printf("Failed to write %s\n", path);
+      retval = 1;
+   }
+   if (fp != 0)
+   {
+      fclose(fp);
+   }
+   if (retval == 0)
+   {
+      snprintf(path, sizeof(path), "%s/ApxNode_%s.c", m_outputDir, nodeName);
+      fp = fopen(path, "w");
+      if ( (fp == 0) || (apx_codeGenerator_writeSource(generator, fp, headerName) != 0) )
+      {
+         printf("Failed to write %s\n", path);
+         retval = 1;
+      }
+      if (fp != 0)
+      {
+         fclose(fp);
+      }
+   }
+   return retval;
+}
+
+static int generateFileTable(apx_fileTableGenerator_t *tableGenerator)
+{
+   int retval = 0;
+   char headerName[MAX_PATH_LEN];
+   char path[MAX_PATH_LEN];
+   FILE *fp;
+   snprintf(headerName, sizeof(headerName), "ApxFileTable_%s.h", tableGenerator->tableName);
+   snprintf(path, sizeof(path), "%s/%s", m_outputDir, headerName);
+   fp = fopen(path, "w");
+   if ( (fp == 0) || (apx_fileTableGenerator_writeHeader(tableGenerator, fp) != 0) )
+   {
+      printf("Failed to write %s\n", path);
+      retval = 1;
+   }
+   if (fp != 0)
+   {
+      fclose(fp);
+   }
+   if (retval == 0)
+   {
+      snprintf(path, sizeof(path), "%s/ApxFileTable_%s.c", m_outputDir, tableGenerator->tableName);
+      fp = fopen(path, "w");
+      if ( (fp == 0) || (apx_fileTableGenerator_writeSource(tableGenerator, fp, headerName) != 0) )
+      {
+         printf("Failed to write %s\n", path);
+         retval = 1;
+      }
+      if (fp != 0)
+      {
+         fclose(fp);
+      }
+   }
+   return retval;
+}
+
+static int generateBinaryDefinition(apx_node_t *node, const char *definitionText, uint32_t definitionLen)
+{
+   int retval = 0;
+   char path[MAX_PATH_LEN];
+   uint32_t binaryLen = 0;
+   uint8_t *binaryData;
+   FILE *fp;
+   binaryData = apx_binaryDefinition_compile(node, (const uint8_t*) definitionText, definitionLen, &binaryLen);
+   if (binaryData == 0)
+   {
+      printf("Failed to compile binary definition of node %s\n", node->name);
+      return 1;
+   }
+   snprintf(path, sizeof(path), "%s/%s.apb", m_outputDir, node->name);
+   fp = fopen(path, "wb");
+   if ( (fp == 0) || (fwrite(binaryData, 1, binaryLen, fp) != binaryLen) )
+   {
+      printf("Failed to write %s\n", path);
+      retval = 1;
+   }
+   if (fp != 0)
+   {
+      fclose(fp);
+   }
+   free(binaryData);
+   return retval;
+}
+
+static int checkBinaryDefinition(const char *nodeName, const char *definitionText, uint32_t definitionLen)
+{
+   int retval = 0;
+   char path[MAX_PATH_LEN];
+   uint32_t binaryLen = 0;
+   char *binaryData;
+   snprintf(path, sizeof(path), "%s/%s.apb", m_outputDir, nodeName);
+   binaryData = readTextFile(path, &binaryLen);
+   if (binaryData == 0)
+   {
+      printf("Failed to read %s\n", path);
+      return 1;
+   }
+   if (apx_binaryDefinition_verifyText((const uint8_t*) binaryData, binaryLen, (const uint8_t*) definitionText, definitionLen) != 0)
+   {
+      printf("%s was not compiled from the current APX definition of node %s\n", path, nodeName);
+      retval = 1;
+   }
+   free(binaryData);
+   return retval;
+}
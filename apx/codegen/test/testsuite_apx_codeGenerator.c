@@ -0,0 +1,227 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_codeGenerator.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_OUTPUT_LEN 16384
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_codeGenerator_initData(CuTest* tc);
+static void test_apx_codeGenerator_header(CuTest* tc);
+static void test_apx_codeGenerator_records(CuTest* tc);
+static void test_apx_codeGenerator_source(CuTest* tc);
+static void test_apx_codeGenerator_strings(CuTest* tc);
+static void createTestNode(apx_node_t *node);
+static char *readOutput(FILE *fp);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_definitionText =
+"APX/1.2\n"
+"N\"TestNode\"\n"
+"R\"VehicleSpeed\"S:=0xFFFF\n"
+"R\"Temperatures\"s[2]:={-1, 2}\n"
+"P\"EngineStatus\"C:=3\n"
+"P\"Location\"{\"Id\"L\"Name\"a[4]\"Pos\"S[2]}\n"
+"\n";
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_codeGenerator(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_codeGenerator_initData);
+   SUITE_ADD_TEST(suite, test_apx_codeGenerator_header);
+   SUITE_ADD_TEST(suite, test_apx_codeGenerator_records);
+   SUITE_ADD_TEST(suite, test_apx_codeGenerator_source);
+   SUITE_ADD_TEST(suite, test_apx_codeGenerator_strings);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_codeGenerator_initData(CuTest* tc)
+{
+   apx_node_t node;
+   apx_codeGenerator_t generator;
+   const uint8_t *data;
+   createTestNode(&node);
+   apx_codeGenerator_create(&generator);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_setNode(&generator, &node, m_definitionText, (uint32_t) strlen(m_definitionText)));
+   CuAssertUIntEquals(tc, 6, apx_node_getInPortDataLen(&node));
+   data = apx_node_getInPortInitData(&node);
+   CuAssertUIntEquals(tc, 0xFF, data[0]);
+   CuAssertUIntEquals(tc, 0xFF, data[1]);
+   CuAssertUIntEquals(tc, 0xFF, data[2]);
+   CuAssertUIntEquals(tc, 0xFF, data[3]);
+   CuAssertUIntEquals(tc, 0x02, data[4]);
+   CuAssertUIntEquals(tc, 0x00, data[5]);
+   CuAssertUIntEquals(tc, 13, apx_node_getOutPortDataLen(&node));
+   data = apx_node_getOutPortInitData(&node);
+   CuAssertUIntEquals(tc, 3, data[0]);
+   CuAssertUIntEquals(tc, 0, data[1]);
+   apx_codeGenerator_destroy(&generator);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_codeGenerator_header(CuTest* tc)
+{
+   apx_node_t node;
+   apx_codeGenerator_t generator;
+   FILE *fp;
+   char *output;
+   createTestNode(&node);
+   apx_codeGenerator_create(&generator);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_setNode(&generator, &node, m_definitionText, (uint32_t) strlen(m_definitionText)));
+   fp = tmpfile();
+   CuAssertPtrNotNull(tc, fp);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_writeHeader(&generator, fp));
+   output = readOutput(fp);
+   CuAssertPtrNotNull(tc, output);
+   CuAssertPtrNotNull(tc, strstr(output, "#ifndef APXNODE_TESTNODE_H\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXNODE_TESTNODE_IN_PORT_DATA_LEN 6u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXNODE_TESTNODE_OUT_PORT_DATA_LEN 13u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXNODE_TESTNODE_TEMPERATURES_OFFSET 2u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXNODE_TESTNODE_TEMPERATURES_LEN 4u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXNODE_TESTNODE_LOCATION_OFFSET 1u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXNODE_TESTNODE_LOCATION_LEN 12u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "APXNODE_INLINE void ApxNode_Read_TestNode_VehicleSpeed(uint16_t *val)\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   *val = ApxNode_unpackU16LE(&p[0u]);\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "APXNODE_INLINE void ApxNode_Read_TestNode_Temperatures(int16_t *val)\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "      val[i0] = (int16_t) ApxNode_unpackU16LE(&p[i0*2u]);\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "APXNODE_INLINE void ApxNode_Write_TestNode_EngineStatus(uint8_t val)\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   ApxNode_packU8(&p[0u], (uint8_t) val);\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   apx_nodeData_outPortDataNotify(&ApxNode_TestNode_nodeData, APXNODE_TESTNODE_ENGINESTATUS_OFFSET, APXNODE_TESTNODE_ENGINESTATUS_LEN);\n"));
+   free(output);
+   fclose(fp);
+   apx_codeGenerator_destroy(&generator);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_codeGenerator_records(CuTest* tc)
+{
+   apx_node_t node;
+   apx_codeGenerator_t generator;
+   FILE *fp;
+   char *output;
+   createTestNode(&node);
+   apx_codeGenerator_create(&generator);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_setNode(&generator, &node, m_definitionText, (uint32_t) strlen(m_definitionText)));
+   fp = tmpfile();
+   CuAssertPtrNotNull(tc, fp);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_writeHeader(&generator, fp));
+   output = readOutput(fp);
+   CuAssertPtrNotNull(tc, output);
+   CuAssertPtrNotNull(tc, strstr(output, "typedef struct ApxNode_TestNode_Location_tag\n{\n   uint32_t Id;\n   char Name[5];\n   uint16_t Pos[2];\n} ApxNode_TestNode_Location_T;\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "APXNODE_INLINE void ApxNode_Write_TestNode_Location(const ApxNode_TestNode_Location_T *val)\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   ApxNode_packU32LE(&p[0u], (uint32_t) val->Id);\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   ApxNode_packStr(&p[4u], &val->Name[0], 4u);\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "      ApxNode_packU16LE(&p[i0*2u + 8u], (uint16_t) val->Pos[i0]);\n"));
+   free(output);
+   fclose(fp);
+   apx_codeGenerator_destroy(&generator);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_codeGenerator_source(CuTest* tc)
+{
+   apx_node_t node;
+   apx_codeGenerator_t generator;
+   FILE *fp;
+   char *output;
+   createTestNode(&node);
+   apx_codeGenerator_create(&generator);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_setNode(&generator, &node, m_definitionText, (uint32_t) strlen(m_definitionText)));
+   fp = tmpfile();
+   CuAssertPtrNotNull(tc, fp);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_writeSource(&generator, fp, "ApxNode_TestNode.h"));
+   output = readOutput(fp);
+   CuAssertPtrNotNull(tc, output);
+   CuAssertPtrNotNull(tc, strstr(output, "#include \"ApxNode_TestNode.h\"\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "static const uint8_t m_inPortInitData[APXNODE_TESTNODE_IN_PORT_DATA_LEN]= {\n   255, 255, 255, 255, 2, 0\n};\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "\"R\\\"VehicleSpeed\\\"S:=0xFFFF\\n\"\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "uint8_t ApxNode_TestNode_inPortData[APXNODE_TESTNODE_IN_PORT_DATA_LEN];\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "void ApxNode_Init_TestNode(void)\n"));
+   free(output);
+   fclose(fp);
+   apx_codeGenerator_destroy(&generator);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_codeGenerator_strings(CuTest* tc)
+{
+   const char *definitionText = "APX/1.2\nN\"StringNode\"\nR\"Label\"a[8]\nR\"Item\"{\"Id\"C\"Name\"a[4]}\n\n";
+   apx_node_t node;
+   apx_codeGenerator_t generator;
+   FILE *fp;
+   char *output;
+   apx_node_create(&node, "StringNode");
+   apx_node_createRequirePort(&node, "Label", "a[8]", 0);
+   apx_node_createRequirePort(&node, "Item", "{\"Id\"C\"Name\"a[4]}", 0);
+   apx_node_finalize(&node);
+   apx_codeGenerator_create(&generator);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_setNode(&generator, &node, definitionText, (uint32_t) strlen(definitionText)));
+   fp = tmpfile();
+   CuAssertPtrNotNull(tc, fp);
+   CuAssertIntEquals(tc, 0, apx_codeGenerator_writeHeader(&generator, fp));
+   output = readOutput(fp);
+   CuAssertPtrNotNull(tc, output);
+   //a string that fills the whole port is still terminated
+   CuAssertPtrNotNull(tc, strstr(output, "//val must hold APXNODE_STRINGNODE_LABEL_LEN+1 bytes, the string is always null-terminated\n"
+                                         "APXNODE_INLINE void ApxNode_Read_StringNode_Label(char *val)\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   memcpy(&val[0], &p[0u], 8u);\n   val[8u] = '\\0';\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   char Name[5];\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   memcpy(&val->Name[0], &p[1u], 4u);\n   val->Name[4u] = '\\0';\n"));
+   free(output);
+   fclose(fp);
+   apx_codeGenerator_destroy(&generator);
+   apx_node_destroy(&node);
+}
+
+static void createTestNode(apx_node_t *node)
+{
+   apx_node_create(node, "TestNode");
+   apx_node_createRequirePort(node, "VehicleSpeed", "S", "=0xFFFF");
+   apx_node_createRequirePort(node, "Temperatures", "s[2]", "={-1, 2}");
+   apx_node_createProvidePort(node, "EngineStatus", "C", "=3");
+   apx_node_createProvidePort(node, "Location", "{\"Id\"L\"Name\"a[4]\"Pos\"S[2]}", 0);
+   apx_node_finalize(node);
+}
+
+static char *readOutput(FILE *fp)
+{
+   char *output = (char*) malloc(MAX_OUTPUT_LEN);
+   if (output != 0)
+   {
+      size_t len;
+      rewind(fp);
+      len = fread(output, 1, MAX_OUTPUT_LEN-1, fp);
+      output[len] = '\0';
+   }
+   return output;
+}
@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_fileTableGenerator.h"
+#include "rmf.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_OUTPUT_LEN 16384
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_fileTableGenerator_addresses(CuTest* tc);
+static void test_apx_fileTableGenerator_header(CuTest* tc);
+static void test_apx_fileTableGenerator_source(CuTest* tc);
+static void createTestTable(apx_fileTableGenerator_t *generator);
+static char *readOutput(FILE *fp);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_fileTableGenerator(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_fileTableGenerator_addresses);
+   SUITE_ADD_TEST(suite, test_apx_fileTableGenerator_header);
+   SUITE_ADD_TEST(suite, test_apx_fileTableGenerator_source);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_fileTableGenerator_addresses(CuTest* tc)
+{
+   apx_fileTableGenerator_t generator;
+   createTestTable(&generator);
+   CuAssertIntEquals(tc, 3, generator.numNodes);
+   CuAssertIntEquals(tc, 5, generator.numFiles);
+   CuAssertUIntEquals(tc, 0x0, generator.nodes[0].outDataAddress);
+   CuAssertUIntEquals(tc, 0x4000000, generator.nodes[0].definitionAddress);
+   CuAssertUIntEquals(tc, 0x800, generator.nodes[1].outDataAddress);
+   CuAssertUIntEquals(tc, 0x4200000, generator.nodes[1].definitionAddress);
+   CuAssertUIntEquals(tc, RMF_INVALID_ADDRESS, generator.nodes[2].outDataAddress);
+   CuAssertUIntEquals(tc, 0x4300000, generator.nodes[2].definitionAddress);
+   CuAssertIntEquals(tc, -1, apx_fileTableGenerator_addNode(&generator, "Empty", 0, 0));
+   CuAssertIntEquals(tc, -1, apx_fileTableGenerator_addNode(&generator, "Huge", 0x4000000, 10));
+   CuAssertIntEquals(tc, 3, generator.numNodes);
+}
+
+static void test_apx_fileTableGenerator_header(CuTest* tc)
+{
+   apx_fileTableGenerator_t generator;
+   FILE *fp;
+   char *output;
+   createTestTable(&generator);
+   fp = tmpfile();
+   CuAssertPtrNotNull(tc, fp);
+   CuAssertIntEquals(tc, 0, apx_fileTableGenerator_writeHeader(&generator, fp));
+   output = readOutput(fp);
+   CuAssertPtrNotNull(tc, output);
+   CuAssertPtrNotNull(tc, strstr(output, "#ifndef APXFILETABLE_ECU_H\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXFILETABLE_ECU_NUM_FILES 5u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXFILETABLE_ECU_TESTNODE2_OUT_DATA_ADDRESS 0x00000800u\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "#define APXFILETABLE_ECU_TESTNODE2_DEFINITION_ADDRESS 0x04200000u\n"));
+   CuAssertPtrEquals(tc, 0, strstr(output, "APXFILETABLE_ECU_TESTNODE3_OUT_DATA_ADDRESS"));
+   CuAssertPtrNotNull(tc, strstr(output, "extern apx_file_t * const ApxFileTable_Ecu_files[APXFILETABLE_ECU_NUM_FILES];\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "int8_t ApxFileTable_Init_Ecu(apx_es_fileManager_t *fileManager);\n"));
+   free(output);
+   fclose(fp);
+}
+
+static void test_apx_fileTableGenerator_source(CuTest* tc)
+{
+   apx_fileTableGenerator_t generator;
+   FILE *fp;
+   char *output;
+   createTestTable(&generator);
+   fp = tmpfile();
+   CuAssertPtrNotNull(tc, fp);
+   CuAssertIntEquals(tc, 0, apx_fileTableGenerator_writeSource(&generator, fp, "ApxFileTable_Ecu.h"));
+   output = readOutput(fp);
+   CuAssertPtrNotNull(tc, output);
+   CuAssertPtrNotNull(tc, strstr(output, "#include \"ApxFileTable_Ecu.h\"\n#include \"ApxNode_TestNode1.h\"\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "apx_file_t ApxFileTable_Ecu_TestNode1_outDataFile =\n{\n   .isRemoteFile = false,\n   .nodeData = &ApxNode_TestNode1_nodeData,\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "      .length = APXNODE_TESTNODE1_OUT_PORT_DATA_LEN,\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "      .name = \"TestNode1.apx\"\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "apx_file_t * const ApxFileTable_Ecu_files[APXFILETABLE_ECU_NUM_FILES] =\n{\n"
+                                         "   &ApxFileTable_Ecu_TestNode1_outDataFile,\n"
+                                         "   &ApxFileTable_Ecu_TestNode2_outDataFile,\n"
+                                         "   &ApxFileTable_Ecu_TestNode1_definitionFile,\n"
+                                         "   &ApxFileTable_Ecu_TestNode2_definitionFile,\n"
+                                         "   &ApxFileTable_Ecu_TestNode3_definitionFile,\n"
+                                         "};\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   apx_nodeData_setOutPortDataFile(&ApxNode_TestNode2_nodeData, &ApxFileTable_Ecu_TestNode2_outDataFile);\n"));
+   CuAssertPtrNotNull(tc, strstr(output, "   return apx_es_fileManager_setLocalFileTable(fileManager, &ApxFileTable_Ecu_files[0], APXFILETABLE_ECU_NUM_FILES);\n"));
+   free(output);
+   fclose(fp);
+}
+
+static void createTestTable(apx_fileTableGenerator_t *generator)
+{
+   apx_fileTableGenerator_create(generator, "Ecu");
+   apx_fileTableGenerator_addNode(generator, "TestNode1", 1500, 0x180000);
+   apx_fileTableGenerator_addNode(generator, "TestNode2", 13, 200);
+   apx_fileTableGenerator_addNode(generator, "TestNode3", 0, 100);
+}
+
+static char *readOutput(FILE *fp)
+{
+   char *output = (char*) malloc(MAX_OUTPUT_LEN);
+   if (output != 0)
+   {
+      size_t len;
+      rewind(fp);
+      len = fread(output, 1, MAX_OUTPUT_LEN-1, fp);
+      output[len] = '\0';
+   }
+   return output;
+}
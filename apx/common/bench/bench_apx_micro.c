@@ -0,0 +1,859 @@
+/**
+ * file: bench_apx_micro.c
+ * description: microbenchmarks for the hot functions of the protocol and node model layers.
+ *              Every case is calibrated so one repetition runs for at least --min-time, warmed up for --warmup and then
+ *              measured --reps times. Reports min, median, mean and relative standard deviation in ns per operation.
+ *              Medians can be saved as a baseline (--save) and later runs compared against it (--baseline), in which case
+ *              the exit code is 1 when any case got slower than --threshold percent.
+ */
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rmf.h"
+#include "headerutil.h"
+#include "pack.h"
+#include "apx_dataSignature.h"
+#include "apx_stream.h"
+#include "apx_parser.h"
+#include "apx_node.h"
+#include "apx_nodeInfo.h"
+#include "apx_router.h"
+#include "apx_file.h"
+#include "apx_fileMap.h"
+#include "apx_allocator.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_REPETITIONS      15u
+#define DEFAULT_WARMUP_MS        100u
+#define DEFAULT_MIN_TIME_MS      10u
+#define DEFAULT_THRESHOLD        5.0 //percent
+#define MAX_REPETITIONS          1000u
+#define MAX_BASELINE_ENTRIES     64
+#define MAX_NAME_LEN             64
+
+#define NUM_MESSAGES             64u //number of prepared messages/values the codec cases cycle through
+#define NUM_SIGNATURES           8u
+#define NUM_STREAM_PORTS         1000u
+#define NUM_ROUTER_NODES         1000u
+#define NUM_ROUTER_PORTS         4u //provide ports (and require ports) per node
+#define NUM_FILES                4096u
+#define FILE_ADDRESS_STRIDE      1024u
+#define NUM_LOOKUPS              1024u //must be a power of 2
+#define NUM_ALLOCATOR_OBJECTS    16u
+
+typedef struct benchCase_tag
+{
+   const char *name;
+   int (*setup)(void **state); //optional, returns 0 on success
+   void (*run)(void *state, uint32_t iterations);
+   void (*teardown)(void *state); //optional
+   uint32_t opsPerIteration; //ns/op is computed from iterations*opsPerIteration
+}benchCase_t;
+
+typedef struct benchStats_tag
+{
+   double min;
+   double median;
+   double mean;
+   double rsd; //relative standard deviation in percent
+}benchStats_t;
+
+typedef struct baselineEntry_tag
+{
+   char name[MAX_NAME_LEN];
+   double median;
+}baselineEntry_t;
+
+typedef struct codecState_tag
+{
+   uint8_t messages[NUM_MESSAGES][RMF_MAX_HEADER_SIZE+8];
+   int32_t messageLen[NUM_MESSAGES];
+   uint32_t values[NUM_MESSAGES];
+   uint8_t encoded[NUM_MESSAGES][sizeof(uint32_t)];
+   uint32_t encodedLen[NUM_MESSAGES];
+   uint8_t buf[RMF_MAX_HEADER_SIZE+8];
+}codecState_t;
+
+typedef struct streamState_tag
+{
+   char *definition;
+   uint32_t definitionLen;
+   apx_istream_t istream;
+   apx_istream_handler_t handler;
+}streamState_t;
+
+typedef struct routerState_tag
+{
+   apx_parser_t parser;
+   apx_nodeInfo_t *nodeInfoList;
+   uint32_t numNodes;
+}routerState_t;
+
+typedef struct fileMapState_tag
+{
+   apx_fileMap_t fileMap;
+   uint32_t addresses[NUM_LOOKUPS];
+}fileMapState_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static double getTimeSec(void);
+static double runOnce(const benchCase_t *benchCase, void *state, uint32_t iterations);
+static int runCase(const benchCase_t *benchCase, benchStats_t *stats);
+static int compareDouble(const void *a, const void *b);
+static int loadBaseline(const char *fileName);
+static const baselineEntry_t *findBaseline(const char *name);
+static uint32_t nextRandom(uint32_t *seed);
+
+static int setupCodec(void **state);
+static void teardownFree(void *state);
+static void run_rmf_unpackMsg(void *state, uint32_t iterations);
+static void run_rmf_packHeaderBeforeData(void *state, uint32_t iterations);
+static void run_headerutil_numEncode32(void *state, uint32_t iterations);
+static void run_headerutil_numDecode32(void *state, uint32_t iterations);
+static void run_packBE(void *state, uint32_t iterations);
+static void run_packLE(void *state, uint32_t iterations);
+static void run_apx_dataSignature_create(void *state, uint32_t iterations);
+static int setupStream(void **state);
+static void run_apx_istream_write(void *state, uint32_t iterations);
+static void teardownStream(void *state);
+static int setupRouter(void **state);
+static void run_apx_router_attachDetach(void *state, uint32_t iterations);
+static void teardownRouter(void *state);
+static int setupFileMap(void **state);
+static void run_apx_fileMap_findByAddress(void *state, uint32_t iterations);
+static void teardownFileMap(void *state);
+static int setupAllocator(void **state);
+static void run_apx_allocator_allocFree(void *state, uint32_t iterations);
+static void teardownAllocator(void *state);
+static void onStreamEvent(void *arg);
+static void onStreamNode(void *arg, const char *name);
+static void onStreamDeclaration(void *arg, const char *name, const char *dsg, const char *attr);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+int8_t g_debug; // Global so apx_logging can use it from everywhere
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static volatile uint32_t m_sink; //results are accumulated here so the compiler cannot remove the measured calls
+static uint32_t m_repetitions = DEFAULT_REPETITIONS;
+static double m_warmupTime = DEFAULT_WARMUP_MS/1000.0;
+static double m_minTime = DEFAULT_MIN_TIME_MS/1000.0;
+static baselineEntry_t m_baseline[MAX_BASELINE_ENTRIES];
+static int m_numBaselineEntries;
+static const char *m_signatures[NUM_SIGNATURES] = {"C", "S(0,65535)", "L", "a[32]", "C[8]", "{\"Id\"L\"Name\"a[8]\"Values\"C[4]}",
+                                                    "{\"A\"S\"B\"{\"C\"C\"D\"L}}", "s(-100,100)"};
+
+static const benchCase_t m_cases[] =
+{
+   {"rmf_unpackMsg", setupCodec, run_rmf_unpackMsg, teardownFree, 1u},
+   {"rmf_packHeaderBeforeData", setupCodec, run_rmf_packHeaderBeforeData, teardownFree, 1u},
+   {"headerutil_numEncode32", setupCodec, run_headerutil_numEncode32, teardownFree, 1u},
+   {"headerutil_numDecode32", setupCodec, run_headerutil_numDecode32, teardownFree, 1u},
+   {"packBE", setupCodec, run_packBE, teardownFree, 1u},
+   {"packLE", setupCodec, run_packLE, teardownFree, 1u},
+   {"apx_dataSignature_create", 0, run_apx_dataSignature_create, 0, 1u},
+   {"apx_istream_write (per line)", setupStream, run_apx_istream_write, teardownStream, NUM_STREAM_PORTS+1u},
+   {"apx_router_attach+detachNodeInfo", setupRouter, run_apx_router_attachDetach, teardownRouter, NUM_ROUTER_NODES},
+   {"apx_fileMap_findByAddress", setupFileMap, run_apx_fileMap_findByAddress, teardownFileMap, 1u},
+   {"apx_allocator_alloc+free", setupAllocator, run_apx_allocator_allocFree, teardownAllocator, 1u}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+   const char *filter = 0;
+   const char *saveFile = 0;
+   const char *baselineFile = 0;
+   double threshold = DEFAULT_THRESHOLD;
+   FILE *saveFh = 0;
+   int numRegressions = 0;
+   int i;
+   g_debug = 0;
+   for (i=1; i<argc; i++)
+   {
+      if (strncmp(argv[i], "--reps=", 7) == 0)
+      {
+         m_repetitions = (uint32_t) strtoul(&argv[i][7], 0, 10);
+      }
+      else if (strncmp(argv[i], "--warmup=", 9) == 0)
+      {
+         m_warmupTime = strtod(&argv[i][9], 0)/1000.0;
+      }
+      else if (strncmp(argv[i], "--min-time=", 11) == 0)
+      {
+         m_minTime = strtod(&argv[i][11], 0)/1000.0;
+      }
+      else if (strncmp(argv[i], "--filter=", 9) == 0)
+      {
+         filter = &argv[i][9];
+      }
+      else if (strncmp(argv[i], "--save=", 7) == 0)
+      {
+         saveFile = &argv[i][7];
+      }
+      else if (strncmp(argv[i], "--baseline=", 11) == 0)
+      {
+         baselineFile = &argv[i][11];
+      }
+      else if (strncmp(argv[i], "--threshold=", 12) == 0)
+      {
+         threshold = strtod(&argv[i][12], 0);
+      }
+      else
+      {
+         printf("%s [--reps=<n>] [--warmup=<ms>] [--min-time=<ms>] [--filter=<text>] [--save=<file>] [--baseline=<file>] [--threshold=<percent>]\n", argv[0]);
+         return 1;
+      }
+   }
+   if ( (m_repetitions == 0) || (m_repetitions > MAX_REPETITIONS) || (m_minTime <= 0.0) )
+   {
+      printf("invalid arguments\n");
+      return 1;
+   }
+   if ( (baselineFile != 0) && (loadBaseline(baselineFile) != 0) )
+   {
+      printf("Failed to read baseline %s\n", baselineFile);
+      return 1;
+   }
+   if (saveFile != 0)
+   {
+      saveFh = fopen(saveFile, "w");
+      if (saveFh == 0)
+      {
+         printf("Failed to open %s\n", saveFile);
+         return 1;
+      }
+   }
+   printf("%-34s %10s %10s %10s %7s", "ns/op", "min", "median", "mean", "rsd%");
+   if (baselineFile != 0)
+   {
+      printf(" %10s %8s", "baseline", "delta%");
+   }
+   printf("\n");
+   for (i=0; i<(int) (sizeof(m_cases)/sizeof(m_cases[0])); i++)
+   {
+      benchStats_t stats;
+      const benchCase_t *benchCase = &m_cases[i];
+      if ( (filter != 0) && (strstr(benchCase->name, filter) == 0) )
+      {
+         continue;
+      }
+      if (runCase(benchCase, &stats) != 0)
+      {
+         printf("%-34s setup failed\n", benchCase->name);
+         continue;
+      }
+      printf("%-34s %10.2f %10.2f %10.2f %7.2f", benchCase->name, stats.min, stats.median, stats.mean, stats.rsd);
+      if (baselineFile != 0)
+      {
+         const baselineEntry_t *entry = findBaseline(benchCase->name);
+         if (entry != 0)
+         {
+            double delta = (stats.median - entry->median)*100.0/entry->median;
+            printf(" %10.2f %+8.2f", entry->median, delta);
+            if (delta > threshold)
+            {
+               printf("  REGRESSION");
+               numRegressions++;
+            }
+         }
+         else
+         {
+            printf(" %10s %8s", "-", "-");
+         }
+      }
+      printf("\n");
+      if (saveFh != 0)
+      {
+         fprintf(saveFh, "%s\t%.4f\n", benchCase->name, stats.median);
+      }
+   }
+   if (saveFh != 0)
+   {
+      fclose(saveFh);
+   }
+   if (numRegressions > 0)
+   {
+      printf("%d case(s) slower than baseline by more than %.1f%%\n", numRegressions, threshold);
+      return 1;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static double getTimeSec(void)
+{
+#ifdef _MSC_VER
+   LARGE_INTEGER freq;
+   LARGE_INTEGER count;
+   QueryPerformanceFrequency(&freq);
+   QueryPerformanceCounter(&count);
+   return ((double) count.QuadPart) / ((double) freq.QuadPart);
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((double) ts.tv_sec) + ((double) ts.tv_nsec)*1e-9;
+#endif
+}
+
+static double runOnce(const benchCase_t *benchCase, void *state, uint32_t iterations)
+{
+   double start = getTimeSec();
+   benchCase->run(state, iterations);
+   return getTimeSec() - start;
+}
+
+/**
+ * calibrates the number of iterations per repetition, warms up and then measures m_repetitions repetitions
+ */
+static int runCase(const benchCase_t *benchCase, benchStats_t *stats)
+{
+   double samples[MAX_REPETITIONS];
+   void *state = 0;
+   uint32_t iterations = 1u;
+   double elapsed;
+   double sum = 0.0;
+   double sumSq = 0.0;
+   double warmupStart;
+   uint32_t i;
+   if ( (benchCase->setup != 0) && (benchCase->setup(&state) != 0) )
+   {
+      return -1;
+   }
+   for(;;)
+   {
+      elapsed = runOnce(benchCase, state, iterations);
+      if ( (elapsed >= m_minTime) || (iterations >= 0x40000000u) )
+      {
+         break;
+      }
+      //aim a bit above minTime, but never grow more than 10x at a time
+      if (elapsed*10.0 < m_minTime)
+      {
+         iterations *= 10u;
+      }
+      else
+      {
+         iterations = (uint32_t) ( ((double) iterations) * 1.2 * m_minTime / elapsed ) + 1u;
+      }
+   }
+   warmupStart = getTimeSec();
+   while (getTimeSec() - warmupStart < m_warmupTime)
+   {
+      runOnce(benchCase, state, iterations);
+   }
+   for (i=0; i<m_repetitions; i++)
+   {
+      elapsed = runOnce(benchCase, state, iterations);
+      samples[i] = elapsed*1e9 / ( ((double) iterations) * (double) benchCase->opsPerIteration );
+      sum += samples[i];
+   }
+   if (benchCase->teardown != 0)
+   {
+      benchCase->teardown(state);
+   }
+   qsort(samples, m_repetitions, sizeof(double), compareDouble);
+   stats->min = samples[0];
+   stats->median = ( (m_repetitions & 1u) != 0u)? samples[m_repetitions/2u] :
+                   (samples[m_repetitions/2u-1u] + samples[m_repetitions/2u])/2.0;
+   stats->mean = sum / (double) m_repetitions;
+   for (i=0; i<m_repetitions; i++)
+   {
+      sumSq += (samples[i]-stats->mean)*(samples[i]-stats->mean);
+   }
+   stats->rsd = (stats->mean > 0.0)? sqrt(sumSq / (double) m_repetitions)*100.0/stats->mean : 0.0;
+   return 0;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+   double lhs = *(const double*) a;
+   double rhs = *(const double*) b;
+   return (lhs < rhs)? -1 : ((lhs > rhs)? 1 : 0);
+}
+
+/**
+ * reads a baseline written by --save. Each line is "<case name>\t<median ns/op>"
+ */
+static int loadBaseline(const char *fileName)
+{
+   char line[MAX_NAME_LEN+32];
+   FILE *fh = fopen(fileName, "r");
+   if (fh == 0)
+   {
+      return -1;
+   }
+   m_numBaselineEntries = 0;
+   while ( (m_numBaselineEntries < MAX_BASELINE_ENTRIES) && (fgets(line, (int) sizeof(line), fh) != 0) )
+   {
+      char *pTab = strrchr(line, '\t');
+      if ( (pTab != 0) && (pTab-line < MAX_NAME_LEN) )
+      {
+         baselineEntry_t *entry = &m_baseline[m_numBaselineEntries];
+         memcpy(entry->name, line, (size_t) (pTab-line));
+         entry->name[pTab-line] = 0;
+         entry->median = strtod(pTab+1, 0);
+         if (entry->median > 0.0)
+         {
+            m_numBaselineEntries++;
+         }
+      }
+   }
+   fclose(fh);
+   return 0;
+}
+
+static const baselineEntry_t *findBaseline(const char *name)
+{
+   int i;
+   for (i=0; i<m_numBaselineEntries; i++)
+   {
+      if (strcmp(m_baseline[i].name, name) == 0)
+      {
+         return &m_baseline[i];
+      }
+   }
+   return 0;
+}
+
+static uint32_t nextRandom(uint32_t *seed)
+{
+   *seed = (*seed)*1103515245u + 12345u;
+   return (*seed) >> 8;
+}
+
+/**
+ * prepares messages with both low and high addresses and numbers with both short and long encodings
+ */
+static int setupCodec(void **state)
+{
+   uint32_t i;
+   uint32_t seed = 1u;
+   codecState_t *codec = (codecState_t*) malloc(sizeof(codecState_t));
+   if (codec == 0)
+   {
+      return -1;
+   }
+   for (i=0; i<NUM_MESSAGES; i++)
+   {
+      uint32_t address = ( (i & 1u) == 0u)? (nextRandom(&seed) & RMF_DATA_LOW_MAX_ADDR) :
+                         (RMF_DATA_HIGH_MIN_ADDR + (nextRandom(&seed) & 0xFFFFFu));
+      int32_t headerLen = rmf_packHeader(codec->messages[i], RMF_MAX_HEADER_SIZE, address, false);
+      memset(&codec->messages[i][headerLen], (int) i, 8);
+      codec->messageLen[i] = headerLen + 8;
+      codec->values[i] = ( (i & 1u) == 0u)? (nextRandom(&seed) & 0x7Fu) : (nextRandom(&seed) & 0x7FFFFFFu);
+      codec->encodedLen[i] = (uint32_t) (headerutil_numEncode32(codec->encoded[i], sizeof(uint32_t), codec->values[i]) - codec->encoded[i]);
+   }
+   *state = codec;
+   return 0;
+}
+
+static void teardownFree(void *state)
+{
+   free(state);
+}
+
+static void run_rmf_unpackMsg(void *state, uint32_t iterations)
+{
+   codecState_t *codec = (codecState_t*) state;
+   uint32_t sum = 0;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      rmf_msg_t msg;
+      uint32_t index = i & (NUM_MESSAGES-1u);
+      rmf_unpackMsg(codec->messages[index], codec->messageLen[index], &msg);
+      sum += msg.address;
+   }
+   m_sink += sum;
+}
+
+static void run_rmf_packHeaderBeforeData(void *state, uint32_t iterations)
+{
+   codecState_t *codec = (codecState_t*) state;
+   uint32_t sum = 0;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      uint32_t address = (codec->values[i & (NUM_MESSAGES-1u)] + i) & 0x3FFFFu;
+      sum += (uint32_t) rmf_packHeaderBeforeData(&codec->buf[RMF_MAX_HEADER_SIZE], RMF_MAX_HEADER_SIZE, address, false);
+   }
+   m_sink += sum + codec->buf[0];
+}
+
+static void run_headerutil_numEncode32(void *state, uint32_t iterations)
+{
+   codecState_t *codec = (codecState_t*) state;
+   uint32_t sum = 0;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      uint8_t *pResult = headerutil_numEncode32(codec->buf, sizeof(uint32_t), codec->values[i & (NUM_MESSAGES-1u)]);
+      sum += (uint32_t) (pResult - codec->buf);
+   }
+   m_sink += sum + codec->buf[0];
+}
+
+static void run_headerutil_numDecode32(void *state, uint32_t iterations)
+{
+   codecState_t *codec = (codecState_t*) state;
+   uint32_t sum = 0;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      uint32_t index = i & (NUM_MESSAGES-1u);
+      uint32_t value = 0;
+      headerutil_numDecode32(codec->encoded[index], codec->encoded[index] + codec->encodedLen[index], &value);
+      sum += value;
+   }
+   m_sink += sum;
+}
+
+static void run_packBE(void *state, uint32_t iterations)
+{
+   codecState_t *codec = (codecState_t*) state;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      packBE(codec->buf, codec->values[i & (NUM_MESSAGES-1u)] + i, (uint8_t) sizeof(uint32_t));
+   }
+   m_sink += codec->buf[0];
+}
+
+static void run_packLE(void *state, uint32_t iterations)
+{
+   codecState_t *codec = (codecState_t*) state;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      packLE(codec->buf, codec->values[i & (NUM_MESSAGES-1u)] + i, (uint8_t) sizeof(uint32_t));
+   }
+   m_sink += codec->buf[0];
+}
+
+static void run_apx_dataSignature_create(void *state, uint32_t iterations)
+{
+   uint32_t sum = 0;
+   uint32_t i;
+   (void) state;
+   for (i=0; i<iterations; i++)
+   {
+      apx_dataSignature_t dsg;
+      if (apx_dataSignature_create(&dsg, m_signatures[i % NUM_SIGNATURES]) == 0)
+      {
+         sum += apx_dataSignature_packLen(&dsg);
+         apx_dataSignature_destroy(&dsg);
+      }
+   }
+   m_sink += sum;
+}
+
+static int setupStream(void **state)
+{
+   uint32_t i;
+   char *p;
+   streamState_t *stream = (streamState_t*) malloc(sizeof(streamState_t));
+   if (stream == 0)
+   {
+      return -1;
+   }
+   stream->definition = (char*) malloc( ((size_t) NUM_STREAM_PORTS+3u)*MAX_NAME_LEN*2u );
+   if (stream->definition == 0)
+   {
+      free(stream);
+      return -1;
+   }
+   p = stream->definition;
+   p += sprintf(p, "APX/1.2\nN\"BenchNode\"\n");
+   for (i=0; i<NUM_STREAM_PORTS; i++)
+   {
+      if ( (i & 1u) == 0u)
+      {
+         p += sprintf(p, "R\"RequirePortWithLongName%u\"S(0,65535):=0xFFFF\n", (unsigned int) i);
+      }
+      else
+      {
+         p += sprintf(p, "P\"ProvidePort%u\"{\"Id\"L\"Name\"a[8]\"Values\"C[4]}\n", (unsigned int) i);
+      }
+   }
+   p += sprintf(p, "\n");
+   stream->definitionLen = (uint32_t) (p-stream->definition);
+   memset(&stream->handler, 0, sizeof(stream->handler));
+   stream->handler.arg = stream;
+   stream->handler.open = onStreamEvent;
+   stream->handler.close = onStreamEvent;
+   stream->handler.node = onStreamNode;
+   stream->handler.datatype = onStreamDeclaration;
+   stream->handler.require = onStreamDeclaration;
+   stream->handler.provide = onStreamDeclaration;
+   stream->handler.node_end = onStreamEvent;
+   apx_istream_create(&stream->istream, &stream->handler);
+   *state = stream;
+   return 0;
+}
+
+static void run_apx_istream_write(void *state, uint32_t iterations)
+{
+   streamState_t *stream = (streamState_t*) state;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      apx_istream_reset(&stream->istream);
+      apx_istream_open(&stream->istream);
+      apx_istream_write(&stream->istream, (const uint8_t*) stream->definition, stream->definitionLen);
+      apx_istream_close(&stream->istream);
+   }
+}
+
+static void teardownStream(void *state)
+{
+   streamState_t *stream = (streamState_t*) state;
+   apx_istream_destroy(&stream->istream);
+   free(stream->definition);
+   free(stream);
+}
+
+/**
+ * creates NUM_ROUTER_NODES nodes where node n requires the signals provided by node n-1
+ */
+static int setupRouter(void **state)
+{
+   apx_istream_t istream;
+   apx_istream_handler_t handler;
+   char definition[(NUM_ROUTER_PORTS*2u+2u)*MAX_NAME_LEN];
+   uint32_t i;
+   routerState_t *router = (routerState_t*) malloc(sizeof(routerState_t));
+   if (router == 0)
+   {
+      return -1;
+   }
+   router->nodeInfoList = (apx_nodeInfo_t*) malloc(NUM_ROUTER_NODES*sizeof(apx_nodeInfo_t));
+   if (router->nodeInfoList == 0)
+   {
+      free(router);
+      return -1;
+   }
+   apx_parser_create(&router->parser);
+   memset(&handler, 0, sizeof(handler));
+   handler.arg = &router->parser;
+   handler.open = apx_parser_vopen;
+   handler.close = apx_parser_vclose;
+   handler.node = apx_parser_vnode;
+   handler.datatype = apx_parser_vdatatype;
+   handler.provide = apx_parser_vprovide;
+   handler.require = apx_parser_vrequire;
+   handler.node_end = apx_parser_vnode_end;
+   apx_istream_create(&istream, &handler);
+   for (i=0; i<NUM_ROUTER_NODES; i++)
+   {
+      uint32_t j;
+      char *p = definition;
+      p += sprintf(p, "APX/1.2\nN\"RouterNode%u\"\n", (unsigned int) i);
+      for (j=0; j<NUM_ROUTER_PORTS; j++)
+      {
+         p += sprintf(p, "P\"Signal%u_%u\"S\n", (unsigned int) i, (unsigned int) j);
+      }
+      for (j=0; j<NUM_ROUTER_PORTS; j++)
+      {
+         p += sprintf(p, "R\"Signal%u_%u\"S\n", (unsigned int) ((i+NUM_ROUTER_NODES-1u) % NUM_ROUTER_NODES), (unsigned int) j);
+      }
+      p += sprintf(p, "\n");
+      apx_istream_reset(&istream);
+      apx_istream_open(&istream);
+      apx_istream_write(&istream, (const uint8_t*) definition, (uint32_t) (p-definition));
+      apx_istream_close(&istream);
+   }
+   apx_istream_destroy(&istream);
+   router->numNodes = (uint32_t) apx_parser_getNumNodes(&router->parser);
+   for (i=0; i<router->numNodes; i++)
+   {
+      apx_nodeInfo_create(&router->nodeInfoList[i], apx_parser_getNode(&router->parser, (int32_t) i));
+   }
+   if (router->numNodes != NUM_ROUTER_NODES)
+   {
+      teardownRouter(router);
+      return -1;
+   }
+   *state = router;
+   return 0;
+}
+
+/**
+ * one iteration attaches all nodes to a new router and detaches them again
+ */
+static void run_apx_router_attachDetach(void *state, uint32_t iterations)
+{
+   routerState_t *routerState = (routerState_t*) state;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      apx_router_t router;
+      uint32_t j;
+      apx_router_create(&router);
+      for (j=0; j<routerState->numNodes; j++)
+      {
+         apx_router_attachNodeInfo(&router, &routerState->nodeInfoList[j]);
+      }
+      for (j=0; j<routerState->numNodes; j++)
+      {
+         apx_router_detachNodeInfo(&router, &routerState->nodeInfoList[j]);
+      }
+      apx_router_destroy(&router);
+   }
+}
+
+static void teardownRouter(void *state)
+{
+   routerState_t *router = (routerState_t*) state;
+   uint32_t i;
+   for (i=0; i<router->numNodes; i++)
+   {
+      apx_nodeInfo_destroy(&router->nodeInfoList[i]);
+   }
+   apx_parser_destroy(&router->parser);
+   free(router->nodeInfoList);
+   free(router);
+}
+
+static int setupFileMap(void **state)
+{
+   uint32_t i;
+   uint32_t seed = 7u;
+   fileMapState_t *fileMap = (fileMapState_t*) malloc(sizeof(fileMapState_t));
+   if (fileMap == 0)
+   {
+      return -1;
+   }
+   apx_fileMap_create(&fileMap->fileMap);
+   for (i=0; i<NUM_FILES; i++)
+   {
+      rmf_fileInfo_t fileInfo;
+      char name[MAX_NAME_LEN];
+      apx_file_t *file;
+      sprintf(name, "Node%u.out", (unsigned int) i);
+      rmf_fileInfo_create(&fileInfo, name, i*FILE_ADDRESS_STRIDE, FILE_ADDRESS_STRIDE/2u, RMF_FILE_TYPE_FIXED);
+      file = apx_file_newRemoteFile(&fileInfo);
+      rmf_fileInfo_destroy(&fileInfo);
+      if (file == 0)
+      {
+         teardownFileMap(fileMap);
+         return -1;
+      }
+      //addresses never overlap, the return value is not reliable for the first file in the map
+      (void) apx_fileMap_insertFile(&fileMap->fileMap, file);
+   }
+   for (i=0; i<NUM_LOOKUPS; i++)
+   {
+      //uniformly distributed over all files, always inside a file
+      fileMap->addresses[i] = (nextRandom(&seed) % NUM_FILES)*FILE_ADDRESS_STRIDE + (nextRandom(&seed) % (FILE_ADDRESS_STRIDE/2u));
+   }
+   *state = fileMap;
+   return 0;
+}
+
+static void run_apx_fileMap_findByAddress(void *state, uint32_t iterations)
+{
+   fileMapState_t *fileMap = (fileMapState_t*) state;
+   uint32_t sum = 0;
+   uint32_t i;
+   for (i=0; i<iterations; i++)
+   {
+      apx_file_t *file = apx_fileMap_findByAddress(&fileMap->fileMap, fileMap->addresses[i & (NUM_LOOKUPS-1u)]);
+      sum += (file != 0)? file->fileInfo.length : 0u;
+   }
+   m_sink += sum;
+}
+
+static void teardownFileMap(void *state)
+{
+   fileMapState_t *fileMap = (fileMapState_t*) state;
+   apx_fileMap_destroy(&fileMap->fileMap);
+   free(fileMap);
+}
+
+static int setupAllocator(void **state)
+{
+   apx_allocator_t *allocator = (apx_allocator_t*) malloc(sizeof(apx_allocator_t));
+   if (allocator == 0)
+   {
+      return -1;
+   }
+   if (apx_allocator_create(allocator) != 0)
+   {
+      free(allocator);
+      return -1;
+   }
+   *state = allocator;
+   return 0;
+}
+
+/**
+ * one iteration allocates and frees one object, objects are kept alive in a small window of mixed sizes
+ */
+static void run_apx_allocator_allocFree(void *state, uint32_t iterations)
+{
+   apx_allocator_t *allocator = (apx_allocator_t*) state;
+   uint8_t *objects[NUM_ALLOCATOR_OBJECTS];
+   uint32_t i;
+   for (i=0; i<NUM_ALLOCATOR_OBJECTS; i++)
+   {
+      objects[i] = apx_allocator_alloc(allocator, (size_t) (4u + (i & 7u)*4u));
+   }
+   for (i=0; i<iterations; i++)
+   {
+      uint32_t index = i & (NUM_ALLOCATOR_OBJECTS-1u);
+      uint32_t size = 4u + (index & 7u)*4u;
+      apx_allocator_free(allocator, objects[index], size);
+      objects[index] = apx_allocator_alloc(allocator, (size_t) size);
+   }
+   for (i=0; i<NUM_ALLOCATOR_OBJECTS; i++)
+   {
+      apx_allocator_free(allocator, objects[i], 4u + (i & 7u)*4u);
+   }
+}
+
+static void teardownAllocator(void *state)
+{
+   apx_allocator_destroy((apx_allocator_t*) state);
+   free(state);
+}
+
+static void onStreamEvent(void *arg)
+{
+   (void) arg;
+   m_sink++;
+}
+
+static void onStreamNode(void *arg, const char *name)
+{
+   (void) arg;
+   m_sink += (uint32_t) name[0];
+}
+
+static void onStreamDeclaration(void *arg, const char *name, const char *dsg, const char *attr)
+{
+   (void) arg;
+   (void) attr;
+   m_sink += (uint32_t) name[0] + (uint32_t) dsg[0];
+}
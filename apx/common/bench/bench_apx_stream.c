@@ -0,0 +1,209 @@
+/**
+ * file: bench_apx_stream.c
+ * description: measures parsing throughput of apx_istream for a large generated APX definition fed in chunks of
+ *              different sizes.
+ */
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "apx_stream.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_NUM_PORTS  50000
+#define DEFAULT_ITERATIONS 5
+#define MAX_LINE_LEN       128
+
+typedef struct benchCounters_tag
+{
+   uint32_t numLines;
+   uint32_t numNodeEnd;
+}benchCounters_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static char *createDefinition(uint32_t numPorts, uint32_t *len);
+static double getTimeSec(void);
+static double runBenchmark(const uint8_t *data, uint32_t dataLen, uint32_t chunkLen, benchCounters_t *counters);
+static void onNode(void *arg, const char *name);
+static void onDeclaration(void *arg, const char *name, const char *dsg, const char *attr);
+static void onNodeEnd(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+int8_t g_debug; // Global so apx_logging can use it from everywhere
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const uint32_t m_chunkSizes[] = {16u, 256u, 4096u, 65536u, 0u}; //0 means whole definition in one write
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+   uint32_t numPorts = DEFAULT_NUM_PORTS;
+   uint32_t iterations = DEFAULT_ITERATIONS;
+   uint32_t dataLen = 0;
+   uint32_t i;
+   char *data;
+   g_debug = 0;
+   if (argc > 1)
+   {
+      numPorts = (uint32_t) strtoul(argv[1], 0, 10);
+   }
+   if (argc > 2)
+   {
+      iterations = (uint32_t) strtoul(argv[2], 0, 10);
+   }
+   if ( (numPorts == 0) || (iterations == 0) )
+   {
+      printf("%s [numPorts] [iterations]\n", argv[0]);
+      return 1;
+   }
+   data = createDefinition(numPorts, &dataLen);
+   if (data == 0)
+   {
+      printf("Failed to allocate definition\n");
+      return 1;
+   }
+   printf("apx_istream: %u ports, %u bytes, best of %u iterations\n", (unsigned int) numPorts, (unsigned int) dataLen, (unsigned int) iterations);
+   printf("%10s %12s %12s %14s\n", "chunk", "time (ms)", "MB/s", "lines/s");
+   for (i=0; i<sizeof(m_chunkSizes)/sizeof(m_chunkSizes[0]); i++)
+   {
+      uint32_t j;
+      double best = -1.0;
+      benchCounters_t counters;
+      uint32_t chunkLen = (m_chunkSizes[i] == 0u)? dataLen : m_chunkSizes[i];
+      for (j=0; j<iterations; j++)
+      {
+         double elapsed = runBenchmark((const uint8_t*) data, dataLen, chunkLen, &counters);
+         if ( (best < 0.0) || (elapsed < best) )
+         {
+            best = elapsed;
+         }
+      }
+      if ( (counters.numLines != numPorts+1) || (counters.numNodeEnd != 1) )
+      {
+         printf("unexpected parse result: %u lines, %u node ends\n", (unsigned int) counters.numLines, (unsigned int) counters.numNodeEnd);
+         free(data);
+         return 1;
+      }
+      if (best <= 0.0)
+      {
+         best = 1e-9;
+      }
+      printf("%10u %12.3f %12.1f %14.0f\n", (unsigned int) chunkLen, best*1000.0, ((double) dataLen)/(best*1024.0*1024.0),
+            ((double) counters.numLines)/best);
+   }
+   free(data);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static char *createDefinition(uint32_t numPorts, uint32_t *len)
+{
+   uint32_t i;
+   size_t allocLen = ((size_t) numPorts+3u)*MAX_LINE_LEN;
+   char *data = (char*) malloc(allocLen);
+   char *p = data;
+   if (data == 0)
+   {
+      return 0;
+   }
+   p += sprintf(p, "APX/1.2\nN\"BenchNode\"\n");
+   for (i=0; i<numPorts; i++)
+   {
+      if ( (i & 1u) == 0u)
+      {
+         p += sprintf(p, "R\"RequirePortWithLongName%u\"S(0,65535):=0xFFFF\n", (unsigned int) i);
+      }
+      else
+      {
+         p += sprintf(p, "P\"ProvidePort%u\"{\"Id\"L\"Name\"a[8]\"Values\"C[4]}\n", (unsigned int) i);
+      }
+   }
+   p += sprintf(p, "\n");
+   *len = (uint32_t) (p-data);
+   return data;
+}
+
+static double getTimeSec(void)
+{
+#ifdef _MSC_VER
+   LARGE_INTEGER freq;
+   LARGE_INTEGER count;
+   QueryPerformanceFrequency(&freq);
+   QueryPerformanceCounter(&count);
+   return ((double) count.QuadPart) / ((double) freq.QuadPart);
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((double) ts.tv_sec) + ((double) ts.tv_nsec)*1e-9;
+#endif
+}
+
+static double runBenchmark(const uint8_t *data, uint32_t dataLen, uint32_t chunkLen, benchCounters_t *counters)
+{
+   apx_istream_t istream;
+   apx_istream_handler_t handler;
+   const uint8_t *pNext = data;
+   const uint8_t *pEnd = data + dataLen;
+   double start;
+   double stop;
+   memset(&handler, 0, sizeof(handler));
+   memset(counters, 0, sizeof(benchCounters_t));
+   handler.arg = counters;
+   handler.node = onNode;
+   handler.datatype = onDeclaration;
+   handler.require = onDeclaration;
+   handler.provide = onDeclaration;
+   handler.node_end = onNodeEnd;
+   apx_istream_create(&istream, &handler);
+   start = getTimeSec();
+   apx_istream_open(&istream);
+   while (pNext < pEnd)
+   {
+      uint32_t len = ( (uint32_t) (pEnd-pNext) < chunkLen)? (uint32_t) (pEnd-pNext) : chunkLen;
+      apx_istream_write(&istream, pNext, len);
+      pNext += len;
+   }
+   apx_istream_close(&istream);
+   stop = getTimeSec();
+   apx_istream_destroy(&istream);
+   return stop-start;
+}
+
+static void onNode(void *arg, const char *name)
+{
+   (void) name;
+   ((benchCounters_t*) arg)->numLines++;
+}
+
+static void onDeclaration(void *arg, const char *name, const char *dsg, const char *attr)
+{
+   (void) name;
+   (void) dsg;
+   (void) attr;
+   ((benchCounters_t*) arg)->numLines++;
+}
+
+static void onNodeEnd(void *arg)
+{
+   ((benchCounters_t*) arg)->numNodeEnd++;
+}
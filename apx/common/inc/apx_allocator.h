@@ -5,6 +5,7 @@
 // INCLUDES
 //////////////////////////////////////////////////////////////////////////////
 #include <stdint.h>
+#include <stddef.h>
 #if defined(_MSC_PLATFORM_TOOLSET) && (_MSC_PLATFORM_TOOLSET<=110)
 #include "msc_bool.h"
 #else
@@ -15,44 +16,92 @@
 #include <Windows.h>
 #else
 #include <pthread.h>
-#include <semaphore.h>
 #endif
 #include "osmacro.h"
-#include "ringbuf.h"
-#include "soa.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#define APX_ALLOCATOR_NUM_SIZE_CLASSES    16u
+#define APX_ALLOCATOR_MAX_OBJECT_SIZE     4096u //larger objects are passed directly to malloc/free
+#ifndef APX_ALLOCATOR_THREAD_CACHE_SIZE
+#define APX_ALLOCATOR_THREAD_CACHE_SIZE   4u //number of allocators whose heap a thread finds without taking a lock
+#endif
+#ifndef APX_ALLOCATOR_SLAB_SIZE
+#define APX_ALLOCATOR_SLAB_SIZE           65536u
+#endif
+#define APX_ALLOCATOR_BLOCK_HEADER_SIZE   8u //holds the slab pointer of the block
+#define APX_ALLOCATOR_SLAB_HEADER_SIZE    ((uint32_t) ((sizeof(apx_allocatorSlab_t) + 7u) & ~7u))
+
+struct apx_allocatorHeap_tag;
+
+//free blocks are linked through their first bytes
+typedef struct apx_allocatorBlock_tag
+{
+   struct apx_allocatorBlock_tag *next;
+}apx_allocatorBlock_t;
 
 /**
- * this is a simple small object allocator with built-in garbage collector thread
+ * A slab holds blocks of a single size class and keeps its own free list. It is linked into the partial list of its
+ * size class while it has free blocks and into the full list otherwise.
  */
-typedef struct apx_allocator_tag
+typedef struct apx_allocatorSlab_tag
 {
-   THREAD_T workerThread; //local worker thread
-   SPINLOCK_T lock;  //variable lock
-   SEMAPHORE_T semaphore; //thread semaphore
+   struct apx_allocatorSlab_tag *next;
+   struct apx_allocatorSlab_tag *prev;
+   apx_allocatorBlock_t *freeList;
+   uint32_t numFree;
+   uint32_t numBlocks;
+   struct apx_allocatorHeap_tag *heap; //heap that owns the slab
+   uint8_t sizeClass;
+}apx_allocatorSlab_t;
 
-   //data object, all read/write accesses to these must be protected by the lock variable above
-   rbfs_t messages; //pending messages (ringbuffer)
-   bool isRunning; //when false it's time do shut down
-   bool workerThreadValid; //true if workerThread is a valid variable
-   uint8_t *ringBufferData; //memory for ringbuffer
-   uint32_t ringBufferLen; //number of items in ringbuffer
-   soa_t soa;
+/**
+ * Thread-local cache: every thread that uses an allocator gets a heap of its own, created on first use.
+ * Only the owning thread allocates from its heap or puts blocks back on its slabs, so neither takes a lock.
+ * A block freed by another thread is pushed lock-free onto remoteFreeList of the heap that owns it. The next alloc or free
+ * made by the owning thread moves it back to its slab.
+ * A slab whose blocks are all free is returned to the system unless it is the last slab with free blocks in its size
+ * class, so each heap keeps at most one idle slab per size class.
+ * Heaps are released by apx_allocator_destroy, the heap of a thread that has exited keeps its slabs until then.
+ */
+typedef struct apx_allocatorHeap_tag
+{
+   struct apx_allocatorHeap_tag *next; //next heap of the same allocator
+   uint32_t ownerThreadId;
+   apx_allocatorSlab_t *partialSlabs[APX_ALLOCATOR_NUM_SIZE_CLASSES]; //slabs with at least one free block
+   apx_allocatorSlab_t *fullSlabs[APX_ALLOCATOR_NUM_SIZE_CLASSES];
+   apx_allocatorBlock_t * volatile remoteFreeList; //blocks of any size class, freed by other threads
+   //statistics are only written by the owning thread, except numRemoteFrees which other threads update atomically
+   volatile uint32_t numSlabs[APX_ALLOCATOR_NUM_SIZE_CLASSES]; //slabs currently allocated
+   volatile uint32_t numAllocs[APX_ALLOCATOR_NUM_SIZE_CLASSES];
+   volatile uint32_t numLocalFrees[APX_ALLOCATOR_NUM_SIZE_CLASSES];
+   volatile uint32_t numRemoteFrees[APX_ALLOCATOR_NUM_SIZE_CLASSES];
+}apx_allocatorHeap_t;
 
-#ifdef _MSC_VER
-   unsigned int threadId;
-#endif
+/**
+ * slab based small object allocator. Objects up to APX_ALLOCATOR_MAX_OBJECT_SIZE bytes are served from size classes,
+ * alloc and free can be called directly from any thread.
+ */
+typedef struct apx_allocator_tag
+{
+   SPINLOCK_T heapLock; //protects the heap list, only taken when a thread uses the allocator for the first time
+   apx_allocatorHeap_t *heaps;
+   uint32_t id; //unique for each created allocator, identifies the allocator in the thread-local heap cache
+   uint32_t numHeaps;
+   volatile uint32_t numLargeAllocs;
+   volatile uint32_t numLargeFrees;
 }apx_allocator_t;
 
-//this data structure is used as elements in the ring buffer
-typedef struct rbf_data_tag
+typedef struct apx_allocatorStats_tag
 {
-   uint8_t *ptr;
-   uint32_t size;
-}rbf_data_t;
+   uint32_t objectSize; //largest object size served by the size class (0 for large objects)
+   uint32_t numSlabs; //slabs currently allocated
+   uint32_t numAllocs;
+   uint32_t numFrees; //includes numRemoteFrees
+   uint32_t numRemoteFrees; //objects freed by another thread than the one that allocated them
+   uint32_t numInUse;
+}apx_allocatorStats_t;
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -62,12 +111,14 @@ typedef struct rbf_data_tag
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
-int8_t apx_allocator_create(apx_allocator_t *self, uint16_t maxPendingMessages);
+int8_t apx_allocator_create(apx_allocator_t *self);
 void apx_allocator_destroy(apx_allocator_t *self);
 
-void apx_allocator_start(apx_allocator_t *self);
-void apx_allocator_stop(apx_allocator_t *self);
 uint8_t *apx_allocator_alloc(apx_allocator_t *self, size_t size);
 void apx_allocator_free(apx_allocator_t *self, uint8_t *ptr, uint32_t size);
+int8_t apx_allocator_getStats(apx_allocator_t *self, uint8_t sizeClass, apx_allocatorStats_t *stats);
+int8_t apx_allocator_getLargeObjectStats(apx_allocator_t *self, apx_allocatorStats_t *stats);
+uint32_t apx_allocator_getNumHeaps(apx_allocator_t *self);
+uint8_t apx_allocator_getSizeClass(size_t size);
 
 #endif //APX_ALLOCATOR_H
@@ -0,0 +1,57 @@
+/**
+ * file: apx_arena.h
+ * description: apx_arena is a bump allocator used to build the node model of a single APX definition.
+ *              Memory is handed out sequentially from a small number of large chunks and is only released when the
+ *              arena itself is destroyed.
+ */
+#ifndef APX_ARENA_H
+#define APX_ARENA_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stddef.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_ARENA_DEFAULT_CHUNK_SIZE   4096u
+#define APX_ARENA_MAX_CHUNK_SIZE       (1024u*1024u) //chunk size stops doubling at this size
+#define APX_ARENA_ALIGNMENT            8u
+
+typedef struct apx_arenaChunk_tag
+{
+   struct apx_arenaChunk_tag *next;
+   uint32_t size; //number of usable bytes in chunk
+   uint32_t used;
+}apx_arenaChunk_t;
+
+typedef struct apx_arena_tag
+{
+   apx_arenaChunk_t *head; //chunk currently used for allocations, older chunks follow in the next-chain
+   uint32_t nextChunkSize;
+   uint32_t numChunks;
+   uint32_t totalUsed; //total number of bytes handed out (including alignment padding)
+}apx_arena_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void apx_arena_create(apx_arena_t *self, uint32_t chunkSize);
+void apx_arena_destroy(apx_arena_t *self);
+apx_arena_t *apx_arena_new(uint32_t chunkSize);
+void apx_arena_delete(apx_arena_t *self);
+
+int8_t apx_arena_reserve(apx_arena_t *self, uint32_t size);
+void *apx_arena_alloc(apx_arena_t *self, uint32_t size);
+char *apx_arena_strdup(apx_arena_t *self, const char *str);
+uint32_t apx_arena_getUsed(const apx_arena_t *self);
+uint32_t apx_arena_getNumChunks(const apx_arena_t *self);
+
+#endif //APX_ARENA_H
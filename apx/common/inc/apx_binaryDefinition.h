@@ -0,0 +1,78 @@
+/**
+ * file: apx_binaryDefinition.h
+ * description: precompiled (binary) form of an APX definition. It is generated from a finalized apx_node_t and contains
+ *              the type table, the derived data signature, compiled data element tree, parsed attributes, pack length
+ *              and data offset of each port and the init data images of the node.
+ *              Nodes are created from it without parsing any APX text, data signature or attribute string.
+ *              The APX text remains the source of truth, the binary form carries a digest of the text it was compiled from
+ *              (see apx_binaryDefinition_verifyText).
+ *
+ * Layout (all integers are little endian):
+ *    header (APX_BINARY_DEFINITION_HEADER_LEN bytes)
+ *    datatype table (numDatatypes * APX_BINARY_DEFINITION_DATATYPE_LEN bytes): nameOffset, dsgOffset, attrOffset
+ *    port table ((numRequirePorts+numProvidePorts) * APX_BINARY_DEFINITION_PORT_LEN bytes): nameOffset, dsgOffset,
+ *       attrOffset, packLen, dataOffset, queueLen, attribute flags. Require ports come first.
+ *    element table (numElements * APX_BINARY_DEFINITION_ELEMENT_LEN bytes): nameOffset, baseType (1 byte + 3 reserved),
+ *       numChildren, arrayLen, packLen, min, max. The data element tree of each port in pre-order, in port table order.
+ *    inPort init data (inPortDataLen bytes)
+ *    outPort init data (outPortDataLen bytes)
+ *    string table (stringTableLen bytes), null-terminated strings. The node name is always at offset 0.
+ */
+#ifndef APX_BINARY_DEFINITION_H
+#define APX_BINARY_DEFINITION_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#if defined(_MSC_PLATFORM_TOOLSET) && (_MSC_PLATFORM_TOOLSET<=110)
+#include "msc_bool.h"
+#else
+#include <stdbool.h>
+#endif
+#include "apx_node.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_BINARY_DEFINITION_MAGIC          "APXB"
+#define APX_BINARY_DEFINITION_VERSION        2u
+#define APX_BINARY_DEFINITION_HEADER_LEN     52u
+#define APX_BINARY_DEFINITION_DATATYPE_LEN   12u
+#define APX_BINARY_DEFINITION_PORT_LEN       28u
+#define APX_BINARY_DEFINITION_ELEMENT_LEN    28u
+#define APX_BINARY_DEFINITION_NO_STRING      0xFFFFFFFFu
+
+#define APX_BINARY_DEFINITION_FLAG_QUEUED    0x01u
+#define APX_BINARY_DEFINITION_FLAG_PARAMETER 0x02u
+
+typedef struct apx_binaryDefinitionInfo_tag
+{
+   uint32_t totalLen;
+   uint32_t textLen; //length of the APX text the binary definition was compiled from
+   uint64_t textDigest; //64-bit FNV-1a digest of the APX text
+   uint32_t numDatatypes;
+   uint32_t numRequirePorts;
+   uint32_t numProvidePorts;
+   uint32_t numElements;
+   uint32_t inPortDataLen;
+   uint32_t outPortDataLen;
+   uint32_t stringTableLen;
+}apx_binaryDefinitionInfo_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+uint64_t apx_binaryDefinition_digest(const uint8_t *data, uint32_t len);
+uint8_t *apx_binaryDefinition_compile(apx_node_t *node, const uint8_t *definitionText, uint32_t definitionLen, uint32_t *binaryLen);
+bool apx_binaryDefinition_isBinary(const uint8_t *data, uint32_t len);
+int8_t apx_binaryDefinition_getInfo(const uint8_t *data, uint32_t len, apx_binaryDefinitionInfo_t *info);
+int8_t apx_binaryDefinition_verifyText(const uint8_t *data, uint32_t len, const uint8_t *definitionText, uint32_t definitionLen);
+apx_node_t *apx_binaryDefinition_createNode(const uint8_t *data, uint32_t len);
+
+#endif //APX_BINARY_DEFINITION_H
@@ -0,0 +1,105 @@
+/**
+ * file: apx_capture.h
+ * description: append-only log of raw RMF frames (message header and message data, exactly as seen on the socket).
+ *              Frames from all connections are written into one memory-mapped file, tagged with connection id, direction
+ *              and a nanosecond timestamp relative to the time the log was opened. The reader is used by the replay tool.
+ *
+ *              File layout (all integers little endian):
+ *                header:  magic "APXCAP01" | version (u32) | header length (u32) | wall clock at open, seconds (u64) | reserved (u64)
+ *                records: timestamp ns (u64) | connection id (u32) | frame length (u32, bit 31 set for transmitted frames)
+ *                         | frame data | zero padding up to next 8-byte boundary
+ *              A record with frame length 0 ends the log (the file is preallocated in chunks and zero-filled).
+ */
+#ifndef APX_CAPTURE_H
+#define APX_CAPTURE_H
+
+#ifndef APX_EMBEDDED
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+#if defined(_MSC_PLATFORM_TOOLSET) && (_MSC_PLATFORM_TOOLSET<=110)
+#include "msc_bool.h"
+#else
+#include <stdbool.h>
+#endif
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+#include "osmacro.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_CAPTURE_MAGIC "APXCAP01"
+#define APX_CAPTURE_VERSION 1u
+#define APX_CAPTURE_FILE_HEADER_LEN 32u
+#define APX_CAPTURE_RECORD_HEADER_LEN 16u
+#define APX_CAPTURE_RECORD_ALIGN 8u
+#define APX_CAPTURE_DIRECTION_BIT 0x80000000u
+#ifndef APX_CAPTURE_GROW_SIZE
+#define APX_CAPTURE_GROW_SIZE (16u*1024u*1024u) //the log file is extended (and remapped) in steps of this size
+#endif
+
+#define APX_CAPTURE_RX 0u //frame received from the peer
+#define APX_CAPTURE_TX 1u //frame sent to the peer
+
+typedef struct apx_captureRecord_tag
+{
+   uint64_t timestamp; //nanoseconds since the log was opened
+   uint32_t connectionId;
+   uint8_t direction; //APX_CAPTURE_RX or APX_CAPTURE_TX
+   uint32_t frameLen;
+   const uint8_t *frame; //weak pointer into the mapped log
+}apx_captureRecord_t;
+
+typedef struct apx_capture_tag
+{
+   SPINLOCK_T lock; //serializes appends from socket threads and fileManager worker threads
+#ifdef _WIN32
+   FILE *fp;
+#else
+   int fd;
+   uint8_t *pBegin; //mapped region
+#endif
+   uint64_t mapLen;
+   uint64_t writeOffset;
+   uint64_t startTime; //monotonic clock at open, nanoseconds
+   uint64_t numRecords;
+   uint32_t nextConnectionId;
+   bool isOpen;
+}apx_capture_t;
+
+typedef struct apx_captureReader_tag
+{
+   const uint8_t *pBegin;
+   uint64_t len;
+   uint64_t readOffset;
+   uint64_t wallClockStart; //seconds since epoch when the log was opened
+}apx_captureReader_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+int8_t apx_capture_open(apx_capture_t *self, const char *path);
+void apx_capture_close(apx_capture_t *self);
+uint32_t apx_capture_newConnectionId(apx_capture_t *self);
+int8_t apx_capture_write(apx_capture_t *self, uint32_t connectionId, uint8_t direction, const uint8_t *frame, uint32_t frameLen);
+uint64_t apx_capture_getTime(void);
+
+int8_t apx_captureReader_open(apx_captureReader_t *self, const char *path);
+void apx_captureReader_close(apx_captureReader_t *self);
+int8_t apx_captureReader_next(apx_captureReader_t *self, apx_captureRecord_t *record);
+void apx_captureReader_rewind(apx_captureReader_t *self);
+
+#endif //APX_EMBEDDED
+
+#endif //APX_CAPTURE_H
@@ -0,0 +1,59 @@
+/**
+ * file: apx_connectionStats.h
+ * description: runtime counters of a single connection. Counters are updated with atomic adds from the socket thread
+ *              and the fileManager worker thread, readers take a snapshot with apx_fileManager_getStats.
+ */
+#ifndef APX_CONNECTION_STATS_H
+#define APX_CONNECTION_STATS_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <Windows.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+#define APX_STATS_ADD32(x, n) InterlockedExchangeAdd((volatile LONG*) &(x), (LONG) (n))
+#define APX_STATS_ADD64(x, n) InterlockedExchangeAdd64((volatile LONGLONG*) &(x), (LONGLONG) (n))
+#else
+#define APX_STATS_ADD32(x, n) __sync_fetch_and_add(&(x), (uint32_t) (n))
+#define APX_STATS_ADD64(x, n) __sync_fetch_and_add(&(x), (uint64_t) (n))
+#endif
+#define APX_STATS_INC(x) APX_STATS_ADD32(x, 1u)
+
+typedef struct apx_connectionStats_tag
+{
+   volatile uint32_t numMessagesIn; //complete messages received (including the greeting)
+   volatile uint32_t numMessagesOut;
+   volatile uint64_t numBytesIn; //includes message headers
+   volatile uint64_t numBytesOut;
+   volatile uint32_t queueHighWater; //peak number of pending messages in the fileManager worker queue
+   volatile uint32_t numSendStalls; //no send buffer was available or the transmit handler failed
+   volatile uint32_t numDroppedMessages; //worker queue was full or the write data could not be allocated
+   volatile uint32_t numTriggers; //write commands fanned out to other connections by data received on this connection
+   volatile uint32_t numConflatedMessages; //port data writes superseded (fully or partly) by a later write in the same receive batch
+   //the fields below are only filled in by apx_fileManager_getStats
+   uint32_t queueDepth;
+   uint32_t allocatorObjectsInUse;
+   uint32_t allocatorBytesInUse; //upper bound, small objects are counted with the size of their size class
+}apx_connectionStats_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void apx_connectionStats_create(apx_connectionStats_t *self);
+void apx_connectionStats_updateMax(volatile uint32_t *counter, uint32_t value);
+int32_t apx_connectionStats_toText(const apx_connectionStats_t *self, char *buf, uint32_t bufLen);
+int32_t apx_connectionStats_toJson(const apx_connectionStats_t *self, char *buf, uint32_t bufLen);
+
+#endif //APX_CONNECTION_STATS_H
@@ -2,6 +2,7 @@
 #define APX_DATA_SIGNATURE_H
 #include <stdint.h>
 #include "apx_dataElement.h"
+#include "apx_packProgram.h"
 
 #define APX_DSG_TYPE_SENDER_RECEIVER   0
 #define APX_DSG_TYPE_CLIENT_SERVER     1
@@ -11,6 +12,7 @@ typedef struct apx_dataSignature_tag
    char *str;
    uint8_t dsgType; //this will always have value APX_DSG_TYPE_SENDER_RECEIVER until client/server has been implemented
    apx_dataElement_t *dataElement;
+   apx_packProgram_t packProgram; //compiled from dataElement, used for fast packing/unpacking
    //TODO: implement support for client/server interfaces here
 }apx_dataSignature_t;
 
@@ -22,5 +24,8 @@ int8_t apx_dataSignature_create(apx_dataSignature_t *self, const char *dsg);
 void apx_dataSignature_destroy(apx_dataSignature_t *self);
 uint32_t apx_dataSignature_packLen(apx_dataSignature_t *self);
 int8_t apx_dataSignature_update(apx_dataSignature_t *self,const char *dsg);
+int8_t apx_dataSignature_assign(apx_dataSignature_t *self, const char *dsg, apx_dataElement_t *dataElement);
+uint8_t *apx_dataSignature_pack_dv(apx_dataSignature_t *self, uint8_t *pBegin, uint8_t *pEnd, const dtl_dv_t *dv);
+const uint8_t *apx_dataSignature_unpack_dv(apx_dataSignature_t *self, const uint8_t *pBegin, const uint8_t *pEnd, dtl_dv_t **dv);
 
 #endif //APX_DATA_SIGNATURE_H
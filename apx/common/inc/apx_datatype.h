@@ -2,9 +2,11 @@
 #define APX_DATATYPE_H
 #include <stdint.h>
 
+struct apx_arena_tag;
+
 typedef struct apx_datatype_tag
 {
-   char* pAlloc;
+   char* pAlloc; //NULL when the strings are owned by an arena
    uint32_t allocLen;
    char *name;
    char *dsg;
@@ -13,6 +15,7 @@ typedef struct apx_datatype_tag
 
 /***************** Public Function Declarations *******************/
 apx_datatype_t* apx_datatype_new(const char *name, const char *dsg, const char *attr);
+apx_datatype_t* apx_datatype_newInArena(struct apx_arena_tag *arena, const char *name, const char *dsg, const char *attr);
 void apx_datatype_delete(apx_datatype_t *self);
 void apx_datatype_vdelete(void *arg);
 int8_t apx_datatype_create(apx_datatype_t *self, const char *name, const char *dsg, const char *attr);
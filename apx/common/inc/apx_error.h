@@ -17,6 +17,9 @@
 #define APX_ELEMENT_TYPE_ERROR      5
 #define APX_DV_TYPE_ERROR           6
 #define APX_UNSUPPORTED_ERROR       7
+#define APX_TIMEOUT_ERROR           8
+#define APX_NOT_CONNECTED_ERROR     9
+#define APX_QUEUE_FULL_ERROR        10
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
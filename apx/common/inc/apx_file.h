@@ -23,11 +23,16 @@
 #define APX_INDATA_FILE           2
 #define APX_DEFINITION_FILE       3
 #define APX_USER_DATA_FILE        4
+#define APX_DEFINITION_BIN_FILE   5 //precompiled definition, see apx_binaryDefinition.h
 
 #define APX_MAX_FILE_EXT_LEN      4 //'.xxx'
 #define APX_OUTDATA_FILE_EXT      ".out"
 #define APX_INDATA_FILE_EXT       ".in"
 #define APX_DEFINITION_FILE_EXT   ".apx"
+#define APX_DEFINITION_BIN_FILE_EXT ".apb"
+
+//provides the content of local user data files, returns 0 on success
+typedef int8_t (apx_file_readHandler_t)(void *arg, uint8_t *pDest, uint32_t offset, uint32_t length);
 
 typedef struct apx_file_tag
 {
@@ -36,6 +41,8 @@ typedef struct apx_file_tag
    rmf_fileInfo_t fileInfo;
    uint16_t fileType;
    bool isOpen;
+   apx_file_readHandler_t *readHandler; //only used by local user data files
+   void *readHandlerArg;
 } apx_file_t;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -48,13 +55,16 @@ typedef struct apx_file_tag
 //////////////////////////////////////////////////////////////////////////////
 int8_t apx_file_createLocalFile(apx_file_t *self, uint8_t fileType, apx_nodeData_t *nodeData);
 int8_t apx_file_createRemoteFile(apx_file_t *self, const rmf_fileInfo_t *fileInfo);
+int8_t apx_file_createLocalUserDataFile(apx_file_t *self, const char *name, uint32_t length, apx_file_readHandler_t *readHandler, void *arg);
 #ifndef APX_EMBEDDED
 void apx_file_destroy(apx_file_t *self);
 apx_file_t *apx_file_newLocalFile(uint8_t fileType, apx_nodeData_t *nodeData);
 apx_file_t *apx_file_newLocalDefinitionFile(apx_nodeData_t *nodeData);
+apx_file_t *apx_file_newLocalBinaryDefinitionFile(apx_nodeData_t *nodeData);
 apx_file_t *apx_file_newLocalOutPortDataFile(apx_nodeData_t *nodeData);
 apx_file_t *apx_file_newLocalInPortDataFile(apx_nodeData_t *nodeData);
 apx_file_t *apx_file_newRemoteFile(const rmf_fileInfo_t *fileInfo);
+apx_file_t *apx_file_newLocalUserDataFile(const char *name, uint32_t length, apx_file_readHandler_t *readHandler, void *arg);
 void apx_file_delete(apx_file_t *self);
 void apx_file_vdelete(void *arg);
 #endif
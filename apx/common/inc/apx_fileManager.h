@@ -28,6 +28,7 @@
 #include "apx_fileMap.h"
 #include "adt_bytearray.h"
 #include "apx_transmitHandler.h"
+#include "apx_connectionStats.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
@@ -40,6 +41,16 @@ struct apx_nodeManager_tag;
 #define APX_FILEMANAGER_CLIENT_MODE 0
 #define APX_FILEMANAGER_SERVER_MODE 1
 
+/**
+ * one RMF message (without the message length header) inside a receive buffer, see apx_fileManager_parseMessages
+ */
+typedef struct apx_fileManagerFrame_tag
+{
+   const uint8_t *msgBuf; //weak pointer into the receive buffer
+   int32_t msgLen;
+}apx_fileManagerFrame_t;
+
+struct apx_fileManagerWrite_tag;
 
 
 
@@ -52,7 +63,7 @@ typedef struct apx_fileManager_tag
    SEMAPHORE_T semaphore; //thread semaphore
 
    //data object, all read/write accesses to these must be protected by the lock variable above
-   rbfs_t ringbuffer; //pending messages
+   rbf32_t ringbuffer; //pending messages, written with rbf32_mpsc_insert (under lock without RBF32_ATOMIC_ENABLE) and read by workerThread without locking
    bool workerThreadValid;
    void *debugInfo;
    uint8_t *ringbufferData; //strong pointer to raw data used by our ringbuffer
@@ -67,9 +78,15 @@ typedef struct apx_fileManager_tag
    uint32_t curFileStartAddress; //cached start address of last accessed file
    uint32_t curFileEndAddress; //cached end address of of last accessed file
    apx_file_t *curFile; //weak pointer to last accessed file
+   uint32_t fragmentStartAddress; //address of the first fragment of the fragmented write in progress, RMF_INVALID_ADDRESS when none
+   struct apx_fileManagerWrite_tag *batchWrites; //scratch array of apx_fileManager_parseMessages, only used by the receiving thread
+   int32_t batchWritesLen; //number of allocated elements in batchWrites
 
    struct apx_nodeManager_tag *nodeManager; //weak pointer to attached nodeManager
+   struct apx_nodeData_tag *ownedNodeData; //head of the list of remote nodes created for this connection (see apx_nodeData_t.ownerNext), protected by the nodeManager lock
    bool isConnected;
+   volatile bool isDead; //set by apx_fileManager_markDead when the connection is lost, no new messages are queued after that
+   apx_connectionStats_t stats; //updated without locking, see apx_connectionStats.h
 #ifdef _WIN32
    unsigned int threadId;
 #endif
@@ -95,12 +112,17 @@ void apx_fileManager_stop(apx_fileManager_t *self);
 void apx_fileManager_setNodeManager(apx_fileManager_t *self, struct apx_nodeManager_tag *nodeManager); //used to create remote nodes
 void apx_fileManager_setTransmitHandler(apx_fileManager_t *self, apx_transmitHandler_t *handler);
 int32_t apx_fileManager_parseMessage(apx_fileManager_t *self, const uint8_t *msgBuf, int32_t msgLen);
+int8_t apx_fileManager_parseMessages(apx_fileManager_t *self, const apx_fileManagerFrame_t *frames, int32_t numFrames);
 void apx_fileManager_sendFileOpen(apx_fileManager_t *self, uint32_t remoteAddress);
 apx_file_t *apx_fileManager_findRemoteFile(apx_fileManager_t *self, const char *name);
 void apx_fileManager_attachLocalDefinitionFile(apx_fileManager_t *self, apx_file_t *localFile);
 void apx_fileManager_attachLocalPortDataFile(apx_fileManager_t *self, apx_file_t *localFile);
+void apx_fileManager_attachLocalDataFile(apx_fileManager_t *self, apx_file_t *localFile);
 const char *apx_fileManager_modeString(apx_fileManager_t *self);
 void apx_fileManager_setDebugInfo(apx_fileManager_t *self, void *debugInfo);
+void apx_fileManager_getStats(apx_fileManager_t *self, apx_connectionStats_t *stats);
+void apx_fileManager_markDead(apx_fileManager_t *self);
+bool apx_fileManager_isDead(const apx_fileManager_t *self);
 
 //these messages can be sent to the fileManager to be processed by its internal worker thread
 void apx_fileManager_onConnected(apx_fileManager_t *self);
@@ -108,4 +130,10 @@ void apx_fileManager_onDisconnected(apx_fileManager_t *self);
 void apx_fileManager_triggerFileUpdatedEvent(apx_fileManager_t *self, apx_file_t *file, uint32_t offset, uint32_t length);
 void apx_fileManager_triggerFileWriteCmdEvent(apx_fileManager_t *self, apx_file_t *file, const uint8_t *data, apx_offset_t offset, apx_size_t length);
 
+#ifdef UNIT_TEST
+//when set, remote file writes are reported to spy instead of the nodeManager
+typedef void (apx_fileManager_remoteFileWrittenSpy_t)(void *arg, apx_file_t *remoteFile, uint32_t offset, int32_t length);
+void apx_fileManager_setRemoteFileWrittenSpy(apx_fileManager_remoteFileWrittenSpy_t *spy, void *arg);
+#endif
+
 #endif //APX_FILE_MANAGER_H
@@ -2,27 +2,95 @@
 #define APX_LOGGING_H
 
 /**
-* temporary placeholder for APX logging functionality, replace later with system log, or file log support
+* APX logging. Log calls only store the format string pointer and the raw argument values in a lock-free ring buffer
+* owned by the calling thread, a background writer thread formats and prints them (see apx_log_start).
+* Before apx_log_start is called (or after apx_log_stop), messages are printed synchronously.
+* Every call site is rate limited to APX_LOG_RATE_LIMIT messages per second.
+* APX_EMBEDDED builds keep the plain fprintf macros and do not need apx_logging.c.
 */
 extern int8_t g_debug; // Global variable from main
 
 //////////////////////////////////////////////////////////////////////////////
 // INCLUDES
 //////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdarg.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_LOG_LEVEL_NONE       0u
+#define APX_LOG_LEVEL_ERROR      1u
+#define APX_LOG_LEVEL_WARNING    2u
+#define APX_LOG_LEVEL_INFO       3u
+#define APX_LOG_LEVEL_DEBUG      4u
+
+#ifndef APX_LOG_MAX_LEVEL
+#define APX_LOG_MAX_LEVEL APX_LOG_LEVEL_DEBUG //log calls above this level are removed at compile time
+#endif
+#ifndef APX_LOG_RATE_LIMIT
+#define APX_LOG_RATE_LIMIT 20u //max messages per second and call site, 0 disables rate limiting
+#endif
+
+typedef struct apx_logSite_tag
+{
+   const char *fmt;
+   uint8_t level;
+   //rate limiter state, updated without locking (the limit is approximate when several threads share a call site)
+   volatile uint32_t windowStart;
+   volatile uint32_t windowCount;
+   volatile uint32_t numSuppressed;
+}apx_logSite_t;
+
+typedef void (apx_logHandler_t)(uint8_t level, const char *msg);
+
+#define APX_LOG_SITE_INIT(level, fmt) {fmt, level, 0u, 0u, 0u}
+
 #ifdef UNIT_TEST
 # define APX_LOG_DEBUG(fmt, ...)
 # define APX_LOG_INFO(fmt, ...)
 # define APX_LOG_WARNING(fmt, ...)
 # define APX_LOG_ERROR(fmt, ...)
-#else
+#elif defined(APX_EMBEDDED)
 # include <stdio.h>
 # define APX_LOG_DEBUG(fmt, ...) if(g_debug != 0){fprintf(stdout, fmt "\n", ##__VA_ARGS__);}
 # define APX_LOG_INFO(fmt, ...) if(g_debug != 0){fprintf(stdout, fmt "\n", ##__VA_ARGS__);}
 # define APX_LOG_WARNING(fmt, ...) fprintf(stdout, fmt "\n", ##__VA_ARGS__)
 # define APX_LOG_ERROR(fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#else
+# define APX_LOG_WRITE(level, fmt, ...) do { \
+   if ( ((level) <= APX_LOG_MAX_LEVEL) && ((level) <= g_apx_logLevel) ) \
+   { \
+      static apx_logSite_t apx_logSite = APX_LOG_SITE_INIT(level, fmt); \
+      apx_log_write(&apx_logSite, fmt, ##__VA_ARGS__); \
+   } \
+} while(0)
+# define APX_LOG_DEBUG(fmt, ...) APX_LOG_WRITE(APX_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+# define APX_LOG_INFO(fmt, ...) APX_LOG_WRITE(APX_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+# define APX_LOG_WARNING(fmt, ...) APX_LOG_WRITE(APX_LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+# define APX_LOG_ERROR(fmt, ...) APX_LOG_WRITE(APX_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
 #endif
+
 //////////////////////////////////////////////////////////////////////////////
-// CONSTANTS AND DATA TYPES
+// GLOBAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
+extern volatile uint8_t g_apx_logLevel;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+int8_t apx_log_start(void);
+void apx_log_stop(void);
+void apx_log_flush(void);
+void apx_log_setLevel(uint8_t level);
+uint8_t apx_log_getLevel(void);
+void apx_log_setHandler(apx_logHandler_t *handler);
+#ifdef __GNUC__
+void apx_log_write(apx_logSite_t *site, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+#else
+void apx_log_write(apx_logSite_t *site, const char *fmt, ...);
+#endif
+int32_t apx_log_encodeArgs(uint8_t *dest, uint32_t destLen, const char *fmt, va_list args);
+int32_t apx_log_decodeArgs(char *dest, uint32_t destLen, const char *fmt, const uint8_t *src, uint32_t srcLen);
 
 #endif //APX_LOGGING_H
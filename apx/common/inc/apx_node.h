@@ -6,6 +6,7 @@
 #include "apx_datatype.h"
 #include "apx_port.h"
 #include "apx_attributeParser.h"
+#include "apx_arena.h"
 #if defined(_MSC_PLATFORM_TOOLSET) && (_MSC_PLATFORM_TOOLSET<=110)
 #include "msc_bool.h"
 #else
@@ -16,6 +17,7 @@ struct apx_node_t;
 struct apx_nodeInfo_tag;
 
 typedef struct apx_node_t{
+   apx_arena_t arena; //owns all datatype and port objects (and their strings) of this node
    adt_ary_t datatypeList;
    adt_ary_t requirePortList;
    adt_ary_t providePortList;
@@ -26,6 +28,8 @@ typedef struct apx_node_t{
    struct apx_nodeInfo_tag *nodeInfo;
    bool isFinalized;
    apx_attributeParser_t attributeParser;
+   adt_bytearray_t inPortInitData; //init data of all require ports, precomputed by apx_node_finalize
+   adt_bytearray_t outPortInitData; //init data of all provide ports, precomputed by apx_node_finalize
 } apx_node_t;
 
 
@@ -40,6 +44,7 @@ void apx_node_destroy(apx_node_t *self);
 
 //node functions
 void apx_node_setName(apx_node_t *self, const char *name);
+int8_t apx_node_reserve(apx_node_t *self, uint32_t definitionLen);
 const char *apx_node_getName(apx_node_t *self);
 
 //datatype functions
@@ -47,12 +52,18 @@ apx_datatype_t *apx_node_createDataType(apx_node_t *self, const char* name, cons
 //port functions
 apx_port_t *apx_node_createRequirePort(apx_node_t *self, const char* name, const char *dsg, const char *attr);
 apx_port_t *apx_node_createProvidePort(apx_node_t *self, const char* name, const char *dsg, const char *attr);
+apx_port_t *apx_node_appendPort(apx_node_t *self, uint8_t portType, const char* name, const char *dsg, const char *attr);
 int8_t apx_node_finalize(apx_node_t *self);
+int8_t apx_node_finalizeWithInitData(apx_node_t *self, const uint8_t *inPortInitData, uint32_t inPortDataLen, const uint8_t *outPortInitData, uint32_t outPortDataLen);
 apx_port_t *apx_node_getRequirePort(apx_node_t *self, int32_t portIndex);
 apx_port_t *apx_node_getProvidePort(apx_node_t *self, int32_t portIndex);
 int32_t apx_node_getNumRequirePorts(apx_node_t *self);
 int32_t apx_node_getNumProvidePorts(apx_node_t *self);
 adt_bytearray_t *apx_node_createPortInitData(apx_node_t *self, apx_port_t *port);
 int32_t apx_node_fillPortInitData(apx_node_t *self, apx_port_t *port, adt_bytearray_t *output);
+const uint8_t *apx_node_getInPortInitData(apx_node_t *self);
+uint32_t apx_node_getInPortDataLen(apx_node_t *self);
+const uint8_t *apx_node_getOutPortInitData(apx_node_t *self);
+uint32_t apx_node_getOutPortDataLen(apx_node_t *self);
 
 #endif //APX_NODE_H
@@ -76,6 +76,7 @@ typedef struct apx_nodeData_tag
    SPINLOCK_T outPortDataLock;
    SPINLOCK_T definitionDataLock;
    SPINLOCK_T internalLock;
+   struct apx_nodeData_tag *ownerNext; //next remote node owned by the same fileManager, maintained by apx_nodeManager
 #endif
    struct apx_file_tag *outPortDataFile;
    struct apx_file_tag *inPortDataFile;
@@ -36,6 +36,7 @@ typedef struct apx_nodeInfo_tag
    uint32_t pendingProvidePortFlags; //number of modified providePortFlags since last check (this is an optimization to reduce some linear search time)
    apx_dataTriggerTable_t outDataTriggerTable; //trigger table routines
    struct apx_nodeData_tag *nodeData; //weak pointer to associated nodeData
+   bool isAttached; //true while the node is attached to an apx_router_t
 } apx_nodeInfo_t;
 
 #define APX_PORT_EVENT_NONE         0
@@ -58,6 +58,7 @@ void apx_nodeManager_setRouter(apx_nodeManager_t *self, struct apx_router_tag *r
 void apx_nodeManager_attachLocalNode(apx_nodeManager_t *self, apx_nodeData_t *nodeData);
 void apx_nodeManager_attachFileManager(apx_nodeManager_t *self, struct apx_fileManager_tag *fileManager);
 void apx_nodeManager_detachFileManager(apx_nodeManager_t *self, struct apx_fileManager_tag *fileManager);
+void apx_nodeManager_detachFileManagers(apx_nodeManager_t *self, struct apx_fileManager_tag **fileManagers, int32_t numFileManagers);
 void apx_nodeManager_setDebugMode(apx_nodeManager_t *self, int8_t debugMode);
 
 #endif //APX_NODE_MANAGER_H
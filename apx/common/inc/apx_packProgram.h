@@ -0,0 +1,68 @@
+#ifndef APX_PACK_PROGRAM_H
+#define APX_PACK_PROGRAM_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include "apx_dataElement.h"
+#include "dtl_type.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_PACK_OP_UINT              0 //unsigned integer of width 1, 2, 4 or 8 bytes
+#define APX_PACK_OP_SINT              1 //signed integer of width 1, 2, 4 or 8 bytes
+#define APX_PACK_OP_STRING            2 //null-padded string of 'count' bytes
+#define APX_PACK_OP_RECORD_BEGIN      3 //enter record, 'count' is number of record fields
+#define APX_PACK_OP_RECORD_END        4 //leave record
+#define APX_PACK_OP_ARRAY_BEGIN       5 //enter array of records, 'count' is array length
+#define APX_PACK_OP_ARRAY_END         6 //repeat from 'jump' until all records in array have been visited
+
+#define APX_PACK_PROGRAM_MAX_DEPTH    16
+
+/**
+ * A single instruction in a pack program.
+ *
+ * For UINT/SINT instructions, count is the array length (0 means scalar) and repeat is the number of consecutive
+ * sibling values (of identical type and array length) that are handled by this instruction.
+ */
+typedef struct apx_packInstruction_tag
+{
+   uint8_t opcode;  //APX_PACK_OP_*
+   uint8_t width;   //number of bytes per element, 0 for non-integer opcodes
+   uint16_t jump;   //used by APX_PACK_OP_ARRAY_END, index of matching APX_PACK_OP_RECORD_BEGIN
+   uint32_t count;  //array length, string length or number of record fields
+   uint32_t repeat; //number of consecutive values merged into this instruction
+   uint32_t offset; //byte offset from start of packed data
+}apx_packInstruction_t;
+
+/**
+ * Flat representation of an apx_dataElement_t tree. Compiled once and then executed for every pack/unpack.
+ */
+typedef struct apx_packProgram_tag
+{
+   apx_packInstruction_t *instructions;
+   uint16_t numInstructions;
+   uint16_t maxDepth; //maximum nesting of record/array instructions
+   uint32_t packLen;
+}apx_packProgram_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void apx_packProgram_create(apx_packProgram_t *self);
+void apx_packProgram_destroy(apx_packProgram_t *self);
+apx_packProgram_t *apx_packProgram_new(void);
+void apx_packProgram_delete(apx_packProgram_t *self);
+int8_t apx_packProgram_compile(apx_packProgram_t *self, const apx_dataElement_t *dataElement);
+void apx_packProgram_clear(apx_packProgram_t *self);
+uint8_t *apx_packProgram_pack_dv(const apx_packProgram_t *self, uint8_t *pBegin, uint8_t *pEnd, const dtl_dv_t *dv);
+const uint8_t *apx_packProgram_unpack_dv(const apx_packProgram_t *self, const uint8_t *pBegin, const uint8_t *pEnd, dtl_dv_t **dv);
+
+#endif //APX_PACK_PROGRAM_H
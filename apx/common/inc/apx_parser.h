@@ -8,6 +8,9 @@ typedef struct apx_parser_tag
 {
    adt_ary_t nodeList;
    apx_node_t *currentNode;
+   uint32_t *nodeReserveLens; //when set, arena memory of the n:th new node is preallocated for nodeReserveLens[n] bytes of text
+   int32_t numNodeReserveLens;
+   int32_t nextNodeReserve;
 }apx_parser_t;
 /***************** Public Function Declarations *******************/
 void apx_parser_create(apx_parser_t *self);
@@ -15,6 +18,7 @@ void apx_parser_destroy(apx_parser_t *self);
 int32_t apx_parser_getNumNodes(apx_parser_t *self);
 apx_node_t *apx_parser_getNode(apx_parser_t *self, int32_t index);
 void apx_parser_clearNodes(apx_parser_t *self);
+int8_t apx_parser_setNodeReserveLens(apx_parser_t *self, const uint8_t *definitionBuf, uint32_t definitionLen);
 #if defined(_WIN32) || defined(__GNUC__)
 apx_node_t *apx_parser_parseFile(apx_parser_t *self, const char *filename);
 #endif
@@ -7,6 +7,8 @@
 #define APX_REQUIRE_PORT 0
 #define APX_PROVIDE_PORT 1
 
+struct apx_arena_tag;
+
 typedef struct apx_port_tag{
 	char *name;
 	char *dataSignature; //underived data signature, this string usually contains just a type reference, e.g. "T[0]"
@@ -15,6 +17,8 @@ typedef struct apx_port_tag{
 	char *portSignature; //full port signature, excluding the initial 'R' or 'P'
 	uint8_t portType; //APX_REQUIRE_PORT or APX_PROVIDE_PORT
 	int32_t portIndex; //index of the port 0..len(ports) where it resides on its parent node
+	int32_t portMapHandle; //slot of this port in its apx_routerPortMapEntry_t, -1 while the port is not in a port map
+	struct apx_arena_tag *arena; //when not NULL the port and its strings are owned by this arena (see apx_port_newInArena)
 }apx_port_t;
 
 /***************** Public Function Declarations *******************/
@@ -23,8 +27,10 @@ void apx_port_create(apx_port_t *self,uint8_t portDirection,const char *name, co
 void apx_port_destroy(apx_port_t *self);
 apx_port_t* apx_providePort_new(const char *name, const char* dataSignature, const char *attributes);
 apx_port_t* apx_requirePort_new(const char *name, const char* dataSignature, const char *attributes);
+apx_port_t* apx_port_newInArena(struct apx_arena_tag *arena, uint8_t portDirection, const char *name, const char* dataSignature, const char *attributes);
 void apx_port_delete(apx_port_t *self);
 void apx_port_vdelete(void *arg);
+void apx_port_vdestroy(void *arg);
 
 void apx_port_setDerivedDataSignature(apx_port_t *self, const char *dataSignature);
 const char *apx_port_derivePortSignature(apx_port_t *self);
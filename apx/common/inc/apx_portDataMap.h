@@ -25,7 +25,8 @@ typedef struct apx_portDataMapEntry_tag
 
 typedef struct apx_portDataMap_tag
 {
-   adt_ary_t elements; //list of apx_portDataMapEntry_t object
+   apx_portDataMapEntry_t *entries; //contiguous array of numEntries elements, one per port with non-zero length
+   int32_t numEntries;
    apx_node_t *node; //pointer to parent node
    int8_t mapType; //APX_REQUIRE_DATA_MAP or APX_PROVIDE_DATA_MAP
    int32_t totalLen; //totalLen=sum([x.length for x in elements]
@@ -52,6 +53,7 @@ void apx_portDataMap_delete(apx_portDataMap_t *self);
 void apx_portDataMap_vdelete(void *arg);
 int8_t apx_portDataMap_build(apx_portDataMap_t *self, apx_node_t *node, uint8_t portType);
 int32_t apx_portDataMap_getDataLen(apx_portDataMap_t *self);
+int32_t apx_portDataMap_getNumEntries(const apx_portDataMap_t *self);
 
 apx_portDataMapEntry_t *apx_portDataMap_getEntry(apx_portDataMap_t *self, int32_t portIndex);
 
@@ -15,12 +15,23 @@ typedef struct apx_router_tag
    int8_t debugMode;
 }apx_router_t;
 
+typedef struct apx_routerStats_tag
+{
+   uint32_t numNodes;
+   uint32_t numProvidePorts;
+   uint32_t numRequirePorts;
+   uint32_t numConnectors; //require ports currently connected to a provider
+   uint32_t routeTableSize; //number of entries in portMap
+}apx_routerStats_t;
+
 /***************** Public Function Declarations *******************/
 void apx_router_create(apx_router_t *self);
 void apx_router_destroy(apx_router_t *self);
 
 void apx_router_attachNodeInfo(apx_router_t *self, apx_nodeInfo_t *nodeInfo);
 void apx_router_detachNodeInfo(apx_router_t *self, apx_nodeInfo_t *nodeInfo);
+void apx_router_detachNodeInfos(apx_router_t *self, apx_nodeInfo_t **nodeInfos, int32_t numNodeInfos);
 void apx_router_setDebugMode(apx_router_t *self, int8_t debugMode);
+void apx_router_getStats(apx_router_t *self, apx_routerStats_t *stats);
 
 #endif //APX_ROUTER_H
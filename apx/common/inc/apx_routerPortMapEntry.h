@@ -12,10 +12,34 @@
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#define APX_PORT_MAP_INVALID_HANDLE -1
+
+/**
+ * A slot either holds a port reference (portref.port != 0) and is linked into the list of used slots (in insertion order),
+ * or it is free and linked into the free list (using next only).
+ * The index of a slot is the handle of the port, it does not change while the port is in the list.
+ */
+typedef struct apx_routerPortSlot_tag
+{
+   apx_portref_t portref;
+   int32_t prev;
+   int32_t next;
+}apx_routerPortSlot_t;
+
+typedef struct apx_routerPortList_tag
+{
+   apx_routerPortSlot_t *slots; //strong pointer
+   int32_t capacity;
+   int32_t length; //number of used slots
+   int32_t head; //oldest port
+   int32_t tail; //newest port
+   int32_t freeHead;
+}apx_routerPortList_t;
+
 typedef struct portMapEntry_tag
 {
-   adt_ary_t requirePorts; //list of apx_portref_t (all require ports that maps to this signal)
-   adt_ary_t providePorts; //list of apx_portref_t (all provide ports that maps to this signal)
+   apx_routerPortList_t requirePorts; //all require ports that maps to this signal
+   apx_routerPortList_t providePorts; //all provide ports that maps to this signal, the newest one is the active provider
 }apx_routerPortMapEntry_t;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -37,8 +61,13 @@ int8_t apx_routerPortMapEntry_insertProvidePort(apx_routerPortMapEntry_t *self,
 int8_t apx_routerPortMapEntry_insertRequirePort(apx_routerPortMapEntry_t *self, apx_node_t *node, int32_t portIndex);
 int8_t apx_routerPortMapEntry_removePort(apx_routerPortMapEntry_t *self, apx_node_t *node, apx_port_t *port);
 
-apx_portref_t *apx_routerPortMapEntry_getProvidePortById(apx_routerPortMapEntry_t *self,int32_t index);
-apx_portref_t *apx_routerPortMapEntry_getRequirePortById(apx_routerPortMapEntry_t *self,int32_t index);
+int32_t apx_routerPortMapEntry_getNumProvidePorts(const apx_routerPortMapEntry_t *self);
+int32_t apx_routerPortMapEntry_getNumRequirePorts(const apx_routerPortMapEntry_t *self);
+apx_portref_t *apx_routerPortMapEntry_getActiveProvider(apx_routerPortMapEntry_t *self);
+apx_portref_t *apx_routerPortMapEntry_getProvidePortById(apx_routerPortMapEntry_t *self,int32_t handle);
+apx_portref_t *apx_routerPortMapEntry_getRequirePortById(apx_routerPortMapEntry_t *self,int32_t handle);
+int32_t apx_routerPortMapEntry_firstRequirePort(const apx_routerPortMapEntry_t *self);
+int32_t apx_routerPortMapEntry_nextRequirePort(const apx_routerPortMapEntry_t *self, int32_t handle);
 
 
 #endif //APX_PORTMAP_ENTRY_H
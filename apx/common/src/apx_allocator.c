@@ -6,9 +6,6 @@
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
-#ifdef _MSC_VER
-#include <process.h>
-#endif
 #include "apx_allocator.h"
 #include "apx_logging.h"
 #ifdef MEM_LEAK_CHECK
@@ -19,13 +16,45 @@
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+#define APX_ALLOCATOR_THREAD_LOCAL __declspec(thread)
+#define APX_ALLOCATOR_ATOMIC_INC(x) ((uint32_t) InterlockedIncrement((volatile LONG*) &(x)))
+#define APX_ALLOCATOR_CAS_PTR(dest, expected, desired) (InterlockedCompareExchangePointer((PVOID volatile*) (dest), (PVOID) (desired), (PVOID) (expected)) == (PVOID) (expected))
+#define APX_ALLOCATOR_XCHG_PTR(dest, value) InterlockedExchangePointer((PVOID volatile*) (dest), (PVOID) (value))
+#define APX_ALLOCATOR_LOAD_PTR(x) (x)
+#define APX_ALLOCATOR_COUNTER_ADD(x, v) ((x) += (v))
+#define APX_ALLOCATOR_COUNTER_GET(x) (x)
+#else
+#define APX_ALLOCATOR_THREAD_LOCAL __thread
+#define APX_ALLOCATOR_ATOMIC_INC(x) __sync_add_and_fetch(&(x), 1u)
+#define APX_ALLOCATOR_CAS_PTR(dest, expected, desired) __sync_bool_compare_and_swap((dest), (expected), (desired))
+#define APX_ALLOCATOR_XCHG_PTR(dest, value) __sync_lock_test_and_set((dest), (value))
+#define APX_ALLOCATOR_LOAD_PTR(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+//single writer counters: a relaxed load and store is enough, no locked instruction is needed
+#define APX_ALLOCATOR_COUNTER_ADD(x, v) __atomic_store_n(&(x), __atomic_load_n(&(x), __ATOMIC_RELAXED) + (v), __ATOMIC_RELAXED)
+#define APX_ALLOCATOR_COUNTER_GET(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#endif
+
+typedef struct apx_allocatorThreadCacheEntry_tag
+{
+   uint32_t allocatorId; //0 when unused
+   apx_allocatorHeap_t *heap;
+}apx_allocatorThreadCacheEntry_t;
+
+//every block is preceded by a pointer to its slab (APX_ALLOCATOR_BLOCK_HEADER_SIZE bytes)
+#define APX_ALLOCATOR_GET_SLAB(ptr) (*((apx_allocatorSlab_t**) (((uint8_t*) (ptr)) - APX_ALLOCATOR_BLOCK_HEADER_SIZE)))
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
-static int8_t apx_allocator_startThread(apx_allocator_t *self);
-static THREAD_PROTO(threadTask,arg);
-
+static uint32_t apx_allocator_getThreadId(void);
+static apx_allocatorHeap_t *apx_allocator_getThreadHeap(apx_allocator_t *self);
+static void apx_allocator_drainRemoteFreeList(apx_allocatorHeap_t *heap);
+static apx_allocatorSlab_t *apx_allocator_addSlab(apx_allocatorHeap_t *heap, uint8_t sizeClass);
+static void apx_allocator_releaseBlock(apx_allocatorHeap_t *heap, apx_allocatorSlab_t *slab, apx_allocatorBlock_t *block);
+static void apx_allocator_linkSlab(apx_allocatorSlab_t **list, apx_allocatorSlab_t *slab);
+static void apx_allocator_unlinkSlab(apx_allocatorSlab_t **list, apx_allocatorSlab_t *slab);
+static void apx_allocator_freeSlabList(apx_allocatorSlab_t *slab);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -34,243 +63,396 @@ static THREAD_PROTO(threadTask,arg);
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
-
+static const uint32_t m_sizeClasses[APX_ALLOCATOR_NUM_SIZE_CLASSES] =
+{
+   16u, 32u, 48u, 64u, 96u, 128u, 192u, 256u, 384u, 512u, 768u, 1024u, 1536u, 2048u, 3072u, APX_ALLOCATOR_MAX_OBJECT_SIZE
+};
+static volatile uint32_t m_numThreads = 0u;
+static volatile uint32_t m_numAllocators = 0u;
+static APX_ALLOCATOR_THREAD_LOCAL uint32_t m_threadId = 0u; //0 means not yet assigned
+static APX_ALLOCATOR_THREAD_LOCAL apx_allocatorThreadCacheEntry_t m_threadHeaps[APX_ALLOCATOR_THREAD_CACHE_SIZE];
+static APX_ALLOCATOR_THREAD_LOCAL uint32_t m_threadHeapsNext = 0u; //entry replaced on the next cache miss
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
-int8_t apx_allocator_create(apx_allocator_t *self, uint16_t maxPendingMessages)
+int8_t apx_allocator_create(apx_allocator_t *self)
 {
    if (self != 0)
    {
-      size_t numElem;
-      size_t elemSize = sizeof(rbf_data_t);
-
-      numElem = (size_t) maxPendingMessages;
-#ifdef _WIN32
-      self->workerThread = INVALID_HANDLE_VALUE;
-#else
-      self->workerThread = 0;
-#endif
-      self->workerThreadValid=false;
-      SPINLOCK_INIT(self->lock);
-      SEMAPHORE_CREATE(self->semaphore);
-      self->isRunning = false;
-      self->ringBufferLen = (uint16_t) numElem;
-      self->ringBufferData = (uint8_t*) malloc(numElem*elemSize);
-      if (self->ringBufferData == 0)
-      {
-         return -1;
-      }
-      rbfs_create(&self->messages,self->ringBufferData,(uint16_t) numElem,(uint8_t) elemSize);
-      soa_init(&self->soa);
+      memset(self, 0, sizeof(apx_allocator_t));
+      SPINLOCK_INIT(self->heapLock);
+      //ids are never reused, cache entries left behind by a destroyed allocator can therefore never match
+      self->id = APX_ALLOCATOR_ATOMIC_INC(m_numAllocators);
       return 0;
    }
+   errno = EINVAL;
    return -1;
 }
 
+/**
+ * releases all heaps and slabs. Blocks that are still in use become invalid, no other thread may use the allocator.
+ */
 void apx_allocator_destroy(apx_allocator_t *self)
 {
    if (self != 0)
    {
-      if (self->ringBufferData != 0)
+      apx_allocatorHeap_t *heap = self->heaps;
+      while (heap != 0)
       {
-         free(self->ringBufferData);
+         uint8_t sizeClass;
+         apx_allocatorHeap_t *next = heap->next;
+         for (sizeClass = 0; sizeClass < APX_ALLOCATOR_NUM_SIZE_CLASSES; sizeClass++)
+         {
+            apx_allocator_freeSlabList(heap->partialSlabs[sizeClass]);
+            apx_allocator_freeSlabList(heap->fullSlabs[sizeClass]);
+         }
+         free(heap);
+         heap = next;
       }
-      soa_destroy(&self->soa);
-      SEMAPHORE_DESTROY(self->semaphore);
-      SPINLOCK_DESTROY(self->lock);
+      self->heaps = (apx_allocatorHeap_t*) 0;
+      self->numHeaps = 0u;
+      SPINLOCK_DESTROY(self->heapLock);
    }
 }
 
-void apx_allocator_start(apx_allocator_t *self)
+/**
+ * returns a block of at least size bytes, aligned to 8 bytes
+ */
+uint8_t *apx_allocator_alloc(apx_allocator_t *self, size_t size)
 {
-   if( (self != 0) && (self->workerThreadValid == false) )
+   uint8_t *data = 0;
+   if ( (self != 0) && (size > 0) )
    {
-      apx_allocator_startThread(self);
+      if (size <= APX_ALLOCATOR_MAX_OBJECT_SIZE)
+      {
+         apx_allocatorSlab_t *slab;
+         uint8_t sizeClass = apx_allocator_getSizeClass(size);
+         apx_allocatorHeap_t *heap = apx_allocator_getThreadHeap(self);
+         if (heap == 0)
+         {
+            return 0;
+         }
+         apx_allocator_drainRemoteFreeList(heap);
+         slab = heap->partialSlabs[sizeClass];
+         if (slab == 0)
+         {
+            slab = apx_allocator_addSlab(heap, sizeClass);
+         }
+         if (slab != 0)
+         {
+            apx_allocatorBlock_t *block = slab->freeList;
+            assert( (block != 0) && (slab->numFree > 0) );
+            slab->freeList = block->next;
+            if (--slab->numFree == 0u)
+            {
+               apx_allocator_unlinkSlab(&heap->partialSlabs[sizeClass], slab);
+               apx_allocator_linkSlab(&heap->fullSlabs[sizeClass], slab);
+            }
+            APX_ALLOCATOR_COUNTER_ADD(heap->numAllocs[sizeClass], 1u);
+            data = (uint8_t*) block;
+         }
+      }
+      else
+      {
+         data = (uint8_t*) malloc(size);
+         if (data != 0)
+         {
+            APX_ALLOCATOR_ATOMIC_INC(self->numLargeAllocs);
+         }
+      }
    }
+   return data;
 }
 
-void apx_allocator_stop(apx_allocator_t *self)
+/**
+ * size must be the same value that was given to apx_allocator_alloc. May be called from any thread.
+ */
+void apx_allocator_free(apx_allocator_t *self, uint8_t *ptr, uint32_t size)
 {
-   if( (self != 0) && (self->workerThreadValid == true) )
+   if ( (self != 0) && (ptr != 0) )
    {
-#ifdef _MSC_VER
-      DWORD result;
-#endif
-      rbf_data_t data = {0,0}; //sending a null-pointer with size 0 should wake up the workerThread
-      //1. enqueue message
-      SPINLOCK_ENTER(self->lock);
-      self->isRunning = false;
-      rbfs_insert(&self->messages,(const uint8_t*) &data);
-      SPINLOCK_LEAVE(self->lock);
-      //2. wake workerThread
-      SEMAPHORE_POST(self->semaphore);
-#ifdef _MSC_VER
-      result = WaitForSingleObject(self->workerThread, 5000);
-      if (result == WAIT_TIMEOUT)
-      {
-         APX_LOG_ERROR("[APX_ALLOCATOR] timeout while joining workerThread");
-      }
-      else if (result == WAIT_FAILED)
-      {
-         DWORD lastError = GetLastError();
-         APX_LOG_ERROR("[APX_ALLOCATOR]  joining workerThread failed with %d", (int)lastError);         
-      }
-      CloseHandle(self->workerThread);
-      self->workerThread = INVALID_HANDLE_VALUE;
-#else
-      if(pthread_equal(pthread_self(),self->workerThread) == 0)
+      if (size <= APX_ALLOCATOR_MAX_OBJECT_SIZE)
       {
-         void *status;
-         int s = pthread_join(self->workerThread, &status);
-         if (s != 0)
+         apx_allocatorBlock_t *block = (apx_allocatorBlock_t*) ptr;
+         apx_allocatorSlab_t *slab = APX_ALLOCATOR_GET_SLAB(ptr);
+         uint8_t sizeClass = slab->sizeClass;
+         apx_allocatorHeap_t *heap = slab->heap;
+         assert(sizeClass == apx_allocator_getSizeClass(size));
+         if (heap->ownerThreadId == apx_allocator_getThreadId())
          {
-            APX_LOG_ERROR("[APX_ALLOCATOR] pthread_join error %d\n",s);
+            apx_allocator_drainRemoteFreeList(heap);
+            apx_allocator_releaseBlock(heap, slab, block);
+            APX_ALLOCATOR_COUNTER_ADD(heap->numLocalFrees[sizeClass], 1u);
+         }
+         else
+         {
+            //the owner may release the slab as soon as the block is pushed, slab must not be used after this point
+            apx_allocatorBlock_t *head;
+            do
+            {
+               head = heap->remoteFreeList;
+               block->next = head;
+            } while (!APX_ALLOCATOR_CAS_PTR(&heap->remoteFreeList, head, block));
+            APX_ALLOCATOR_ATOMIC_INC(heap->numRemoteFrees[sizeClass]);
          }
       }
       else
       {
-         APX_LOG_ERROR("[APX_ALLOCATOR] pthread_join attempted on pthread_self()\n");
+         free(ptr);
+         APX_ALLOCATOR_ATOMIC_INC(self->numLargeFrees);
       }
-#endif
    }
 }
 
-uint8_t *apx_allocator_alloc(apx_allocator_t *self, size_t size)
+/**
+ * collects statistics of one size class over the heaps of all threads.
+ * Counters of threads that are using the allocator meanwhile are sampled one by one, the result is then approximate.
+ */
+int8_t apx_allocator_getStats(apx_allocator_t *self, uint8_t sizeClass, apx_allocatorStats_t *stats)
 {
-   uint8_t *data = 0;
-   if ( (self != 0) && (size > 0) )
+   if ( (self != 0) && (sizeClass < APX_ALLOCATOR_NUM_SIZE_CLASSES) && (stats != 0) )
    {
-      if (size <= SOA_SMALL_OBJECT_MAX_SIZE)
+      apx_allocatorHeap_t *heap;
+      uint32_t numLocalFrees = 0u;
+      memset(stats, 0, sizeof(apx_allocatorStats_t));
+      stats->objectSize = m_sizeClasses[sizeClass];
+      SPINLOCK_ENTER(self->heapLock);
+      for (heap = self->heaps; heap != 0; heap = heap->next)
       {
-         //use the small object allocator
-         SPINLOCK_ENTER(self->lock);
-         data = (uint8_t*) soa_alloc(&self->soa, size);
-         SPINLOCK_LEAVE(self->lock);
-      }
-      else
-      {
-         //use the default allocator
-         data = (uint8_t*) malloc(size);
+         stats->numSlabs += APX_ALLOCATOR_COUNTER_GET(heap->numSlabs[sizeClass]);
+         stats->numAllocs += APX_ALLOCATOR_COUNTER_GET(heap->numAllocs[sizeClass]);
+         numLocalFrees += APX_ALLOCATOR_COUNTER_GET(heap->numLocalFrees[sizeClass]);
+         stats->numRemoteFrees += APX_ALLOCATOR_COUNTER_GET(heap->numRemoteFrees[sizeClass]);
       }
+      SPINLOCK_LEAVE(self->heapLock);
+      stats->numFrees = numLocalFrees + stats->numRemoteFrees;
+      stats->numInUse = stats->numAllocs - stats->numFrees;
+      return 0;
    }
-   return data;
+   errno = EINVAL;
+   return -1;
 }
 
-void apx_allocator_free(apx_allocator_t *self, uint8_t *ptr, uint32_t size)
+int8_t apx_allocator_getLargeObjectStats(apx_allocator_t *self, apx_allocatorStats_t *stats)
+{
+   if ( (self != 0) && (stats != 0) )
+   {
+      memset(stats, 0, sizeof(apx_allocatorStats_t));
+      stats->numAllocs = self->numLargeAllocs;
+      stats->numFrees = self->numLargeFrees;
+      stats->numInUse = stats->numAllocs - stats->numFrees;
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * returns the number of threads that have used the allocator (each one owns a heap)
+ */
+uint32_t apx_allocator_getNumHeaps(apx_allocator_t *self)
 {
+   uint32_t numHeaps = 0u;
    if (self != 0)
    {
-      rbf_data_t data;
-      data.ptr=ptr;
-      data.size=size;
-      //1. enqueue message
-      SPINLOCK_ENTER(self->lock);
-      rbfs_insert(&self->messages,(const uint8_t*) &data);
-      SPINLOCK_LEAVE(self->lock);
-      //2. wake worker thread
-      SEMAPHORE_POST(self->semaphore);
+      SPINLOCK_ENTER(self->heapLock);
+      numHeaps = self->numHeaps;
+      SPINLOCK_LEAVE(self->heapLock);
    }
+   return numHeaps;
 }
 
+/**
+ * returns index of the smallest size class that fits size bytes. size must be in range 1..APX_ALLOCATOR_MAX_OBJECT_SIZE
+ */
+uint8_t apx_allocator_getSizeClass(size_t size)
+{
+   uint8_t sizeClass = 0;
+   while ( (sizeClass < (APX_ALLOCATOR_NUM_SIZE_CLASSES-1)) && (m_sizeClasses[sizeClass] < size) )
+   {
+      sizeClass++;
+   }
+   return sizeClass;
+}
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
-static int8_t apx_allocator_startThread(apx_allocator_t *self)
+/**
+ * threads are numbered in the order they first use any allocator, numbers are never reused
+ */
+static uint32_t apx_allocator_getThreadId(void)
+{
+   if (m_threadId == 0u)
+   {
+      m_threadId = APX_ALLOCATOR_ATOMIC_INC(m_numThreads);
+   }
+   return m_threadId;
+}
+
+/**
+ * returns the heap of the calling thread, it is created the first time the thread uses the allocator.
+ * The heap is looked up in a small thread-local cache first, the heap list is only searched on a cache miss.
+ */
+static apx_allocatorHeap_t *apx_allocator_getThreadHeap(apx_allocator_t *self)
 {
-   if( self != 0){
-   self->isRunning = true;
-   self->workerThreadValid = true;
-#ifdef _WIN32
-      THREAD_CREATE(self->workerThread,threadTask,self,self->threadId);
-      if(self->workerThread == INVALID_HANDLE_VALUE){
-         self->workerThreadValid = false;
-         return -1;
+   uint32_t i;
+   uint32_t threadId;
+   apx_allocatorHeap_t *heap;
+   for (i = 0; i < APX_ALLOCATOR_THREAD_CACHE_SIZE; i++)
+   {
+      if (m_threadHeaps[i].allocatorId == self->id)
+      {
+         return m_threadHeaps[i].heap;
       }
-#else
-      int rc = THREAD_CREATE(self->workerThread,threadTask,self);
-      if(rc != 0){
-         self->workerThreadValid = false;
-         return -1;
+   }
+   threadId = apx_allocator_getThreadId();
+   SPINLOCK_ENTER(self->heapLock);
+   for (heap = self->heaps; heap != 0; heap = heap->next)
+   {
+      if (heap->ownerThreadId == threadId)
+      {
+         break;
       }
-#endif
-      //from this point forward all access to self must be protected by spin lock
+   }
+   if (heap == 0)
+   {
+      heap = (apx_allocatorHeap_t*) malloc(sizeof(apx_allocatorHeap_t));
+      if (heap != 0)
+      {
+         memset(heap, 0, sizeof(apx_allocatorHeap_t));
+         heap->ownerThreadId = threadId;
+         heap->next = self->heaps;
+         self->heaps = heap;
+         self->numHeaps++;
+      }
+   }
+   SPINLOCK_LEAVE(self->heapLock);
+   if (heap == 0)
+   {
+      APX_LOG_ERROR("[APX_ALLOCATOR] %s", "failed to allocate thread heap");
+      errno = ENOMEM;
       return 0;
    }
-   errno = EINVAL;
-   return -1;
+   m_threadHeaps[m_threadHeapsNext].allocatorId = self->id;
+   m_threadHeaps[m_threadHeapsNext].heap = heap;
+   m_threadHeapsNext = (m_threadHeapsNext + 1u) % APX_ALLOCATOR_THREAD_CACHE_SIZE;
+   return heap;
 }
 
-static THREAD_PROTO(threadTask,arg)
+/**
+ * returns all blocks freed by other threads to their slabs. Must only be called by the thread owning the heap.
+ */
+static void apx_allocator_drainRemoteFreeList(apx_allocatorHeap_t *heap)
 {
-   if(arg!=0)
+   apx_allocatorBlock_t *block;
+   if (APX_ALLOCATOR_LOAD_PTR(heap->remoteFreeList) == 0)
    {
-      rbf_data_t data;
-      apx_allocator_t *self;
-      uint32_t messages_processed=0;
-      self = (apx_allocator_t*) arg;
-      for(;;)
-      {
-#ifdef _MSC_VER
-         DWORD result = WaitForSingleObject(self->semaphore, INFINITE);
-         if (result == WAIT_OBJECT_0)
-#else
-         int result = sem_wait(&self->semaphore);
-         if (result == 0)
-#endif
-         {
-            uint8_t bufResult;
-            bool delayedFree = false;
-            SPINLOCK_ENTER(self->lock);
-            bufResult = rbfs_remove(&self->messages,(uint8_t*) &data);
-            if (bufResult == E_BUF_OK)
-            {
-               if (data.ptr != 0)
-               {
-                  if (data.size<=SOA_SMALL_OBJECT_MAX_SIZE)
-                  {
-                     soa_free(&self->soa,data.ptr,data.size);
-                  }
-                  else
-                  {
-                     delayedFree = true;
-                  }
-               }
-            }
-            SPINLOCK_LEAVE(self->lock);
-            messages_processed++;
-            if (delayedFree == true)
-            {
-               free(data.ptr);
-            }
-            else if ( (bufResult == E_BUF_OK) && (data.ptr == 0) )
-            {
-               break; //NULL pointer is used to exit the thread
-            }
-            else
-            {
-               //Already handled by soa_free or bufResult != E_BUF_OK
-               assert(bufResult == E_BUF_OK);
-            }
-         }
-         else
-         {
-#ifdef _MSC_VER
-            DWORD lastError = GetLastError();
-            APX_LOG_ERROR("[APX_ALLOCATOR]: failure while waiting for semaphore, lastError=%d", lastError);
-#else
-            APX_LOG_ERROR("[APX_ALLOCATOR]: failure while waiting for semaphore, errno=%d", errno);
-#endif
-            break;
-         }
-      }
-      //APX_LOG_DEBUG("[APX_ALLOCATOR]: messages_processed: %u\n", messages_processed);
+      return;
+   }
+   block = (apx_allocatorBlock_t*) APX_ALLOCATOR_XCHG_PTR(&heap->remoteFreeList, 0);
+   while (block != 0)
+   {
+      apx_allocatorBlock_t *next = block->next;
+      apx_allocator_releaseBlock(heap, APX_ALLOCATOR_GET_SLAB(block), block);
+      block = next;
    }
-   THREAD_RETURN(0);
 }
 
+/**
+ * carves a new slab into blocks of the given size class and links it into the partial list. Must only be called by the
+ * thread owning the heap.
+ */
+static apx_allocatorSlab_t *apx_allocator_addSlab(apx_allocatorHeap_t *heap, uint8_t sizeClass)
+{
+   uint32_t blockSize = APX_ALLOCATOR_BLOCK_HEADER_SIZE + m_sizeClasses[sizeClass];
+   uint32_t numBlocks = (APX_ALLOCATOR_SLAB_SIZE - APX_ALLOCATOR_SLAB_HEADER_SIZE) / blockSize;
+   apx_allocatorSlab_t *slab = (apx_allocatorSlab_t*) malloc(APX_ALLOCATOR_SLAB_SIZE);
+   uint8_t *next;
+   uint32_t i;
+   if (slab == 0)
+   {
+      APX_LOG_ERROR("[APX_ALLOCATOR] failed to allocate slab for %u byte objects", (unsigned int) m_sizeClasses[sizeClass]);
+      errno = ENOMEM;
+      return 0;
+   }
+   slab->heap = heap;
+   slab->sizeClass = sizeClass;
+   slab->numBlocks = numBlocks;
+   slab->numFree = numBlocks;
+   //link blocks in address order
+   next = ((uint8_t*) slab) + APX_ALLOCATOR_SLAB_HEADER_SIZE;
+   slab->freeList = (apx_allocatorBlock_t*) (next + APX_ALLOCATOR_BLOCK_HEADER_SIZE);
+   for (i = 0; i < numBlocks; i++)
+   {
+      apx_allocatorBlock_t *block = (apx_allocatorBlock_t*) (next + APX_ALLOCATOR_BLOCK_HEADER_SIZE);
+      *((apx_allocatorSlab_t**) next) = slab;
+      next += blockSize;
+      block->next = (i+1 < numBlocks)? (apx_allocatorBlock_t*) (next + APX_ALLOCATOR_BLOCK_HEADER_SIZE) : (apx_allocatorBlock_t*) 0;
+   }
+   apx_allocator_linkSlab(&heap->partialSlabs[sizeClass], slab);
+   APX_ALLOCATOR_COUNTER_ADD(heap->numSlabs[sizeClass], 1u);
+   return slab;
+}
 
+/**
+ * puts block back on the free list of its slab. The slab is freed when it became empty and another slab of the same
+ * size class still has free blocks. Must only be called by the thread owning the heap.
+ */
+static void apx_allocator_releaseBlock(apx_allocatorHeap_t *heap, apx_allocatorSlab_t *slab, apx_allocatorBlock_t *block)
+{
+   uint8_t sizeClass = slab->sizeClass;
+   block->next = slab->freeList;
+   slab->freeList = block;
+   if (slab->numFree++ == 0u)
+   {
+      apx_allocator_unlinkSlab(&heap->fullSlabs[sizeClass], slab);
+      apx_allocator_linkSlab(&heap->partialSlabs[sizeClass], slab);
+   }
+   if ( (slab->numFree == slab->numBlocks) && ( (heap->partialSlabs[sizeClass] != slab) || (slab->next != 0) ) )
+   {
+      apx_allocator_unlinkSlab(&heap->partialSlabs[sizeClass], slab);
+      APX_ALLOCATOR_COUNTER_ADD(heap->numSlabs[sizeClass], (uint32_t) -1);
+      free(slab);
+   }
+}
 
+static void apx_allocator_linkSlab(apx_allocatorSlab_t **list, apx_allocatorSlab_t *slab)
+{
+   slab->prev = (apx_allocatorSlab_t*) 0;
+   slab->next = *list;
+   if (*list != 0)
+   {
+      (*list)->prev = slab;
+   }
+   *list = slab;
+}
+
+static void apx_allocator_unlinkSlab(apx_allocatorSlab_t **list, apx_allocatorSlab_t *slab)
+{
+   if (slab->prev != 0)
+   {
+      slab->prev->next = slab->next;
+   }
+   else
+   {
+      *list = slab->next;
+   }
+   if (slab->next != 0)
+   {
+      slab->next->prev = slab->prev;
+   }
+   slab->next = (apx_allocatorSlab_t*) 0;
+   slab->prev = (apx_allocatorSlab_t*) 0;
+}
 
+static void apx_allocator_freeSlabList(apx_allocatorSlab_t *slab)
+{
+   while (slab != 0)
+   {
+      apx_allocatorSlab_t *next = slab->next;
+      free(slab);
+      slab = next;
+   }
+}
@@ -0,0 +1,197 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include "apx_arena.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_ARENA_CHUNK_HEADER_SIZE ((uint32_t) ((sizeof(apx_arenaChunk_t) + APX_ARENA_ALIGNMENT - 1u) & ~(APX_ARENA_ALIGNMENT - 1u)))
+#define APX_ARENA_ALIGN(x) (((x) + APX_ARENA_ALIGNMENT - 1u) & ~(APX_ARENA_ALIGNMENT - 1u))
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static apx_arenaChunk_t *apx_arena_addChunk(apx_arena_t *self, uint32_t minSize);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * chunkSize is the size of the first chunk, it is allocated on first use. Use 0 to select APX_ARENA_DEFAULT_CHUNK_SIZE
+ */
+void apx_arena_create(apx_arena_t *self, uint32_t chunkSize)
+{
+   if (self != 0)
+   {
+      self->head = (apx_arenaChunk_t*) 0;
+      self->nextChunkSize = (chunkSize == 0u)? APX_ARENA_DEFAULT_CHUNK_SIZE : APX_ARENA_ALIGN(chunkSize);
+      self->numChunks = 0u;
+      self->totalUsed = 0u;
+   }
+}
+
+void apx_arena_destroy(apx_arena_t *self)
+{
+   if (self != 0)
+   {
+      apx_arenaChunk_t *chunk = self->head;
+      while (chunk != 0)
+      {
+         apx_arenaChunk_t *next = chunk->next;
+         free(chunk);
+         chunk = next;
+      }
+      self->head = (apx_arenaChunk_t*) 0;
+      self->numChunks = 0u;
+      self->totalUsed = 0u;
+   }
+}
+
+apx_arena_t *apx_arena_new(uint32_t chunkSize)
+{
+   apx_arena_t *self = (apx_arena_t*) malloc(sizeof(apx_arena_t));
+   if (self != 0)
+   {
+      apx_arena_create(self, chunkSize);
+   }
+   else
+   {
+      errno = ENOMEM;
+   }
+   return self;
+}
+
+void apx_arena_delete(apx_arena_t *self)
+{
+   if (self != 0)
+   {
+      apx_arena_destroy(self);
+      free(self);
+   }
+}
+
+/**
+ * makes sure that the next size bytes can be allocated from a single chunk.
+ * Use this when the size of what is about to be built is known in advance (e.g. from the length of an APX definition).
+ */
+int8_t apx_arena_reserve(apx_arena_t *self, uint32_t size)
+{
+   if (self != 0)
+   {
+      size = APX_ARENA_ALIGN(size);
+      if ( (self->head == 0) || ( (self->head->size - self->head->used) < size) )
+      {
+         if (apx_arena_addChunk(self, size) == 0)
+         {
+            return -1;
+         }
+      }
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * returns APX_ARENA_ALIGNMENT aligned memory that stays valid until the arena is destroyed
+ */
+void *apx_arena_alloc(apx_arena_t *self, uint32_t size)
+{
+   if ( (self != 0) && (size > 0u) )
+   {
+      uint8_t *ptr;
+      apx_arenaChunk_t *chunk = self->head;
+      size = APX_ARENA_ALIGN(size);
+      if ( (chunk == 0) || ( (chunk->size - chunk->used) < size) )
+      {
+         chunk = apx_arena_addChunk(self, size);
+         if (chunk == 0)
+         {
+            return 0;
+         }
+      }
+      ptr = ((uint8_t*) chunk) + APX_ARENA_CHUNK_HEADER_SIZE + chunk->used;
+      chunk->used += size;
+      self->totalUsed += size;
+      return (void*) ptr;
+   }
+   errno = EINVAL;
+   return 0;
+}
+
+char *apx_arena_strdup(apx_arena_t *self, const char *str)
+{
+   if ( (self != 0) && (str != 0) )
+   {
+      uint32_t len = (uint32_t) strlen(str) + 1u;
+      char *dest = (char*) apx_arena_alloc(self, len);
+      if (dest != 0)
+      {
+         memcpy(dest, str, len);
+      }
+      return dest;
+   }
+   errno = EINVAL;
+   return 0;
+}
+
+uint32_t apx_arena_getUsed(const apx_arena_t *self)
+{
+   if (self != 0)
+   {
+      return self->totalUsed;
+   }
+   return 0u;
+}
+
+uint32_t apx_arena_getNumChunks(const apx_arena_t *self)
+{
+   if (self != 0)
+   {
+      return self->numChunks;
+   }
+   return 0u;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * adds a new head chunk. Chunk sizes double until APX_ARENA_MAX_CHUNK_SIZE to keep the number of chunks small.
+ */
+static apx_arenaChunk_t *apx_arena_addChunk(apx_arena_t *self, uint32_t minSize)
+{
+   apx_arenaChunk_t *chunk;
+   uint32_t size = (minSize > self->nextChunkSize)? minSize : self->nextChunkSize;
+   chunk = (apx_arenaChunk_t*) malloc(APX_ARENA_CHUNK_HEADER_SIZE + size);
+   if (chunk == 0)
+   {
+      errno = ENOMEM;
+      return 0;
+   }
+   chunk->size = size;
+   chunk->used = 0u;
+   chunk->next = self->head;
+   self->head = chunk;
+   self->numChunks++;
+   if (self->nextChunkSize < APX_ARENA_MAX_CHUNK_SIZE)
+   {
+      self->nextChunkSize *= 2u;
+   }
+   return chunk;
+}
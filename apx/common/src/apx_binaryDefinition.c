@@ -0,0 +1,749 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "apx_binaryDefinition.h"
+#include "apx_cfg.h"
+#include "apx_datatype.h"
+#include "apx_error.h"
+#include "apx_logging.h"
+#include "pack.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define FNV1A_64_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV1A_64_PRIME        0x100000001b3ull
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t apx_binaryDefinition_stringLen(const char *str);
+static uint8_t *apx_binaryDefinition_packString(uint8_t *pStringBegin, uint8_t **ppStringNext, uint8_t *pTableEntry, const char *str);
+static void apx_binaryDefinition_measureElement(const apx_dataElement_t *element, uint32_t *numElements, uint32_t *stringTableLen);
+static uint8_t *apx_binaryDefinition_packPorts(uint8_t *pNext, uint8_t *pStringBegin, uint8_t **ppStringNext, adt_ary_t *portList);
+static uint8_t *apx_binaryDefinition_packElement(uint8_t *pNext, uint8_t *pStringBegin, uint8_t **ppStringNext, const apx_dataElement_t *element);
+static int8_t apx_binaryDefinition_getString(const apx_binaryDefinitionInfo_t *info, const uint8_t *pStringTable, const uint8_t *pEntry, const char **str);
+static bool apx_binaryDefinition_isValidName(const char *name);
+static int8_t apx_binaryDefinition_loadPorts(apx_node_t *node, const apx_binaryDefinitionInfo_t *info, const uint8_t *pStringTable, const uint8_t *pNext, uint32_t numPorts, uint8_t portType, const uint8_t *pElementTable, uint32_t *elementIndex);
+static apx_dataElement_t *apx_binaryDefinition_loadElement(const apx_binaryDefinitionInfo_t *info, const uint8_t *pStringTable, const uint8_t *pElementTable, uint32_t *elementIndex, uint32_t depth);
+static uint64_t apx_binaryDefinition_calcPackLen(const apx_dataElement_t *element);
+static int8_t apx_binaryDefinition_matchSignature(const char *dsg, const apx_dataElement_t *dataElement);
+static const char *apx_binaryDefinition_matchElement(const char *pNext, const apx_dataElement_t *element);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * 64-bit FNV-1a digest, used to link the binary definition to the APX text it was compiled from
+ */
+uint64_t apx_binaryDefinition_digest(const uint8_t *data, uint32_t len)
+{
+   uint64_t hash = FNV1A_64_OFFSET_BASIS;
+   if (data != 0)
+   {
+      const uint8_t *pEnd = data + len;
+      while (data < pEnd)
+      {
+         hash ^= (uint64_t) *data++;
+         hash *= FNV1A_64_PRIME;
+      }
+   }
+   return hash;
+}
+
+/**
+ * compiles node into its binary definition. The node is finalized if it has not been already.
+ * definitionText is the APX text the node was parsed from (only its digest and length are stored).
+ * returns a malloc'd buffer on success (caller must free), NULL on error
+ */
+uint8_t *apx_binaryDefinition_compile(apx_node_t *node, const uint8_t *definitionText, uint32_t definitionLen, uint32_t *binaryLen)
+{
+   if ( (node != 0) && (node->name != 0) && (binaryLen != 0) )
+   {
+      int32_t i;
+      int32_t numDatatypes;
+      int32_t numRequirePorts;
+      int32_t numProvidePorts;
+      uint32_t numElements = 0;
+      uint32_t inPortDataLen;
+      uint32_t outPortDataLen;
+      uint32_t stringTableLen;
+      uint32_t totalLen;
+      uint64_t textDigest;
+      uint8_t *data;
+      uint8_t *pNext;
+      uint8_t *pStringBegin;
+      uint8_t *pStringNext;
+
+      if (apx_node_finalize(node) != 0)
+      {
+         return 0;
+      }
+      numDatatypes = adt_ary_length(&node->datatypeList);
+      numRequirePorts = apx_node_getNumRequirePorts(node);
+      numProvidePorts = apx_node_getNumProvidePorts(node);
+      inPortDataLen = apx_node_getInPortDataLen(node);
+      outPortDataLen = apx_node_getOutPortDataLen(node);
+      stringTableLen = apx_binaryDefinition_stringLen(node->name);
+      for (i=0; i<numDatatypes; i++)
+      {
+         apx_datatype_t *datatype = (apx_datatype_t*) adt_ary_value(&node->datatypeList, i);
+         stringTableLen += apx_binaryDefinition_stringLen(datatype->name);
+         stringTableLen += apx_binaryDefinition_stringLen(datatype->dsg);
+         stringTableLen += apx_binaryDefinition_stringLen(datatype->attr);
+      }
+      for (i=0; i<numRequirePorts+numProvidePorts; i++)
+      {
+         apx_port_t *port = (i < numRequirePorts)? apx_node_getRequirePort(node, i) : apx_node_getProvidePort(node, i-numRequirePorts);
+         if ( (port->derivedDsg.str == 0) || (port->derivedDsg.dataElement == 0) )
+         {
+            APX_LOG_ERROR("[APX_BINARY_DEFINITION] port %s of node %s has no data signature", port->name, node->name);
+            apx_setError(APX_PARSE_ERROR);
+            return 0;
+         }
+         stringTableLen += apx_binaryDefinition_stringLen(port->name);
+         stringTableLen += apx_binaryDefinition_stringLen(port->derivedDsg.str);
+         stringTableLen += apx_binaryDefinition_stringLen( (port->portAttributes != 0)? port->portAttributes->rawValue : 0);
+         apx_binaryDefinition_measureElement(port->derivedDsg.dataElement, &numElements, &stringTableLen);
+      }
+      totalLen = APX_BINARY_DEFINITION_HEADER_LEN + ((uint32_t) numDatatypes)*APX_BINARY_DEFINITION_DATATYPE_LEN +
+            ((uint32_t) (numRequirePorts+numProvidePorts))*APX_BINARY_DEFINITION_PORT_LEN + numElements*APX_BINARY_DEFINITION_ELEMENT_LEN +
+            inPortDataLen + outPortDataLen + stringTableLen;
+      data = (uint8_t*) malloc(totalLen);
+      if (data == 0)
+      {
+         apx_setError(APX_MEM_ERROR);
+         return 0;
+      }
+      textDigest = apx_binaryDefinition_digest(definitionText, definitionLen);
+      pNext = data;
+      memcpy(pNext, APX_BINARY_DEFINITION_MAGIC, 4); pNext+=4;
+      packU16LE(pNext, APX_BINARY_DEFINITION_VERSION);
+      packU16LE(pNext, APX_BINARY_DEFINITION_HEADER_LEN);
+      packU32LE(pNext, totalLen);
+      packU32LE(pNext, definitionLen);
+      packU32LE(pNext, (uint32_t) (textDigest & 0xFFFFFFFFu));
+      packU32LE(pNext, (uint32_t) (textDigest >> 32));
+      packU32LE(pNext, (uint32_t) numDatatypes);
+      packU32LE(pNext, (uint32_t) numRequirePorts);
+      packU32LE(pNext, (uint32_t) numProvidePorts);
+      packU32LE(pNext, numElements);
+      packU32LE(pNext, inPortDataLen);
+      packU32LE(pNext, outPortDataLen);
+      packU32LE(pNext, stringTableLen);
+      pStringBegin = data + totalLen - stringTableLen;
+      pStringNext = pStringBegin;
+      memcpy(pStringNext, node->name, strlen(node->name)+1);
+      pStringNext += strlen(node->name)+1;
+      for (i=0; i<numDatatypes; i++)
+      {
+         apx_datatype_t *datatype = (apx_datatype_t*) adt_ary_value(&node->datatypeList, i);
+         pNext = apx_binaryDefinition_packString(pStringBegin, &pStringNext, pNext, datatype->name);
+         pNext = apx_binaryDefinition_packString(pStringBegin, &pStringNext, pNext, datatype->dsg);
+         pNext = apx_binaryDefinition_packString(pStringBegin, &pStringNext, pNext, datatype->attr);
+      }
+      pNext = apx_binaryDefinition_packPorts(pNext, pStringBegin, &pStringNext, &node->requirePortList);
+      pNext = apx_binaryDefinition_packPorts(pNext, pStringBegin, &pStringNext, &node->providePortList);
+      for (i=0; i<numRequirePorts+numProvidePorts; i++)
+      {
+         apx_port_t *port = (i < numRequirePorts)? apx_node_getRequirePort(node, i) : apx_node_getProvidePort(node, i-numRequirePorts);
+         pNext = apx_binaryDefinition_packElement(pNext, pStringBegin, &pStringNext, port->derivedDsg.dataElement);
+      }
+      if (inPortDataLen > 0)
+      {
+         memcpy(pNext, apx_node_getInPortInitData(node), inPortDataLen);
+         pNext += inPortDataLen;
+      }
+      if (outPortDataLen > 0)
+      {
+         memcpy(pNext, apx_node_getOutPortInitData(node), outPortDataLen);
+         pNext += outPortDataLen;
+      }
+      if ( (pNext != pStringBegin) || (pStringNext != data + totalLen) )
+      {
+         APX_LOG_ERROR("[APX_BINARY_DEFINITION] internal length error while compiling node %s", node->name);
+         free(data);
+         return 0;
+      }
+      *binaryLen = totalLen;
+      return data;
+   }
+   errno = EINVAL;
+   return 0;
+}
+
+/**
+ * returns true if data starts with the binary definition magic
+ */
+bool apx_binaryDefinition_isBinary(const uint8_t *data, uint32_t len)
+{
+   return ( (data != 0) && (len >= APX_BINARY_DEFINITION_HEADER_LEN) && (memcmp(data, APX_BINARY_DEFINITION_MAGIC, 4) == 0) );
+}
+
+/**
+ * decodes and validates the header of a binary definition.
+ * returns 0 on success, -1 on error
+ */
+int8_t apx_binaryDefinition_getInfo(const uint8_t *data, uint32_t len, apx_binaryDefinitionInfo_t *info)
+{
+   if ( (data != 0) && (info != 0) )
+   {
+      const uint8_t *pNext;
+      uint16_t version;
+      uint16_t headerLen;
+      uint32_t digestLow;
+      uint32_t digestHigh;
+      uint64_t expectedLen;
+      if (apx_binaryDefinition_isBinary(data, len) == false)
+      {
+         apx_setError(APX_PARSE_ERROR);
+         return -1;
+      }
+      pNext = data+4;
+      version = (uint16_t) unpackLE(pNext, 2); pNext+=2;
+      headerLen = (uint16_t) unpackLE(pNext, 2); pNext+=2;
+      info->totalLen = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->textLen = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      digestLow = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      digestHigh = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->textDigest = (((uint64_t) digestHigh) << 32) | ((uint64_t) digestLow);
+      info->numDatatypes = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->numRequirePorts = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->numProvidePorts = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->numElements = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->inPortDataLen = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->outPortDataLen = (uint32_t) unpackLE(pNext, 4); pNext+=4;
+      info->stringTableLen = (uint32_t) unpackLE(pNext, 4);
+      if ( (version != APX_BINARY_DEFINITION_VERSION) || (headerLen != APX_BINARY_DEFINITION_HEADER_LEN) )
+      {
+         apx_setError(APX_UNSUPPORTED_ERROR);
+         return -1;
+      }
+      expectedLen = (uint64_t) APX_BINARY_DEFINITION_HEADER_LEN + ((uint64_t) info->numDatatypes)*APX_BINARY_DEFINITION_DATATYPE_LEN +
+            ((uint64_t) info->numRequirePorts + (uint64_t) info->numProvidePorts)*APX_BINARY_DEFINITION_PORT_LEN +
+            ((uint64_t) info->numElements)*APX_BINARY_DEFINITION_ELEMENT_LEN + (uint64_t) info->inPortDataLen + (uint64_t) info->outPortDataLen + (uint64_t) info->stringTableLen;
+      if ( (info->totalLen != len) || (expectedLen != (uint64_t) len) || (info->stringTableLen == 0) || (data[len-1] != 0) )
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return -1;
+      }
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * checks that the binary definition was compiled from definitionText, the APX text remains the source of truth.
+ * returns 0 if length and digest of definitionText match the header, -1 otherwise (APX_VALUE_ERROR on mismatch)
+ */
+int8_t apx_binaryDefinition_verifyText(const uint8_t *data, uint32_t len, const uint8_t *definitionText, uint32_t definitionLen)
+{
+   apx_binaryDefinitionInfo_t info;
+   if (apx_binaryDefinition_getInfo(data, len, &info) != 0)
+   {
+      return -1;
+   }
+   if ( (info.textLen != definitionLen) || (info.textDigest != apx_binaryDefinition_digest(definitionText, definitionLen)) )
+   {
+      apx_setError(APX_VALUE_ERROR);
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * creates a finalized node from a binary definition. No APX text, data signature or attribute string is parsed:
+ * data element trees and attributes are rebuilt from the tables, pack programs are compiled from the data element trees
+ * and init data is copied directly from the binary definition.
+ * returns NULL on error
+ */
+apx_node_t *apx_binaryDefinition_createNode(const uint8_t *data, uint32_t len)
+{
+   apx_binaryDefinitionInfo_t info;
+   if (apx_binaryDefinition_getInfo(data, len, &info) == 0)
+   {
+      uint32_t i;
+      uint32_t elementIndex = 0;
+      apx_node_t *node;
+      const uint8_t *pNext = data + APX_BINARY_DEFINITION_HEADER_LEN;
+      const uint8_t *pRequirePorts;
+      const uint8_t *pProvidePorts;
+      const uint8_t *pElementTable;
+      const uint8_t *pInPortInitData;
+      const uint8_t *pOutPortInitData;
+      const uint8_t *pStringTable = data + len - info.stringTableLen;
+      if (apx_binaryDefinition_isValidName((const char*) pStringTable) == false)
+      {
+         apx_setError(APX_PARSE_ERROR);
+         return 0;
+      }
+      node = apx_node_new((const char*) pStringTable);
+      if ( (node == 0) || (apx_node_reserve(node, len) != 0) )
+      {
+         apx_node_delete(node);
+         apx_setError(APX_MEM_ERROR);
+         return 0;
+      }
+      for (i=0; i<info.numDatatypes; i++)
+      {
+         const char *name;
+         const char *dsg;
+         const char *attr;
+         if ( (apx_binaryDefinition_getString(&info, pStringTable, pNext, &name) != 0) ||
+              (apx_binaryDefinition_getString(&info, pStringTable, pNext+4, &dsg) != 0) ||
+              (apx_binaryDefinition_getString(&info, pStringTable, pNext+8, &attr) != 0) ||
+              (apx_node_createDataType(node, name, dsg, attr) == 0) )
+         {
+            apx_node_delete(node);
+            return 0;
+         }
+         pNext += APX_BINARY_DEFINITION_DATATYPE_LEN;
+      }
+      pRequirePorts = pNext;
+      pProvidePorts = pRequirePorts + info.numRequirePorts*APX_BINARY_DEFINITION_PORT_LEN;
+      pElementTable = pProvidePorts + info.numProvidePorts*APX_BINARY_DEFINITION_PORT_LEN;
+      pInPortInitData = pElementTable + info.numElements*APX_BINARY_DEFINITION_ELEMENT_LEN;
+      pOutPortInitData = pInPortInitData + info.inPortDataLen;
+      if ( (apx_binaryDefinition_loadPorts(node, &info, pStringTable, pRequirePorts, info.numRequirePorts, APX_REQUIRE_PORT, pElementTable, &elementIndex) != 0) ||
+           (apx_binaryDefinition_loadPorts(node, &info, pStringTable, pProvidePorts, info.numProvidePorts, APX_PROVIDE_PORT, pElementTable, &elementIndex) != 0) ||
+           (elementIndex != info.numElements) ||
+           (apx_node_finalizeWithInitData(node, pInPortInitData, info.inPortDataLen, pOutPortInitData, info.outPortDataLen) != 0) )
+      {
+         APX_LOG_ERROR("[APX_BINARY_DEFINITION] failed to load node %s", node->name);
+         apx_setError(APX_PARSE_ERROR);
+         apx_node_delete(node);
+         return 0;
+      }
+      return node;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t apx_binaryDefinition_stringLen(const char *str)
+{
+   return (str != 0)? ((uint32_t) strlen(str)) + 1u : 0u;
+}
+
+/**
+ * adds the number of table entries and string table bytes needed by the data element tree
+ */
+static void apx_binaryDefinition_measureElement(const apx_dataElement_t *element, uint32_t *numElements, uint32_t *stringTableLen)
+{
+   (*numElements)++;
+   *stringTableLen += apx_binaryDefinition_stringLen(element->name);
+   if ( (element->baseType == APX_BASE_TYPE_RECORD) && (element->childElements != 0) )
+   {
+      int32_t i;
+      int32_t numChildren = adt_ary_length(element->childElements);
+      for (i=0; i<numChildren; i++)
+      {
+         apx_binaryDefinition_measureElement((const apx_dataElement_t*) adt_ary_value(element->childElements, i), numElements, stringTableLen);
+      }
+   }
+}
+
+/**
+ * copies str into the string table and writes its offset into pTableEntry
+ */
+static uint8_t *apx_binaryDefinition_packString(uint8_t *pStringBegin, uint8_t **ppStringNext, uint8_t *pTableEntry, const char *str)
+{
+   if (str != 0)
+   {
+      uint32_t len = (uint32_t) strlen(str)+1;
+      packU32LE(pTableEntry, (uint32_t) (*ppStringNext - pStringBegin));
+      memcpy(*ppStringNext, str, len);
+      *ppStringNext += len;
+   }
+   else
+   {
+      packU32LE(pTableEntry, APX_BINARY_DEFINITION_NO_STRING);
+   }
+   return pTableEntry;
+}
+
+static uint8_t *apx_binaryDefinition_packPorts(uint8_t *pNext, uint8_t *pStringBegin, uint8_t **ppStringNext, adt_ary_t *portList)
+{
+   int32_t i;
+   int32_t numPorts = adt_ary_length(portList);
+   uint32_t dataOffset = 0;
+   for (i=0; i<numPorts; i++)
+   {
+      apx_port_t *port = (apx_port_t*) adt_ary_value(portList, i);
+      int32_t packLen = apx_port_getPackLen(port);
+      int32_t queueLen = -1;
+      uint32_t flags = 0u;
+      if (packLen < 0)
+      {
+         packLen = 0;
+      }
+      if (port->portAttributes != 0)
+      {
+         queueLen = port->portAttributes->queueLen;
+         flags |= (port->portAttributes->isQueued == true)? APX_BINARY_DEFINITION_FLAG_QUEUED : 0u;
+         flags |= (port->portAttributes->isParameter == true)? APX_BINARY_DEFINITION_FLAG_PARAMETER : 0u;
+      }
+      pNext = apx_binaryDefinition_packString(pStringBegin, ppStringNext, pNext, port->name);
+      pNext = apx_binaryDefinition_packString(pStringBegin, ppStringNext, pNext, port->derivedDsg.str);
+      pNext = apx_binaryDefinition_packString(pStringBegin, ppStringNext, pNext, (port->portAttributes != 0)? port->portAttributes->rawValue : 0);
+      packU32LE(pNext, (uint32_t) packLen);
+      packU32LE(pNext, dataOffset);
+      packU32LE(pNext, (uint32_t) queueLen);
+      packU32LE(pNext, flags);
+      dataOffset += (uint32_t) packLen;
+   }
+   return pNext;
+}
+
+/**
+ * writes the data element tree in pre-order
+ */
+static uint8_t *apx_binaryDefinition_packElement(uint8_t *pNext, uint8_t *pStringBegin, uint8_t **ppStringNext, const apx_dataElement_t *element)
+{
+   int32_t i;
+   int32_t numChildren = 0;
+   if ( (element->baseType == APX_BASE_TYPE_RECORD) && (element->childElements != 0) )
+   {
+      numChildren = adt_ary_length(element->childElements);
+   }
+   pNext = apx_binaryDefinition_packString(pStringBegin, ppStringNext, pNext, element->name);
+   packU32LE(pNext, (uint32_t) (uint8_t) element->baseType);
+   packU32LE(pNext, (uint32_t) numChildren);
+   packU32LE(pNext, element->arrayLen);
+   packU32LE(pNext, element->packLen);
+   packU32LE(pNext, element->min.u32);
+   packU32LE(pNext, element->max.u32);
+   for (i=0; i<numChildren; i++)
+   {
+      pNext = apx_binaryDefinition_packElement(pNext, pStringBegin, ppStringNext, (const apx_dataElement_t*) adt_ary_value(element->childElements, i));
+   }
+   return pNext;
+}
+
+/**
+ * reads string offset from pEntry and sets *str to the string it refers to (NULL when there is no string).
+ * Since getInfo verified that the string table ends with a null-terminator any in-range offset is a valid string.
+ */
+static int8_t apx_binaryDefinition_getString(const apx_binaryDefinitionInfo_t *info, const uint8_t *pStringTable, const uint8_t *pEntry, const char **str)
+{
+   uint32_t offset = (uint32_t) unpackLE(pEntry, 4);
+   if (offset == APX_BINARY_DEFINITION_NO_STRING)
+   {
+      *str = 0;
+      return 0;
+   }
+   if (offset >= info->stringTableLen)
+   {
+      apx_setError(APX_LENGTH_ERROR);
+      return -1;
+   }
+   *str = (const char*) &pStringTable[offset];
+   return 0;
+}
+
+/**
+ * returns true if name is non-empty and not longer than names accepted by the APX text parser
+ */
+static bool apx_binaryDefinition_isValidName(const char *name)
+{
+   return ( (name != 0) && (name[0] != 0) && (strlen(name) < APX_MAX_NAME_LEN) );
+}
+
+/**
+ * appends ports and sets their derived data signature from the element table.
+ * The data element tree must describe the same type as the data signature string (the router matches ports on the
+ * string), the compiled pack program must agree with the pack length of the tree and the stored pack length and
+ * offset of each port must agree with both.
+ */
+static int8_t apx_binaryDefinition_loadPorts(apx_node_t *node, const apx_binaryDefinitionInfo_t *info, const uint8_t *pStringTable, const uint8_t *pNext, uint32_t numPorts, uint8_t portType, const uint8_t *pElementTable, uint32_t *elementIndex)
+{
+   uint32_t i;
+   uint32_t dataOffset = 0;
+   for (i=0; i<numPorts; i++)
+   {
+      const char *name;
+      const char *dsg;
+      const char *attr;
+      apx_port_t *port;
+      apx_dataElement_t *dataElement;
+      uint32_t flags;
+      if ( (apx_binaryDefinition_getString(info, pStringTable, pNext, &name) != 0) ||
+           (apx_binaryDefinition_getString(info, pStringTable, pNext+4, &dsg) != 0) ||
+           (apx_binaryDefinition_getString(info, pStringTable, pNext+8, &attr) != 0) ||
+           (apx_binaryDefinition_isValidName(name) == false) || (dsg == 0) )
+      {
+         apx_setError(APX_PARSE_ERROR);
+         return -1;
+      }
+      port = apx_node_appendPort(node, portType, name, dsg, attr);
+      if (port == 0)
+      {
+         apx_setError(APX_MEM_ERROR);
+         return -1;
+      }
+      if (port->portAttributes != 0)
+      {
+         flags = (uint32_t) unpackLE(pNext+24, 4);
+         port->portAttributes->queueLen = (int32_t) unpackLE(pNext+20, 4);
+         port->portAttributes->isQueued = ( (flags & APX_BINARY_DEFINITION_FLAG_QUEUED) != 0u);
+         port->portAttributes->isParameter = ( (flags & APX_BINARY_DEFINITION_FLAG_PARAMETER) != 0u);
+         port->portAttributes->isFinalized = true;
+      }
+      dataElement = apx_binaryDefinition_loadElement(info, pStringTable, pElementTable, elementIndex, 1);
+      if ( (dataElement == 0) || (apx_dataSignature_assign(&port->derivedDsg, dsg, dataElement) != 0) )
+      {
+         return -1;
+      }
+      if (apx_binaryDefinition_matchSignature(dsg, dataElement) != 0)
+      {
+         APX_LOG_ERROR("[APX_BINARY_DEFINITION] element table of port %s does not match its data signature %s", name, dsg);
+         apx_setError(APX_PARSE_ERROR);
+         return -1;
+      }
+      if ( (apx_port_derivePortSignature(port) == 0) ||
+           (port->derivedDsg.packProgram.numInstructions == 0) ||
+           (port->derivedDsg.packProgram.packLen != dataElement->packLen) ||
+           ( (uint32_t) unpackLE(pNext+12, 4) != dataElement->packLen) ||
+           ( (uint32_t) unpackLE(pNext+16, 4) != dataOffset) )
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return -1;
+      }
+      dataOffset += apx_dataSignature_packLen(&port->derivedDsg);
+      pNext += APX_BINARY_DEFINITION_PORT_LEN;
+   }
+   return 0;
+}
+
+/**
+ * rebuilds the data element tree starting at *elementIndex and advances *elementIndex past it.
+ * Records nested deeper than a pack program supports are rejected, this also bounds the recursion.
+ * The stored pack length of each element must match the one calculated from its type, array length and children.
+ * Since the init data of every port is part of the binary definition no element can be longer than the binary itself,
+ * this bounds arrayLen.
+ * returns NULL on error
+ */
+static apx_dataElement_t *apx_binaryDefinition_loadElement(const apx_binaryDefinitionInfo_t *info, const uint8_t *pStringTable, const uint8_t *pElementTable, uint32_t *elementIndex, uint32_t depth)
+{
+   const uint8_t *pNext;
+   const char *name;
+   int8_t baseType;
+   uint32_t i;
+   uint32_t numChildren;
+   uint64_t packLen;
+   apx_dataElement_t *element;
+   if ( (*elementIndex >= info->numElements) || (depth > APX_PACK_PROGRAM_MAX_DEPTH) )
+   {
+      apx_setError(APX_LENGTH_ERROR);
+      return 0;
+   }
+   pNext = pElementTable + (*elementIndex)*APX_BINARY_DEFINITION_ELEMENT_LEN;
+   (*elementIndex)++;
+   baseType = (int8_t) pNext[4];
+   numChildren = (uint32_t) unpackLE(pNext+8, 4);
+   if ( (apx_binaryDefinition_getString(info, pStringTable, pNext, &name) != 0) ||
+        ( (name != 0) && (apx_binaryDefinition_isValidName(name) == false) ) ||
+        (baseType < APX_BASE_TYPE_NONE) || (baseType > APX_BASE_TYPE_RECORD) ||
+        ( (baseType != APX_BASE_TYPE_RECORD) && (numChildren > 0) ) ||
+        (numChildren > info->numElements - *elementIndex) )
+   {
+      apx_setError(APX_PARSE_ERROR);
+      return 0;
+   }
+   element = apx_dataElement_new(baseType, name);
+   if (element == 0)
+   {
+      apx_setError(APX_MEM_ERROR);
+      return 0;
+   }
+   element->arrayLen = (uint32_t) unpackLE(pNext+12, 4);
+   element->packLen = (uint32_t) unpackLE(pNext+16, 4);
+   element->min.u32 = (uint32_t) unpackLE(pNext+20, 4);
+   element->max.u32 = (uint32_t) unpackLE(pNext+24, 4);
+   for (i=0; i<numChildren; i++)
+   {
+      apx_dataElement_t *child = apx_binaryDefinition_loadElement(info, pStringTable, pElementTable, elementIndex, depth+1);
+      if (child == 0)
+      {
+         apx_dataElement_delete(element);
+         return 0;
+      }
+      apx_dataElement_appendChild(element, child);
+   }
+   packLen = apx_binaryDefinition_calcPackLen(element);
+   if ( (packLen != (uint64_t) element->packLen) || (packLen > (uint64_t) info->totalLen) )
+   {
+      apx_setError(APX_LENGTH_ERROR);
+      apx_dataElement_delete(element);
+      return 0;
+   }
+   return element;
+}
+
+/**
+ * calculates the pack length of an element the same way the APX text parser does, children must already be validated
+ */
+static uint64_t apx_binaryDefinition_calcPackLen(const apx_dataElement_t *element)
+{
+   uint64_t packLen = 0u;
+   if (element->baseType == APX_BASE_TYPE_RECORD)
+   {
+      int32_t i;
+      int32_t numChildren = adt_ary_length(element->childElements);
+      for (i=0; i<numChildren; i++)
+      {
+         packLen += ((const apx_dataElement_t*) adt_ary_value(element->childElements, i))->packLen;
+      }
+   }
+   else
+   {
+      uint64_t elemLen = 0u;
+      switch(element->baseType)
+      {
+      case APX_BASE_TYPE_UINT8:
+      case APX_BASE_TYPE_SINT8:
+      case APX_BASE_TYPE_STRING:
+         elemLen = 1u;
+         break;
+      case APX_BASE_TYPE_UINT16:
+      case APX_BASE_TYPE_SINT16:
+         elemLen = 2u;
+         break;
+      case APX_BASE_TYPE_UINT32:
+      case APX_BASE_TYPE_SINT32:
+         elemLen = 4u;
+         break;
+      default:
+         break;
+      }
+      packLen = elemLen * ( (element->arrayLen > 0)? (uint64_t) element->arrayLen : 1u);
+   }
+   return packLen;
+}
+
+/**
+ * checks that the data element tree describes the type written in the data signature string: same record layout,
+ * base types and array lengths. Element names and range limits do not affect the data layout and are skipped.
+ * returns 0 if they match, -1 otherwise
+ */
+static int8_t apx_binaryDefinition_matchSignature(const char *dsg, const apx_dataElement_t *dataElement)
+{
+   const char *pNext = dsg;
+   if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+   {
+      int32_t i;
+      int32_t numChildren = adt_ary_length(dataElement->childElements);
+      if ( (*pNext++ != '{') || (dataElement->arrayLen != 0) )
+      {
+         return -1;
+      }
+      for (i=0; (i<numChildren) && (pNext != 0); i++)
+      {
+         pNext = apx_binaryDefinition_matchElement(pNext, (const apx_dataElement_t*) adt_ary_value(dataElement->childElements, i));
+      }
+      if ( (pNext == 0) || (*pNext++ != '}') )
+      {
+         return -1;
+      }
+   }
+   else
+   {
+      pNext = apx_binaryDefinition_matchElement(pNext, dataElement);
+   }
+   return ( (pNext != 0) && (*pNext == 0) )? 0 : -1;
+}
+
+/**
+ * matches a single non-record element: optional "name", type character, optional [arrayLen] and optional (min,max).
+ * returns pointer to the first character after the element or NULL if it does not match
+ */
+static const char *apx_binaryDefinition_matchElement(const char *pNext, const apx_dataElement_t *element)
+{
+   int8_t baseType;
+   uint32_t arrayLen = 0u;
+   if (*pNext == '"')
+   {
+      pNext++;
+      while ( (*pNext != 0) && (*pNext != '"') )
+      {
+         if ( (*pNext == '\\') && (pNext[1] != 0) )
+         {
+            pNext++;
+         }
+         pNext++;
+      }
+      if (*pNext++ != '"')
+      {
+         return 0;
+      }
+   }
+   switch(*pNext++)
+   {
+   case 'C':
+      baseType = APX_BASE_TYPE_UINT8;
+      break;
+   case 'S':
+      baseType = APX_BASE_TYPE_UINT16;
+      break;
+   case 'L':
+      baseType = APX_BASE_TYPE_UINT32;
+      break;
+   case 'a':
+      baseType = APX_BASE_TYPE_STRING;
+      break;
+   case 'c':
+      baseType = APX_BASE_TYPE_SINT8;
+      break;
+   case 's':
+      baseType = APX_BASE_TYPE_SINT16;
+      break;
+   case 'l':
+      baseType = APX_BASE_TYPE_SINT32;
+      break;
+   default:
+      return 0;
+   }
+   if (*pNext == '[')
+   {
+      char *pEnd;
+      arrayLen = (uint32_t) strtoul(pNext+1, &pEnd, 0);
+      if ( (pEnd == pNext+1) || (*pEnd != ']') )
+      {
+         return 0;
+      }
+      pNext = pEnd+1;
+   }
+   if ( (baseType != element->baseType) || (arrayLen != element->arrayLen) )
+   {
+      return 0;
+   }
+   if (*pNext == '(')
+   {
+      pNext = strchr(pNext, ')');
+      if (pNext == 0)
+      {
+         return 0;
+      }
+      pNext++;
+   }
+   return pNext;
+}
@@ -0,0 +1,415 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef APX_EMBEDDED
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "apx_capture.h"
+#include "apx_logging.h"
+#include "pack.h"
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_CAPTURE_MAGIC_LEN 8u
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void apx_capture_packU64LE(uint8_t *p, uint64_t value);
+static uint64_t apx_capture_unpackU64LE(const uint8_t *p);
+static void apx_capture_packFileHeader(uint8_t *p);
+static void apx_capture_packRecordHeader(uint8_t *p, uint64_t timestamp, uint32_t connectionId, uint8_t direction, uint32_t frameLen);
+#ifndef _WIN32
+static int8_t apx_capture_grow(apx_capture_t *self, uint64_t minLen);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * creates (or truncates) the log file at path and writes the file header
+ */
+int8_t apx_capture_open(apx_capture_t *self, const char *path)
+{
+   if ( (self != 0) && (path != 0) )
+   {
+      uint8_t header[APX_CAPTURE_FILE_HEADER_LEN];
+      self->mapLen = 0u;
+      self->writeOffset = 0u;
+      self->numRecords = 0u;
+      self->nextConnectionId = 0u;
+      self->isOpen = false;
+      apx_capture_packFileHeader(header);
+#ifdef _WIN32
+      self->fp = fopen(path, "wb");
+      if (self->fp == 0)
+      {
+         return -1;
+      }
+      if (fwrite(header, 1, sizeof(header), self->fp) != sizeof(header))
+      {
+         fclose(self->fp);
+         self->fp = 0;
+         return -1;
+      }
+#else
+      self->pBegin = (uint8_t*) 0;
+      self->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (self->fd < 0)
+      {
+         APX_LOG_ERROR("[APX_CAPTURE] cannot open %s, errno=%d", path, errno);
+         return -1;
+      }
+      if (apx_capture_grow(self, APX_CAPTURE_FILE_HEADER_LEN) != 0)
+      {
+         close(self->fd);
+         self->fd = -1;
+         return -1;
+      }
+      memcpy(self->pBegin, header, sizeof(header));
+#endif
+      self->writeOffset = APX_CAPTURE_FILE_HEADER_LEN;
+      SPINLOCK_INIT(self->lock);
+      self->startTime = apx_capture_getTime();
+      self->isOpen = true;
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * unmaps the log and truncates the file to the written length. All connections using the log must be stopped first.
+ */
+void apx_capture_close(apx_capture_t *self)
+{
+   if ( (self != 0) && (self->isOpen == true) )
+   {
+      self->isOpen = false;
+#ifdef _WIN32
+      fclose(self->fp);
+      self->fp = 0;
+#else
+      if (self->pBegin != 0)
+      {
+         munmap(self->pBegin, (size_t) self->mapLen);
+         self->pBegin = (uint8_t*) 0;
+      }
+      if (ftruncate(self->fd, (off_t) self->writeOffset) != 0)
+      {
+         APX_LOG_ERROR("[APX_CAPTURE] ftruncate failed, errno=%d", errno);
+      }
+      close(self->fd);
+      self->fd = -1;
+#endif
+      SPINLOCK_DESTROY(self->lock);
+   }
+}
+
+/**
+ * returns a new id that tags the frames of one connection
+ */
+uint32_t apx_capture_newConnectionId(apx_capture_t *self)
+{
+   if (self != 0)
+   {
+      uint32_t connectionId;
+      SPINLOCK_ENTER(self->lock);
+      connectionId = self->nextConnectionId++;
+      SPINLOCK_LEAVE(self->lock);
+      return connectionId;
+   }
+   return 0u;
+}
+
+/**
+ * appends one frame to the log. The frame data is written before the record header so a process crash never leaves
+ * a record header pointing to incomplete data.
+ */
+int8_t apx_capture_write(apx_capture_t *self, uint32_t connectionId, uint8_t direction, const uint8_t *frame, uint32_t frameLen)
+{
+   if ( (self != 0) && (frame != 0) && (frameLen > 0u) && (frameLen < APX_CAPTURE_DIRECTION_BIT) )
+   {
+      uint8_t recordHeader[APX_CAPTURE_RECORD_HEADER_LEN];
+      uint32_t recordLen = APX_CAPTURE_RECORD_HEADER_LEN + frameLen;
+      int8_t retval = 0;
+      recordLen = (recordLen + (APX_CAPTURE_RECORD_ALIGN-1u)) & ~(APX_CAPTURE_RECORD_ALIGN-1u);
+      SPINLOCK_ENTER(self->lock);
+      //timestamp is taken inside the lock to keep the log ordered by time
+      apx_capture_packRecordHeader(recordHeader, apx_capture_getTime() - self->startTime, connectionId, direction, frameLen);
+      if (self->isOpen == false)
+      {
+         retval = -1;
+      }
+      else
+      {
+#ifdef _WIN32
+         static const uint8_t padding[APX_CAPTURE_RECORD_ALIGN] = {0, 0, 0, 0, 0, 0, 0, 0};
+         uint32_t paddingLen = recordLen - APX_CAPTURE_RECORD_HEADER_LEN - frameLen;
+         if ( (fwrite(recordHeader, 1, sizeof(recordHeader), self->fp) != sizeof(recordHeader)) ||
+              (fwrite(frame, 1, frameLen, self->fp) != frameLen) ||
+              (fwrite(padding, 1, paddingLen, self->fp) != paddingLen) )
+         {
+            retval = -1;
+         }
+#else
+         if ( (self->writeOffset + recordLen + APX_CAPTURE_RECORD_HEADER_LEN > self->mapLen) &&
+              (apx_capture_grow(self, self->writeOffset + recordLen + APX_CAPTURE_RECORD_HEADER_LEN) != 0) )
+         {
+            retval = -1;
+         }
+         else
+         {
+            uint8_t *pRecord = self->pBegin + self->writeOffset;
+            memcpy(pRecord + APX_CAPTURE_RECORD_HEADER_LEN, frame, frameLen);
+            memcpy(pRecord, recordHeader, APX_CAPTURE_RECORD_HEADER_LEN);
+         }
+#endif
+         if (retval == 0)
+         {
+            self->writeOffset += recordLen;
+            self->numRecords++;
+         }
+      }
+      SPINLOCK_LEAVE(self->lock);
+      return retval;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * monotonic time in nanoseconds
+ */
+uint64_t apx_capture_getTime(void)
+{
+#ifdef _WIN32
+   LARGE_INTEGER frequency;
+   LARGE_INTEGER counter;
+   QueryPerformanceFrequency(&frequency);
+   QueryPerformanceCounter(&counter);
+   return (uint64_t) ( ( (double) counter.QuadPart * 1000000000.0) / (double) frequency.QuadPart);
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ( (uint64_t) ts.tv_sec) * 1000000000ull + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+/**
+ * maps a capture log for reading and verifies its header
+ */
+int8_t apx_captureReader_open(apx_captureReader_t *self, const char *path)
+{
+   if ( (self != 0) && (path != 0) )
+   {
+      uint32_t headerLen;
+#ifndef _WIN32
+      struct stat st;
+      void *data;
+      int fd = open(path, O_RDONLY);
+      if (fd < 0)
+      {
+         return -1;
+      }
+      if ( (fstat(fd, &st) != 0) || (st.st_size < (off_t) APX_CAPTURE_FILE_HEADER_LEN) )
+      {
+         close(fd);
+         errno = EBADMSG;
+         return -1;
+      }
+      data = mmap(0, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+      if (data == MAP_FAILED)
+      {
+         return -1;
+      }
+      self->pBegin = (const uint8_t*) data;
+      self->len = (uint64_t) st.st_size;
+#else
+      uint8_t *data = 0;
+      long fileLen;
+      FILE *fp = fopen(path, "rb");
+      if (fp == 0)
+      {
+         return -1;
+      }
+      if ( (fseek(fp, 0, SEEK_END) == 0) && ( (fileLen = ftell(fp)) >= (long) APX_CAPTURE_FILE_HEADER_LEN) && (fseek(fp, 0, SEEK_SET) == 0) )
+      {
+         data = (uint8_t*) malloc( (size_t) fileLen);
+         if ( (data != 0) && (fread(data, 1, (size_t) fileLen, fp) != (size_t) fileLen) )
+         {
+            free(data);
+            data = 0;
+         }
+      }
+      fclose(fp);
+      if (data == 0)
+      {
+         errno = EBADMSG;
+         return -1;
+      }
+      self->pBegin = data;
+      self->len = (uint64_t) fileLen;
+#endif
+      headerLen = (uint32_t) unpackLE(&self->pBegin[APX_CAPTURE_MAGIC_LEN+4u], 4u);
+      if ( (memcmp(self->pBegin, APX_CAPTURE_MAGIC, APX_CAPTURE_MAGIC_LEN) != 0) ||
+           ( (uint32_t) unpackLE(&self->pBegin[APX_CAPTURE_MAGIC_LEN], 4u) != APX_CAPTURE_VERSION) ||
+           (headerLen < APX_CAPTURE_FILE_HEADER_LEN) || (headerLen > self->len) )
+      {
+         apx_captureReader_close(self);
+         errno = EBADMSG;
+         return -1;
+      }
+      self->wallClockStart = apx_capture_unpackU64LE(&self->pBegin[APX_CAPTURE_MAGIC_LEN+8u]);
+      self->readOffset = headerLen;
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+void apx_captureReader_close(apx_captureReader_t *self)
+{
+   if ( (self != 0) && (self->pBegin != 0) )
+   {
+#ifndef _WIN32
+      munmap((void*) self->pBegin, (size_t) self->len);
+#else
+      free((void*) self->pBegin);
+#endif
+      self->pBegin = (const uint8_t*) 0;
+      self->len = 0u;
+   }
+}
+
+/**
+ * reads the next record. Returns 1 when a record was read, 0 at end of log and -1 when the log is corrupt.
+ */
+int8_t apx_captureReader_next(apx_captureReader_t *self, apx_captureRecord_t *record)
+{
+   if ( (self != 0) && (record != 0) && (self->pBegin != 0) )
+   {
+      const uint8_t *pNext = self->pBegin + self->readOffset;
+      uint32_t lenField;
+      uint64_t recordLen;
+      if (self->readOffset + APX_CAPTURE_RECORD_HEADER_LEN > self->len)
+      {
+         return 0;
+      }
+      lenField = (uint32_t) unpackLE(&pNext[12], 4u);
+      if (lenField == 0u)
+      {
+         return 0; //end of written data in a log that was not closed properly
+      }
+      record->timestamp = apx_capture_unpackU64LE(pNext);
+      record->connectionId = (uint32_t) unpackLE(&pNext[8], 4u);
+      record->direction = ( (lenField & APX_CAPTURE_DIRECTION_BIT) != 0u)? APX_CAPTURE_TX : APX_CAPTURE_RX;
+      record->frameLen = lenField & ~APX_CAPTURE_DIRECTION_BIT;
+      record->frame = pNext + APX_CAPTURE_RECORD_HEADER_LEN;
+      recordLen = APX_CAPTURE_RECORD_HEADER_LEN + (uint64_t) record->frameLen;
+      if (self->readOffset + recordLen > self->len)
+      {
+         errno = EBADMSG;
+         return -1;
+      }
+      recordLen = (recordLen + (APX_CAPTURE_RECORD_ALIGN-1u)) & ~((uint64_t) (APX_CAPTURE_RECORD_ALIGN-1u));
+      self->readOffset += recordLen;
+      return 1;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+void apx_captureReader_rewind(apx_captureReader_t *self)
+{
+   if ( (self != 0) && (self->pBegin != 0) )
+   {
+      self->readOffset = (uint32_t) unpackLE(&self->pBegin[APX_CAPTURE_MAGIC_LEN+4u], 4u);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void apx_capture_packU64LE(uint8_t *p, uint64_t value)
+{
+   packLE(p, (uint32_t) (value & 0xFFFFFFFFu), 4u);
+   packLE(p+4, (uint32_t) (value >> 32), 4u);
+}
+
+static uint64_t apx_capture_unpackU64LE(const uint8_t *p)
+{
+   uint64_t low = (uint64_t) (uint32_t) unpackLE(p, 4u);
+   uint64_t high = (uint64_t) (uint32_t) unpackLE(p+4, 4u);
+   return (high << 32) | low;
+}
+
+static void apx_capture_packFileHeader(uint8_t *p)
+{
+   memset(p, 0, APX_CAPTURE_FILE_HEADER_LEN);
+   memcpy(p, APX_CAPTURE_MAGIC, APX_CAPTURE_MAGIC_LEN);
+   packLE(&p[APX_CAPTURE_MAGIC_LEN], APX_CAPTURE_VERSION, 4u);
+   packLE(&p[APX_CAPTURE_MAGIC_LEN+4u], APX_CAPTURE_FILE_HEADER_LEN, 4u);
+   apx_capture_packU64LE(&p[APX_CAPTURE_MAGIC_LEN+8u], (uint64_t) time(0));
+}
+
+static void apx_capture_packRecordHeader(uint8_t *p, uint64_t timestamp, uint32_t connectionId, uint8_t direction, uint32_t frameLen)
+{
+   apx_capture_packU64LE(p, timestamp);
+   packLE(&p[8], connectionId, 4u);
+   packLE(&p[12], (direction == APX_CAPTURE_TX)? (frameLen | APX_CAPTURE_DIRECTION_BIT) : frameLen, 4u);
+}
+
+#ifndef _WIN32
+/**
+ * extends the file to at least minLen bytes (rounded up to APX_CAPTURE_GROW_SIZE) and remaps it. Caller must hold the lock.
+ */
+static int8_t apx_capture_grow(apx_capture_t *self, uint64_t minLen)
+{
+   uint64_t newLen = ( (minLen + APX_CAPTURE_GROW_SIZE - 1u) / APX_CAPTURE_GROW_SIZE) * APX_CAPTURE_GROW_SIZE;
+   void *data;
+   if (ftruncate(self->fd, (off_t) newLen) != 0)
+   {
+      APX_LOG_ERROR("[APX_CAPTURE] ftruncate failed, errno=%d", errno);
+      return -1;
+   }
+   if (self->pBegin != 0)
+   {
+      munmap(self->pBegin, (size_t) self->mapLen);
+      self->pBegin = (uint8_t*) 0;
+   }
+   data = mmap(0, (size_t) newLen, PROT_READ | PROT_WRITE, MAP_SHARED, self->fd, 0);
+   if (data == MAP_FAILED)
+   {
+      APX_LOG_ERROR("[APX_CAPTURE] mmap failed, errno=%d", errno);
+      self->mapLen = 0u;
+      return -1;
+   }
+   self->pBegin = (uint8_t*) data;
+   self->mapLen = newLen;
+   return 0;
+}
+#endif
+
+#endif //APX_EMBEDDED
@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include "apx_connectionStats.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+#define APX_STATS_CAS32(x, expected, desired) (InterlockedCompareExchange((volatile LONG*) (x), (LONG) (desired), (LONG) (expected)) == (LONG) (expected))
+#define snprintf _snprintf
+#else
+#define APX_STATS_CAS32(x, expected, desired) __sync_bool_compare_and_swap((x), (expected), (desired))
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static int32_t apx_connectionStats_checkLength(int result, uint32_t bufLen);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void apx_connectionStats_create(apx_connectionStats_t *self)
+{
+   if (self != 0)
+   {
+      memset((void*) self, 0, sizeof(apx_connectionStats_t));
+   }
+}
+
+/**
+ * raises counter to value unless it is already higher. Safe to call from several threads.
+ */
+void apx_connectionStats_updateMax(volatile uint32_t *counter, uint32_t value)
+{
+   if (counter != 0)
+   {
+      uint32_t current = *counter;
+      while (value > current)
+      {
+         if (APX_STATS_CAS32(counter, current, value))
+         {
+            break;
+         }
+         current = *counter;
+      }
+   }
+}
+
+/**
+ * writes the counters as space separated key=value pairs. Returns number of characters written (excluding the null
+ * terminator) or -1 when buf is too small.
+ */
+int32_t apx_connectionStats_toText(const apx_connectionStats_t *self, char *buf, uint32_t bufLen)
+{
+   if ( (self != 0) && (buf != 0) )
+   {
+      int result = snprintf(buf, bufLen, "msgIn=%u bytesIn=%llu msgOut=%u bytesOut=%llu queue=%u queueMax=%u stalls=%u dropped=%u triggers=%u conflated=%u allocObjects=%u allocBytes=%u",
+            (unsigned int) self->numMessagesIn, (unsigned long long) self->numBytesIn,
+            (unsigned int) self->numMessagesOut, (unsigned long long) self->numBytesOut,
+            (unsigned int) self->queueDepth, (unsigned int) self->queueHighWater,
+            (unsigned int) self->numSendStalls, (unsigned int) self->numDroppedMessages, (unsigned int) self->numTriggers,
+            (unsigned int) self->numConflatedMessages,
+            (unsigned int) self->allocatorObjectsInUse, (unsigned int) self->allocatorBytesInUse);
+      return apx_connectionStats_checkLength(result, bufLen);
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * writes the counters as a JSON object. Returns number of characters written (excluding the null terminator)
+ * or -1 when buf is too small.
+ */
+int32_t apx_connectionStats_toJson(const apx_connectionStats_t *self, char *buf, uint32_t bufLen)
+{
+   if ( (self != 0) && (buf != 0) )
+   {
+      int result = snprintf(buf, bufLen, "{\"msgIn\":%u,\"bytesIn\":%llu,\"msgOut\":%u,\"bytesOut\":%llu,\"queue\":%u,\"queueMax\":%u,"
+            "\"stalls\":%u,\"dropped\":%u,\"triggers\":%u,\"conflated\":%u,\"allocObjects\":%u,\"allocBytes\":%u}",
+            (unsigned int) self->numMessagesIn, (unsigned long long) self->numBytesIn,
+            (unsigned int) self->numMessagesOut, (unsigned long long) self->numBytesOut,
+            (unsigned int) self->queueDepth, (unsigned int) self->queueHighWater,
+            (unsigned int) self->numSendStalls, (unsigned int) self->numDroppedMessages, (unsigned int) self->numTriggers,
+            (unsigned int) self->numConflatedMessages,
+            (unsigned int) self->allocatorObjectsInUse, (unsigned int) self->allocatorBytesInUse);
+      return apx_connectionStats_checkLength(result, bufLen);
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static int32_t apx_connectionStats_checkLength(int result, uint32_t bufLen)
+{
+   if ( (result < 0) || ((uint32_t) result >= bufLen) )
+   {
+      errno = ENOBUFS;
+      return -1;
+   }
+   return (int32_t) result;
+}
@@ -29,6 +29,7 @@ static const uint8_t *parseType(const uint8_t *pBegin, const uint8_t *pEnd, apx_
 static const uint8_t *parseArrayLength(const uint8_t *pBegin, const uint8_t *pEnd, apx_dataElement_t *pDataElement);
 static const uint8_t *parseLimit(const uint8_t *pBegin, const uint8_t *pEnd, apx_dataElement_t *pDataElement);
 static void calcPackLen(apx_dataElement_t *pDataElement);
+static void compilePackProgram(apx_dataSignature_t *self);
 /**************** Private Variable Declarations *******************/
 
 
@@ -86,10 +87,14 @@ int8_t apx_dataSignature_create(apx_dataSignature_t *self, const char *dsg)
       {
          self->str = 0;
       }
+      apx_packProgram_create(&self->packProgram);
       if (self->str != 0)
       {
          self->dataElement=apx_dataElement_new(APX_BASE_TYPE_NONE,0);
-         parseDataSignature(self,(const uint8_t*) self->str);
+         if (parseDataSignature(self,(const uint8_t*) self->str) == 0)
+         {
+            compilePackProgram(self);
+         }
       }
       else
       {
@@ -112,6 +117,7 @@ void apx_dataSignature_destroy(apx_dataSignature_t *self)
       {
          free(self->str);
       }
+      apx_packProgram_destroy(&self->packProgram);
    }
 }
 
@@ -141,6 +147,7 @@ int8_t apx_dataSignature_update(apx_dataSignature_t *self,const char *dsg)
          {
             free(self->str);
             self->str=0;
+            apx_packProgram_clear(&self->packProgram);
             if (self->dataElement != 0)
             {
                apx_dataElement_destroy(self->dataElement);
@@ -177,12 +184,84 @@ int8_t apx_dataSignature_update(apx_dataSignature_t *self,const char *dsg)
          {
             self->dataElement = apx_dataElement_new(APX_BASE_TYPE_NONE,0);
          }
-         parseDataSignature(self,(const uint8_t*) self->str);
+         apx_packProgram_clear(&self->packProgram);
+         if (parseDataSignature(self,(const uint8_t*) self->str) == 0)
+         {
+            compilePackProgram(self);
+         }
       }
    }
    return 0;
 }
 
+/**
+ * sets the data signature from an already built dataElement tree, dsg is stored as is and is not parsed.
+ * The data signature takes ownership of dataElement (also on failure).
+ * returns 0 on sucess, -1 on failure (also sets errno)
+ */
+int8_t apx_dataSignature_assign(apx_dataSignature_t *self, const char *dsg, apx_dataElement_t *dataElement)
+{
+   if ( (self != 0) && (dataElement != 0) )
+   {
+      if (self->dataElement != 0)
+      {
+         apx_dataElement_delete(self->dataElement);
+      }
+      self->dataElement = dataElement;
+      if (self->str != 0)
+      {
+         free(self->str);
+         self->str = 0;
+      }
+      apx_packProgram_clear(&self->packProgram);
+      if (dsg != 0)
+      {
+         self->str=STRDUP(dsg);
+         if (self->str == 0)
+         {
+            errno = ENOMEM;
+            return -1;
+         }
+      }
+      compilePackProgram(self);
+      return 0;
+   }
+   if (dataElement != 0)
+   {
+      apx_dataElement_delete(dataElement);
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * packs dv into buffer using the precompiled pack program.
+ * returns pointer to byte after the last byte written or NULL on failure (also sets apx error)
+ */
+uint8_t *apx_dataSignature_pack_dv(apx_dataSignature_t *self, uint8_t *pBegin, uint8_t *pEnd, const dtl_dv_t *dv)
+{
+   if (self != 0)
+   {
+      return apx_packProgram_pack_dv(&self->packProgram, pBegin, pEnd, dv);
+   }
+   errno = EINVAL;
+   return 0;
+}
+
+/**
+ * unpacks buffer into dv using the precompiled pack program. If *dv is NULL a new dtl value is created.
+ * returns pointer to byte after the last byte read or NULL on failure (also sets apx error)
+ */
+const uint8_t *apx_dataSignature_unpack_dv(apx_dataSignature_t *self, const uint8_t *pBegin, const uint8_t *pEnd, dtl_dv_t **dv)
+{
+   if (self != 0)
+   {
+      return apx_packProgram_unpack_dv(&self->packProgram, pBegin, pEnd, dv);
+   }
+   errno = EINVAL;
+   return 0;
+}
+
 /***************** Private Function Definitions *******************/
 /**
  * returns 0 on success, -1 on error
@@ -520,3 +599,11 @@ static void calcPackLen(apx_dataElement_t *pDataElement)
    }
 }
 
+static void compilePackProgram(apx_dataSignature_t *self)
+{
+   if ( (self->dataElement != 0) && (self->dataElement->baseType != APX_BASE_TYPE_NONE) )
+   {
+      //a failed compile leaves an empty program, pack/unpack then reports APX_ELEMENT_TYPE_ERROR
+      (void) apx_packProgram_compile(&self->packProgram, self->dataElement);
+   }
+}
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <malloc.h>
 #include "apx_datatype.h"
+#include "apx_arena.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -35,6 +36,28 @@ apx_datatype_t* apx_datatype_new(const char *name, const char *dsg, const char *
    return self;
 }
 
+/**
+ * creates a datatype where the object and its strings are allocated from arena.
+ * apx_datatype_destroy is a no-op for such objects, the memory is released when the arena is destroyed.
+ */
+apx_datatype_t* apx_datatype_newInArena(struct apx_arena_tag *arena, const char *name, const char *dsg, const char *attr)
+{
+   apx_datatype_t *self = (apx_datatype_t*) apx_arena_alloc(arena, (uint32_t) sizeof(apx_datatype_t));
+   if(self != 0)
+   {
+      self->pAlloc = 0;
+      self->allocLen = 0;
+      self->name = ( (name != 0) && (name[0] != '\0') )? apx_arena_strdup(arena, name) : 0;
+      self->dsg = ( (dsg != 0) && (dsg[0] != '\0') )? apx_arena_strdup(arena, dsg) : 0;
+      self->attr = ( (attr != 0) && (attr[0] != '\0') )? apx_arena_strdup(arena, attr) : 0;
+   }
+   else
+   {
+      errno = ENOMEM;
+   }
+   return self;
+}
+
 void apx_datatype_delete(apx_datatype_t *self)
 {
    if(self != 0){
@@ -59,6 +82,9 @@ int8_t apx_datatype_create(apx_datatype_t *self, const char *name, const char *d
       char *pNext;
       char *pEnd;
 
+      self->name = 0;
+      self->dsg = 0;
+      self->attr = 0;
       nameLen = (name==0)? 0 : (uint32_t) strlen(name);
       dsgLen  = (dsg==0)?  0 : (uint32_t) strlen(dsg);
       attrLen = (attr==0)? 0 : (uint32_t) strlen(attr);
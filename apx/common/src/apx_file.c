@@ -44,6 +44,8 @@ int8_t apx_file_createLocalFile(apx_file_t *self, uint8_t fileType, apx_nodeData
       self->nodeData=nodeData;
       self->isRemoteFile = false;
       self->isOpen = false;
+      self->readHandler = 0;
+      self->readHandlerArg = 0;
       len = strlen(self->nodeData->name);
 
       if (len+APX_MAX_FILE_EXT_LEN <= RMF_MAX_FILE_NAME)
@@ -66,6 +68,10 @@ int8_t apx_file_createLocalFile(apx_file_t *self, uint8_t fileType, apx_nodeData
             ext = APX_DEFINITION_FILE_EXT;
             filelen = nodeData->definitionDataLen;
             break;
+         case APX_DEFINITION_BIN_FILE:
+            ext = APX_DEFINITION_BIN_FILE_EXT;
+            filelen = nodeData->definitionDataLen;
+            break;
          default:
             errno = EINVAL;
             return -1;
@@ -86,6 +92,8 @@ int8_t apx_file_createRemoteFile(apx_file_t *self, const rmf_fileInfo_t *cmdFile
       self->isRemoteFile = true;
       self->nodeData = 0;
       self->isOpen = false;
+      self->readHandler = 0;
+      self->readHandlerArg = 0;
 
       rmf_fileInfo_create(&self->fileInfo, cmdFileInfo->name, cmdFileInfo->address, cmdFileInfo->length, cmdFileInfo->fileType);
       rmf_fileInfo_setDigestData(&self->fileInfo, cmdFileInfo->digestType, cmdFileInfo->digestData, 0);
@@ -96,6 +104,26 @@ int8_t apx_file_createRemoteFile(apx_file_t *self, const rmf_fileInfo_t *cmdFile
    return -1;
 }
 
+/**
+ * creates a local file of type APX_USER_DATA_FILE. Its content is read from readHandler every time the file is sent.
+ */
+int8_t apx_file_createLocalUserDataFile(apx_file_t *self, const char *name, uint32_t length, apx_file_readHandler_t *readHandler, void *arg)
+{
+   if ( (self != 0) && (name != 0) && (readHandler != 0) && (strlen(name) <= RMF_MAX_FILE_NAME) )
+   {
+      self->fileType = APX_USER_DATA_FILE;
+      self->nodeData = 0;
+      self->isRemoteFile = false;
+      self->isOpen = false;
+      self->readHandler = readHandler;
+      self->readHandlerArg = arg;
+      rmf_fileInfo_create(&self->fileInfo, name, RMF_INVALID_ADDRESS, length, RMF_FILE_TYPE_FIXED);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
 void apx_file_destroy(apx_file_t *self)
 {
    if (self != 0)
@@ -129,6 +157,11 @@ apx_file_t *apx_file_newLocalDefinitionFile(apx_nodeData_t *nodeData)
    return apx_file_newLocalFile(APX_DEFINITION_FILE, nodeData);
 }
 
+apx_file_t *apx_file_newLocalBinaryDefinitionFile(apx_nodeData_t *nodeData)
+{
+   return apx_file_newLocalFile(APX_DEFINITION_BIN_FILE, nodeData);
+}
+
 apx_file_t *apx_file_newLocalOutPortDataFile(apx_nodeData_t *nodeData)
 {
    return apx_file_newLocalFile(APX_OUTDATA_FILE, nodeData);
@@ -158,6 +191,25 @@ apx_file_t *apx_file_newRemoteFile(const rmf_fileInfo_t *fileInfo)
    return self;
 }
 
+apx_file_t *apx_file_newLocalUserDataFile(const char *name, uint32_t length, apx_file_readHandler_t *readHandler, void *arg)
+{
+   apx_file_t *self = (apx_file_t*) malloc(sizeof(apx_file_t));
+   if(self != 0)
+   {
+      int8_t result = apx_file_createLocalUserDataFile(self, name, length, readHandler, arg);
+      if (result<0)
+      {
+         free(self);
+         self=0;
+      }
+   }
+   else
+   {
+      errno = ENOMEM;
+   }
+   return self;
+}
+
 void apx_file_delete(apx_file_t *self)
 {
    if (self != 0)
@@ -252,13 +304,17 @@ int8_t apx_file_read(apx_file_t *self, uint8_t *pDest, uint32_t offset, uint32_t
             APX_LOG_ERROR("[APX_FILE] apx_nodeData_writeInData failed");
          }
          break;
-      case APX_DEFINITION_FILE:
+      case APX_DEFINITION_FILE: //fall-through
+      case APX_DEFINITION_BIN_FILE:
          result = apx_nodeData_readDefinitionData(self->nodeData, pDest, offset, length);
          if (result != 0)
          {
             APX_LOG_ERROR("[APX_FILE] apx_nodeData_readDefinitionData failed");
          }
          break;
+      case APX_USER_DATA_FILE:
+         result = (self->readHandler != 0)? self->readHandler(self->readHandlerArg, pDest, offset, length) : -1;
+         break;
       default:
          result=-1;
          break;
@@ -276,7 +332,8 @@ int8_t apx_file_write(apx_file_t *self, const uint8_t *pSrc, uint32_t offset, ui
       int8_t result;
       switch(self->fileType)
       {
-      case APX_DEFINITION_FILE:
+      case APX_DEFINITION_FILE: //fall-through
+      case APX_DEFINITION_BIN_FILE:
          result = apx_nodeData_writeDefinitionData(self->nodeData, pSrc, offset, length);
          if (result != 0)
          {
@@ -337,6 +394,10 @@ static uint8_t apx_file_deriveFileType(apx_file_t *self)
                {
                   return APX_DEFINITION_FILE;
                }
+               else if ( (strcmp(p, APX_DEFINITION_BIN_FILE_EXT)==0) )
+               {
+                  return APX_DEFINITION_BIN_FILE;
+               }
                else if ( (strcmp(p, APX_INDATA_FILE_EXT)==0) )
                {
                   return APX_INDATA_FILE;
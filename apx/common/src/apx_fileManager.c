@@ -3,6 +3,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #include <errno.h>
 #include <malloc.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include "rmf.h"
@@ -24,12 +25,26 @@
 //////////////////////////////////////////////////////////////////////////////
 #ifdef _WIN32
 #undef SEMAPHORE_MAX_COUNT
-#define SEMAPHORE_MAX_COUNT APX_CONTEXT_NUM_MESSAGES //redefine here on Win32 platforms
+#define SEMAPHORE_MAX_COUNT (2*APX_CONTEXT_NUM_MESSAGES) //redefine here on Win32 platforms, ringbuffer length is rounded up to a power of two
 #endif
 
 #ifndef APX_FILEMANAGER_DEBUG_ENABLE
 #define APX_FILEMANAGER_DEBUG_ENABLE 0
 #endif
+
+#define BATCH_WRITES_MIN_LEN 64
+
+/**
+ * a complete write to a remote port data file, collected by apx_fileManager_parseMessages
+ */
+typedef struct apx_fileManagerWrite_tag
+{
+   apx_file_t *file;
+   const uint8_t *data; //weak pointer into the receive buffer
+   uint32_t offset; //offset within file
+   uint32_t length;
+   int32_t seqNr; //position in the batch, keeps the writes to each file in arrival order
+}apx_fileManagerWrite_t;
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
@@ -47,10 +62,19 @@ static void apx_fileManager_parseCmdMsg(apx_fileManager_t *self, const uint8_t *
 static void apx_fileManager_parseDataMsg(apx_fileManager_t *self, uint32_t address, const uint8_t *msgBuf, int32_t msgLen, bool more_bit);
 static void apx_fileManager_processRemoteFileInfo(apx_fileManager_t *self, const rmf_fileInfo_t *cmdFileInfo);
 static void apx_fileManager_processOpenFile(apx_fileManager_t *self, const rmf_cmdOpenFile_t *cmdOpenFile);
+static apx_file_t *apx_fileManager_findRemoteFileByAddress(apx_fileManager_t *self, uint32_t address);
+static int8_t apx_fileManager_reserveBatchWrites(apx_fileManager_t *self, int32_t numWrites);
+static void apx_fileManager_applyBatchWrites(apx_fileManager_t *self, int32_t numWrites);
+static int apx_fileManager_compareWriteByFile(const void *a, const void *b);
+static int apx_fileManager_compareWriteByOffset(const void *a, const void *b);
+static void apx_fileManager_notifyRemoteFileWritten(apx_fileManager_t *self, apx_file_t *remoteFile, uint32_t offset, int32_t length);
 
 //other internal functions
 static void apx_fileManager_sendFileInfo(apx_fileManager_t *self, rmf_fileInfo_t *fileInfo);
 static void apx_fileManager_sendAck(apx_fileManager_t *self);
+static int8_t apx_fileManager_postMessage(apx_fileManager_t *self, const apx_msg_t *msg);
+static uint8_t *apx_fileManager_getSendBuffer(apx_fileManager_t *self, int32_t msgLen);
+static void apx_fileManager_transmit(apx_fileManager_t *self, int32_t offset, int32_t msgLen);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -59,7 +83,10 @@ static void apx_fileManager_sendAck(apx_fileManager_t *self);
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
-
+#ifdef UNIT_TEST
+static apx_fileManager_remoteFileWrittenSpy_t *m_remoteFileWrittenSpy = (apx_fileManager_remoteFileWrittenSpy_t*) 0;
+static void *m_remoteFileWrittenSpyArg = (void*) 0;
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL FUNCTIONS
@@ -68,9 +95,9 @@ int8_t apx_fileManager_create(apx_fileManager_t *self, uint8_t mode)
 {
    if (self != 0 && ( (mode == APX_FILEMANAGER_CLIENT_MODE) || (mode == APX_FILEMANAGER_SERVER_MODE) ) )
    {
-      size_t numItems = APX_CONTEXT_NUM_MESSAGES;
+      uint32_t numItems = rbf32_calcNumElem(APX_CONTEXT_NUM_MESSAGES);
       size_t elemSize = RMF_MSG_SIZE;
-      int8_t result = apx_allocator_create(&self->allocator, APX_CONTEXT_NUM_MESSAGES);
+      int8_t result = apx_allocator_create(&self->allocator);
 
       if (result == 0)
       {
@@ -92,17 +119,22 @@ int8_t apx_fileManager_create(apx_fileManager_t *self, uint8_t mode)
             apx_allocator_destroy(&self->allocator);
             return -1;
          }
-         rbfs_create(&self->ringbuffer, self->ringbufferData,(uint16_t) numItems,(uint8_t) elemSize);
+         rbf32_create(&self->ringbuffer, self->ringbufferData, numItems, (uint32_t) elemSize);
          apx_fileMap_create(&self->localFileMap);
          apx_fileMap_create(&self->remoteFileMap);
          apx_fileManager_setTransmitHandler(self, 0);
-         apx_allocator_start(&self->allocator);
 
          self->curFileStartAddress = 0;
          self->curFileEndAddress = 0;
          self->curFile = 0;
+         self->fragmentStartAddress = RMF_INVALID_ADDRESS;
+         self->batchWrites = (apx_fileManagerWrite_t*) 0;
+         self->batchWritesLen = 0;
          self->nodeManager = (apx_nodeManager_t*) 0;
+         self->ownedNodeData = (apx_nodeData_t*) 0;
          self->isConnected = false;
+         self->isDead = false;
+         apx_connectionStats_create(&self->stats);
          return 0;
       }
    }
@@ -115,7 +147,6 @@ void apx_fileManager_destroy(apx_fileManager_t *self)
    if (self != 0)
    {
       apx_fileManager_stop(self);
-      apx_allocator_stop(&self->allocator);
       if (self->ringbufferData != 0)
       {
          free(self->ringbufferData);
@@ -126,6 +157,10 @@ void apx_fileManager_destroy(apx_fileManager_t *self)
       apx_allocator_destroy(&self->allocator);
       apx_fileMap_destroy(&self->localFileMap);
       apx_fileMap_destroy(&self->remoteFileMap);
+      if (self->batchWrites != 0)
+      {
+         free(self->batchWrites);
+      }
    }
 }
 
@@ -184,10 +219,7 @@ void apx_fileManager_stop(apx_fileManager_t *self)
       DWORD result;
 #endif
       apx_msg_t msg = {RMF_MSG_EXIT,0,0,0,0}; //{msgType, sender, msgData1, msgData2, msgData3}
-      SPINLOCK_ENTER(self->lock);
-      rbfs_insert(&self->ringbuffer,(const uint8_t*) &msg);
-      SPINLOCK_LEAVE(self->lock);
-      SEMAPHORE_POST(self->semaphore);
+      apx_fileManager_postMessage(self, &msg);
 #ifdef _MSC_VER
       result = WaitForSingleObject(self->workerThread, 5000);
       if (result == WAIT_TIMEOUT)
@@ -256,6 +288,64 @@ void apx_fileManager_setDebugInfo(apx_fileManager_t *self, void *debugInfo)
    }
 }
 
+/**
+ * copies the runtime counters into stats and fills in current queue depth and allocator usage
+ */
+void apx_fileManager_getStats(apx_fileManager_t *self, apx_connectionStats_t *stats)
+{
+   if ( (self != 0) && (stats != 0) )
+   {
+      uint8_t sizeClass;
+      apx_allocatorStats_t allocatorStats;
+      stats->numMessagesIn = self->stats.numMessagesIn;
+      stats->numMessagesOut = self->stats.numMessagesOut;
+      stats->numBytesIn = self->stats.numBytesIn;
+      stats->numBytesOut = self->stats.numBytesOut;
+      stats->queueHighWater = self->stats.queueHighWater;
+      stats->numSendStalls = self->stats.numSendStalls;
+      stats->numDroppedMessages = self->stats.numDroppedMessages;
+      stats->numTriggers = self->stats.numTriggers;
+      stats->queueDepth = rbf32_size(&self->ringbuffer);
+      stats->allocatorObjectsInUse = 0u;
+      stats->allocatorBytesInUse = 0u;
+      for (sizeClass = 0u; sizeClass < APX_ALLOCATOR_NUM_SIZE_CLASSES; sizeClass++)
+      {
+         if (apx_allocator_getStats(&self->allocator, sizeClass, &allocatorStats) == 0)
+         {
+            stats->allocatorObjectsInUse += allocatorStats.numInUse;
+            stats->allocatorBytesInUse += allocatorStats.numInUse*allocatorStats.objectSize;
+         }
+      }
+      if (apx_allocator_getLargeObjectStats(&self->allocator, &allocatorStats) == 0)
+      {
+         //the size of large objects is not tracked, count them with the smallest size they can have
+         stats->allocatorObjectsInUse += allocatorStats.numInUse;
+         stats->allocatorBytesInUse += allocatorStats.numInUse*(APX_ALLOCATOR_MAX_OBJECT_SIZE+1u);
+      }
+   }
+}
+
+/**
+ * Called when the underlying connection is lost. From this point the fileManager silently drops all file update
+ * and file write events so that other connections stop routing data to it while its nodes are being detached.
+ */
+void apx_fileManager_markDead(apx_fileManager_t *self)
+{
+   if (self != 0)
+   {
+      self->isDead = true;
+   }
+}
+
+bool apx_fileManager_isDead(const apx_fileManager_t *self)
+{
+   if (self != 0)
+   {
+      return self->isDead;
+   }
+   return false;
+}
+
 
 /**
  * returns number of bytes parsed from msgBuf. returns -1 on error or 0 if msgBuf is too short (wait for more data to arrive)
@@ -296,6 +386,56 @@ int32_t apx_fileManager_parseMessage(apx_fileManager_t *self, const uint8_t *msg
    return result;
 }
 
+/**
+ * Parses all messages received in one read from the socket. Complete writes to port data files are collected
+ * and applied per file while holding the port data lock once. The data triggers of each written port run once
+ * per batch (using the most recent data) instead of once per message.
+ * All other messages (commands, definition data, fragments including the last one) are parsed in order by apx_fileManager_parseMessage,
+ * writes collected before such a message are applied first.
+ */
+int8_t apx_fileManager_parseMessages(apx_fileManager_t *self, const apx_fileManagerFrame_t *frames, int32_t numFrames)
+{
+   if ( (self != 0) && (frames != 0) && (numFrames >= 0) )
+   {
+      int32_t i;
+      int32_t numWrites = 0;
+      bool useBatch = (apx_fileManager_reserveBatchWrites(self, numFrames) == 0);
+      for (i=0; i<numFrames; i++)
+      {
+         apx_file_t *file = (apx_file_t*) 0;
+         rmf_msg_t msg;
+         if ( (useBatch == true) && (self->fragmentStartAddress == RMF_INVALID_ADDRESS) && (rmf_unpackMsg(frames[i].msgBuf, frames[i].msgLen, &msg) > 0) &&
+              (msg.address < RMF_CMD_START_ADDR) && (msg.more_bit == false) )
+         {
+            file = apx_fileManager_findRemoteFileByAddress(self, msg.address);
+            if ( (file != 0) && ( (file->fileType != APX_OUTDATA_FILE) || (file->nodeData == 0) || (msg.address+msg.dataLen > self->curFileEndAddress) ) )
+            {
+               file = (apx_file_t*) 0; //parseMessage handles (or reports) this one
+            }
+         }
+         if (file != 0)
+         {
+            apx_fileManagerWrite_t *write = &self->batchWrites[numWrites];
+            write->file = file;
+            write->data = msg.data;
+            write->offset = msg.address - file->fileInfo.address;
+            write->length = (uint32_t) msg.dataLen;
+            write->seqNr = numWrites++;
+         }
+         else
+         {
+            apx_fileManager_applyBatchWrites(self, numWrites);
+            numWrites = 0;
+            (void) apx_fileManager_parseMessage(self, frames[i].msgBuf, frames[i].msgLen);
+         }
+      }
+      apx_fileManager_applyBatchWrites(self, numWrites);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
 /**
  * sends a file open request
  */
@@ -304,7 +444,7 @@ void apx_fileManager_sendFileOpen(apx_fileManager_t *self, uint32_t remoteAddres
    uint8_t *buf;
    assert(self->transmitHandler.getSendBuffer != 0);
    SPINLOCK_ENTER(self->sendLock);
-   buf = self->transmitHandler.getSendBuffer(self->transmitHandler.arg, RMF_MAX_CMD_BUF_SIZE+RMF_MAX_HEADER_SIZE);
+   buf = apx_fileManager_getSendBuffer(self, RMF_MAX_CMD_BUF_SIZE+RMF_MAX_HEADER_SIZE);
    if (buf != 0)
    {
       int32_t bufLen = RMF_MAX_CMD_BUF_SIZE;
@@ -319,7 +459,7 @@ void apx_fileManager_sendFileOpen(apx_fileManager_t *self, uint32_t remoteAddres
          if (headerLen > 0)
          {
             int32_t msgLen = (headerLen+dataLen);
-            self->transmitHandler.send(self->transmitHandler.arg, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
+            apx_fileManager_transmit(self, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
          }
       }
    }
@@ -379,6 +519,26 @@ void apx_fileManager_attachLocalPortDataFile(apx_fileManager_t *self, apx_file_t
    }
 }
 
+/**
+ * attaches a new local user data file (see apx_file_newLocalUserDataFile), if transmit function is enabled, send a new file info to remote side
+ * fileManager takes ownership of the pointer to localFile (will be deleted when fileManager is destroyed)
+ */
+void apx_fileManager_attachLocalDataFile(apx_fileManager_t *self, apx_file_t *localFile)
+{
+   if ( (self != 0) && (localFile != 0) )
+   {
+      bool isConnected;
+      SPINLOCK_ENTER(self->lock);
+      isConnected = self->isConnected;
+      apx_fileMap_autoInsertDataFile(&self->localFileMap, localFile);
+      if ( (isConnected == true) && (self->transmitHandler.send != 0) )
+      {
+         apx_fileManager_sendFileInfo(self, &localFile->fileInfo);
+      }
+      SPINLOCK_LEAVE(self->lock);
+   }
+}
+
 /**
  * returns string CLI or SRV depending on its mode (used for debug print messages)
  */
@@ -405,10 +565,7 @@ void apx_fileManager_onConnected(apx_fileManager_t *self)
    if (self != 0)
    {
       apx_msg_t msg = {RMF_MSG_CONNECT,0,0,0,0}; //{msgType,  msgData1, msgData2, msgData3, msgData4}
-      SPINLOCK_ENTER(self->lock);
-      rbfs_insert(&self->ringbuffer,(const uint8_t*) &msg);
-      SPINLOCK_LEAVE(self->lock);
-      SEMAPHORE_POST(self->semaphore);
+      apx_fileManager_postMessage(self, &msg);
    }
 }
 
@@ -417,31 +574,25 @@ void apx_fileManager_onDisconnected(apx_fileManager_t *self)
    if (self != 0)
    {
       apx_msg_t msg = {RMF_MSG_DISCONNECT,0,0,0,0}; //{msgType,  msgData1, msgData2, msgData3, msgData4}
-      SPINLOCK_ENTER(self->lock);
-      rbfs_insert(&self->ringbuffer,(const uint8_t*) &msg);
-      SPINLOCK_LEAVE(self->lock);
-      SEMAPHORE_POST(self->semaphore);
+      apx_fileManager_postMessage(self, &msg);
    }
 }
 
 void apx_fileManager_triggerFileUpdatedEvent(apx_fileManager_t *self, apx_file_t *file, uint32_t offset, uint32_t length)
 {
-   if (self !=0 )
+   if ( (self !=0 ) && (self->isDead == false) )
    {
       apx_msg_t msg = {RMF_MSG_WRITE_NOTIFY,0,0,0,0}; //{msgType,  msgData1, msgData2, msgData3, msgData4}
       msg.msgData1 = (uint32_t) offset;
       msg.msgData2 = (uint32_t) length;
       msg.msgData3 = file; //sent from node in nodeDataPtr
-      SPINLOCK_ENTER(self->lock);
-      rbfs_insert(&self->ringbuffer,(const uint8_t*) &msg);
-      SPINLOCK_LEAVE(self->lock);
-      SEMAPHORE_POST(self->semaphore);
+      apx_fileManager_postMessage(self, &msg);
    }
 }
 
 void apx_fileManager_triggerFileWriteCmdEvent(apx_fileManager_t *self, apx_file_t *file, const uint8_t *data, apx_offset_t offset, apx_size_t length)
 {
-   if (self !=0 )
+   if ( (self !=0 ) && (self->isDead == false) )
    {
       uint8_t *dataCopy;
       apx_msg_t msg = {RMF_MSG_FILE_WRITE,0,0,0,0}; //{msgType,  msgData1, msgData2, msgData3, msgData4}
@@ -452,19 +603,27 @@ void apx_fileManager_triggerFileWriteCmdEvent(apx_fileManager_t *self, apx_file_
       if (dataCopy == 0)
       {
          APX_LOG_ERROR("[APX_REMOTE_FILE] apx_allocator out of memory while attempting to allocate %d bytes", (int)length);
+         APX_STATS_INC(self->stats.numDroppedMessages);
       }
       else
       {
          memcpy(dataCopy, data, length);
          msg.msgData4 = dataCopy;
-         SPINLOCK_ENTER(self->lock);
-         rbfs_insert(&self->ringbuffer,(const uint8_t*) &msg);
-         SPINLOCK_LEAVE(self->lock);
-         SEMAPHORE_POST(self->semaphore);
+         if (apx_fileManager_postMessage(self, &msg) != 0)
+         {
+            apx_allocator_free(&self->allocator, dataCopy, (uint32_t) length);
+         }
       }
    }
 }
 
+#ifdef UNIT_TEST
+void apx_fileManager_setRemoteFileWrittenSpy(apx_fileManager_remoteFileWrittenSpy_t *spy, void *arg)
+{
+   m_remoteFileWrittenSpy = spy;
+   m_remoteFileWrittenSpyArg = arg;
+}
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
@@ -517,9 +676,7 @@ static THREAD_PROTO(threadTask,arg)
          if (result == 0)
 #endif
          {
-            SPINLOCK_ENTER(self->lock);
-            rbfs_remove(&self->ringbuffer,(uint8_t*) &msg);
-            SPINLOCK_LEAVE(self->lock);
+            rbf32_remove(&self->ringbuffer,(uint8_t*) &msg);
             messages_processed++;
             switch(msg.msgType)
             {
@@ -560,12 +717,32 @@ static void apx_fileManager_connectHandler(apx_fileManager_t *self)
 {
    if ( (self != 0) )
    {
-      SPINLOCK_ENTER(self->lock);
-      self->isConnected = true;
-      SPINLOCK_LEAVE(self->lock);
-      if (self->transmitHandler.send != 0)
+      if (self->mode == APX_FILEMANAGER_SERVER_MODE)
+      {
+         //local files attached before the greeting was parsed (user data files) are announced right after the acknowledge.
+         //The lock is held throughout so that files attached meanwhile are not announced twice.
+         SPINLOCK_ENTER(self->lock);
+         self->isConnected = true;
+         if (self->transmitHandler.send != 0)
+         {
+            adt_list_elem_t *iter;
+            apx_fileManager_sendAck(self);
+            adt_list_iter_init(&self->localFileMap.fileList);
+            while ( (iter = adt_list_iter_next(&self->localFileMap.fileList)) != 0)
+            {
+               apx_file_t *file = (apx_file_t*)iter->pItem;
+               assert(file != 0);
+               apx_fileManager_sendFileInfo(self, &file->fileInfo);
+            }
+         }
+         SPINLOCK_LEAVE(self->lock);
+      }
+      else
       {
-         if (self->mode == APX_FILEMANAGER_CLIENT_MODE)
+         SPINLOCK_ENTER(self->lock);
+         self->isConnected = true;
+         SPINLOCK_LEAVE(self->lock);
+         if (self->transmitHandler.send != 0)
          {
             adt_list_elem_t *iter;
             SPINLOCK_ENTER(self->lock);
@@ -584,11 +761,7 @@ static void apx_fileManager_connectHandler(apx_fileManager_t *self)
                }
             } while (iter != 0);
          }
-         else if (self->mode == APX_FILEMANAGER_SERVER_MODE)
-         {
-            apx_fileManager_sendAck(self);
-         }
-      }      
+      }
    }
 }
 
@@ -603,7 +776,7 @@ static void apx_fileManager_fileWriteNotifyHandler(apx_fileManager_t *self, apx_
       //to achieve this we increase the len variable with 4 bytes and then adjust for the header length later
       uint8_t *buf=0;
       SPINLOCK_ENTER(self->sendLock);
-      buf = self->transmitHandler.getSendBuffer(self->transmitHandler.arg, len+RMF_MAX_HEADER_SIZE);
+      buf = apx_fileManager_getSendBuffer(self, len+RMF_MAX_HEADER_SIZE);
       if (buf != 0)
       {
          uint8_t *dataBuf = &buf[RMF_MAX_HEADER_SIZE]; //the dataBuf starts RMF_MAX_HEADER_SIZE (4 bytes) into buf
@@ -628,15 +801,18 @@ static void apx_fileManager_fileWriteNotifyHandler(apx_fileManager_t *self, apx_
                   APX_LOG_ERROR("[APX_FILE_MANAGER] apx_nodeData_writeInData failed");
                }
                break;
-            case APX_DEFINITION_FILE:
+            case APX_DEFINITION_FILE: //fall-through
+            case APX_DEFINITION_BIN_FILE:
                result = apx_nodeData_readDefinitionData(file->nodeData, dataBuf, offset, dataLen);
                if (result != 0)
                {
                   APX_LOG_ERROR("[APX_FILE_MANAGER] apx_nodeData_readDefinitionData failed");
                }
                break;
+            case APX_USER_DATA_FILE:
+               result = apx_file_read(file, dataBuf, offset, dataLen);
+               break;
             default:
-               //TODO: check fpr user data files here
                break;
          }
          if (result == 0)
@@ -645,7 +821,7 @@ static void apx_fileManager_fileWriteNotifyHandler(apx_fileManager_t *self, apx_
             if (headerLen > 0)
             {
                int32_t msgLen = (headerLen+dataLen);
-               self->transmitHandler.send(self->transmitHandler.arg, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
+               apx_fileManager_transmit(self, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
             }
          }
       }
@@ -686,7 +862,7 @@ static void apx_fileManager_fileWriteCmdHandler(apx_fileManager_t *self, apx_fil
                      APX_LOG_DEBUG("[APX_FILE_MANAGER] (%p) Server Write %s[%d,%d]", self->debugInfo, file->fileInfo.name, (int) offset, (int) len );
                   }
                   SPINLOCK_ENTER(self->sendLock);
-                  sendBuf = self->transmitHandler.getSendBuffer(self->transmitHandler.arg, len+RMF_MAX_HEADER_SIZE);
+                  sendBuf = apx_fileManager_getSendBuffer(self, len+RMF_MAX_HEADER_SIZE);
                   if (sendBuf != 0)
                   {
                      uint8_t *dataBuf = &sendBuf[RMF_MAX_HEADER_SIZE]; //the dataBuf starts RMF_MAX_HEADER_SIZE (4 bytes) into sendBuf, this gives us enough room for a header
@@ -698,7 +874,7 @@ static void apx_fileManager_fileWriteCmdHandler(apx_fileManager_t *self, apx_fil
                      if (headerLen > 0)
                      {
                         int32_t msgLen = (headerLen+dataLen);
-                        self->transmitHandler.send(self->transmitHandler.arg, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
+                        apx_fileManager_transmit(self, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
                      }
                   }
                   SPINLOCK_LEAVE(self->sendLock);
@@ -719,7 +895,7 @@ static void apx_fileManager_sendFileInfo(apx_fileManager_t *self, rmf_fileInfo_t
    {
       uint8_t *buf;
       SPINLOCK_ENTER(self->sendLock);
-      buf = self->transmitHandler.getSendBuffer(self->transmitHandler.arg, RMF_MAX_CMD_BUF_SIZE+RMF_MAX_HEADER_SIZE);
+      buf = apx_fileManager_getSendBuffer(self, RMF_MAX_CMD_BUF_SIZE+RMF_MAX_HEADER_SIZE);
       if (buf != 0)
       {
          int32_t bufLen = RMF_MAX_CMD_BUF_SIZE;
@@ -739,7 +915,7 @@ static void apx_fileManager_sendFileInfo(apx_fileManager_t *self, rmf_fileInfo_t
             if (headerLen > 0)
             {
                int32_t msgLen = (headerLen+dataLen);
-               self->transmitHandler.send(self->transmitHandler.arg, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
+               apx_fileManager_transmit(self, RMF_MAX_HEADER_SIZE-headerLen, msgLen);
             }
          }
       }
@@ -823,24 +999,9 @@ static void apx_fileManager_parseDataMsg(apx_fileManager_t *self, uint32_t addre
 {
    if (self != 0)
    {
-      if ( (self->curFile != 0) && ((address < self->curFileStartAddress) || (address >= self->curFileEndAddress)) )
+      if (apx_fileManager_findRemoteFileByAddress(self, address) == 0)
       {
-         //invalidate cached file if address is outside range
-         self->curFile = 0;
-      }
-
-      if ( self->curFile == 0)
-      {
-         self->curFile = apx_fileMap_findByAddress(&self->remoteFileMap,address);
-         if (self->curFile == 0)
-         {
-            APX_LOG_ERROR("[APX_FILE_MANAGER(%s)] invalid write attempted at address %08X, len=%d",apx_fileManager_modeString(self), (int) address, (int) dataLen);
-         }
-         else
-         {
-            self->curFileStartAddress = self->curFile->fileInfo.address;
-            self->curFileEndAddress = self->curFileStartAddress+self->curFile->fileInfo.length;
-         }
+         APX_LOG_ERROR("[APX_FILE_MANAGER(%s)] invalid write attempted at address %08X, len=%d",apx_fileManager_modeString(self), (int) address, (int) dataLen);
       }
 
       //this section is valid for both cases where the file was cached and where it was non-cached
@@ -861,7 +1022,8 @@ static void apx_fileManager_parseDataMsg(apx_fileManager_t *self, uint32_t addre
             {
                switch(remoteFile->fileType)
                {
-                  case APX_DEFINITION_FILE:
+                  case APX_DEFINITION_FILE: //fall-through
+                  case APX_DEFINITION_BIN_FILE:
                      result = apx_nodeData_writeDefinitionData(remoteFile->nodeData, dataBuf, offset, dataLen);
                      if (result != 0)
                      {
@@ -890,11 +1052,26 @@ static void apx_fileManager_parseDataMsg(apx_fileManager_t *self, uint32_t addre
                      result=-1;
                      break;
                }
-               if (result == 0)
+               if (more_bit == true)
                {
-                  if ((more_bit == false) && (self->nodeManager != 0) )
+                  if ( (result == 0) && (self->fragmentStartAddress == RMF_INVALID_ADDRESS) )
                   {
-                     apx_nodeManager_remoteFileWritten(self->nodeManager, self, remoteFile, offset, dataLen);
+                     self->fragmentStartAddress = address;
+                  }
+               }
+               else
+               {
+                  uint32_t length = (uint32_t) dataLen;
+                  if ( (self->fragmentStartAddress >= self->curFileStartAddress) && (self->fragmentStartAddress < address) )
+                  {
+                     //the written range starts at the first fragment
+                     length += address - self->fragmentStartAddress;
+                     offset = self->fragmentStartAddress - remoteFile->fileInfo.address;
+                  }
+                  self->fragmentStartAddress = RMF_INVALID_ADDRESS;
+                  if (result == 0)
+                  {
+                     apx_fileManager_notifyRemoteFileWritten(self, remoteFile, offset, (int32_t) length);
                   }
                }
             }
@@ -962,6 +1139,10 @@ static void apx_fileManager_processOpenFile(apx_fileManager_t *self, const rmf_c
                apx_nodeData_setFileManager(localFile->nodeData, self);
             }
          }
+         else if (localFile->fileType == APX_USER_DATA_FILE)
+         {
+            apx_file_open(localFile);
+         }
       }
    }
 }
@@ -973,8 +1154,9 @@ static void apx_fileManager_sendAck(apx_fileManager_t *self)
 {
    if (self != 0)
    {
+      uint8_t *sendBuf;
       SPINLOCK_ENTER(self->sendLock);
-      uint8_t *sendBuf = self->transmitHandler.getSendBuffer(self->transmitHandler.arg, RMF_MAX_CMD_BUF_SIZE + RMF_MAX_HEADER_SIZE);
+      sendBuf = apx_fileManager_getSendBuffer(self, RMF_MAX_CMD_BUF_SIZE + RMF_MAX_HEADER_SIZE);
       if (sendBuf != 0)
       {
          uint8_t *dataBuf = &sendBuf[RMF_MAX_HEADER_SIZE]; //the dataBuf starts RMF_MAX_HEADER_SIZE (4 bytes) into buf
@@ -986,10 +1168,218 @@ static void apx_fileManager_sendAck(apx_fileManager_t *self)
             if ( (headerLen > 0) && (headerLen<= (int32_t) RMF_MAX_HEADER_SIZE) )
             {
                int32_t msgLen = (headerLen + dataLen);
-               self->transmitHandler.send(self->transmitHandler.arg, RMF_MAX_HEADER_SIZE - headerLen, msgLen);
+               apx_fileManager_transmit(self, RMF_MAX_HEADER_SIZE - headerLen, msgLen);
             }
          }
       }
       SPINLOCK_LEAVE(self->sendLock);
    }
 }
+
+/**
+ * queues msg for the worker thread. Returns -1 (and counts the message as dropped) when the queue is full
+ */
+static int8_t apx_fileManager_postMessage(apx_fileManager_t *self, const apx_msg_t *msg)
+{
+   uint8_t result;
+#if(RBF32_ATOMIC_ENABLE)
+   result = rbf32_mpsc_insert(&self->ringbuffer, (const uint8_t*) msg);
+#else
+   SPINLOCK_ENTER(self->lock);
+   result = rbf32_insert(&self->ringbuffer, (const uint8_t*) msg);
+   SPINLOCK_LEAVE(self->lock);
+#endif
+   if (result != E_BUF_OK)
+   {
+      APX_STATS_INC(self->stats.numDroppedMessages);
+      APX_LOG_ERROR("[APX_FILE_MANAGER] message queue full, dropped message type %u", (unsigned int) msg->msgType);
+      return -1;
+   }
+   apx_connectionStats_updateMax(&self->stats.queueHighWater, rbf32_size(&self->ringbuffer));
+   SEMAPHORE_POST(self->semaphore);
+   return 0;
+}
+
+/**
+ * these two wrap the transmitHandler to count send stalls, they must be called while holding sendLock
+ */
+static uint8_t *apx_fileManager_getSendBuffer(apx_fileManager_t *self, int32_t msgLen)
+{
+   uint8_t *buf = self->transmitHandler.getSendBuffer(self->transmitHandler.arg, msgLen);
+   if (buf == 0)
+   {
+      APX_STATS_INC(self->stats.numSendStalls);
+   }
+   return buf;
+}
+
+static void apx_fileManager_transmit(apx_fileManager_t *self, int32_t offset, int32_t msgLen)
+{
+   if (self->transmitHandler.send(self->transmitHandler.arg, offset, msgLen) < 0)
+   {
+      APX_STATS_INC(self->stats.numSendStalls);
+   }
+}
+
+/**
+ * returns the remote file containing address, the result is cached in self->curFile
+ */
+static apx_file_t *apx_fileManager_findRemoteFileByAddress(apx_fileManager_t *self, uint32_t address)
+{
+   if ( (self->curFile != 0) && ((address < self->curFileStartAddress) || (address >= self->curFileEndAddress)) )
+   {
+      //invalidate cached file if address is outside range
+      self->curFile = 0;
+   }
+   if (self->curFile == 0)
+   {
+      self->curFile = apx_fileMap_findByAddress(&self->remoteFileMap,address);
+      if (self->curFile != 0)
+      {
+         self->curFileStartAddress = self->curFile->fileInfo.address;
+         self->curFileEndAddress = self->curFileStartAddress+self->curFile->fileInfo.length;
+      }
+   }
+   return self->curFile;
+}
+
+static int8_t apx_fileManager_reserveBatchWrites(apx_fileManager_t *self, int32_t numWrites)
+{
+   if (numWrites > self->batchWritesLen)
+   {
+      int32_t newLen = (self->batchWritesLen > 0)? self->batchWritesLen : BATCH_WRITES_MIN_LEN;
+      apx_fileManagerWrite_t *batchWrites;
+      while (newLen < numWrites)
+      {
+         newLen *= 2;
+      }
+      batchWrites = (apx_fileManagerWrite_t*) realloc(self->batchWrites, ((size_t) newLen)*sizeof(apx_fileManagerWrite_t));
+      if (batchWrites == 0)
+      {
+         errno = ENOMEM;
+         return -1;
+      }
+      self->batchWrites = batchWrites;
+      self->batchWritesLen = newLen;
+   }
+   return 0;
+}
+
+/**
+ * applies the first numWrites elements of self->batchWrites. Writes are grouped by file, each group is copied while holding the
+ * port data lock once. Then the written ranges of the group are merged and the nodeManager is notified once per merged range,
+ * which makes the data triggers of each port run at most once. Writes overlapping another write of the same range are counted
+ * in stats.numConflatedMessages.
+ */
+static void apx_fileManager_applyBatchWrites(apx_fileManager_t *self, int32_t numWrites)
+{
+   int32_t i = 0;
+   if (numWrites > 1)
+   {
+      qsort(self->batchWrites, (size_t) numWrites, sizeof(apx_fileManagerWrite_t), apx_fileManager_compareWriteByFile);
+   }
+   while (i < numWrites)
+   {
+      int32_t j;
+      apx_file_t *file = self->batchWrites[i].file;
+      apx_nodeData_t *nodeData = file->nodeData;
+      apx_nodeData_lockOutPortData(nodeData);
+      for (j=i; (j < numWrites) && (self->batchWrites[j].file == file); j++)
+      {
+         const apx_fileManagerWrite_t *write = &self->batchWrites[j];
+         if ( (write->offset+write->length) <= nodeData->outPortDataLen )
+         {
+            memcpy(&nodeData->outPortDataBuf[write->offset], write->data, write->length);
+         }
+         else
+         {
+            APX_LOG_ERROR("[APX_FILE_MANAGER] write outside outPortData of %s attempted at offset %u", file->fileInfo.name, (unsigned int) write->offset);
+            self->batchWrites[j].length = 0u;
+         }
+      }
+      apx_nodeData_unlockOutPortData(nodeData);
+      if ( (j-i) > 1)
+      {
+         int32_t k;
+         uint32_t numConflated = 0u;
+         uint32_t startOffset;
+         uint32_t endOffset;
+         qsort(&self->batchWrites[i], (size_t) (j-i), sizeof(apx_fileManagerWrite_t), apx_fileManager_compareWriteByOffset);
+         startOffset = self->batchWrites[i].offset;
+         endOffset = startOffset + self->batchWrites[i].length;
+         for (k=i+1; k<=j; k++)
+         {
+            if ( (k < j) && (self->batchWrites[k].offset <= endOffset) )
+            {
+               uint32_t writeEnd = self->batchWrites[k].offset + self->batchWrites[k].length;
+               if ( (self->batchWrites[k].offset < endOffset) && (self->batchWrites[k].length > 0u) )
+               {
+                  numConflated++; //overlaps a write of the same merged range
+               }
+               if (writeEnd > endOffset)
+               {
+                  endOffset = writeEnd;
+               }
+            }
+            else
+            {
+               if (endOffset > startOffset)
+               {
+                  apx_fileManager_notifyRemoteFileWritten(self, file, startOffset, (int32_t) (endOffset-startOffset));
+               }
+               if (k < j)
+               {
+                  startOffset = self->batchWrites[k].offset;
+                  endOffset = startOffset + self->batchWrites[k].length;
+               }
+            }
+         }
+         if (numConflated > 0u)
+         {
+            APX_STATS_ADD32(self->stats.numConflatedMessages, numConflated);
+         }
+      }
+      else if (self->batchWrites[i].length > 0u)
+      {
+         apx_fileManager_notifyRemoteFileWritten(self, file, self->batchWrites[i].offset, (int32_t) self->batchWrites[i].length);
+      }
+      else
+      {
+         //write was rejected
+      }
+      i = j;
+   }
+}
+
+static int apx_fileManager_compareWriteByFile(const void *a, const void *b)
+{
+   const apx_fileManagerWrite_t *writeA = (const apx_fileManagerWrite_t*) a;
+   const apx_fileManagerWrite_t *writeB = (const apx_fileManagerWrite_t*) b;
+   if (writeA->file != writeB->file)
+   {
+      return (writeA->file < writeB->file)? -1 : 1;
+   }
+   return (writeA->seqNr < writeB->seqNr)? -1 : ( (writeA->seqNr > writeB->seqNr)? 1 : 0 );
+}
+
+static int apx_fileManager_compareWriteByOffset(const void *a, const void *b)
+{
+   const apx_fileManagerWrite_t *writeA = (const apx_fileManagerWrite_t*) a;
+   const apx_fileManagerWrite_t *writeB = (const apx_fileManagerWrite_t*) b;
+   return (writeA->offset < writeB->offset)? -1 : ( (writeA->offset > writeB->offset)? 1 : 0 );
+}
+
+static void apx_fileManager_notifyRemoteFileWritten(apx_fileManager_t *self, apx_file_t *remoteFile, uint32_t offset, int32_t length)
+{
+#ifdef UNIT_TEST
+   if (m_remoteFileWrittenSpy != 0)
+   {
+      m_remoteFileWrittenSpy(m_remoteFileWrittenSpyArg, remoteFile, offset, length);
+      return;
+   }
+#endif
+   if (self->nodeManager != 0)
+   {
+      apx_nodeManager_remoteFileWritten(self->nodeManager, self, remoteFile, offset, length);
+   }
+}
@@ -0,0 +1,891 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#if defined(_MSC_PLATFORM_TOOLSET) && (_MSC_PLATFORM_TOOLSET<=110)
+#include "msc_bool.h"
+#else
+#include <stdbool.h>
+#endif
+#ifdef _MSC_VER
+#include <Windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+#include "osmacro.h"
+#include "ringbuf.h"
+#include "apx_logging.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef APX_LOG_RECORD_SIZE
+#define APX_LOG_RECORD_SIZE         256u
+#endif
+#ifndef APX_LOG_BUFFER_NUM_RECORDS
+#define APX_LOG_BUFFER_NUM_RECORDS  256u //per thread, must be a power of two
+#endif
+#ifndef APX_LOG_WRITER_PERIOD_MS
+#define APX_LOG_WRITER_PERIOD_MS    10u
+#endif
+#ifndef APX_LOG_FLUSH_BATCH_SIZE
+#define APX_LOG_FLUSH_BATCH_SIZE    16u //records copied out of the buffers before they are formatted and printed
+#endif
+#define APX_LOG_MSG_MAX_LEN         1024u
+#define APX_LOG_STRING_TRUNCATED    0x8000u
+#define APX_LOG_STRING_NULL         0x7FFFu
+
+#ifdef _MSC_VER
+#define APX_LOG_THREAD_LOCAL __declspec(thread)
+#else
+#define APX_LOG_THREAD_LOCAL __thread
+#endif
+
+typedef struct apx_logRecord_tag
+{
+   const apx_logSite_t *site;
+   uint32_t numSuppressed; //number of messages dropped by the rate limiter of site just before this one
+   uint16_t argLen;
+   uint8_t args[APX_LOG_RECORD_SIZE - sizeof(void*) - 8u];
+}apx_logRecord_t;
+
+typedef struct apx_logBuffer_tag
+{
+   struct apx_logBuffer_tag *next;
+   rbf32_t ringbuf; //single producer (owning thread), single consumer (writer thread)
+   uint8_t *data;
+   volatile uint32_t numDropped; //incremented by owning thread when ringbuf is full
+   uint32_t numDroppedReported;
+   volatile bool isOrphaned; //owning thread has exited, buffer is freed once empty
+}apx_logBuffer_t;
+
+typedef struct apx_logSpec_tag
+{
+   char flags[8];
+   uint8_t numFlags;
+   bool hasWidth;
+   bool widthIsArg;
+   int32_t width;
+   bool hasPrecision;
+   bool precisionIsArg;
+   int32_t precision;
+   char lengthMod; //0, 'H' (hh), 'h', 'l', 'q' (ll), 'j', 'z', 't' or 'L'
+   char conversion;
+}apx_logSpec_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static bool apx_log_rateLimit(apx_logSite_t *site, uint32_t *numSuppressed);
+static apx_logBuffer_t *apx_log_getThreadBuffer(void);
+static void apx_log_threadExit(void *arg);
+static void apx_log_output(uint8_t level, const char *msg);
+static void apx_log_defaultHandler(uint8_t level, const char *msg);
+static const char *apx_log_parseSpec(const char *p, apx_logSpec_t *spec);
+static int32_t apx_log_buildSpec(char *dest, const apx_logSpec_t *spec, const char *lengthMod, char conversion);
+static bool apx_log_encodeValue(uint8_t *dest, uint32_t destLen, uint32_t *offset, const void *value, uint32_t size);
+static void apx_log_append(char *dest, uint32_t destLen, uint32_t *pos, const char *fmt, ...);
+static void apx_log_formatRecord(const apx_logRecord_t *record, char *msg, uint32_t msgLen);
+static uint32_t apx_log_collectRecords(apx_logRecord_t *dest, uint32_t maxRecords, uint32_t *numDropped);
+static THREAD_PROTO(writerTask, arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+volatile uint8_t g_apx_logLevel = APX_LOG_LEVEL_WARNING;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static volatile bool m_isRunning = false;
+static bool m_isInitialized = false;
+static MUTEX_T m_bufferListLock;
+static MUTEX_T m_flushLock; //serializes consumers (writer thread and apx_log_flush) so messages are printed in order
+static apx_logBuffer_t *m_bufferList = 0;
+static apx_logHandler_t *m_handler = apx_log_defaultHandler;
+static THREAD_T m_writerThread;
+#ifdef _MSC_VER
+static unsigned int m_writerThreadId;
+static DWORD m_bufferKey; //fiber local storage index, used to get notified when threads exit
+#else
+static pthread_key_t m_bufferKey;
+#endif
+static APX_LOG_THREAD_LOCAL apx_logBuffer_t *m_threadBuffer = 0;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * starts the writer thread. From this point log calls are buffered.
+ */
+int8_t apx_log_start(void)
+{
+   if (m_isRunning)
+   {
+      return 0;
+   }
+   if (!m_isInitialized)
+   {
+      MUTEX_INIT(m_bufferListLock);
+      MUTEX_INIT(m_flushLock);
+#ifdef _MSC_VER
+      m_bufferKey = FlsAlloc((PFLS_CALLBACK_FUNCTION) apx_log_threadExit);
+      if (m_bufferKey == FLS_OUT_OF_INDEXES)
+      {
+         return -1;
+      }
+#else
+      if (pthread_key_create(&m_bufferKey, apx_log_threadExit) != 0)
+      {
+         return -1;
+      }
+#endif
+      m_isInitialized = true;
+   }
+   m_isRunning = true;
+#ifdef _MSC_VER
+   THREAD_CREATE(m_writerThread, writerTask, 0, m_writerThreadId);
+   if (m_writerThread == INVALID_HANDLE_VALUE)
+   {
+      m_isRunning = false;
+      return -1;
+   }
+#else
+   if (THREAD_CREATE(m_writerThread, writerTask, 0) != 0)
+   {
+      m_isRunning = false;
+      return -1;
+   }
+#endif
+   return 0;
+}
+
+/**
+ * stops the writer thread and prints all buffered messages. Log calls are printed synchronously afterwards.
+ */
+void apx_log_stop(void)
+{
+   if (m_isRunning)
+   {
+      m_isRunning = false;
+#ifdef _MSC_VER
+      WaitForSingleObject(m_writerThread, INFINITE);
+      CloseHandle(m_writerThread);
+#else
+      pthread_join(m_writerThread, 0);
+#endif
+      apx_log_flush();
+   }
+}
+
+/**
+ * formats and prints all buffered messages. Records are copied out of the buffers in batches, the handler is called
+ * without holding the buffer list lock.
+ */
+void apx_log_flush(void)
+{
+   if (m_isInitialized)
+   {
+      char msg[APX_LOG_MSG_MAX_LEN];
+      apx_logRecord_t batch[APX_LOG_FLUSH_BATCH_SIZE];
+      uint32_t numRecords;
+      MUTEX_LOCK(m_flushLock);
+      do
+      {
+         uint32_t i;
+         uint32_t numDropped;
+         numRecords = apx_log_collectRecords(batch, APX_LOG_FLUSH_BATCH_SIZE, &numDropped);
+         for (i = 0; i < numRecords; i++)
+         {
+            apx_log_formatRecord(&batch[i], msg, (uint32_t) sizeof(msg));
+            apx_log_output(batch[i].site->level, msg);
+         }
+         if (numDropped > 0)
+         {
+            snprintf(msg, sizeof(msg), "[APX_LOG] log buffer full, %u messages dropped", (unsigned int) numDropped);
+            apx_log_output(APX_LOG_LEVEL_WARNING, msg);
+         }
+      } while (numRecords == APX_LOG_FLUSH_BATCH_SIZE);
+      MUTEX_UNLOCK(m_flushLock);
+      fflush(stdout);
+   }
+}
+
+void apx_log_setLevel(uint8_t level)
+{
+   g_apx_logLevel = level;
+}
+
+uint8_t apx_log_getLevel(void)
+{
+   return g_apx_logLevel;
+}
+
+/**
+ * replaces the function that prints formatted messages (default: stdout, stderr for errors). Use 0 to restore the default.
+ */
+void apx_log_setHandler(apx_logHandler_t *handler)
+{
+   m_handler = (handler != 0)? handler : apx_log_defaultHandler;
+}
+
+/**
+ * called by the APX_LOG_* macros. fmt must be the string literal stored in site.
+ */
+void apx_log_write(apx_logSite_t *site, const char *fmt, ...)
+{
+   uint32_t numSuppressed;
+   va_list args;
+   if ( (site == 0) || (fmt == 0) || (apx_log_rateLimit(site, &numSuppressed) == false) )
+   {
+      return;
+   }
+   va_start(args, fmt);
+   if (m_isRunning)
+   {
+      apx_logBuffer_t *buffer = apx_log_getThreadBuffer();
+      if (buffer != 0)
+      {
+         uint8_t *span;
+         if (rbf32_writeSpan(&buffer->ringbuf, &span) == 0)
+         {
+            buffer->numDropped++;
+         }
+         else
+         {
+            apx_logRecord_t *record = (apx_logRecord_t*) span;
+            record->site = site;
+            record->numSuppressed = numSuppressed;
+            record->argLen = (uint16_t) apx_log_encodeArgs(record->args, (uint32_t) sizeof(record->args), fmt, args);
+            rbf32_commit(&buffer->ringbuf, 1);
+         }
+         va_end(args);
+         return;
+      }
+   }
+   {
+      char msg[APX_LOG_MSG_MAX_LEN];
+      vsnprintf(msg, sizeof(msg), fmt, args);
+      if (numSuppressed > 0)
+      {
+         uint32_t pos = (uint32_t) strlen(msg);
+         apx_log_append(msg, (uint32_t) sizeof(msg), &pos, " (%u similar messages suppressed)", (unsigned int) numSuppressed);
+      }
+      apx_log_output(site->level, msg);
+   }
+   va_end(args);
+}
+
+/**
+ * stores the arguments described by fmt in dest. Strings are copied, at most precision bytes when the conversion has one
+ * (including "%.*s"). They are truncated when dest is too small.
+ * Returns number of bytes written.
+ */
+int32_t apx_log_encodeArgs(uint8_t *dest, uint32_t destLen, const char *fmt, va_list args)
+{
+   uint32_t offset = 0;
+   const char *p = fmt;
+   while ( (p = strchr(p, '%')) != 0)
+   {
+      apx_logSpec_t spec;
+      int32_t precision; //-1 when the conversion has no precision
+      p = apx_log_parseSpec(p+1, &spec);
+      if (p == 0)
+      {
+         break;
+      }
+      if (spec.conversion == '%')
+      {
+         continue;
+      }
+      precision = spec.hasPrecision? spec.precision : -1;
+      if (spec.widthIsArg)
+      {
+         int value = va_arg(args, int);
+         if (!apx_log_encodeValue(dest, destLen, &offset, &value, (uint32_t) sizeof(int32_t))) break;
+      }
+      if (spec.precisionIsArg)
+      {
+         int value = va_arg(args, int);
+         precision = (value < 0)? -1 : (int32_t) value; //a negative precision is taken as if it was omitted
+         if (!apx_log_encodeValue(dest, destLen, &offset, &value, (uint32_t) sizeof(int32_t))) break;
+      }
+      switch (spec.conversion)
+      {
+      case 'd':
+      case 'i':
+      case 'c':
+         {
+            int64_t value;
+            switch (spec.lengthMod)
+            {
+            case 'l': value = (int64_t) va_arg(args, long); break;
+            case 'q': value = (int64_t) va_arg(args, long long); break;
+            case 'j': value = (int64_t) va_arg(args, intmax_t); break;
+            case 'z': value = (int64_t) va_arg(args, size_t); break;
+            case 't': value = (int64_t) va_arg(args, ptrdiff_t); break;
+            case 'H': value = (int64_t) (signed char) va_arg(args, int); break;
+            case 'h': value = (int64_t) (short) va_arg(args, int); break;
+            default: value = (int64_t) va_arg(args, int); break;
+            }
+            if (!apx_log_encodeValue(dest, destLen, &offset, &value, (uint32_t) sizeof(value))) return (int32_t) offset;
+         }
+         break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+         {
+            uint64_t value;
+            switch (spec.lengthMod)
+            {
+            case 'l': value = (uint64_t) va_arg(args, unsigned long); break;
+            case 'q': value = (uint64_t) va_arg(args, unsigned long long); break;
+            case 'j': value = (uint64_t) va_arg(args, uintmax_t); break;
+            case 'z': value = (uint64_t) va_arg(args, size_t); break;
+            case 't': value = (uint64_t) va_arg(args, ptrdiff_t); break;
+            case 'H': value = (uint64_t) (unsigned char) va_arg(args, unsigned int); break;
+            case 'h': value = (uint64_t) (unsigned short) va_arg(args, unsigned int); break;
+            default: value = (uint64_t) va_arg(args, unsigned int); break;
+            }
+            if (!apx_log_encodeValue(dest, destLen, &offset, &value, (uint32_t) sizeof(value))) return (int32_t) offset;
+         }
+         break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+         {
+            double value = (spec.lengthMod == 'L')? (double) va_arg(args, long double) : va_arg(args, double);
+            if (!apx_log_encodeValue(dest, destLen, &offset, &value, (uint32_t) sizeof(value))) return (int32_t) offset;
+         }
+         break;
+      case 'p':
+         {
+            uint64_t value = (uint64_t) (uintptr_t) va_arg(args, void*);
+            if (!apx_log_encodeValue(dest, destLen, &offset, &value, (uint32_t) sizeof(value))) return (int32_t) offset;
+         }
+         break;
+      case 's':
+         {
+            const char *str = va_arg(args, const char*);
+            uint16_t header;
+            uint32_t len;
+            if (offset + sizeof(uint16_t) > destLen)
+            {
+               return (int32_t) offset;
+            }
+            if (str == 0)
+            {
+               header = APX_LOG_STRING_NULL;
+               len = 0;
+            }
+            else
+            {
+               uint32_t avail = destLen - (offset + (uint32_t) sizeof(uint16_t));
+               if (precision >= 0)
+               {
+                  //the string does not need to be null-terminated within precision bytes
+                  const char *end = (const char*) memchr(str, 0, (size_t) precision);
+                  len = (end != 0)? (uint32_t) (end - str) : (uint32_t) precision;
+               }
+               else
+               {
+                  len = (uint32_t) strlen(str);
+               }
+               if (len >= APX_LOG_STRING_NULL)
+               {
+                  len = APX_LOG_STRING_NULL - 1u;
+               }
+               header = (uint16_t) len;
+               if (len > avail)
+               {
+                  len = avail;
+                  header = (uint16_t) (len | APX_LOG_STRING_TRUNCATED);
+               }
+            }
+            memcpy(&dest[offset], &header, sizeof(uint16_t));
+            offset += (uint32_t) sizeof(uint16_t);
+            if (len > 0)
+            {
+               memcpy(&dest[offset], str, len);
+               offset += len;
+            }
+         }
+         break;
+      case 'n':
+         (void) va_arg(args, void*);
+         break;
+      default:
+         return (int32_t) offset;
+      }
+   }
+   return (int32_t) offset;
+}
+
+/**
+ * formats arguments stored by apx_log_encodeArgs. The result is always null-terminated.
+ * Returns length of formatted string.
+ */
+int32_t apx_log_decodeArgs(char *dest, uint32_t destLen, const char *fmt, const uint8_t *src, uint32_t srcLen)
+{
+   uint32_t pos = 0;
+   uint32_t offset = 0;
+   const char *p = fmt;
+   if ( (dest == 0) || (destLen == 0) )
+   {
+      return -1;
+   }
+   dest[0] = 0;
+   while (*p != 0)
+   {
+      const char *next = strchr(p, '%');
+      apx_logSpec_t spec;
+      char specStr[32];
+      if (next == 0)
+      {
+         apx_log_append(dest, destLen, &pos, "%s", p);
+         break;
+      }
+      if (next > p)
+      {
+         apx_log_append(dest, destLen, &pos, "%.*s", (int) (next - p), p);
+      }
+      p = apx_log_parseSpec(next+1, &spec);
+      if (p == 0)
+      {
+         break;
+      }
+      if (spec.conversion == '%')
+      {
+         apx_log_append(dest, destLen, &pos, "%%");
+         continue;
+      }
+      if (spec.widthIsArg)
+      {
+         int32_t value;
+         if (offset + sizeof(int32_t) > srcLen) goto truncated;
+         memcpy(&value, &src[offset], sizeof(int32_t));
+         offset += (uint32_t) sizeof(int32_t);
+         spec.width = value;
+      }
+      if (spec.precisionIsArg)
+      {
+         int32_t value;
+         if (offset + sizeof(int32_t) > srcLen) goto truncated;
+         memcpy(&value, &src[offset], sizeof(int32_t));
+         offset += (uint32_t) sizeof(int32_t);
+         spec.precision = value;
+      }
+      switch (spec.conversion)
+      {
+      case 'd':
+      case 'i':
+      case 'c':
+         {
+            int64_t value;
+            if (offset + sizeof(value) > srcLen) goto truncated;
+            memcpy(&value, &src[offset], sizeof(value));
+            offset += (uint32_t) sizeof(value);
+            if (spec.conversion == 'c')
+            {
+               apx_log_buildSpec(specStr, &spec, "", 'c');
+               apx_log_append(dest, destLen, &pos, specStr, (int) value);
+            }
+            else
+            {
+               apx_log_buildSpec(specStr, &spec, "ll", spec.conversion);
+               apx_log_append(dest, destLen, &pos, specStr, (long long) value);
+            }
+         }
+         break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+         {
+            uint64_t value;
+            if (offset + sizeof(value) > srcLen) goto truncated;
+            memcpy(&value, &src[offset], sizeof(value));
+            offset += (uint32_t) sizeof(value);
+            apx_log_buildSpec(specStr, &spec, "ll", spec.conversion);
+            apx_log_append(dest, destLen, &pos, specStr, (unsigned long long) value);
+         }
+         break;
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+         {
+            double value;
+            if (offset + sizeof(value) > srcLen) goto truncated;
+            memcpy(&value, &src[offset], sizeof(value));
+            offset += (uint32_t) sizeof(value);
+            apx_log_buildSpec(specStr, &spec, "", spec.conversion);
+            apx_log_append(dest, destLen, &pos, specStr, value);
+         }
+         break;
+      case 'p':
+         {
+            uint64_t value;
+            if (offset + sizeof(value) > srcLen) goto truncated;
+            memcpy(&value, &src[offset], sizeof(value));
+            offset += (uint32_t) sizeof(value);
+            apx_log_buildSpec(specStr, &spec, "", 'p');
+            apx_log_append(dest, destLen, &pos, specStr, (void*) (uintptr_t) value);
+         }
+         break;
+      case 's':
+         {
+            uint16_t header;
+            uint32_t len;
+            if (offset + sizeof(uint16_t) > srcLen) goto truncated;
+            memcpy(&header, &src[offset], sizeof(uint16_t));
+            offset += (uint32_t) sizeof(uint16_t);
+            if (header == APX_LOG_STRING_NULL)
+            {
+               apx_log_append(dest, destLen, &pos, "(null)");
+               break;
+            }
+            len = header & ~APX_LOG_STRING_TRUNCATED;
+            if (offset + len > srcLen) goto truncated;
+            spec.hasPrecision = true;
+            spec.precisionIsArg = false;
+            spec.precision = (int32_t) len;
+            apx_log_buildSpec(specStr, &spec, "", 's');
+            apx_log_append(dest, destLen, &pos, specStr, (const char*) &src[offset]);
+            offset += len;
+            if ( (header & APX_LOG_STRING_TRUNCATED) != 0)
+            {
+               goto truncated;
+            }
+         }
+         break;
+      default:
+         break;
+      }
+   }
+   return (int32_t) pos;
+truncated:
+   apx_log_append(dest, destLen, &pos, "...");
+   return (int32_t) pos;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+/**
+ * returns false when the message should be dropped. *numSuppressed is set to the number of messages dropped since the
+ * last message that was let through.
+ */
+static bool apx_log_rateLimit(apx_logSite_t *site, uint32_t *numSuppressed)
+{
+#if (APX_LOG_RATE_LIMIT > 0)
+   uint32_t now = (uint32_t) time(0);
+   if (site->windowStart != now)
+   {
+      site->windowStart = now;
+      site->windowCount = 0u;
+   }
+   if (site->windowCount >= APX_LOG_RATE_LIMIT)
+   {
+      site->numSuppressed++;
+      return false;
+   }
+   site->windowCount++;
+   *numSuppressed = site->numSuppressed;
+   site->numSuppressed = 0u;
+#else
+   (void) site;
+   *numSuppressed = 0u;
+#endif
+   return true;
+}
+
+/**
+ * returns the log buffer of the calling thread, it is created on first use
+ */
+static apx_logBuffer_t *apx_log_getThreadBuffer(void)
+{
+   apx_logBuffer_t *buffer = m_threadBuffer;
+   if (buffer == 0)
+   {
+      buffer = (apx_logBuffer_t*) malloc(sizeof(apx_logBuffer_t));
+      if (buffer == 0)
+      {
+         return 0;
+      }
+      buffer->data = (uint8_t*) malloc(APX_LOG_BUFFER_NUM_RECORDS*APX_LOG_RECORD_SIZE);
+      if (buffer->data == 0)
+      {
+         free(buffer);
+         return 0;
+      }
+      rbf32_create(&buffer->ringbuf, buffer->data, APX_LOG_BUFFER_NUM_RECORDS, APX_LOG_RECORD_SIZE);
+      buffer->numDropped = 0u;
+      buffer->numDroppedReported = 0u;
+      buffer->isOrphaned = false;
+      MUTEX_LOCK(m_bufferListLock);
+      buffer->next = m_bufferList;
+      m_bufferList = buffer;
+      MUTEX_UNLOCK(m_bufferListLock);
+#ifdef _MSC_VER
+      FlsSetValue(m_bufferKey, buffer);
+#else
+      pthread_setspecific(m_bufferKey, buffer);
+#endif
+      m_threadBuffer = buffer;
+   }
+   return buffer;
+}
+
+/**
+ * called when a thread that has a log buffer exits. The writer thread frees the buffer after printing its contents.
+ */
+static void apx_log_threadExit(void *arg)
+{
+   apx_logBuffer_t *buffer = (apx_logBuffer_t*) arg;
+   if (buffer != 0)
+   {
+      buffer->isOrphaned = true;
+   }
+}
+
+static void apx_log_output(uint8_t level, const char *msg)
+{
+   apx_logHandler_t *handler = m_handler;
+   handler(level, msg);
+}
+
+static void apx_log_defaultHandler(uint8_t level, const char *msg)
+{
+   FILE *stream = (level == APX_LOG_LEVEL_ERROR)? stderr : stdout;
+   fputs(msg, stream);
+   fputc('\n', stream);
+}
+
+/**
+ * p points to the character following '%'. Returns pointer to the character following the conversion specifier or
+ * 0 when the specification is incomplete.
+ */
+static const char *apx_log_parseSpec(const char *p, apx_logSpec_t *spec)
+{
+   memset(spec, 0, sizeof(apx_logSpec_t));
+   while ( (*p == '-') || (*p == '+') || (*p == ' ') || (*p == '#') || (*p == '0') )
+   {
+      if (spec->numFlags < (sizeof(spec->flags)-1))
+      {
+         spec->flags[spec->numFlags++] = *p;
+      }
+      p++;
+   }
+   if (*p == '*')
+   {
+      spec->hasWidth = true;
+      spec->widthIsArg = true;
+      p++;
+   }
+   else
+   {
+      while ( (*p >= '0') && (*p <= '9') )
+      {
+         spec->hasWidth = true;
+         spec->width = spec->width*10 + (*p - '0');
+         p++;
+      }
+   }
+   if (*p == '.')
+   {
+      spec->hasPrecision = true;
+      p++;
+      if (*p == '*')
+      {
+         spec->precisionIsArg = true;
+         p++;
+      }
+      else
+      {
+         while ( (*p >= '0') && (*p <= '9') )
+         {
+            spec->precision = spec->precision*10 + (*p - '0');
+            p++;
+         }
+      }
+   }
+   switch (*p)
+   {
+   case 'h':
+      p++;
+      spec->lengthMod = 'h';
+      if (*p == 'h')
+      {
+         spec->lengthMod = 'H';
+         p++;
+      }
+      break;
+   case 'l':
+      p++;
+      spec->lengthMod = 'l';
+      if (*p == 'l')
+      {
+         spec->lengthMod = 'q';
+         p++;
+      }
+      break;
+   case 'j':
+   case 'z':
+   case 't':
+   case 'L':
+      spec->lengthMod = *p++;
+      break;
+   default:
+      break;
+   }
+   if (*p == 0)
+   {
+      return 0;
+   }
+   spec->conversion = *p++;
+   return p;
+}
+
+static int32_t apx_log_buildSpec(char *dest, const apx_logSpec_t *spec, const char *lengthMod, char conversion)
+{
+   int32_t len;
+   char *p = dest;
+   *p++ = '%';
+   memcpy(p, spec->flags, spec->numFlags);
+   p += spec->numFlags;
+   if (spec->hasWidth)
+   {
+      p += sprintf(p, "%d", (int) spec->width);
+   }
+   if ( (spec->hasPrecision) && (spec->precision >= 0) )
+   {
+      //a negative precision given as argument is taken as if it was omitted
+      p += sprintf(p, ".%d", (int) spec->precision);
+   }
+   len = (int32_t) strlen(lengthMod);
+   memcpy(p, lengthMod, (size_t) len);
+   p += len;
+   *p++ = conversion;
+   *p = 0;
+   return (int32_t) (p - dest);
+}
+
+static bool apx_log_encodeValue(uint8_t *dest, uint32_t destLen, uint32_t *offset, const void *value, uint32_t size)
+{
+   if ( (*offset + size) > destLen)
+   {
+      return false;
+   }
+   memcpy(&dest[*offset], value, size);
+   *offset += size;
+   return true;
+}
+
+static void apx_log_append(char *dest, uint32_t destLen, uint32_t *pos, const char *fmt, ...)
+{
+   if (*pos + 1u < destLen)
+   {
+      int result;
+      va_list args;
+      va_start(args, fmt);
+      result = vsnprintf(&dest[*pos], destLen - *pos, fmt, args);
+      va_end(args);
+      if (result > 0)
+      {
+         *pos += (uint32_t) result;
+         if (*pos >= destLen)
+         {
+            *pos = destLen - 1u;
+         }
+      }
+   }
+}
+
+static void apx_log_formatRecord(const apx_logRecord_t *record, char *msg, uint32_t msgLen)
+{
+   uint32_t pos = (uint32_t) apx_log_decodeArgs(msg, msgLen, record->site->fmt, record->args, record->argLen);
+   if (record->numSuppressed > 0)
+   {
+      apx_log_append(msg, msgLen, &pos, " (%u similar messages suppressed)", (unsigned int) record->numSuppressed);
+   }
+}
+
+/**
+ * moves up to maxRecords buffered records into dest, taking them from the buffers in list order. Also returns the number
+ * of messages dropped since the previous call and frees buffers of exited threads once they are empty.
+ * returns number of records copied
+ */
+static uint32_t apx_log_collectRecords(apx_logRecord_t *dest, uint32_t maxRecords, uint32_t *numDropped)
+{
+   uint32_t numCopied = 0u;
+   apx_logBuffer_t **link;
+   *numDropped = 0u;
+   MUTEX_LOCK(m_bufferListLock);
+   link = &m_bufferList;
+   while ( (*link != 0) && (numCopied < maxRecords) )
+   {
+      apx_logBuffer_t *buffer = *link;
+      uint8_t *span;
+      uint32_t numAvailable;
+      uint32_t bufferDropped;
+      while ( (numCopied < maxRecords) && ( (numAvailable = rbf32_peekSpan(&buffer->ringbuf, &span)) > 0) )
+      {
+         uint32_t i;
+         if (numAvailable > maxRecords - numCopied)
+         {
+            numAvailable = maxRecords - numCopied;
+         }
+         for (i = 0; i < numAvailable; i++)
+         {
+            memcpy(&dest[numCopied++], &span[i*APX_LOG_RECORD_SIZE], sizeof(apx_logRecord_t));
+         }
+         rbf32_consume(&buffer->ringbuf, numAvailable);
+      }
+      bufferDropped = buffer->numDropped;
+      *numDropped += bufferDropped - buffer->numDroppedReported;
+      buffer->numDroppedReported = bufferDropped;
+      if ( (buffer->isOrphaned) && (rbf32_size(&buffer->ringbuf) == 0) )
+      {
+         *link = buffer->next;
+         free(buffer->data);
+         free(buffer);
+      }
+      else
+      {
+         link = &buffer->next;
+      }
+   }
+   MUTEX_UNLOCK(m_bufferListLock);
+   return numCopied;
+}
+
+static THREAD_PROTO(writerTask, arg)
+{
+   (void) arg;
+   while (m_isRunning)
+   {
+      apx_log_flush();
+      SLEEP(APX_LOG_WRITER_PERIOD_MS);
+   }
+   THREAD_RETURN(0);
+}
@@ -26,6 +26,10 @@ static void apx_node_setPortSignature(const apx_node_t *self, apx_port_t *port);
 static int apx_node_getDatatypeId(apx_port_t *port);
 static const char *apx_node_resolveDataSignature(const apx_node_t *self,apx_port_t *port);
 static void apx_parser_attributeParseError(apx_port_t *port, int32_t lastError);
+static int32_t apx_node_packPortInitData(apx_port_t *port, uint8_t *buf, uint32_t bufLen);
+static void apx_node_buildInitData(adt_ary_t *portList, adt_bytearray_t *initData);
+static uint32_t apx_node_calcPortDataLen(adt_ary_t *portList);
+static int8_t apx_node_copyInitData(adt_ary_t *portList, adt_bytearray_t *initData, const uint8_t *data, uint32_t dataLen);
 
 /**************** Private Variable Declarations *******************/
 
@@ -58,9 +62,10 @@ void apx_node_vdelete(void *arg)
 void apx_node_create(apx_node_t *self,const char *name){
    if(self != 0){
       self->name = 0;
-      adt_ary_create(&self->datatypeList,apx_datatype_vdelete);
-      adt_ary_create(&self->requirePortList,apx_port_vdelete);
-      adt_ary_create(&self->providePortList,apx_port_vdelete);
+      apx_arena_create(&self->arena, 0);
+      adt_ary_create(&self->datatypeList,0); //datatypes are owned by the arena and have nothing else to release
+      adt_ary_create(&self->requirePortList,apx_port_vdestroy);
+      adt_ary_create(&self->providePortList,apx_port_vdestroy);
       apx_attributeParser_create(&self->attributeParser);
       apx_node_setName(self,name);
       self->lastPortError=0;
@@ -68,6 +73,8 @@ void apx_node_create(apx_node_t *self,const char *name){
       self->lastPortType=-1;
       self->nodeInfo=(apx_nodeInfo_t*) 0;
       self->isFinalized = false;
+      adt_bytearray_create(&self->inPortInitData, 0);
+      adt_bytearray_create(&self->outPortInitData, 0);
    }
 }
 
@@ -77,6 +84,9 @@ void apx_node_destroy(apx_node_t *self){
       adt_ary_destroy(&self->providePortList);
       adt_ary_destroy(&self->requirePortList);
       apx_attributeParser_destroy(&self->attributeParser);
+      adt_bytearray_destroy(&self->inPortInitData);
+      adt_bytearray_destroy(&self->outPortInitData);
+      apx_arena_destroy(&self->arena);
       if(self->name != 0){
          free(self->name);
       }
@@ -107,13 +117,28 @@ const char *apx_node_getName(apx_node_t *self)
    return (const char*) 0;
 }
 
+/**
+ * preallocates arena memory for the datatypes and ports of a definition with the given text length.
+ * Calling this before the ports are created lets small and medium sized nodes live in a single arena chunk.
+ */
+int8_t apx_node_reserve(apx_node_t *self, uint32_t definitionLen)
+{
+   if (self != 0)
+   {
+      //each declaration line turns into a port object plus a copy of its name, data signature and port signature
+      return apx_arena_reserve(&self->arena, definitionLen*2u + APX_ARENA_DEFAULT_CHUNK_SIZE);
+   }
+   errno = EINVAL;
+   return -1;
+}
+
 //datatype functions
 apx_datatype_t *apx_node_createDataType(apx_node_t *self, const char* name, const char *dsg, const char *attr)
 {
    apx_datatype_t *datatype=0;
    if (self != 0)
    {
-     datatype = apx_datatype_new(name,dsg,attr);
+     datatype = apx_datatype_newInArena(&self->arena,name,dsg,attr);
      if (datatype != 0)
      {
         adt_ary_push(&self->datatypeList,datatype);
@@ -128,7 +153,7 @@ apx_port_t *apx_node_createRequirePort(apx_node_t *self, const char* name, const
    apx_port_t *port=0;
    if (self != 0)
    {
-     port = apx_requirePort_new(name,dsg,attr);
+     port = apx_port_newInArena(&self->arena,APX_REQUIRE_PORT,name,dsg,attr);
      if (port != 0)
      {
         int32_t portIndex = adt_ary_length(&self->requirePortList);
@@ -140,7 +165,7 @@ apx_port_t *apx_node_createRequirePort(apx_node_t *self, const char* name, const
               int32_t lastError;
               lastError = apx_attributeParser_getLastError(&self->attributeParser, 0);
               apx_parser_attributeParseError(port, lastError);
-              apx_port_delete(port);
+              apx_port_destroy(port); //memory is returned when the arena is destroyed
               return 0;
            }
         }
@@ -156,7 +181,7 @@ apx_port_t *apx_node_createProvidePort(apx_node_t *self, const char* name, const
    apx_port_t *port=0;
    if (self != 0)
    {
-     port = apx_providePort_new(name,dsg,attr);
+     port = apx_port_newInArena(&self->arena,APX_PROVIDE_PORT,name,dsg,attr);
      if (port != 0)
      {
         int32_t portIndex = adt_ary_length(&self->providePortList);
@@ -168,7 +193,7 @@ apx_port_t *apx_node_createProvidePort(apx_node_t *self, const char* name, const
               int32_t lastError;
               lastError = apx_attributeParser_getLastError(&self->attributeParser, 0);
               apx_parser_attributeParseError(port, lastError);
-              apx_port_delete(port);
+              apx_port_destroy(port); //memory is returned when the arena is destroyed
               return 0;
            }
         }
@@ -179,6 +204,30 @@ apx_port_t *apx_node_createProvidePort(apx_node_t *self, const char* name, const
    return port;
 }
 
+/**
+ * adds a port to the node without parsing its attribute string.
+ * Used when the init data of the node is already known (see apx_node_finalizeWithInitData)
+ */
+apx_port_t *apx_node_appendPort(apx_node_t *self, uint8_t portType, const char* name, const char *dsg, const char *attr)
+{
+   apx_port_t *port=0;
+   if (self != 0)
+   {
+      adt_ary_t *portList = (portType == APX_REQUIRE_PORT)? &self->requirePortList : &self->providePortList;
+      port = apx_port_newInArena(&self->arena,portType,name,dsg,attr);
+      if (port != 0)
+      {
+         apx_port_setPortIndex(port,adt_ary_length(portList));
+         adt_ary_push(portList,port);
+      }
+   }
+   else
+   {
+      errno = EINVAL;
+   }
+   return port;
+}
+
 /**
  * return 0 on success, -1 on error
  */
@@ -205,6 +254,9 @@ int8_t apx_node_finalize(apx_node_t *self)
          apx_port_t *port = (apx_port_t*) adt_ary_value(&self->requirePortList,i);
          apx_node_setPortSignature(self,port);
       }
+      //pack init values once, nodeData buffers are then initialized using a single memcpy
+      apx_node_buildInitData(&self->requirePortList, &self->inPortInitData);
+      apx_node_buildInitData(&self->providePortList, &self->outPortInitData);
       self->isFinalized = true;
       return 0;
    }
@@ -268,6 +320,77 @@ adt_bytearray_t *apx_node_createPortInitData(apx_node_t *self, apx_port_t *port)
    return 0;
 }
 
+/**
+ * finalizes a node whose ports already have their derived data signature and port signature set (see apx_binaryDefinition).
+ * Data signatures are not resolved or parsed again, the precomputed init data is used instead of packing the init value of each port.
+ * The length of each init data image must match the total pack length of the corresponding ports.
+ * return 0 on success, -1 on error
+ */
+int8_t apx_node_finalizeWithInitData(apx_node_t *self, const uint8_t *inPortInitData, uint32_t inPortDataLen, const uint8_t *outPortInitData, uint32_t outPortDataLen)
+{
+   if (self != 0)
+   {
+      if (self->isFinalized == true)
+      {
+         return 0;
+      }
+      if ( (apx_node_copyInitData(&self->requirePortList, &self->inPortInitData, inPortInitData, inPortDataLen) != 0) ||
+           (apx_node_copyInitData(&self->providePortList, &self->outPortInitData, outPortInitData, outPortDataLen) != 0) )
+      {
+         return -1;
+      }
+      self->isFinalized = true;
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * returns the init data of all require ports in port index order. Only valid after apx_node_finalize
+ */
+const uint8_t *apx_node_getInPortInitData(apx_node_t *self)
+{
+   if (self != 0)
+   {
+      return adt_bytearray_data(&self->inPortInitData);
+   }
+   errno = EINVAL;
+   return (const uint8_t*) 0;
+}
+
+uint32_t apx_node_getInPortDataLen(apx_node_t *self)
+{
+   if (self != 0)
+   {
+      return adt_bytearray_length(&self->inPortInitData);
+   }
+   errno = EINVAL;
+   return 0u;
+}
+
+/**
+ * returns the init data of all provide ports in port index order. Only valid after apx_node_finalize
+ */
+const uint8_t *apx_node_getOutPortInitData(apx_node_t *self)
+{
+   if (self != 0)
+   {
+      return adt_bytearray_data(&self->outPortInitData);
+   }
+   errno = EINVAL;
+   return (const uint8_t*) 0;
+}
+
+uint32_t apx_node_getOutPortDataLen(apx_node_t *self)
+{
+   if (self != 0)
+   {
+      return adt_bytearray_length(&self->outPortInitData);
+   }
+   errno = EINVAL;
+   return 0u;
+}
 
 /***************** Private Function Definitions *******************/
 static void apx_node_setPortSignature(const apx_node_t *self, apx_port_t *port)
@@ -396,39 +519,87 @@ int32_t apx_node_fillPortInitData(apx_node_t *self, apx_port_t *port, adt_bytear
          return -1;
       }
       adt_bytearray_resize(output, dataElement->packLen);
-      if (port->portAttributes != 0)
+      return apx_node_packPortInitData(port, adt_bytearray_data(output), dataElement->packLen);
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * packs the init value of port into buf. Ports without init value are initialized to 0.
+ * returns 0 on success, -1 on error
+ */
+static int32_t apx_node_packPortInitData(apx_port_t *port, uint8_t *buf, uint32_t bufLen)
+{
+   if ( (port->portAttributes != 0) && (port->portAttributes->initValue != 0) )
+   {
+      uint8_t *pResult = apx_dataSignature_pack_dv(&port->derivedDsg, buf, buf + bufLen, port->portAttributes->initValue);
+      if ( (pResult == 0) || (pResult == buf) )
       {
-         apx_portAttributes_t *attr = port->portAttributes;
-         if (attr->initValue == 0)
-         {
-            //if no init value is given, set to 0
-            uint8_t *buf = adt_bytearray_data(output);
-            memset(buf, 0, dataElement->packLen);
-            return 0;
-         }
-         else
+         return -1;
+      }
+   }
+   else
+   {
+      //if no init value is given, set to 0
+      memset(buf, 0, bufLen);
+   }
+   return 0;
+}
+
+/**
+ * creates one init data image for all ports in portList, laid out in the same order as apx_portDataMap_t
+ */
+static void apx_node_buildInitData(adt_ary_t *portList, adt_bytearray_t *initData)
+{
+   int32_t i;
+   int32_t numPorts = adt_ary_length(portList);
+   uint8_t *pNext;
+   adt_bytearray_resize(initData, apx_node_calcPortDataLen(portList));
+   pNext = adt_bytearray_data(initData);
+   for(i=0;i<numPorts;i++)
+   {
+      apx_port_t *port = (apx_port_t*) adt_ary_value(portList,i);
+      int32_t packLen = apx_port_getPackLen(port);
+      if (packLen > 0)
+      {
+         if (apx_node_packPortInitData(port, pNext, (uint32_t) packLen) != 0)
          {
-            uint8_t *pBegin;
-            uint8_t *pEnd;
-            uint8_t *pResult;
-            pBegin = adt_bytearray_data(output);
-            pEnd = pBegin + dataElement->packLen;
-            pResult = apx_dataElement_pack_dv(dataElement, pBegin, pEnd, attr->initValue);
-            if ( (pResult == 0) || (pResult == pBegin) )
-            {
-               return -1;
-            }
-            return 0;
+            APX_LOG_ERROR("[APX_NODE] Failed to pack init value of port %s", port->name);
+            memset(pNext, 0, (size_t) packLen);
          }
+         pNext += packLen;
       }
-      else
+   }
+}
+
+static uint32_t apx_node_calcPortDataLen(adt_ary_t *portList)
+{
+   int32_t i;
+   int32_t numPorts = adt_ary_length(portList);
+   uint32_t totalLen = 0;
+   for(i=0;i<numPorts;i++)
+   {
+      int32_t packLen = apx_port_getPackLen((apx_port_t*) adt_ary_value(portList,i));
+      if (packLen > 0)
       {
-         //if no init value is given, set to 0
-         uint8_t *buf = adt_bytearray_data(output);
-         memset(buf, 0, dataElement->packLen);
-         return 0;
+         totalLen += (uint32_t) packLen;
       }
    }
-   errno = EINVAL;
-   return -1;
+   return totalLen;
+}
+
+static int8_t apx_node_copyInitData(adt_ary_t *portList, adt_bytearray_t *initData, const uint8_t *data, uint32_t dataLen)
+{
+   if ( (apx_node_calcPortDataLen(portList) != dataLen) || ( (dataLen > 0) && (data == 0) ) )
+   {
+      apx_setError(APX_LENGTH_ERROR);
+      return -1;
+   }
+   adt_bytearray_resize(initData, dataLen);
+   if (dataLen > 0)
+   {
+      memcpy(adt_bytearray_data(initData), data, dataLen);
+   }
+   return 0;
 }
@@ -71,6 +71,7 @@ void apx_nodeData_create(apx_nodeData_t *self, const char *name, uint8_t *defini
       SPINLOCK_INIT(self->internalLock);
       self->fileManager = (apx_fileManager_t*) 0;
       self->nodeInfo = (apx_nodeInfo_t*) 0;
+      self->ownerNext = (apx_nodeData_t*) 0;
 #endif
    }
 }
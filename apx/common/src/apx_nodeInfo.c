@@ -61,6 +61,7 @@ void apx_nodeInfo_create(apx_nodeInfo_t *self, apx_node_t *node)
       self->node=node;
       node->nodeInfo=self;
       self->isWeakRef_node = true; //default true
+      self->isAttached = false;
       numRequirePorts = adt_ary_length(&self->node->requirePortList);
       numProvidePorts = adt_ary_length(&self->node->providePortList);
       adt_ary_resize(&self->requireConnectors,numRequirePorts);
@@ -22,6 +22,7 @@
 #include "apx_nodeInfo.h"
 #include "apx_router.h"
 #include "apx_logging.h"
+#include "apx_binaryDefinition.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -38,13 +39,16 @@
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void apx_nodeManager_createNode(apx_nodeManager_t *self, const uint8_t *definitionBuf, int32_t definitionLen, struct apx_fileManager_tag *fileManager);
+static void apx_nodeManager_createNodeFromBinary(apx_nodeManager_t *self, const uint8_t *definitionBuf, int32_t definitionLen, struct apx_fileManager_tag *fileManager);
+static int8_t apx_nodeManager_attachRemoteNode(apx_nodeManager_t *self, apx_node_t *apxNode, struct apx_fileManager_tag *fileManager, const char *debugInfoStr);
 static apx_nodeData_t *apx_nodeManager_getNodeData(const apx_nodeManager_t *self, const char *name);
 static void apx_nodeManager_setLocalNodeData(apx_nodeManager_t *self, apx_nodeData_t *nodeData);
-static void apx_nodeManager_executePortTriggerFunction(const apx_dataTriggerFunction_t *triggerFunction, const apx_file_t *file);
+static uint32_t apx_nodeManager_executePortTriggerFunction(const apx_dataTriggerFunction_t *triggerFunction, const apx_file_t *file);
 static void apx_nodeManager_attachLocalNodeToFileManager(apx_nodeData_t *nodeData, apx_fileManager_t *fileManager);
 static void apx_nodeManager_removeRemoteNodeData(apx_nodeManager_t *self, apx_nodeData_t *nodeData);
 static void apx_nodeManager_removeNodeInfo(apx_nodeManager_t *self, apx_nodeInfo_t *nodeInfo);
-static bool apx_nodeManager_createInitData(apx_node_t *node, uint8_t *buf, int32_t bufLen);
+static void apx_nodeManager_detachFileManagersLocked(apx_nodeManager_t *self, struct apx_fileManager_tag **fileManagers, int32_t numFileManagers);
+static void apx_nodeManager_addOwnedNodeData(apx_fileManager_t *fileManager, apx_nodeData_t *nodeData);
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
@@ -104,7 +108,7 @@ void apx_nodeManager_remoteFileAdded(apx_nodeManager_t *self, struct apx_fileMan
 {
    if ( (self != 0) && (fileManager != 0) && (remoteFile != 0) )
    {
-      if ( remoteFile->fileType == APX_DEFINITION_FILE )
+      if ( (remoteFile->fileType == APX_DEFINITION_FILE) || (remoteFile->fileType == APX_DEFINITION_BIN_FILE) )
       {
          char *basename = apx_file_basename(remoteFile);
          if (basename != 0)
@@ -113,6 +117,13 @@ void apx_nodeManager_remoteFileAdded(apx_nodeManager_t *self, struct apx_fileMan
             //this is potentially a new node, check if it exists already
             MUTEX_LOCK(self->lock);
             nodeData = apx_nodeManager_getNodeData(self, basename);
+            if ( (nodeData != 0) && (nodeData->fileManager != 0) && (nodeData->fileManager != fileManager) && (apx_fileManager_isDead(nodeData->fileManager) == true) )
+            {
+               //the client reconnected before its previous connection was torn down, detach the old connection right away
+               struct apx_fileManager_tag *deadFileManager = nodeData->fileManager;
+               apx_nodeManager_detachFileManagersLocked(self, &deadFileManager, 1);
+               nodeData = apx_nodeManager_getNodeData(self, basename);
+            }
             MUTEX_UNLOCK(self->lock);
             if (nodeData == 0)
             {
@@ -133,8 +144,10 @@ void apx_nodeManager_remoteFileAdded(apx_nodeManager_t *self, struct apx_fileMan
                      else
                      {
                         nodeData->definitionDataLen = remoteFile->fileInfo.length;
+                        apx_nodeData_setFileManager(nodeData, fileManager);
                         MUTEX_LOCK(self->lock);
                         adt_hash_set(&self->remoteNodeDataMap, basename, 0, nodeData);
+                        apx_nodeManager_addOwnedNodeData(fileManager, nodeData);
                         MUTEX_UNLOCK(self->lock);
                         //now that memory has been allocated, send request to open the file (triggering file transfer)
                         apx_fileManager_sendFileOpen(fileManager, remoteFile->fileInfo.address);
@@ -220,6 +233,12 @@ void apx_nodeManager_remoteFileWritten(apx_nodeManager_t *self, struct apx_fileM
          apx_nodeManager_createNode(self, remoteFile->nodeData->definitionDataBuf, remoteFile->nodeData->definitionDataLen, fileManager);
          MUTEX_UNLOCK(self->lock);
       }
+      else if (remoteFile->fileType == APX_DEFINITION_BIN_FILE)
+      {
+         MUTEX_LOCK(self->lock);
+         apx_nodeManager_createNodeFromBinary(self, remoteFile->nodeData->definitionDataBuf, remoteFile->nodeData->definitionDataLen, fileManager);
+         MUTEX_UNLOCK(self->lock);
+      }
       else
       {
          uint32_t endOffset = offset + length;
@@ -234,6 +253,7 @@ void apx_nodeManager_remoteFileWritten(apx_nodeManager_t *self, struct apx_fileM
          if (remoteFile->fileType == APX_OUTDATA_FILE)
          {
             apx_nodeInfo_t *nodeInfo = remoteFile->nodeData->nodeInfo;
+            uint32_t numTriggers = 0u;
             assert(nodeInfo != 0);
             while (offset < endOffset)
             {
@@ -241,7 +261,7 @@ void apx_nodeManager_remoteFileWritten(apx_nodeManager_t *self, struct apx_fileM
                triggerFunction = apx_nodeInfo_getTriggerFunction(nodeInfo, offset);
                if (triggerFunction != 0)
                {
-                  apx_nodeManager_executePortTriggerFunction(triggerFunction, remoteFile);
+                  numTriggers += apx_nodeManager_executePortTriggerFunction(triggerFunction, remoteFile);
                   offset = triggerFunction->srcOffset + triggerFunction->dataLength;
                }
                else
@@ -250,6 +270,10 @@ void apx_nodeManager_remoteFileWritten(apx_nodeManager_t *self, struct apx_fileM
                   offset++;
                }
             }
+            if ( (numTriggers > 0u) && (fileManager != 0) )
+            {
+               APX_STATS_ADD32(fileManager->stats.numTriggers, numTriggers);
+            }
          }
       }
    }
@@ -340,106 +364,21 @@ void apx_nodeManager_attachFileManager(apx_nodeManager_t *self, struct apx_fileM
  */
 void apx_nodeManager_detachFileManager(apx_nodeManager_t *self, struct apx_fileManager_tag *fileManager)
 {
-   if (fileManager->debugInfo != 0)
-   {
-      APX_LOG_INFO("[APX_NODE_MANAGER] (%p) Detaching file manager", fileManager->debugInfo);
-   }
-   else
-   {
-      APX_LOG_INFO("[APX_NODE_MANAGER] %s", "Detaching file manager");
-   }
+   apx_nodeManager_detachFileManagers(self, &fileManager, 1);
+}
 
-   if ( (self != 0) && (fileManager != 0) )
+/**
+ * detaches a batch of fileManagers from this nodeManager. The nodes of all fileManagers in the batch are detached
+ * from the router in one step which means that signals are rerouted once, no matter how many connections were lost.
+ * fileManagers that are not (or no longer) attached to this nodeManager are ignored.
+ */
+void apx_nodeManager_detachFileManagers(apx_nodeManager_t *self, struct apx_fileManager_tag **fileManagers, int32_t numFileManagers)
+{
+   if ( (self != 0) && (fileManagers != 0) && (numFileManagers > 0) )
    {
-      void **ppVal;
-      const char *key;
-      int32_t i;
-      int32_t end;
-      uint32_t keyLen;
-      adt_ary_t toBeDeleted; //list of nodeInfo_t that we need to remove from nodeInfoMap due to the removal of the file manager
-      adt_ary_t deletedNodeData; //list of deleted nodeData_t, used to prevent duplicate deletions
-
-      adt_ary_create(&toBeDeleted, NULL);
-      adt_ary_create(&deletedNodeData, NULL);
-      adt_list_remove(&self->fileManagerList, fileManager);
-      adt_hash_iter_init(&self->nodeInfoMap);
-      do
-      {
-         ppVal = adt_hash_iter_next(&self->nodeInfoMap,&key, &keyLen);
-         if (ppVal != 0)
-         {
-            apx_nodeInfo_t *nodeInfo = (apx_nodeInfo_t*) *ppVal;
-            assert(nodeInfo != 0);
-            if (nodeInfo->nodeData != 0)
-            {
-               if (nodeInfo->nodeData->fileManager == fileManager)
-               {
-                  adt_ary_push(&toBeDeleted, nodeInfo);
-               }
-            }
-         }
-      } while(ppVal != 0);
-      end = adt_ary_length(&toBeDeleted);
-      for (i=0; i<end; i++)
-      {
-         apx_nodeInfo_t *nodeInfo = (apx_nodeInfo_t*) *adt_ary_get(&toBeDeleted, i);
-         apx_nodeData_t *nodeData = nodeInfo->nodeData;
-         if (self->router != 0)
-         {
-            apx_router_detachNodeInfo(self->router, nodeInfo);
-         }
-         apx_nodeManager_removeRemoteNodeData(self, nodeData);
-         apx_nodeData_delete(nodeData);
-         adt_ary_push(&deletedNodeData,nodeData);
-         apx_nodeManager_removeNodeInfo(self, nodeInfo);
-         apx_nodeInfo_delete(nodeInfo);
-      }
-      
-      {
-         //remove any remaining nodeInfos attached to this fileManager
-         adt_list_elem_t *iter;
-         adt_list_iter_init(&fileManager->remoteFileMap.fileList);
-         do
-         {
-            iter = adt_list_iter_next(&fileManager->remoteFileMap.fileList);
-            if (iter != 0)
-            {
-               apx_file_t *file = (apx_file_t*)iter->pItem;
-               if ( (file != 0) && (file->nodeData != 0))
-               {
-                  bool found=false;
-                  end = adt_ary_length(&deletedNodeData);
-                  for (i=0; i<end; i++)
-                  {
-                     //prevent deleting nodeData twice
-                     apx_nodeData_t *nodeData = (apx_nodeData_t*) *adt_ary_get(&deletedNodeData, i);
-                     if (nodeData == file->nodeData)
-                     {
-                        found=true;
-                        break;
-                     }
-                  }
-                  if (found == false)
-                  {
-                     MUTEX_LOCK(self->lock);
-                     ppVal = adt_hash_get(&self->remoteNodeDataMap, file->nodeData->name, 0);
-                     if (ppVal != 0)
-                     {
-                        APX_LOG_INFO("[APX_NODE_MANAGER] deleting nodeData for %s",file->nodeData->name);
-                        apx_nodeManager_removeRemoteNodeData(self, file->nodeData);
-                        apx_nodeData_delete(file->nodeData);
-                        adt_ary_push(&deletedNodeData, file->nodeData);
-//                        apx_nodeManager_removeNodeInfo(self, nodeInfo);
-//                        apx_nodeInfo_delete(nodeInfo);
-                     }
-                     MUTEX_UNLOCK(self->lock);
-                  }
-               }
-            }
-         }while(iter != 0);
-      }
-      adt_ary_destroy(&toBeDeleted);
-      adt_ary_destroy(&deletedNodeData);
+      MUTEX_LOCK(self->lock);
+      apx_nodeManager_detachFileManagersLocked(self, fileManagers, numFileManagers);
+      MUTEX_UNLOCK(self->lock);
    }
 }
 
@@ -473,6 +412,7 @@ static void apx_nodeManager_createNode(apx_nodeManager_t *self, const uint8_t *d
       APX_LOG_INFO("[APX_NODE_MANAGER]%s Server processing APX definition, len=%d", debugInfoStr, (int) definitionLen);
 
 
+      (void) apx_parser_setNodeReserveLens(&self->parser, definitionBuf, (uint32_t) definitionLen);
       apx_istream_reset(&self->apx_istream);
       apx_istream_open(&self->apx_istream);
       apx_istream_write(&self->apx_istream, definitionBuf, (uint32_t) definitionLen);
@@ -480,114 +420,166 @@ static void apx_nodeManager_createNode(apx_nodeManager_t *self, const uint8_t *d
       numNodes = apx_parser_getNumNodes(&self->parser);
       for (i=0;i<numNodes;i++)
       {
-         apx_nodeInfo_t *nodeInfo;
          apx_node_t *apxNode = apx_parser_getNode(&self->parser, i);
          assert(apxNode != 0);
          apx_node_finalize(apxNode);
-         nodeInfo = apx_nodeInfo_new(apxNode);
-         if (nodeInfo != 0)
+         if (apx_nodeManager_attachRemoteNode(self, apxNode, fileManager, debugInfoStr) != 0)
          {
-            apx_nodeData_t *nodeData=0;
-            char fileName[RMF_MAX_FILE_NAME];
-            char *p;
-            int32_t inPortDataLen;
-            int32_t outPortDataLen;
-            apx_file_t *inDataFile = (apx_file_t*) 0;
+            return;
+         }
+      }
+      apx_parser_clearNodes(&self->parser);
+   }
+}
 
+/**
+ * used to create new remote nodes on server side from a precompiled (binary) definition. No APX text is parsed.
+ */
+static void apx_nodeManager_createNodeFromBinary(apx_nodeManager_t *self, const uint8_t *definitionBuf, int32_t definitionLen, struct apx_fileManager_tag *fileManager)
+{
+   if( (self != 0) && (definitionBuf != 0) && (definitionLen > 0) )
+   {
+      apx_node_t *apxNode;
+      char debugInfoStr[APX_DEBUG_INFO_MAX_LEN];
+      debugInfoStr[0]=0;
+      if (fileManager->debugInfo != 0)
+      {
+         snprintf(debugInfoStr, APX_DEBUG_INFO_MAX_LEN, " (%p)", fileManager->debugInfo);
+      }
+      APX_LOG_INFO("[APX_NODE_MANAGER]%s Server processing binary APX definition, len=%d", debugInfoStr, (int) definitionLen);
+      apxNode = apx_binaryDefinition_createNode(definitionBuf, (uint32_t) definitionLen);
+      if (apxNode == 0)
+      {
+         APX_LOG_ERROR("[APX_NODE_MANAGER]%s Failed to load binary APX definition", debugInfoStr);
+         return;
+      }
+      if (apx_nodeManager_attachRemoteNode(self, apxNode, fileManager, debugInfoStr) != 0)
+      {
+         apx_node_delete(apxNode);
+      }
+   }
+}
 
-            nodeData = apx_nodeManager_getNodeData(self, apxNode->name);
-            if (nodeData == 0)
-            {
-               APX_LOG_ERROR("[APX_NODE_MANAGER] %s", "Failed to create nodeData object");
-               return;
-            }
-            apx_nodeData_setFileManager(nodeData,fileManager);
-            apx_nodeData_setNodeInfo(nodeData, nodeInfo);
-            apx_nodeInfo_setNodeData(nodeInfo, nodeData);
-            nodeInfo->isWeakRef_node = false; //nodeInfo is now the owner of the node pointer (will trigger deletion when apx_nodeInfo_delete is called)
-            adt_hash_set(&self->nodeInfoMap, apxNode->name, 0, nodeInfo);
-            inPortDataLen = apx_nodeInfo_getInPortDataLen(nodeInfo);
-            outPortDataLen = apx_nodeInfo_getOutPortDataLen(nodeInfo);
-            
-            //if node has output data, search a file called "<node_name>.out"
-            if (outPortDataLen > 0)
+/**
+ * creates nodeInfo for a finalized node received from a client and attaches it to the router.
+ * On success the created nodeInfo takes ownership of apxNode.
+ * returns 0 on success, -1 on error
+ */
+static int8_t apx_nodeManager_attachRemoteNode(apx_nodeManager_t *self, apx_node_t *apxNode, struct apx_fileManager_tag *fileManager, const char *debugInfoStr)
+{
+   apx_nodeInfo_t *nodeInfo = apx_nodeInfo_new(apxNode);
+   if (nodeInfo != 0)
+   {
+      apx_nodeData_t *nodeData=0;
+      char fileName[RMF_MAX_FILE_NAME];
+      char *p;
+      int32_t inPortDataLen;
+      int32_t outPortDataLen;
+      apx_file_t *inDataFile = (apx_file_t*) 0;
+
+      //the node name may come from a binary definition sent by the client, make sure "<node_name>.out" fits in fileName
+      if ( (apxNode->name == 0) || (strlen(apxNode->name) + sizeof(".out") > RMF_MAX_FILE_NAME) )
+      {
+         APX_LOG_ERROR("[APX_NODE_MANAGER]%s %s", debugInfoStr, "Node name is missing or too long");
+         apx_nodeInfo_delete(nodeInfo);
+         return -1;
+      }
+      nodeData = apx_nodeManager_getNodeData(self, apxNode->name);
+      if (nodeData == 0)
+      {
+         APX_LOG_ERROR("[APX_NODE_MANAGER] %s", "Failed to create nodeData object");
+         apx_nodeInfo_delete(nodeInfo);
+         return -1;
+      }
+      apx_nodeData_setFileManager(nodeData,fileManager);
+      apx_nodeData_setNodeInfo(nodeData, nodeInfo);
+      apx_nodeInfo_setNodeData(nodeInfo, nodeData);
+      nodeInfo->isWeakRef_node = false; //nodeInfo is now the owner of the node pointer (will trigger deletion when apx_nodeInfo_delete is called)
+      adt_hash_set(&self->nodeInfoMap, apxNode->name, 0, nodeInfo);
+      inPortDataLen = apx_nodeInfo_getInPortDataLen(nodeInfo);
+      outPortDataLen = apx_nodeInfo_getOutPortDataLen(nodeInfo);
+      
+      //if node has output data, search a file called "<node_name>.out"
+      if (outPortDataLen > 0)
+      {
+         apx_file_t *outDataFile;
+         strcpy(fileName,apxNode->name);
+         p=fileName+strlen(fileName);
+         strcpy(p,".out");
+         
+         outDataFile = apx_fileManager_findRemoteFile(fileManager, fileName);
+         if (outDataFile != 0)
+         {
+            //check if length of file is the expected length of our outPortDataLen calculation
+            if (outPortDataLen != (int32_t) outDataFile->fileInfo.length)
             {
-               apx_file_t *outDataFile;
-               strcpy(fileName,apxNode->name);
-               p=fileName+strlen(fileName);
-               strcpy(p,".out");
-               
-               outDataFile = apx_fileManager_findRemoteFile(fileManager, fileName);
-               if (outDataFile != 0)
-               {
-                  //check if length of file is the expected length of our outPortDataLen calculation
-                  if (outPortDataLen != (int32_t) outDataFile->fileInfo.length)
-                  {
-                     APX_LOG_ERROR("[APX_NODE_MANAGER] length of file %s is %d, expected length was %d\n", fileName, outDataFile->fileInfo.length, outPortDataLen);
-                  }
-                  else
-                  {
-                     if (outDataFile->nodeData==0)
-                     {
-                        outDataFile->nodeData=nodeData;
-                        //now create memory for the outPortData
-                        nodeData->outPortDataBuf = (uint8_t*) malloc(outPortDataLen);
-                        assert(nodeData->outPortDataBuf);
-                        nodeData->outPortDirtyFlags = (uint8_t*) malloc(outPortDataLen);
-                        assert(nodeData->outPortDirtyFlags);
-                        nodeData->outPortDataLen = outPortDataLen;
-                        APX_LOG_INFO("[APX_NODE_MANAGER]%s Server opening client file %s[%d,%d]", debugInfoStr, fileName, outDataFile->fileInfo.address, outDataFile->fileInfo.length);
-                        apx_nodeData_setNodeInfo(nodeData, nodeInfo);
-                        apx_fileManager_sendFileOpen(fileManager, outDataFile->fileInfo.address);
-                     }
-                  }
-               }
-               else
-               {
-                  APX_LOG_WARNING("[APX_NODE_MANAGER] '%s': no file found", fileName);
-               }
+               APX_LOG_ERROR("[APX_NODE_MANAGER] length of file %s is %d, expected length was %d\n", fileName, outDataFile->fileInfo.length, outPortDataLen);
             }
-            if (inPortDataLen > 0)
+            else
             {
-               //create local inPortData file
-
-               bool result;
-               strcpy(fileName,apxNode->name);
-               p=fileName+strlen(fileName);
-               strcpy(p,".in");
-               
-               nodeData->inPortDataBuf = (uint8_t*) malloc(inPortDataLen);
-               assert(nodeData->inPortDataBuf);
-               nodeData->inPortDirtyFlags = (uint8_t*) malloc(inPortDataLen);
-               assert(nodeData->inPortDirtyFlags);
-               result = apx_nodeManager_createInitData(apxNode, nodeData->inPortDataBuf, inPortDataLen);
-               if (result == false)
-               {
-                  APX_LOG_ERROR("[APX_NODE_MANAGER] Failed to create init data for node %s", apx_node_getName(apxNode));
-               }
-               nodeData->inPortDataLen = inPortDataLen;
-               inDataFile = apx_file_newLocalInPortDataFile(nodeData);
-               if (inDataFile == 0)
+               if (outDataFile->nodeData==0)
                {
-                  APX_LOG_ERROR("[APX_NODE_MANAGER]%s Server failed to create local file '%s'", debugInfoStr, fileName);
+                  outDataFile->nodeData=nodeData;
+                  //now create memory for the outPortData
+                  nodeData->outPortDataBuf = (uint8_t*) malloc(outPortDataLen);
+                  assert(nodeData->outPortDataBuf);
+                  nodeData->outPortDirtyFlags = (uint8_t*) malloc(outPortDataLen);
+                  assert(nodeData->outPortDirtyFlags);
+                  nodeData->outPortDataLen = outPortDataLen;
+                  APX_LOG_INFO("[APX_NODE_MANAGER]%s Server opening client file %s[%d,%d]", debugInfoStr, fileName, outDataFile->fileInfo.address, outDataFile->fileInfo.length);
+                  apx_nodeData_setNodeInfo(nodeData, nodeInfo);
+                  apx_fileManager_sendFileOpen(fileManager, outDataFile->fileInfo.address);
                }
             }
-            //router is set, attach the newly create nodeInfo to the router
-            if (self->router != 0)
-            {
-               apx_router_attachNodeInfo(self->router, nodeInfo);
-            }
-            //for all connected require ports copy data from the provide port into our newly create inDataFile buffer
-            apx_nodeInfo_copyInitDataFromProvideConnectors(nodeInfo);
-            if (inDataFile != 0)
-            {
-               apx_fileManager_attachLocalPortDataFile(fileManager, inDataFile);
-               APX_LOG_INFO("[APX_NODE_MANAGER]%s Server created file %s[%d,%d]", debugInfoStr, fileName, inDataFile->fileInfo.address, inDataFile->fileInfo.length);
-            }
+         }
+         else
+         {
+            APX_LOG_WARNING("[APX_NODE_MANAGER] '%s': no file found", fileName);
          }
       }
-      apx_parser_clearNodes(&self->parser);
+      if (inPortDataLen > 0)
+      {
+         //create local inPortData file
+         strcpy(fileName,apxNode->name);
+         p=fileName+strlen(fileName);
+         strcpy(p,".in");
+         
+         nodeData->inPortDataBuf = (uint8_t*) malloc(inPortDataLen);
+         assert(nodeData->inPortDataBuf);
+         nodeData->inPortDirtyFlags = (uint8_t*) malloc(inPortDataLen);
+         assert(nodeData->inPortDirtyFlags);
+         if (apx_node_getInPortDataLen(apxNode) == (uint32_t) inPortDataLen)
+         {
+            //init data was precomputed when the node was finalized
+            memcpy(nodeData->inPortDataBuf, apx_node_getInPortInitData(apxNode), inPortDataLen);
+         }
+         else
+         {
+            APX_LOG_ERROR("[APX_NODE_MANAGER] Failed to create init data for node %s", apx_node_getName(apxNode));
+            memset(nodeData->inPortDataBuf, 0, inPortDataLen);
+         }
+         nodeData->inPortDataLen = inPortDataLen;
+         inDataFile = apx_file_newLocalInPortDataFile(nodeData);
+         if (inDataFile == 0)
+         {
+            APX_LOG_ERROR("[APX_NODE_MANAGER]%s Server failed to create local file '%s'", debugInfoStr, fileName);
+         }
+      }
+      //router is set, attach the newly create nodeInfo to the router
+      if (self->router != 0)
+      {
+         apx_router_attachNodeInfo(self->router, nodeInfo);
+      }
+      //for all connected require ports copy data from the provide port into our newly create inDataFile buffer
+      apx_nodeInfo_copyInitDataFromProvideConnectors(nodeInfo);
+      if (inDataFile != 0)
+      {
+         apx_fileManager_attachLocalPortDataFile(fileManager, inDataFile);
+         APX_LOG_INFO("[APX_NODE_MANAGER]%s Server created file %s[%d,%d]", debugInfoStr, fileName, inDataFile->fileInfo.address, inDataFile->fileInfo.length);
+      }
+      return 0;
    }
+   return -1;
 }
 
 /**
@@ -624,10 +616,11 @@ static void apx_nodeManager_setLocalNodeData(apx_nodeManager_t *self, apx_nodeDa
 }
 
 /**
- * applies the portTriggerFunction
+ * applies the portTriggerFunction, returns the number of write commands sent to other connections
  */
-static void apx_nodeManager_executePortTriggerFunction(const apx_dataTriggerFunction_t *triggerFunction, const apx_file_t *file)
+static uint32_t apx_nodeManager_executePortTriggerFunction(const apx_dataTriggerFunction_t *triggerFunction, const apx_file_t *file)
 {
+   uint32_t numTriggers = 0u;
    if( (triggerFunction != 0) && (file != 0) )
    {
       if (file->fileType == APX_OUTDATA_FILE)
@@ -647,9 +640,10 @@ static void apx_nodeManager_executePortTriggerFunction(const apx_dataTriggerFunc
                   if( targetNodeInfo->nodeData != 0)
                   {
                      apx_nodeData_t *targetNodeData = targetNodeInfo->nodeData;
-                     if( (targetNodeData->inPortDataFile != 0) && (targetNodeData->fileManager != 0) )
+                     if( (targetNodeData->inPortDataFile != 0) && (targetNodeData->fileManager != 0) && (apx_fileManager_isDead(targetNodeData->fileManager) == false) )
                      {
                         apx_fileManager_triggerFileWriteCmdEvent(targetNodeData->fileManager, targetNodeData->inPortDataFile, dataBuf, writeInfo->destOffset, triggerFunction->dataLength);
+                        numTriggers++;
                      }
                   }
                }
@@ -658,6 +652,7 @@ static void apx_nodeManager_executePortTriggerFunction(const apx_dataTriggerFunc
          }
       }
    }
+   return numTriggers;
 }
 
 static void apx_nodeManager_attachLocalNodeToFileManager(apx_nodeData_t *nodeData, apx_fileManager_t *fileManager)
@@ -697,34 +692,90 @@ static void apx_nodeManager_removeNodeInfo(apx_nodeManager_t *self, apx_nodeInfo
    }
 }
 
-static bool apx_nodeManager_createInitData(apx_node_t *node, uint8_t *buf, int32_t bufLen)
+/**
+ * implementation of apx_nodeManager_detachFileManagers, must be called while holding self->lock.
+ * Only the nodes owned by the detached fileManagers are visited.
+ */
+static void apx_nodeManager_detachFileManagersLocked(apx_nodeManager_t *self, struct apx_fileManager_tag **fileManagers, int32_t numFileManagers)
 {
-   if ( (node != 0) && (buf != 0) && (bufLen > 0))
+   int32_t i;
+   int32_t numDetaching;
+   int32_t numNodeInfos;
+   adt_ary_t detaching; //list of apx_fileManager_t in this batch that are still attached to this nodeManager
+   adt_ary_t nodeInfos; //list of apx_nodeInfo_t owned by the detached file managers
+
+   adt_ary_create(&detaching, NULL);
+   for (i=0; i<numFileManagers; i++)
    {
-      uint8_t *pNext = buf;
-      uint8_t *pEnd = buf+bufLen;
-      int32_t i;
-      int32_t numRequirePorts;
-      adt_bytearray_t *portData;
-      portData = adt_bytearray_new(0);
-      numRequirePorts = apx_node_getNumRequirePorts(node);
-      for(i=0; i<numRequirePorts; i++)
+      apx_fileManager_t *fileManager = fileManagers[i];
+      if ( (fileManager != 0) && (fileManager->nodeManager == self) )
+      {
+         if (fileManager->debugInfo != 0)
+         {
+            APX_LOG_INFO("[APX_NODE_MANAGER] (%p) Detaching file manager", fileManager->debugInfo);
+         }
+         else
+         {
+            APX_LOG_INFO("[APX_NODE_MANAGER] %s", "Detaching file manager");
+         }
+         adt_list_remove(&self->fileManagerList, fileManager);
+         fileManager->nodeManager = (apx_nodeManager_t*) 0;
+         adt_ary_push(&detaching, fileManager);
+      }
+   }
+   numDetaching = adt_ary_length(&detaching);
+   if (numDetaching == 0)
+   {
+      adt_ary_destroy(&detaching);
+      return;
+   }
+   adt_ary_create(&nodeInfos, NULL);
+   for (i=0; i<numDetaching; i++)
+   {
+      apx_fileManager_t *fileManager = (apx_fileManager_t*) adt_ary_value(&detaching, i);
+      apx_nodeData_t *nodeData;
+      for (nodeData = fileManager->ownedNodeData; nodeData != 0; nodeData = nodeData->ownerNext)
+      {
+         if (nodeData->nodeInfo != 0)
+         {
+            adt_ary_push(&nodeInfos, nodeData->nodeInfo);
+         }
+      }
+   }
+   numNodeInfos = adt_ary_length(&nodeInfos);
+   if ( (self->router != 0) && (numNodeInfos > 0) )
+   {
+      //reroute once for the entire batch
+      apx_router_detachNodeInfos(self->router, (apx_nodeInfo_t**) adt_ary_get(&nodeInfos, 0), numNodeInfos);
+   }
+   for (i=0; i<numDetaching; i++)
+   {
+      apx_fileManager_t *fileManager = (apx_fileManager_t*) adt_ary_value(&detaching, i);
+      apx_nodeData_t *nodeData = fileManager->ownedNodeData;
+      fileManager->ownedNodeData = (apx_nodeData_t*) 0;
+      while (nodeData != 0)
       {
-         int32_t packLen;
-         int32_t dataLen;
-         apx_port_t *port = apx_node_getRequirePort(node, i);
-         assert(port != 0);
-         packLen = apx_port_getPackLen(port);
-         apx_node_fillPortInitData(node, port, portData);
-         dataLen = adt_bytearray_length(portData);
-         assert(packLen == dataLen);
-         memcpy(pNext, adt_bytearray_data(portData), packLen);
-         pNext+=packLen;
-         assert(pNext<=pEnd);
+         apx_nodeData_t *next = nodeData->ownerNext;
+         apx_nodeInfo_t *nodeInfo = nodeData->nodeInfo;
+         apx_nodeManager_removeRemoteNodeData(self, nodeData);
+         apx_nodeData_delete(nodeData);
+         if (nodeInfo != 0)
+         {
+            apx_nodeManager_removeNodeInfo(self, nodeInfo);
+            apx_nodeInfo_delete(nodeInfo);
+         }
+         nodeData = next;
       }
-      assert(pNext==pEnd);
-      adt_bytearray_delete(portData);
-      return true;
    }
-   return false;
+   adt_ary_destroy(&nodeInfos);
+   adt_ary_destroy(&detaching);
+}
+
+/**
+ * links nodeData into the list of nodes owned by fileManager, must be called while holding the nodeManager lock
+ */
+static void apx_nodeManager_addOwnedNodeData(apx_fileManager_t *fileManager, apx_nodeData_t *nodeData)
+{
+   nodeData->ownerNext = fileManager->ownedNodeData;
+   fileManager->ownedNodeData = nodeData;
 }
@@ -0,0 +1,799 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <errno.h>
+#include <malloc.h>
+#include <string.h>
+#include <assert.h>
+#include "apx_packProgram.h"
+#include "apx_error.h"
+#include "pack.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * cursor into a dtl_av_t (or into the single top-level value when av is NULL)
+ */
+typedef struct apx_packFrame_tag
+{
+   const dtl_av_t *av;
+   const dtl_dv_t *single;
+   int32_t index;
+   int32_t length;
+}apx_packFrame_t;
+
+typedef struct apx_unpackFrame_tag
+{
+   dtl_av_t *av;
+   dtl_dv_t **root;
+   int32_t index;
+   int32_t length;
+}apx_unpackFrame_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static int32_t apx_packProgram_countInstructions(const apx_dataElement_t *dataElement);
+static int8_t apx_packProgram_emit(apx_packProgram_t *self, const apx_dataElement_t *dataElement, uint32_t *offset, uint16_t depth);
+static apx_packInstruction_t *apx_packProgram_append(apx_packProgram_t *self, uint8_t opcode, uint8_t width, uint32_t count, uint32_t offset);
+static void apx_packProgram_mergeRuns(apx_packProgram_t *self);
+static uint8_t apx_packProgram_getWidth(int8_t baseType);
+static const dtl_dv_t *apx_packFrame_next(apx_packFrame_t *frame);
+static void apx_packInteger(uint8_t *p, const apx_packInstruction_t *instr, const dtl_sv_t *sv);
+static uint8_t *apx_packProgram_packInteger(const apx_packInstruction_t *instr, uint8_t *pNext, uint8_t *pEnd, const dtl_dv_t *dv);
+static uint8_t *apx_packProgram_packString(const apx_packInstruction_t *instr, uint8_t *pNext, uint8_t *pEnd, const dtl_dv_t *dv);
+static dtl_dv_t *apx_unpackFrame_take(apx_unpackFrame_t *frame, dtl_dv_type_id dvType, int32_t avLen, uint8_t create);
+static void apx_unpackInteger(const uint8_t *p, const apx_packInstruction_t *instr, dtl_sv_t *sv);
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void apx_packProgram_create(apx_packProgram_t *self)
+{
+   if (self != 0)
+   {
+      self->instructions = (apx_packInstruction_t*) 0;
+      self->numInstructions = 0;
+      self->maxDepth = 0;
+      self->packLen = 0;
+   }
+}
+
+void apx_packProgram_destroy(apx_packProgram_t *self)
+{
+   apx_packProgram_clear(self);
+}
+
+apx_packProgram_t *apx_packProgram_new(void)
+{
+   apx_packProgram_t *self = (apx_packProgram_t*) malloc(sizeof(apx_packProgram_t));
+   if(self != 0)
+   {
+      apx_packProgram_create(self);
+   }
+   else
+   {
+      errno = ENOMEM;
+   }
+   return self;
+}
+
+void apx_packProgram_delete(apx_packProgram_t *self)
+{
+   if (self != 0)
+   {
+      apx_packProgram_destroy(self);
+      free(self);
+   }
+}
+
+void apx_packProgram_clear(apx_packProgram_t *self)
+{
+   if (self != 0)
+   {
+      if (self->instructions != 0)
+      {
+         free(self->instructions);
+      }
+      apx_packProgram_create(self);
+   }
+}
+
+/**
+ * compiles the dataElement tree into a flat list of instructions.
+ * returns 0 on success, -1 on failure (also sets apx error)
+ */
+int8_t apx_packProgram_compile(apx_packProgram_t *self, const apx_dataElement_t *dataElement)
+{
+   if ( (self != 0) && (dataElement != 0) )
+   {
+      int32_t numInstructions;
+      uint32_t offset = 0;
+      apx_packProgram_clear(self);
+      numInstructions = apx_packProgram_countInstructions(dataElement);
+      if (numInstructions <= 0)
+      {
+         apx_setError(APX_ELEMENT_TYPE_ERROR);
+         return -1;
+      }
+      if (numInstructions > UINT16_MAX)
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return -1;
+      }
+      self->instructions = (apx_packInstruction_t*) malloc(sizeof(apx_packInstruction_t) * numInstructions);
+      if (self->instructions == 0)
+      {
+         apx_setError(APX_MEM_ERROR);
+         return -1;
+      }
+      self->maxDepth = 1;
+      if (apx_packProgram_emit(self, dataElement, &offset, 1) != 0)
+      {
+         apx_packProgram_clear(self);
+         return -1;
+      }
+      assert(self->numInstructions == numInstructions);
+      self->packLen = offset;
+      apx_packProgram_mergeRuns(self);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * packs dv into the buffer. Returns pointer to the byte after the last byte written or NULL on error (also sets apx error).
+ */
+uint8_t *apx_packProgram_pack_dv(const apx_packProgram_t *self, uint8_t *pBegin, uint8_t *pEnd, const dtl_dv_t *dv)
+{
+   if ( (self != 0) && (pBegin != 0) && (pEnd != 0) && (pBegin <= pEnd) && (dv != 0) )
+   {
+      apx_packFrame_t stack[APX_PACK_PROGRAM_MAX_DEPTH];
+      apx_packFrame_t *frame = &stack[0];
+      uint8_t *pNext = pBegin;
+      uint16_t pc = 0;
+      if (self->numInstructions == 0)
+      {
+         apx_setError(APX_ELEMENT_TYPE_ERROR);
+         return 0;
+      }
+      frame->av = (const dtl_av_t*) 0;
+      frame->single = dv;
+      frame->index = 0;
+      frame->length = 1;
+      while (pc < self->numInstructions)
+      {
+         const apx_packInstruction_t *instr = &self->instructions[pc];
+         const dtl_dv_t *childDv;
+         uint32_t i;
+         switch(instr->opcode)
+         {
+         case APX_PACK_OP_UINT:
+         case APX_PACK_OP_SINT:
+            for (i = 0; i < instr->repeat; i++)
+            {
+               pNext = apx_packProgram_packInteger(instr, pNext, pEnd, apx_packFrame_next(frame));
+               if (pNext == 0)
+               {
+                  return 0;
+               }
+            }
+            break;
+         case APX_PACK_OP_STRING:
+            pNext = apx_packProgram_packString(instr, pNext, pEnd, apx_packFrame_next(frame));
+            if (pNext == 0)
+            {
+               return 0;
+            }
+            break;
+         case APX_PACK_OP_RECORD_BEGIN:
+         case APX_PACK_OP_ARRAY_BEGIN:
+            childDv = apx_packFrame_next(frame);
+            if ( (childDv == 0) || (dtl_dv_type(childDv) != DTL_DV_ARRAY) )
+            {
+               apx_setError(APX_DV_TYPE_ERROR);
+               return 0;
+            }
+            frame++;
+            frame->av = (const dtl_av_t*) childDv;
+            frame->single = (const dtl_dv_t*) 0;
+            frame->index = 0;
+            frame->length = dtl_av_length(frame->av);
+            if (frame->length != (int32_t) instr->count)
+            {
+               apx_setError(APX_LENGTH_ERROR);
+               return 0;
+            }
+            break;
+         case APX_PACK_OP_RECORD_END:
+            frame--;
+            break;
+         case APX_PACK_OP_ARRAY_END:
+            if (frame->index < frame->length)
+            {
+               pc = instr->jump;
+               continue;
+            }
+            frame--;
+            break;
+         default:
+            apx_setError(APX_ELEMENT_TYPE_ERROR);
+            return 0;
+         }
+         pc++;
+      }
+      return pNext;
+   }
+   errno = EINVAL;
+   return 0;
+}
+
+/**
+ * unpacks data from buffer into a dtl value.
+ * When *dv is NULL a new dtl value is created and stored in *dv.
+ * When *dv is not NULL it must have been created by an earlier call using the same program. Its values are then updated in-place
+ * without any memory allocation.
+ * Returns pointer to the byte after the last byte read or NULL on error (also sets apx error).
+ */
+const uint8_t *apx_packProgram_unpack_dv(const apx_packProgram_t *self, const uint8_t *pBegin, const uint8_t *pEnd, dtl_dv_t **dv)
+{
+   if ( (self != 0) && (pBegin != 0) && (pEnd != 0) && (pBegin <= pEnd) && (dv != 0) )
+   {
+      apx_unpackFrame_t stack[APX_PACK_PROGRAM_MAX_DEPTH];
+      apx_unpackFrame_t *frame = &stack[0];
+      const uint8_t *pNext = pBegin;
+      uint8_t create = (*dv == 0)? 1 : 0;
+      uint16_t pc = 0;
+      if (self->numInstructions == 0)
+      {
+         apx_setError(APX_ELEMENT_TYPE_ERROR);
+         return 0;
+      }
+      if (pBegin + self->packLen > pEnd)
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return 0;
+      }
+      frame->av = (dtl_av_t*) 0;
+      frame->root = dv;
+      frame->index = 0;
+      frame->length = 1;
+      while (pc < self->numInstructions)
+      {
+         const apx_packInstruction_t *instr = &self->instructions[pc];
+         dtl_dv_t *childDv;
+         uint32_t i;
+         uint32_t j;
+         switch(instr->opcode)
+         {
+         case APX_PACK_OP_UINT:
+         case APX_PACK_OP_SINT:
+            for (i = 0; i < instr->repeat; i++)
+            {
+               if (instr->count == 0)
+               {
+                  childDv = apx_unpackFrame_take(frame, DTL_DV_SCALAR, 0, create);
+                  if (childDv == 0)
+                  {
+                     goto unpack_error;
+                  }
+                  apx_unpackInteger(pNext, instr, (dtl_sv_t*) childDv);
+                  pNext += instr->width;
+               }
+               else
+               {
+                  dtl_av_t *av = (dtl_av_t*) apx_unpackFrame_take(frame, DTL_DV_ARRAY, (int32_t) instr->count, create);
+                  if (av == 0)
+                  {
+                     goto unpack_error;
+                  }
+                  for (j = 0; j < instr->count; j++)
+                  {
+                     dtl_sv_t *sv;
+                     if (create)
+                     {
+                        sv = dtl_sv_new();
+                        dtl_av_push(av, (dtl_dv_t*) sv);
+                     }
+                     else
+                     {
+                        sv = (dtl_sv_t*) *dtl_av_get(av, (int32_t) j);
+                        if (dtl_dv_type((dtl_dv_t*) sv) != DTL_DV_SCALAR)
+                        {
+                           apx_setError(APX_DV_TYPE_ERROR);
+                           goto unpack_error;
+                        }
+                     }
+                     apx_unpackInteger(pNext, instr, sv);
+                     pNext += instr->width;
+                  }
+               }
+            }
+            break;
+         case APX_PACK_OP_STRING:
+            childDv = apx_unpackFrame_take(frame, DTL_DV_SCALAR, 0, create);
+            if (childDv == 0)
+            {
+               goto unpack_error;
+            }
+            else
+            {
+               const uint8_t *pStrEnd = (const uint8_t*) memchr(pNext, 0, instr->count);
+               if (pStrEnd == 0)
+               {
+                  pStrEnd = pNext + instr->count;
+               }
+               dtl_sv_set_bstr((dtl_sv_t*) childDv, (const char*) pNext, (const char*) pStrEnd);
+               pNext += instr->count;
+            }
+            break;
+         case APX_PACK_OP_RECORD_BEGIN:
+         case APX_PACK_OP_ARRAY_BEGIN:
+            childDv = apx_unpackFrame_take(frame, DTL_DV_ARRAY, (int32_t) instr->count, create);
+            if (childDv == 0)
+            {
+               goto unpack_error;
+            }
+            frame++;
+            frame->av = (dtl_av_t*) childDv;
+            frame->root = (dtl_dv_t**) 0;
+            frame->index = 0;
+            frame->length = (int32_t) instr->count;
+            break;
+         case APX_PACK_OP_RECORD_END:
+            frame--;
+            break;
+         case APX_PACK_OP_ARRAY_END:
+            if (frame->index < frame->length)
+            {
+               pc = instr->jump;
+               continue;
+            }
+            frame--;
+            break;
+         default:
+            apx_setError(APX_ELEMENT_TYPE_ERROR);
+            goto unpack_error;
+         }
+         pc++;
+      }
+      return pNext;
+unpack_error:
+      if ( (create) && (*dv != 0) )
+      {
+         dtl_dv_delete(*dv);
+         *dv = (dtl_dv_t*) 0;
+      }
+      return 0;
+   }
+   errno = EINVAL;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static int32_t apx_packProgram_countInstructions(const apx_dataElement_t *dataElement)
+{
+   int32_t result;
+   if (dataElement->baseType == APX_BASE_TYPE_NONE)
+   {
+      return -1;
+   }
+   else if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+   {
+      int32_t i;
+      int32_t numChild = apx_dataElement_getNumChild((apx_dataElement_t*) dataElement);
+      result = (dataElement->arrayLen > 0)? 4 : 2;
+      for (i = 0; i < numChild; i++)
+      {
+         int32_t childResult = apx_packProgram_countInstructions(apx_dataElement_getChildAt((apx_dataElement_t*) dataElement, i));
+         if (childResult < 0)
+         {
+            return -1;
+         }
+         result += childResult;
+      }
+   }
+   else
+   {
+      result = 1;
+   }
+   return result;
+}
+
+static int8_t apx_packProgram_emit(apx_packProgram_t *self, const apx_dataElement_t *dataElement, uint32_t *offset, uint16_t depth)
+{
+   if (depth > self->maxDepth)
+   {
+      self->maxDepth = depth;
+   }
+   if (dataElement->baseType == APX_BASE_TYPE_RECORD)
+   {
+      int32_t i;
+      int32_t numChild = apx_dataElement_getNumChild((apx_dataElement_t*) dataElement);
+      uint16_t recordBegin;
+      uint16_t recordDepth = depth + 1;
+      if (numChild < 0)
+      {
+         numChild = 0;
+      }
+      if (dataElement->arrayLen > 0)
+      {
+         apx_packProgram_append(self, APX_PACK_OP_ARRAY_BEGIN, 0, dataElement->arrayLen, *offset);
+         recordDepth++;
+      }
+      if (recordDepth > APX_PACK_PROGRAM_MAX_DEPTH)
+      {
+         apx_setError(APX_UNSUPPORTED_ERROR);
+         return -1;
+      }
+      if (recordDepth > self->maxDepth)
+      {
+         self->maxDepth = recordDepth;
+      }
+      recordBegin = self->numInstructions;
+      apx_packProgram_append(self, APX_PACK_OP_RECORD_BEGIN, 0, (uint32_t) numChild, *offset);
+      for (i = 0; i < numChild; i++)
+      {
+         if (apx_packProgram_emit(self, apx_dataElement_getChildAt((apx_dataElement_t*) dataElement, i), offset, recordDepth) != 0)
+         {
+            return -1;
+         }
+      }
+      apx_packProgram_append(self, APX_PACK_OP_RECORD_END, 0, 0, *offset);
+      if (dataElement->arrayLen > 0)
+      {
+         apx_packInstruction_t *instr;
+         uint32_t recordLen = *offset - self->instructions[recordBegin].offset;
+         *offset += recordLen * (dataElement->arrayLen - 1);
+         instr = apx_packProgram_append(self, APX_PACK_OP_ARRAY_END, 0, dataElement->arrayLen, *offset);
+         instr->jump = recordBegin;
+      }
+   }
+   else if (dataElement->baseType == APX_BASE_TYPE_STRING)
+   {
+      apx_packProgram_append(self, APX_PACK_OP_STRING, 1, dataElement->arrayLen, *offset);
+      *offset += dataElement->arrayLen;
+   }
+   else
+   {
+      uint8_t width = apx_packProgram_getWidth(dataElement->baseType);
+      uint8_t opcode = (dataElement->baseType >= APX_BASE_TYPE_SINT8)? APX_PACK_OP_SINT : APX_PACK_OP_UINT;
+      if (width == 0)
+      {
+         apx_setError(APX_ELEMENT_TYPE_ERROR);
+         return -1;
+      }
+#if  !(defined(__GNUC__) && defined(__LP64__))
+      if (width == 8)
+      {
+         apx_setError(APX_UNSUPPORTED_ERROR);
+         return -1;
+      }
+#endif
+      apx_packProgram_append(self, opcode, width, dataElement->arrayLen, *offset);
+      *offset += width * ( (dataElement->arrayLen > 0)? dataElement->arrayLen : 1);
+   }
+   return 0;
+}
+
+static apx_packInstruction_t *apx_packProgram_append(apx_packProgram_t *self, uint8_t opcode, uint8_t width, uint32_t count, uint32_t offset)
+{
+   apx_packInstruction_t *instr = &self->instructions[self->numInstructions++];
+   instr->opcode = opcode;
+   instr->width = width;
+   instr->jump = 0;
+   instr->count = count;
+   instr->repeat = 1;
+   instr->offset = offset;
+   return instr;
+}
+
+/**
+ * merges runs of identical integer instructions (same signedness, width and array length) into a single instruction
+ */
+static void apx_packProgram_mergeRuns(apx_packProgram_t *self)
+{
+   uint16_t readIndex;
+   uint16_t writeIndex = 0;
+   uint16_t *newIndex;
+   if (self->numInstructions < 2)
+   {
+      return;
+   }
+   newIndex = (uint16_t*) malloc(sizeof(uint16_t) * self->numInstructions);
+   if (newIndex == 0)
+   {
+      return; //program is still valid, just not merged
+   }
+   for (readIndex = 0; readIndex < self->numInstructions; readIndex++)
+   {
+      apx_packInstruction_t *instr = &self->instructions[readIndex];
+      if (writeIndex > 0)
+      {
+         apx_packInstruction_t *prev = &self->instructions[writeIndex-1];
+         if ( ( (instr->opcode == APX_PACK_OP_UINT) || (instr->opcode == APX_PACK_OP_SINT) ) &&
+              (prev->opcode == instr->opcode) && (prev->width == instr->width) && (prev->count == instr->count) )
+         {
+            prev->repeat++;
+            newIndex[readIndex] = writeIndex-1;
+            continue;
+         }
+      }
+      newIndex[readIndex] = writeIndex;
+      if (writeIndex != readIndex)
+      {
+         self->instructions[writeIndex] = *instr;
+      }
+      writeIndex++;
+   }
+   self->numInstructions = writeIndex;
+   for (readIndex = 0; readIndex < self->numInstructions; readIndex++)
+   {
+      apx_packInstruction_t *instr = &self->instructions[readIndex];
+      if (instr->opcode == APX_PACK_OP_ARRAY_END)
+      {
+         instr->jump = newIndex[instr->jump];
+      }
+   }
+   free(newIndex);
+}
+
+static uint8_t apx_packProgram_getWidth(int8_t baseType)
+{
+   switch(baseType)
+   {
+   case APX_BASE_TYPE_UINT8:
+   case APX_BASE_TYPE_SINT8:
+      return 1;
+   case APX_BASE_TYPE_UINT16:
+   case APX_BASE_TYPE_SINT16:
+      return 2;
+   case APX_BASE_TYPE_UINT32:
+   case APX_BASE_TYPE_SINT32:
+      return 4;
+   case APX_BASE_TYPE_UINT64:
+   case APX_BASE_TYPE_SINT64:
+      return 8;
+   default:
+      break;
+   }
+   return 0;
+}
+
+static const dtl_dv_t *apx_packFrame_next(apx_packFrame_t *frame)
+{
+   if (frame->index >= frame->length)
+   {
+      return (const dtl_dv_t*) 0;
+   }
+   if (frame->av != 0)
+   {
+      return *dtl_av_get(frame->av, frame->index++);
+   }
+   frame->index++;
+   return frame->single;
+}
+
+static void apx_packInteger(uint8_t *p, const apx_packInstruction_t *instr, const dtl_sv_t *sv)
+{
+#if  defined(__GNUC__) && defined(__LP64__)
+   if (instr->width == 8)
+   {
+      uint64_t value = (instr->opcode == APX_PACK_OP_SINT)? (uint64_t) dtl_sv_get_i64(sv) : dtl_sv_get_u64(sv);
+      packLE(p, value, 8);
+      return;
+   }
+#endif
+   {
+      uint32_t value = (instr->opcode == APX_PACK_OP_SINT)? (uint32_t) dtl_sv_get_i32(sv) : dtl_sv_get_u32(sv);
+      switch(instr->width)
+      {
+      case 1:
+         p[0] = (uint8_t) value;
+         break;
+      case 2:
+         p[0] = (uint8_t) value;
+         p[1] = (uint8_t) (value >> 8);
+         break;
+      case 4:
+         p[0] = (uint8_t) value;
+         p[1] = (uint8_t) (value >> 8);
+         p[2] = (uint8_t) (value >> 16);
+         p[3] = (uint8_t) (value >> 24);
+         break;
+      default:
+         break;
+      }
+   }
+}
+
+static uint8_t *apx_packProgram_packInteger(const apx_packInstruction_t *instr, uint8_t *pNext, uint8_t *pEnd, const dtl_dv_t *dv)
+{
+   if (dv == 0)
+   {
+      apx_setError(APX_LENGTH_ERROR);
+      return 0;
+   }
+   if (instr->count == 0)
+   {
+      if (dtl_dv_type(dv) != DTL_DV_SCALAR)
+      {
+         apx_setError(APX_DV_TYPE_ERROR);
+         return 0;
+      }
+      if (pNext + instr->width > pEnd)
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return 0;
+      }
+      apx_packInteger(pNext, instr, (const dtl_sv_t*) dv);
+      pNext += instr->width;
+   }
+   else
+   {
+      const dtl_av_t *av = (const dtl_av_t*) dv;
+      int32_t i;
+      if (dtl_dv_type(dv) != DTL_DV_ARRAY)
+      {
+         apx_setError(APX_DV_TYPE_ERROR);
+         return 0;
+      }
+      if ( (dtl_av_length(av) != (int32_t) instr->count) || (pNext + instr->width * instr->count > pEnd) )
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return 0;
+      }
+      for (i = 0; i < (int32_t) instr->count; i++)
+      {
+         const dtl_dv_t *childDv = *dtl_av_get(av, i);
+         if (dtl_dv_type(childDv) != DTL_DV_SCALAR)
+         {
+            apx_setError(APX_DV_TYPE_ERROR);
+            return 0;
+         }
+         apx_packInteger(pNext, instr, (const dtl_sv_t*) childDv);
+         pNext += instr->width;
+      }
+   }
+   return pNext;
+}
+
+static uint8_t *apx_packProgram_packString(const apx_packInstruction_t *instr, uint8_t *pNext, uint8_t *pEnd, const dtl_dv_t *dv)
+{
+   const char *cstr;
+   size_t len;
+   if ( (dv == 0) || (dtl_dv_type(dv) != DTL_DV_SCALAR) )
+   {
+      apx_setError(APX_DV_TYPE_ERROR);
+      return 0;
+   }
+   cstr = dtl_sv_get_cstr((dtl_sv_t*) dv);
+   if (cstr == 0)
+   {
+      apx_setError(APX_DV_TYPE_ERROR);
+      return 0;
+   }
+   len = strlen(cstr);
+   if ( (len > instr->count) || (pNext + instr->count > pEnd) )
+   {
+      apx_setError(APX_LENGTH_ERROR);
+      return 0;
+   }
+   memcpy(pNext, cstr, len);
+   memset(pNext + len, 0, instr->count - len);
+   return pNext + instr->count;
+}
+
+/**
+ * returns the next value from the frame. In create mode a new value is created and attached to the frame.
+ * In update mode the existing value is returned after its type has been verified.
+ */
+static dtl_dv_t *apx_unpackFrame_take(apx_unpackFrame_t *frame, dtl_dv_type_id dvType, int32_t avLen, uint8_t create)
+{
+   dtl_dv_t *dv;
+   if (frame->index >= frame->length)
+   {
+      apx_setError(APX_LENGTH_ERROR);
+      return (dtl_dv_t*) 0;
+   }
+   if (create)
+   {
+      dv = (dvType == DTL_DV_ARRAY)? (dtl_dv_t*) dtl_av_new() : (dtl_dv_t*) dtl_sv_new();
+      if (dv == 0)
+      {
+         apx_setError(APX_MEM_ERROR);
+         return (dtl_dv_t*) 0;
+      }
+      if (frame->av != 0)
+      {
+         dtl_av_push(frame->av, dv);
+      }
+      else
+      {
+         *frame->root = dv;
+      }
+   }
+   else
+   {
+      dv = (frame->av != 0)? *dtl_av_get(frame->av, frame->index) : *frame->root;
+      if ( (dv == 0) || (dtl_dv_type(dv) != dvType) )
+      {
+         apx_setError(APX_DV_TYPE_ERROR);
+         return (dtl_dv_t*) 0;
+      }
+      if ( (dvType == DTL_DV_ARRAY) && (dtl_av_length((dtl_av_t*) dv) != avLen) )
+      {
+         apx_setError(APX_LENGTH_ERROR);
+         return (dtl_dv_t*) 0;
+      }
+   }
+   frame->index++;
+   return dv;
+}
+
+static void apx_unpackInteger(const uint8_t *p, const apx_packInstruction_t *instr, dtl_sv_t *sv)
+{
+   switch(instr->width)
+   {
+   case 1:
+      if (instr->opcode == APX_PACK_OP_SINT)
+      {
+         dtl_sv_set_i32(sv, (int8_t) p[0]);
+      }
+      else
+      {
+         dtl_sv_set_u32(sv, p[0]);
+      }
+      break;
+   case 2:
+      if (instr->opcode == APX_PACK_OP_SINT)
+      {
+         dtl_sv_set_i32(sv, (int16_t) ( ((uint16_t) p[0]) | (((uint16_t) p[1]) << 8) ));
+      }
+      else
+      {
+         dtl_sv_set_u32(sv, ((uint32_t) p[0]) | (((uint32_t) p[1]) << 8));
+      }
+      break;
+   case 4:
+      {
+         uint32_t value = ((uint32_t) p[0]) | (((uint32_t) p[1]) << 8) | (((uint32_t) p[2]) << 16) | (((uint32_t) p[3]) << 24);
+         if (instr->opcode == APX_PACK_OP_SINT)
+         {
+            dtl_sv_set_i32(sv, (int32_t) value);
+         }
+         else
+         {
+            dtl_sv_set_u32(sv, value);
+         }
+      }
+      break;
+#if  defined(__GNUC__) && defined(__LP64__)
+   case 8:
+      if (instr->opcode == APX_PACK_OP_SINT)
+      {
+         dtl_sv_set_i64(sv, (int64_t) unpackLE(p, 8));
+      }
+      else
+      {
+         dtl_sv_set_u64(sv, (uint64_t) unpackLE(p, 8));
+      }
+      break;
+#endif
+   default:
+      break;
+   }
+}
@@ -1,5 +1,7 @@
+#include <errno.h>
 #include <malloc.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "filestream.h"
 #include "apx_parser.h"
@@ -10,13 +12,17 @@
 #include "CMemLeak.h"
 #endif
 
+static void apx_parser_clearNodeReserveLens(apx_parser_t *self);
+
 void apx_parser_create(apx_parser_t *self)
 {
    if (self !=0)
    {
       adt_ary_create(&self->nodeList,apx_node_vdelete);
       self->currentNode=0;
-
+      self->nodeReserveLens=0;
+      self->numNodeReserveLens=0;
+      self->nextNodeReserve=0;
    }
 }
 
@@ -29,7 +35,7 @@ void apx_parser_destroy(apx_parser_t *self)
          apx_node_delete(self->currentNode);
       }
       adt_ary_destroy(&self->nodeList);
-
+      apx_parser_clearNodeReserveLens(self);
    }
 }
 
@@ -69,6 +75,54 @@ void apx_parser_clearNodes(apx_parser_t *self)
    }
 }
 
+/**
+ * scans the APX definition about to be parsed for its N-lines. Each node created by the parser preallocates arena memory
+ * based on the length of its own section of the text (see apx_node_reserve), not the length of the whole definition.
+ * The lengths are used by the next parse only.
+ * returns 0 on success, -1 on failure
+ */
+int8_t apx_parser_setNodeReserveLens(apx_parser_t *self, const uint8_t *definitionBuf, uint32_t definitionLen)
+{
+   if ( (self != 0) && (definitionBuf != 0) )
+   {
+      uint32_t i;
+      int32_t numNodes = 0;
+      apx_parser_clearNodeReserveLens(self);
+      for (i=0; i<definitionLen; i++)
+      {
+         if ( (definitionBuf[i] == 'N') && ( (i == 0) || (definitionBuf[i-1] == '\n') ) )
+         {
+            numNodes++;
+         }
+      }
+      if (numNodes > 0)
+      {
+         int32_t nodeIndex = -1;
+         self->nodeReserveLens = (uint32_t*) malloc(sizeof(uint32_t)*(size_t) numNodes);
+         if (self->nodeReserveLens == 0)
+         {
+            errno = ENOMEM;
+            return -1;
+         }
+         for (i=0; i<definitionLen; i++)
+         {
+            if ( (definitionBuf[i] == 'N') && ( (i == 0) || (definitionBuf[i-1] == '\n') ) )
+            {
+               self->nodeReserveLens[++nodeIndex] = 0;
+            }
+            if (nodeIndex >= 0)
+            {
+               self->nodeReserveLens[nodeIndex]++;
+            }
+         }
+         self->numNodeReserveLens = numNodes;
+      }
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
 #if defined(_WIN32) || defined(__GNUC__)
 /**
  * convenience function for automatically parsing an apx file from the file system
@@ -116,11 +170,15 @@ void apx_parser_open(apx_parser_t *self)
 
 void apx_parser_close(apx_parser_t *self)
 {
-   if ( (self!=0) && (self->currentNode!=0) )
+   if (self != 0)
    {
-      apx_node_finalize(self->currentNode);
-      adt_ary_push(&self->nodeList,self->currentNode);
-      self->currentNode=0;
+      if (self->currentNode!=0)
+      {
+         apx_node_finalize(self->currentNode);
+         adt_ary_push(&self->nodeList,self->currentNode);
+         self->currentNode=0;
+      }
+      apx_parser_clearNodeReserveLens(self);
    }
 }
 
@@ -135,6 +193,10 @@ void apx_parser_node(apx_parser_t *self, const char *name) //N"<name>"
          self->currentNode=0;
       }
       self->currentNode=apx_node_new(name);
+      if ( (self->currentNode != 0) && (self->nextNodeReserve < self->numNodeReserveLens) )
+      {
+         apx_node_reserve(self->currentNode, self->nodeReserveLens[self->nextNodeReserve++]);
+      }
    }
 }
 
@@ -208,4 +270,13 @@ void apx_parser_vnode_end(void *arg)
    apx_parser_node_end((apx_parser_t*) arg);
 }
 
-
+static void apx_parser_clearNodeReserveLens(apx_parser_t *self)
+{
+   if (self->nodeReserveLens != 0)
+   {
+      free(self->nodeReserveLens);
+      self->nodeReserveLens = 0;
+   }
+   self->numNodeReserveLens = 0;
+   self->nextNodeReserve = 0;
+}
@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include "apx_port.h"
+#include "apx_arena.h"
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -36,6 +37,8 @@ void apx_port_create(apx_port_t *self,uint8_t portDirection,const char *name, co
 			self->portType = portDirection;
          self->portSignature = 0;
          self->portIndex = -1;
+         self->portMapHandle = -1;
+         self->arena = (struct apx_arena_tag*) 0;
 			apx_dataSignature_create(&self->derivedDsg,0);
 			if (attributes != 0)
 			{
@@ -49,22 +52,25 @@ void apx_port_create(apx_port_t *self,uint8_t portDirection,const char *name, co
 }
 void apx_port_destroy(apx_port_t *self){
 	if(self != 0){
-		if (self->name != 0)
-		{
-			free(self->name);
-		}
-      if (self->dataSignature != 0)
+      if (self->arena == 0)
       {
-         free(self->dataSignature);
+         if (self->name != 0)
+         {
+            free(self->name);
+         }
+         if (self->dataSignature != 0)
+         {
+            free(self->dataSignature);
+         }
+         if (self->portSignature != 0)
+         {
+            free(self->portSignature);
+         }
       }
 		if (self->portAttributes != 0)
 		{
 			apx_portAttributes_delete(self->portAttributes);
 		}
-      if (self->portSignature != 0)
-      {
-         free(self->portSignature);
-      }
       apx_dataSignature_destroy(&self->derivedDsg);
 	}
 }
@@ -93,6 +99,27 @@ apx_port_t* apx_requirePort_new(const char *name, const char* dataSignature, con
    return self;
 }
 
+/**
+ * creates a port where the port object itself and its name, data signature and port signature strings are allocated
+ * from arena. Such ports must be destroyed with apx_port_destroy (or apx_port_vdestroy), never deleted.
+ */
+apx_port_t* apx_port_newInArena(struct apx_arena_tag *arena, uint8_t portDirection, const char *name, const char* dataSignature, const char *attributes)
+{
+   apx_port_t *self = (apx_port_t*) apx_arena_alloc(arena, (uint32_t) sizeof(apx_port_t));
+   if (self != 0)
+   {
+      apx_port_create(self, portDirection, 0, 0, attributes);
+      self->arena = arena;
+      self->name = (name != 0)? apx_arena_strdup(arena, name) : 0;
+      self->dataSignature = (dataSignature != 0)? apx_arena_strdup(arena, dataSignature) : 0;
+   }
+   else
+   {
+      errno = ENOMEM;
+   }
+   return self;
+}
+
 void apx_port_delete(apx_port_t *self)
 {
    if (self != 0)
@@ -106,6 +133,10 @@ void apx_port_vdelete(void *arg){
 	apx_port_delete((apx_port_t*) arg);
 }
 
+void apx_port_vdestroy(void *arg){
+   apx_port_destroy((apx_port_t*) arg);
+}
+
 void apx_port_setDerivedDataSignature(apx_port_t *self, const char *dataSignature)
 {
    if (self != 0)
@@ -127,11 +158,11 @@ const char *apx_port_derivePortSignature(apx_port_t *self)
       uint32_t dsgLen=0;
       const char *dsgPtr=0;
 
-      if (self->portSignature != 0)
+      if ( (self->portSignature != 0) && (self->arena == 0) )
       {
          free(self->portSignature);
-         self->portSignature = 0;
       }
+      self->portSignature = 0;
 
       if (self->name != 0)
       {
@@ -151,7 +182,7 @@ const char *apx_port_derivePortSignature(apx_port_t *self)
       if ( (namelen > 0) && (dsgLen > 0) && (dsgPtr != 0) )
       {
          uint32_t psgLen=namelen+dsgLen+3; //add 3 to fit null-terminator + 2 '"' characters
-         self->portSignature = (char*) malloc(psgLen);
+         self->portSignature = (self->arena != 0)? (char*) apx_arena_alloc(self->arena, psgLen) : (char*) malloc(psgLen);
          if (self->portSignature != 0)
          {
             char *p = self->portSignature;
@@ -20,7 +20,7 @@
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
-static int32_t apx_portDataMap_buildInternal(adt_ary_t *entryList, adt_ary_t *portList);
+static int32_t apx_portDataMap_buildInternal(apx_portDataMap_t *self, adt_ary_t *portList);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -83,7 +83,8 @@ void apx_portDataMap_create(apx_portDataMap_t *self)
 {
    if (self != 0)
    {
-      adt_ary_create(&self->elements,apx_portDataMapEntry_vdelete);
+      self->entries = (apx_portDataMapEntry_t*) 0;
+      self->numEntries = 0;
       self->node = (apx_node_t*) 0;
       self->mapType = -1;
       self->totalLen = -1;
@@ -94,7 +95,12 @@ void apx_portDataMap_destroy(apx_portDataMap_t *self)
 {
    if (self != 0)
    {
-      adt_ary_destroy(&self->elements);
+      if (self->entries != 0)
+      {
+         free(self->entries);
+         self->entries = (apx_portDataMapEntry_t*) 0;
+      }
+      self->numEntries = 0;
    }
 }
 
@@ -132,18 +138,18 @@ int8_t apx_portDataMap_build(apx_portDataMap_t *self, apx_node_t *node, uint8_t
       if (portType == APX_REQUIRE_PORT)
       {
          self->mapType = APX_REQUIRE_PORT;
-         self->totalLen=apx_portDataMap_buildInternal(&self->elements,&node->requirePortList);
+         self->totalLen=apx_portDataMap_buildInternal(self,&node->requirePortList);
       }
       else if (portType == APX_PROVIDE_PORT)
       {
          self->mapType = APX_PROVIDE_PORT;
-         self->totalLen=apx_portDataMap_buildInternal(&self->elements,&node->providePortList);
+         self->totalLen=apx_portDataMap_buildInternal(self,&node->providePortList);
       }
       else
       {
          return -1;
       }
-      return 0;
+      return (self->totalLen >= 0)? 0 : -1;
    }
    return -1;
 }
@@ -158,14 +164,22 @@ int32_t apx_portDataMap_getDataLen(apx_portDataMap_t *self)
    return -1;
 }
 
+int32_t apx_portDataMap_getNumEntries(const apx_portDataMap_t *self)
+{
+   if (self != 0)
+   {
+      return self->numEntries;
+   }
+   return -1;
+}
+
 apx_portDataMapEntry_t *apx_portDataMap_getEntry(apx_portDataMap_t *self, int32_t portIndex)
 {
    if (self != 0)
    {
-      int32_t numPorts = adt_ary_length(&self->elements);
-      if ( (portIndex>=0) && (portIndex < numPorts) )
+      if ( (portIndex>=0) && (portIndex < self->numEntries) )
       {
-         return (apx_portDataMapEntry_t*) *adt_ary_get(&self->elements,portIndex);
+         return &self->entries[portIndex];
       }
    }
    errno=EINVAL;
@@ -175,32 +189,45 @@ apx_portDataMapEntry_t *apx_portDataMap_getEntry(apx_portDataMap_t *self, int32_
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
-static int32_t apx_portDataMap_buildInternal(adt_ary_t *entryList, adt_ary_t *portList)
+static int32_t apx_portDataMap_buildInternal(apx_portDataMap_t *self, adt_ary_t *portList)
 {
    int32_t retval=-1;
-   if ( (entryList != 0) && (portList != 0) )
+   if ( (self != 0) && (portList != 0) )
    {
       int32_t i;
       int32_t end;
       int32_t offset = 0;
 
-      adt_ary_clear(entryList);
+      if (self->entries != 0)
+      {
+         free(self->entries);
+         self->entries = (apx_portDataMapEntry_t*) 0;
+      }
+      self->numEntries = 0;
       end = adt_ary_length(portList);
+      if (end > 0)
+      {
+         //all entries are stored in one array so that offset lookups during routing walk contiguous memory
+         self->entries = (apx_portDataMapEntry_t*) malloc(sizeof(apx_portDataMapEntry_t)*end);
+         if (self->entries == 0)
+         {
+            errno = ENOMEM;
+            return -1;
+         }
+      }
       for (i=0;i<end;i++)
       {
          void **ptr = adt_ary_get(portList,i);
          if (ptr != 0)
          {
             apx_port_t *port = (apx_port_t*) *ptr;
-            apx_portDataMapEntry_t *entry;
             int32_t packLen;
             assert( port != 0);
             packLen = apx_port_getPackLen(port);
             if (packLen>0)
             {
-               entry = apx_portDataMapEntry_new(port,offset,packLen);
+               apx_portDataMapEntry_create(&self->entries[self->numEntries++],port,offset,packLen);
                offset+=packLen;
-               adt_ary_push(entryList,(void*) entry);
             }
             else
             {
@@ -212,4 +239,3 @@ static int32_t apx_portDataMap_buildInternal(adt_ary_t *entryList, adt_ary_t *po
    }
    return retval;
 }
-
@@ -30,7 +30,7 @@ static void apx_router_attachPortToPortMap(apx_router_t *self, apx_node_t *node,
 static void apx_router_detachPortFromPortMap(apx_router_t *self, apx_node_t *node, apx_port_t *port);
 static bool apx_router_createDefaultPortConnector(const apx_router_t *self, apx_nodeInfo_t *nodeInfo, apx_port_t *port, apx_portref_t *provideConnector);
 static void apx_router_build_requireRefs(apx_nodeInfo_t *nodeInfo, adt_ary_t *requireRefs);
-static void apx_router_postProcessNodes(const apx_router_t *self, apx_nodeInfo_t *detachedNodeInfo);
+static void apx_router_postProcessNodes(const apx_router_t *self, apx_nodeInfo_t **detachedNodeInfos, int32_t numDetached);
 static void apx_router_postProcessNode(apx_nodeInfo_t *extraNodeInfo, int8_t debugMode);
 
 //////////////////////////////////////////////////////////////////////////////
@@ -112,6 +112,7 @@ void apx_router_attachNodeInfo(apx_router_t *self, apx_nodeInfo_t *nodeInfo)
       //This is a new node.
       //2. add this nodeInfo to the nodeInfoList
       adt_ary_push(&self->nodeInfoList,nodeInfo);
+      nodeInfo->isAttached = true;
 
       //3. register all require ports into the portMap
       for (i=0;i<requirePortLen;i++)
@@ -145,7 +146,7 @@ void apx_router_attachNodeInfo(apx_router_t *self, apx_nodeInfo_t *nodeInfo)
          APX_LOG_DEBUG("[APX_ROUTER] done creating default connectors for %s",node->name);
       }
       //6. loop through all nodes and check for flags (flags indicate extra post processing steps are required)
-      apx_router_postProcessNodes(self,0);
+      apx_router_postProcessNodes(self,0,0);
       if (self->debugMode == APX_DEBUG_1_PROFILE)
       {
          APX_LOG_DEBUG("[APX_ROUTER] done post processing %s connect",node->name);
@@ -158,89 +159,132 @@ void apx_router_attachNodeInfo(apx_router_t *self, apx_nodeInfo_t *nodeInfo)
  */
 void apx_router_detachNodeInfo(apx_router_t *self, apx_nodeInfo_t *nodeInfo)
 {
-   if ( (self != 0) && (nodeInfo != 0) )
+   apx_router_detachNodeInfos(self, &nodeInfo, 1);
+}
+
+/**
+ * detaches a batch of nodeInfo structures from the router (typically all nodes of the connections that were lost
+ * at the same time). All ports of the batch are removed from the portMap before any signal is rerouted, this way
+ * a require port is never rerouted to a provider that is about to be detached and nodes within the batch are never rerouted at all.
+ */
+void apx_router_detachNodeInfos(apx_router_t *self, apx_nodeInfo_t **nodeInfos, int32_t numNodeInfos)
+{
+   if ( (self != 0) && (nodeInfos != 0) && (numNodeInfos > 0) )
    {
-      int8_t found=0;
       int32_t i;
-      int32_t requirePortLen;
-      int32_t providePortLen;
+      int32_t j;
       int32_t nodeInfoListLen;
+      int32_t numDetached;
       int32_t numRequireRefs;
+      adt_ary_t detached; //array of apx_nodeInfo_t*, nodes that were actually attached to the router
       adt_ary_t requireRefs; //array of apx_portref_t*
-      apx_node_t *node = nodeInfo->node;
-      char debugInfoStr[APX_DEBUG_INFO_MAX_LEN];
-      assert(node != 0);
 
-      debugInfoStr[0]=0;
-      if ( (nodeInfo->nodeData != 0) && (nodeInfo->nodeData->fileManager->debugInfo != 0) )
+      adt_ary_create(&detached, (void(*)(void*)) 0);
+      for (i=0;i<numNodeInfos;i++)
       {
-         snprintf(debugInfoStr, APX_DEBUG_INFO_MAX_LEN, " (%p)", nodeInfo->nodeData->fileManager->debugInfo);
+         apx_nodeInfo_t *nodeInfo = nodeInfos[i];
+         if ( (nodeInfo != 0) && (nodeInfo->isAttached == true) ) //ignore nodes that weren't attached in the first place
+         {
+            char debugInfoStr[APX_DEBUG_INFO_MAX_LEN];
+            assert(nodeInfo->node != 0);
+            debugInfoStr[0]=0;
+            if ( (nodeInfo->nodeData != 0) && (nodeInfo->nodeData->fileManager != 0) && (nodeInfo->nodeData->fileManager->debugInfo != 0) )
+            {
+               snprintf(debugInfoStr, APX_DEBUG_INFO_MAX_LEN, " (%p)", nodeInfo->nodeData->fileManager->debugInfo);
+            }
+            APX_LOG_DEBUG("[APX_ROUTER]%s Detaching %s", debugInfoStr, nodeInfo->node->name);
+            nodeInfo->isAttached = false;
+            adt_ary_push(&detached, nodeInfo);
+         }
+      }
+      numDetached = adt_ary_length(&detached);
+      if (numDetached == 0)
+      {
+         adt_ary_destroy(&detached);
+         return;
       }
 
-      APX_LOG_DEBUG("[APX_ROUTER]%s Detaching %s", debugInfoStr, node->name);
+      //1. remove the nodes from nodeInfoList in a single pass
       nodeInfoListLen = adt_ary_length(&self->nodeInfoList);
-      requirePortLen = adt_ary_length(&node->requirePortList);
-      providePortLen = adt_ary_length(&node->providePortList);
-      for (i=0;i<nodeInfoListLen;i++)
+      for (i=0,j=0;i<nodeInfoListLen;i++)
       {
          apx_nodeInfo_t *elem = (apx_nodeInfo_t*) adt_ary_value(&self->nodeInfoList,i);
-         if (elem == nodeInfo)
+         if (elem->isAttached == true)
          {
-            found = 1;
-            //found the node, remove it from the list
-            adt_ary_splice(&self->nodeInfoList,i,1);
-            break; //important to break for-loop here since splice modifies the list (invalidating the nodeInfoListLen variable)
+            if (j != i)
+            {
+               adt_ary_set(&self->nodeInfoList,j,elem);
+            }
+            j++;
          }
       }
-
-      if (found == 0)
+      if (j < nodeInfoListLen)
       {
-         return; //user tried to detach a node that wasn't attached in the first place
+         adt_ary_splice(&self->nodeInfoList,j,nodeInfoListLen-j);
       }
 
-      //1. Detach all ports from the portMap
-      for (i=0;i<requirePortLen;i++)
-      {
-         apx_port_t *port = apx_node_getRequirePort(node,i);
-         apx_router_detachPortFromPortMap(self,node,port);
-      }
-      for (i=0;i<providePortLen;i++)
+      //2. Detach all ports from the portMap
+      for (i=0;i<numDetached;i++)
       {
-         apx_port_t *port = apx_node_getProvidePort(node,i);
-         apx_router_detachPortFromPortMap(self,node,port);
+         apx_nodeInfo_t *nodeInfo = (apx_nodeInfo_t*) adt_ary_value(&detached,i);
+         apx_node_t *node = nodeInfo->node;
+         int32_t requirePortLen = adt_ary_length(&node->requirePortList);
+         int32_t providePortLen = adt_ary_length(&node->providePortList);
+         for (j=0;j<requirePortLen;j++)
+         {
+            apx_port_t *port = apx_node_getRequirePort(node,j);
+            apx_router_detachPortFromPortMap(self,node,port);
+         }
+         for (j=0;j<providePortLen;j++)
+         {
+            apx_port_t *port = apx_node_getProvidePort(node,j);
+            apx_router_detachPortFromPortMap(self,node,port);
+         }
       }
 
-      //2. follow all connectors reaching out from this node and determine what other nodes will be affected by this delete
+      //3. follow all connectors reaching out from the detached nodes and determine what other nodes will be affected by this delete
       adt_ary_create(&requireRefs,apx_portref_vdelete);
-
-      apx_router_build_requireRefs(nodeInfo,&requireRefs);
-
-      //3. disconnect require and provide ports
-      for (i=0;i<requirePortLen;i++)
+      for (i=0;i<numDetached;i++)
       {
-         apx_nodeInfo_disconnectRequirePort(nodeInfo,i);
+         apx_router_build_requireRefs((apx_nodeInfo_t*) adt_ary_value(&detached,i),&requireRefs);
       }
-      for (i=0;i<providePortLen;i++)
+
+      //4. disconnect require and provide ports
+      for (i=0;i<numDetached;i++)
       {
-         apx_nodeInfo_disconnectProvidePort(nodeInfo,i);
+         apx_nodeInfo_t *nodeInfo = (apx_nodeInfo_t*) adt_ary_value(&detached,i);
+         int32_t requirePortLen = adt_ary_length(&nodeInfo->node->requirePortList);
+         int32_t providePortLen = adt_ary_length(&nodeInfo->node->providePortList);
+         for (j=0;j<requirePortLen;j++)
+         {
+            apx_nodeInfo_disconnectRequirePort(nodeInfo,j);
+         }
+         for (j=0;j<providePortLen;j++)
+         {
+            apx_nodeInfo_disconnectProvidePort(nodeInfo,j);
+         }
       }
 
-      //4. for the deleted connectors, try to reroute using default rule
+      //5. for the deleted connectors, try to reroute using default rule
       numRequireRefs = adt_ary_length(&requireRefs);
       for (i=0;i<numRequireRefs;i++)
       {
-         apx_nodeInfo_t *requesterNodeInfo; //this is the node that requested the signal this node provided
-         apx_portref_t *requireConnector;
+         apx_nodeInfo_t *requesterNodeInfo; //this is the node that requested the signal a detached node provided
          apx_portref_t *portref = (apx_portref_t*) adt_ary_value(&requireRefs,i);
          requesterNodeInfo = portref->node->nodeInfo;
-         requireConnector = apx_nodeInfo_getRequirePortConnector(requesterNodeInfo, portref->port->portIndex);
-         assert(requireConnector == 0);
-         //This is now an empty connector due to the fact that our detached nodeInfo was the provider of that signal.
-         //Try to reroute the signal from a different source
-         (void)apx_router_createDefaultPortConnector(self,requesterNodeInfo,portref->port,0);
+         if (requesterNodeInfo->isAttached == true) //requesters that are part of this batch are going away as well
+         {
+            apx_portref_t *requireConnector = apx_nodeInfo_getRequirePortConnector(requesterNodeInfo, portref->port->portIndex);
+            assert(requireConnector == 0);
+            (void) requireConnector;
+            //This is now an empty connector due to the fact that a detached nodeInfo was the provider of that signal.
+            //Try to reroute the signal from a different source
+            (void)apx_router_createDefaultPortConnector(self,requesterNodeInfo,portref->port,0);
+         }
       }
       adt_ary_destroy(&requireRefs);
-      apx_router_postProcessNodes(self,nodeInfo);
+      apx_router_postProcessNodes(self, (apx_nodeInfo_t**) adt_ary_get(&detached,0), numDetached);
+      adt_ary_destroy(&detached);
    }
 }
 
@@ -252,6 +296,36 @@ void apx_router_setDebugMode(apx_router_t *self, int8_t debugMode)
    }
 }
 
+/**
+ * counts nodes, ports, connectors and route table entries. The caller must hold the same lock as for attach/detach.
+ */
+void apx_router_getStats(apx_router_t *self, apx_routerStats_t *stats)
+{
+   if ( (self != 0) && (stats != 0) )
+   {
+      int32_t i;
+      int32_t nodeInfoListLen = adt_ary_length(&self->nodeInfoList);
+      memset(stats, 0, sizeof(apx_routerStats_t));
+      stats->numNodes = (uint32_t) nodeInfoListLen;
+      stats->routeTableSize = adt_hash_length(&self->portMap);
+      for (i=0; i<nodeInfoListLen; i++)
+      {
+         int32_t j;
+         apx_nodeInfo_t *nodeInfo = (apx_nodeInfo_t*) adt_ary_value(&self->nodeInfoList, i);
+         int32_t numRequirePorts = apx_nodeInfo_getNumRequirePorts(nodeInfo);
+         stats->numProvidePorts += (uint32_t) apx_nodeInfo_getNumProvidePorts(nodeInfo);
+         stats->numRequirePorts += (uint32_t) numRequirePorts;
+         for (j=0; j<numRequirePorts; j++)
+         {
+            if (apx_nodeInfo_getRequirePortConnector(nodeInfo, j) != 0)
+            {
+               stats->numConnectors++;
+            }
+         }
+      }
+   }
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
@@ -334,14 +408,11 @@ static bool apx_router_createDefaultPortConnector(const apx_router_t *self, apx_
          if (port->portType == APX_REQUIRE_PORT)
          {
             //if port is a require port, try to find a matching provide port.
-            int32_t numProvidePorts;
-            numProvidePorts = adt_ary_length(&portMapEntry->providePorts);
-            if (numProvidePorts > 0)
+            //The default rule is to connect to the last of the available providers (cached as the active provider)
+            apx_portref_t *portref = apx_routerPortMapEntry_getActiveProvider(portMapEntry);
+            if (portref != 0)
             {
-               //OK, there is at least one provider for this signal.
-               //The default rule is to connect to the last of the available providers (index = numProvidePorts-1)
-               apx_portref_t *portref = apx_routerPortMapEntry_getProvidePortById(portMapEntry,numProvidePorts-1);
-               if ( (portref != 0) && (portref->node != 0) && (portref->port != 0) )
+               if ( (portref->node != 0) && (portref->port != 0) )
                {
                   apx_nodeInfo_t *providerNodeInfo = portref->node->nodeInfo;
 
@@ -370,12 +441,11 @@ static bool apx_router_createDefaultPortConnector(const apx_router_t *self, apx_
          else if(port->portType == APX_PROVIDE_PORT)
          {
             //if port is a provide port, try to find all require ports and try to connect them to this new provider port
-            int32_t numRequirePorts;
-            int32_t i;
-            numRequirePorts = adt_ary_length(&portMapEntry->requirePorts);
-            for (i=0;i<numRequirePorts;i++)
+            int32_t handle;
+            for (handle = apx_routerPortMapEntry_firstRequirePort(portMapEntry); handle != APX_PORT_MAP_INVALID_HANDLE;
+                 handle = apx_routerPortMapEntry_nextRequirePort(portMapEntry, handle))
             {
-               apx_portref_t *portref = apx_routerPortMapEntry_getRequirePortById(portMapEntry,i);
+               apx_portref_t *portref = apx_routerPortMapEntry_getRequirePortById(portMapEntry,handle);
                if ( (portref != 0) && (portref->node != 0) && (portref->port != 0) )
                {
                   apx_portref_t *requireConnector;
@@ -446,7 +516,7 @@ static void apx_router_build_requireRefs(apx_nodeInfo_t *nodeInfo, adt_ary_t *re
    }
 }
 
-static void apx_router_postProcessNodes(const apx_router_t *self, apx_nodeInfo_t *detachedNodeInfo)
+static void apx_router_postProcessNodes(const apx_router_t *self, apx_nodeInfo_t **detachedNodeInfos, int32_t numDetached)
 {
    int32_t numNodes;
    int32_t i;
@@ -457,9 +527,9 @@ static void apx_router_postProcessNodes(const apx_router_t *self, apx_nodeInfo_t
       assert(nodeInfo != 0);
       apx_router_postProcessNode(nodeInfo, self->debugMode);
    }
-   if (detachedNodeInfo != 0) //detachedNodeInfo is the nodeInfo that is no longer in self->nodeInfoList
+   for (i=0;i<numDetached;i++) //detachedNodeInfos are no longer in self->nodeInfoList
    {
-      apx_router_postProcessNode(detachedNodeInfo, self->debugMode);
+      apx_router_postProcessNode(detachedNodeInfos[i], self->debugMode);
    }
 }
 
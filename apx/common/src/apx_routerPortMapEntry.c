@@ -15,11 +15,18 @@
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#define PORT_LIST_MIN_CAPACITY 4
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
-
+static void apx_routerPortList_create(apx_routerPortList_t *self);
+static void apx_routerPortList_destroy(apx_routerPortList_t *self);
+static int32_t apx_routerPortList_find(const apx_routerPortList_t *self, const apx_node_t *node, const apx_port_t *port, bool fullSearch);
+static int8_t apx_routerPortList_grow(apx_routerPortList_t *self);
+static int32_t apx_routerPortList_insert(apx_routerPortList_t *self, apx_node_t *node, apx_port_t *port);
+static void apx_routerPortList_remove(apx_routerPortList_t *self, int32_t handle);
+static apx_routerPortList_t *apx_routerPortMapEntry_getList(apx_routerPortMapEntry_t *self, const apx_port_t *port);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -37,8 +44,8 @@ void apx_routerPortMapEntry_create(apx_routerPortMapEntry_t *self)
 {
    if (self != 0)
    {
-      adt_ary_create(&self->requirePorts,apx_portref_vdelete);
-      adt_ary_create(&self->providePorts,apx_portref_vdelete);
+      apx_routerPortList_create(&self->requirePorts);
+      apx_routerPortList_create(&self->providePorts);
    }
 }
 
@@ -46,8 +53,8 @@ void apx_routerPortMapEntry_destroy(apx_routerPortMapEntry_t *self)
 {
    if (self != 0)
    {
-      adt_ary_destroy(&self->requirePorts);
-      adt_ary_destroy(&self->providePorts);
+      apx_routerPortList_destroy(&self->requirePorts);
+      apx_routerPortList_destroy(&self->providePorts);
    }
 }
 
@@ -77,49 +84,33 @@ void apx_routerPortMapEntry_vdelete(void *arg)
    apx_routerPortMapEntry_delete( (apx_routerPortMapEntry_t*) arg );
 }
 
+/**
+ * Adds the port to the require or provide list. The slot index is stored in port->portMapHandle which makes both the
+ * duplicate check and a later removal O(1).
+ */
 int8_t apx_routerPortMapEntry_insertPort(apx_routerPortMapEntry_t *self, apx_node_t *node, apx_port_t *port)
 {
    if ( (self != 0) && (node != 0) && (port != 0) )
    {
-      int32_t i;
-      int32_t end;
-      adt_ary_t *portrefList = 0;
-      apx_portref_t *portref = apx_portref_new(node,port);
-
-      if (portref == 0)
-      {
-         return -1; //apx_portref_new should already have set errno
-      }
-      if (portref->port->portType == APX_REQUIRE_PORT)
-      {
-         portrefList = &self->requirePorts;
-      }
-      else if (portref->port->portType == APX_PROVIDE_PORT)
+      int32_t handle;
+      apx_routerPortList_t *portList = apx_routerPortMapEntry_getList(self, port);
+      if (portList == 0)
       {
-         portrefList = &self->providePorts;
-      }
-      else
-      {
-         apx_portref_delete(portref);
          errno = EINVAL;
          return -1;
       }
       //prevent the user from adding the same port reference twice.
-      assert(portrefList != 0);
-      end = adt_ary_length(portrefList);
-      for (i=0;i<end;i++)
+      handle = apx_routerPortList_find(portList, node, port, false);
+      if (handle != APX_PORT_MAP_INVALID_HANDLE)
       {
-         apx_portref_t *elem = (apx_portref_t*) adt_ary_value(portrefList,i);
-         if (apx_portref_equals(elem,portref) != 0)
-         {
-            //the portref already exists in this list, take no more action
-            apx_portref_delete(portref);
-            return 0;
-         }
+         return 0;
       }
-      //New portref.
-      //Add it to portrefList, destruction of portref will be automatically taken care of when destructor of apx_routerPortMapEntry_t is called.
-      adt_ary_push(portrefList,portref);
+      handle = apx_routerPortList_insert(portList, node, port);
+      if (handle == APX_PORT_MAP_INVALID_HANDLE)
+      {
+         return -1; //apx_routerPortList_insert has set errno
+      }
+      port->portMapHandle = handle;
       return 0;
    }
    errno = EINVAL;
@@ -162,57 +153,70 @@ int8_t apx_routerPortMapEntry_removePort(apx_routerPortMapEntry_t *self, apx_nod
 {
    if ( (self != 0) && (node != 0) && (port != 0) )
    {
-      int32_t i;
-      int32_t end;
-      apx_portref_t portref;
-      adt_ary_t *portrefList = 0;
-      apx_portref_create(&portref,node,port);
-      if (portref.port->portType == APX_REQUIRE_PORT)
-      {
-         portrefList = &self->requirePorts;
-      }
-      else if (portref.port->portType == APX_PROVIDE_PORT)
-      {
-         portrefList = &self->providePorts;
-      }
-      else
+      int32_t handle;
+      apx_routerPortList_t *portList = apx_routerPortMapEntry_getList(self, port);
+      if (portList == 0)
       {
          errno = EINVAL;
          return -1;
       }
-      assert(portrefList != 0);
-      end = adt_ary_length(portrefList);
-      for (i=0;i<end;i++)
+      handle = apx_routerPortList_find(portList, node, port, true);
+      if (handle != APX_PORT_MAP_INVALID_HANDLE)
       {
-         apx_portref_t *elem = (apx_portref_t*) adt_ary_value(portrefList,i);
-         if (apx_portref_equals(elem,&portref) != 0)
-         {
-            //found in list, we can now remove it and shorten the list.
-            //using the adt_ary_splice method will both shorten the list and destroy the object (it calls apx_portref_vdelete)
-            adt_ary_splice(portrefList,i,1);
-            break;
-         }
+         apx_routerPortList_remove(portList, handle);
+         port->portMapHandle = APX_PORT_MAP_INVALID_HANDLE;
       }
-      apx_portref_destroy(&portref); //nothing is actually destroyed here but call is made here to match call to the constructor
       return 0;
    }
    errno=EINVAL;
    return -1;
 }
 
+int32_t apx_routerPortMapEntry_getNumProvidePorts(const apx_routerPortMapEntry_t *self)
+{
+   if (self != 0)
+   {
+      return self->providePorts.length;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+int32_t apx_routerPortMapEntry_getNumRequirePorts(const apx_routerPortMapEntry_t *self)
+{
+   if (self != 0)
+   {
+      return self->requirePorts.length;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
 /**
- * retreives the portref_t from the self->providePorts array.
- * returns NULL on failure
+ * returns the provide port that require ports are connected to by default (the most recently inserted provide port).
+ * returns NULL when there are no providers for this signal
  */
-apx_portref_t *apx_routerPortMapEntry_getProvidePortById(apx_routerPortMapEntry_t *self,int32_t index)
+apx_portref_t *apx_routerPortMapEntry_getActiveProvider(apx_routerPortMapEntry_t *self)
 {
-   if (self != 0)
+   if ( (self != 0) && (self->providePorts.tail != APX_PORT_MAP_INVALID_HANDLE) )
    {
-      int32_t length = adt_ary_length(&self->providePorts);
+      return &self->providePorts.slots[self->providePorts.tail].portref;
+   }
+   return (apx_portref_t*) 0;
+}
 
-      if( (index >= 0) && (index < length) )
+/**
+ * retreives the portref_t stored under handle in self->providePorts.
+ * returns NULL on failure or when the slot is free
+ */
+apx_portref_t *apx_routerPortMapEntry_getProvidePortById(apx_routerPortMapEntry_t *self,int32_t handle)
+{
+   if ( (self != 0) && (handle >= 0) && (handle < self->providePorts.capacity) )
+   {
+      apx_portref_t *portref = &self->providePorts.slots[handle].portref;
+      if (portref->port != 0)
       {
-         return (apx_portref_t*) *adt_ary_get(&self->providePorts,index);
+         return portref;
       }
    }
    return (apx_portref_t*) 0;
@@ -220,26 +224,187 @@ apx_portref_t *apx_routerPortMapEntry_getProvidePortById(apx_routerPortMapEntry_
 
 
 /**
- * retreives the portref_t from the self->requirePorts array.
- * returns NULL on failure
+ * retreives the portref_t stored under handle in self->requirePorts.
+ * returns NULL on failure or when the slot is free
  */
-apx_portref_t *apx_routerPortMapEntry_getRequirePortById(apx_routerPortMapEntry_t *self,int32_t index)
+apx_portref_t *apx_routerPortMapEntry_getRequirePortById(apx_routerPortMapEntry_t *self,int32_t handle)
 {
-   if (self != 0)
+   if ( (self != 0) && (handle >= 0) && (handle < self->requirePorts.capacity) )
    {
-      int32_t length = adt_ary_length(&self->requirePorts);
-
-      if( (index >= 0) && (index < length) )
+      apx_portref_t *portref = &self->requirePorts.slots[handle].portref;
+      if (portref->port != 0)
       {
-         return (apx_portref_t*) *adt_ary_get(&self->requirePorts,index);
+         return portref;
       }
    }
    return (apx_portref_t*) 0;
 }
 
+/**
+ * iterates the require ports in insertion order:
+ * for (h = apx_routerPortMapEntry_firstRequirePort(e); h != APX_PORT_MAP_INVALID_HANDLE; h = apx_routerPortMapEntry_nextRequirePort(e, h))
+ */
+int32_t apx_routerPortMapEntry_firstRequirePort(const apx_routerPortMapEntry_t *self)
+{
+   if (self != 0)
+   {
+      return self->requirePorts.head;
+   }
+   return APX_PORT_MAP_INVALID_HANDLE;
+}
+
+int32_t apx_routerPortMapEntry_nextRequirePort(const apx_routerPortMapEntry_t *self, int32_t handle)
+{
+   if ( (self != 0) && (handle >= 0) && (handle < self->requirePorts.capacity) )
+   {
+      return self->requirePorts.slots[handle].next;
+   }
+   return APX_PORT_MAP_INVALID_HANDLE;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
+static void apx_routerPortList_create(apx_routerPortList_t *self)
+{
+   self->slots = (apx_routerPortSlot_t*) 0;
+   self->capacity = 0;
+   self->length = 0;
+   self->head = APX_PORT_MAP_INVALID_HANDLE;
+   self->tail = APX_PORT_MAP_INVALID_HANDLE;
+   self->freeHead = APX_PORT_MAP_INVALID_HANDLE;
+}
 
+static void apx_routerPortList_destroy(apx_routerPortList_t *self)
+{
+   if (self->slots != 0)
+   {
+      free(self->slots);
+   }
+   apx_routerPortList_create(self);
+}
 
+/**
+ * returns the slot holding (node, port) or APX_PORT_MAP_INVALID_HANDLE.
+ * The handle stored in the port is verified against the slot content. When it does not match (the port handle belongs to
+ * another port map) or when fullSearch is true and the port has no handle, this falls back to a linear search.
+ */
+static int32_t apx_routerPortList_find(const apx_routerPortList_t *self, const apx_node_t *node, const apx_port_t *port, bool fullSearch)
+{
+   int32_t handle = port->portMapHandle;
+   if ( (handle >= 0) && (handle < self->capacity) )
+   {
+      const apx_portref_t *portref = &self->slots[handle].portref;
+      if ( (portref->port == port) && (portref->node == node) )
+      {
+         return handle;
+      }
+   }
+   if ( (handle != APX_PORT_MAP_INVALID_HANDLE) || fullSearch )
+   {
+      for (handle = self->head; handle != APX_PORT_MAP_INVALID_HANDLE; handle = self->slots[handle].next)
+      {
+         const apx_portref_t *portref = &self->slots[handle].portref;
+         if ( (portref->port == port) && (portref->node == node) )
+         {
+            return handle;
+         }
+      }
+   }
+   return APX_PORT_MAP_INVALID_HANDLE;
+}
 
+/**
+ * doubles the capacity and links the new slots into the free list. Existing handles stay valid.
+ */
+static int8_t apx_routerPortList_grow(apx_routerPortList_t *self)
+{
+   int32_t i;
+   int32_t newCapacity = (self->capacity == 0)? PORT_LIST_MIN_CAPACITY : self->capacity*2;
+   apx_routerPortSlot_t *slots = (apx_routerPortSlot_t*) realloc(self->slots, sizeof(apx_routerPortSlot_t)*newCapacity);
+   if (slots == 0)
+   {
+      errno = ENOMEM;
+      return -1;
+   }
+   for (i=newCapacity-1; i>=self->capacity; i--)
+   {
+      slots[i].portref.node = (apx_node_t*) 0;
+      slots[i].portref.port = (apx_port_t*) 0;
+      slots[i].prev = APX_PORT_MAP_INVALID_HANDLE;
+      slots[i].next = self->freeHead;
+      self->freeHead = i;
+   }
+   self->slots = slots;
+   self->capacity = newCapacity;
+   return 0;
+}
+
+static int32_t apx_routerPortList_insert(apx_routerPortList_t *self, apx_node_t *node, apx_port_t *port)
+{
+   int32_t handle;
+   apx_routerPortSlot_t *slot;
+   if ( (self->freeHead == APX_PORT_MAP_INVALID_HANDLE) && (apx_routerPortList_grow(self) != 0) )
+   {
+      return APX_PORT_MAP_INVALID_HANDLE;
+   }
+   handle = self->freeHead;
+   slot = &self->slots[handle];
+   self->freeHead = slot->next;
+   apx_portref_create(&slot->portref, node, port);
+   slot->prev = self->tail;
+   slot->next = APX_PORT_MAP_INVALID_HANDLE;
+   if (self->tail != APX_PORT_MAP_INVALID_HANDLE)
+   {
+      self->slots[self->tail].next = handle;
+   }
+   else
+   {
+      self->head = handle;
+   }
+   self->tail = handle;
+   self->length++;
+   return handle;
+}
+
+static void apx_routerPortList_remove(apx_routerPortList_t *self, int32_t handle)
+{
+   apx_routerPortSlot_t *slot = &self->slots[handle];
+   assert(slot->portref.port != 0);
+   if (slot->prev != APX_PORT_MAP_INVALID_HANDLE)
+   {
+      self->slots[slot->prev].next = slot->next;
+   }
+   else
+   {
+      self->head = slot->next;
+   }
+   if (slot->next != APX_PORT_MAP_INVALID_HANDLE)
+   {
+      self->slots[slot->next].prev = slot->prev;
+   }
+   else
+   {
+      self->tail = slot->prev;
+   }
+   apx_portref_destroy(&slot->portref);
+   slot->portref.node = (apx_node_t*) 0;
+   slot->portref.port = (apx_port_t*) 0;
+   slot->prev = APX_PORT_MAP_INVALID_HANDLE;
+   slot->next = self->freeHead;
+   self->freeHead = handle;
+   self->length--;
+}
+
+static apx_routerPortList_t *apx_routerPortMapEntry_getList(apx_routerPortMapEntry_t *self, const apx_port_t *port)
+{
+   if (port->portType == APX_REQUIRE_PORT)
+   {
+      return &self->requirePorts;
+   }
+   else if (port->portType == APX_PROVIDE_PORT)
+   {
+      return &self->providePorts;
+   }
+   return (apx_routerPortList_t*) 0;
+}
@@ -31,6 +31,7 @@ static void apx_istream_handler_require(const apx_istream_handler_t *handler,con
 static void apx_istream_handler_provide(const apx_istream_handler_t *handler,const char *name, const char *dsg, const char *attr); //P"<name>"<dsg>:<attr>
 static void apx_istream_handler_close(const apx_istream_handler_t *handler);
 
+static int8_t apx_istream_parseLine(apx_istream_t *self, const uint8_t *pLineBegin, const uint8_t *pLineEnd);
 static const uint8_t* apx_istream_parseNodeName(apx_istream_t *self,const uint8_t *pBegin, const uint8_t *pEnd);
 static const uint8_t *apx_stream_parse_textLine(apx_istream_t *self,const uint8_t *pLineBegin,const uint8_t *pLineEnd);
 static const uint8_t *apx_stream_parseApxHeaderLine(const uint8_t *pBegin, const uint8_t *pEnd, apx_headerLine_t *data);
@@ -84,68 +85,55 @@ void apx_istream_open(apx_istream_t *self){
 }
 
 /**
- * Writes data to the istream. This function parses the data and forwards to sub-handlers
- * Returns 0 on success, negative on error
+ * Writes data to the istream. This function parses the data and forwards to sub-handlers.
+ * Complete lines are parsed directly from pChunk, only a trailing partial line is kept in self->buf until the rest of
+ * it arrives in a later call.
  */
 void apx_istream_write(apx_istream_t *self, const uint8_t *pChunk, uint32_t chunkLen){
    if( (self != 0) && (pChunk != 0) && (chunkLen != 0) ){
-      const uint8_t *pEnd;
-      const uint8_t *pBegin;
-      const uint8_t *pNext;
-      const uint8_t *pResult;
-      const uint8_t *pNextOld = 0;
-      adt_bytearray_append(&self->buf,(uint8_t*) pChunk,(uint32_t) chunkLen);
-      pBegin = adt_bytearray_data(&self->buf);
-      pEnd = pBegin+adt_bytearray_length(&self->buf);
-      pNext = pBegin;
-      while(pNext < pEnd){
-         uint8_t firstByte;
-
-         assert(pNextOld != pNext); //sanity-check for parser during development, this must never be true
-         pNextOld = pNext;
-         firstByte =  *pNext; //do not move pNext forward yet, it could be a single '\n' character
-         if(firstByte < 128U){
-            //ascii character if firstByte is in the range 0-127-
-            //wait to parse until a complete line has been seen. lines end with a single \n (not with \r\n as in HTML)
-            //if the line is empty it means end of data-block. This is the same principe as the empty \r\n at the end of an HTML request header.
-            const uint8_t *pLineEnd = 0;
-            const uint8_t *pLineBegin = pNext;
-
-            pLineEnd = bstr_searchVal(pNext,pEnd,(uint8_t) '\n');
-
-            if(pLineEnd == pLineBegin){
-               pNext = pLineEnd+1;
-               if(self->handler.node_end != 0){
-                  //empty line '\n'
-                  self->handler.node_end(self->handler.arg);
-               }
-            }
-            else if(pLineEnd > pLineBegin){
-
-               pNext = pLineEnd+1;
-               assert( ((char) *pLineEnd) == '\n'); //check during development, remove later
-               pResult = apx_stream_parse_textLine(self,pLineBegin,pLineEnd);
-               if(pResult == 0){
-                  //parse failure, ignore all data
-                  adt_bytearray_clear(&self->buf);
-                  APX_LOG_ERROR("[APX_STREAM] %s", "Parse error");
-                  return;
-               }
-            }
-            else{
-               //'\n' not seen, trim byffer and try parsing again later
-               break;
+      const uint8_t *pNext = pChunk;
+      const uint8_t *pEnd = pChunk+chunkLen;
+      const uint8_t *pLineEnd;
+      //lines end with a single \n (not with \r\n as in HTML)
+      //if the line is empty it means end of data-block. This is the same principe as the empty \r\n at the end of an HTML request header.
+      if (adt_bytearray_length(&self->buf) > 0)
+      {
+         //complete the partial line from the previous write
+         pLineEnd = (const uint8_t*) memchr(pNext, (int) '\n', (size_t) chunkLen);
+         if (pLineEnd == 0)
+         {
+            adt_bytearray_append(&self->buf, (uint8_t*) pNext, chunkLen);
+            return;
+         }
+         else
+         {
+            int8_t result;
+            const uint8_t *pLineBegin;
+            //the '\n' is copied as well, it terminates numbers parsed with strtol
+            adt_bytearray_append(&self->buf, (uint8_t*) pNext, (uint32_t) (pLineEnd-pNext+1));
+            pLineBegin = adt_bytearray_data(&self->buf);
+            result = apx_istream_parseLine(self, pLineBegin, pLineBegin+adt_bytearray_length(&self->buf)-1);
+            adt_bytearray_clear(&self->buf);
+            if (result != 0)
+            {
+               return;
             }
+            pNext = pLineEnd+1;
          }
       }
-      if (pNext <= pEnd)
-      {
-         adt_bytearray_trimLeft(&self->buf,pNext);
-      }
-      else
-      {
-         //pNext is outside array bounds
-         assert(0);
+      while(pNext < pEnd){
+         pLineEnd = (const uint8_t*) memchr(pNext, (int) '\n', (size_t) (pEnd-pNext));
+         if (pLineEnd == 0)
+         {
+            //'\n' not seen, save partial line and try parsing again later
+            adt_bytearray_append(&self->buf, (uint8_t*) pNext, (uint32_t) (pEnd-pNext));
+            break;
+         }
+         if (apx_istream_parseLine(self, pNext, pLineEnd) != 0)
+         {
+            return;
+         }
+         pNext = pLineEnd+1;
       }
    }
 }
@@ -282,6 +270,29 @@ void apx_istream_handler_close(const apx_istream_handler_t *handler){
    }
 }
 
+/**
+ * parses a single line, pLineEnd points to the terminating '\n' (which is not part of the line).
+ * returns 0 on success, -1 on parse failure
+ */
+static int8_t apx_istream_parseLine(apx_istream_t *self, const uint8_t *pLineBegin, const uint8_t *pLineEnd)
+{
+   if (pLineEnd == pLineBegin)
+   {
+      if(self->handler.node_end != 0){
+         //empty line '\n'
+         self->handler.node_end(self->handler.arg);
+      }
+   }
+   else if (apx_stream_parse_textLine(self,pLineBegin,pLineEnd) == 0)
+   {
+      //parse failure, ignore all data
+      adt_bytearray_clear(&self->buf);
+      APX_LOG_ERROR("[APX_STREAM] %s", "Parse error");
+      return -1;
+   }
+   return 0;
+}
+
 const uint8_t* apx_istream_parseNodeName(apx_istream_t *self, const uint8_t *pBegin, const uint8_t *pEnd){
    if (self != 0){
       const uint8_t *pNext;
@@ -436,107 +447,65 @@ static const uint8_t *apx_stream_parseApxHeaderLine(const uint8_t *pBegin, const
    return 0;
 }
 
+/**
+ * Splits R"<name>"<dsg>:<attr> into name, dsg and attr.
+ * The line is first split into views of the original buffer. The views are then materialized as null-terminated strings
+ * using a single copy of the line into data->pAlloc where the '"' and ':' separators are replaced with null-terminators.
+ */
 static const uint8_t * apx_splitDeclarationLine(const uint8_t *pBegin,const uint8_t *pEnd, apx_declarationLine_t *data)
 {
    const uint8_t *pNext = (uint8_t*) pBegin;
    const uint8_t *pResult = 0;
    const uint8_t *pNameBegin = 0;
-   const uint8_t *pDsgBegin = 0;
-   const uint8_t *pAttrBegin = 0;
    uint32_t nameLen=0;
    uint32_t dsgLen=0;
    uint32_t attrLen=0;
    if (pNext < pEnd)
    {
       data->lineType = *pNext++;
-      if (pNext < pEnd)
+      if ( (pNext < pEnd) && (*pNext == (uint8_t) '"') )
       {
-         uint8_t c = (uint8_t) *pNext;
-         if (c == '"')
+         pResult = bstr_matchPair(pNext,pEnd,'"','"','\\');
+         if (pResult > pNext)
          {
-            pResult = bstr_matchPair(pNext,pEnd,'"','"','\\');
-            if (pResult > pNext)
+            const uint8_t *pAttrSep;
+            nameLen = (uint32_t) (pResult-pNext-1); //compensate for the first '"' character
+            pNameBegin=(pNext+1);
+            pNext = pResult+1;
+            pAttrSep = (const uint8_t*) memchr(pNext, (int) ':', (size_t) (pEnd-pNext));
+            if (pAttrSep != 0)
             {
-               nameLen = (uint32_t) (pResult-pNext-1); //compensate for the first '"' character
-               pNameBegin=(pNext+1);
-               pNext = pResult+1;
-               pResult = bstr_searchVal(pNext,pEnd,':');
-               if (pResult > pNext)
+               dsgLen = (uint32_t) (pAttrSep-pNext);
+               attrLen = (uint32_t) (pEnd-pAttrSep-1);
+               if (attrLen == 0)
                {
-
-                  dsgLen = (uint32_t) (pResult-pNext);
-                  pDsgBegin=pNext;
-                  pNext = pResult;
-                  if (pNext<pEnd)
-                  {
-                     assert(':'==*pNext);
-                     pNext++;
-                     if (pNext<pEnd)
-                     {
-                        attrLen = (uint32_t) (pEnd-pNext);
-                        pAttrBegin=pNext;
-                        pNext=pEnd;
-                     }
-                     else
-                     {
-                        assert(0); //deal with this error later
-                     }
-                  }
-               }
-               else if(pResult == pNext) //OK, no ':' in string, put everything in dsg
-               {
-                  dsgLen = (uint32_t) (pEnd-pNext);
-                  pDsgBegin=pNext;
-                  pNext=pEnd;
-               }
-               else
-               {
-                  //parse failure
-                  assert(pResult == 0);
-                  return 0;
+                  return 0; //':' without attributes
                }
             }
-         }
-         if ( (nameLen>0) && (dsgLen>0) )
-         {
-            int8_t result;
-            uint32_t numTerminationChars = (attrLen>0)? 3u : 2u; //need extra bytes for NULL-terminators
-            result = apx_declarationLine_resize(data,nameLen+dsgLen+attrLen+numTerminationChars); //this grows the internal buffer if it's too small otherwise the buffer stays the same
-            if (result == 0)
+            else
             {
-               char *pStrNext;
-               char *pStrEnd;
-
-               pStrNext= data->pAlloc;
-               pStrEnd = pStrNext+data->allocLen;
-               memcpy(pStrNext,pNameBegin,nameLen);
-               data->name=pStrNext;
-               pStrNext+=nameLen;
-               *pStrNext++='\0';
-               memcpy(pStrNext,pDsgBegin,dsgLen);
-               data->dsg=pStrNext;
-               pStrNext+=dsgLen;
-               *pStrNext++='\0';
-               if (attrLen>0)
-               {
-                  memcpy(pStrNext,pAttrBegin,attrLen);
-                  data->attr=pStrNext;
-                  pStrNext+=attrLen;
-                  *pStrNext++='\0';
-               }
-               else
-               {
-                  data->attr = (char*) 0;
-               }
-               assert(pStrNext<=pStrEnd); //check pointer post conditions
-               return pNext;
+               //OK, no ':' in string, put everything in dsg
+               dsgLen = (uint32_t) (pEnd-pNext);
             }
          }
       }
+      if ( (nameLen>0) && (dsgLen>0) )
+      {
+         //the copied region is <name>"<dsg>:<attr>, only one extra byte is needed for the last null-terminator
+         uint32_t copyLen = (uint32_t) (pEnd-pNameBegin);
+         if (apx_declarationLine_resize(data, copyLen+1u) == 0) //this grows the internal buffer if it's too small otherwise the buffer stays the same
+         {
+            char *pStr = data->pAlloc;
+            memcpy(pStr, pNameBegin, copyLen);
+            pStr[copyLen] = '\0';
+            pStr[nameLen] = '\0';
+            data->name = pStr;
+            data->dsg = pStr+nameLen+1;
+            data->dsg[dsgLen] = '\0';
+            data->attr = (attrLen > 0)? data->dsg+dsgLen+1 : (char*) 0;
+            return pEnd;
+         }
+      }
    }
    return 0; //parse failure
 }
-
-
-
-
@@ -9,6 +9,12 @@ CuSuite* testsuite_apx_dataSignature(void);
 CuSuite* testsuite_apx_port(void);
 CuSuite* testSuite_apx_node(void);
 CuSuite* testSuite_apx_parser(void);
+CuSuite* testSuite_apx_stream(void);
+CuSuite* testSuite_apx_binaryDefinition(void);
+CuSuite* testSuite_apx_arena(void);
+CuSuite* testSuite_apx_logging(void);
+CuSuite* testSuite_apx_connectionStats(void);
+CuSuite* testSuite_apx_capture(void);
 CuSuite* testSuite_apx_portDataMap(void);
 CuSuite* testSuite_apx_nodeInfo(void);
 CuSuite* testSuite_apx_routerPortMapEntry(void);
@@ -17,14 +23,19 @@ CuSuite* testSuite_apx_dataTrigger(void);
 CuSuite* testSuite_apx_allocator(void);
 CuSuite* testSuite_apx_file(void);
 CuSuite* testSuite_apx_fileMap(void);
+CuSuite* testSuite_apx_fileManager(void);
 CuSuite* testSuite_apx_nodeData(void);
 CuSuite* testsuite_apx_attributesParser(void);
 CuSuite* testSuite_apx_dataElement(void);
+CuSuite* testSuite_apx_packProgram(void);
+CuSuite* testSuite_apx_codeGenerator(void);
+CuSuite* testSuite_apx_fileTableGenerator(void);
 CuSuite* testSuite_remotefile(void);
 CuSuite* testSuite_apx_testServer(void);
 CuSuite* testSuite_apx_clientSession(void);
 CuSuite* testSuite_apx_sessionCmd(void);
 CuSuite* testsuite_soa_fsa(void);
+CuSuite* testsuite_ringbuf(void);
 
 void RunAllTests(void)
 {
@@ -35,6 +46,12 @@ void RunAllTests(void)
    CuSuiteAddSuite(suite, testsuite_apx_port());
    CuSuiteAddSuite(suite, testSuite_apx_node());
    CuSuiteAddSuite(suite, testSuite_apx_parser());
+   CuSuiteAddSuite(suite, testSuite_apx_stream());
+   CuSuiteAddSuite(suite, testSuite_apx_binaryDefinition());
+   CuSuiteAddSuite(suite, testSuite_apx_arena());
+   CuSuiteAddSuite(suite, testSuite_apx_logging());
+   CuSuiteAddSuite(suite, testSuite_apx_connectionStats());
+   CuSuiteAddSuite(suite, testSuite_apx_capture());
    CuSuiteAddSuite(suite, testSuite_apx_portDataMap());
    CuSuiteAddSuite(suite, testSuite_apx_nodeInfo());
    CuSuiteAddSuite(suite, testSuite_apx_routerPortMapEntry());
@@ -42,15 +59,20 @@ void RunAllTests(void)
    CuSuiteAddSuite(suite, testSuite_apx_dataTrigger());
    CuSuiteAddSuite(suite, testSuite_apx_file());
    CuSuiteAddSuite(suite, testSuite_apx_fileMap());
+   CuSuiteAddSuite(suite, testSuite_apx_fileManager());
    CuSuiteAddSuite(suite, testSuite_apx_nodeData());
    CuSuiteAddSuite(suite, testSuite_apx_allocator());
    CuSuiteAddSuite(suite, testSuite_remotefile());
    CuSuiteAddSuite(suite, testsuite_apx_attributesParser());
    CuSuiteAddSuite(suite, testSuite_apx_dataElement());
+   CuSuiteAddSuite(suite, testSuite_apx_packProgram());
+   CuSuiteAddSuite(suite, testSuite_apx_codeGenerator());
+   CuSuiteAddSuite(suite, testSuite_apx_fileTableGenerator());
    CuSuiteAddSuite(suite, testSuite_apx_testServer());
    CuSuiteAddSuite(suite, testSuite_apx_clientSession());
    CuSuiteAddSuite(suite, testSuite_apx_sessionCmd());
    CuSuiteAddSuite(suite, testsuite_soa_fsa());
+   CuSuiteAddSuite(suite, testsuite_ringbuf());
 
    CuSuiteRun(suite);
    CuSuiteSummary(suite, output);
@@ -9,6 +9,9 @@
 #include "CuTest.h"
 #include "apx_allocator.h"
 #include "apx_parser.h"
+#ifndef _MSC_VER
+#include <pthread.h>
+#endif
 #ifdef MEM_LEAK_CHECK
 #include "CMemLeak.h"
 #endif
@@ -22,6 +25,16 @@
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void test_apx_allocator_create(CuTest* tc);
+static void test_apx_allocator_sizeClass(CuTest* tc);
+static void test_apx_allocator_reuseFreedBlock(CuTest* tc);
+static void test_apx_allocator_largeObjects(CuTest* tc);
+static void test_apx_allocator_releaseEmptySlabs(CuTest* tc);
+#ifndef _MSC_VER
+static void test_apx_allocator_remoteFree(CuTest* tc);
+static void test_apx_allocator_threadHeaps(CuTest* tc);
+static void *remoteFreeTask(void *arg);
+static void *threadAllocTask(void *arg);
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -42,6 +55,14 @@ CuSuite* testSuite_apx_allocator(void)
    CuSuite* suite = CuSuiteNew();
 
    SUITE_ADD_TEST(suite, test_apx_allocator_create);
+   SUITE_ADD_TEST(suite, test_apx_allocator_sizeClass);
+   SUITE_ADD_TEST(suite, test_apx_allocator_reuseFreedBlock);
+   SUITE_ADD_TEST(suite, test_apx_allocator_largeObjects);
+   SUITE_ADD_TEST(suite, test_apx_allocator_releaseEmptySlabs);
+#ifndef _MSC_VER
+   SUITE_ADD_TEST(suite, test_apx_allocator_remoteFree);
+   SUITE_ADD_TEST(suite, test_apx_allocator_threadHeaps);
+#endif
 
    return suite;
 }
@@ -58,8 +79,7 @@ static void test_apx_allocator_create(CuTest* tc)
    uint8_t *data4;
    uint8_t *data128;
    apx_allocator_t allocator;
-   apx_allocator_create(&allocator,100);
-   apx_allocator_start(&allocator);
+   apx_allocator_create(&allocator);
    data1 = apx_allocator_alloc(&allocator,1);
    CuAssertPtrNotNull(tc,data1);
    data2 = apx_allocator_alloc(&allocator,2);
@@ -74,7 +94,197 @@ static void test_apx_allocator_create(CuTest* tc)
    apx_allocator_free(&allocator,data3,3);
    apx_allocator_free(&allocator,data4,4);
    apx_allocator_free(&allocator,data128,128);
-   apx_allocator_stop(&allocator);
    apx_allocator_destroy(&allocator);
 }
 
+static void test_apx_allocator_sizeClass(CuTest* tc)
+{
+   CuAssertUIntEquals(tc, 0, apx_allocator_getSizeClass(1));
+   CuAssertUIntEquals(tc, 0, apx_allocator_getSizeClass(16));
+   CuAssertUIntEquals(tc, 1, apx_allocator_getSizeClass(17));
+   CuAssertUIntEquals(tc, 4, apx_allocator_getSizeClass(65));
+   CuAssertUIntEquals(tc, 11, apx_allocator_getSizeClass(1024));
+   CuAssertUIntEquals(tc, APX_ALLOCATOR_NUM_SIZE_CLASSES-1, apx_allocator_getSizeClass(APX_ALLOCATOR_MAX_OBJECT_SIZE));
+}
+
+static void test_apx_allocator_reuseFreedBlock(CuTest* tc)
+{
+   uint8_t *data1;
+   uint8_t *data2;
+   apx_allocatorStats_t stats;
+   apx_allocator_t allocator;
+   apx_allocator_create(&allocator);
+   data1 = apx_allocator_alloc(&allocator, 100);
+   CuAssertPtrNotNull(tc, data1);
+   CuAssertUIntEquals(tc, 0, ((uintptr_t) data1) % 8);
+   memset(data1, 0xAA, 100);
+   apx_allocator_free(&allocator, data1, 100);
+   data2 = apx_allocator_alloc(&allocator, 120);
+   CuAssertPtrEquals(tc, data1, data2);
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(100), &stats));
+   CuAssertUIntEquals(tc, 128, stats.objectSize);
+   CuAssertUIntEquals(tc, 1, stats.numSlabs);
+   CuAssertUIntEquals(tc, 2, stats.numAllocs);
+   CuAssertUIntEquals(tc, 1, stats.numFrees);
+   CuAssertUIntEquals(tc, 0, stats.numRemoteFrees);
+   CuAssertUIntEquals(tc, 1, stats.numInUse);
+   apx_allocator_free(&allocator, data2, 120);
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(100), &stats));
+   CuAssertUIntEquals(tc, 0, stats.numInUse);
+   CuAssertIntEquals(tc, -1, apx_allocator_getStats(&allocator, APX_ALLOCATOR_NUM_SIZE_CLASSES, &stats));
+   apx_allocator_destroy(&allocator);
+}
+
+static void test_apx_allocator_largeObjects(CuTest* tc)
+{
+   uint8_t *data;
+   apx_allocatorStats_t stats;
+   apx_allocator_t allocator;
+   apx_allocator_create(&allocator);
+   data = apx_allocator_alloc(&allocator, APX_ALLOCATOR_MAX_OBJECT_SIZE+1);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertIntEquals(tc, 0, apx_allocator_getLargeObjectStats(&allocator, &stats));
+   CuAssertUIntEquals(tc, 1, stats.numAllocs);
+   CuAssertUIntEquals(tc, 1, stats.numInUse);
+   apx_allocator_free(&allocator, data, APX_ALLOCATOR_MAX_OBJECT_SIZE+1);
+   CuAssertIntEquals(tc, 0, apx_allocator_getLargeObjectStats(&allocator, &stats));
+   CuAssertUIntEquals(tc, 1, stats.numFrees);
+   CuAssertUIntEquals(tc, 0, stats.numInUse);
+   apx_allocator_destroy(&allocator);
+}
+
+static void test_apx_allocator_releaseEmptySlabs(CuTest* tc)
+{
+   int i;
+   int numBlocks = 3 * ((APX_ALLOCATOR_SLAB_SIZE - APX_ALLOCATOR_SLAB_HEADER_SIZE) / (APX_ALLOCATOR_BLOCK_HEADER_SIZE + 1024));
+   uint8_t **data;
+   apx_allocatorStats_t stats;
+   apx_allocator_t allocator;
+   apx_allocator_create(&allocator);
+   data = (uint8_t**) malloc(numBlocks * sizeof(uint8_t*));
+   CuAssertPtrNotNull(tc, data);
+   for (i = 0; i < numBlocks; i++)
+   {
+      data[i] = apx_allocator_alloc(&allocator, 1024);
+      CuAssertPtrNotNull(tc, data[i]);
+   }
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(1024), &stats));
+   CuAssertUIntEquals(tc, 3, stats.numSlabs);
+   for (i = 0; i < numBlocks; i++)
+   {
+      apx_allocator_free(&allocator, data[i], 1024);
+   }
+   //one idle slab is kept per size class
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(1024), &stats));
+   CuAssertUIntEquals(tc, 1, stats.numSlabs);
+   CuAssertUIntEquals(tc, 0, stats.numInUse);
+   free(data);
+   apx_allocator_destroy(&allocator);
+}
+
+#ifndef _MSC_VER
+typedef struct remoteFreeArg_tag
+{
+   apx_allocator_t *allocator;
+   uint8_t *data[10];
+}remoteFreeArg_t;
+
+static void test_apx_allocator_remoteFree(CuTest* tc)
+{
+   int i;
+   int numBlocksPerSlab = (APX_ALLOCATOR_SLAB_SIZE - APX_ALLOCATOR_SLAB_HEADER_SIZE) / (APX_ALLOCATOR_BLOCK_HEADER_SIZE + 32);
+   uint8_t *data;
+   pthread_t thread;
+   remoteFreeArg_t arg;
+   apx_allocatorStats_t stats;
+   apx_allocator_t allocator;
+   apx_allocator_create(&allocator);
+   arg.allocator = &allocator;
+   for (i = 0; i < 10; i++)
+   {
+      arg.data[i] = apx_allocator_alloc(&allocator, 32);
+      CuAssertPtrNotNull(tc, arg.data[i]);
+   }
+   CuAssertIntEquals(tc, 0, pthread_create(&thread, 0, remoteFreeTask, &arg));
+   CuAssertIntEquals(tc, 0, pthread_join(thread, 0));
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(32), &stats));
+   CuAssertUIntEquals(tc, 10, stats.numRemoteFrees);
+   //freeing does not give the other thread a heap of its own
+   CuAssertUIntEquals(tc, 1, apx_allocator_getNumHeaps(&allocator));
+   CuAssertUIntEquals(tc, 10, stats.numFrees);
+   CuAssertUIntEquals(tc, 0, stats.numInUse);
+   //blocks freed by the other thread are handed out again once the local free list is used up
+   for (i = 0; i < numBlocksPerSlab; i++)
+   {
+      data = apx_allocator_alloc(&allocator, 32);
+      CuAssertPtrNotNull(tc, data);
+   }
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(32), &stats));
+   CuAssertUIntEquals(tc, 1, stats.numSlabs);
+   apx_allocator_destroy(&allocator);
+}
+
+static void test_apx_allocator_threadHeaps(CuTest* tc)
+{
+   int i;
+   uint8_t *data;
+   pthread_t thread;
+   remoteFreeArg_t arg;
+   apx_allocatorStats_t stats;
+   apx_allocator_t allocator;
+   apx_allocator_create(&allocator);
+   arg.allocator = &allocator;
+   data = apx_allocator_alloc(&allocator, 32);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertUIntEquals(tc, 1, apx_allocator_getNumHeaps(&allocator));
+   CuAssertIntEquals(tc, 0, pthread_create(&thread, 0, threadAllocTask, &arg));
+   CuAssertIntEquals(tc, 0, pthread_join(thread, 0));
+   //the other thread allocated from a heap of its own
+   CuAssertUIntEquals(tc, 2, apx_allocator_getNumHeaps(&allocator));
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(32), &stats));
+   CuAssertUIntEquals(tc, 2, stats.numSlabs);
+   CuAssertUIntEquals(tc, 11, stats.numAllocs);
+   for (i = 0; i < 10; i++)
+   {
+      CuAssertTrue(tc, arg.data[i] != data);
+      apx_allocator_free(&allocator, arg.data[i], 32);
+   }
+   apx_allocator_free(&allocator, data, 32);
+   CuAssertIntEquals(tc, 0, apx_allocator_getStats(&allocator, apx_allocator_getSizeClass(32), &stats));
+   CuAssertUIntEquals(tc, 10, stats.numRemoteFrees);
+   CuAssertUIntEquals(tc, 11, stats.numFrees);
+   CuAssertUIntEquals(tc, 0, stats.numInUse);
+   //a new allocator at the same address must not reuse heaps cached by this thread
+   apx_allocator_destroy(&allocator);
+   apx_allocator_create(&allocator);
+   CuAssertUIntEquals(tc, 0, apx_allocator_getNumHeaps(&allocator));
+   data = apx_allocator_alloc(&allocator, 32);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertUIntEquals(tc, 1, apx_allocator_getNumHeaps(&allocator));
+   apx_allocator_free(&allocator, data, 32);
+   apx_allocator_destroy(&allocator);
+}
+
+static void *threadAllocTask(void *arg)
+{
+   int i;
+   remoteFreeArg_t *remoteFreeArg = (remoteFreeArg_t*) arg;
+   for (i = 0; i < 10; i++)
+   {
+      remoteFreeArg->data[i] = apx_allocator_alloc(remoteFreeArg->allocator, 32);
+   }
+   return 0;
+}
+
+static void *remoteFreeTask(void *arg)
+{
+   int i;
+   remoteFreeArg_t *remoteFreeArg = (remoteFreeArg_t*) arg;
+   for (i = 0; i < 10; i++)
+   {
+      apx_allocator_free(remoteFreeArg->allocator, remoteFreeArg->data[i], 32);
+   }
+   return 0;
+}
+#endif
+
@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_arena.h"
+#include "apx_node.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_arena_alloc(CuTest* tc);
+static void test_apx_arena_strdup(CuTest* tc);
+static void test_apx_arena_grow(CuTest* tc);
+static void test_apx_arena_reserve(CuTest* tc);
+static void test_apx_arena_nodeInSingleChunk(CuTest* tc);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_arena(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_arena_alloc);
+   SUITE_ADD_TEST(suite, test_apx_arena_strdup);
+   SUITE_ADD_TEST(suite, test_apx_arena_grow);
+   SUITE_ADD_TEST(suite, test_apx_arena_reserve);
+   SUITE_ADD_TEST(suite, test_apx_arena_nodeInSingleChunk);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_arena_alloc(CuTest* tc)
+{
+   apx_arena_t arena;
+   uint8_t *p1;
+   uint8_t *p2;
+   uint8_t *p3;
+   apx_arena_create(&arena, 0);
+   CuAssertUIntEquals(tc, 0, apx_arena_getNumChunks(&arena));
+   CuAssertPtrEquals(tc, 0, apx_arena_alloc(&arena, 0));
+   p1 = (uint8_t*) apx_arena_alloc(&arena, 1);
+   p2 = (uint8_t*) apx_arena_alloc(&arena, 3);
+   p3 = (uint8_t*) apx_arena_alloc(&arena, 8);
+   CuAssertPtrNotNull(tc, p1);
+   CuAssertPtrNotNull(tc, p2);
+   CuAssertPtrNotNull(tc, p3);
+   CuAssertUIntEquals(tc, 0, ((uintptr_t) p1) % APX_ARENA_ALIGNMENT);
+   CuAssertPtrEquals(tc, p1+APX_ARENA_ALIGNMENT, p2);
+   CuAssertPtrEquals(tc, p2+APX_ARENA_ALIGNMENT, p3);
+   CuAssertUIntEquals(tc, 1, apx_arena_getNumChunks(&arena));
+   CuAssertUIntEquals(tc, 3*APX_ARENA_ALIGNMENT, apx_arena_getUsed(&arena));
+   apx_arena_destroy(&arena);
+   CuAssertUIntEquals(tc, 0, apx_arena_getNumChunks(&arena));
+}
+
+static void test_apx_arena_strdup(CuTest* tc)
+{
+   apx_arena_t *arena = apx_arena_new(0);
+   const char *src = "VehicleSpeed";
+   char *str;
+   CuAssertPtrNotNull(tc, arena);
+   str = apx_arena_strdup(arena, src);
+   CuAssertPtrNotNull(tc, str);
+   CuAssertTrue(tc, str != src);
+   CuAssertStrEquals(tc, src, str);
+   CuAssertPtrEquals(tc, 0, apx_arena_strdup(arena, 0));
+   apx_arena_delete(arena);
+}
+
+static void test_apx_arena_grow(CuTest* tc)
+{
+   apx_arena_t arena;
+   int i;
+   apx_arena_create(&arena, 64);
+   for (i = 0; i < 8; i++)
+   {
+      CuAssertPtrNotNull(tc, apx_arena_alloc(&arena, 16));
+   }
+   //64 + 128 bytes
+   CuAssertUIntEquals(tc, 2, apx_arena_getNumChunks(&arena));
+   //allocations larger than the next chunk size get a chunk of their own
+   CuAssertPtrNotNull(tc, apx_arena_alloc(&arena, 1000));
+   CuAssertUIntEquals(tc, 3, apx_arena_getNumChunks(&arena));
+   apx_arena_destroy(&arena);
+}
+
+static void test_apx_arena_reserve(CuTest* tc)
+{
+   apx_arena_t arena;
+   int i;
+   apx_arena_create(&arena, 64);
+   CuAssertIntEquals(tc, 0, apx_arena_reserve(&arena, 1024));
+   CuAssertUIntEquals(tc, 1, apx_arena_getNumChunks(&arena));
+   for (i = 0; i < 64; i++)
+   {
+      CuAssertPtrNotNull(tc, apx_arena_alloc(&arena, 16));
+   }
+   CuAssertUIntEquals(tc, 1, apx_arena_getNumChunks(&arena));
+   //already enough room left
+   CuAssertIntEquals(tc, 0, apx_arena_reserve(&arena, 0));
+   CuAssertUIntEquals(tc, 1, apx_arena_getNumChunks(&arena));
+   apx_arena_destroy(&arena);
+}
+
+static void test_apx_arena_nodeInSingleChunk(CuTest* tc)
+{
+   apx_node_t node;
+   apx_port_t *port;
+   apx_node_create(&node, "TestNode");
+   CuAssertIntEquals(tc, 0, apx_node_reserve(&node, 200));
+   apx_node_createDataType(&node, "Speed_T", "S", 0);
+   apx_node_createRequirePort(&node, "VehicleSpeed", "T[0]", "=0xFFFF");
+   apx_node_createProvidePort(&node, "EngineStatus", "C(0,3)", "=3");
+   apx_node_createProvidePort(&node, "Location", "{\"Id\"L\"Name\"a[4]}", 0);
+   CuAssertIntEquals(tc, 0, apx_node_finalize(&node));
+   CuAssertUIntEquals(tc, 1, apx_arena_getNumChunks(&node.arena));
+   port = apx_node_getRequirePort(&node, 0);
+   CuAssertStrEquals(tc, "VehicleSpeed", port->name);
+   CuAssertStrEquals(tc, "\"VehicleSpeed\"S", apx_port_getPortSignature(port));
+   port = apx_node_getProvidePort(&node, 1);
+   CuAssertStrEquals(tc, "Location", port->name);
+   CuAssertIntEquals(tc, 8, apx_port_getPackLen(port));
+   apx_node_destroy(&node);
+}
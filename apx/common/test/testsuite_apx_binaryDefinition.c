@@ -0,0 +1,354 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_binaryDefinition.h"
+#include "apx_cfg.h"
+#include "apx_error.h"
+#include "apx_file.h"
+#include "pack.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_binaryDefinition_compile(CuTest* tc);
+static void test_apx_binaryDefinition_createNode(CuTest* tc);
+static void test_apx_binaryDefinition_textDigest(CuTest* tc);
+static void test_apx_binaryDefinition_dataElements(CuTest* tc);
+static void test_apx_binaryDefinition_portAttributes(CuTest* tc);
+static void test_apx_binaryDefinition_corrupt(CuTest* tc);
+static void test_apx_binaryDefinition_corruptElements(CuTest* tc);
+static void test_apx_binaryDefinition_longNames(CuTest* tc);
+static void test_apx_binaryDefinition_fileType(CuTest* tc);
+static void createTestNode(apx_node_t *node);
+static void setElementField(uint8_t *data, uint32_t elementIndex, uint32_t fieldOffset, uint32_t value);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_definitionText =
+"APX/1.2\n"
+"N\"TestNode\"\n"
+"T\"Speed_T\"S\n"
+"R\"VehicleSpeed\"T[0]:=0xFFFF\n"
+"R\"Temperatures\"s[2]:={-1, 2}\n"
+"P\"EngineStatus\"C(0,3):=3\n"
+"P\"Location\"{\"Id\"L\"Name\"a[4]}\n"
+"\n";
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_binaryDefinition(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_compile);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_createNode);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_textDigest);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_dataElements);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_portAttributes);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_corrupt);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_corruptElements);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_longNames);
+   SUITE_ADD_TEST(suite, test_apx_binaryDefinition_fileType);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_binaryDefinition_compile(CuTest* tc)
+{
+   apx_node_t node;
+   apx_binaryDefinitionInfo_t info;
+   uint32_t len = 0;
+   uint8_t *data;
+   createTestNode(&node);
+   data = apx_binaryDefinition_compile(&node, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText), &len);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertTrue(tc, apx_binaryDefinition_isBinary(data, len));
+   CuAssertIntEquals(tc, 0, apx_binaryDefinition_getInfo(data, len, &info));
+   CuAssertUIntEquals(tc, len, info.totalLen);
+   CuAssertUIntEquals(tc, (uint32_t) strlen(m_definitionText), info.textLen);
+   CuAssertUIntEquals(tc, 1, info.numDatatypes);
+   CuAssertUIntEquals(tc, 2, info.numRequirePorts);
+   CuAssertUIntEquals(tc, 2, info.numProvidePorts);
+   CuAssertUIntEquals(tc, 6, info.inPortDataLen);
+   CuAssertUIntEquals(tc, 9, info.outPortDataLen);
+   //the node name is always first in the string table
+   CuAssertStrEquals(tc, "TestNode", (const char*) &data[len-info.stringTableLen]);
+   free(data);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_createNode(CuTest* tc)
+{
+   apx_node_t node;
+   apx_node_t *loaded;
+   apx_port_t *port;
+   uint32_t len = 0;
+   uint8_t *data;
+   createTestNode(&node);
+   data = apx_binaryDefinition_compile(&node, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText), &len);
+   CuAssertPtrNotNull(tc, data);
+   loaded = apx_binaryDefinition_createNode(data, len);
+   CuAssertPtrNotNull(tc, loaded);
+   CuAssertTrue(tc, loaded->isFinalized);
+   CuAssertStrEquals(tc, "TestNode", loaded->name);
+   CuAssertIntEquals(tc, 1, adt_ary_length(&loaded->datatypeList));
+   CuAssertIntEquals(tc, 2, apx_node_getNumRequirePorts(loaded));
+   CuAssertIntEquals(tc, 2, apx_node_getNumProvidePorts(loaded));
+   port = apx_node_getRequirePort(loaded, 0);
+   //type reference is stored already resolved
+   CuAssertStrEquals(tc, "VehicleSpeed", port->name);
+   CuAssertStrEquals(tc, "S", port->derivedDsg.str);
+   CuAssertStrEquals(tc, "\"VehicleSpeed\"S", apx_port_getPortSignature(port));
+   CuAssertIntEquals(tc, 0, apx_port_getPortIndex(port));
+   port = apx_node_getProvidePort(loaded, 1);
+   CuAssertStrEquals(tc, "Location", port->name);
+   CuAssertIntEquals(tc, 8, apx_port_getPackLen(port));
+   CuAssertIntEquals(tc, 1, apx_port_getPortIndex(port));
+   CuAssertUIntEquals(tc, apx_node_getInPortDataLen(&node), apx_node_getInPortDataLen(loaded));
+   CuAssertUIntEquals(tc, apx_node_getOutPortDataLen(&node), apx_node_getOutPortDataLen(loaded));
+   CuAssertTrue(tc, memcmp(apx_node_getInPortInitData(&node), apx_node_getInPortInitData(loaded), apx_node_getInPortDataLen(&node)) == 0);
+   CuAssertTrue(tc, memcmp(apx_node_getOutPortInitData(&node), apx_node_getOutPortInitData(loaded), apx_node_getOutPortDataLen(&node)) == 0);
+   CuAssertUIntEquals(tc, 0xFF, apx_node_getInPortInitData(loaded)[0]);
+   CuAssertUIntEquals(tc, 3, apx_node_getOutPortInitData(loaded)[0]);
+   apx_node_delete(loaded);
+   free(data);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_textDigest(CuTest* tc)
+{
+   apx_node_t node;
+   apx_binaryDefinitionInfo_t info;
+   uint32_t len = 0;
+   uint8_t *data;
+   char *modifiedText;
+   createTestNode(&node);
+   data = apx_binaryDefinition_compile(&node, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText), &len);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertIntEquals(tc, 0, apx_binaryDefinition_getInfo(data, len, &info));
+   CuAssertTrue(tc, info.textDigest == apx_binaryDefinition_digest((const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText)));
+   CuAssertIntEquals(tc, 0, apx_binaryDefinition_verifyText(data, len, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText)));
+   modifiedText = (char*) malloc(strlen(m_definitionText)+1);
+   strcpy(modifiedText, m_definitionText);
+   modifiedText[strlen(modifiedText)-3] = '4';
+   CuAssertTrue(tc, info.textDigest != apx_binaryDefinition_digest((const uint8_t*) modifiedText, (uint32_t) strlen(modifiedText)));
+   apx_clearError();
+   CuAssertIntEquals(tc, -1, apx_binaryDefinition_verifyText(data, len, (const uint8_t*) modifiedText, (uint32_t) strlen(modifiedText)));
+   CuAssertIntEquals(tc, APX_VALUE_ERROR, apx_getLastError());
+   //same text with a different length
+   CuAssertIntEquals(tc, -1, apx_binaryDefinition_verifyText(data, len, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText)-1));
+   free(modifiedText);
+   free(data);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_dataElements(CuTest* tc)
+{
+   apx_node_t node;
+   apx_node_t *loaded;
+   apx_port_t *port;
+   apx_dataElement_t *child;
+   apx_binaryDefinitionInfo_t info;
+   uint32_t len = 0;
+   uint8_t *data;
+   createTestNode(&node);
+   data = apx_binaryDefinition_compile(&node, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText), &len);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertIntEquals(tc, 0, apx_binaryDefinition_getInfo(data, len, &info));
+   //one element per non-record port, three for the record port
+   CuAssertUIntEquals(tc, 6, info.numElements);
+   loaded = apx_binaryDefinition_createNode(data, len);
+   CuAssertPtrNotNull(tc, loaded);
+   port = apx_node_getRequirePort(loaded, 1);
+   CuAssertIntEquals(tc, APX_BASE_TYPE_SINT16, port->derivedDsg.dataElement->baseType);
+   CuAssertUIntEquals(tc, 2, port->derivedDsg.dataElement->arrayLen);
+   CuAssertTrue(tc, port->derivedDsg.packProgram.numInstructions > 0);
+   port = apx_node_getProvidePort(loaded, 0);
+   CuAssertIntEquals(tc, APX_BASE_TYPE_UINT8, port->derivedDsg.dataElement->baseType);
+   CuAssertUIntEquals(tc, 0, port->derivedDsg.dataElement->min.u32);
+   CuAssertUIntEquals(tc, 3, port->derivedDsg.dataElement->max.u32);
+   port = apx_node_getProvidePort(loaded, 1);
+   CuAssertIntEquals(tc, APX_BASE_TYPE_RECORD, port->derivedDsg.dataElement->baseType);
+   CuAssertIntEquals(tc, 2, apx_dataElement_getNumChild(port->derivedDsg.dataElement));
+   child = apx_dataElement_getChildAt(port->derivedDsg.dataElement, 1);
+   CuAssertStrEquals(tc, "Name", child->name);
+   CuAssertIntEquals(tc, APX_BASE_TYPE_STRING, child->baseType);
+   CuAssertUIntEquals(tc, 4, child->arrayLen);
+   CuAssertUIntEquals(tc, apx_node_getProvidePort(&node, 1)->derivedDsg.packProgram.packLen, port->derivedDsg.packProgram.packLen);
+   apx_node_delete(loaded);
+   free(data);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_portAttributes(CuTest* tc)
+{
+   apx_node_t node;
+   apx_node_t *loaded;
+   apx_port_t *port;
+   uint32_t len = 0;
+   uint8_t *data;
+   apx_node_create(&node, "AttributeNode");
+   apx_node_createRequirePort(&node, "Setting", "C", "P,=7");
+   apx_node_createProvidePort(&node, "Events", "S", "Q[10]");
+   data = apx_binaryDefinition_compile(&node, 0, 0, &len);
+   CuAssertPtrNotNull(tc, data);
+   loaded = apx_binaryDefinition_createNode(data, len);
+   CuAssertPtrNotNull(tc, loaded);
+   port = apx_node_getRequirePort(loaded, 0);
+   CuAssertPtrNotNull(tc, port->portAttributes);
+   CuAssertStrEquals(tc, "P,=7", port->portAttributes->rawValue);
+   CuAssertTrue(tc, port->portAttributes->isParameter);
+   CuAssertTrue(tc, !port->portAttributes->isQueued);
+   CuAssertUIntEquals(tc, 7, apx_node_getInPortInitData(loaded)[0]);
+   port = apx_node_getProvidePort(loaded, 0);
+   CuAssertTrue(tc, port->portAttributes->isQueued);
+   CuAssertIntEquals(tc, 10, port->portAttributes->queueLen);
+   apx_node_delete(loaded);
+   free(data);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_corrupt(CuTest* tc)
+{
+   apx_node_t node;
+   uint32_t len = 0;
+   uint8_t *data;
+   createTestNode(&node);
+   data = apx_binaryDefinition_compile(&node, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText), &len);
+   CuAssertPtrNotNull(tc, data);
+   //truncated data
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len-1));
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, 10));
+   //plain text is not a binary definition
+   CuAssertTrue(tc, !apx_binaryDefinition_isBinary((const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText)));
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode((const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText)));
+   //pack length of first require port does not match its data signature
+   data[APX_BINARY_DEFINITION_HEADER_LEN + APX_BINARY_DEFINITION_DATATYPE_LEN + 12]++;
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   data[APX_BINARY_DEFINITION_HEADER_LEN + APX_BINARY_DEFINITION_DATATYPE_LEN + 12]--;
+   //string offset outside of string table
+   data[APX_BINARY_DEFINITION_HEADER_LEN + APX_BINARY_DEFINITION_DATATYPE_LEN + 3] = 0x7F;
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   free(data);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_corruptElements(CuTest* tc)
+{
+   apx_node_t node;
+   apx_node_t *loaded;
+   uint32_t len = 0;
+   uint8_t *original;
+   uint8_t *data;
+   createTestNode(&node);
+   original = apx_binaryDefinition_compile(&node, (const uint8_t*) m_definitionText, (uint32_t) strlen(m_definitionText), &len);
+   CuAssertPtrNotNull(tc, original);
+   data = (uint8_t*) malloc(len);
+   CuAssertPtrNotNull(tc, data);
+   //element table: VehicleSpeed, Temperatures, EngineStatus, Location, Id, Name
+   //element pack length does not match its type and array length
+   memcpy(data, original, len);
+   setElementField(data, 5, 16, 5);
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   //array length and pack lengths agree with each other but not with the data signature "s[2]"
+   memcpy(data, original, len);
+   setElementField(data, 1, 12, 3);
+   setElementField(data, 1, 16, 6);
+   packLE(&data[APX_BINARY_DEFINITION_HEADER_LEN + APX_BINARY_DEFINITION_DATATYPE_LEN + APX_BINARY_DEFINITION_PORT_LEN + 12], 6, 4);
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   //base type does not match the data signature "C(0,3)"
+   memcpy(data, original, len);
+   data[APX_BINARY_DEFINITION_HEADER_LEN + APX_BINARY_DEFINITION_DATATYPE_LEN + 4*APX_BINARY_DEFINITION_PORT_LEN + 2*APX_BINARY_DEFINITION_ELEMENT_LEN + 4] = APX_BASE_TYPE_SINT8;
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   //huge array length
+   memcpy(data, original, len);
+   setElementField(data, 5, 12, 0x40000000);
+   setElementField(data, 5, 16, 0x40000000);
+   setElementField(data, 3, 16, 0x40000004);
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   //unmodified copy still loads
+   memcpy(data, original, len);
+   loaded = apx_binaryDefinition_createNode(data, len);
+   CuAssertPtrNotNull(tc, loaded);
+   apx_node_delete(loaded);
+   free(data);
+   free(original);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_longNames(CuTest* tc)
+{
+   apx_node_t node;
+   uint32_t len = 0;
+   uint8_t *data;
+   char name[APX_MAX_NAME_LEN+1];
+   memset(name, 'A', APX_MAX_NAME_LEN);
+   name[APX_MAX_NAME_LEN] = 0;
+   apx_node_create(&node, "LongNames");
+   apx_node_createRequirePort(&node, name, "C", 0);
+   data = apx_binaryDefinition_compile(&node, 0, 0, &len);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   free(data);
+   apx_node_destroy(&node);
+   apx_node_create(&node, name);
+   apx_node_createRequirePort(&node, "Short", "C", 0);
+   data = apx_binaryDefinition_compile(&node, 0, 0, &len);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertPtrEquals(tc, 0, apx_binaryDefinition_createNode(data, len));
+   free(data);
+   apx_node_destroy(&node);
+}
+
+static void test_apx_binaryDefinition_fileType(CuTest* tc)
+{
+   apx_file_t file;
+   rmf_fileInfo_t info;
+   rmf_fileInfo_create(&info, "TestNode.apb", 0x4000000, 100, RMF_FILE_TYPE_FIXED);
+   CuAssertIntEquals(tc, 0, apx_file_createRemoteFile(&file, &info));
+   CuAssertIntEquals(tc, APX_DEFINITION_BIN_FILE, file.fileType);
+   apx_file_destroy(&file);
+   rmf_fileInfo_destroy(&info);
+}
+
+static void createTestNode(apx_node_t *node)
+{
+   apx_node_create(node, "TestNode");
+   apx_node_createDataType(node, "Speed_T", "S", 0);
+   apx_node_createRequirePort(node, "VehicleSpeed", "T[0]", "=0xFFFF");
+   apx_node_createRequirePort(node, "Temperatures", "s[2]", "={-1, 2}");
+   apx_node_createProvidePort(node, "EngineStatus", "C(0,3)", "=3");
+   apx_node_createProvidePort(node, "Location", "{\"Id\"L\"Name\"a[4]}", 0);
+   apx_node_finalize(node);
+}
+
+static void setElementField(uint8_t *data, uint32_t elementIndex, uint32_t fieldOffset, uint32_t value)
+{
+   uint32_t offset = APX_BINARY_DEFINITION_HEADER_LEN + APX_BINARY_DEFINITION_DATATYPE_LEN + 4*APX_BINARY_DEFINITION_PORT_LEN +
+         elementIndex*APX_BINARY_DEFINITION_ELEMENT_LEN + fieldOffset;
+   packLE(&data[offset], value, 4);
+}
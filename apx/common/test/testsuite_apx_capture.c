@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_capture.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define CAPTURE_TEST_FILE "testsuite_apx_capture.bin"
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_capture_writeRead(CuTest* tc);
+static void test_apx_capture_grow(CuTest* tc);
+static void test_apx_capture_invalidFile(CuTest* tc);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_capture(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_capture_writeRead);
+   SUITE_ADD_TEST(suite, test_apx_capture_grow);
+   SUITE_ADD_TEST(suite, test_apx_capture_invalidFile);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_capture_writeRead(CuTest* tc)
+{
+   apx_capture_t capture;
+   apx_captureReader_t reader;
+   apx_captureRecord_t record;
+   uint8_t frame1[] = {0x04, 'R', 'M', 'F', 'P'};
+   uint8_t frame2[] = {0x08, 0xBF, 0xFF, 0xFC, 0x00, 0x00, 0x00, 0x00, 0x00};
+   uint32_t id1;
+   uint32_t id2;
+   uint64_t lastTimestamp;
+   CuAssertIntEquals(tc, 0, apx_capture_open(&capture, CAPTURE_TEST_FILE));
+   id1 = apx_capture_newConnectionId(&capture);
+   id2 = apx_capture_newConnectionId(&capture);
+   CuAssertTrue(tc, id1 != id2);
+   CuAssertIntEquals(tc, 0, apx_capture_write(&capture, id1, APX_CAPTURE_RX, frame1, sizeof(frame1)));
+   CuAssertIntEquals(tc, 0, apx_capture_write(&capture, id2, APX_CAPTURE_TX, frame2, sizeof(frame2)));
+   CuAssertIntEquals(tc, -1, apx_capture_write(&capture, id2, APX_CAPTURE_TX, frame2, 0));
+   apx_capture_close(&capture);
+
+   CuAssertIntEquals(tc, 0, apx_captureReader_open(&reader, CAPTURE_TEST_FILE));
+   CuAssertIntEquals(tc, 1, apx_captureReader_next(&reader, &record));
+   CuAssertUIntEquals(tc, id1, record.connectionId);
+   CuAssertUIntEquals(tc, APX_CAPTURE_RX, record.direction);
+   CuAssertUIntEquals(tc, sizeof(frame1), record.frameLen);
+   CuAssertTrue(tc, memcmp(record.frame, frame1, sizeof(frame1)) == 0);
+   lastTimestamp = record.timestamp;
+   CuAssertIntEquals(tc, 1, apx_captureReader_next(&reader, &record));
+   CuAssertUIntEquals(tc, id2, record.connectionId);
+   CuAssertUIntEquals(tc, APX_CAPTURE_TX, record.direction);
+   CuAssertUIntEquals(tc, sizeof(frame2), record.frameLen);
+   CuAssertTrue(tc, memcmp(record.frame, frame2, sizeof(frame2)) == 0);
+   CuAssertTrue(tc, record.timestamp >= lastTimestamp);
+   CuAssertIntEquals(tc, 0, apx_captureReader_next(&reader, &record));
+   apx_captureReader_rewind(&reader);
+   CuAssertIntEquals(tc, 1, apx_captureReader_next(&reader, &record));
+   CuAssertUIntEquals(tc, id1, record.connectionId);
+   apx_captureReader_close(&reader);
+   remove(CAPTURE_TEST_FILE);
+}
+
+static void test_apx_capture_grow(CuTest* tc)
+{
+   apx_capture_t capture;
+   apx_captureReader_t reader;
+   apx_captureRecord_t record;
+   uint8_t *frame;
+   uint32_t frameLen = 100000u;
+   uint32_t numFrames = (APX_CAPTURE_GROW_SIZE / frameLen) * 2u;
+   uint32_t i;
+   frame = (uint8_t*) malloc(frameLen);
+   CuAssertPtrNotNull(tc, frame);
+   CuAssertIntEquals(tc, 0, apx_capture_open(&capture, CAPTURE_TEST_FILE));
+   for (i=0; i<numFrames; i++)
+   {
+      memset(frame, (int) (i & 0xFF), frameLen);
+      CuAssertIntEquals(tc, 0, apx_capture_write(&capture, 0u, APX_CAPTURE_RX, frame, frameLen - (i % 8u)));
+   }
+   apx_capture_close(&capture);
+   CuAssertIntEquals(tc, 0, apx_captureReader_open(&reader, CAPTURE_TEST_FILE));
+   for (i=0; i<numFrames; i++)
+   {
+      CuAssertIntEquals(tc, 1, apx_captureReader_next(&reader, &record));
+      CuAssertUIntEquals(tc, frameLen - (i % 8u), record.frameLen);
+      CuAssertUIntEquals(tc, i & 0xFF, record.frame[0]);
+      CuAssertUIntEquals(tc, i & 0xFF, record.frame[record.frameLen-1]);
+   }
+   CuAssertIntEquals(tc, 0, apx_captureReader_next(&reader, &record));
+   apx_captureReader_close(&reader);
+   free(frame);
+   remove(CAPTURE_TEST_FILE);
+}
+
+static void test_apx_capture_invalidFile(CuTest* tc)
+{
+   apx_captureReader_t reader;
+   FILE *fp = fopen(CAPTURE_TEST_FILE, "wb");
+   CuAssertPtrNotNull(tc, fp);
+   fprintf(fp, "this is not a capture file, just some text");
+   fclose(fp);
+   CuAssertIntEquals(tc, -1, apx_captureReader_open(&reader, CAPTURE_TEST_FILE));
+   remove(CAPTURE_TEST_FILE);
+}
@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_connectionStats.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_connectionStats_create(CuTest* tc);
+static void test_apx_connectionStats_counters(CuTest* tc);
+static void test_apx_connectionStats_updateMax(CuTest* tc);
+static void test_apx_connectionStats_toText(CuTest* tc);
+static void test_apx_connectionStats_toJson(CuTest* tc);
+static void test_apx_connectionStats_bufferTooSmall(CuTest* tc);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_connectionStats(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_connectionStats_create);
+   SUITE_ADD_TEST(suite, test_apx_connectionStats_counters);
+   SUITE_ADD_TEST(suite, test_apx_connectionStats_updateMax);
+   SUITE_ADD_TEST(suite, test_apx_connectionStats_toText);
+   SUITE_ADD_TEST(suite, test_apx_connectionStats_toJson);
+   SUITE_ADD_TEST(suite, test_apx_connectionStats_bufferTooSmall);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_connectionStats_create(CuTest* tc)
+{
+   apx_connectionStats_t stats;
+   memset(&stats, 0xFF, sizeof(stats));
+   apx_connectionStats_create(&stats);
+   CuAssertUIntEquals(tc, 0, stats.numMessagesIn);
+   CuAssertUIntEquals(tc, 0, stats.numMessagesOut);
+   CuAssertTrue(tc, stats.numBytesIn == 0u);
+   CuAssertTrue(tc, stats.numBytesOut == 0u);
+   CuAssertUIntEquals(tc, 0, stats.queueHighWater);
+   CuAssertUIntEquals(tc, 0, stats.numSendStalls);
+   CuAssertUIntEquals(tc, 0, stats.numDroppedMessages);
+   CuAssertUIntEquals(tc, 0, stats.numTriggers);
+   CuAssertUIntEquals(tc, 0, stats.numConflatedMessages);
+   CuAssertUIntEquals(tc, 0, stats.queueDepth);
+   CuAssertUIntEquals(tc, 0, stats.allocatorObjectsInUse);
+   CuAssertUIntEquals(tc, 0, stats.allocatorBytesInUse);
+}
+
+static void test_apx_connectionStats_counters(CuTest* tc)
+{
+   apx_connectionStats_t stats;
+   apx_connectionStats_create(&stats);
+   APX_STATS_INC(stats.numMessagesIn);
+   APX_STATS_INC(stats.numMessagesIn);
+   APX_STATS_ADD64(stats.numBytesIn, 0x100000000ull);
+   APX_STATS_ADD64(stats.numBytesIn, 10);
+   APX_STATS_ADD32(stats.numTriggers, 5);
+   CuAssertUIntEquals(tc, 2, stats.numMessagesIn);
+   CuAssertTrue(tc, stats.numBytesIn == 0x10000000Aull);
+   CuAssertUIntEquals(tc, 5, stats.numTriggers);
+}
+
+static void test_apx_connectionStats_updateMax(CuTest* tc)
+{
+   apx_connectionStats_t stats;
+   apx_connectionStats_create(&stats);
+   apx_connectionStats_updateMax(&stats.queueHighWater, 3);
+   CuAssertUIntEquals(tc, 3, stats.queueHighWater);
+   apx_connectionStats_updateMax(&stats.queueHighWater, 2);
+   CuAssertUIntEquals(tc, 3, stats.queueHighWater);
+   apx_connectionStats_updateMax(&stats.queueHighWater, 7);
+   CuAssertUIntEquals(tc, 7, stats.queueHighWater);
+}
+
+static void test_apx_connectionStats_toText(CuTest* tc)
+{
+   apx_connectionStats_t stats;
+   char buf[256];
+   int32_t result;
+   apx_connectionStats_create(&stats);
+   stats.numMessagesIn = 1;
+   stats.numBytesIn = 12;
+   stats.numMessagesOut = 2;
+   stats.numBytesOut = 34;
+   stats.queueDepth = 3;
+   stats.queueHighWater = 4;
+   stats.numSendStalls = 5;
+   stats.numDroppedMessages = 6;
+   stats.numTriggers = 7;
+   stats.numConflatedMessages = 10;
+   stats.allocatorObjectsInUse = 8;
+   stats.allocatorBytesInUse = 9;
+   result = apx_connectionStats_toText(&stats, buf, sizeof(buf));
+   CuAssertStrEquals(tc, "msgIn=1 bytesIn=12 msgOut=2 bytesOut=34 queue=3 queueMax=4 stalls=5 dropped=6 triggers=7 conflated=10 allocObjects=8 allocBytes=9", buf);
+   CuAssertIntEquals(tc, (int) strlen(buf), result);
+}
+
+static void test_apx_connectionStats_toJson(CuTest* tc)
+{
+   apx_connectionStats_t stats;
+   char buf[256];
+   int32_t result;
+   apx_connectionStats_create(&stats);
+   stats.numMessagesIn = 1;
+   stats.numBytesIn = 5000000000ull;
+   stats.numTriggers = 7;
+   result = apx_connectionStats_toJson(&stats, buf, sizeof(buf));
+   CuAssertStrEquals(tc, "{\"msgIn\":1,\"bytesIn\":5000000000,\"msgOut\":0,\"bytesOut\":0,\"queue\":0,\"queueMax\":0,"
+         "\"stalls\":0,\"dropped\":0,\"triggers\":7,\"conflated\":0,\"allocObjects\":0,\"allocBytes\":0}", buf);
+   CuAssertIntEquals(tc, (int) strlen(buf), result);
+}
+
+static void test_apx_connectionStats_bufferTooSmall(CuTest* tc)
+{
+   apx_connectionStats_t stats;
+   char buf[16];
+   apx_connectionStats_create(&stats);
+   CuAssertIntEquals(tc, -1, apx_connectionStats_toText(&stats, buf, sizeof(buf)));
+   CuAssertIntEquals(tc, -1, apx_connectionStats_toJson(&stats, buf, sizeof(buf)));
+   CuAssertIntEquals(tc, -1, apx_connectionStats_toText(0, buf, sizeof(buf)));
+}
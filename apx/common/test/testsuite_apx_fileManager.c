@@ -0,0 +1,266 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_fileManager.h"
+#include "rmf.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define PORT_DATA_LEN 8
+#define NODE_A_ADDRESS 0x0000u
+#define NODE_B_ADDRESS 0x0400u
+#define NODE_C_ADDRESS 0x0800u
+#define MAX_LOGGED_WRITES 16
+#define MAX_FRAMES 128
+
+typedef struct remoteFileWrite_tag
+{
+   apx_file_t *file;
+   uint32_t offset;
+   int32_t length;
+}remoteFileWrite_t;
+
+typedef struct remoteFileWriteLog_tag
+{
+   remoteFileWrite_t writes[MAX_LOGGED_WRITES];
+   int32_t numWrites;
+}remoteFileWriteLog_t;
+
+typedef struct batchFixture_tag
+{
+   apx_fileManager_t fileManager;
+   apx_nodeData_t nodeDataA;
+   apx_nodeData_t nodeDataB;
+   uint8_t outPortDataA[PORT_DATA_LEN];
+   uint8_t outPortDataB[PORT_DATA_LEN];
+   apx_file_t *fileA;
+   apx_file_t *fileB;
+   remoteFileWriteLog_t log;
+   uint8_t buf[4096];
+   int32_t bufLen;
+   apx_fileManagerFrame_t frames[MAX_FRAMES];
+   int32_t numFrames;
+}batchFixture_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_fileManager_parseMessagesBatch(CuTest* tc);
+static void test_apx_fileManager_parseMessagesGrowBatch(CuTest* tc);
+static void batchFixture_create(CuTest* tc, batchFixture_t *fixture);
+static void batchFixture_destroy(batchFixture_t *fixture);
+static void batchFixture_addWrite(batchFixture_t *fixture, uint32_t address, bool more_bit, const uint8_t *data, int32_t dataLen);
+static void batchFixture_addFileInfo(batchFixture_t *fixture, const char *name, uint32_t address, uint32_t length);
+static void remoteFileWrittenSpy(void *arg, apx_file_t *remoteFile, uint32_t offset, int32_t length);
+static int32_t findLoggedWrite(const remoteFileWriteLog_t *log, int32_t begin, int32_t end, const apx_file_t *file, uint32_t offset, int32_t length);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_fileManager(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_fileManager_parseMessagesBatch);
+   SUITE_ADD_TEST(suite, test_apx_fileManager_parseMessagesGrowBatch);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * one receive buffer with interleaved writes to two files, overlapping and adjacent ranges, a command in the middle
+ * of the batch and a fragmented write
+ */
+static void test_apx_fileManager_parseMessagesBatch(CuTest* tc)
+{
+   batchFixture_t *fixture = (batchFixture_t*) malloc(sizeof(batchFixture_t));
+   const uint8_t dataA1[2] = {0x01, 0x02};
+   const uint8_t dataB1[4] = {0x10, 0x11, 0x12, 0x13};
+   const uint8_t dataA2[2] = {0x03, 0x04};
+   const uint8_t dataB2[2] = {0x14, 0x15};
+   const uint8_t dataA3[1] = {0x05};
+   const uint8_t dataA4[2] = {0x06, 0x07};
+   const uint8_t dataA5[1] = {0x08};
+   const uint8_t dataB3[1] = {0x16};
+   const uint8_t dataB4[1] = {0x17};
+   const uint8_t dataA6[1] = {0x09};
+   const uint8_t expectedA[PORT_DATA_LEN] = {0x08, 0x03, 0x09, 0x00, 0x00, 0x00, 0x06, 0x07};
+   const uint8_t expectedB[PORT_DATA_LEN] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17};
+   CuAssertPtrNotNull(tc, fixture);
+   batchFixture_create(tc, fixture);
+
+   batchFixture_addWrite(fixture, NODE_A_ADDRESS+0u, false, dataA1, sizeof(dataA1));
+   batchFixture_addWrite(fixture, NODE_B_ADDRESS+0u, false, dataB1, sizeof(dataB1));
+   batchFixture_addWrite(fixture, NODE_A_ADDRESS+1u, false, dataA2, sizeof(dataA2)); //overlaps A1
+   batchFixture_addWrite(fixture, NODE_B_ADDRESS+4u, false, dataB2, sizeof(dataB2)); //adjacent to B1
+   batchFixture_addWrite(fixture, NODE_A_ADDRESS+0u, false, dataA3, sizeof(dataA3)); //overlaps A1
+   batchFixture_addWrite(fixture, NODE_A_ADDRESS+6u, false, dataA4, sizeof(dataA4)); //separate range
+   batchFixture_addFileInfo(fixture, "NodeC.out", NODE_C_ADDRESS, PORT_DATA_LEN);
+   batchFixture_addWrite(fixture, NODE_A_ADDRESS+0u, false, dataA5, sizeof(dataA5)); //not merged with writes before the command
+   batchFixture_addWrite(fixture, NODE_B_ADDRESS+6u, true, dataB3, sizeof(dataB3));
+   batchFixture_addWrite(fixture, NODE_B_ADDRESS+7u, false, dataB4, sizeof(dataB4));
+   batchFixture_addWrite(fixture, NODE_A_ADDRESS+2u, false, dataA6, sizeof(dataA6));
+   CuAssertIntEquals(tc, 0, apx_fileManager_parseMessages(&fixture->fileManager, fixture->frames, fixture->numFrames));
+
+   CuAssertTrue(tc, memcmp(expectedA, fixture->outPortDataA, PORT_DATA_LEN) == 0);
+   CuAssertTrue(tc, memcmp(expectedB, fixture->outPortDataB, PORT_DATA_LEN) == 0);
+   CuAssertPtrNotNull(tc, apx_fileManager_findRemoteFile(&fixture->fileManager, "NodeC.out"));
+
+   CuAssertIntEquals(tc, 6, fixture->log.numWrites);
+   //writes before the command, the order of the files is not defined
+   CuAssertTrue(tc, findLoggedWrite(&fixture->log, 0, 3, fixture->fileA, 0u, 3) >= 0);
+   CuAssertTrue(tc, findLoggedWrite(&fixture->log, 0, 3, fixture->fileA, 6u, 2) >= 0);
+   CuAssertTrue(tc, findLoggedWrite(&fixture->log, 0, 3, fixture->fileB, 0u, 6) >= 0);
+   //applied before the fragmented write starts
+   CuAssertIntEquals(tc, 3, findLoggedWrite(&fixture->log, 3, 4, fixture->fileA, 0u, 1));
+   //both fragments are reported as one range
+   CuAssertIntEquals(tc, 4, findLoggedWrite(&fixture->log, 4, 5, fixture->fileB, 6u, 2));
+   CuAssertIntEquals(tc, 5, findLoggedWrite(&fixture->log, 5, 6, fixture->fileA, 2u, 1));
+
+   CuAssertUIntEquals(tc, 2, fixture->fileManager.stats.numConflatedMessages);
+
+   batchFixture_destroy(fixture);
+   free(fixture);
+}
+
+/**
+ * more writes than the initial size of the batch array
+ */
+static void test_apx_fileManager_parseMessagesGrowBatch(CuTest* tc)
+{
+   batchFixture_t *fixture = (batchFixture_t*) malloc(sizeof(batchFixture_t));
+   int32_t i;
+   uint8_t expectedA[PORT_DATA_LEN];
+   CuAssertPtrNotNull(tc, fixture);
+   batchFixture_create(tc, fixture);
+
+   for (i=0; i<100; i++)
+   {
+      uint8_t data[2];
+      data[0] = (uint8_t) i;
+      data[1] = (uint8_t) (i+1);
+      batchFixture_addWrite(fixture, NODE_A_ADDRESS+(uint32_t) (i%4), false, data, sizeof(data));
+   }
+   CuAssertIntEquals(tc, 0, apx_fileManager_parseMessages(&fixture->fileManager, fixture->frames, fixture->numFrames));
+   CuAssertTrue(tc, fixture->fileManager.batchWritesLen >= 100);
+
+   memset(expectedA, 0, sizeof(expectedA));
+   expectedA[0] = 96;
+   expectedA[1] = 97;
+   expectedA[2] = 98;
+   expectedA[3] = 99;
+   expectedA[4] = 100;
+   CuAssertTrue(tc, memcmp(expectedA, fixture->outPortDataA, PORT_DATA_LEN) == 0);
+   CuAssertIntEquals(tc, 1, fixture->log.numWrites);
+   CuAssertIntEquals(tc, 0, findLoggedWrite(&fixture->log, 0, 1, fixture->fileA, 0u, 5));
+   CuAssertUIntEquals(tc, 99, fixture->fileManager.stats.numConflatedMessages);
+
+   batchFixture_destroy(fixture);
+   free(fixture);
+}
+
+static void batchFixture_create(CuTest* tc, batchFixture_t *fixture)
+{
+   memset(fixture, 0, sizeof(batchFixture_t));
+   CuAssertIntEquals(tc, 0, apx_fileManager_create(&fixture->fileManager, APX_FILEMANAGER_SERVER_MODE));
+   apx_nodeData_create(&fixture->nodeDataA, "NodeA", 0, 0, 0, 0, 0, fixture->outPortDataA, 0, PORT_DATA_LEN);
+   apx_nodeData_create(&fixture->nodeDataB, "NodeB", 0, 0, 0, 0, 0, fixture->outPortDataB, 0, PORT_DATA_LEN);
+   batchFixture_addFileInfo(fixture, "NodeA.out", NODE_A_ADDRESS, PORT_DATA_LEN);
+   batchFixture_addFileInfo(fixture, "NodeB.out", NODE_B_ADDRESS, PORT_DATA_LEN);
+   CuAssertIntEquals(tc, 0, apx_fileManager_parseMessages(&fixture->fileManager, fixture->frames, fixture->numFrames));
+   fixture->fileA = apx_fileManager_findRemoteFile(&fixture->fileManager, "NodeA.out");
+   fixture->fileB = apx_fileManager_findRemoteFile(&fixture->fileManager, "NodeB.out");
+   CuAssertPtrNotNull(tc, fixture->fileA);
+   CuAssertPtrNotNull(tc, fixture->fileB);
+   CuAssertUIntEquals(tc, APX_OUTDATA_FILE, fixture->fileA->fileType);
+   fixture->fileA->nodeData = &fixture->nodeDataA;
+   fixture->fileB->nodeData = &fixture->nodeDataB;
+   fixture->bufLen = 0;
+   fixture->numFrames = 0;
+   apx_fileManager_setRemoteFileWrittenSpy(remoteFileWrittenSpy, &fixture->log);
+}
+
+static void batchFixture_destroy(batchFixture_t *fixture)
+{
+   apx_fileManager_setRemoteFileWrittenSpy(0, 0);
+   apx_fileManager_destroy(&fixture->fileManager);
+   apx_nodeData_destroy(&fixture->nodeDataA);
+   apx_nodeData_destroy(&fixture->nodeDataB);
+}
+
+static void batchFixture_addWrite(batchFixture_t *fixture, uint32_t address, bool more_bit, const uint8_t *data, int32_t dataLen)
+{
+   uint8_t *msgBuf = &fixture->buf[fixture->bufLen];
+   int32_t headerLen = rmf_packHeader(msgBuf, (int32_t) sizeof(fixture->buf) - fixture->bufLen, address, more_bit);
+   assert( (headerLen > 0) && (fixture->numFrames < MAX_FRAMES) );
+   memcpy(&msgBuf[headerLen], data, dataLen);
+   fixture->frames[fixture->numFrames].msgBuf = msgBuf;
+   fixture->frames[fixture->numFrames].msgLen = headerLen + dataLen;
+   fixture->numFrames++;
+   fixture->bufLen += headerLen + dataLen;
+}
+
+static void batchFixture_addFileInfo(batchFixture_t *fixture, const char *name, uint32_t address, uint32_t length)
+{
+   rmf_fileInfo_t fileInfo;
+   uint8_t cmdBuf[RMF_MAX_CMD_BUF_SIZE];
+   int32_t cmdLen;
+   rmf_fileInfo_create(&fileInfo, name, address, length, RMF_FILE_TYPE_FIXED);
+   cmdLen = rmf_serialize_cmdFileInfo(cmdBuf, (int32_t) sizeof(cmdBuf), &fileInfo);
+   assert(cmdLen > 0);
+   batchFixture_addWrite(fixture, RMF_CMD_START_ADDR, false, cmdBuf, cmdLen);
+}
+
+static void remoteFileWrittenSpy(void *arg, apx_file_t *remoteFile, uint32_t offset, int32_t length)
+{
+   remoteFileWriteLog_t *log = (remoteFileWriteLog_t*) arg;
+   if (log->numWrites < MAX_LOGGED_WRITES)
+   {
+      remoteFileWrite_t *write = &log->writes[log->numWrites];
+      write->file = remoteFile;
+      write->offset = offset;
+      write->length = length;
+   }
+   log->numWrites++;
+}
+
+/**
+ * returns index of the logged write in the range begin..end-1 or -1 when not found
+ */
+static int32_t findLoggedWrite(const remoteFileWriteLog_t *log, int32_t begin, int32_t end, const apx_file_t *file, uint32_t offset, int32_t length)
+{
+   int32_t i;
+   for (i=begin; (i<end) && (i<log->numWrites) && (i<MAX_LOGGED_WRITES); i++)
+   {
+      const remoteFileWrite_t *write = &log->writes[i];
+      if ( (write->file == file) && (write->offset == offset) && (write->length == length) )
+      {
+         return i;
+      }
+   }
+   return -1;
+}
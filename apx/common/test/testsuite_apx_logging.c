@@ -0,0 +1,202 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include "CuTest.h"
+#include "apx_logging.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_CAPTURED_MESSAGES 48
+#define CAPTURED_MESSAGE_LEN 128
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_logging_encodeDecode(CuTest* tc);
+static void test_apx_logging_truncatedString(CuTest* tc);
+static void test_apx_logging_rateLimit(CuTest* tc);
+static void test_apx_logging_writerThread(CuTest* tc);
+static void test_apx_logging_flushBatches(CuTest* tc);
+static int32_t encodeDecode(char *dest, uint32_t destLen, uint32_t bufLen, const char *fmt, ...);
+static void captureHandler(uint8_t level, const char *msg);
+static void reentrantHandler(uint8_t level, const char *msg);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static int m_numCaptured;
+static uint8_t m_capturedLevel[NUM_CAPTURED_MESSAGES];
+static char m_captured[NUM_CAPTURED_MESSAGES][CAPTURED_MESSAGE_LEN];
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_logging(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_logging_encodeDecode);
+   SUITE_ADD_TEST(suite, test_apx_logging_truncatedString);
+   SUITE_ADD_TEST(suite, test_apx_logging_rateLimit);
+   SUITE_ADD_TEST(suite, test_apx_logging_writerThread);
+   SUITE_ADD_TEST(suite, test_apx_logging_flushBatches);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_logging_encodeDecode(CuTest* tc)
+{
+   char msg[128];
+   char expected[128];
+   char name[9];
+   int value = 5;
+   encodeDecode(msg, sizeof(msg), 200, "plain text");
+   CuAssertStrEquals(tc, "plain text", msg);
+   encodeDecode(msg, sizeof(msg), 200, "%d %u %08X %ld %c 100%%", -12, 34u, 0xABCDu, 1234567890L, 'z');
+   CuAssertStrEquals(tc, "-12 34 0000ABCD 1234567890 z 100%", msg);
+   encodeDecode(msg, sizeof(msg), 200, "[%s] [%-6s] [%.2s] [%s]", "node", "ab", "xyz", (const char*) 0);
+   CuAssertStrEquals(tc, "[node] [ab    ] [xy] [(null)]", msg);
+   encodeDecode(msg, sizeof(msg), 200, "%*d|%.3f|%hhx", 4, 7, 1.5, 0x1FF);
+   CuAssertStrEquals(tc, "   7|1.500|ff", msg);
+   //precision given as argument, the string is not null-terminated
+   memcpy(name, "SpeedXXXX", sizeof(name));
+   encodeDecode(msg, sizeof(msg), 200, "[%.*s] [%.*s] [%.*s]", 5, name, 20, "ab", -1, "cd");
+   CuAssertStrEquals(tc, "[Speed] [ab] [cd]", msg);
+   //a negative precision argument is taken as if the precision was omitted
+   encodeDecode(msg, sizeof(msg), 200, "%.*d|%.*f|%.*d", -1, 7, -1, 1.5, 3, 7);
+   CuAssertStrEquals(tc, "7|1.500000|007", msg);
+   encodeDecode(msg, sizeof(msg), 200, "%p", (void*) &value);
+   sprintf(expected, "%p", (void*) &value);
+   CuAssertStrEquals(tc, expected, msg);
+}
+
+static void test_apx_logging_truncatedString(CuTest* tc)
+{
+   char msg[128];
+   //argument buffer only has room for the first characters of the string
+   encodeDecode(msg, sizeof(msg), 8, "name=%s", "VehicleSpeed");
+   CuAssertStrEquals(tc, "name=Vehicl...", msg);
+   //second argument does not fit at all
+   encodeDecode(msg, sizeof(msg), 10, "%d,%d", 1, 2);
+   CuAssertStrEquals(tc, "1,...", msg);
+   //output buffer too small
+   encodeDecode(msg, 6, 200, "%s", "VehicleSpeed");
+   CuAssertStrEquals(tc, "Vehic", msg);
+}
+
+static void test_apx_logging_rateLimit(CuTest* tc)
+{
+   static apx_logSite_t site = APX_LOG_SITE_INIT(APX_LOG_LEVEL_WARNING, "message %d");
+   int i;
+   m_numCaptured = 0;
+   apx_log_setHandler(captureHandler);
+   for (i = 0; i < (int) (3*APX_LOG_RATE_LIMIT); i++)
+   {
+      apx_log_write(&site, "message %d", i);
+   }
+   apx_log_setHandler(0);
+   //allows for one change of second during the loop
+   CuAssertTrue(tc, m_numCaptured >= (int) APX_LOG_RATE_LIMIT);
+   CuAssertTrue(tc, m_numCaptured <= (int) (2*APX_LOG_RATE_LIMIT));
+   CuAssertStrEquals(tc, "message 0", m_captured[0]);
+}
+
+static void test_apx_logging_writerThread(CuTest* tc)
+{
+   static apx_logSite_t site1 = APX_LOG_SITE_INIT(APX_LOG_LEVEL_ERROR, "[%s] error %d");
+   static apx_logSite_t site2 = APX_LOG_SITE_INIT(APX_LOG_LEVEL_INFO, "value=%u");
+   uint8_t level = apx_log_getLevel();
+   apx_log_setLevel(APX_LOG_LEVEL_DEBUG);
+   CuAssertUIntEquals(tc, APX_LOG_LEVEL_DEBUG, apx_log_getLevel());
+   apx_log_setLevel(level);
+   m_numCaptured = 0;
+   apx_log_setHandler(captureHandler);
+   CuAssertIntEquals(tc, 0, apx_log_start());
+   apx_log_write(&site1, "[%s] error %d", "APX_SERVER", 3);
+   apx_log_write(&site2, "value=%u", 42u);
+   apx_log_stop();
+   apx_log_setHandler(0);
+   CuAssertIntEquals(tc, 2, m_numCaptured);
+   CuAssertUIntEquals(tc, APX_LOG_LEVEL_ERROR, m_capturedLevel[0]);
+   CuAssertStrEquals(tc, "[APX_SERVER] error 3", m_captured[0]);
+   CuAssertUIntEquals(tc, APX_LOG_LEVEL_INFO, m_capturedLevel[1]);
+   CuAssertStrEquals(tc, "value=42", m_captured[1]);
+}
+
+static void test_apx_logging_flushBatches(CuTest* tc)
+{
+   static apx_logSite_t site1 = APX_LOG_SITE_INIT(APX_LOG_LEVEL_ERROR, "message %d");
+   static apx_logSite_t site2 = APX_LOG_SITE_INIT(APX_LOG_LEVEL_ERROR, "message %d");
+   int i;
+   char expected[CAPTURED_MESSAGE_LEN];
+   m_numCaptured = 0;
+   //the handler logs a message itself, this must not deadlock the writer thread
+   apx_log_setHandler(reentrantHandler);
+   CuAssertIntEquals(tc, 0, apx_log_start());
+   //more messages than fit in one flush batch, spread over two sites to stay below the rate limit
+   for (i = 0; i < 40; i++)
+   {
+      apx_log_write( ( (i & 1) == 0)? &site1 : &site2, "message %d", i);
+   }
+   apx_log_stop();
+   apx_log_setHandler(0);
+   CuAssertIntEquals(tc, 41, m_numCaptured);
+   for (i = 0; i < 40; i++)
+   {
+      sprintf(expected, "message %d", i);
+      CuAssertStrEquals(tc, expected, m_captured[i]);
+   }
+   CuAssertStrEquals(tc, "logged by handler", m_captured[40]);
+}
+
+static int32_t encodeDecode(char *dest, uint32_t destLen, uint32_t bufLen, const char *fmt, ...)
+{
+   uint8_t buf[200];
+   int32_t len;
+   va_list args;
+   assert(bufLen <= sizeof(buf));
+   va_start(args, fmt);
+   len = apx_log_encodeArgs(buf, bufLen, fmt, args);
+   va_end(args);
+   return apx_log_decodeArgs(dest, destLen, fmt, buf, (uint32_t) len);
+}
+
+static void captureHandler(uint8_t level, const char *msg)
+{
+   if (m_numCaptured < NUM_CAPTURED_MESSAGES)
+   {
+      m_capturedLevel[m_numCaptured] = level;
+      strncpy(m_captured[m_numCaptured], msg, CAPTURED_MESSAGE_LEN-1);
+      m_captured[m_numCaptured][CAPTURED_MESSAGE_LEN-1] = 0;
+   }
+   m_numCaptured++;
+}
+
+static void reentrantHandler(uint8_t level, const char *msg)
+{
+   static apx_logSite_t site = APX_LOG_SITE_INIT(APX_LOG_LEVEL_ERROR, "logged by handler");
+   captureHandler(level, msg);
+   if (strcmp(msg, "message 39") == 0)
+   {
+      apx_log_write(&site, "logged by handler");
+   }
+}
@@ -34,6 +34,7 @@ static void test_apx_node_initValue_U32_array(CuTest* tc);
 static void test_apx_node_initValue_S8_array(CuTest* tc);
 static void test_apx_node_initValue_S16_array(CuTest* tc);
 static void test_apx_node_initValue_S32_array(CuTest* tc);
+static void test_apx_node_initData_image(CuTest* tc);
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -67,6 +68,7 @@ CuSuite* testSuite_apx_node(void)
    SUITE_ADD_TEST(suite, test_apx_node_initValue_S8_array);
    SUITE_ADD_TEST(suite, test_apx_node_initValue_S16_array);
    SUITE_ADD_TEST(suite, test_apx_node_initValue_S32_array);
+   SUITE_ADD_TEST(suite, test_apx_node_initData_image);
 
 
    return suite;
@@ -650,3 +652,35 @@ static void test_apx_node_initValue_S32_array(CuTest* tc)
    CuAssertIntEquals(tc, APX_NO_ERROR, apx_getLastError());
    apx_node_destroy(&node);
 }
+
+static void test_apx_node_initData_image(CuTest* tc)
+{
+   apx_node_t node;
+   const uint8_t *data;
+   apx_clearError();
+   apx_node_create(&node,"Test");
+   apx_node_createRequirePort(&node,"U8Signal","C","=7");
+   apx_node_createRequirePort(&node,"U16Signal","S",0);
+   apx_node_createRequirePort(&node,"U16Array","S[2]","={0x1234, 0xFFFF}");
+   apx_node_createProvidePort(&node,"S8Signal","c","=-1");
+   CuAssertUIntEquals(tc, 0, apx_node_getInPortDataLen(&node));
+   CuAssertIntEquals(tc, 0, apx_node_finalize(&node));
+
+   CuAssertUIntEquals(tc, 7, apx_node_getInPortDataLen(&node));
+   data = apx_node_getInPortInitData(&node);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertUIntEquals(tc, 7, data[0]);
+   CuAssertUIntEquals(tc, 0, data[1]);
+   CuAssertUIntEquals(tc, 0, data[2]);
+   CuAssertUIntEquals(tc, 0x34, data[3]);
+   CuAssertUIntEquals(tc, 0x12, data[4]);
+   CuAssertUIntEquals(tc, 0xFF, data[5]);
+   CuAssertUIntEquals(tc, 0xFF, data[6]);
+
+   CuAssertUIntEquals(tc, 1, apx_node_getOutPortDataLen(&node));
+   data = apx_node_getOutPortInitData(&node);
+   CuAssertPtrNotNull(tc, data);
+   CuAssertUIntEquals(tc, 0xFF, data[0]);
+   CuAssertIntEquals(tc, APX_NO_ERROR, apx_getLastError());
+   apx_node_destroy(&node);
+}
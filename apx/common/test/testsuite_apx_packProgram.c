@@ -0,0 +1,337 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_packProgram.h"
+#include "apx_dataSignature.h"
+
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_packProgram_compile_scalar(CuTest* tc);
+static void test_apx_packProgram_compile_mergeRecordFields(CuTest* tc);
+static void test_apx_packProgram_compile_recordArray(CuTest* tc);
+static void test_apx_packProgram_pack_U16_array(CuTest* tc);
+static void test_apx_packProgram_pack_record(CuTest* tc);
+static void test_apx_packProgram_pack_recordArray(CuTest* tc);
+static void test_apx_packProgram_pack_lengthError(CuTest* tc);
+static void test_apx_packProgram_unpack_record(CuTest* tc);
+static void test_apx_packProgram_unpack_inPlace(CuTest* tc);
+static void test_apx_packProgram_unpack_recordArray(CuTest* tc);
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_packProgram(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_packProgram_compile_scalar);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_compile_mergeRecordFields);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_compile_recordArray);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_pack_U16_array);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_pack_record);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_pack_recordArray);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_pack_lengthError);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_unpack_record);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_unpack_inPlace);
+   SUITE_ADD_TEST(suite, test_apx_packProgram_unpack_recordArray);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_apx_packProgram_compile_scalar(CuTest* tc)
+{
+   apx_dataSignature_t *dsg = apx_dataSignature_new("s(-100,100)");
+   apx_packProgram_t *program;
+   CuAssertPtrNotNull(tc, dsg);
+   program = &dsg->packProgram;
+   CuAssertIntEquals(tc, 1, program->numInstructions);
+   CuAssertUIntEquals(tc, 2, program->packLen);
+   CuAssertIntEquals(tc, APX_PACK_OP_SINT, program->instructions[0].opcode);
+   CuAssertIntEquals(tc, 2, program->instructions[0].width);
+   CuAssertUIntEquals(tc, 0, program->instructions[0].count);
+   CuAssertUIntEquals(tc, 1, program->instructions[0].repeat);
+   apx_dataSignature_delete(dsg);
+}
+
+static void test_apx_packProgram_compile_mergeRecordFields(CuTest* tc)
+{
+   apx_dataSignature_t *dsg = apx_dataSignature_new("{\"a\"C\"b\"C\"c\"C\"d\"S\"e\"S\"f\"C[2]\"g\"C[2]\"h\"a[4]}");
+   apx_packProgram_t *program;
+   CuAssertPtrNotNull(tc, dsg);
+   program = &dsg->packProgram;
+   CuAssertIntEquals(tc, 6, program->numInstructions);
+   CuAssertUIntEquals(tc, 3+4+4+4, program->packLen);
+   CuAssertUIntEquals(tc, apx_dataSignature_packLen(dsg), program->packLen);
+   CuAssertIntEquals(tc, APX_PACK_OP_RECORD_BEGIN, program->instructions[0].opcode);
+   CuAssertUIntEquals(tc, 8, program->instructions[0].count);
+   CuAssertIntEquals(tc, APX_PACK_OP_UINT, program->instructions[1].opcode);
+   CuAssertUIntEquals(tc, 3, program->instructions[1].repeat);
+   CuAssertUIntEquals(tc, 0, program->instructions[1].offset);
+   CuAssertIntEquals(tc, APX_PACK_OP_UINT, program->instructions[2].opcode);
+   CuAssertIntEquals(tc, 2, program->instructions[2].width);
+   CuAssertUIntEquals(tc, 2, program->instructions[2].repeat);
+   CuAssertUIntEquals(tc, 3, program->instructions[2].offset);
+   CuAssertIntEquals(tc, APX_PACK_OP_UINT, program->instructions[3].opcode);
+   CuAssertUIntEquals(tc, 2, program->instructions[3].count);
+   CuAssertUIntEquals(tc, 2, program->instructions[3].repeat);
+   CuAssertUIntEquals(tc, 7, program->instructions[3].offset);
+   CuAssertIntEquals(tc, APX_PACK_OP_STRING, program->instructions[4].opcode);
+   CuAssertUIntEquals(tc, 11, program->instructions[4].offset);
+   CuAssertIntEquals(tc, APX_PACK_OP_RECORD_END, program->instructions[5].opcode);
+   apx_dataSignature_delete(dsg);
+}
+
+static void test_apx_packProgram_compile_recordArray(CuTest* tc)
+{
+   apx_dataElement_t *rootElement;
+   apx_dataElement_t *childElem;
+   apx_packProgram_t program;
+
+   //DSG: {LC[3]}[2]
+   rootElement = apx_dataElement_new(APX_BASE_TYPE_RECORD, 0);
+   apx_dataElement_appendChild(rootElement, apx_dataElement_new(APX_BASE_TYPE_UINT32, 0));
+   childElem = apx_dataElement_new(APX_BASE_TYPE_UINT8, 0);
+   apx_dataElement_setArrayLen(childElem, 3);
+   apx_dataElement_appendChild(rootElement, childElem);
+   apx_dataElement_setArrayLen(rootElement, 2);
+
+   apx_packProgram_create(&program);
+   CuAssertIntEquals(tc, 0, apx_packProgram_compile(&program, rootElement));
+   CuAssertIntEquals(tc, 6, program.numInstructions);
+   CuAssertUIntEquals(tc, (4+3)*2, program.packLen);
+   CuAssertIntEquals(tc, APX_PACK_OP_ARRAY_BEGIN, program.instructions[0].opcode);
+   CuAssertIntEquals(tc, APX_PACK_OP_RECORD_BEGIN, program.instructions[1].opcode);
+   CuAssertIntEquals(tc, APX_PACK_OP_ARRAY_END, program.instructions[5].opcode);
+   CuAssertIntEquals(tc, 1, program.instructions[5].jump);
+   CuAssertIntEquals(tc, 3, program.maxDepth);
+   apx_packProgram_destroy(&program);
+   apx_dataElement_delete(rootElement);
+}
+
+static void test_apx_packProgram_pack_U16_array(CuTest* tc)
+{
+   apx_dataSignature_t *dsg = apx_dataSignature_new("S[3]");
+   uint8_t buf[6];
+   uint8_t *pResult;
+   dtl_av_t *av;
+   CuAssertPtrNotNull(tc, dsg);
+   av = dtl_av_new();
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(0x1234));
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(0xFFFF));
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(1));
+   pResult = apx_dataSignature_pack_dv(dsg, &buf[0], &buf[0]+sizeof(buf), (dtl_dv_t*) av);
+   CuAssertPtrEquals(tc, &buf[0]+sizeof(buf), pResult);
+   CuAssertIntEquals(tc, 0x34, buf[0]);
+   CuAssertIntEquals(tc, 0x12, buf[1]);
+   CuAssertIntEquals(tc, 0xFF, buf[2]);
+   CuAssertIntEquals(tc, 0xFF, buf[3]);
+   CuAssertIntEquals(tc, 0x01, buf[4]);
+   CuAssertIntEquals(tc, 0x00, buf[5]);
+   dtl_av_delete(av);
+   apx_dataSignature_delete(dsg);
+}
+
+static void test_apx_packProgram_pack_record(CuTest* tc)
+{
+   apx_dataSignature_t *dsg = apx_dataSignature_new("{\"a\"C\"b\"C\"c\"s\"d\"a[4]}");
+   uint8_t buf[8];
+   uint8_t *pResult;
+   dtl_av_t *av;
+   CuAssertPtrNotNull(tc, dsg);
+   memset(buf, 0xAA, sizeof(buf));
+   av = dtl_av_new();
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(1));
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(2));
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_i32(-2));
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_cstr("ab"));
+   pResult = apx_dataSignature_pack_dv(dsg, &buf[0], &buf[0]+sizeof(buf), (dtl_dv_t*) av);
+   CuAssertPtrEquals(tc, &buf[0]+sizeof(buf), pResult);
+   CuAssertIntEquals(tc, 1, buf[0]);
+   CuAssertIntEquals(tc, 2, buf[1]);
+   CuAssertIntEquals(tc, 0xFE, buf[2]);
+   CuAssertIntEquals(tc, 0xFF, buf[3]);
+   CuAssertIntEquals(tc, 'a', buf[4]);
+   CuAssertIntEquals(tc, 'b', buf[5]);
+   CuAssertIntEquals(tc, 0, buf[6]);
+   CuAssertIntEquals(tc, 0, buf[7]);
+   dtl_av_delete(av);
+   apx_dataSignature_delete(dsg);
+}
+
+static void test_apx_packProgram_pack_recordArray(CuTest* tc)
+{
+   apx_dataElement_t *rootElement;
+   apx_dataElement_t *childElem;
+   apx_packProgram_t program;
+   uint8_t buf[14];
+   uint8_t *pResult;
+   dtl_av_t *av;
+   int32_t i;
+
+   //DSG: {LC[3]}[2]
+   rootElement = apx_dataElement_new(APX_BASE_TYPE_RECORD, 0);
+   apx_dataElement_appendChild(rootElement, apx_dataElement_new(APX_BASE_TYPE_UINT32, 0));
+   childElem = apx_dataElement_new(APX_BASE_TYPE_UINT8, 0);
+   apx_dataElement_setArrayLen(childElem, 3);
+   apx_dataElement_appendChild(rootElement, childElem);
+   apx_dataElement_setArrayLen(rootElement, 2);
+   apx_packProgram_create(&program);
+   CuAssertIntEquals(tc, 0, apx_packProgram_compile(&program, rootElement));
+
+   //{{0x12345678, {1,2,3}}, {0x12345678, {4,5,6}}
+   av = dtl_av_new();
+   for (i = 0; i < 2; i++)
+   {
+      dtl_av_t *record = dtl_av_new();
+      dtl_av_t *bytes = dtl_av_new();
+      dtl_av_push(record, (dtl_dv_t*) dtl_sv_make_u32(0x12345678));
+      dtl_av_push(bytes, (dtl_dv_t*) dtl_sv_make_i32(i*3+1));
+      dtl_av_push(bytes, (dtl_dv_t*) dtl_sv_make_i32(i*3+2));
+      dtl_av_push(bytes, (dtl_dv_t*) dtl_sv_make_i32(i*3+3));
+      dtl_av_push(record, (dtl_dv_t*) bytes);
+      dtl_av_push(av, (dtl_dv_t*) record);
+   }
+   pResult = apx_packProgram_pack_dv(&program, &buf[0], &buf[0]+sizeof(buf), (dtl_dv_t*) av);
+   CuAssertPtrEquals(tc, &buf[0]+sizeof(buf), pResult);
+   CuAssertIntEquals(tc, 0x78, buf[0]);
+   CuAssertIntEquals(tc, 0x12, buf[3]);
+   CuAssertIntEquals(tc, 1, buf[4]);
+   CuAssertIntEquals(tc, 2, buf[5]);
+   CuAssertIntEquals(tc, 3, buf[6]);
+   CuAssertIntEquals(tc, 0x78, buf[7]);
+   CuAssertIntEquals(tc, 0x12, buf[10]);
+   CuAssertIntEquals(tc, 4, buf[11]);
+   CuAssertIntEquals(tc, 5, buf[12]);
+   CuAssertIntEquals(tc, 6, buf[13]);
+   dtl_av_delete(av);
+   apx_packProgram_destroy(&program);
+   apx_dataElement_delete(rootElement);
+}
+
+static void test_apx_packProgram_pack_lengthError(CuTest* tc)
+{
+   apx_dataSignature_t *dsg = apx_dataSignature_new("C[3]");
+   uint8_t buf[3];
+   dtl_av_t *av;
+   CuAssertPtrNotNull(tc, dsg);
+   av = dtl_av_new();
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(1));
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(2));
+   apx_clearError();
+   CuAssertPtrEquals(tc, 0, apx_dataSignature_pack_dv(dsg, &buf[0], &buf[0]+sizeof(buf), (dtl_dv_t*) av));
+   CuAssertIntEquals(tc, APX_LENGTH_ERROR, apx_getLastError());
+   dtl_av_push(av, (dtl_dv_t*) dtl_sv_make_u32(3));
+   CuAssertPtrEquals(tc, 0, apx_dataSignature_pack_dv(dsg, &buf[0], &buf[0]+2, (dtl_dv_t*) av));
+   CuAssertPtrEquals(tc, &buf[0]+sizeof(buf), apx_dataSignature_pack_dv(dsg, &buf[0], &buf[0]+sizeof(buf), (dtl_dv_t*) av));
+   dtl_av_delete(av);
+   apx_dataSignature_delete(dsg);
+}
+
+static void test_apx_packProgram_unpack_record(CuTest* tc)
+{
+   apx_dataSignature_t *dsg = apx_dataSignature_new("{\"a\"C\"b\"s\"c\"L[2]\"d\"a[4]}");
+   const uint8_t buf[] = {0x07, 0xFE, 0xFF, 0x01, 0x00, 0x00, 0x00, 0x78, 0x56, 0x34, 0x12, 'a', 'b', 'c', 0};
+   const uint8_t *pResult;
+   dtl_dv_t *dv = 0;
+   dtl_av_t *av;
+   dtl_av_t *av2;
+   CuAssertPtrNotNull(tc, dsg);
+   pResult = apx_dataSignature_unpack_dv(dsg, &buf[0], &buf[0]+sizeof(buf), &dv);
+   CuAssertPtrEquals(tc, (void*) (&buf[0]+sizeof(buf)), (void*) pResult);
+   CuAssertPtrNotNull(tc, dv);
+   CuAssertIntEquals(tc, DTL_DV_ARRAY, dtl_dv_type(dv));
+   av = (dtl_av_t*) dv;
+   CuAssertIntEquals(tc, 4, dtl_av_length(av));
+   CuAssertUIntEquals(tc, 7, dtl_sv_get_u32((dtl_sv_t*) *dtl_av_get(av, 0)));
+   CuAssertIntEquals(tc, -2, dtl_sv_get_i32((dtl_sv_t*) *dtl_av_get(av, 1)));
+   av2 = (dtl_av_t*) *dtl_av_get(av, 2);
+   CuAssertIntEquals(tc, 2, dtl_av_length(av2));
+   CuAssertUIntEquals(tc, 1, dtl_sv_get_u32((dtl_sv_t*) *dtl_av_get(av2, 0)));
+   CuAssertUIntEquals(tc, 0x12345678, dtl_sv_get_u32((dtl_sv_t*) *dtl_av_get(av2, 1)));
+   CuAssertStrEquals(tc, "abc", dtl_sv_get_cstr((dtl_sv_t*) *dtl_av_get(av, 3)));
+   dtl_dv_delete(dv);
+   apx_dataSignature_delete(dsg);
+}
+
+static void test_apx_packProgram_unpack_inPlace(CuTest* tc)
+{
+   apx_dataSignature_t *dsg = apx_dataSignature_new("{\"a\"C\"b\"S}");
+   uint8_t buf[3] = {1, 2, 0};
+   dtl_dv_t *dv = 0;
+   dtl_dv_t *first;
+   dtl_av_t *av;
+   CuAssertPtrNotNull(tc, dsg);
+   CuAssertPtrNotNull(tc, apx_dataSignature_unpack_dv(dsg, &buf[0], &buf[0]+sizeof(buf), &dv));
+   av = (dtl_av_t*) dv;
+   first = *dtl_av_get(av, 0);
+   buf[0] = 10;
+   buf[1] = 0x34;
+   buf[2] = 0x12;
+   CuAssertPtrNotNull(tc, apx_dataSignature_unpack_dv(dsg, &buf[0], &buf[0]+sizeof(buf), &dv));
+   CuAssertPtrEquals(tc, av, dv);
+   CuAssertPtrEquals(tc, first, *dtl_av_get(av, 0));
+   CuAssertUIntEquals(tc, 10, dtl_sv_get_u32((dtl_sv_t*) *dtl_av_get(av, 0)));
+   CuAssertUIntEquals(tc, 0x1234, dtl_sv_get_u32((dtl_sv_t*) *dtl_av_get(av, 1)));
+   dtl_dv_delete(dv);
+   apx_dataSignature_delete(dsg);
+}
+
+static void test_apx_packProgram_unpack_recordArray(CuTest* tc)
+{
+   apx_dataElement_t *rootElement;
+   apx_packProgram_t program;
+   const uint8_t buf[] = {1, 2, 0, 3, 4, 0};
+   dtl_dv_t *dv = 0;
+   dtl_av_t *record;
+   uint8_t packed[6];
+
+   //DSG: {CS}[2]
+   rootElement = apx_dataElement_new(APX_BASE_TYPE_RECORD, 0);
+   apx_dataElement_appendChild(rootElement, apx_dataElement_new(APX_BASE_TYPE_UINT8, 0));
+   apx_dataElement_appendChild(rootElement, apx_dataElement_new(APX_BASE_TYPE_UINT16, 0));
+   apx_dataElement_setArrayLen(rootElement, 2);
+   apx_packProgram_create(&program);
+   CuAssertIntEquals(tc, 0, apx_packProgram_compile(&program, rootElement));
+   CuAssertPtrEquals(tc, (void*) (&buf[0]+sizeof(buf)), (void*) apx_packProgram_unpack_dv(&program, &buf[0], &buf[0]+sizeof(buf), &dv));
+   CuAssertIntEquals(tc, 2, dtl_av_length((dtl_av_t*) dv));
+   record = (dtl_av_t*) *dtl_av_get((dtl_av_t*) dv, 1);
+   CuAssertUIntEquals(tc, 3, dtl_sv_get_u32((dtl_sv_t*) *dtl_av_get(record, 0)));
+   CuAssertUIntEquals(tc, 4, dtl_sv_get_u32((dtl_sv_t*) *dtl_av_get(record, 1)));
+   CuAssertPtrEquals(tc, &packed[0]+sizeof(packed), apx_packProgram_pack_dv(&program, &packed[0], &packed[0]+sizeof(packed), dv));
+   CuAssertIntEquals(tc, 0, memcmp(buf, packed, sizeof(buf)));
+   dtl_dv_delete(dv);
+   apx_packProgram_destroy(&program);
+   apx_dataElement_delete(rootElement);
+}
@@ -28,6 +28,7 @@
 static void test_apx_parser_file(CuTest* tc);
 static void test_apx_parser_fileWithErrorErrors(CuTest* tc);
 static void test_apx_parser_fileWithInitValues(CuTest* tc);
+static void test_apx_parser_nodeReserveLens(CuTest* tc);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -50,6 +51,7 @@ CuSuite* testSuite_apx_parser(void)
    SUITE_ADD_TEST(suite, test_apx_parser_file);
    SUITE_ADD_TEST(suite, test_apx_parser_fileWithErrorErrors);
    SUITE_ADD_TEST(suite, test_apx_parser_fileWithInitValues);
+   SUITE_ADD_TEST(suite, test_apx_parser_nodeReserveLens);
 
    return suite;
 }
@@ -111,3 +113,57 @@ static void test_apx_parser_fileWithInitValues(CuTest* tc)
 
    apx_parser_destroy(&parser);
 }
+
+static void test_apx_parser_nodeReserveLens(CuTest* tc)
+{
+   apx_parser_t parser;
+   apx_node_t *node;
+   const char *smallNode = "N\"Small\"\nR\"A\"C\n";
+   char *definition;
+   uint32_t definitionLen;
+   uint32_t largeNodeLen;
+   int32_t i;
+   apx_arenaChunk_t *chunk;
+   definition = (char*) malloc(20000);
+   CuAssertPtrNotNull(tc, definition);
+   strcpy(definition, "APX/1.2\n");
+   strcat(definition, smallNode);
+   strcat(definition, "N\"Large\"\n");
+   for (i=0; i<500; i++)
+   {
+      sprintf(definition+strlen(definition), "P\"Port%03d\"S\n", (int) i);
+   }
+   definitionLen = (uint32_t) strlen(definition);
+   largeNodeLen = definitionLen - (uint32_t) strlen("APX/1.2\n") - (uint32_t) strlen(smallNode);
+   apx_parser_create(&parser);
+   CuAssertIntEquals(tc, 0, apx_parser_setNodeReserveLens(&parser, (const uint8_t*) definition, definitionLen));
+   CuAssertIntEquals(tc, 2, parser.numNodeReserveLens);
+   CuAssertUIntEquals(tc, (uint32_t) strlen(smallNode), parser.nodeReserveLens[0]);
+   CuAssertUIntEquals(tc, largeNodeLen, parser.nodeReserveLens[1]);
+   apx_parser_open(&parser);
+   apx_parser_node(&parser, "Small");
+   apx_parser_require(&parser, "A", "C", 0);
+   apx_parser_node(&parser, "Large");
+   for (i=0; i<500; i++)
+   {
+      char name[10];
+      sprintf(name, "Port%03d", (int) i);
+      apx_parser_provide(&parser, name, "S", 0);
+   }
+   apx_parser_close(&parser);
+   CuAssertIntEquals(tc, 2, apx_parser_getNumNodes(&parser));
+   CuAssertPtrEquals(tc, 0, parser.nodeReserveLens);
+   //each node reserves arena memory for its own part of the definition only
+   node = apx_parser_getNode(&parser, 0);
+   CuAssertUIntEquals(tc, 1, apx_arena_getNumChunks(&node->arena));
+   CuAssertTrue(tc, node->arena.head->size < definitionLen);
+   node = apx_parser_getNode(&parser, 1);
+   chunk = node->arena.head;
+   while (chunk->next != 0)
+   {
+      chunk = chunk->next;
+   }
+   CuAssertTrue(tc, chunk->size >= largeNodeLen*2u);
+   apx_parser_destroy(&parser);
+   free(definition);
+}
@@ -67,14 +67,14 @@ static void test_apx_portDataMap_create(CuTest* tc)
    CuAssertPtrNotNull(tc,node);
    apx_portDataMap_build(&dataMap,node,APX_REQUIRE_PORT);
 
-   CuAssertIntEquals(tc,2,adt_ary_length(&dataMap.elements));
+   CuAssertIntEquals(tc,2,apx_portDataMap_getNumEntries(&dataMap));
 
-   entry = (apx_portDataMapEntry_t*) *(adt_ary_get(&dataMap.elements,0));
+   entry = apx_portDataMap_getEntry(&dataMap,0);
    CuAssertStrEquals(tc,"WheelBasedVehicleSpeed",entry->port->name);
    CuAssertIntEquals(tc,0,entry->offset);
    CuAssertIntEquals(tc,2,entry->length);
 
-   entry = (apx_portDataMapEntry_t*) *(adt_ary_get(&dataMap.elements,1));
+   entry = apx_portDataMap_getEntry(&dataMap,1);
    CuAssertStrEquals(tc,"CabTiltLockWarning",entry->port->name);
    CuAssertIntEquals(tc,2,entry->offset);
    CuAssertIntEquals(tc,1,entry->length);
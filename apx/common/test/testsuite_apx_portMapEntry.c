@@ -22,6 +22,7 @@
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void test_apx_routerPortMapEntry_create(CuTest* tc);
+static void test_apx_routerPortMapEntry_removePort(CuTest* tc);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -42,6 +43,7 @@ CuSuite* testSuite_apx_routerPortMapEntry(void)
    CuSuite* suite = CuSuiteNew();
 
    SUITE_ADD_TEST(suite, test_apx_routerPortMapEntry_create);
+   SUITE_ADD_TEST(suite, test_apx_routerPortMapEntry_removePort);
 
    return suite;
 }
@@ -75,16 +77,16 @@ static void test_apx_routerPortMapEntry_create(CuTest* tc)
    apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node3,0);
    apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node4,0);
    apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node5,0);
-   CuAssertIntEquals(tc, 2, adt_ary_length(&portMapEntry.providePorts));
-   CuAssertIntEquals(tc, 3, adt_ary_length(&portMapEntry.requirePorts));
+   CuAssertIntEquals(tc, 2, apx_routerPortMapEntry_getNumProvidePorts(&portMapEntry));
+   CuAssertIntEquals(tc, 3, apx_routerPortMapEntry_getNumRequirePorts(&portMapEntry));
    //test that it prevents duplicate items
    apx_routerPortMapEntry_insertProvidePort(&portMapEntry,&node1,0);
    apx_routerPortMapEntry_insertProvidePort(&portMapEntry,&node2,0);
    apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node3,0);
    apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node4,0);
    apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node5,0);
-   CuAssertIntEquals(tc, 2, adt_ary_length(&portMapEntry.providePorts));
-   CuAssertIntEquals(tc, 3, adt_ary_length(&portMapEntry.requirePorts));
+   CuAssertIntEquals(tc, 2, apx_routerPortMapEntry_getNumProvidePorts(&portMapEntry));
+   CuAssertIntEquals(tc, 3, apx_routerPortMapEntry_getNumRequirePorts(&portMapEntry));
 
    apx_routerPortMapEntry_destroy(&portMapEntry);
    apx_node_destroy(&node1);
@@ -95,4 +97,74 @@ static void test_apx_routerPortMapEntry_create(CuTest* tc)
 
 }
 
+static void test_apx_routerPortMapEntry_removePort(CuTest* tc)
+{
+   apx_routerPortMapEntry_t portMapEntry;
+   apx_node_t node1;
+   apx_node_t node2;
+   apx_node_t node3;
+   apx_node_t node4;
+   apx_node_t node5;
+   apx_port_t *provider1;
+   apx_port_t *provider2;
+   apx_port_t *requester3;
+   apx_port_t *requester4;
+   apx_port_t *requester5;
+   int32_t handle;
+
+   apx_node_create(&node1, "test1");
+   apx_node_create(&node2, "test2");
+   apx_node_create(&node3, "test3");
+   apx_node_create(&node4, "test4");
+   apx_node_create(&node5, "test5");
+   provider1 = apx_node_createProvidePort(&node1, "WheelBasedVehicleSpeed", "S", 0);
+   provider2 = apx_node_createProvidePort(&node2, "WheelBasedVehicleSpeed", "S", 0);
+   requester3 = apx_node_createRequirePort(&node3, "WheelBasedVehicleSpeed", "S", 0);
+   requester4 = apx_node_createRequirePort(&node4, "WheelBasedVehicleSpeed", "S", 0);
+   requester5 = apx_node_createRequirePort(&node5, "WheelBasedVehicleSpeed", "S", 0);
+   apx_routerPortMapEntry_create(&portMapEntry);
+   CuAssertPtrEquals(tc, 0, apx_routerPortMapEntry_getActiveProvider(&portMapEntry));
+
+   apx_routerPortMapEntry_insertProvidePort(&portMapEntry,&node1,0);
+   apx_routerPortMapEntry_insertProvidePort(&portMapEntry,&node2,0);
+   apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node3,0);
+   apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node4,0);
+   apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node5,0);
+   CuAssertPtrEquals(tc, provider2, apx_routerPortMapEntry_getActiveProvider(&portMapEntry)->port);
+
+   //removing a port keeps the handles of the other ports
+   handle = requester5->portMapHandle;
+   CuAssertIntEquals(tc, 0, apx_routerPortMapEntry_removePort(&portMapEntry,&node4,requester4));
+   CuAssertIntEquals(tc, 2, apx_routerPortMapEntry_getNumRequirePorts(&portMapEntry));
+   CuAssertIntEquals(tc, APX_PORT_MAP_INVALID_HANDLE, requester4->portMapHandle);
+   CuAssertIntEquals(tc, handle, requester5->portMapHandle);
+   CuAssertPtrEquals(tc, requester5, apx_routerPortMapEntry_getRequirePortById(&portMapEntry, handle)->port);
+   handle = apx_routerPortMapEntry_firstRequirePort(&portMapEntry);
+   CuAssertPtrEquals(tc, requester3, apx_routerPortMapEntry_getRequirePortById(&portMapEntry, handle)->port);
+   handle = apx_routerPortMapEntry_nextRequirePort(&portMapEntry, handle);
+   CuAssertPtrEquals(tc, requester5, apx_routerPortMapEntry_getRequirePortById(&portMapEntry, handle)->port);
+   handle = apx_routerPortMapEntry_nextRequirePort(&portMapEntry, handle);
+   CuAssertIntEquals(tc, APX_PORT_MAP_INVALID_HANDLE, handle);
+   //removing a port twice is harmless
+   CuAssertIntEquals(tc, 0, apx_routerPortMapEntry_removePort(&portMapEntry,&node4,requester4));
+   CuAssertIntEquals(tc, 2, apx_routerPortMapEntry_getNumRequirePorts(&portMapEntry));
+   //the free slot is reused
+   apx_routerPortMapEntry_insertRequirePort(&portMapEntry,&node4,0);
+   CuAssertIntEquals(tc, 3, apx_routerPortMapEntry_getNumRequirePorts(&portMapEntry));
+   CuAssertTrue(tc, requester4->portMapHandle < 3);
+
+   //the active provider falls back to the previous provider
+   apx_routerPortMapEntry_removePort(&portMapEntry,&node2,provider2);
+   CuAssertIntEquals(tc, 1, apx_routerPortMapEntry_getNumProvidePorts(&portMapEntry));
+   CuAssertPtrEquals(tc, provider1, apx_routerPortMapEntry_getActiveProvider(&portMapEntry)->port);
+   apx_routerPortMapEntry_removePort(&portMapEntry,&node1,provider1);
+   CuAssertPtrEquals(tc, 0, apx_routerPortMapEntry_getActiveProvider(&portMapEntry));
+
+   apx_routerPortMapEntry_destroy(&portMapEntry);
+   apx_node_destroy(&node1);
+   apx_node_destroy(&node2);
+   apx_node_destroy(&node3);
+   apx_node_destroy(&node4);
+   apx_node_destroy(&node5);
+}
 
@@ -27,6 +27,7 @@
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void test_apx_router_create(CuTest* tc);
+static void test_apx_router_detachNodeInfos(CuTest* tc);
 //static int create_test_nodes(apx_node_t *nodeList, apx_nodeInfo_t *nodeInfoList, apx_port_t **ports, int maxNumNodes);
 //static void destroy_test_nodes(apx_node_t *nodeList, apx_nodeInfo_t *nodeInfoList, int numNodes);
 
@@ -49,6 +50,7 @@ CuSuite* testSuite_apx_router(void)
    CuSuite* suite = CuSuiteNew();
 
    SUITE_ADD_TEST(suite, test_apx_router_create);
+   SUITE_ADD_TEST(suite, test_apx_router_detachNodeInfos);
 
    return suite;
 }
@@ -167,6 +169,57 @@ static void test_apx_router_create(CuTest* tc)
    apx_parser_destroy(&parser);
 }
 
+static void test_apx_router_detachNodeInfos(CuTest* tc)
+{
+   const char *fileNames[5] = {APX_TEST_DATA_PATH "test1.apx", APX_TEST_DATA_PATH "test2.apx", APX_TEST_DATA_PATH "test3.apx", APX_TEST_DATA_PATH "test4.apx", APX_TEST_DATA_PATH "test5.apx"};
+   apx_node_t *apx_node[5];
+   apx_nodeInfo_t nodeInfoList[5];
+   apx_nodeInfo_t *detachList[3];
+   apx_parser_t parser;
+   apx_router_t router;
+   int32_t i;
+   adt_ary_t *connectors;
 
+   apx_parser_create(&parser);
+   apx_router_create(&router);
+   for (i=0;i<5;i++)
+   {
+      apx_node[i] = apx_parser_parseFile(&parser, fileNames[i]);
+      CuAssertPtrNotNull(tc,apx_node[i]);
+      apx_nodeInfo_create(&nodeInfoList[i],apx_node[i]);
+      apx_router_attachNodeInfo(&router,&nodeInfoList[i]);
+      CuAssertTrue(tc, nodeInfoList[i].isAttached);
+   }
+   CuAssertIntEquals(tc,5,adt_ary_length(&router.nodeInfoList));
+   CuAssertPtrNotNull(tc,apx_nodeInfo_getRequirePortConnector(&nodeInfoList[2],0)); //test3/WheelBasedVehicleSpeed
+
+   //detach both providers of WheelBasedVehicleSpeed in one batch, test2 also requires VehicleMode from test1
+   detachList[0] = &nodeInfoList[1];
+   detachList[1] = &nodeInfoList[0];
+   detachList[2] = &nodeInfoList[0]; //duplicates are ignored
+   apx_router_detachNodeInfos(&router, detachList, 3);
+   CuAssertIntEquals(tc,3,adt_ary_length(&router.nodeInfoList));
+   CuAssertTrue(tc, !nodeInfoList[0].isAttached);
+   CuAssertTrue(tc, !nodeInfoList[1].isAttached);
+   CuAssertPtrEquals(tc,0,apx_nodeInfo_getRequirePortConnector(&nodeInfoList[2],0)); //test3/WheelBasedVehicleSpeed
+   CuAssertPtrEquals(tc,0,apx_nodeInfo_getRequirePortConnector(&nodeInfoList[3],0)); //test4/WheelBasedVehicleSpeed
+   CuAssertPtrEquals(tc,0,apx_nodeInfo_getRequirePortConnector(&nodeInfoList[3],1)); //test4/ParkBrakeAlert
+   CuAssertPtrEquals(tc,0,apx_nodeInfo_getRequirePortConnector(&nodeInfoList[1],0)); //test2/VehicleMode was not rerouted
+   connectors = (adt_ary_t*) *adt_ary_get(&nodeInfoList[4].provideConnectors,0); //test5/GearSelectionMode
+   if (connectors != 0)
+   {
+      CuAssertIntEquals(tc,0,adt_ary_length(connectors));
+   }
 
+   //attaching test1 again reconnects the remaining nodes
+   apx_router_attachNodeInfo(&router,&nodeInfoList[0]);
+   CuAssertPtrNotNull(tc,apx_nodeInfo_getRequirePortConnector(&nodeInfoList[2],0));
+   CuAssertPtrNotNull(tc,apx_nodeInfo_getRequirePortConnector(&nodeInfoList[4],1)); //test5/CabTiltLockWarning
 
+   apx_router_destroy(&router);
+   for(i=0;i<5;i++)
+   {
+      apx_nodeInfo_destroy(&nodeInfoList[i]);
+   }
+   apx_parser_destroy(&parser);
+}
@@ -0,0 +1,182 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "CuTest.h"
+#include "apx_stream.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define EVENT_LOG_LEN 1024
+
+typedef struct eventLog_tag
+{
+   char text[EVENT_LOG_LEN];
+   int numNodeEnd;
+}eventLog_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_istream_singleWrite(CuTest* tc);
+static void test_apx_istream_byteByByte(CuTest* tc);
+static void test_apx_istream_splitChunks(CuTest* tc);
+static void test_apx_istream_parseError(CuTest* tc);
+static void feedInChunks(const char *text, uint32_t chunkLen, eventLog_t *log);
+static void onNode(void *arg, const char *name);
+static void onDatatype(void *arg, const char *name, const char *dsg, const char *attr);
+static void onRequire(void *arg, const char *name, const char *dsg, const char *attr);
+static void onProvide(void *arg, const char *name, const char *dsg, const char *attr);
+static void onNodeEnd(void *arg);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static const char *m_apxText =
+"APX/1.2\n"
+"N\"TestNode\"\n"
+"T\"Percent_T\"C\n"
+"R\"VehicleSpeed\"S:=0xFFFF\n"
+"P\"EngineStatus\"C(0,3):=3\n"
+"\n";
+
+static const char *m_expectedLog =
+"N(TestNode)"
+"T(Percent_T,C,-)"
+"R(VehicleSpeed,S,=0xFFFF)"
+"P(EngineStatus,C(0,3),=3)";
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testSuite_apx_stream(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_apx_istream_singleWrite);
+   SUITE_ADD_TEST(suite, test_apx_istream_byteByByte);
+   SUITE_ADD_TEST(suite, test_apx_istream_splitChunks);
+   SUITE_ADD_TEST(suite, test_apx_istream_parseError);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void test_apx_istream_singleWrite(CuTest* tc)
+{
+   eventLog_t log;
+   feedInChunks(m_apxText, (uint32_t) strlen(m_apxText), &log);
+   CuAssertStrEquals(tc, m_expectedLog, log.text);
+   CuAssertIntEquals(tc, 1, log.numNodeEnd);
+}
+
+static void test_apx_istream_byteByByte(CuTest* tc)
+{
+   eventLog_t log;
+   feedInChunks(m_apxText, 1, &log);
+   CuAssertStrEquals(tc, m_expectedLog, log.text);
+   CuAssertIntEquals(tc, 1, log.numNodeEnd);
+}
+
+static void test_apx_istream_splitChunks(CuTest* tc)
+{
+   uint32_t chunkLen;
+   for (chunkLen = 2; chunkLen < 32; chunkLen++)
+   {
+      eventLog_t log;
+      feedInChunks(m_apxText, chunkLen, &log);
+      CuAssertStrEquals(tc, m_expectedLog, log.text);
+      CuAssertIntEquals(tc, 1, log.numNodeEnd);
+   }
+}
+
+static void test_apx_istream_parseError(CuTest* tc)
+{
+   eventLog_t log;
+   const char *text =
+         "APX/1.2\n"
+         "N\"TestNode\"\n"
+         "R\"VehicleSpeed\":=0xFFFF\n"
+         "R\"EngineSpeed\"S\n"
+         "\n";
+   //remaining data of the write is discarded after a parse error
+   feedInChunks(text, (uint32_t) strlen(text), &log);
+   CuAssertStrEquals(tc, "N(TestNode)", log.text);
+   CuAssertIntEquals(tc, 0, log.numNodeEnd);
+}
+
+static void feedInChunks(const char *text, uint32_t chunkLen, eventLog_t *log)
+{
+   apx_istream_t istream;
+   apx_istream_handler_t handler;
+   const uint8_t *pNext = (const uint8_t*) text;
+   const uint8_t *pEnd = pNext + strlen(text);
+   memset(&handler, 0, sizeof(handler));
+   memset(log, 0, sizeof(eventLog_t));
+   handler.arg = log;
+   handler.node = onNode;
+   handler.datatype = onDatatype;
+   handler.require = onRequire;
+   handler.provide = onProvide;
+   handler.node_end = onNodeEnd;
+   apx_istream_create(&istream, &handler);
+   apx_istream_open(&istream);
+   while (pNext < pEnd)
+   {
+      uint32_t len = ( (uint32_t) (pEnd-pNext) < chunkLen)? (uint32_t) (pEnd-pNext) : chunkLen;
+      apx_istream_write(&istream, pNext, len);
+      pNext += len;
+   }
+   apx_istream_close(&istream);
+   apx_istream_destroy(&istream);
+}
+
+static void onNode(void *arg, const char *name)
+{
+   eventLog_t *log = (eventLog_t*) arg;
+   size_t len = strlen(log->text);
+   snprintf(&log->text[len], EVENT_LOG_LEN-len, "N(%s)", name);
+}
+
+static void onDatatype(void *arg, const char *name, const char *dsg, const char *attr)
+{
+   eventLog_t *log = (eventLog_t*) arg;
+   size_t len = strlen(log->text);
+   snprintf(&log->text[len], EVENT_LOG_LEN-len, "T(%s,%s,%s)", name, dsg, (attr != 0)? attr : "-");
+}
+
+static void onRequire(void *arg, const char *name, const char *dsg, const char *attr)
+{
+   eventLog_t *log = (eventLog_t*) arg;
+   size_t len = strlen(log->text);
+   snprintf(&log->text[len], EVENT_LOG_LEN-len, "R(%s,%s,%s)", name, dsg, (attr != 0)? attr : "-");
+}
+
+static void onProvide(void *arg, const char *name, const char *dsg, const char *attr)
+{
+   eventLog_t *log = (eventLog_t*) arg;
+   size_t len = strlen(log->text);
+   snprintf(&log->text[len], EVENT_LOG_LEN-len, "P(%s,%s,%s)", name, dsg, (attr != 0)? attr : "-");
+}
+
+static void onNodeEnd(void *arg)
+{
+   eventLog_t *log = (eventLog_t*) arg;
+   log->numNodeEnd++;
+}
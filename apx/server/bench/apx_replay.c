@@ -0,0 +1,384 @@
+/**
+ * file: apx_replay.c
+ * description: replays a traffic capture (see apx_capture.h, written by apx_server --capture=<file>) into an in-process broker.
+ *              Every captured connection becomes an apx_serverConnection on top of apx_testServer and receives the frames
+ *              its client originally sent, either at the original pacing (optionally scaled) or as fast as possible.
+ *              Frames sent by the broker are counted and discarded.
+ *              Reports frames/s and bytes/s of the replay together with the amount of traffic the broker generated.
+ *              POSIX only.
+ */
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "apx_testServer.h"
+#include "apx_capture.h"
+#include "headerutil.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define REPLAY_MAX_FRAME_HEADER    4u
+#define REPLAY_DRAIN_TIMEOUT       5.0 //seconds
+#define REPLAY_MAX_SLEEP           0.01 //seconds
+
+typedef struct replayConfig_tag
+{
+   const char *captureFile;
+   double speed; //0 replays as fast as possible
+   uint8_t direction; //APX_CAPTURE_RX for server side captures, APX_CAPTURE_TX for client side captures
+   int8_t verbose;
+}replayConfig_t;
+
+typedef struct replayConnection_tag
+{
+   uint32_t captureId;
+   apx_serverConnection_t *connection; //owned by the test server
+   uint8_t *sendBuf;
+   int32_t sendBufLen;
+   uint64_t numFramesIn;
+   uint64_t numBytesIn;
+   volatile uint64_t numFramesOut; //updated from the fileManager worker thread
+   volatile uint64_t numBytesOut;
+}replayConnection_t;
+
+typedef struct replayResult_tag
+{
+   uint32_t numConnections;
+   uint64_t numFramesIn;
+   uint64_t numBytesIn;
+   uint64_t numFramesOut;
+   uint64_t numBytesOut;
+   uint64_t numSkipped; //frames in the other direction
+   double captureDuration;
+   double elapsed; //time spent feeding frames
+   double drainTime; //time until the broker had processed all queued work after the last frame
+}replayResult_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static int parseArgs(int argc, char **argv, replayConfig_t *cfg);
+static void printUsage(const char *name);
+static int runReplay(const replayConfig_t *cfg, replayResult_t *result);
+static void printResult(const replayResult_t *result);
+static double getTimeSec(void);
+static void sleepUntil(double deadline);
+static replayConnection_t *getConnection(apx_testServer_t *server, replayConnection_t ***connections, uint32_t *numConnections, uint32_t captureId);
+static uint32_t getQueueDepth(replayConnection_t **connections, uint32_t numConnections);
+static uint8_t *replayConnection_getSendBuffer(void *arg, int32_t msgLen);
+static int32_t replayConnection_send(void *arg, int32_t offset, int32_t msgLen);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+int8_t g_debug; // Global so apx_logging can use it from everywhere
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+   replayConfig_t cfg;
+   replayResult_t result;
+   g_debug = 0;
+   if (parseArgs(argc, argv, &cfg) != 0)
+   {
+      printUsage(argv[0]);
+      return 1;
+   }
+   if (runReplay(&cfg, &result) != 0)
+   {
+      return 1;
+   }
+   printResult(&result);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static int parseArgs(int argc, char **argv, replayConfig_t *cfg)
+{
+   int i;
+   memset(cfg, 0, sizeof(replayConfig_t));
+   cfg->speed = 1.0;
+   cfg->direction = APX_CAPTURE_RX;
+   for (i=1; i<argc; i++)
+   {
+      const char *arg = argv[i];
+      if (strcmp(arg, "--fast") == 0)
+      {
+         cfg->speed = 0.0;
+      }
+      else if (strncmp(arg, "--speed=", 8) == 0)
+      {
+         cfg->speed = strtod(&arg[8], 0);
+         if (cfg->speed <= 0.0)
+         {
+            return -1;
+         }
+      }
+      else if (strcmp(arg, "--client") == 0)
+      {
+         cfg->direction = APX_CAPTURE_TX;
+      }
+      else if (strcmp(arg, "-v") == 0)
+      {
+         cfg->verbose = 1;
+      }
+      else if (arg[0] == '-')
+      {
+         printf("Unknown argument %s\n", arg);
+         return -1;
+      }
+      else
+      {
+         cfg->captureFile = arg;
+      }
+   }
+   return (cfg->captureFile != 0)? 0 : -1;
+}
+
+static void printUsage(const char *name)
+{
+   printf("%s [--fast | --speed=<factor>] [--client] [-v] <capture file>\n", name);
+   printf("  --fast     replay without delays\n");
+   printf("  --speed=x  replay at x times the original pacing (default 1)\n");
+   printf("  --client   the capture was taken by a client (replays its transmitted frames)\n");
+}
+
+static int runReplay(const replayConfig_t *cfg, replayResult_t *result)
+{
+   apx_captureReader_t reader;
+   apx_captureRecord_t record;
+   apx_testServer_t server;
+   replayConnection_t **connections = 0; //elements are referenced by the transmit handlers and must not move
+   uint32_t numConnections = 0;
+   uint32_t i;
+   int8_t rc;
+   int retval = 0;
+   double start;
+   double stop;
+
+   memset(result, 0, sizeof(replayResult_t));
+   if (apx_captureReader_open(&reader, cfg->captureFile) != 0)
+   {
+      printf("Failed to open capture %s (errno=%d)\n", cfg->captureFile, errno);
+      return -1;
+   }
+   apx_testServer_create(&server);
+   start = getTimeSec();
+   while ( (rc = apx_captureReader_next(&reader, &record)) == 1)
+   {
+      replayConnection_t *replayConnection;
+      uint32_t parseLen = 0;
+      result->captureDuration = (double) record.timestamp / 1E9;
+      if (record.direction != cfg->direction)
+      {
+         result->numSkipped++;
+         continue;
+      }
+      if (cfg->speed > 0.0)
+      {
+         sleepUntil(start + result->captureDuration / cfg->speed);
+      }
+      replayConnection = getConnection(&server, &connections, &numConnections, record.connectionId);
+      if (replayConnection == 0)
+      {
+         printf("Failed to create connection for capture id %u\n", (unsigned int) record.connectionId);
+         retval = -1;
+         break;
+      }
+      if ( (apx_serverConnection_dataReceived(replayConnection->connection, record.frame, record.frameLen, &parseLen) != 0) ||
+           (parseLen != record.frameLen) )
+      {
+         printf("Frame of %u bytes on connection %u was not accepted by the broker\n", (unsigned int) record.frameLen,
+               (unsigned int) record.connectionId);
+      }
+      replayConnection->numFramesIn++;
+      replayConnection->numBytesIn += record.frameLen;
+      result->numFramesIn++;
+      result->numBytesIn += record.frameLen;
+   }
+   if (rc < 0)
+   {
+      printf("Capture is truncated or corrupt after %llu frames\n", (unsigned long long) result->numFramesIn);
+   }
+   stop = getTimeSec();
+   result->elapsed = stop - start;
+   while ( (getQueueDepth(connections, numConnections) > 0u) && (getTimeSec() - stop < REPLAY_DRAIN_TIMEOUT) )
+   {
+      usleep(100);
+   }
+   result->drainTime = getTimeSec() - stop;
+   result->numConnections = numConnections;
+   for (i=0; i<numConnections; i++)
+   {
+      result->numFramesOut += connections[i]->numFramesOut;
+      result->numBytesOut += connections[i]->numBytesOut;
+      if (cfg->verbose != 0)
+      {
+         printf("connection %u: in %llu frames/%llu bytes, out %llu frames/%llu bytes\n", (unsigned int) connections[i]->captureId,
+               (unsigned long long) connections[i]->numFramesIn, (unsigned long long) connections[i]->numBytesIn,
+               (unsigned long long) connections[i]->numFramesOut, (unsigned long long) connections[i]->numBytesOut);
+      }
+   }
+   apx_testServer_destroy(&server);
+   for (i=0; i<numConnections; i++)
+   {
+      free(connections[i]->sendBuf);
+      free(connections[i]);
+   }
+   free(connections);
+   apx_captureReader_close(&reader);
+   return retval;
+}
+
+static void printResult(const replayResult_t *result)
+{
+   double elapsed = result->elapsed + result->drainTime;
+   printf("replayed %u connections, %llu frames (%llu bytes) in %.3f s + %.3f s drain, capture spans %.3f s\n",
+         (unsigned int) result->numConnections, (unsigned long long) result->numFramesIn, (unsigned long long) result->numBytesIn,
+         result->elapsed, result->drainTime, result->captureDuration);
+   if (elapsed > 0.0)
+   {
+      printf("in:  %12.0f frames/s %10.3f MB/s\n", (double) result->numFramesIn / elapsed, (double) result->numBytesIn / elapsed / 1E6);
+      printf("out: %12.0f frames/s %10.3f MB/s (%llu frames)\n", (double) result->numFramesOut / elapsed,
+            (double) result->numBytesOut / elapsed / 1E6, (unsigned long long) result->numFramesOut);
+   }
+   if (result->numSkipped > 0u)
+   {
+      printf("skipped %llu frames sent in the other direction\n", (unsigned long long) result->numSkipped);
+   }
+}
+
+static double getTimeSec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (double) ts.tv_sec + (double) ts.tv_nsec / 1E9;
+}
+
+static void sleepUntil(double deadline)
+{
+   double now = getTimeSec();
+   while (now < deadline)
+   {
+      double delay = deadline - now;
+      usleep( (useconds_t) ( ( (delay < REPLAY_MAX_SLEEP)? delay : REPLAY_MAX_SLEEP) * 1E6) );
+      now = getTimeSec();
+   }
+}
+
+/**
+ * returns the broker connection of a captured connection, connecting it on first use
+ */
+static replayConnection_t *getConnection(apx_testServer_t *server, replayConnection_t ***connections, uint32_t *numConnections, uint32_t captureId)
+{
+   static uint32_t lastIndex = 0u;
+   replayConnection_t *replayConnection;
+   replayConnection_t **newConnections;
+   apx_transmitHandler_t transmitHandler;
+   adt_list_elem_t *elem;
+   testsocket_t *socket;
+   uint32_t i;
+   if ( (lastIndex < *numConnections) && ( (*connections)[lastIndex]->captureId == captureId) )
+   {
+      return (*connections)[lastIndex];
+   }
+   for (i=0; i<*numConnections; i++)
+   {
+      if ( (*connections)[i]->captureId == captureId)
+      {
+         lastIndex = i;
+         return (*connections)[i];
+      }
+   }
+   newConnections = (replayConnection_t**) realloc(*connections, (*numConnections+1u)*sizeof(replayConnection_t*));
+   if (newConnections == 0)
+   {
+      return 0;
+   }
+   *connections = newConnections;
+   replayConnection = (replayConnection_t*) malloc(sizeof(replayConnection_t));
+   socket = testsocket_new();
+   if ( (replayConnection == 0) || (socket == 0) )
+   {
+      free(replayConnection);
+      return 0;
+   }
+   memset(replayConnection, 0, sizeof(replayConnection_t));
+   replayConnection->captureId = captureId;
+   apx_testServer_accept(server, socket);
+   elem = adt_list_last(&server->connections);
+   if (elem == 0)
+   {
+      free(replayConnection);
+      return 0;
+   }
+   //frames sent by the broker end up in our counters instead of the test socket
+   replayConnection->connection = (apx_serverConnection_t*) elem->pItem;
+   transmitHandler.arg = replayConnection;
+   transmitHandler.getSendAvail = 0;
+   transmitHandler.getSendBuffer = replayConnection_getSendBuffer;
+   transmitHandler.send = replayConnection_send;
+   apx_fileManager_setTransmitHandler(&replayConnection->connection->fileManager, &transmitHandler);
+   lastIndex = *numConnections;
+   (*connections)[(*numConnections)++] = replayConnection;
+   return replayConnection;
+}
+
+static uint32_t getQueueDepth(replayConnection_t **connections, uint32_t numConnections)
+{
+   uint32_t depth = 0u;
+   uint32_t i;
+   for (i=0; i<numConnections; i++)
+   {
+      apx_connectionStats_t stats;
+      apx_fileManager_getStats(&connections[i]->connection->fileManager, &stats);
+      depth += stats.queueDepth;
+   }
+   return depth;
+}
+
+static uint8_t *replayConnection_getSendBuffer(void *arg, int32_t msgLen)
+{
+   replayConnection_t *self = (replayConnection_t*) arg;
+   int32_t requestedLen = msgLen + (int32_t) REPLAY_MAX_FRAME_HEADER;
+   if (requestedLen > self->sendBufLen)
+   {
+      uint8_t *buf = (uint8_t*) realloc(self->sendBuf, (size_t) requestedLen);
+      if (buf == 0)
+      {
+         return 0;
+      }
+      self->sendBuf = buf;
+      self->sendBufLen = requestedLen;
+   }
+   return &self->sendBuf[REPLAY_MAX_FRAME_HEADER];
+}
+
+static int32_t replayConnection_send(void *arg, int32_t offset, int32_t msgLen)
+{
+   replayConnection_t *self = (replayConnection_t*) arg;
+   uint8_t header[REPLAY_MAX_FRAME_HEADER];
+   uint8_t *headerEnd = headerutil_numEncode32(header, (uint32_t) sizeof(header), (uint32_t) msgLen);
+   if ( (headerEnd <= header) || (offset+msgLen+(int32_t) REPLAY_MAX_FRAME_HEADER > self->sendBufLen) )
+   {
+      return -1;
+   }
+   __sync_fetch_and_add(&self->numFramesOut, 1u);
+   __sync_fetch_and_add(&self->numBytesOut, (uint64_t) ( (headerEnd-header) + msgLen) );
+   return 0;
+}
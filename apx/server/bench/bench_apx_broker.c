@@ -0,0 +1,1409 @@
+/**
+ * file: bench_apx_broker.c
+ * description: end-to-end broker benchmark. Simulates a number of APX clients inside a single process. Each client
+ *              connects to the broker, uploads its definition and then writes uint32 signals at a fixed rate. Client n
+ *              requires the signals provided by client n-1, which means every write is routed to exactly one other client.
+ *              Node definitions are either generated or loaded from .apx files given on the command line (the benchmark
+ *              signals are then added to the node found in the file).
+ *              Reports messages/s, bytes/s, end-to-end latency percentiles, connect time per node and CPU time per message.
+ *              The inproc transport runs apx_testServer on top of testsocket in this process, the tcp transport runs the
+ *              same scenario over loopback TCP against apx_server (already running or started with --server).
+ *              POSIX only.
+ */
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <semaphore.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "apx_testServer.h"
+#include "apx_parser.h"
+#include "apx_stream.h"
+#include "apx_node.h"
+#include "adt_bytearray.h"
+#include "headerutil.h"
+#include "pack.h"
+#include "rmf.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define DEFAULT_NUM_CLIENTS        8u
+#define DEFAULT_NUM_SIGNALS        16u
+#define DEFAULT_RATE               1000u //signal writes per second and client
+#define DEFAULT_DURATION           5.0   //seconds
+#define DEFAULT_TCP_PORT           5000u
+
+#define BENCH_TRANSPORT_INPROC     1u
+#define BENCH_TRANSPORT_TCP        2u
+
+#define BENCH_DEFINITION_ADDRESS   0x4000000u //clients place their definition file at start of definition area
+#define BENCH_OUTDATA_ADDRESS      0u
+#define BENCH_SIGNAL_SIZE          4u
+#define BENCH_SEQ_RING_LEN         8192u //must be a power of 2
+#define BENCH_MAX_LATENCY_SAMPLES  (1u << 21)
+#define BENCH_MAX_NAME_LEN         64u
+#define BENCH_MAX_FRAME_HEADER     4u
+#define BENCH_CONNECT_TIMEOUT      10.0 //seconds
+#define BENCH_DRAIN_TIMEOUT        2.0  //seconds
+#define BENCH_MAX_WAIT             0.001 //longest time the traffic loop waits for data before sending the next batch
+#define BENCH_RECV_CHUNK           65536u
+#define BENCH_MAX_POLL_FDS         256u
+#define BENCH_GREETING             RMF_GREETING_START RMF_NUMHEADER_FORMAT "32\n\n"
+
+typedef struct benchConfig_tag
+{
+   uint32_t numClients;
+   uint32_t numSignals;
+   uint32_t rate;
+   double duration;
+   uint8_t transports;
+   uint16_t tcpPort;
+   const char *serverPath;
+   const char *jsonFile;
+   int numApxFiles;
+   char **apxFiles;
+}benchConfig_t;
+
+typedef struct benchClient_tag
+{
+   uint32_t id;
+   char name[BENCH_MAX_NAME_LEN];
+   char *definition;
+   uint32_t definitionLen;
+   uint8_t *outData; //initial content of the .out file
+   uint32_t outDataLen;
+   uint32_t inAddress;
+   uint32_t inDataLen;
+   uint32_t numSignals;
+   uint8_t transport;
+   testsocket_t *testsocket; //inproc transport, owned by the apx_serverConnection once accepted
+   int fd; //tcp transport
+   MUTEX_T rxLock; //protects rxBuf, which is written by server worker threads in the inproc transport
+   adt_bytearray_t rxBuf;
+   adt_bytearray_t procBuf; //received bytes not yet parsed
+   adt_bytearray_t txBuf;
+   uint8_t *serverSendBuf; //transmit buffer of the server side fileManager (inproc transport)
+   int32_t serverSendBufLen;
+   bool isAckSeen;
+   bool isOutOpened;
+   bool isInReceived;
+   bool isConnected;
+   double connectStart;
+   double connectTime;
+   uint32_t nextSeq;
+   uint32_t sendSeq[BENCH_SEQ_RING_LEN];
+   double sendTime[BENCH_SEQ_RING_LEN];
+   uint64_t numSent;
+   uint64_t bytesSent;
+   uint64_t numReceived;
+   uint64_t bytesReceived;
+   uint32_t maxSeqReceived; //the broker may merge writes to the same signal, values below this one are delivered or superseded
+   struct benchClient_tag *provider; //the client providing the signals this client requires
+}benchClient_t;
+
+typedef struct benchResult_tag
+{
+   uint8_t transport;
+   uint32_t numClients;
+   uint32_t numSignals;
+   uint32_t rate;
+   double duration;
+   uint64_t numSent;
+   uint64_t numReceived;
+   uint64_t numSuperseded; //values overwritten by a newer value of the same signal before delivery
+   uint64_t bytesSent;
+   uint64_t bytesReceived;
+   double msgsPerSec;
+   double bytesPerSec;
+   double latencyP50;
+   double latencyP99;
+   double latencyP999;
+   double latencyMax;
+   uint32_t numLatencySamples;
+   double connectMin;
+   double connectAvg;
+   double connectMax;
+   double *connectTimes; //per node, in microseconds
+   double cpuPerMsg; //microseconds of CPU time per routed message
+}benchResult_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static int parseArgs(int argc, char **argv, benchConfig_t *cfg);
+static void printUsage(const char *name);
+static int runScenario(const benchConfig_t *cfg, uint8_t transport, benchResult_t *result);
+static void printResult(const benchResult_t *result);
+static int writeJson(const char *fileName, const benchResult_t *results, int numResults);
+static const char *transportName(uint8_t transport);
+static double getTimeSec(void);
+static double getCpuTimeSec(pid_t serverPid);
+static pid_t startServer(const char *path, uint16_t port);
+static void stopServer(pid_t pid);
+static int compareDouble(const void *a, const void *b);
+static double percentile(const double *sorted, uint32_t len, double p);
+static char *readTextFile(const char *fileName, uint32_t *len);
+static char *createDefinition(const benchClient_t *self, const char *apxText, uint32_t prevId, uint32_t *len);
+
+static int8_t benchClient_create(benchClient_t *self, uint32_t id, uint32_t prevId, const benchConfig_t *cfg, uint8_t transport);
+static void benchClient_destroy(benchClient_t *self);
+static int8_t benchClient_parseDefinition(benchClient_t *self);
+static int8_t benchClient_connect(benchClient_t *self, apx_testServer_t *server, uint16_t tcpPort);
+static void benchClient_disconnect(benchClient_t *self);
+static int8_t benchClient_sendFrame(benchClient_t *self, const uint8_t *msgBuf, uint32_t msgLen);
+static int8_t benchClient_sendFileInfo(benchClient_t *self, const char *suffix, uint32_t address, uint32_t length);
+static int8_t benchClient_sendFileOpen(benchClient_t *self, uint32_t address);
+static int8_t benchClient_sendData(benchClient_t *self, uint32_t address, const uint8_t *data, uint32_t dataLen);
+static int8_t benchClient_sendSignal(benchClient_t *self);
+static uint32_t benchClient_receive(benchClient_t *self);
+static void benchClient_processMsg(benchClient_t *self, const uint8_t *msgBuf, uint32_t msgLen);
+static void benchClient_processCmd(benchClient_t *self, const uint8_t *cmdBuf, uint32_t cmdLen);
+static void benchClient_processData(benchClient_t *self, uint32_t offset, const uint8_t *data, uint32_t dataLen);
+static uint8_t *benchClient_getSendBuffer(void *arg, int32_t msgLen);
+static int32_t benchClient_serverSend(void *arg, int32_t offset, int32_t msgLen);
+
+static uint32_t pumpClients(benchClient_t *clients, uint32_t numClients);
+static void waitForData(benchClient_t *clients, uint32_t numClients, double timeout);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+int8_t g_debug; // Global so apx_logging can use it from everywhere
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static sem_t m_rxSemaphore; //posted by server worker threads when data is available for a client (inproc transport)
+static double *m_latencySamples;
+static uint32_t m_numLatencySamples;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+   benchConfig_t cfg;
+   benchResult_t results[2];
+   int numResults = 0;
+   int retval = 0;
+   int i;
+   g_debug = 0;
+   if (parseArgs(argc, argv, &cfg) != 0)
+   {
+      printUsage(argv[0]);
+      return 1;
+   }
+   signal(SIGPIPE, SIG_IGN);
+   m_latencySamples = (double*) malloc(BENCH_MAX_LATENCY_SAMPLES*sizeof(double));
+   if (m_latencySamples == 0)
+   {
+      printf("Failed to allocate latency samples\n");
+      return 1;
+   }
+   sem_init(&m_rxSemaphore, 0, 0);
+   printf("apx broker: %u clients, %u signals/client, %u writes/s/client, %.1f s\n", (unsigned int) cfg.numClients,
+         (unsigned int) cfg.numSignals, (unsigned int) cfg.rate, cfg.duration);
+   printf("%-8s %12s %12s %10s %10s %10s %12s %12s\n", "", "msgs/s", "MB/s", "p50 (us)", "p99 (us)", "p999 (us)",
+         "connect (ms)", "cpu/msg (us)");
+   if (cfg.transports & BENCH_TRANSPORT_INPROC)
+   {
+      if (runScenario(&cfg, BENCH_TRANSPORT_INPROC, &results[numResults]) == 0)
+      {
+         printResult(&results[numResults++]);
+      }
+      else
+      {
+         retval = 1;
+      }
+   }
+   if (cfg.transports & BENCH_TRANSPORT_TCP)
+   {
+      if (runScenario(&cfg, BENCH_TRANSPORT_TCP, &results[numResults]) == 0)
+      {
+         printResult(&results[numResults++]);
+      }
+      else
+      {
+         retval = 1;
+      }
+   }
+   if ( (cfg.jsonFile != 0) && (numResults > 0) )
+   {
+      if (writeJson(cfg.jsonFile, results, numResults) != 0)
+      {
+         printf("Failed to write %s\n", cfg.jsonFile);
+         retval = 1;
+      }
+   }
+   for (i=0; i<numResults; i++)
+   {
+      free(results[i].connectTimes);
+   }
+   sem_destroy(&m_rxSemaphore);
+   free(m_latencySamples);
+   return retval;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static int parseArgs(int argc, char **argv, benchConfig_t *cfg)
+{
+   int i;
+   memset(cfg, 0, sizeof(benchConfig_t));
+   cfg->numClients = DEFAULT_NUM_CLIENTS;
+   cfg->numSignals = DEFAULT_NUM_SIGNALS;
+   cfg->rate = DEFAULT_RATE;
+   cfg->duration = DEFAULT_DURATION;
+   cfg->transports = BENCH_TRANSPORT_INPROC;
+   cfg->tcpPort = DEFAULT_TCP_PORT;
+   cfg->apxFiles = (char**) malloc(sizeof(char*)*argc);
+   if (cfg->apxFiles == 0)
+   {
+      return -1;
+   }
+   for (i=1; i<argc; i++)
+   {
+      const char *arg = argv[i];
+      if (strncmp(arg, "--clients=", 10) == 0)
+      {
+         cfg->numClients = (uint32_t) strtoul(&arg[10], 0, 10);
+      }
+      else if (strncmp(arg, "--signals=", 10) == 0)
+      {
+         cfg->numSignals = (uint32_t) strtoul(&arg[10], 0, 10);
+      }
+      else if (strncmp(arg, "--rate=", 7) == 0)
+      {
+         cfg->rate = (uint32_t) strtoul(&arg[7], 0, 10);
+      }
+      else if (strncmp(arg, "--duration=", 11) == 0)
+      {
+         cfg->duration = strtod(&arg[11], 0);
+      }
+      else if (strncmp(arg, "--transport=", 12) == 0)
+      {
+         if (strcmp(&arg[12], "inproc") == 0)
+         {
+            cfg->transports = BENCH_TRANSPORT_INPROC;
+         }
+         else if (strcmp(&arg[12], "tcp") == 0)
+         {
+            cfg->transports = BENCH_TRANSPORT_TCP;
+         }
+         else if (strcmp(&arg[12], "all") == 0)
+         {
+            cfg->transports = BENCH_TRANSPORT_INPROC | BENCH_TRANSPORT_TCP;
+         }
+         else
+         {
+            return -1;
+         }
+      }
+      else if (strncmp(arg, "--port=", 7) == 0)
+      {
+         cfg->tcpPort = (uint16_t) strtoul(&arg[7], 0, 10);
+      }
+      else if (strncmp(arg, "--server=", 9) == 0)
+      {
+         cfg->serverPath = &arg[9];
+      }
+      else if (strncmp(arg, "--json=", 7) == 0)
+      {
+         cfg->jsonFile = &arg[7];
+      }
+      else if (strncmp(arg, "--", 2) == 0)
+      {
+         return -1;
+      }
+      else
+      {
+         cfg->apxFiles[cfg->numApxFiles++] = argv[i];
+      }
+   }
+   if ( (cfg->numClients < 2) || (cfg->numSignals == 0) || (cfg->rate == 0) || (cfg->duration <= 0.0) || (cfg->tcpPort == 0) )
+   {
+      return -1;
+   }
+   return 0;
+}
+
+static void printUsage(const char *name)
+{
+   printf("%s [options] [file.apx ...]\n", name);
+   printf("  --clients=<n>      number of simulated clients, at least 2 (default %u)\n", DEFAULT_NUM_CLIENTS);
+   printf("  --signals=<n>      uint32 signals provided by each client (default %u)\n", DEFAULT_NUM_SIGNALS);
+   printf("  --rate=<n>         signal writes per second and client (default %u)\n", DEFAULT_RATE);
+   printf("  --duration=<sec>   length of traffic phase (default %.0f)\n", DEFAULT_DURATION);
+   printf("  --transport=<t>    inproc, tcp or all (default inproc)\n");
+   printf("  --port=<n>         TCP port of the broker (default %u)\n", DEFAULT_TCP_PORT);
+   printf("  --server=<path>    start this apx_server executable for the tcp transport\n");
+   printf("  --json=<file>      write results as JSON\n");
+   printf("Definition files are assigned to clients round-robin. Without files, definitions are generated.\n");
+}
+
+static int runScenario(const benchConfig_t *cfg, uint8_t transport, benchResult_t *result)
+{
+   apx_testServer_t server;
+   benchClient_t *clients;
+   pid_t serverPid = 0;
+   uint32_t numClients = cfg->numClients;
+   uint32_t numConnected = 0;
+   uint64_t numSent = 0;
+   uint64_t numSettled = 0;
+   double start;
+   double stop;
+   double now;
+   double cpuStart;
+   double cpuStop;
+   double connectSum = 0.0;
+   uint32_t i;
+   int retval = 0;
+
+   memset(result, 0, sizeof(benchResult_t));
+   result->transport = transport;
+   result->numClients = numClients;
+   result->numSignals = cfg->numSignals;
+   result->rate = cfg->rate;
+   result->duration = cfg->duration;
+   result->connectTimes = (double*) malloc(numClients*sizeof(double));
+   clients = (benchClient_t*) calloc(numClients, sizeof(benchClient_t));
+   if ( (clients == 0) || (result->connectTimes == 0) )
+   {
+      printf("Failed to allocate clients\n");
+      free(clients);
+      return -1;
+   }
+   for (i=0; i<numClients; i++)
+   {
+      uint32_t prevId = (i + numClients - 1u) % numClients;
+      if (benchClient_create(&clients[i], i, prevId, cfg, transport) != 0)
+      {
+         printf("Failed to create client %u\n", (unsigned int) i);
+         numClients = i+1u;
+         retval = -1;
+         break;
+      }
+   }
+   for (i=0; i<numClients; i++)
+   {
+      clients[i].provider = &clients[(i + numClients - 1u) % numClients];
+   }
+   m_numLatencySamples = 0;
+   if (transport == BENCH_TRANSPORT_INPROC)
+   {
+      apx_testServer_create(&server);
+   }
+   else if (cfg->serverPath != 0)
+   {
+      serverPid = startServer(cfg->serverPath, cfg->tcpPort);
+      if (serverPid <= 0)
+      {
+         printf("Failed to start %s\n", cfg->serverPath);
+         retval = -1;
+      }
+   }
+
+   //connect phase, all clients connect at the same time
+   for (i=0; (retval == 0) && (i<numClients); i++)
+   {
+      if (benchClient_connect(&clients[i], &server, cfg->tcpPort) != 0)
+      {
+         printf("%s: client %u failed to connect\n", transportName(transport), (unsigned int) i);
+         retval = -1;
+      }
+   }
+   start = getTimeSec();
+   while ( (retval == 0) && (numConnected < numClients) )
+   {
+      now = getTimeSec();
+      if (now - start > BENCH_CONNECT_TIMEOUT)
+      {
+         printf("%s: timeout, %u of %u clients connected\n", transportName(transport), (unsigned int) numConnected, (unsigned int) numClients);
+         retval = -1;
+         break;
+      }
+      if (pumpClients(clients, numClients) == 0)
+      {
+         waitForData(clients, numClients, BENCH_MAX_WAIT);
+      }
+      numConnected = 0;
+      for (i=0; i<numClients; i++)
+      {
+         if (clients[i].isConnected)
+         {
+            numConnected++;
+         }
+      }
+   }
+
+   //traffic phase
+   if (retval == 0)
+   {
+      cpuStart = getCpuTimeSec(serverPid);
+      start = getTimeSec();
+      now = start;
+      while (now - start < cfg->duration)
+      {
+         uint64_t due = (uint64_t) ( (now - start) * (double) cfg->rate );
+         for (i=0; i<numClients; i++)
+         {
+            while (clients[i].numSent < due)
+            {
+               if (benchClient_sendSignal(&clients[i]) != 0)
+               {
+                  break;
+               }
+            }
+         }
+         if (pumpClients(clients, numClients) == 0)
+         {
+            double next = start + ((double) (due+1u)) / (double) cfg->rate;
+            now = getTimeSec();
+            if (next > now)
+            {
+               waitForData(clients, numClients, (next-now < BENCH_MAX_WAIT)? next-now : BENCH_MAX_WAIT);
+            }
+         }
+         now = getTimeSec();
+      }
+      //let the broker deliver what is still in flight
+      for (i=0; i<numClients; i++)
+      {
+         numSent += clients[i].numSent;
+      }
+      stop = getTimeSec();
+      while (getTimeSec() - stop < BENCH_DRAIN_TIMEOUT)
+      {
+         numSettled = 0;
+         for (i=0; i<numClients; i++)
+         {
+            numSettled += clients[i].maxSeqReceived;
+         }
+         if (numSettled >= numSent)
+         {
+            break;
+         }
+         if (pumpClients(clients, numClients) == 0)
+         {
+            waitForData(clients, numClients, BENCH_MAX_WAIT);
+         }
+      }
+      stop = getTimeSec();
+      cpuStop = getCpuTimeSec(serverPid);
+
+      for (i=0; i<numClients; i++)
+      {
+         result->numSent += clients[i].numSent;
+         result->bytesSent += clients[i].bytesSent;
+         result->numReceived += clients[i].numReceived;
+         if (clients[i].maxSeqReceived > clients[i].numReceived)
+         {
+            result->numSuperseded += clients[i].maxSeqReceived - clients[i].numReceived;
+         }
+         result->bytesReceived += clients[i].bytesReceived;
+         result->connectTimes[i] = clients[i].connectTime*1e6;
+         connectSum += result->connectTimes[i];
+         if ( (i == 0) || (result->connectTimes[i] < result->connectMin) )
+         {
+            result->connectMin = result->connectTimes[i];
+         }
+         if (result->connectTimes[i] > result->connectMax)
+         {
+            result->connectMax = result->connectTimes[i];
+         }
+      }
+      result->connectAvg = connectSum / (double) numClients;
+      result->msgsPerSec = ((double) result->numReceived) / (stop-start);
+      result->bytesPerSec = ((double) result->bytesReceived) / (stop-start);
+      if (result->numReceived > 0)
+      {
+         result->cpuPerMsg = (cpuStop-cpuStart)*1e6 / (double) result->numReceived;
+      }
+      result->numLatencySamples = m_numLatencySamples;
+      if (m_numLatencySamples > 0)
+      {
+         qsort(m_latencySamples, m_numLatencySamples, sizeof(double), compareDouble);
+         result->latencyP50 = percentile(m_latencySamples, m_numLatencySamples, 0.5);
+         result->latencyP99 = percentile(m_latencySamples, m_numLatencySamples, 0.99);
+         result->latencyP999 = percentile(m_latencySamples, m_numLatencySamples, 0.999);
+         result->latencyMax = m_latencySamples[m_numLatencySamples-1];
+      }
+      if (result->numReceived + result->numSuperseded < result->numSent)
+      {
+         printf("%s: %lu of %lu messages were not delivered\n", transportName(transport),
+               (unsigned long) (result->numSent-result->numReceived-result->numSuperseded), (unsigned long) result->numSent);
+      }
+      if (result->numSuperseded > 0)
+      {
+         printf("%s: %lu of %lu messages were superseded by a newer value before delivery\n", transportName(transport),
+               (unsigned long) result->numSuperseded, (unsigned long) result->numSent);
+      }
+   }
+
+   //teardown, the server connections own the testsockets
+   if (transport == BENCH_TRANSPORT_INPROC)
+   {
+      apx_testServer_destroy(&server);
+   }
+   for (i=0; i<numClients; i++)
+   {
+      benchClient_disconnect(&clients[i]);
+      benchClient_destroy(&clients[i]);
+   }
+   if (serverPid > 0)
+   {
+      stopServer(serverPid);
+   }
+   free(clients);
+   if (retval != 0)
+   {
+      free(result->connectTimes);
+      result->connectTimes = 0;
+   }
+   return retval;
+}
+
+static void printResult(const benchResult_t *result)
+{
+   printf("%-8s %12.0f %12.2f %10.1f %10.1f %10.1f %12.2f %12.2f\n", transportName(result->transport), result->msgsPerSec,
+         result->bytesPerSec/(1024.0*1024.0), result->latencyP50, result->latencyP99, result->latencyP999,
+         result->connectAvg/1000.0, result->cpuPerMsg);
+}
+
+static int writeJson(const char *fileName, const benchResult_t *results, int numResults)
+{
+   int i;
+   FILE *fh = fopen(fileName, "w");
+   if (fh == 0)
+   {
+      return -1;
+   }
+   fprintf(fh, "[\n");
+   for (i=0; i<numResults; i++)
+   {
+      const benchResult_t *result = &results[i];
+      uint32_t j;
+      fprintf(fh, "  {\n");
+      fprintf(fh, "    \"transport\": \"%s\",\n", transportName(result->transport));
+      fprintf(fh, "    \"clients\": %u,\n", (unsigned int) result->numClients);
+      fprintf(fh, "    \"signalsPerClient\": %u,\n", (unsigned int) result->numSignals);
+      fprintf(fh, "    \"ratePerClient\": %u,\n", (unsigned int) result->rate);
+      fprintf(fh, "    \"duration\": %.3f,\n", result->duration);
+      fprintf(fh, "    \"messagesSent\": %lu,\n", (unsigned long) result->numSent);
+      fprintf(fh, "    \"messagesReceived\": %lu,\n", (unsigned long) result->numReceived);
+      fprintf(fh, "    \"messagesSuperseded\": %lu,\n", (unsigned long) result->numSuperseded);
+      fprintf(fh, "    \"bytesSent\": %lu,\n", (unsigned long) result->bytesSent);
+      fprintf(fh, "    \"bytesReceived\": %lu,\n", (unsigned long) result->bytesReceived);
+      fprintf(fh, "    \"msgsPerSec\": %.1f,\n", result->msgsPerSec);
+      fprintf(fh, "    \"bytesPerSec\": %.1f,\n", result->bytesPerSec);
+      fprintf(fh, "    \"latencyUs\": {\"samples\": %u, \"p50\": %.2f, \"p99\": %.2f, \"p999\": %.2f, \"max\": %.2f},\n",
+            (unsigned int) result->numLatencySamples, result->latencyP50, result->latencyP99, result->latencyP999, result->latencyMax);
+      fprintf(fh, "    \"connectUs\": {\"min\": %.1f, \"avg\": %.1f, \"max\": %.1f, \"perNode\": [", result->connectMin,
+            result->connectAvg, result->connectMax);
+      for (j=0; j<result->numClients; j++)
+      {
+         fprintf(fh, "%s%.1f", (j == 0)? "" : ", ", result->connectTimes[j]);
+      }
+      fprintf(fh, "]},\n");
+      fprintf(fh, "    \"cpuUsPerMsg\": %.3f\n", result->cpuPerMsg);
+      fprintf(fh, "  }%s\n", (i+1 < numResults)? "," : "");
+   }
+   fprintf(fh, "]\n");
+   fclose(fh);
+   return 0;
+}
+
+static const char *transportName(uint8_t transport)
+{
+   return (transport == BENCH_TRANSPORT_TCP)? "tcp" : "inproc";
+}
+
+static double getTimeSec(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((double) ts.tv_sec) + ((double) ts.tv_nsec)*1e-9;
+}
+
+/**
+ * returns CPU time (user+system) consumed by this process and, when the broker was started by us, the broker process
+ */
+static double getCpuTimeSec(pid_t serverPid)
+{
+   struct rusage usage;
+   double cpuTime = 0.0;
+   if (getrusage(RUSAGE_SELF, &usage) == 0)
+   {
+      cpuTime = ((double) usage.ru_utime.tv_sec) + ((double) usage.ru_utime.tv_usec)*1e-6 +
+                ((double) usage.ru_stime.tv_sec) + ((double) usage.ru_stime.tv_usec)*1e-6;
+   }
+#ifdef __linux__
+   if (serverPid > 0)
+   {
+      char path[64];
+      FILE *fh;
+      sprintf(path, "/proc/%d/stat", (int) serverPid);
+      fh = fopen(path, "r");
+      if (fh != 0)
+      {
+         unsigned long utime = 0;
+         unsigned long stime = 0;
+         //fields 14 and 15 are utime and stime in clock ticks
+         if (fscanf(fh, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) == 2)
+         {
+            cpuTime += ((double) (utime+stime)) / (double) sysconf(_SC_CLK_TCK);
+         }
+         fclose(fh);
+      }
+   }
+#else
+   (void) serverPid;
+#endif
+   return cpuTime;
+}
+
+static pid_t startServer(const char *path, uint16_t port)
+{
+   pid_t pid = fork();
+   if (pid == 0)
+   {
+      char portArg[16];
+      sprintf(portArg, "-p%u", (unsigned int) port);
+      execl(path, path, portArg, (char*) 0);
+      _exit(127);
+   }
+   return pid;
+}
+
+static void stopServer(pid_t pid)
+{
+   kill(pid, SIGTERM);
+   waitpid(pid, 0, 0);
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+   double lhs = *(const double*) a;
+   double rhs = *(const double*) b;
+   return (lhs < rhs)? -1 : ((lhs > rhs)? 1 : 0);
+}
+
+static double percentile(const double *sorted, uint32_t len, double p)
+{
+   uint32_t index = (uint32_t) (p * (double) len);
+   if (index >= len)
+   {
+      index = len-1;
+   }
+   return sorted[index];
+}
+
+static char *readTextFile(const char *fileName, uint32_t *len)
+{
+   char *data = 0;
+   FILE *fh = fopen(fileName, "rb");
+   if (fh != 0)
+   {
+      long fileLen;
+      fseek(fh, 0, SEEK_END);
+      fileLen = ftell(fh);
+      fseek(fh, 0, SEEK_SET);
+      if (fileLen >= 0)
+      {
+         data = (char*) malloc((size_t) fileLen+1u);
+         if ( (data != 0) && (fread(data, 1, (size_t) fileLen, fh) == (size_t) fileLen) )
+         {
+            data[fileLen] = 0;
+            *len = (uint32_t) fileLen;
+         }
+         else
+         {
+            free(data);
+            data = 0;
+         }
+      }
+      fclose(fh);
+   }
+   return data;
+}
+
+/**
+ * creates the APX definition of a client. The benchmark signals are placed before any other port so that signal k is
+ * found at offset k*BENCH_SIGNAL_SIZE in both the .out and .in file.
+ * When apxText is given, the node in it is renamed to self->name and its ports and types are kept.
+ */
+static char *createDefinition(const benchClient_t *self, const char *apxText, uint32_t prevId, uint32_t *len)
+{
+   uint32_t k;
+   size_t allocLen = ((size_t) self->numSignals*2u + 4u)*BENCH_MAX_NAME_LEN + ((apxText != 0)? strlen(apxText) : 0u);
+   char *data = (char*) malloc(allocLen);
+   char *p = data;
+   bool isSignalsWritten = false;
+   if (data == 0)
+   {
+      return 0;
+   }
+   if (apxText == 0)
+   {
+      p += sprintf(p, "APX/1.2\nN\"%s\"\n", self->name);
+   }
+   else
+   {
+      const char *pNext = apxText;
+      while (*pNext != 0)
+      {
+         const char *pEnd = strchr(pNext, '\n');
+         size_t lineLen = (pEnd != 0)? (size_t) (pEnd-pNext) : strlen(pNext);
+         if ( (lineLen > 0) && (pNext[lineLen-1] == '\r') )
+         {
+            lineLen--;
+         }
+         if ( (!isSignalsWritten) && ( (pNext[0] == 'P') || (pNext[0] == 'R') ) )
+         {
+            for (k=0; k<self->numSignals; k++)
+            {
+               p += sprintf(p, "P\"BenchSignal%u_%u\"L\n", (unsigned int) self->id, (unsigned int) k);
+            }
+            for (k=0; k<self->numSignals; k++)
+            {
+               p += sprintf(p, "R\"BenchSignal%u_%u\"L\n", (unsigned int) prevId, (unsigned int) k);
+            }
+            isSignalsWritten = true;
+         }
+         if ( (lineLen == 0) && (isSignalsWritten) )
+         {
+            break; //node ends at first empty line
+         }
+         if (pNext[0] == 'N')
+         {
+            p += sprintf(p, "N\"%s\"\n", self->name);
+         }
+         else if (lineLen > 0)
+         {
+            memcpy(p, pNext, lineLen);
+            p += lineLen;
+            *p++ = '\n';
+         }
+         if (pEnd == 0)
+         {
+            break;
+         }
+         pNext = pEnd+1;
+      }
+   }
+   if (!isSignalsWritten)
+   {
+      for (k=0; k<self->numSignals; k++)
+      {
+         p += sprintf(p, "P\"BenchSignal%u_%u\"L\n", (unsigned int) self->id, (unsigned int) k);
+      }
+      for (k=0; k<self->numSignals; k++)
+      {
+         p += sprintf(p, "R\"BenchSignal%u_%u\"L\n", (unsigned int) prevId, (unsigned int) k);
+      }
+   }
+   p += sprintf(p, "\n");
+   *len = (uint32_t) (p-data);
+   return data;
+}
+
+static int8_t benchClient_create(benchClient_t *self, uint32_t id, uint32_t prevId, const benchConfig_t *cfg, uint8_t transport)
+{
+   char *apxText = 0;
+   memset(self, 0, sizeof(benchClient_t));
+   self->id = id;
+   self->numSignals = cfg->numSignals;
+   self->transport = transport;
+   self->fd = -1;
+   self->nextSeq = 1u; //zero is the init value of the signals
+   if (cfg->numApxFiles > 0)
+   {
+      uint32_t apxLen;
+      const char *fileName = cfg->apxFiles[id % (uint32_t) cfg->numApxFiles];
+      const char *baseName = strrchr(fileName, '/');
+      const char *pExt;
+      int baseLen;
+      baseName = (baseName != 0)? baseName+1 : fileName;
+      pExt = strrchr(baseName, '.');
+      baseLen = (pExt != 0)? (int) (pExt-baseName) : (int) strlen(baseName);
+      if (baseLen > (int) BENCH_MAX_NAME_LEN-16)
+      {
+         baseLen = (int) BENCH_MAX_NAME_LEN-16;
+      }
+      snprintf(self->name, BENCH_MAX_NAME_LEN, "%.*s_%u", baseLen, baseName, (unsigned int) id);
+      apxText = readTextFile(fileName, &apxLen);
+      if (apxText == 0)
+      {
+         printf("Failed to read %s\n", fileName);
+         return -1;
+      }
+   }
+   else
+   {
+      snprintf(self->name, BENCH_MAX_NAME_LEN, "BenchNode%u", (unsigned int) id);
+   }
+   self->definition = createDefinition(self, apxText, prevId, &self->definitionLen);
+   free(apxText);
+   if (self->definition == 0)
+   {
+      return -1;
+   }
+   adt_bytearray_create(&self->rxBuf, BENCH_RECV_CHUNK);
+   adt_bytearray_create(&self->procBuf, BENCH_RECV_CHUNK);
+   adt_bytearray_create(&self->txBuf, 0);
+   MUTEX_INIT(self->rxLock);
+   return benchClient_parseDefinition(self);
+}
+
+static void benchClient_destroy(benchClient_t *self)
+{
+   if (self->definition != 0)
+   {
+      adt_bytearray_destroy(&self->rxBuf);
+      adt_bytearray_destroy(&self->procBuf);
+      adt_bytearray_destroy(&self->txBuf);
+      MUTEX_DESTROY(self->rxLock);
+      free(self->definition);
+      free(self->outData);
+      free(self->serverSendBuf);
+   }
+}
+
+/**
+ * parses the generated definition to learn the lengths and init data of the port data files
+ */
+static int8_t benchClient_parseDefinition(benchClient_t *self)
+{
+   apx_parser_t parser;
+   apx_istream_t istream;
+   apx_istream_handler_t handler;
+   int8_t retval = -1;
+   apx_parser_create(&parser);
+   memset(&handler, 0, sizeof(handler));
+   handler.arg = &parser;
+   handler.open = apx_parser_vopen;
+   handler.close = apx_parser_vclose;
+   handler.node = apx_parser_vnode;
+   handler.datatype = apx_parser_vdatatype;
+   handler.provide = apx_parser_vprovide;
+   handler.require = apx_parser_vrequire;
+   handler.node_end = apx_parser_vnode_end;
+   apx_istream_create(&istream, &handler);
+   apx_istream_open(&istream);
+   apx_istream_write(&istream, (const uint8_t*) self->definition, self->definitionLen);
+   apx_istream_close(&istream);
+   if (apx_parser_getNumNodes(&parser) == 1)
+   {
+      apx_node_t *node = apx_parser_getNode(&parser, 0);
+      self->outDataLen = apx_node_getOutPortDataLen(node);
+      self->inDataLen = apx_node_getInPortDataLen(node);
+      if (self->outDataLen >= self->numSignals*BENCH_SIGNAL_SIZE)
+      {
+         self->outData = (uint8_t*) malloc(self->outDataLen);
+         if (self->outData != 0)
+         {
+            memcpy(self->outData, apx_node_getOutPortInitData(node), self->outDataLen);
+            retval = 0;
+         }
+      }
+   }
+   if (retval != 0)
+   {
+      printf("Failed to parse definition of %s\n", self->name);
+   }
+   apx_istream_destroy(&istream);
+   apx_parser_destroy(&parser);
+   return retval;
+}
+
+static int8_t benchClient_connect(benchClient_t *self, apx_testServer_t *server, uint16_t tcpPort)
+{
+   self->connectStart = getTimeSec();
+   if (self->transport == BENCH_TRANSPORT_INPROC)
+   {
+      apx_serverConnection_t *connection;
+      apx_transmitHandler_t transmitHandler;
+      adt_list_elem_t *elem;
+      self->testsocket = testsocket_new();
+      if (self->testsocket == 0)
+      {
+         return -1;
+      }
+      apx_testServer_accept(server, self->testsocket);
+      elem = adt_list_last(&server->connections);
+      if (elem == 0)
+      {
+         return -1;
+      }
+      //deliver server messages directly into our receive buffer, they are sent from the server worker threads
+      connection = (apx_serverConnection_t*) elem->pItem;
+      transmitHandler.arg = self;
+      transmitHandler.getSendAvail = 0;
+      transmitHandler.getSendBuffer = benchClient_getSendBuffer;
+      transmitHandler.send = benchClient_serverSend;
+      apx_fileManager_setTransmitHandler(&connection->fileManager, &transmitHandler);
+   }
+   else
+   {
+      struct sockaddr_in addr;
+      int flag = 1;
+      double start = self->connectStart;
+      memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(tcpPort);
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      for(;;)
+      {
+         self->fd = socket(AF_INET, SOCK_STREAM, 0);
+         if (self->fd < 0)
+         {
+            return -1;
+         }
+         if (connect(self->fd, (struct sockaddr*) &addr, sizeof(addr)) == 0)
+         {
+            break;
+         }
+         close(self->fd);
+         self->fd = -1;
+         //the broker may still be starting up
+         if ( (errno != ECONNREFUSED) || (getTimeSec() - start > BENCH_CONNECT_TIMEOUT) )
+         {
+            return -1;
+         }
+         usleep(10000);
+         self->connectStart = getTimeSec();
+      }
+      setsockopt(self->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+      fcntl(self->fd, F_SETFL, fcntl(self->fd, F_GETFL, 0) | O_NONBLOCK);
+   }
+   return benchClient_sendFrame(self, (const uint8_t*) BENCH_GREETING, (uint32_t) strlen(BENCH_GREETING));
+}
+
+static void benchClient_disconnect(benchClient_t *self)
+{
+   if (self->fd >= 0)
+   {
+      close(self->fd);
+      self->fd = -1;
+   }
+   self->testsocket = 0;
+}
+
+static int8_t benchClient_sendFrame(benchClient_t *self, const uint8_t *msgBuf, uint32_t msgLen)
+{
+   uint8_t *frame;
+   uint8_t *pBegin;
+   uint8_t *headerEnd;
+   uint32_t frameLen;
+   if (adt_bytearray_resize(&self->txBuf, msgLen+BENCH_MAX_FRAME_HEADER) != 0)
+   {
+      return -1;
+   }
+   frame = adt_bytearray_data(&self->txBuf);
+   headerEnd = headerutil_numEncode32(frame, BENCH_MAX_FRAME_HEADER, msgLen);
+   if (headerEnd <= frame)
+   {
+      return -1;
+   }
+   memcpy(headerEnd, msgBuf, msgLen);
+   frameLen = (uint32_t) (headerEnd-frame) + msgLen;
+   if (self->transport == BENCH_TRANSPORT_INPROC)
+   {
+      testsocket_clientSend(self->testsocket, frame, frameLen);
+   }
+   else
+   {
+      pBegin = frame;
+      while (frameLen > 0)
+      {
+         ssize_t result = send(self->fd, pBegin, frameLen, 0);
+         if (result > 0)
+         {
+            pBegin += result;
+            frameLen -= (uint32_t) result;
+         }
+         else if ( (result < 0) && ( (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR) ) )
+         {
+            struct pollfd pfd;
+            pfd.fd = self->fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            poll(&pfd, 1, 10);
+         }
+         else
+         {
+            return -1;
+         }
+      }
+   }
+   return 0;
+}
+
+static int8_t benchClient_sendFileInfo(benchClient_t *self, const char *suffix, uint32_t address, uint32_t length)
+{
+   uint8_t buf[RMF_MAX_CMD_BUF_SIZE];
+   char fileName[BENCH_MAX_NAME_LEN+8];
+   rmf_fileInfo_t fileInfo;
+   int32_t headerLen;
+   int32_t dataLen;
+   sprintf(fileName, "%s%s", self->name, suffix);
+   rmf_fileInfo_create(&fileInfo, fileName, address, length, RMF_FILE_TYPE_FIXED);
+   headerLen = rmf_packHeader(buf, RMF_MAX_HEADER_SIZE, RMF_CMD_START_ADDR, false);
+   dataLen = rmf_serialize_cmdFileInfo(&buf[headerLen], (int32_t) sizeof(buf) - headerLen, &fileInfo);
+   rmf_fileInfo_destroy(&fileInfo);
+   if ( (headerLen <= 0) || (dataLen <= 0) )
+   {
+      return -1;
+   }
+   return benchClient_sendFrame(self, buf, (uint32_t) (headerLen+dataLen));
+}
+
+static int8_t benchClient_sendFileOpen(benchClient_t *self, uint32_t address)
+{
+   uint8_t buf[RMF_MAX_HEADER_SIZE+RMF_FILE_OPEN_CMD_LEN];
+   rmf_cmdOpenFile_t cmdOpenFile;
+   int32_t headerLen;
+   int32_t dataLen;
+   cmdOpenFile.address = address;
+   headerLen = rmf_packHeader(buf, RMF_MAX_HEADER_SIZE, RMF_CMD_START_ADDR, false);
+   dataLen = rmf_serialize_cmdOpenFile(&buf[headerLen], (int32_t) sizeof(buf) - headerLen, &cmdOpenFile);
+   if ( (headerLen <= 0) || (dataLen <= 0) )
+   {
+      return -1;
+   }
+   return benchClient_sendFrame(self, buf, (uint32_t) (headerLen+dataLen));
+}
+
+static int8_t benchClient_sendData(benchClient_t *self, uint32_t address, const uint8_t *data, uint32_t dataLen)
+{
+   int8_t result;
+   uint8_t *msgBuf = (uint8_t*) malloc(RMF_MAX_HEADER_SIZE+dataLen);
+   int32_t headerLen;
+   if (msgBuf == 0)
+   {
+      return -1;
+   }
+   headerLen = rmf_packHeader(msgBuf, RMF_MAX_HEADER_SIZE, address, false);
+   if (headerLen <= 0)
+   {
+      free(msgBuf);
+      return -1;
+   }
+   memcpy(&msgBuf[headerLen], data, dataLen);
+   result = benchClient_sendFrame(self, msgBuf, (uint32_t) headerLen + dataLen);
+   free(msgBuf);
+   return result;
+}
+
+/**
+ * writes the next sequence number into the next signal of this client
+ */
+static int8_t benchClient_sendSignal(benchClient_t *self)
+{
+   uint8_t msgBuf[RMF_LOW_ADDRESS_SIZE+BENCH_SIGNAL_SIZE];
+   uint32_t seq = self->nextSeq++;
+   uint32_t offset = (seq % self->numSignals)*BENCH_SIGNAL_SIZE;
+   uint32_t ringIndex = seq & (BENCH_SEQ_RING_LEN-1u);
+   int32_t headerLen = rmf_packHeader(msgBuf, (int32_t) sizeof(msgBuf), BENCH_OUTDATA_ADDRESS+offset, false);
+   if (headerLen <= 0)
+   {
+      return -1;
+   }
+   packLE(&msgBuf[headerLen], seq, (uint8_t) BENCH_SIGNAL_SIZE);
+   self->sendSeq[ringIndex] = seq;
+   self->sendTime[ringIndex] = getTimeSec();
+   if (benchClient_sendFrame(self, msgBuf, (uint32_t) headerLen + BENCH_SIGNAL_SIZE) != 0)
+   {
+      return -1;
+   }
+   self->numSent++;
+   self->bytesSent += (uint64_t) headerLen + BENCH_SIGNAL_SIZE;
+   return 0;
+}
+
+/**
+ * moves received bytes into procBuf and parses all complete messages. Returns number of parsed messages
+ */
+static uint32_t benchClient_receive(benchClient_t *self)
+{
+   uint32_t numMessages = 0;
+   const uint8_t *pBegin;
+   const uint8_t *pNext;
+   const uint8_t *pEnd;
+   if (self->transport == BENCH_TRANSPORT_INPROC)
+   {
+      MUTEX_LOCK(self->rxLock);
+      if (adt_bytearray_length(&self->rxBuf) > 0)
+      {
+         adt_bytearray_append(&self->procBuf, adt_bytearray_data(&self->rxBuf), adt_bytearray_length(&self->rxBuf));
+         adt_bytearray_clear(&self->rxBuf);
+      }
+      MUTEX_UNLOCK(self->rxLock);
+   }
+   else if (self->fd >= 0)
+   {
+      uint8_t chunk[BENCH_RECV_CHUNK];
+      for(;;)
+      {
+         ssize_t result = recv(self->fd, chunk, sizeof(chunk), 0);
+         if (result <= 0)
+         {
+            break;
+         }
+         adt_bytearray_append(&self->procBuf, chunk, (uint32_t) result);
+      }
+   }
+   pBegin = adt_bytearray_data(&self->procBuf);
+   pEnd = pBegin + adt_bytearray_length(&self->procBuf);
+   pNext = pBegin;
+   while (pNext < pEnd)
+   {
+      uint32_t msgLen;
+      const uint8_t *pResult = headerutil_numDecode32(pNext, pEnd, &msgLen);
+      if ( (pResult <= pNext) || (pResult+msgLen > pEnd) )
+      {
+         break;
+      }
+      benchClient_processMsg(self, pResult, msgLen);
+      pNext = pResult+msgLen;
+      numMessages++;
+   }
+   if (pNext > pBegin)
+   {
+      adt_bytearray_trimLeft(&self->procBuf, pNext);
+   }
+   return numMessages;
+}
+
+static void benchClient_processMsg(benchClient_t *self, const uint8_t *msgBuf, uint32_t msgLen)
+{
+   rmf_msg_t msg;
+   if (rmf_unpackMsg(msgBuf, (int32_t) msgLen, &msg) <= 0)
+   {
+      return;
+   }
+   if (msg.address == RMF_CMD_START_ADDR)
+   {
+      benchClient_processCmd(self, msg.data, (uint32_t) msg.dataLen);
+   }
+   else if ( (self->inDataLen > 0) && (msg.address >= self->inAddress) && (msg.address < self->inAddress+self->inDataLen) )
+   {
+      benchClient_processData(self, msg.address-self->inAddress, msg.data, (uint32_t) msg.dataLen);
+   }
+}
+
+static void benchClient_processCmd(benchClient_t *self, const uint8_t *cmdBuf, uint32_t cmdLen)
+{
+   uint32_t cmdType;
+   if (rmf_deserialize_cmdType(cmdBuf, (int32_t) cmdLen, &cmdType) <= 0)
+   {
+      return;
+   }
+   if (cmdType == RMF_CMD_ACK)
+   {
+      if (!self->isAckSeen)
+      {
+         self->isAckSeen = true;
+         //the .out file must be known by the broker before it parses the definition
+         benchClient_sendFileInfo(self, ".out", BENCH_OUTDATA_ADDRESS, self->outDataLen);
+         benchClient_sendFileInfo(self, ".apx", BENCH_DEFINITION_ADDRESS, self->definitionLen);
+      }
+   }
+   else if (cmdType == RMF_CMD_FILE_INFO)
+   {
+      rmf_fileInfo_t fileInfo;
+      if (rmf_deserialize_cmdFileInfo(cmdBuf, (int32_t) cmdLen, &fileInfo) > 0)
+      {
+         size_t nameLen = strlen(fileInfo.name);
+         if ( (nameLen > 3) && (strcmp(&fileInfo.name[nameLen-3], ".in") == 0) )
+         {
+            self->inAddress = fileInfo.address;
+            self->inDataLen = fileInfo.length;
+            benchClient_sendFileOpen(self, fileInfo.address);
+         }
+      }
+   }
+   else if (cmdType == RMF_CMD_FILE_OPEN)
+   {
+      rmf_cmdOpenFile_t cmdOpenFile;
+      if (rmf_deserialize_cmdOpenFile(cmdBuf, (int32_t) cmdLen, &cmdOpenFile) > 0)
+      {
+         if (cmdOpenFile.address == BENCH_DEFINITION_ADDRESS)
+         {
+            benchClient_sendData(self, BENCH_DEFINITION_ADDRESS, (const uint8_t*) self->definition, self->definitionLen);
+         }
+         else if (cmdOpenFile.address == BENCH_OUTDATA_ADDRESS)
+         {
+            benchClient_sendData(self, BENCH_OUTDATA_ADDRESS, self->outData, self->outDataLen);
+            self->isOutOpened = true;
+         }
+      }
+   }
+   if ( (!self->isConnected) && self->isOutOpened && self->isInReceived)
+   {
+      self->isConnected = true;
+      self->connectTime = getTimeSec() - self->connectStart;
+   }
+}
+
+/**
+ * handles writes into our .in file, every benchmark signal contains the sequence number written by the provider
+ */
+static void benchClient_processData(benchClient_t *self, uint32_t offset, const uint8_t *data, uint32_t dataLen)
+{
+   uint32_t signalAreaLen = self->numSignals*BENCH_SIGNAL_SIZE;
+   if (!self->isInReceived)
+   {
+      //the first write is the initial content of the whole file
+      self->isInReceived = true;
+      if ( (!self->isConnected) && self->isOutOpened)
+      {
+         self->isConnected = true;
+         self->connectTime = getTimeSec() - self->connectStart;
+      }
+      return;
+   }
+   if ( (offset < signalAreaLen) && ( (offset % BENCH_SIGNAL_SIZE) == 0) )
+   {
+      const uint8_t *pNext = data;
+      const uint8_t *pEnd = data + dataLen;
+      double now = getTimeSec();
+      benchClient_t *provider = self->provider;
+      while ( (pNext+BENCH_SIGNAL_SIZE <= pEnd) && (offset < signalAreaLen) )
+      {
+         uint32_t seq = (uint32_t) unpackLE(pNext, (uint8_t) BENCH_SIGNAL_SIZE);
+         uint32_t ringIndex = seq & (BENCH_SEQ_RING_LEN-1u);
+         //zero is the init value, sent when a provider connects after this client
+         if (seq != 0)
+         {
+            self->numReceived++;
+            self->bytesReceived += BENCH_SIGNAL_SIZE;
+            if (seq > self->maxSeqReceived)
+            {
+               self->maxSeqReceived = seq;
+            }
+            if ( (provider->sendSeq[ringIndex] == seq) && (m_numLatencySamples < BENCH_MAX_LATENCY_SAMPLES) )
+            {
+               m_latencySamples[m_numLatencySamples++] = (now - provider->sendTime[ringIndex])*1e6;
+            }
+         }
+         pNext += BENCH_SIGNAL_SIZE;
+         offset += BENCH_SIGNAL_SIZE;
+      }
+   }
+}
+
+/**
+ * transmit handler of the server side fileManager (inproc transport). Mirrors apx_serverConnection_getSendBuffer.
+ */
+static uint8_t *benchClient_getSendBuffer(void *arg, int32_t msgLen)
+{
+   benchClient_t *self = (benchClient_t*) arg;
+   int32_t requestedLen = msgLen + (int32_t) BENCH_MAX_FRAME_HEADER;
+   if (requestedLen > self->serverSendBufLen)
+   {
+      uint8_t *buf = (uint8_t*) realloc(self->serverSendBuf, (size_t) requestedLen);
+      if (buf == 0)
+      {
+         return 0;
+      }
+      self->serverSendBuf = buf;
+      self->serverSendBufLen = requestedLen;
+   }
+   return &self->serverSendBuf[BENCH_MAX_FRAME_HEADER];
+}
+
+static int32_t benchClient_serverSend(void *arg, int32_t offset, int32_t msgLen)
+{
+   benchClient_t *self = (benchClient_t*) arg;
+   uint8_t header[BENCH_MAX_FRAME_HEADER];
+   uint8_t *headerEnd = headerutil_numEncode32(header, (uint32_t) sizeof(header), (uint32_t) msgLen);
+   if ( (headerEnd <= header) || (offset+msgLen+(int32_t) BENCH_MAX_FRAME_HEADER > self->serverSendBufLen) )
+   {
+      return -1;
+   }
+   MUTEX_LOCK(self->rxLock);
+   adt_bytearray_append(&self->rxBuf, header, (uint32_t) (headerEnd-header));
+   adt_bytearray_append(&self->rxBuf, &self->serverSendBuf[BENCH_MAX_FRAME_HEADER+offset], (uint32_t) msgLen);
+   MUTEX_UNLOCK(self->rxLock);
+   sem_post(&m_rxSemaphore);
+   return 0;
+}
+
+/**
+ * lets the broker process what clients have sent and lets clients process what the broker has sent.
+ * Returns number of messages received by clients.
+ */
+static uint32_t pumpClients(benchClient_t *clients, uint32_t numClients)
+{
+   uint32_t numMessages = 0;
+   uint32_t i;
+   if (clients[0].transport == BENCH_TRANSPORT_INPROC)
+   {
+      //data arriving after this point posts the semaphore again and ends the next waitForData early
+      while (sem_trywait(&m_rxSemaphore) == 0)
+      {
+      }
+   }
+   for (i=0; i<numClients; i++)
+   {
+      if (clients[i].testsocket != 0)
+      {
+         testsocket_run(clients[i].testsocket);
+      }
+   }
+   for (i=0; i<numClients; i++)
+   {
+      numMessages += benchClient_receive(&clients[i]);
+   }
+   return numMessages;
+}
+
+static void waitForData(benchClient_t *clients, uint32_t numClients, double timeout)
+{
+   if (clients[0].transport == BENCH_TRANSPORT_INPROC)
+   {
+      struct timespec ts;
+      long nsec;
+      clock_gettime(CLOCK_REALTIME, &ts);
+      nsec = ts.tv_nsec + (long) (timeout*1e9);
+      ts.tv_sec += nsec / 1000000000L;
+      ts.tv_nsec = nsec % 1000000000L;
+      while ( (sem_timedwait(&m_rxSemaphore, &ts) != 0) && (errno == EINTR) )
+      {
+      }
+   }
+   else
+   {
+      struct pollfd pfds[BENCH_MAX_POLL_FDS];
+      //clients beyond BENCH_MAX_POLL_FDS are served by the next pumpClients call
+      uint32_t numFds = (numClients < BENCH_MAX_POLL_FDS)? numClients : BENCH_MAX_POLL_FDS;
+      uint32_t i;
+      int timeoutMs = (int) (timeout*1000.0);
+      for (i=0; i<numFds; i++)
+      {
+         pfds[i].fd = clients[i].fd;
+         pfds[i].events = POLLIN;
+         pfds[i].revents = 0;
+      }
+      poll(pfds, numFds, (timeoutMs > 0)? timeoutMs : 1);
+   }
+}
@@ -0,0 +1,65 @@
+/**
+ * file: apx_adminSocket.h
+ * description: local (unix domain) socket used to query the server at runtime. A client connects, sends a single request
+ *              line and receives the response before the server closes the connection, e.g. "echo json | nc -U <path>".
+ *              Only available on POSIX platforms.
+ */
+#ifndef APX_ADMIN_SOCKET_H
+#define APX_ADMIN_SOCKET_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#if defined(_MSC_PLATFORM_TOOLSET) && (_MSC_PLATFORM_TOOLSET<=110)
+#include "msc_bool.h"
+#else
+#include <stdbool.h>
+#endif
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+#include "osmacro.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define APX_ADMIN_SOCKET_MAX_REQUEST_LEN 128u
+
+/**
+ * writes the response to request (without line ending) into response. Returns number of characters written or -1 on error.
+ */
+typedef int32_t (apx_adminSocket_handler_t)(void *arg, const char *request, char *response, uint32_t responseLen);
+
+typedef struct apx_adminSocket_tag
+{
+   char *path; //strong pointer, socket file path
+   int listenFd;
+   THREAD_T workerThread;
+   bool workerThreadValid;
+   volatile bool isRunning;
+   apx_adminSocket_handler_t *handler;
+   void *handlerArg;
+   char *responseBuf; //strong pointer
+   uint32_t responseBufLen;
+#ifdef _WIN32
+   unsigned int threadId;
+#endif
+}apx_adminSocket_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+int8_t apx_adminSocket_create(apx_adminSocket_t *self, apx_adminSocket_handler_t *handler, void *arg, uint32_t responseBufLen);
+void apx_adminSocket_destroy(apx_adminSocket_t *self);
+int8_t apx_adminSocket_start(apx_adminSocket_t *self, const char *path);
+void apx_adminSocket_stop(apx_adminSocket_t *self);
+
+#endif //APX_ADMIN_SOCKET_H
@@ -14,6 +14,10 @@
 #include "apx_serverConnection.h"
 #include "apx_router.h"
 #include "adt_list.h"
+#include "adt_ary.h"
+#include "apx_server_cfg.h"
+#include "apx_adminSocket.h"
+#include "apx_connectionStats.h"
 
 
 
@@ -32,8 +36,24 @@ typedef struct apx_server_tag
    apx_router_t router; //this component handles all routing tables within the server
    MUTEX_T mutex;
    int8_t debugMode;
+   apx_adminSocket_t adminSocket; //optional runtime query interface
+   SPINLOCK_T statsLock; //protects the cached statistics below
+   apx_routerStats_t routerStats; //cached by apx_server_updateStats, read by the statistics file of each connection
+   uint32_t numConnections;
+   apx_capture_t *capture; //weak pointer, 0 when traffic capture is disabled
+   adt_ary_t pendingDisconnects; //weak references to lost connections waiting for teardown, protected by mutex
+   THREAD_T reclaimerThread; //detaches lost connections from the nodeManager and cleans up their msockets
+   SEMAPHORE_T reclaimerSemaphore;
+   bool reclaimerThreadValid; //protected by mutex
+   volatile bool isReclaimerRunning;
+#ifdef _MSC_VER
+   unsigned int reclaimerThreadId;
+#endif
 }apx_server_t;
 
+#define APX_SERVER_STATS_FORMAT_TEXT 0
+#define APX_SERVER_STATS_FORMAT_JSON 1
+
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
@@ -46,6 +66,10 @@ void apx_server_create(apx_server_t *self, uint16_t port);
 void apx_server_destroy(apx_server_t *self);
 void apx_server_start(apx_server_t *self);
 void apx_server_setDebugMode(apx_server_t *self, int8_t debugMode);
+int8_t apx_server_startAdminSocket(apx_server_t *self, const char *path);
+void apx_server_setCapture(apx_server_t *self, apx_capture_t *capture);
+void apx_server_updateStats(apx_server_t *self);
+int32_t apx_server_formatStats(apx_server_t *self, uint8_t format, char *buf, uint32_t bufLen);
 
 
 #endif //APX_SERVER_H
@@ -13,6 +13,7 @@
 #include "adt_bytearray.h"
 #include "apx_fileManager.h"
 #include "apx_nodeManager.h"
+#include "apx_capture.h"
 #ifdef _MSC_VER
 #include <Windows.h>
 #endif
@@ -43,6 +44,11 @@ typedef struct apx_serverConnection_tag
    int8_t debugMode;
    adt_bytearray_t sendBuffer;
    uint8_t numHeaderMaxLen;
+   apx_file_t *statsFile; //weak pointer to the server statistics file (owned by fileManager), 0 when not published
+   apx_capture_t *capture; //weak pointer, 0 when traffic capture is disabled
+   uint32_t captureId;
+   apx_fileManagerFrame_t *frames; //messages decoded from the current receive buffer
+   int32_t framesLen; //number of allocated elements in frames
 }apx_serverConnection_t;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -71,6 +77,7 @@ void apx_serverConnection_attachNodeManager(apx_serverConnection_t *self, apx_no
 void apx_serverConnection_detachNodeManager(apx_serverConnection_t *self, apx_nodeManager_t *nodeManager);
 void apx_serverConnection_start(apx_serverConnection_t *self);
 void apx_serverConnection_setDebugMode(apx_serverConnection_t *self, int8_t debugMode);
+void apx_serverConnection_setCapture(apx_serverConnection_t *self, apx_capture_t *capture);
 
 int8_t apx_serverConnection_dataReceived(apx_serverConnection_t *self, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen);
 
@@ -0,0 +1,37 @@
+#ifndef APX_SERVER_CFG_H
+#define APX_SERVER_CFG_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef APX_SERVER_STATS_FILE_NAME
+#define APX_SERVER_STATS_FILE_NAME "apx_server.stats" //user data file published to every client
+#endif
+#ifndef APX_SERVER_STATS_FILE_LEN
+#define APX_SERVER_STATS_FILE_LEN 1024u //JSON text padded with null characters
+#endif
+#ifndef APX_SERVER_STATS_INTERVAL_MS
+#define APX_SERVER_STATS_INTERVAL_MS 1000u //update period of the statistics file
+#endif
+#ifndef APX_SERVER_RECLAIM_WINDOW_MS
+#define APX_SERVER_RECLAIM_WINDOW_MS 20u //disconnects within this time after the first one are torn down as a single batch
+#endif
+#ifndef APX_SERVER_ADMIN_RESPONSE_LEN
+#define APX_SERVER_ADMIN_RESPONSE_LEN 65536u //max size of an admin socket response
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+
+#endif //APX_SERVER_CFG_H
@@ -0,0 +1,266 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <errno.h>
+#include <malloc.h>
+#include <string.h>
+#include <stdio.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#endif
+#include "apx_adminSocket.h"
+#include "apx_logging.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define POLL_INTERVAL_MS 200 //how often the worker thread checks isRunning
+#define RECEIVE_TIMEOUT_MS 1000 //clients must send their request within this time
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef _MSC_VER
+static THREAD_PROTO(threadTask,arg);
+static void apx_adminSocket_serveClient(apx_adminSocket_t *self, int fd);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+int8_t apx_adminSocket_create(apx_adminSocket_t *self, apx_adminSocket_handler_t *handler, void *arg, uint32_t responseBufLen)
+{
+   if ( (self != 0) && (handler != 0) && (responseBufLen > 0u) )
+   {
+      self->path = (char*) 0;
+      self->listenFd = -1;
+      self->workerThreadValid = false;
+      self->isRunning = false;
+      self->handler = handler;
+      self->handlerArg = arg;
+      self->responseBufLen = responseBufLen;
+      self->responseBuf = (char*) malloc(responseBufLen);
+      if (self->responseBuf == 0)
+      {
+         errno = ENOMEM;
+         return -1;
+      }
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+void apx_adminSocket_destroy(apx_adminSocket_t *self)
+{
+   if (self != 0)
+   {
+      apx_adminSocket_stop(self);
+      if (self->responseBuf != 0)
+      {
+         free(self->responseBuf);
+         self->responseBuf = (char*) 0;
+      }
+   }
+}
+
+/**
+ * binds the socket to path (an existing socket file is replaced) and starts the worker thread
+ */
+int8_t apx_adminSocket_start(apx_adminSocket_t *self, const char *path)
+{
+#ifdef _MSC_VER
+   (void) self;
+   (void) path;
+   errno = ENOTSUP;
+   return -1;
+#else
+   if ( (self != 0) && (path != 0) && (self->workerThreadValid == false) )
+   {
+      struct sockaddr_un addr;
+      size_t pathLen = strlen(path);
+      int rc;
+      if (pathLen >= sizeof(addr.sun_path))
+      {
+         errno = ENAMETOOLONG;
+         return -1;
+      }
+      self->path = (char*) malloc(pathLen+1);
+      if (self->path == 0)
+      {
+         errno = ENOMEM;
+         return -1;
+      }
+      memcpy(self->path, path, pathLen+1);
+      memset(&addr, 0, sizeof(addr));
+      addr.sun_family = AF_UNIX;
+      memcpy(addr.sun_path, path, pathLen+1);
+      self->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (self->listenFd < 0)
+      {
+         APX_LOG_ERROR("[APX_ADMIN_SOCKET] socket() failed, errno=%d", errno);
+         apx_adminSocket_stop(self);
+         return -1;
+      }
+      (void) unlink(path);
+      if ( (bind(self->listenFd, (struct sockaddr*) &addr, sizeof(addr)) != 0) || (listen(self->listenFd, 4) != 0) )
+      {
+         APX_LOG_ERROR("[APX_ADMIN_SOCKET] cannot listen on %s, errno=%d", path, errno);
+         apx_adminSocket_stop(self);
+         return -1;
+      }
+      self->isRunning = true;
+      self->workerThreadValid = true;
+      rc = THREAD_CREATE(self->workerThread, threadTask, self);
+      if (rc != 0)
+      {
+         self->workerThreadValid = false;
+         apx_adminSocket_stop(self);
+         return -1;
+      }
+      APX_LOG_INFO("[APX_ADMIN_SOCKET] Listening on %s", path);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+#endif
+}
+
+void apx_adminSocket_stop(apx_adminSocket_t *self)
+{
+#ifndef _MSC_VER
+   if (self != 0)
+   {
+      self->isRunning = false;
+      if (self->workerThreadValid == true)
+      {
+         void *status;
+         int s = pthread_join(self->workerThread, &status);
+         if (s != 0)
+         {
+            APX_LOG_ERROR("[APX_ADMIN_SOCKET] pthread_join error %d", s);
+         }
+         self->workerThreadValid = false;
+      }
+      if (self->listenFd >= 0)
+      {
+         close(self->listenFd);
+         self->listenFd = -1;
+      }
+      if (self->path != 0)
+      {
+         (void) unlink(self->path);
+         free(self->path);
+         self->path = (char*) 0;
+      }
+   }
+#else
+   (void) self;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+#ifndef _MSC_VER
+static THREAD_PROTO(threadTask,arg)
+{
+   apx_adminSocket_t *self = (apx_adminSocket_t*) arg;
+   if (self != 0)
+   {
+      while (self->isRunning == true)
+      {
+         struct pollfd pfd;
+         int result;
+         pfd.fd = self->listenFd;
+         pfd.events = POLLIN;
+         pfd.revents = 0;
+         result = poll(&pfd, 1, POLL_INTERVAL_MS);
+         if (result > 0)
+         {
+            int fd = accept(self->listenFd, (struct sockaddr*) 0, (socklen_t*) 0);
+            if (fd >= 0)
+            {
+               apx_adminSocket_serveClient(self, fd);
+               close(fd);
+            }
+         }
+         else if ( (result < 0) && (errno != EINTR) )
+         {
+            APX_LOG_ERROR("[APX_ADMIN_SOCKET] poll failed, errno=%d", errno);
+            break;
+         }
+      }
+   }
+   THREAD_RETURN(0);
+}
+
+/**
+ * reads one request line and writes the response followed by a newline
+ */
+static void apx_adminSocket_serveClient(apx_adminSocket_t *self, int fd)
+{
+   char request[APX_ADMIN_SOCKET_MAX_REQUEST_LEN+1];
+   uint32_t requestLen = 0u;
+   struct timeval tv;
+   int32_t responseLen;
+   int32_t sent = 0;
+   tv.tv_sec = RECEIVE_TIMEOUT_MS/1000;
+   tv.tv_usec = (RECEIVE_TIMEOUT_MS%1000)*1000;
+   (void) setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+   while (requestLen < APX_ADMIN_SOCKET_MAX_REQUEST_LEN)
+   {
+      ssize_t result = recv(fd, &request[requestLen], APX_ADMIN_SOCKET_MAX_REQUEST_LEN-requestLen, 0);
+      if (result <= 0)
+      {
+         break;
+      }
+      requestLen += (uint32_t) result;
+      if (memchr(request, '\n', requestLen) != 0)
+      {
+         break;
+      }
+   }
+   request[requestLen] = 0;
+   while ( (requestLen > 0u) && ( (request[requestLen-1] == '\n') || (request[requestLen-1] == '\r') || (request[requestLen-1] == ' ') ) )
+   {
+      request[--requestLen] = 0;
+   }
+   responseLen = self->handler(self->handlerArg, request, self->responseBuf, self->responseBufLen-1u);
+   if (responseLen < 0)
+   {
+      responseLen = snprintf(self->responseBuf, self->responseBufLen-1u, "error: request failed");
+   }
+   else if ((uint32_t) responseLen >= self->responseBufLen-1u)
+   {
+      //handler output was truncated
+      responseLen = (int32_t) strlen(self->responseBuf);
+   }
+   self->responseBuf[responseLen++] = '\n';
+   while (sent < responseLen)
+   {
+      ssize_t result = send(fd, &self->responseBuf[sent], (size_t) (responseLen-sent), MSG_NOSIGNAL);
+      if (result <= 0)
+      {
+         break;
+      }
+      sent += (int32_t) result;
+   }
+}
+#endif
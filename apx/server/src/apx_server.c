@@ -5,6 +5,8 @@
 #include "apx_server.h"
 #include "apx_logging.h"
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -21,6 +23,14 @@ typedef struct apx_serverInfo_tag
 static void apx_server_accept(void *arg,msocket_server_t *srv,msocket_t *msocket);
 static int8_t apx_server_data(void *arg, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen);
 static void apx_server_disconnected(void *arg);
+static int8_t apx_server_readStatsFile(void *arg, uint8_t *pDest, uint32_t offset, uint32_t length);
+static int32_t apx_server_adminRequest(void *arg, const char *request, char *response, uint32_t responseLen);
+static int32_t apx_server_formatBrokerStats(const apx_routerStats_t *routerStats, uint32_t numConnections, uint8_t format, char *buf, uint32_t bufLen);
+static uint32_t apx_server_countConnections(apx_server_t *self);
+static void apx_server_startReclaimer(apx_server_t *self);
+static void apx_server_stopReclaimer(apx_server_t *self);
+static THREAD_PROTO(reclaimerTask,arg);
+static void apx_server_reclaimConnections(apx_server_t *self);
 
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
@@ -53,6 +63,15 @@ void apx_server_create(apx_server_t *self, uint16_t tcpPort)
       apx_router_create(&self->router);
       apx_nodeManager_setRouter(&self->nodeManager, &self->router);
       MUTEX_INIT(self->mutex);
+      SPINLOCK_INIT(self->statsLock);
+      memset(&self->routerStats, 0, sizeof(self->routerStats));
+      self->numConnections = 0u;
+      self->capture = (apx_capture_t*) 0;
+      adt_ary_create(&self->pendingDisconnects, (void(*)(void*)) 0);
+      SEMAPHORE_CREATE(self->reclaimerSemaphore);
+      self->reclaimerThreadValid = false;
+      self->isReclaimerRunning = false;
+      apx_adminSocket_create(&self->adminSocket, apx_server_adminRequest, self, APX_SERVER_ADMIN_RESPONSE_LEN);
    }
 }
 
@@ -61,6 +80,7 @@ void apx_server_start(apx_server_t *self)
 {
    if (self != 0)
    {
+      apx_server_startReclaimer(self);
       msocket_server_start(&self->tcpServer,0,0,self->tcpPort);
    }
 }
@@ -69,6 +89,11 @@ void apx_server_destroy(apx_server_t *self)
 {
    if (self != 0)
    {
+      //stop answering admin requests before the connections go away
+      apx_adminSocket_destroy(&self->adminSocket);
+      //finish the teardown of connections that were lost before the call to destroy
+      apx_server_stopReclaimer(self);
+      apx_server_reclaimConnections(self);
       //close and delete all open server connections
       adt_list_destroy(&self->connections);
       //destroy the tcp server
@@ -80,6 +105,9 @@ void apx_server_destroy(apx_server_t *self)
       apx_nodeManager_destroy(&self->nodeManager);
       apx_router_destroy(&self->router);
       MUTEX_DESTROY(self->mutex);
+      SPINLOCK_DESTROY(self->statsLock);
+      adt_ary_destroy(&self->pendingDisconnects);
+      SEMAPHORE_DESTROY(self->reclaimerSemaphore);
    }
 }
 
@@ -93,6 +121,133 @@ void apx_server_setDebugMode(apx_server_t *self, int8_t debugMode)
    }
 }
 
+int8_t apx_server_startAdminSocket(apx_server_t *self, const char *path)
+{
+   if ( (self != 0) && (path != 0) )
+   {
+      return apx_adminSocket_start(&self->adminSocket, path);
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+/**
+ * captures all traffic of connections accepted after this call into capture (see apx_capture.h)
+ */
+void apx_server_setCapture(apx_server_t *self, apx_capture_t *capture)
+{
+   if (self != 0)
+   {
+      self->capture = capture;
+   }
+}
+
+/**
+ * Refreshes the cached broker statistics and notifies every client that has opened the statistics file.
+ * Called periodically from the main thread.
+ */
+void apx_server_updateStats(apx_server_t *self)
+{
+   if (self != 0)
+   {
+      apx_routerStats_t routerStats;
+      adt_list_elem_t *pIter;
+      MUTEX_LOCK(self->mutex);
+      MUTEX_LOCK(self->nodeManager.lock);
+      apx_router_getStats(&self->router, &routerStats);
+      MUTEX_UNLOCK(self->nodeManager.lock);
+      SPINLOCK_ENTER(self->statsLock);
+      self->routerStats = routerStats;
+      self->numConnections = apx_server_countConnections(self);
+      SPINLOCK_LEAVE(self->statsLock);
+      adt_list_iter_init(&self->connections);
+      do
+      {
+         pIter = adt_list_iter_next(&self->connections);
+         if (pIter != 0)
+         {
+            apx_serverConnection_t *connection = (apx_serverConnection_t*) pIter->pItem;
+            if ( (connection->statsFile != 0) && (apx_file_isOpen(connection->statsFile) == true) )
+            {
+               apx_fileManager_triggerFileUpdatedEvent(&connection->fileManager, connection->statsFile, 0, APX_SERVER_STATS_FILE_LEN);
+            }
+         }
+      } while (pIter != 0);
+      MUTEX_UNLOCK(self->mutex);
+   }
+}
+
+/**
+ * Writes broker-wide and per-connection statistics into buf. Returns number of characters written or -1 on error.
+ */
+int32_t apx_server_formatStats(apx_server_t *self, uint8_t format, char *buf, uint32_t bufLen)
+{
+   if ( (self != 0) && (buf != 0) && (bufLen > 0u) && ( (format == APX_SERVER_STATS_FORMAT_TEXT) || (format == APX_SERVER_STATS_FORMAT_JSON) ) )
+   {
+      apx_routerStats_t routerStats;
+      adt_list_elem_t *pIter;
+      int32_t total;
+      int32_t result;
+      bool isFirst = true;
+      MUTEX_LOCK(self->mutex);
+      MUTEX_LOCK(self->nodeManager.lock);
+      apx_router_getStats(&self->router, &routerStats);
+      MUTEX_UNLOCK(self->nodeManager.lock);
+      total = apx_server_formatBrokerStats(&routerStats, apx_server_countConnections(self), format, buf, bufLen);
+      if ( (total >= 0) && (format == APX_SERVER_STATS_FORMAT_JSON) )
+      {
+         //reopen the object to append the connection array
+         total--;
+         result = snprintf(&buf[total], bufLen-total, ",\"connections\":[");
+         total = ( (result < 0) || ((uint32_t) result >= bufLen-total) )? -1 : total + result;
+      }
+      adt_list_iter_init(&self->connections);
+      do
+      {
+         pIter = adt_list_iter_next(&self->connections);
+         if ( (pIter != 0) && (total >= 0) )
+         {
+            apx_serverConnection_t *connection = (apx_serverConnection_t*) pIter->pItem;
+            apx_connectionStats_t stats;
+            apx_fileManager_getStats(&connection->fileManager, &stats);
+            if (format == APX_SERVER_STATS_FORMAT_JSON)
+            {
+               result = snprintf(&buf[total], bufLen-total, "%s{\"id\":\"%p\",\"stats\":", isFirst? "" : ",", (void*) connection);
+            }
+            else
+            {
+               result = snprintf(&buf[total], bufLen-total, "\nconnection %p: ", (void*) connection);
+            }
+            total = ( (result < 0) || ((uint32_t) result >= bufLen-total) )? -1 : total + result;
+            if (total >= 0)
+            {
+               result = (format == APX_SERVER_STATS_FORMAT_JSON)? apx_connectionStats_toJson(&stats, &buf[total], bufLen-total) : apx_connectionStats_toText(&stats, &buf[total], bufLen-total);
+               total = (result < 0)? -1 : total + result;
+            }
+            if ( (total >= 0) && (format == APX_SERVER_STATS_FORMAT_JSON) )
+            {
+               result = snprintf(&buf[total], bufLen-total, "}");
+               total = ( (result < 0) || ((uint32_t) result >= bufLen-total) )? -1 : total + result;
+            }
+            isFirst = false;
+         }
+      } while (pIter != 0);
+      MUTEX_UNLOCK(self->mutex);
+      if ( (total >= 0) && (format == APX_SERVER_STATS_FORMAT_JSON) )
+      {
+         result = snprintf(&buf[total], bufLen-total, "]}");
+         total = ( (result < 0) || ((uint32_t) result >= bufLen-total) )? -1 : total + result;
+      }
+      if (total < 0)
+      {
+         errno = ENOBUFS;
+      }
+      return total;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
@@ -110,7 +265,9 @@ static void apx_server_accept(void *arg,msocket_server_t *srv,msocket_t *msocket
          msocket_handler_t handlerTable;
 
          //add it to our list of connections. The linked list is used to keep track of all open connections
+         MUTEX_LOCK(self->mutex);
          adt_list_insert(&self->connections,newConnection);
+         MUTEX_UNLOCK(self->mutex);
 
          //attach our (single) instance of the nodeManager with the connection
          //apx_serverConnection_attachNodeManager()
@@ -133,6 +290,16 @@ static void apx_server_accept(void *arg,msocket_server_t *srv,msocket_t *msocket
          {
             apx_serverConnection_setDebugMode(newConnection, self->debugMode);
          }
+         //publish the statistics file, its FILE_INFO is sent to the client together with the acknowledge message
+         newConnection->statsFile = apx_file_newLocalUserDataFile(APX_SERVER_STATS_FILE_NAME, APX_SERVER_STATS_FILE_LEN, apx_server_readStatsFile, newConnection);
+         if (newConnection->statsFile != 0)
+         {
+            apx_fileManager_attachLocalDataFile(&newConnection->fileManager, newConnection->statsFile);
+         }
+         if (self->capture != 0)
+         {
+            apx_serverConnection_setCapture(newConnection, self->capture);
+         }
          //now that the handler is setup, start the internal listening thread in the msocket
          msocket_start_io(msocket);
          //trigger the new connection to send the greeting message (in case there is any to be sent)
@@ -152,35 +319,285 @@ static int8_t apx_server_data(void *arg, const uint8_t *dataBuf, uint32_t dataLe
 }
 
 /**
- * called by msocket worker thread when it detects a disconnect event on the msocket
+ * called by msocket worker thread when it detects a disconnect event on the msocket.
+ * Only the cheap part is done here: the connection stops receiving data from other connections and is handed over
+ * to the reclaimer thread which detaches its nodes (together with those of any other connection lost in the same
+ * window) and then cleans up the msocket.
  */
 static void apx_server_disconnected(void *arg)
 {
-   apx_serverConnection_t *connection;   
+   apx_serverConnection_t *connection;
    connection = (apx_serverConnection_t*) arg;
    if (connection != 0)
    {
+      bool useReclaimer;
       apx_server_t *server = connection->server;
+      apx_fileManager_markDead(&connection->fileManager);
       MUTEX_LOCK(server->mutex);
       adt_list_remove(&server->connections, connection);
-      //the thread inside the msocket class cannot shutdown itself, instead use the cleanup thread to do the job of shutting it down
-      apx_nodeManager_detachFileManager(&server->nodeManager, &connection->fileManager);
+      adt_ary_push(&server->pendingDisconnects, connection);
+      useReclaimer = server->reclaimerThreadValid;
+      MUTEX_UNLOCK(server->mutex);
       APX_LOG_INFO("[APX_SERVER] Client (%p) disconnected", (void*)connection);
+      if (useReclaimer == true)
+      {
+         SEMAPHORE_POST(server->reclaimerSemaphore);
+      }
+      else
+      {
+         //server not started or shutting down, tear down the connection right away
+         apx_server_reclaimConnections(server);
+      }
+   }
+}
+
+static void apx_server_startReclaimer(apx_server_t *self)
+{
+   if (self->reclaimerThreadValid == false)
+   {
+      self->isReclaimerRunning = true;
+#ifdef _MSC_VER
+      THREAD_CREATE(self->reclaimerThread, reclaimerTask, self, self->reclaimerThreadId);
+      if (self->reclaimerThread == INVALID_HANDLE_VALUE)
+      {
+         self->isReclaimerRunning = false;
+         APX_LOG_ERROR("[APX_SERVER] %s", "Failed to start reclaimer thread");
+         return;
+      }
+#else
+      if (THREAD_CREATE(self->reclaimerThread, reclaimerTask, self) != 0)
+      {
+         self->isReclaimerRunning = false;
+         APX_LOG_ERROR("[APX_SERVER] %s", "Failed to start reclaimer thread");
+         return;
+      }
+#endif
+      MUTEX_LOCK(self->mutex);
+      self->reclaimerThreadValid = true;
+      MUTEX_UNLOCK(self->mutex);
+   }
+}
+
+static void apx_server_stopReclaimer(apx_server_t *self)
+{
+   if (self->reclaimerThreadValid == true)
+   {
+      self->isReclaimerRunning = false;
+      SEMAPHORE_POST(self->reclaimerSemaphore);
+#ifdef _MSC_VER
+      if (WaitForSingleObject(self->reclaimerThread, 5000) != WAIT_OBJECT_0)
+      {
+         APX_LOG_ERROR("[APX_SERVER] %s", "Failed to join reclaimer thread");
+      }
+      CloseHandle(self->reclaimerThread);
+#else
+      {
+         void *status;
+         int s = pthread_join(self->reclaimerThread, &status);
+         if (s != 0)
+         {
+            APX_LOG_ERROR("[APX_SERVER] pthread_join error %d", s);
+         }
+      }
+#endif
+      MUTEX_LOCK(self->mutex);
+      self->reclaimerThreadValid = false;
+      MUTEX_UNLOCK(self->mutex);
+   }
+}
+
+static THREAD_PROTO(reclaimerTask,arg)
+{
+   apx_server_t *self = (apx_server_t*) arg;
+   if (self != 0)
+   {
+      while (self->isReclaimerRunning == true)
+      {
+#ifdef _MSC_VER
+         DWORD result = WaitForSingleObject(self->reclaimerSemaphore, INFINITE);
+         if (result != WAIT_OBJECT_0)
+         {
+            APX_LOG_ERROR("[APX_SERVER] failure while waiting for semaphore, error=%d", (int) GetLastError());
+            break;
+         }
+#else
+         if (sem_wait(&self->reclaimerSemaphore) != 0)
+         {
+            if (errno == EINTR)
+            {
+               continue;
+            }
+            APX_LOG_ERROR("[APX_SERVER] failure while waiting for semaphore, errno=%d", errno);
+            break;
+         }
+#endif
+         if (self->isReclaimerRunning == true)
+         {
+            //give connections that are lost at the same time (e.g. network failure) a chance to join this batch
+            SLEEP(APX_SERVER_RECLAIM_WINDOW_MS);
+         }
+         apx_server_reclaimConnections(self);
+      }
+   }
+   THREAD_RETURN(0);
+}
+
+/**
+ * tears down all connections in pendingDisconnects. Their nodes are detached from the nodeManager as one batch
+ * (the router reroutes affected signals once), after that the msockets are handed over to the msocket cleanup thread
+ * which deletes the connection objects.
+ */
+static void apx_server_reclaimConnections(apx_server_t *self)
+{
+   int32_t i;
+   int32_t numConnections;
+   adt_ary_t connections; //weak references to apx_serverConnection_t
+   adt_ary_t fileManagers; //weak references to apx_fileManager_t
+
+   adt_ary_create(&connections, (void(*)(void*)) 0);
+   MUTEX_LOCK(self->mutex);
+   numConnections = adt_ary_length(&self->pendingDisconnects);
+   for (i=0; i<numConnections; i++)
+   {
+      adt_ary_push(&connections, adt_ary_value(&self->pendingDisconnects, i));
+   }
+   adt_ary_clear(&self->pendingDisconnects);
+   MUTEX_UNLOCK(self->mutex);
+   if (numConnections == 0)
+   {
+      adt_ary_destroy(&connections);
+      return;
+   }
+   adt_ary_create(&fileManagers, (void(*)(void*)) 0);
+   for (i=0; i<numConnections; i++)
+   {
+      apx_serverConnection_t *connection = (apx_serverConnection_t*) adt_ary_value(&connections, i);
+      adt_ary_push(&fileManagers, &connection->fileManager);
+   }
+   apx_nodeManager_detachFileManagers(&self->nodeManager, (struct apx_fileManager_tag**) adt_ary_get(&fileManagers, 0), numConnections);
+   if (numConnections > 1)
+   {
+      APX_LOG_INFO("[APX_SERVER] Detached %d lost connections as one batch", (int) numConnections);
+   }
+   //the thread inside the msocket class cannot shutdown itself, instead use the cleanup thread to do the job of shutting it down
+   for (i=0; i<numConnections; i++)
+   {
+      apx_serverConnection_t *connection = (apx_serverConnection_t*) adt_ary_value(&connections, i);
       switch (connection->msocket->addressFamily)
       {
          case AF_INET: //intentional fallthrough
-         case AF_INET6:            
-            msocket_server_cleanup_connection(&connection->server->tcpServer, arg);
+         case AF_INET6:
+            msocket_server_cleanup_connection(&self->tcpServer, connection);
             break;
 #ifndef _MSC_VER
          case AF_LOCAL:
-            msocket_server_cleanup_connection(&connection->server->localServer,arg);
+            msocket_server_cleanup_connection(&self->localServer, connection);
             break;
 #endif
          default:
             break;
       }
-      MUTEX_UNLOCK(server->mutex);
    }
+   adt_ary_destroy(&fileManagers);
+   adt_ary_destroy(&connections);
 }
 
+/**
+ * read handler of the statistics file. Runs in the fileManager worker thread of the connection (with its send lock held)
+ * and must therefore only use the cached broker statistics, never the server or nodeManager locks.
+ */
+static int8_t apx_server_readStatsFile(void *arg, uint8_t *pDest, uint32_t offset, uint32_t length)
+{
+   apx_serverConnection_t *connection = (apx_serverConnection_t*) arg;
+   if ( (connection != 0) && (pDest != 0) && ( (offset+length) <= APX_SERVER_STATS_FILE_LEN) )
+   {
+      char tmp[APX_SERVER_STATS_FILE_LEN];
+      apx_routerStats_t routerStats;
+      apx_connectionStats_t stats;
+      uint32_t numConnections;
+      int32_t total;
+      apx_server_t *server = connection->server;
+      SPINLOCK_ENTER(server->statsLock);
+      routerStats = server->routerStats;
+      numConnections = server->numConnections;
+      SPINLOCK_LEAVE(server->statsLock);
+      apx_fileManager_getStats(&connection->fileManager, &stats);
+      memset(tmp, 0, sizeof(tmp));
+      total = apx_server_formatBrokerStats(&routerStats, numConnections, APX_SERVER_STATS_FORMAT_JSON, tmp, sizeof(tmp));
+      if (total > 0)
+      {
+         //replace the closing brace with the statistics of this connection
+         total--;
+         if (snprintf(&tmp[total], sizeof(tmp)-total, ",\"connection\":") < (int) (sizeof(tmp)-total))
+         {
+            total += (int32_t) strlen(&tmp[total]);
+            if (apx_connectionStats_toJson(&stats, &tmp[total], sizeof(tmp)-total-1) >= 0)
+            {
+               strcat(tmp, "}");
+            }
+         }
+      }
+      memcpy(pDest, &tmp[offset], length);
+      return 0;
+   }
+   errno = EINVAL;
+   return -1;
+}
+
+static int32_t apx_server_adminRequest(void *arg, const char *request, char *response, uint32_t responseLen)
+{
+   apx_server_t *self = (apx_server_t*) arg;
+   if (self != 0)
+   {
+      if ( (strcmp(request, "stats") == 0) || (request[0] == 0) )
+      {
+         return apx_server_formatStats(self, APX_SERVER_STATS_FORMAT_TEXT, response, responseLen);
+      }
+      else if ( (strcmp(request, "json") == 0) || (strcmp(request, "stats json") == 0) )
+      {
+         return apx_server_formatStats(self, APX_SERVER_STATS_FORMAT_JSON, response, responseLen);
+      }
+      else if (strcmp(request, "help") == 0)
+      {
+         return snprintf(response, responseLen, "commands: stats, stats json, help");
+      }
+      return snprintf(response, responseLen, "error: unknown request '%s'", request);
+   }
+   return -1;
+}
+
+static int32_t apx_server_formatBrokerStats(const apx_routerStats_t *routerStats, uint32_t numConnections, uint8_t format, char *buf, uint32_t bufLen)
+{
+   int result;
+   if (format == APX_SERVER_STATS_FORMAT_JSON)
+   {
+      result = snprintf(buf, bufLen, "{\"nodes\":%u,\"providePorts\":%u,\"requirePorts\":%u,\"connectors\":%u,\"routeTableSize\":%u,\"numConnections\":%u}",
+            (unsigned int) routerStats->numNodes, (unsigned int) routerStats->numProvidePorts, (unsigned int) routerStats->numRequirePorts,
+            (unsigned int) routerStats->numConnectors, (unsigned int) routerStats->routeTableSize, (unsigned int) numConnections);
+   }
+   else
+   {
+      result = snprintf(buf, bufLen, "broker: nodes=%u providePorts=%u requirePorts=%u connectors=%u routeTableSize=%u connections=%u",
+            (unsigned int) routerStats->numNodes, (unsigned int) routerStats->numProvidePorts, (unsigned int) routerStats->numRequirePorts,
+            (unsigned int) routerStats->numConnectors, (unsigned int) routerStats->routeTableSize, (unsigned int) numConnections);
+   }
+   if ( (result < 0) || ((uint32_t) result >= bufLen) )
+   {
+      return -1;
+   }
+   return (int32_t) result;
+}
+
+/**
+ * the caller must hold self->mutex
+ */
+static uint32_t apx_server_countConnections(apx_server_t *self)
+{
+   uint32_t count = 0u;
+   adt_list_iter_init(&self->connections);
+   while (adt_list_iter_next(&self->connections) != 0)
+   {
+      count++;
+   }
+   return count;
+}
@@ -32,12 +32,14 @@
 #define MAX_DEBUG_BYTES 100
 #define MAX_DEBUG_MSG_SIZE 400
 #define HEX_DATA_LEN 3u
+#define FRAMES_MIN_LEN 64
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 static void apx_serverConnection_parseGreeting(apx_serverConnection_t *self, const uint8_t *msgBuf, int32_t msgLen);
-static uint8_t apx_serverConnection_parseMessage(apx_serverConnection_t *self, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen);
+static uint8_t apx_serverConnection_parseMessage(apx_serverConnection_t *self, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen, apx_fileManagerFrame_t *frame);
+static int8_t apx_serverConnection_reserveFrames(apx_serverConnection_t *self, int32_t numFrames);
 static uint8_t *apx_serverConnection_getSendBuffer(void *arg, int32_t msgLen);
 static int32_t apx_serverConnection_send(void *arg, int32_t offset, int32_t msgLen);
 
@@ -71,6 +73,11 @@ int8_t apx_serverConnection_create(apx_serverConnection_t *self, msocket_t *sock
       self->server=server;
       self->isGreetingParsed = false;
       self->debugMode = APX_DEBUG_NONE;
+      self->statsFile = (apx_file_t*) 0;
+      self->capture = (apx_capture_t*) 0;
+      self->captureId = 0u;
+      self->frames = (apx_fileManagerFrame_t*) 0;
+      self->framesLen = 0;
       self->numHeaderMaxLen = (int8_t) sizeof(uint32_t); //currently only 4-byte header is supported. There might be a future version where we support both 16-bit and 32-bit message headers
       adt_bytearray_create(&self->sendBuffer, SEND_BUFFER_GROW_SIZE);
       return apx_fileManager_create(&self->fileManager, APX_FILEMANAGER_SERVER_MODE);
@@ -85,6 +92,10 @@ void apx_serverConnection_destroy(apx_serverConnection_t *self)
    {
       apx_fileManager_destroy(&self->fileManager);
       adt_bytearray_destroy(&self->sendBuffer);
+      if (self->frames != 0)
+      {
+         free(self->frames);
+      }
 #ifdef UNIT_TEST
       testsocket_delete(self->testsocket);
 #else
@@ -175,7 +186,8 @@ void apx_serverConnection_start(apx_serverConnection_t *self)
 }
 
 /**
- * called from apx_client when data has been received on the msocket
+ * called from apx_client when data has been received on the msocket.
+ * All complete messages in dataBuf are decoded first and then handed over to the fileManager as one batch.
  */
 int8_t apx_serverConnection_dataReceived(apx_serverConnection_t *self, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen)
 {
@@ -184,15 +196,16 @@ int8_t apx_serverConnection_dataReceived(apx_serverConnection_t *self, const uin
       uint32_t totalParseLen = 0;
       uint32_t remain = dataLen;
       const uint8_t *pNext = dataBuf;
+      int32_t numFrames = 0;
       while(totalParseLen<dataLen)
       {
          uint32_t internalParseLen = 0;
-         uint8_t result;         
-         result = apx_serverConnection_parseMessage(self, pNext, remain, &internalParseLen);
+         uint8_t result;
+         apx_fileManagerFrame_t frame = {0, 0};
+         result = apx_serverConnection_parseMessage(self, pNext, remain, &internalParseLen, &frame);
          //check parse result
          if (result == 0)
          {
-            //printf("\tinternalParseLen(%s): %d\n",parseFunc, internalParseLen);
             assert(internalParseLen<=dataLen);
             pNext+=internalParseLen;
             totalParseLen+=internalParseLen;
@@ -201,14 +214,31 @@ int8_t apx_serverConnection_dataReceived(apx_serverConnection_t *self, const uin
             {
                break;
             }
+            if (frame.msgBuf != 0)
+            {
+               if (apx_serverConnection_reserveFrames(self, numFrames+1) != 0)
+               {
+                  //out of memory, parse what we have so far and continue without batching
+                  (void) apx_fileManager_parseMessages(&self->fileManager, self->frames, numFrames);
+                  numFrames = 0;
+                  (void) apx_fileManager_parseMessage(&self->fileManager, frame.msgBuf, frame.msgLen);
+               }
+               else
+               {
+                  self->frames[numFrames++] = frame;
+               }
+            }
          }
          else
          {
             return result;
          }
       }
+      if (numFrames > 0)
+      {
+         (void) apx_fileManager_parseMessages(&self->fileManager, self->frames, numFrames);
+      }
       //no more complete messages can be parsed. There may be a partial message left in buffer, but we ignore it until more data has been recevied.
-      //printf("\ttotalParseLen=%d\n", totalParseLen);
       *parseLen = totalParseLen;
       return 0;
    }
@@ -227,6 +257,18 @@ void apx_serverConnection_setDebugMode(apx_serverConnection_t *self, int8_t debu
    }
 }
 
+/**
+ * enables capture of all frames received and sent on this connection. Must be called before the connection is started.
+ */
+void apx_serverConnection_setCapture(apx_serverConnection_t *self, apx_capture_t *capture)
+{
+   if (self != 0)
+   {
+      self->capture = capture;
+      self->captureId = apx_capture_newConnectionId(capture);
+   }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
@@ -286,8 +328,9 @@ static void apx_serverConnection_parseGreeting(apx_serverConnection_t *self, con
 
 /**
  * a message consists of a message length (1 or 4 bytes) packed as binary integer (big endian). Then follows the message data followed by a new message length header etc.
+ * The greeting is parsed directly, all other messages are returned in frame for batch processing by the fileManager.
  */
-static uint8_t apx_serverConnection_parseMessage(apx_serverConnection_t *self, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen)
+static uint8_t apx_serverConnection_parseMessage(apx_serverConnection_t *self, const uint8_t *dataBuf, uint32_t dataLen, uint32_t *parseLen, apx_fileManagerFrame_t *frame)
 {
    uint32_t totalParsed=0;
    uint32_t msgLen;
@@ -303,6 +346,12 @@ static uint8_t apx_serverConnection_parseMessage(apx_serverConnection_t *self, c
       if (pNext+msgLen<=pEnd)
       {
          totalParsed+=headerLen+msgLen;
+         APX_STATS_INC(self->fileManager.stats.numMessagesIn);
+         APX_STATS_ADD64(self->fileManager.stats.numBytesIn, headerLen+msgLen);
+         if (self->capture != 0)
+         {
+            apx_capture_write(self->capture, self->captureId, APX_CAPTURE_RX, pBegin, headerLen+msgLen);
+         }
          if (self->debugMode >= APX_DEBUG_4_HIGH)
          {
             uint32_t i;
@@ -327,7 +376,8 @@ static uint8_t apx_serverConnection_parseMessage(apx_serverConnection_t *self, c
          }
          else
          {
-            apx_fileManager_parseMessage(&self->fileManager, pNext, msgLen);
+            frame->msgBuf = pNext;
+            frame->msgLen = (int32_t) msgLen;
          }
       }
       else
@@ -343,6 +393,23 @@ static uint8_t apx_serverConnection_parseMessage(apx_serverConnection_t *self, c
    return 0;
 }
 
+static int8_t apx_serverConnection_reserveFrames(apx_serverConnection_t *self, int32_t numFrames)
+{
+   if (numFrames > self->framesLen)
+   {
+      int32_t newLen = (self->framesLen > 0)? self->framesLen*2 : FRAMES_MIN_LEN;
+      apx_fileManagerFrame_t *frames = (apx_fileManagerFrame_t*) realloc(self->frames, ((size_t) newLen)*sizeof(apx_fileManagerFrame_t));
+      if (frames == 0)
+      {
+         errno = ENOMEM;
+         return -1;
+      }
+      self->frames = frames;
+      self->framesLen = newLen;
+   }
+   return 0;
+}
+
 /**
  * callback for fileManager when it requests a send buffer
  */
@@ -424,12 +491,17 @@ static int32_t apx_serverConnection_send(void *arg, int32_t offset, int32_t msgL
             }
             APX_LOG_DEBUG("[APX_SRV_CONNECTION] %s", msg);
          }
-		 
+         if (self->capture != 0)
+         {
+            apx_capture_write(self->capture, self->captureId, APX_CAPTURE_TX, pBegin, msgLen+headerLen);
+         }
 #ifdef UNIT_TEST
 		 testsocket_serverSend(self->testsocket, pBegin, msgLen+headerLen);
 #else
 		 msocket_send(self->msocket, pBegin, msgLen+headerLen);
 #endif
+         APX_STATS_INC(self->fileManager.stats.numMessagesOut);
+         APX_STATS_ADD64(self->fileManager.stats.numBytesOut, msgLen+headerLen);
          return 0;
       }
       else
@@ -36,6 +36,9 @@ int8_t g_debug; // Global so apx_logging can use it from everywhere
 static uint16_t m_port;
 static apx_server_t m_server;
 static int32_t m_count;
+static const char *m_adminPath;
+static const char *m_capturePath;
+static apx_capture_t m_capture;
 static const char *SW_VERSION_STR = SW_VERSION_LITERAL;
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL FUNCTIONS
@@ -50,6 +53,8 @@ int main(int argc, char **argv)
    m_count = 0;
    g_debug = 0;
    m_port = DEFAULT_PORT;
+   m_adminPath = (const char*) 0;
+   m_capturePath = (const char*) 0;
    printf("APX Server %s\n", SW_VERSION_STR);
    if(argc>1)
    {
@@ -64,6 +69,11 @@ int main(int argc, char **argv)
       printUsage(argv[0]);
       return 0;
    }
+   if (g_debug != 0)
+   {
+      apx_log_setLevel(APX_LOG_LEVEL_DEBUG);
+   }
+   apx_log_start();
    APX_LOG_INFO("Listening on port %d\n", (int)m_port);
 #ifdef _WIN32   
    wVersionRequested = MAKEWORD(2, 2);
@@ -76,10 +86,27 @@ int main(int argc, char **argv)
 #endif
    apx_server_create(&m_server,m_port);
    apx_server_setDebugMode(&m_server, g_debug);
+   if (m_capturePath != 0)
+   {
+      if (apx_capture_open(&m_capture, m_capturePath) == 0)
+      {
+         apx_server_setCapture(&m_server, &m_capture);
+         APX_LOG_INFO("Capturing traffic to %s\n", m_capturePath);
+      }
+      else
+      {
+         APX_LOG_ERROR("Failed to open capture file %s\n", m_capturePath);
+      }
+   }
    apx_server_start(&m_server);
+   if ( (m_adminPath != 0) && (apx_server_startAdminSocket(&m_server, m_adminPath) != 0) )
+   {
+      APX_LOG_ERROR("Failed to open admin socket %s\n", m_adminPath);
+   }
    for(;;)
    {
-      SLEEP(5000); //main thread is sleeping while child threads do all the work
+      SLEEP(APX_SERVER_STATS_INTERVAL_MS); //main thread only refreshes statistics while child threads do all the work
+      apx_server_updateStats(&m_server);
 /*    if (++m_count==20) //this counter is used during testing to verify that all resources are properly cleaned up
       {
          break;
@@ -87,6 +114,8 @@ int main(int argc, char **argv)
    }
    APX_LOG_INFO("destroying server\n");
    apx_server_destroy(&m_server);
+   apx_capture_close(&m_capture);
+   apx_log_stop();
 #ifdef _WIN32
    WSACleanup();
 #endif
@@ -139,6 +168,14 @@ static int parse_args(int argc, char **argv)
             }
          }
       }
+      else if (strncmp(argv[i], "--admin=", 8) == 0)
+      {
+         m_adminPath = &argv[i][8];
+      }
+      else if (strncmp(argv[i], "--capture=", 10) == 0)
+      {
+         m_capturePath = &argv[i][10];
+      }
       else
       {
          printf("Unknown argument %s\n", argv[i]);
@@ -151,7 +188,7 @@ static int parse_args(int argc, char **argv)
 
 static void printUsage(char *name)
 {   
-   printf("%s -p<port> [--debug=<level 1-4>]\n",name);
+   printf("%s -p<port> [--debug=<level 1-4>] [--admin=<socket path>] [--capture=<file>]\n",name);
 }
 
 
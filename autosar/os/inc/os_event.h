@@ -7,7 +7,6 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "os_task.h"
-#include "priority_queue.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
@@ -0,0 +1,85 @@
+#ifndef OS_EXECUTOR_H
+#define OS_EXECUTOR_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "osmacro.h"
+#include "os_task.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef OS_EXECUTOR_NUM_PRIORITIES
+#define OS_EXECUTOR_NUM_PRIORITIES 4
+#endif
+
+#define OS_EXECUTOR_NO_CPU -1
+
+/**
+ * Ring of tasks waiting to run, protected by the lock of the worker that owns it.
+ */
+typedef struct os_executorQueue_tag
+{
+   os_task_t **tasks; //strong reference to the array, weak references to the tasks
+   uint32_t head;
+   volatile uint32_t length; //written with the lock held, read without it to skip empty queues
+}os_executorQueue_t;
+
+typedef struct os_executorWorker_tag
+{
+   struct os_executor_tag *executor;
+   SPINLOCK_T lock; //protects sharedQueue and pinnedQueue
+   SEMAPHORE_T semaphore; //posted by whoever clears idle
+   THREAD_T workerThread;
+#ifdef _MSC_VER
+   DWORD threadId;
+#endif
+   os_executorQueue_t sharedQueue[OS_EXECUTOR_NUM_PRIORITIES]; //tasks that other workers may steal
+   os_executorQueue_t pinnedQueue[OS_EXECUTOR_NUM_PRIORITIES]; //tasks bound to this worker
+   volatile uint32_t idle; //1 while the worker is about to sleep or sleeping
+   int32_t cpu; //OS_EXECUTOR_NO_CPU or the CPU the worker thread is bound to
+   uint32_t index;
+}os_executorWorker_t;
+
+/**
+ * Runs pooled os_task_t instances (see os_task_createPooled) on a fixed number of worker threads.
+ * Each worker has its own run queues. A worker that runs out of tasks steals from the other workers,
+ * highest priority first. Tasks bound to a worker (os_task_setWorker) are never stolen.
+ */
+typedef struct os_executor_tag
+{
+   os_executorWorker_t *workers; //strong reference
+   uint32_t numWorkers;
+   uint32_t maxNumTasks; //capacity of each run queue
+   volatile uint32_t numTasks;
+   volatile uint32_t running;
+   bool workerThreadsValid;
+}os_executor_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+int8_t os_executor_create(os_executor_t *self, uint32_t numWorkers, uint32_t maxNumTasks);
+void os_executor_destroy(os_executor_t *self);
+int8_t os_executor_setWorkerCpu(os_executor_t *self, uint32_t workerIndex, int32_t cpu);
+int8_t os_executor_start(os_executor_t *self);
+void os_executor_stop(os_executor_t *self);
+int8_t os_executor_addTask(os_executor_t *self, os_task_t *task);
+void os_executor_removeTask(os_executor_t *self, os_task_t *task);
+void os_executor_schedule(os_executor_t *self, os_task_t *task);
+
+#endif //OS_EXECUTOR_H
@@ -24,6 +24,9 @@ void os_schm_init(os_schm_cfg_t *cfg);
 void os_schm_shutdown(void);
 void os_schm_start(void);
 void os_schm_stop(void);
+#if(OS_STAT_ENABLE)
+void os_schm_setStatDump(FILE *fp, uint32_t periodMs);
+#endif
 #ifdef UNIT_TEST
 void os_schm_run(void);
 #endif
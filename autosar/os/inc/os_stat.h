@@ -0,0 +1,67 @@
+#ifndef OS_STAT_H
+#define OS_STAT_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdio.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifndef OS_STAT_ENABLE
+#define OS_STAT_ENABLE 0 //set to 1 to instrument os_schm and os_task
+#endif
+
+#ifndef OS_STAT_MAX_NUM_EVENTS
+#define OS_STAT_MAX_NUM_EVENTS 32 //events with higher IDs are not recorded
+#endif
+
+#define OS_STAT_NUM_BUCKETS 32 //bucket 0 holds 0ns, bucket k holds [2^(k-1), 2^k) ns, the last bucket holds everything above
+
+typedef enum os_stat_kind_tag
+{
+   OS_STAT_FIRE_LATENCY, //time from scheduled to actual timer event fire time (os_schm)
+   OS_STAT_QUEUE_WAIT,   //time from os_task_setEvent until os_task_waitEvent returns the event
+   OS_STAT_RUN_TIME,     //time from os_task_waitEvent returning the event until the task waits again
+   OS_STAT_NUM_KINDS
+}os_stat_kind_t;
+
+/**
+ * Log2 histogram of durations in nanoseconds.
+ * All fields are updated with relaxed atomic operations, readers may see a count that is slightly ahead of the buckets.
+ */
+typedef struct os_stat_histogram_tag
+{
+   uint32_t buckets[OS_STAT_NUM_BUCKETS];
+   uint32_t count;
+   uint64_t sumNs;
+   uint64_t maxNs;
+   uint64_t minNsInv; //~min, zero means no samples (lets the histogram start out zero-initialized)
+}os_stat_histogram_t;
+
+typedef struct os_stat_snapshot_tag
+{
+   uint16_t eventId;
+   os_stat_histogram_t hist[OS_STAT_NUM_KINDS];
+}os_stat_snapshot_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void os_stat_reset(void);
+uint64_t os_stat_now(void);
+void os_stat_record(uint16_t eventId, os_stat_kind_t kind, uint64_t valueNs);
+int8_t os_stat_getSnapshot(uint16_t eventId, os_stat_snapshot_t *snapshot);
+uint64_t os_stat_histogram_min(const os_stat_histogram_t *hist);
+uint64_t os_stat_histogram_mean(const os_stat_histogram_t *hist);
+uint64_t os_stat_histogram_percentile(const os_stat_histogram_t *hist, uint32_t permille);
+void os_stat_dump(FILE *fp);
+
+#endif //OS_STAT_H
@@ -13,12 +13,24 @@
 #include <stdbool.h>
 #include "osmacro.h"
 #include "ringbuf.h"
+#include "os_stat.h"
 
 
 
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#if(OS_STAT_ENABLE)
+typedef struct os_taskEvent_tag
+{
+   uint64_t enqueueTimeNs;
+   uint16_t eventId;
+}os_taskEvent_t;
+#endif
+
+struct os_executor_tag;
+typedef void (*os_task_handler_t)(void *arg, uint16_t eventId);
+
 typedef struct os_task_tag
 {
 	SPINLOCK_T lock;  //variable lock
@@ -29,10 +41,22 @@ typedef struct os_task_tag
 	DWORD threadId;
 #endif
    bool workerThreadValid;
-	//data object, all read/write accesses to these must be protected by the lock variable above
-	rbfu16_t eventQueue; //pending events, type: uint16
+	//eventQueue is written with rbf32_mpsc_insert (under lock without RBF32_ATOMIC_ENABLE) and read by workerThread without locking
+	rbf32_t eventQueue; //pending events, type: uint16 (os_taskEvent_t when OS_STAT_ENABLE is set)
 	uint16_t *eventQueueBuf; //strong pointer to raw data used by our ringbuffer
 	bool eventQueueBufIsWeakRef;
+#if(OS_STAT_ENABLE)
+   uint16_t activeEventId; //event returned by the latest os_task_waitEvent, only accessed by workerThread
+   uint64_t activeStartNs;
+#endif
+   //pooled tasks (see os_task_createPooled) have no workerThread, their events are dispatched by an executor
+   struct os_executor_tag *executor; //weak reference, 0 for tasks with their own workerThread
+   os_task_handler_t handler;
+   void *handlerArg;
+   volatile uint32_t runState; //OS_TASK_RUN_STATE_*, a pooled task is run by at most one executor worker at a time
+   uint8_t priority; //0 is the highest priority
+   int32_t workerIndex; //executor worker the task is bound to, OS_TASK_ANY_WORKER lets any worker run it
+   uint32_t homeWorker; //worker whose run queue receives the task when it is scheduled
 
 } os_task_t;
 
@@ -40,6 +64,13 @@ typedef struct os_task_tag
 #define OS_USER_EVENT_ID     1
 #define OS_INVALID_EVENT_ID 0xFFFF
 
+#define OS_TASK_ANY_WORKER -1
+
+#define OS_TASK_RUN_STATE_IDLE      0u
+#define OS_TASK_RUN_STATE_SCHEDULED 1u //in an executor run queue
+#define OS_TASK_RUN_STATE_RUNNING   2u
+#define OS_TASK_RUN_STATE_STOPPED   3u //shutdown event has been handled
+
 //////////////////////////////////////////////////////////////////////////////
 // GLOBAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
@@ -49,10 +80,14 @@ typedef struct os_task_tag
 // GLOBAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
 int8_t os_task_create(os_task_t *self, THREAD_PROTO_PTR(thread_func, arg), uint16_t u16MaxNumEvents);
+int8_t os_task_createPooled(os_task_t *self, struct os_executor_tag *executor, os_task_handler_t handler, void *arg, uint16_t u16MaxNumEvents);
 void os_task_destroy(os_task_t *self);
 void os_task_start(os_task_t *self);
 void os_task_stop(os_task_t *self);
 void os_task_setEvent(os_task_t *self, uint16_t eventId);
 uint16_t os_task_waitEvent(os_task_t *self);
+void os_task_setPriority(os_task_t *self, uint8_t priority);
+void os_task_setWorker(os_task_t *self, int32_t workerIndex);
+int8_t os_task_runEvents(os_task_t *self);
 
 #endif //OS_H
@@ -0,0 +1,60 @@
+#ifndef OS_TIMER_WHEEL_H
+#define OS_TIMER_WHEEL_H
+
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define OS_TIMER_WHEEL_NUM_LEVELS  4
+#define OS_TIMER_WHEEL_SLOT_BITS   6
+#define OS_TIMER_WHEEL_NUM_SLOTS   (1u << OS_TIMER_WHEEL_SLOT_BITS) //one bit per slot in occupied[]
+#define OS_TIMER_WHEEL_SLOT_MASK   (OS_TIMER_WHEEL_NUM_SLOTS - 1u)
+#define OS_TIMER_WHEEL_NO_TICK     UINT64_MAX
+
+/**
+ * Intrusive list node, embed this into the timer object.
+ */
+typedef struct os_timerWheelNode_tag
+{
+   struct os_timerWheelNode_tag *next;
+   struct os_timerWheelNode_tag *prev;
+   uint64_t expireTick;
+   int32_t slotIndex; //level*OS_TIMER_WHEEL_NUM_SLOTS+slot, -1 when the node is not in the wheel
+   void *arg; //user data
+}os_timerWheelNode_t;
+
+/**
+ * Hierarchical timing wheel with 64-bit ticks.
+ * Level L has OS_TIMER_WHEEL_NUM_SLOTS slots of 2^(L*OS_TIMER_WHEEL_SLOT_BITS) ticks each.
+ * Insert and remove are O(1), a node is moved down at most OS_TIMER_WHEEL_NUM_LEVELS-1 times before it expires.
+ * Nodes further away than the top level can hold are parked in the top level slot that is reached last and are re-inserted from there.
+ */
+typedef struct os_timerWheel_tag
+{
+   os_timerWheelNode_t slots[OS_TIMER_WHEEL_NUM_LEVELS][OS_TIMER_WHEEL_NUM_SLOTS]; //list heads
+   uint64_t occupied[OS_TIMER_WHEEL_NUM_LEVELS]; //bit n is set when slot n is non-empty
+   uint64_t currentTick; //next tick to be processed
+   uint32_t numNodes;
+}os_timerWheel_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+void os_timerWheel_create(os_timerWheel_t *self, uint64_t startTick);
+void os_timerWheel_insert(os_timerWheel_t *self, os_timerWheelNode_t *node, uint64_t expireTick);
+void os_timerWheel_remove(os_timerWheel_t *self, os_timerWheelNode_t *node);
+uint64_t os_timerWheel_nextTick(const os_timerWheel_t *self);
+os_timerWheelNode_t *os_timerWheel_advance(os_timerWheel_t *self, uint64_t tick);
+uint32_t os_timerWheel_length(const os_timerWheel_t *self);
+
+#endif //OS_TIMER_WHEEL_H
@@ -0,0 +1,484 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE //pthread_setaffinity_np
+#endif
+#include "os_executor.h"
+#ifdef _MSC_VER
+#include <process.h>
+#else
+#include <sched.h>
+#include <errno.h>
+#endif
+#include <malloc.h>
+#include <string.h>
+#ifdef MEM_LEAK_CHECK
+# include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define THREAD_STACK_SIZE 65536
+
+#ifdef _MSC_VER
+#define OS_EXECUTOR_LOAD(x) ((uint32_t) InterlockedOr((volatile LONG*) &(x), 0))
+#define OS_EXECUTOR_STORE(x, v) InterlockedExchange((volatile LONG*) &(x), (LONG) (v))
+#define OS_EXECUTOR_ADD(x, v) ((uint32_t) InterlockedExchangeAdd((volatile LONG*) &(x), (LONG) (v)))
+#define OS_EXECUTOR_CAS(x, expected, desired) (InterlockedCompareExchange((volatile LONG*) &(x), (LONG) (desired), (LONG) (expected)) == (LONG) (expected))
+#else
+#define OS_EXECUTOR_LOAD(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define OS_EXECUTOR_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define OS_EXECUTOR_ADD(x, v) __sync_fetch_and_add(&(x), (v))
+#define OS_EXECUTOR_CAS(x, expected, desired) __sync_bool_compare_and_swap(&(x), (expected), (desired))
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static THREAD_PROTO(os_executor_workerThread, arg);
+static os_task_t *os_executor_findTask(os_executor_t *self, os_executorWorker_t *worker);
+static void os_executor_push(os_executor_t *self, os_task_t *task);
+static bool os_executor_wakeWorker(os_executorWorker_t *worker);
+static void os_executor_waitWorker(os_executorWorker_t *worker);
+static void os_executor_applyCpu(os_executorWorker_t *worker);
+static void os_executor_joinWorkers(os_executor_t *self, uint32_t numThreads);
+static void os_executorQueue_push(os_executorQueue_t *queue, uint32_t capacity, os_task_t *task);
+static os_task_t *os_executorQueue_popFront(os_executorQueue_t *queue, uint32_t capacity);
+static os_task_t *os_executorQueue_popBack(os_executorQueue_t *queue, uint32_t capacity);
+static void os_executorQueue_remove(os_executorQueue_t *queue, uint32_t capacity, os_task_t *task);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * return 0 on success, non-zero on error
+ */
+int8_t os_executor_create(os_executor_t *self, uint32_t numWorkers, uint32_t maxNumTasks)
+{
+   if ( (self != 0) && (numWorkers > 0u) && (maxNumTasks > 0u) )
+   {
+      uint32_t i;
+      self->numWorkers = numWorkers;
+      self->maxNumTasks = maxNumTasks;
+      self->numTasks = 0u;
+      self->running = 0u;
+      self->workerThreadsValid = false;
+      self->workers = (os_executorWorker_t*) malloc(sizeof(os_executorWorker_t) * numWorkers);
+      if (self->workers == 0)
+      {
+         return 1;
+      }
+      memset(self->workers, 0, sizeof(os_executorWorker_t) * numWorkers);
+      for (i = 0; i < numWorkers; i++)
+      {
+         os_executorWorker_t *worker = &self->workers[i];
+         uint32_t priority;
+         worker->executor = self;
+         worker->index = i;
+         worker->idle = 0u;
+         worker->cpu = OS_EXECUTOR_NO_CPU;
+         SPINLOCK_INIT(worker->lock);
+         SEMAPHORE_CREATE(worker->semaphore);
+         for (priority = 0; priority < OS_EXECUTOR_NUM_PRIORITIES; priority++)
+         {
+            worker->sharedQueue[priority].tasks = (os_task_t**) malloc(sizeof(os_task_t*) * maxNumTasks);
+            worker->pinnedQueue[priority].tasks = (os_task_t**) malloc(sizeof(os_task_t*) * maxNumTasks);
+            if ( (worker->sharedQueue[priority].tasks == 0) || (worker->pinnedQueue[priority].tasks == 0) )
+            {
+               os_executor_destroy(self);
+               return 1;
+            }
+         }
+      }
+      return 0;
+   }
+   return 1;
+}
+
+void os_executor_destroy(os_executor_t *self)
+{
+   if ( (self != 0) && (self->workers != 0) )
+   {
+      uint32_t i;
+      os_executor_stop(self);
+      for (i = 0; i < self->numWorkers; i++)
+      {
+         os_executorWorker_t *worker = &self->workers[i];
+         uint32_t priority;
+         for (priority = 0; priority < OS_EXECUTOR_NUM_PRIORITIES; priority++)
+         {
+            if (worker->sharedQueue[priority].tasks != 0)
+            {
+               free(worker->sharedQueue[priority].tasks);
+            }
+            if (worker->pinnedQueue[priority].tasks != 0)
+            {
+               free(worker->pinnedQueue[priority].tasks);
+            }
+         }
+         if (worker->executor != 0) //lock and semaphore were initialized
+         {
+            SPINLOCK_DESTROY(worker->lock);
+            SEMAPHORE_DESTROY(worker->semaphore);
+         }
+      }
+      free(self->workers);
+      self->workers = 0;
+   }
+}
+
+/**
+ * Binds worker thread workerIndex to cpu (OS_EXECUTOR_NO_CPU to unbind). Call before os_executor_start.
+ * return 0 on success, non-zero on error
+ */
+int8_t os_executor_setWorkerCpu(os_executor_t *self, uint32_t workerIndex, int32_t cpu)
+{
+   if ( (self != 0) && (workerIndex < self->numWorkers) )
+   {
+      self->workers[workerIndex].cpu = cpu;
+      return 0;
+   }
+   return 1;
+}
+
+/**
+ * return 0 on success, non-zero on error
+ */
+int8_t os_executor_start(os_executor_t *self)
+{
+   if ( (self != 0) && (self->workerThreadsValid == false) )
+   {
+      uint32_t i;
+      OS_EXECUTOR_STORE(self->running, 1u); //set before the worker threads read it
+      for (i = 0; i < self->numWorkers; i++)
+      {
+         os_executorWorker_t *worker = &self->workers[i];
+#ifdef _MSC_VER
+         THREAD_CREATE(worker->workerThread, os_executor_workerThread, worker, worker->threadId);
+         if (worker->workerThread == INVALID_HANDLE_VALUE)
+         {
+            os_executor_joinWorkers(self, i);
+            return 1;
+         }
+#else
+         pthread_attr_t attr;
+         int rc;
+         pthread_attr_init(&attr);
+         pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+         rc = THREAD_CREATE_ATTR(worker->workerThread,attr,os_executor_workerThread,worker);
+         pthread_attr_destroy(&attr);
+         if (rc != 0)
+         {
+            os_executor_joinWorkers(self, i);
+            return 1;
+         }
+#endif
+      }
+      self->workerThreadsValid = true;
+      return 0;
+   }
+   return 1;
+}
+
+/**
+ * Stops the worker threads. Stop the pooled tasks first (os_task_stop), tasks still in the run queues are not run.
+ */
+void os_executor_stop(os_executor_t *self)
+{
+   if ( (self != 0) && (self->workerThreadsValid != false) )
+   {
+      os_executor_joinWorkers(self, self->numWorkers);
+      self->workerThreadsValid = false;
+   }
+}
+
+/**
+ * Registers a pooled task, called by os_task_createPooled.
+ * return 0 on success, non-zero when the executor already has maxNumTasks tasks
+ */
+int8_t os_executor_addTask(os_executor_t *self, os_task_t *task)
+{
+   if ( (self != 0) && (task != 0) )
+   {
+      uint32_t index = OS_EXECUTOR_ADD(self->numTasks, 1u);
+      if (index >= self->maxNumTasks)
+      {
+         OS_EXECUTOR_ADD(self->numTasks, (uint32_t) -1);
+         return 1;
+      }
+      task->homeWorker = index % self->numWorkers; //spread tasks over the workers
+      return 0;
+   }
+   return 1;
+}
+
+/**
+ * Unregisters a pooled task, called by os_task_destroy. Stop the task first (os_task_stop), it must not be running on a worker.
+ */
+void os_executor_removeTask(os_executor_t *self, os_task_t *task)
+{
+   if ( (self != 0) && (self->workers != 0) && (task != 0) )
+   {
+      uint32_t i;
+      for (i = 0; i < self->numWorkers; i++)
+      {
+         os_executorWorker_t *worker = &self->workers[i];
+         uint32_t priority;
+         SPINLOCK_ENTER(worker->lock);
+         for (priority = 0; priority < OS_EXECUTOR_NUM_PRIORITIES; priority++)
+         {
+            os_executorQueue_remove(&worker->sharedQueue[priority], self->maxNumTasks, task);
+            os_executorQueue_remove(&worker->pinnedQueue[priority], self->maxNumTasks, task);
+         }
+         SPINLOCK_LEAVE(worker->lock);
+      }
+      OS_EXECUTOR_ADD(self->numTasks, (uint32_t) -1);
+   }
+}
+
+/**
+ * Puts a task into a run queue, called by os_task_setEvent when it moved the task from idle to scheduled.
+ */
+void os_executor_schedule(os_executor_t *self, os_task_t *task)
+{
+   if ( (self != 0) && (task != 0) )
+   {
+      os_executor_push(self, task);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static THREAD_PROTO(os_executor_workerThread, arg)
+{
+   os_executorWorker_t *worker = (os_executorWorker_t*) arg;
+   os_executor_t *self = worker->executor;
+   os_executor_applyCpu(worker);
+   while (OS_EXECUTOR_LOAD(self->running) != 0u)
+   {
+      os_task_t *task = os_executor_findTask(self, worker);
+      if (task == 0)
+      {
+         //announce idle before the last look so a concurrent os_executor_push either sees idle or its task is found here
+         OS_EXECUTOR_STORE(worker->idle, 1u);
+         task = os_executor_findTask(self, worker);
+         if (task == 0)
+         {
+            os_executor_waitWorker(worker);
+            continue;
+         }
+         if (!OS_EXECUTOR_CAS(worker->idle, 1u, 0u))
+         {
+            os_executor_waitWorker(worker); //consume the post of the thread that cleared idle
+         }
+      }
+      task->homeWorker = worker->index; //rescheduled work stays on this worker unless stolen
+      if (os_task_runEvents(task) > 0)
+      {
+         os_executor_push(self, task);
+      }
+   }
+   THREAD_RETURN(0);
+}
+
+/**
+ * Highest priority first: own pinned queue, own shared queue, then the shared queues of the other workers.
+ */
+static os_task_t *os_executor_findTask(os_executor_t *self, os_executorWorker_t *worker)
+{
+   uint32_t priority;
+   for (priority = 0; priority < OS_EXECUTOR_NUM_PRIORITIES; priority++)
+   {
+      uint32_t i;
+      os_task_t *task = 0;
+      if ( (OS_EXECUTOR_LOAD(worker->pinnedQueue[priority].length) > 0u) || (OS_EXECUTOR_LOAD(worker->sharedQueue[priority].length) > 0u) )
+      {
+         SPINLOCK_ENTER(worker->lock);
+         task = os_executorQueue_popFront(&worker->pinnedQueue[priority], self->maxNumTasks);
+         if (task == 0)
+         {
+            task = os_executorQueue_popFront(&worker->sharedQueue[priority], self->maxNumTasks);
+         }
+         SPINLOCK_LEAVE(worker->lock);
+         if (task != 0)
+         {
+            return task;
+         }
+      }
+      for (i = 1; i < self->numWorkers; i++)
+      {
+         os_executorWorker_t *victim = &self->workers[(worker->index + i) % self->numWorkers];
+         if (OS_EXECUTOR_LOAD(victim->sharedQueue[priority].length) > 0u)
+         {
+            //the owner takes from the front, steal from the back
+            SPINLOCK_ENTER(victim->lock);
+            task = os_executorQueue_popBack(&victim->sharedQueue[priority], self->maxNumTasks);
+            SPINLOCK_LEAVE(victim->lock);
+            if (task != 0)
+            {
+               return task;
+            }
+         }
+      }
+   }
+   return 0;
+}
+
+static void os_executor_push(os_executor_t *self, os_task_t *task)
+{
+   uint32_t priority = (task->priority < OS_EXECUTOR_NUM_PRIORITIES)? task->priority : OS_EXECUTOR_NUM_PRIORITIES-1;
+   if (task->workerIndex >= 0)
+   {
+      os_executorWorker_t *worker = &self->workers[(uint32_t) task->workerIndex % self->numWorkers];
+      SPINLOCK_ENTER(worker->lock);
+      os_executorQueue_push(&worker->pinnedQueue[priority], self->maxNumTasks, task);
+      SPINLOCK_LEAVE(worker->lock);
+      os_executor_wakeWorker(worker);
+   }
+   else
+   {
+      uint32_t home = task->homeWorker % self->numWorkers;
+      os_executorWorker_t *worker = &self->workers[home];
+      uint32_t i;
+      SPINLOCK_ENTER(worker->lock);
+      os_executorQueue_push(&worker->sharedQueue[priority], self->maxNumTasks, task);
+      SPINLOCK_LEAVE(worker->lock);
+      //prefer the home worker, any idle worker can steal the task
+      for (i = 0; i < self->numWorkers; i++)
+      {
+         if (os_executor_wakeWorker(&self->workers[(home + i) % self->numWorkers]))
+         {
+            break;
+         }
+      }
+   }
+}
+
+static bool os_executor_wakeWorker(os_executorWorker_t *worker)
+{
+   if (OS_EXECUTOR_CAS(worker->idle, 1u, 0u))
+   {
+      SEMAPHORE_POST(worker->semaphore);
+      return true;
+   }
+   return false;
+}
+
+static void os_executor_waitWorker(os_executorWorker_t *worker)
+{
+#ifdef _MSC_VER
+   WaitForSingleObject(worker->semaphore, INFINITE);
+#else
+   while (sem_wait(&worker->semaphore) != 0)
+   {
+      if (errno != EINTR)
+      {
+         break;
+      }
+   }
+#endif
+}
+
+static void os_executor_applyCpu(os_executorWorker_t *worker)
+{
+   if (worker->cpu != OS_EXECUTOR_NO_CPU)
+   {
+#ifdef _MSC_VER
+      SetThreadAffinityMask(GetCurrentThread(), ((DWORD_PTR) 1u) << worker->cpu);
+#elif defined(__linux__)
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(worker->cpu, &cpuSet);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#endif
+   }
+}
+
+/**
+ * Stops the first numThreads worker threads
+ */
+static void os_executor_joinWorkers(os_executor_t *self, uint32_t numThreads)
+{
+   uint32_t i;
+   OS_EXECUTOR_STORE(self->running, 0u);
+   for (i = 0; i < numThreads; i++)
+   {
+      SEMAPHORE_POST(self->workers[i].semaphore);
+   }
+   for (i = 0; i < numThreads; i++)
+   {
+      THREAD_JOIN(self->workers[i].workerThread);
+      THREAD_DESTROY(self->workers[i].workerThread);
+   }
+}
+
+/**
+ * A task is in at most one run queue at a time and at most capacity tasks are registered, the queue cannot overflow.
+ */
+static void os_executorQueue_push(os_executorQueue_t *queue, uint32_t capacity, os_task_t *task)
+{
+   if (queue->length < capacity)
+   {
+      queue->tasks[(queue->head + queue->length) % capacity] = task;
+      OS_EXECUTOR_STORE(queue->length, queue->length + 1u);
+   }
+}
+
+static os_task_t *os_executorQueue_popFront(os_executorQueue_t *queue, uint32_t capacity)
+{
+   os_task_t *task = 0;
+   if (queue->length > 0u)
+   {
+      task = queue->tasks[queue->head];
+      queue->head = (queue->head + 1u) % capacity;
+      OS_EXECUTOR_STORE(queue->length, queue->length - 1u);
+   }
+   return task;
+}
+
+static os_task_t *os_executorQueue_popBack(os_executorQueue_t *queue, uint32_t capacity)
+{
+   os_task_t *task = 0;
+   if (queue->length > 0u)
+   {
+      OS_EXECUTOR_STORE(queue->length, queue->length - 1u);
+      task = queue->tasks[(queue->head + queue->length) % capacity];
+   }
+   return task;
+}
+
+/**
+ * Removes task from the queue, keeping the order of the other tasks
+ */
+static void os_executorQueue_remove(os_executorQueue_t *queue, uint32_t capacity, os_task_t *task)
+{
+   uint32_t i;
+   uint32_t numKept = 0u;
+   for (i = 0; i < queue->length; i++)
+   {
+      os_task_t *current = queue->tasks[(queue->head + i) % capacity];
+      if (current != task)
+      {
+         queue->tasks[(queue->head + numKept) % capacity] = current;
+         numKept++;
+      }
+   }
+   if (numKept != queue->length)
+   {
+      OS_EXECUTOR_STORE(queue->length, numKept);
+   }
+}
@@ -8,8 +8,11 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
 #include <time.h>
 #include <limits.h>
+#include <unistd.h>
+#include <errno.h>
 #endif
 #include <stdbool.h>
 #include <assert.h>
@@ -17,10 +20,10 @@
 #include "osmacro.h"
 #include "osutil.h"
 #include "os_schm.h"
-#include "priority_queue.h"
+#include "os_timerWheel.h"
 #include "systime.h"
-#include "adt_ary.h"
 #include <malloc.h>
+#include <string.h>
 #ifdef MEM_LEAK_CHECK
 # include "CMemLeak.h"
 #endif
@@ -29,6 +32,14 @@
 //////////////////////////////////////////////////////////////////////////////
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
+#define OS_SCHM_TICK_NS 1000000u //resolution of the timer wheel, timer events are configured in milliseconds
+
+typedef struct os_schm_timer_tag
+{
+   os_timerWheelNode_t node;
+   const os_timer_ev_cfg_t *cfg;
+}os_schm_timer_t;
+
 static THREAD_PROTO(TimerEventWorker,arg);
 
 //////////////////////////////////////////////////////////////////////////////
@@ -39,13 +50,21 @@ static void shutdownOsTasks(void);
 static void startOsTasks(void);
 static void stopOsTasks(void);
 static void initScheduler(void);
+static uint64_t getCurrentTick(void);
+#ifndef _WIN32
+static uint64_t getMonotonicTimeNs(void);
+static void armTimer(uint64_t tick);
+static void waitTimer(void);
+#endif
+#if(OS_STAT_ENABLE)
+static uint64_t getElapsedTimeNs(void);
+#endif
 
 #ifdef UNIT_TEST
 #define DYN_STATIC
 #else
 #define DYN_STATIC static
 DYN_STATIC void os_schm_run(void);
-DYN_STATIC priority_queue_t *os_time_getPriorityQueue(void);
 #endif
 
 
@@ -58,9 +77,21 @@ extern os_task_cfg_t g_os_task_cfg[];
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL VARIABLES
 //////////////////////////////////////////////////////////////////////////////
-static priority_queue_t m_pq;
+static os_timerWheel_t m_wheel;
+static os_schm_timer_t *m_timers = 0; //strong reference, one per timer event
 static bool m_workerThreadValid;
 static os_schm_cfg_t *m_cfg = 0;
+static uint64_t m_startTimeNs; //tick 0 of the timer wheel
+static uint32_t m_lastTimeMs; //latest value returned by m_getTimeFn
+static uint64_t m_timeMsHigh; //extends m_getTimeFn to 64 bits
+#ifndef _WIN32
+static int m_timerFd = -1;
+#endif
+#if(OS_STAT_ENABLE)
+static os_timerWheelNode_t m_statDumpNode;
+static FILE *m_statDumpFile = 0;
+static uint32_t m_statDumpPeriodMs = 0u;
+#endif
 
 THREAD_T m_thread_worker;
 SPINLOCK_T m_spin;
@@ -79,22 +110,41 @@ void (*m_eventTriggerHook)(const os_timer_ev_cfg_t *cfg);
 /**
  * \param cfg array of event object.
  * \param u32CfgLen number of elements in configuration array
- * \timerfunc pointer to function that returns current system time (default: SysTime_getTime)
+ * \timerfunc pointer to function that returns current system time in ms.
+ *  When not set the scheduler sleeps on CLOCK_MONOTONIC until the next deadline (Windows: SysTime_getTime)
  */
 void os_schm_init(os_schm_cfg_t *cfg)
 {   
    m_cfg = cfg;
-   priority_queue_create(&m_pq);
+   os_timerWheel_create(&m_wheel, 0u);
    
    m_workerThreadValid = false;
-   if (m_cfg->timerEventHookFunc != 0)
+   m_eventTriggerHook = m_cfg->timerEventHookFunc;
+   if (m_cfg->timerFunc != 0)
    {
       m_getTimeFn = m_cfg->timerFunc;
    }
    else
    {
+#ifdef _WIN32
       m_getTimeFn = SysTime_getTime;
-   }   
+#else
+      m_getTimeFn = 0;
+#endif
+   }
+   m_lastTimeMs = 0u;
+   m_timeMsHigh = 0u;
+#if(OS_STAT_ENABLE)
+   m_statDumpNode.slotIndex = -1;
+   m_statDumpFile = 0;
+   m_statDumpPeriodMs = 0u;
+   os_stat_reset();
+#endif
+#ifndef _WIN32
+   m_startTimeNs = getMonotonicTimeNs();
+#else
+   m_startTimeNs = 0u;
+#endif
    
    initOsTasks();
    initScheduler();
@@ -102,7 +152,11 @@ void os_schm_init(os_schm_cfg_t *cfg)
 
 void os_schm_shutdown(void)
 {
-   priority_queue_destroy(&m_pq);
+   if (m_timers != 0)
+   {
+      free(m_timers);
+      m_timers = 0;
+   }
    shutdownOsTasks();
 }
 
@@ -114,15 +168,29 @@ void os_schm_start(void)
 
    SPINLOCK_INIT(m_spin);   
    m_workerThreadValid = false;
-   m_running = 0;
+   m_running = 1; //set before the worker thread reads it
 
    startOsTasks();
+#ifndef _WIN32
+   if (m_getTimeFn == 0)
+   {
+      m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+      if (m_timerFd < 0)
+      {
+         fprintf(stderr, "[OS_SCHM] timerfd_create failed, errno=%d\n", errno);
+         m_running = 0;
+         return;
+      }
+      m_startTimeNs = getMonotonicTimeNs();
+   }
+#endif
 
 #ifdef _MSC_VER
    THREAD_CREATE(m_thread_worker, TimerEventWorker, 0, m_threadId);
    if (m_thread_worker == INVALID_HANDLE_VALUE)
    {
       m_workerThreadValid = false;
+      m_running = 0;
       return;
    }
 #else
@@ -131,36 +199,83 @@ void os_schm_start(void)
    THREAD_CREATE_ATTR(m_thread_worker,attr,TimerEventWorker,0);
 #endif
    m_workerThreadValid = true;
-   m_running = 1;
 }
 
 void os_schm_stop(void)
 {
+   if (m_workerThreadValid == false)
+   {
+      return;
+   }
    SPINLOCK_ENTER(m_spin);
    m_running = 0;
+#ifndef _WIN32
+   if (m_timerFd >= 0)
+   {
+      armTimer(0u); //wake up the worker, it is armed while m_spin is held so this cannot be overwritten
+   }
+#endif
    SPINLOCK_LEAVE(m_spin);
    THREAD_JOIN(m_thread_worker);
    THREAD_DESTROY(m_thread_worker);
    SPINLOCK_DESTROY(m_spin);
+#ifndef _WIN32
+   if (m_timerFd >= 0)
+   {
+      close(m_timerFd);
+      m_timerFd = -1;
+   }
+#endif
    m_workerThreadValid = false;
    stopOsTasks();
 }
 
+#if(OS_STAT_ENABLE)
+/**
+ * Prints os_stat histograms to fp every periodMs from the scheduler thread. A periodMs of 0 (or fp = 0) disables the dump.
+ * Call between os_schm_init and os_schm_start.
+ */
+void os_schm_setStatDump(FILE *fp, uint32_t periodMs)
+{
+   os_timerWheel_remove(&m_wheel, &m_statDumpNode);
+   m_statDumpFile = fp;
+   m_statDumpPeriodMs = periodMs;
+   if ( (fp != 0) && (periodMs > 0u) )
+   {
+      m_statDumpNode.arg = 0;
+      os_timerWheel_insert(&m_wheel, &m_statDumpNode, m_wheel.currentTick + periodMs);
+   }
+}
+#endif
+
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
 DYN_STATIC void os_schm_run(void)
 {
-   uint32_t currentTimeMs = m_getTimeFn();
-   while(1)
+   uint64_t currentTick = getCurrentTick();
+   os_timerWheelNode_t *node = os_timerWheel_advance(&m_wheel, currentTick);
+   while (node != 0)
    {
-      adt_heap_elem_t* elem = priority_queue_top(&m_pq);
-      if (currentTimeMs >= elem->u32Value)
+      os_timerWheelNode_t *next = node->next;
+      const os_timer_ev_cfg_t *cfg;
+      uint64_t expireTick = node->expireTick;
+#if(OS_STAT_ENABLE)
+      if (node == &m_statDumpNode)
       {
-         const os_timer_ev_cfg_t *cfg = (const os_timer_ev_cfg_t*) elem->pItem;
-         //printf("{%u, %d},\n", currentTimeMs, (int) cfg->eventID);
-
+         os_stat_dump(m_statDumpFile);
+         os_timerWheel_insert(&m_wheel, node, currentTick + m_statDumpPeriodMs);
+         node = next;
+         continue;
+      }
+#endif
+      cfg = ((os_schm_timer_t*) node->arg)->cfg;
+      do
+      {
+#if(OS_STAT_ENABLE)
+         os_stat_record(cfg->eventID, OS_STAT_FIRE_LATENCY, getElapsedTimeNs() - expireTick * OS_SCHM_TICK_NS);
+#endif
          //call hook if set
          if (m_eventTriggerHook != 0)
          {
@@ -171,39 +286,53 @@ DYN_STATIC void os_schm_run(void)
          {
             os_task_setEvent(cfg->task, cfg->eventID);
          }
-         priority_queue_incrementTopPriority(&m_pq, cfg->u32PeriodMs);
-      }
-      else
+         //next deadline follows the absolute schedule (initial delay + n*period), not the time the event fired
+         expireTick += cfg->u32PeriodMs;
+      } while ( (cfg->u32PeriodMs > 0u) && (expireTick <= currentTick) );
+      if (cfg->u32PeriodMs > 0u)
       {
-         break;
+         os_timerWheel_insert(&m_wheel, node, expireTick);
       }
+      node = next;
    }
 }
 
 THREAD_PROTO(TimerEventWorker,arg){
-   SysTime_reset();
+   if (m_getTimeFn != 0)
+   {
+      SysTime_reset();
+   }
    os_schm_run();
    for(;;)
    {
       uint8_t running;
       SPINLOCK_ENTER(m_spin);
       running = m_running;
+#ifndef _WIN32
+      if ( (running != 0) && (m_getTimeFn == 0) )
+      {
+         armTimer(os_timerWheel_nextTick(&m_wheel));
+      }
+#endif
       SPINLOCK_LEAVE(m_spin);
       if(running == 0){
          break;
       }
-      SysTime_wait(1);
+#ifndef _WIN32
+      if (m_getTimeFn == 0)
+      {
+         waitTimer();
+      }
+      else
+#endif
+      {
+         SysTime_wait(1);
+      }
       os_schm_run();
    }
    THREAD_RETURN(0);
 }
 
-
-DYN_STATIC priority_queue_t *os_time_getPriorityQueue(void)
-{
-   return &m_pq;
-}
-
 static void initOsTasks(void)  
 {
    uint32_t i;
@@ -243,8 +372,95 @@ static void stopOsTasks(void)
 static void initScheduler(void)
 {
    uint32_t i;
+   m_timers = (os_schm_timer_t*) malloc(sizeof(os_schm_timer_t) * (m_cfg->numTimerEvents > 0u? m_cfg->numTimerEvents : 1u));
+   if (m_timers == 0)
+   {
+      return;
+   }
    for (i = 0; i<m_cfg->numTimerEvents; i++)
    {
-      priority_queue_push(&m_pq, (void*)&m_cfg->timerEventList[i], m_cfg->timerEventList[i].u32InitDelayMs);
+      os_schm_timer_t *timer = &m_timers[i];
+      timer->cfg = &m_cfg->timerEventList[i];
+      timer->node.arg = (void*) timer;
+      os_timerWheel_insert(&m_wheel, &timer->node, m_cfg->timerEventList[i].u32InitDelayMs);
    }
-}
\ No newline at end of file
+}
+
+/**
+ * returns milliseconds since os_schm_start as a 64-bit value
+ */
+static uint64_t getCurrentTick(void)
+{
+   if (m_getTimeFn != 0)
+   {
+      uint32_t timeMs = m_getTimeFn();
+      if (timeMs < m_lastTimeMs)
+      {
+         m_timeMsHigh += ((uint64_t) 1u) << 32; //32-bit millisecond counter wraps after 49.7 days
+      }
+      m_lastTimeMs = timeMs;
+      return m_timeMsHigh + timeMs;
+   }
+#ifndef _WIN32
+   return (getMonotonicTimeNs() - m_startTimeNs) / OS_SCHM_TICK_NS;
+#else
+   return 0u;
+#endif
+}
+
+#if(OS_STAT_ENABLE)
+/**
+ * returns time since os_schm_start in ns, in the same time base as the timer wheel ticks
+ */
+static uint64_t getElapsedTimeNs(void)
+{
+   if (m_getTimeFn != 0)
+   {
+      return (m_timeMsHigh + m_lastTimeMs) * OS_SCHM_TICK_NS; //resolution of the custom timer function
+   }
+#ifndef _WIN32
+   return getMonotonicTimeNs() - m_startTimeNs;
+#else
+   return 0u;
+#endif
+}
+#endif
+
+#ifndef _WIN32
+static uint64_t getMonotonicTimeNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t) ts.tv_sec) * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * arms m_timerFd to expire at tick (absolute), disarms it when tick is OS_TIMER_WHEEL_NO_TICK
+ */
+static void armTimer(uint64_t tick)
+{
+   struct itimerspec its;
+   memset(&its, 0, sizeof(its));
+   if (tick != OS_TIMER_WHEEL_NO_TICK)
+   {
+      uint64_t deadlineNs = m_startTimeNs + tick * OS_SCHM_TICK_NS;
+      its.it_value.tv_sec = (time_t) (deadlineNs / 1000000000u);
+      its.it_value.tv_nsec = (long) (deadlineNs % 1000000000u);
+      if ( (its.it_value.tv_sec == 0) && (its.it_value.tv_nsec == 0) )
+      {
+         its.it_value.tv_nsec = 1; //all zero disarms the timer
+      }
+   }
+   timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &its, 0);
+}
+
+static void waitTimer(void)
+{
+   uint64_t numExpirations;
+   ssize_t result;
+   do
+   {
+      result = read(m_timerFd, &numExpirations, sizeof(numExpirations));
+   } while ( (result < 0) && (errno == EINTR) );
+}
+#endif
\ No newline at end of file
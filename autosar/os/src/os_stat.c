@@ -0,0 +1,270 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+#include "os_stat.h"
+#ifdef MEM_LEAK_CHECK
+# include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+#define OS_STAT_ADD32(x, v) InterlockedExchangeAdd((volatile LONG*) &(x), (LONG) (v))
+#define OS_STAT_ADD64(x, v) InterlockedExchangeAdd64((volatile LONG64*) &(x), (LONG64) (v))
+#define OS_STAT_LOAD32(x) ((uint32_t) InterlockedOr((volatile LONG*) &(x), 0))
+#define OS_STAT_LOAD64(x) ((uint64_t) InterlockedOr64((volatile LONG64*) &(x), 0))
+#define OS_STAT_STORE32(x, v) InterlockedExchange((volatile LONG*) &(x), (LONG) (v))
+#define OS_STAT_STORE64(x, v) InterlockedExchange64((volatile LONG64*) &(x), (LONG64) (v))
+#define OS_STAT_CAS64(x, expected, desired) (InterlockedCompareExchange64((volatile LONG64*) &(x), (LONG64) (desired), (LONG64) (expected)) == (LONG64) (expected))
+#else
+#define OS_STAT_ADD32(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_RELAXED)
+#define OS_STAT_ADD64(x, v) __atomic_fetch_add(&(x), (v), __ATOMIC_RELAXED)
+#define OS_STAT_LOAD32(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define OS_STAT_LOAD64(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define OS_STAT_STORE32(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define OS_STAT_STORE64(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define OS_STAT_CAS64(x, expected, desired) __sync_bool_compare_and_swap(&(x), (expected), (desired))
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t os_stat_bucketIndex(uint64_t valueNs);
+static void os_stat_updateMax(uint64_t *maxValue, uint64_t value);
+static void os_stat_loadHistogram(os_stat_histogram_t *dest, os_stat_histogram_t *src);
+static void os_stat_dumpHistogram(FILE *fp, uint16_t eventId, const char *kindName, const os_stat_histogram_t *hist);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+static os_stat_histogram_t m_histograms[OS_STAT_MAX_NUM_EVENTS][OS_STAT_NUM_KINDS];
+static const char *m_kindNames[OS_STAT_NUM_KINDS] = {"fire latency", "queue wait", "run time"};
+#ifdef _MSC_VER
+static LARGE_INTEGER m_freq;
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Clears all histograms. Samples recorded concurrently with the reset may be partially kept.
+ */
+void os_stat_reset(void)
+{
+   uint32_t eventId;
+   for (eventId = 0; eventId < OS_STAT_MAX_NUM_EVENTS; eventId++)
+   {
+      uint32_t kind;
+      for (kind = 0; kind < OS_STAT_NUM_KINDS; kind++)
+      {
+         os_stat_histogram_t *hist = &m_histograms[eventId][kind];
+         uint32_t i;
+         for (i = 0; i < OS_STAT_NUM_BUCKETS; i++)
+         {
+            OS_STAT_STORE32(hist->buckets[i], 0u);
+         }
+         OS_STAT_STORE32(hist->count, 0u);
+         OS_STAT_STORE64(hist->sumNs, 0u);
+         OS_STAT_STORE64(hist->maxNs, 0u);
+         OS_STAT_STORE64(hist->minNsInv, 0u);
+      }
+   }
+}
+
+/**
+ * returns monotonic time in nanoseconds
+ */
+uint64_t os_stat_now(void)
+{
+#ifdef _MSC_VER
+   LARGE_INTEGER counter;
+   if (m_freq.QuadPart == 0)
+   {
+      QueryPerformanceFrequency(&m_freq);
+   }
+   QueryPerformanceCounter(&counter);
+   return (uint64_t) ( (counter.QuadPart / m_freq.QuadPart) * 1000000000 + ( (counter.QuadPart % m_freq.QuadPart) * 1000000000) / m_freq.QuadPart);
+#else
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((uint64_t) ts.tv_sec) * 1000000000u + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+/**
+ * Adds one sample to the histogram of eventId. Safe to call from any thread, it never blocks.
+ */
+void os_stat_record(uint16_t eventId, os_stat_kind_t kind, uint64_t valueNs)
+{
+   if ( (eventId < OS_STAT_MAX_NUM_EVENTS) && (kind < OS_STAT_NUM_KINDS) )
+   {
+      os_stat_histogram_t *hist = &m_histograms[eventId][kind];
+      OS_STAT_ADD32(hist->buckets[os_stat_bucketIndex(valueNs)], 1u);
+      OS_STAT_ADD32(hist->count, 1u);
+      OS_STAT_ADD64(hist->sumNs, valueNs);
+      os_stat_updateMax(&hist->maxNs, valueNs);
+      os_stat_updateMax(&hist->minNsInv, ~valueNs);
+   }
+}
+
+/**
+ * Copies the current histograms of eventId into snapshot.
+ * returns 0 on success, -1 if eventId is out of range
+ */
+int8_t os_stat_getSnapshot(uint16_t eventId, os_stat_snapshot_t *snapshot)
+{
+   if ( (snapshot != 0) && (eventId < OS_STAT_MAX_NUM_EVENTS) )
+   {
+      uint32_t kind;
+      snapshot->eventId = eventId;
+      for (kind = 0; kind < OS_STAT_NUM_KINDS; kind++)
+      {
+         os_stat_loadHistogram(&snapshot->hist[kind], &m_histograms[eventId][kind]);
+      }
+      return 0;
+   }
+   return -1;
+}
+
+uint64_t os_stat_histogram_min(const os_stat_histogram_t *hist)
+{
+   if ( (hist != 0) && (hist->minNsInv != 0u) )
+   {
+      return ~hist->minNsInv;
+   }
+   return 0u;
+}
+
+uint64_t os_stat_histogram_mean(const os_stat_histogram_t *hist)
+{
+   if ( (hist != 0) && (hist->count > 0u) )
+   {
+      return hist->sumNs / hist->count;
+   }
+   return 0u;
+}
+
+/**
+ * Returns an upper bound of the given percentile (in 1/1000) based on bucket boundaries, never larger than maxNs.
+ */
+uint64_t os_stat_histogram_percentile(const os_stat_histogram_t *hist, uint32_t permille)
+{
+   if ( (hist != 0) && (hist->count > 0u) )
+   {
+      uint64_t target = ( ((uint64_t) hist->count) * permille + 999u) / 1000u;
+      uint64_t sum = 0u;
+      uint32_t i;
+      if (target == 0u)
+      {
+         target = 1u;
+      }
+      for (i = 0; i < OS_STAT_NUM_BUCKETS-1; i++)
+      {
+         sum += hist->buckets[i];
+         if (sum >= target)
+         {
+            uint64_t upperBound = (i == 0)? 0u : ( (((uint64_t) 1u) << i) - 1u);
+            return (upperBound < hist->maxNs)? upperBound : hist->maxNs;
+         }
+      }
+      return hist->maxNs;
+   }
+   return 0u;
+}
+
+/**
+ * Prints all non-empty histograms, one line per event ID and kind. Times are in microseconds.
+ */
+void os_stat_dump(FILE *fp)
+{
+   uint16_t eventId;
+   if (fp == 0)
+   {
+      return;
+   }
+   fprintf(fp, "[OS_STAT] %5s %-12s %10s %10s %10s %10s %10s %10s\n", "event", "kind", "count", "min", "mean", "p50", "p99", "max");
+   for (eventId = 0; eventId < OS_STAT_MAX_NUM_EVENTS; eventId++)
+   {
+      os_stat_snapshot_t snapshot;
+      uint32_t kind;
+      os_stat_getSnapshot(eventId, &snapshot);
+      for (kind = 0; kind < OS_STAT_NUM_KINDS; kind++)
+      {
+         if (snapshot.hist[kind].count > 0u)
+         {
+            os_stat_dumpHistogram(fp, eventId, m_kindNames[kind], &snapshot.hist[kind]);
+         }
+      }
+   }
+   fflush(fp);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static uint32_t os_stat_bucketIndex(uint64_t valueNs)
+{
+   uint32_t index = 0u;
+   if (valueNs == 0u)
+   {
+      return 0u;
+   }
+#if defined(__GNUC__) || defined(__clang__)
+   index = 64u - (uint32_t) __builtin_clzll(valueNs);
+#else
+   while (valueNs != 0u)
+   {
+      valueNs >>= 1;
+      index++;
+   }
+#endif
+   return (index < OS_STAT_NUM_BUCKETS)? index : OS_STAT_NUM_BUCKETS-1;
+}
+
+static void os_stat_updateMax(uint64_t *maxValue, uint64_t value)
+{
+   uint64_t current = OS_STAT_LOAD64(*maxValue);
+   while (value > current)
+   {
+      if (OS_STAT_CAS64(*maxValue, current, value))
+      {
+         break;
+      }
+      current = OS_STAT_LOAD64(*maxValue);
+   }
+}
+
+static void os_stat_loadHistogram(os_stat_histogram_t *dest, os_stat_histogram_t *src)
+{
+   uint32_t i;
+   dest->count = OS_STAT_LOAD32(src->count);
+   for (i = 0; i < OS_STAT_NUM_BUCKETS; i++)
+   {
+      dest->buckets[i] = OS_STAT_LOAD32(src->buckets[i]);
+   }
+   dest->sumNs = OS_STAT_LOAD64(src->sumNs);
+   dest->maxNs = OS_STAT_LOAD64(src->maxNs);
+   dest->minNsInv = OS_STAT_LOAD64(src->minNsInv);
+}
+
+static void os_stat_dumpHistogram(FILE *fp, uint16_t eventId, const char *kindName, const os_stat_histogram_t *hist)
+{
+   fprintf(fp, "[OS_STAT] %5u %-12s %10u %10llu %10llu %10llu %10llu %10llu\n", (unsigned int) eventId, kindName, (unsigned int) hist->count,
+         (unsigned long long) (os_stat_histogram_min(hist) / 1000u),
+         (unsigned long long) (os_stat_histogram_mean(hist) / 1000u),
+         (unsigned long long) (os_stat_histogram_percentile(hist, 500u) / 1000u),
+         (unsigned long long) (os_stat_histogram_percentile(hist, 990u) / 1000u),
+         (unsigned long long) (hist->maxNs / 1000u));
+}
@@ -2,6 +2,7 @@
 // INCLUDES
 //////////////////////////////////////////////////////////////////////////////
 #include "os_task.h"
+#include "os_executor.h"
 #ifdef _MSC_VER
 #include <process.h>
 #endif
@@ -16,10 +17,29 @@
 // CONSTANTS AND DATA TYPES
 //////////////////////////////////////////////////////////////////////////////
 #define THREAD_STACK_SIZE 65536
+#define OS_TASK_MAX_BATCH_SIZE 16 //events handled by a pooled task before it goes back to the run queue
+#if(OS_STAT_ENABLE)
+typedef os_taskEvent_t os_task_queueElem_t;
+#define OS_TASK_EVENT_ID(elem) ((elem).eventId)
+#else
+typedef uint16_t os_task_queueElem_t;
+#define OS_TASK_EVENT_ID(elem) (elem)
+#endif
+#define OS_TASK_EVENT_SIZE sizeof(os_task_queueElem_t)
+
+#ifdef _MSC_VER
+#define OS_TASK_STORE(x, v) InterlockedExchange((volatile LONG*) &(x), (LONG) (v))
+#define OS_TASK_CAS(x, expected, desired) (InterlockedCompareExchange((volatile LONG*) &(x), (LONG) (desired), (LONG) (expected)) == (LONG) (expected))
+#else
+#define OS_TASK_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define OS_TASK_CAS(x, expected, desired) __sync_bool_compare_and_swap(&(x), (expected), (desired))
+#endif
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTION PROTOTYPES
 //////////////////////////////////////////////////////////////////////////////
+static int8_t os_task_init(os_task_t *self, uint16_t u16MaxNumEvents);
+static void os_task_insertEvent(os_task_t *self, const uint8_t *event);
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -43,17 +63,42 @@ int8_t os_task_create(os_task_t *self, THREAD_PROTO_PTR(thread_func, arg), uint1
 {
    if (self != 0)
    {
-      self->eventQueueBufIsWeakRef = false;
-      self->workerThreadValid = false;
-      self->eventQueueBuf = (uint16_t*) malloc(sizeof(uint16_t)*((size_t)u16MaxNumEvents));
-      if (self->eventQueueBuf != 0)
+      self->thread_func = thread_func;
+      self->executor = 0;
+      self->handler = 0;
+      self->handlerArg = 0;
+      return os_task_init(self, u16MaxNumEvents);
+   }
+   return 1;
+}
+
+/**
+ * Creates a task without a thread of its own. Its events are handed to handler on one of the worker threads of executor.
+ * Events of the same task are handled in the order they were set and never concurrently.
+ * os_task_stop passes OS_SHUTDOWN_EVENT_ID to handler as the last event.
+ * return 0 on success, non-zero on error
+ */
+int8_t os_task_createPooled(os_task_t *self, os_executor_t *executor, os_task_handler_t handler, void *arg, uint16_t u16MaxNumEvents)
+{
+   if ( (self != 0) && (executor != 0) && (handler != 0) )
+   {
+      int8_t result;
+      self->thread_func = 0;
+      self->executor = 0; //set once the task is registered, see os_task_destroy
+      self->handler = handler;
+      self->handlerArg = arg;
+      result = os_task_init(self, u16MaxNumEvents);
+      if (result == 0)
       {
-         self->thread_func = thread_func;
-         rbfu16_create(&self->eventQueue, self->eventQueueBuf, u16MaxNumEvents);
-         SEMAPHORE_CREATE(self->semaphore);
-         SPINLOCK_INIT(self->lock);
-         return 0;
+         if (os_executor_addTask(executor, self) != 0)
+         {
+            os_task_destroy(self);
+            self->eventQueueBuf = 0;
+            return 1;
+         }
+         self->executor = executor;
       }
+      return result;
    }
    return 1;
 }
@@ -62,6 +107,10 @@ void os_task_destroy(os_task_t *self)
 {
    if (self != 0)
    {
+      if (self->executor != 0)
+      {
+         os_executor_removeTask(self->executor, self);
+      }
       SPINLOCK_DESTROY(self->lock);
       if ( (self->eventQueueBuf != 0) && (self->eventQueueBufIsWeakRef == false) )
       {
@@ -72,7 +121,12 @@ void os_task_destroy(os_task_t *self)
 
 void os_task_start(os_task_t *self)
 {
-   if ( (self != 0) && (self->workerThreadValid == false) )
+   if ( (self != 0) && (self->workerThreadValid == false) && (self->executor != 0) )
+   {
+      OS_TASK_STORE(self->runState, OS_TASK_RUN_STATE_IDLE);
+      self->workerThreadValid = true; //accepts events from now on
+   }
+   else if ( (self != 0) && (self->workerThreadValid == false) )
    {
 #ifndef _MSC_VER
       pthread_attr_t attr;
@@ -96,7 +150,24 @@ void os_task_start(os_task_t *self)
 
 void os_task_stop(os_task_t *self)
 {
-   if (self != 0)
+   if ( (self != 0) && (self->executor != 0) )
+   {
+      if (self->workerThreadValid != false)
+      {
+         os_task_setEvent(self, OS_SHUTDOWN_EVENT_ID);
+         //posted by os_task_runEvents after it has handled the shutdown event
+   #ifdef _MSC_VER
+         WaitForSingleObject(self->semaphore, INFINITE);
+   #else
+         while (sem_wait(&self->semaphore) != 0)
+         {
+            //interrupted by signal
+         }
+   #endif
+         self->workerThreadValid = false;
+      }
+   }
+   else if (self != 0)
    {
       os_task_setEvent(self, OS_SHUTDOWN_EVENT_ID);      
       THREAD_JOIN(self->workerThread);
@@ -109,10 +180,26 @@ void os_task_setEvent(os_task_t *self, uint16_t eventId)
 {
    if ((self != 0) && (self->workerThreadValid != false))
    {
-      SPINLOCK_ENTER(self->lock);
-      rbfu16_insert(&self->eventQueue, eventId);
-      SPINLOCK_LEAVE(self->lock);
-      SEMAPHORE_POST(self->semaphore);      
+#if(OS_STAT_ENABLE)
+      os_taskEvent_t event;
+      event.enqueueTimeNs = os_stat_now();
+      event.eventId = eventId;
+      os_task_insertEvent(self, (const uint8_t*) &event);
+#else
+      os_task_insertEvent(self, (const uint8_t*) &eventId);
+#endif
+      if (self->executor != 0)
+      {
+         //only the caller that moves the task out of idle puts it in a run queue, a running task checks its queue before it goes idle
+         if (OS_TASK_CAS(self->runState, OS_TASK_RUN_STATE_IDLE, OS_TASK_RUN_STATE_SCHEDULED))
+         {
+            os_executor_schedule(self->executor, self);
+         }
+      }
+      else
+      {
+         SEMAPHORE_POST(self->semaphore);
+      }
    }
 }
 
@@ -120,6 +207,13 @@ uint16_t os_task_waitEvent(os_task_t *self)
 {
    if (self != 0)
    {
+#if(OS_STAT_ENABLE)
+      if (self->activeEventId != OS_INVALID_EVENT_ID)
+      {
+         os_stat_record(self->activeEventId, OS_STAT_RUN_TIME, os_stat_now() - self->activeStartNs);
+         self->activeEventId = OS_INVALID_EVENT_ID;
+      }
+#endif
    #ifdef _MSC_VER
       DWORD result = WaitForSingleObject(self->semaphore, INFINITE);
       if (result == WAIT_OBJECT_0)
@@ -128,15 +222,26 @@ uint16_t os_task_waitEvent(os_task_t *self)
       if (result == 0)
    #endif
       {
-         uint16_t eventId;
          uint8_t rc;
-         SPINLOCK_ENTER(self->lock);
-         rc = rbfu16_remove(&self->eventQueue, &eventId);
-         SPINLOCK_LEAVE(self->lock);
+#if(OS_STAT_ENABLE)
+         os_taskEvent_t event;
+         rc = rbf32_remove(&self->eventQueue, (uint8_t*) &event);
+         if (rc == E_BUF_OK)
+         {
+            uint64_t timeNs = os_stat_now();
+            os_stat_record(event.eventId, OS_STAT_QUEUE_WAIT, timeNs - event.enqueueTimeNs);
+            self->activeEventId = event.eventId;
+            self->activeStartNs = timeNs;
+            return event.eventId;
+         }
+#else
+         uint16_t eventId;
+         rc = rbf32_remove(&self->eventQueue, (uint8_t*) &eventId);
          if (rc == E_BUF_OK)
          {
             return eventId;
          }
+#endif
          else
          {
             return OS_INVALID_EVENT_ID;
@@ -146,7 +251,119 @@ uint16_t os_task_waitEvent(os_task_t *self)
    return OS_INVALID_EVENT_ID;
 }
 
+/**
+ * Sets run queue priority of a pooled task, 0 is the highest. Call before os_task_start.
+ */
+void os_task_setPriority(os_task_t *self, uint8_t priority)
+{
+   if (self != 0)
+   {
+      self->priority = (priority < OS_EXECUTOR_NUM_PRIORITIES)? priority : (uint8_t) (OS_EXECUTOR_NUM_PRIORITIES-1);
+   }
+}
+
+/**
+ * Binds a pooled task to one executor worker (OS_TASK_ANY_WORKER to let any worker run it). Call before os_task_start.
+ * Use os_executor_setWorkerCpu to bind the worker itself to a CPU.
+ */
+void os_task_setWorker(os_task_t *self, int32_t workerIndex)
+{
+   if (self != 0)
+   {
+      self->workerIndex = workerIndex;
+      if (workerIndex >= 0)
+      {
+         self->homeWorker = (uint32_t) workerIndex;
+      }
+   }
+}
+
+/**
+ * Called by an executor worker for a scheduled pooled task. Handles up to OS_TASK_MAX_BATCH_SIZE events.
+ * returns 1 when the task has more events and must be put back in a run queue,
+ * 0 when it went idle and -1 when the shutdown event was handled (the task must not be touched after that).
+ */
+int8_t os_task_runEvents(os_task_t *self)
+{
+   os_task_queueElem_t batch[OS_TASK_MAX_BATCH_SIZE];
+   uint32_t numEvents;
+   uint32_t i;
+#if(OS_STAT_ENABLE)
+   uint64_t timeNs;
+#endif
+   if ( (self == 0) || (self->handler == 0) )
+   {
+      return 0;
+   }
+   OS_TASK_STORE(self->runState, OS_TASK_RUN_STATE_RUNNING);
+   numEvents = rbf32_removeN(&self->eventQueue, (uint8_t*) &batch[0], OS_TASK_MAX_BATCH_SIZE);
+#if(OS_STAT_ENABLE)
+   timeNs = os_stat_now();
+#endif
+   for (i = 0; i < numEvents; i++)
+   {
+      uint16_t eventId = OS_TASK_EVENT_ID(batch[i]);
+#if(OS_STAT_ENABLE)
+      uint64_t endTimeNs;
+      os_stat_record(eventId, OS_STAT_QUEUE_WAIT, timeNs - batch[i].enqueueTimeNs);
+#endif
+      self->handler(self->handlerArg, eventId);
+#if(OS_STAT_ENABLE)
+      endTimeNs = os_stat_now();
+      os_stat_record(eventId, OS_STAT_RUN_TIME, endTimeNs - timeNs);
+      timeNs = endTimeNs;
+#endif
+      if (eventId == OS_SHUTDOWN_EVENT_ID)
+      {
+         OS_TASK_STORE(self->runState, OS_TASK_RUN_STATE_STOPPED);
+         SEMAPHORE_POST(self->semaphore);
+         return -1;
+      }
+   }
+   OS_TASK_STORE(self->runState, OS_TASK_RUN_STATE_IDLE);
+   //events set while the task was running did not schedule it
+   if ( (rbf32_size(&self->eventQueue) > 0u) && OS_TASK_CAS(self->runState, OS_TASK_RUN_STATE_IDLE, OS_TASK_RUN_STATE_SCHEDULED) )
+   {
+      return 1;
+   }
+   return 0;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////
 // LOCAL FUNCTIONS
 //////////////////////////////////////////////////////////////////////////////
+static int8_t os_task_init(os_task_t *self, uint16_t u16MaxNumEvents)
+{
+   uint32_t u32NumElem = rbf32_calcNumElem(u16MaxNumEvents);
+   self->eventQueueBufIsWeakRef = false;
+   self->workerThreadValid = false;
+   self->runState = OS_TASK_RUN_STATE_IDLE;
+   self->priority = 0u;
+   self->workerIndex = OS_TASK_ANY_WORKER;
+   self->homeWorker = 0u;
+   self->eventQueueBuf = (uint16_t*) malloc(OS_TASK_EVENT_SIZE*((size_t)u32NumElem));
+   if (self->eventQueueBuf != 0)
+   {
+#if(OS_STAT_ENABLE)
+      self->activeEventId = OS_INVALID_EVENT_ID;
+      self->activeStartNs = 0u;
+#endif
+      rbf32_create(&self->eventQueue, (uint8_t*) self->eventQueueBuf, u32NumElem, (uint32_t) OS_TASK_EVENT_SIZE);
+      SEMAPHORE_CREATE(self->semaphore);
+      SPINLOCK_INIT(self->lock);
+      return 0;
+   }
+   return 1;
+}
+
+static void os_task_insertEvent(os_task_t *self, const uint8_t *event)
+{
+#if(RBF32_ATOMIC_ENABLE)
+   rbf32_mpsc_insert(&self->eventQueue, event);
+#else
+   SPINLOCK_ENTER(self->lock);
+   rbf32_insert(&self->eventQueue, event);
+   SPINLOCK_LEAVE(self->lock);
+#endif
+}
@@ -0,0 +1,290 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <string.h>
+#include "os_timerWheel.h"
+#ifdef MEM_LEAK_CHECK
+# include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define TOP_LEVEL (OS_TIMER_WHEEL_NUM_LEVELS-1)
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void os_timerWheel_link(os_timerWheel_t *self, os_timerWheelNode_t *node);
+static void os_timerWheel_unlink(os_timerWheel_t *self, os_timerWheelNode_t *node);
+static void os_timerWheel_cascade(os_timerWheel_t *self, int32_t level, uint32_t slot);
+static int32_t os_timerWheel_findSlot(uint64_t occupied, uint32_t fromSlot);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+void os_timerWheel_create(os_timerWheel_t *self, uint64_t startTick)
+{
+   if (self != 0)
+   {
+      int32_t level;
+      uint32_t slot;
+      for (level = 0; level < OS_TIMER_WHEEL_NUM_LEVELS; level++)
+      {
+         for (slot = 0; slot < OS_TIMER_WHEEL_NUM_SLOTS; slot++)
+         {
+            os_timerWheelNode_t *head = &self->slots[level][slot];
+            head->next = head;
+            head->prev = head;
+            head->slotIndex = -1;
+         }
+         self->occupied[level] = 0u;
+      }
+      self->currentTick = startTick;
+      self->numNodes = 0u;
+   }
+}
+
+/**
+ * Inserts node to expire at expireTick. A node that is already overdue expires on the next call to os_timerWheel_advance.
+ */
+void os_timerWheel_insert(os_timerWheel_t *self, os_timerWheelNode_t *node, uint64_t expireTick)
+{
+   if ( (self != 0) && (node != 0) )
+   {
+      node->expireTick = expireTick;
+      os_timerWheel_link(self, node);
+      self->numNodes++;
+   }
+}
+
+void os_timerWheel_remove(os_timerWheel_t *self, os_timerWheelNode_t *node)
+{
+   if ( (self != 0) && (node != 0) && (node->slotIndex >= 0) )
+   {
+      os_timerWheel_unlink(self, node);
+      self->numNodes--;
+   }
+}
+
+/**
+ * Returns the next tick where os_timerWheel_advance has work to do (a node expires or a higher level slot is moved down).
+ * This is never later than the earliest expireTick in the wheel, sleeping until then is always safe.
+ * Returns OS_TIMER_WHEEL_NO_TICK when the wheel is empty.
+ */
+uint64_t os_timerWheel_nextTick(const os_timerWheel_t *self)
+{
+   if (self != 0)
+   {
+      int32_t level;
+      for (level = 0; level < OS_TIMER_WHEEL_NUM_LEVELS; level++)
+      {
+         uint32_t shift = (uint32_t) level * OS_TIMER_WHEEL_SLOT_BITS;
+         uint32_t rotationShift = shift + OS_TIMER_WHEEL_SLOT_BITS;
+         uint32_t currentSlot = (uint32_t) (self->currentTick >> shift) & OS_TIMER_WHEEL_SLOT_MASK;
+         uint64_t rotationStart = (self->currentTick >> rotationShift) << rotationShift;
+         int32_t slot = os_timerWheel_findSlot(self->occupied[level], currentSlot);
+         if ( (slot < 0) && (level == TOP_LEVEL) )
+         {
+            //top level slots behind the current slot belong to the next rotation
+            slot = os_timerWheel_findSlot(self->occupied[level], 0u);
+            rotationStart += ((uint64_t) 1u) << rotationShift;
+         }
+         if (slot >= 0)
+         {
+            uint64_t tick = rotationStart + ( ((uint64_t) slot) << shift);
+            return (tick < self->currentTick)? self->currentTick : tick;
+         }
+      }
+   }
+   return OS_TIMER_WHEEL_NO_TICK;
+}
+
+/**
+ * Processes all ticks up to and including tick.
+ * Returns the expired nodes in order of expiry as a list linked through next (0 if none expired).
+ * The expired nodes are no longer part of the wheel and can be inserted again directly.
+ */
+os_timerWheelNode_t *os_timerWheel_advance(os_timerWheel_t *self, uint64_t tick)
+{
+   os_timerWheelNode_t *first = 0;
+   os_timerWheelNode_t *last = 0;
+   if (self != 0)
+   {
+      uint64_t nextTick;
+      while ( (nextTick = os_timerWheel_nextTick(self)) <= tick)
+      {
+         int32_t level;
+         os_timerWheelNode_t *head;
+         self->currentTick = nextTick;
+         for (level = TOP_LEVEL; level > 0; level--)
+         {
+            uint32_t shift = (uint32_t) level * OS_TIMER_WHEEL_SLOT_BITS;
+            if ( (nextTick & ( (((uint64_t) 1u) << shift) - 1u)) == 0u)
+            {
+               os_timerWheel_cascade(self, level, (uint32_t) (nextTick >> shift) & OS_TIMER_WHEEL_SLOT_MASK);
+            }
+         }
+         head = &self->slots[0][nextTick & OS_TIMER_WHEEL_SLOT_MASK];
+         while (head->next != head)
+         {
+            os_timerWheelNode_t *node = head->next;
+            os_timerWheel_unlink(self, node);
+            self->numNodes--;
+            node->next = 0;
+            if (last == 0)
+            {
+               first = node;
+            }
+            else
+            {
+               last->next = node;
+            }
+            last = node;
+         }
+         self->currentTick = nextTick + 1u;
+         if (nextTick == tick)
+         {
+            break;
+         }
+      }
+      if ( (tick != OS_TIMER_WHEEL_NO_TICK) && (tick >= self->currentTick) )
+      {
+         //nothing happens in between, skip ahead
+         self->currentTick = tick + 1u;
+      }
+   }
+   return first;
+}
+
+uint32_t os_timerWheel_length(const os_timerWheel_t *self)
+{
+   if (self != 0)
+   {
+      return self->numNodes;
+   }
+   return 0u;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void os_timerWheel_link(os_timerWheel_t *self, os_timerWheelNode_t *node)
+{
+   int32_t level;
+   uint32_t slot;
+   os_timerWheelNode_t *head;
+   uint64_t expireTick = node->expireTick;
+   uint64_t currentTick = self->currentTick;
+   if (expireTick < currentTick)
+   {
+      expireTick = currentTick;
+   }
+   //lowest level where expireTick is in the current rotation
+   for (level = 0; level < TOP_LEVEL; level++)
+   {
+      uint32_t rotationShift = ( (uint32_t) level + 1u) * OS_TIMER_WHEEL_SLOT_BITS;
+      if ( (expireTick >> rotationShift) == (currentTick >> rotationShift) )
+      {
+         break;
+      }
+   }
+   if (level < TOP_LEVEL)
+   {
+      slot = (uint32_t) (expireTick >> (level * OS_TIMER_WHEEL_SLOT_BITS)) & OS_TIMER_WHEEL_SLOT_MASK;
+   }
+   else
+   {
+      uint32_t shift = TOP_LEVEL * OS_TIMER_WHEEL_SLOT_BITS;
+      uint32_t rotationShift = shift + OS_TIMER_WHEEL_SLOT_BITS;
+      uint32_t currentSlot = (uint32_t) (currentTick >> shift) & OS_TIMER_WHEEL_SLOT_MASK;
+      slot = (uint32_t) (expireTick >> shift) & OS_TIMER_WHEEL_SLOT_MASK;
+      //the current slot stands for the current rotation only, the same slot of the next rotation is out of range as well
+      if ( ( ( (expireTick - currentTick) >> rotationShift) != 0u) ||
+           ( (slot == currentSlot) && ( (expireTick >> rotationShift) != (currentTick >> rotationShift) ) ) )
+      {
+         //out of range, park in the slot reached last and re-insert from there
+         slot = (currentSlot - 1u) & OS_TIMER_WHEEL_SLOT_MASK;
+      }
+   }
+   head = &self->slots[level][slot];
+   node->next = head;
+   node->prev = head->prev;
+   head->prev->next = node;
+   head->prev = node;
+   node->slotIndex = level * (int32_t) OS_TIMER_WHEEL_NUM_SLOTS + (int32_t) slot;
+   self->occupied[level] |= ((uint64_t) 1u) << slot;
+}
+
+static void os_timerWheel_unlink(os_timerWheel_t *self, os_timerWheelNode_t *node)
+{
+   int32_t level = node->slotIndex / (int32_t) OS_TIMER_WHEEL_NUM_SLOTS;
+   uint32_t slot = (uint32_t) node->slotIndex & OS_TIMER_WHEEL_SLOT_MASK;
+   os_timerWheelNode_t *head = &self->slots[level][slot];
+   node->prev->next = node->next;
+   node->next->prev = node->prev;
+   node->prev = 0;
+   node->slotIndex = -1;
+   if (head->next == head)
+   {
+      self->occupied[level] &= ~(((uint64_t) 1u) << slot);
+   }
+}
+
+static void os_timerWheel_cascade(os_timerWheel_t *self, int32_t level, uint32_t slot)
+{
+   os_timerWheelNode_t *head = &self->slots[level][slot];
+   os_timerWheelNode_t *first = head->next;
+   os_timerWheelNode_t *node;
+   if (first == head)
+   {
+      return;
+   }
+   //detach the whole list first, nodes may be linked back into this slot (parked nodes at the top level)
+   head->prev->next = 0;
+   head->next = head;
+   head->prev = head;
+   self->occupied[level] &= ~(((uint64_t) 1u) << slot);
+   node = first;
+   while (node != 0)
+   {
+      os_timerWheelNode_t *next = node->next;
+      os_timerWheel_link(self, node);
+      node = next;
+   }
+}
+
+/**
+ * returns index of first set bit at or above fromSlot, -1 if there is none
+ */
+static int32_t os_timerWheel_findSlot(uint64_t occupied, uint32_t fromSlot)
+{
+   uint64_t bits = occupied & (~((uint64_t) 0u) << fromSlot);
+   if (bits == 0u)
+   {
+      return -1;
+   }
+#if defined(__GNUC__) || defined(__clang__)
+   return (int32_t) __builtin_ctzll(bits);
+#else
+   {
+      int32_t i = 0;
+      while ( (bits & 1u) == 0u)
+      {
+         bits >>= 1;
+         i++;
+      }
+      return i;
+   }
+#endif
+}
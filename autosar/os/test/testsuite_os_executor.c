@@ -0,0 +1,183 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "os_executor.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_TEST_TASKS     8
+#define NUM_TEST_WORKERS   3
+#define NUM_TEST_EVENTS    2000
+
+typedef struct testTask_tag
+{
+   os_task_t task;
+   uint16_t lastEventId;
+   uint32_t numEvents;
+   uint32_t numOrderErrors;
+   uint32_t numShutdownEvents;
+}testTask_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_os_executor_create(CuTest* tc);
+static void test_os_executor_maxNumTasks(CuTest* tc);
+static void test_os_executor_removeTask(CuTest* tc);
+static void test_os_executor_eventOrder(CuTest* tc);
+static void testTask_handler(void *arg, uint16_t eventId);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_os_executor(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_os_executor_create);
+   SUITE_ADD_TEST(suite, test_os_executor_maxNumTasks);
+   SUITE_ADD_TEST(suite, test_os_executor_removeTask);
+   SUITE_ADD_TEST(suite, test_os_executor_eventOrder);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_os_executor_create(CuTest* tc)
+{
+   os_executor_t executor;
+   CuAssertIntEquals(tc, 1, os_executor_create(&executor, 0, 10));
+   CuAssertIntEquals(tc, 0, os_executor_create(&executor, 2, 10));
+   CuAssertPtrNotNull(tc, executor.workers);
+   CuAssertUIntEquals(tc, 2, executor.numWorkers);
+   CuAssertIntEquals(tc, 0, os_executor_setWorkerCpu(&executor, 1, 0));
+   CuAssertIntEquals(tc, 1, os_executor_setWorkerCpu(&executor, 2, 0));
+   os_executor_destroy(&executor);
+   CuAssertPtrEquals(tc, 0, executor.workers);
+}
+
+static void test_os_executor_maxNumTasks(CuTest* tc)
+{
+   os_executor_t executor;
+   testTask_t task1;
+   testTask_t task2;
+   CuAssertIntEquals(tc, 0, os_executor_create(&executor, 1, 1));
+   CuAssertIntEquals(tc, 0, os_task_createPooled(&task1.task, &executor, testTask_handler, &task1, 10));
+   CuAssertPtrEquals(tc, 0, task1.task.thread_func);
+   CuAssertIntEquals(tc, 1, os_task_createPooled(&task2.task, &executor, testTask_handler, &task2, 10));
+   os_task_destroy(&task1.task);
+   CuAssertUIntEquals(tc, 0, executor.numTasks);
+   CuAssertIntEquals(tc, 0, os_task_createPooled(&task2.task, &executor, testTask_handler, &task2, 10));
+   os_task_destroy(&task2.task);
+   os_executor_destroy(&executor);
+}
+
+static void test_os_executor_removeTask(CuTest* tc)
+{
+   os_executor_t executor;
+   testTask_t task1;
+   testTask_t task2;
+   os_executorQueue_t *queue;
+   CuAssertIntEquals(tc, 0, os_executor_create(&executor, 1, 2));
+   CuAssertIntEquals(tc, 0, os_task_createPooled(&task1.task, &executor, testTask_handler, &task1, 10));
+   CuAssertIntEquals(tc, 0, os_task_createPooled(&task2.task, &executor, testTask_handler, &task2, 10));
+   os_task_start(&task1.task);
+   os_task_start(&task2.task);
+   //the workers are not started, both tasks stay in the run queue
+   os_task_setEvent(&task1.task, OS_USER_EVENT_ID);
+   os_task_setEvent(&task2.task, OS_USER_EVENT_ID);
+   queue = &executor.workers[0].sharedQueue[0];
+   CuAssertUIntEquals(tc, 2, queue->length);
+   os_task_destroy(&task1.task);
+   CuAssertUIntEquals(tc, 1, executor.numTasks);
+   CuAssertUIntEquals(tc, 1, queue->length);
+   CuAssertPtrEquals(tc, &task2.task, queue->tasks[queue->head]);
+   os_task_destroy(&task2.task);
+   CuAssertUIntEquals(tc, 0, queue->length);
+   os_executor_destroy(&executor);
+}
+
+static void test_os_executor_eventOrder(CuTest* tc)
+{
+   os_executor_t executor;
+   testTask_t tasks[NUM_TEST_TASKS];
+   int32_t i;
+   uint16_t eventId;
+   CuAssertIntEquals(tc, 0, os_executor_create(&executor, NUM_TEST_WORKERS, NUM_TEST_TASKS));
+   for (i = 0; i < NUM_TEST_TASKS; i++)
+   {
+      memset(&tasks[i], 0, sizeof(testTask_t));
+      CuAssertIntEquals(tc, 0, os_task_createPooled(&tasks[i].task, &executor, testTask_handler, &tasks[i], NUM_TEST_EVENTS));
+      os_task_setPriority(&tasks[i].task, (uint8_t) i);
+      if (i == 0)
+      {
+         os_task_setWorker(&tasks[i].task, 1);
+      }
+      os_task_start(&tasks[i].task);
+   }
+   CuAssertIntEquals(tc, 0, os_executor_start(&executor));
+   for (eventId = OS_USER_EVENT_ID; eventId <= NUM_TEST_EVENTS; eventId++)
+   {
+      for (i = 0; i < NUM_TEST_TASKS; i++)
+      {
+         os_task_setEvent(&tasks[i].task, eventId);
+      }
+   }
+   for (i = 0; i < NUM_TEST_TASKS; i++)
+   {
+      os_task_stop(&tasks[i].task);
+   }
+   os_executor_stop(&executor);
+   for (i = 0; i < NUM_TEST_TASKS; i++)
+   {
+      CuAssertUIntEquals(tc, NUM_TEST_EVENTS, tasks[i].numEvents);
+      CuAssertUIntEquals(tc, 0, tasks[i].numOrderErrors);
+      CuAssertUIntEquals(tc, 1, tasks[i].numShutdownEvents);
+      CuAssertUIntEquals(tc, NUM_TEST_EVENTS, tasks[i].lastEventId);
+      os_task_destroy(&tasks[i].task);
+   }
+   os_executor_destroy(&executor);
+}
+
+static void testTask_handler(void *arg, uint16_t eventId)
+{
+   testTask_t *testTask = (testTask_t*) arg;
+   if (eventId == OS_SHUTDOWN_EVENT_ID)
+   {
+      testTask->numShutdownEvents++;
+   }
+   else
+   {
+      if (eventId != (uint16_t) (testTask->lastEventId + 1u))
+      {
+         testTask->numOrderErrors++;
+      }
+      testTask->lastEventId = eventId;
+      testTask->numEvents++;
+   }
+}
@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "os_stat.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_OUTPUT_LEN 4096
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_os_stat_record(CuTest* tc);
+static void test_os_stat_percentile(CuTest* tc);
+static void test_os_stat_invalidEventId(CuTest* tc);
+static void test_os_stat_dump(CuTest* tc);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_os_stat(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_os_stat_record);
+   SUITE_ADD_TEST(suite, test_os_stat_percentile);
+   SUITE_ADD_TEST(suite, test_os_stat_invalidEventId);
+   SUITE_ADD_TEST(suite, test_os_stat_dump);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_os_stat_record(CuTest* tc)
+{
+   os_stat_snapshot_t snapshot;
+   os_stat_reset();
+   CuAssertIntEquals(tc, 0, os_stat_getSnapshot(1, &snapshot));
+   CuAssertUIntEquals(tc, 0, snapshot.hist[OS_STAT_FIRE_LATENCY].count);
+   CuAssertTrue(tc, os_stat_histogram_min(&snapshot.hist[OS_STAT_FIRE_LATENCY]) == 0u);
+   os_stat_record(1, OS_STAT_FIRE_LATENCY, 0u);
+   os_stat_record(1, OS_STAT_FIRE_LATENCY, 3000u);
+   os_stat_record(1, OS_STAT_FIRE_LATENCY, 6000u);
+   os_stat_record(1, OS_STAT_RUN_TIME, 100u);
+   CuAssertIntEquals(tc, 0, os_stat_getSnapshot(1, &snapshot));
+   CuAssertUIntEquals(tc, 1, snapshot.eventId);
+   CuAssertUIntEquals(tc, 3, snapshot.hist[OS_STAT_FIRE_LATENCY].count);
+   CuAssertUIntEquals(tc, 1, snapshot.hist[OS_STAT_FIRE_LATENCY].buckets[0]);
+   CuAssertUIntEquals(tc, 1, snapshot.hist[OS_STAT_FIRE_LATENCY].buckets[12]); //[2048, 4096)
+   CuAssertUIntEquals(tc, 1, snapshot.hist[OS_STAT_FIRE_LATENCY].buckets[13]); //[4096, 8192)
+   CuAssertTrue(tc, os_stat_histogram_min(&snapshot.hist[OS_STAT_FIRE_LATENCY]) == 0u);
+   CuAssertTrue(tc, os_stat_histogram_mean(&snapshot.hist[OS_STAT_FIRE_LATENCY]) == 3000u);
+   CuAssertTrue(tc, snapshot.hist[OS_STAT_FIRE_LATENCY].maxNs == 6000u);
+   CuAssertUIntEquals(tc, 0, snapshot.hist[OS_STAT_QUEUE_WAIT].count);
+   CuAssertUIntEquals(tc, 1, snapshot.hist[OS_STAT_RUN_TIME].count);
+   CuAssertTrue(tc, os_stat_histogram_min(&snapshot.hist[OS_STAT_RUN_TIME]) == 100u);
+   os_stat_reset();
+   CuAssertIntEquals(tc, 0, os_stat_getSnapshot(1, &snapshot));
+   CuAssertUIntEquals(tc, 0, snapshot.hist[OS_STAT_FIRE_LATENCY].count);
+   CuAssertTrue(tc, snapshot.hist[OS_STAT_FIRE_LATENCY].maxNs == 0u);
+}
+
+static void test_os_stat_percentile(CuTest* tc)
+{
+   os_stat_snapshot_t snapshot;
+   int32_t i;
+   os_stat_reset();
+   for (i = 0; i < 99; i++)
+   {
+      os_stat_record(2, OS_STAT_QUEUE_WAIT, 1000u); //bucket [512, 1024)
+   }
+   os_stat_record(2, OS_STAT_QUEUE_WAIT, 1000000u);
+   os_stat_getSnapshot(2, &snapshot);
+   CuAssertTrue(tc, os_stat_histogram_percentile(&snapshot.hist[OS_STAT_QUEUE_WAIT], 500u) == 1023u);
+   CuAssertTrue(tc, os_stat_histogram_percentile(&snapshot.hist[OS_STAT_QUEUE_WAIT], 990u) == 1023u);
+   CuAssertTrue(tc, os_stat_histogram_percentile(&snapshot.hist[OS_STAT_QUEUE_WAIT], 1000u) == 1000000u);
+   //values beyond the last bucket
+   os_stat_record(3, OS_STAT_QUEUE_WAIT, 10000000000ull);
+   os_stat_getSnapshot(3, &snapshot);
+   CuAssertUIntEquals(tc, 1, snapshot.hist[OS_STAT_QUEUE_WAIT].buckets[OS_STAT_NUM_BUCKETS-1]);
+   CuAssertTrue(tc, os_stat_histogram_percentile(&snapshot.hist[OS_STAT_QUEUE_WAIT], 500u) == 10000000000ull);
+}
+
+static void test_os_stat_invalidEventId(CuTest* tc)
+{
+   os_stat_snapshot_t snapshot;
+   os_stat_reset();
+   os_stat_record(OS_STAT_MAX_NUM_EVENTS, OS_STAT_FIRE_LATENCY, 1000u);
+   CuAssertIntEquals(tc, -1, os_stat_getSnapshot(OS_STAT_MAX_NUM_EVENTS, &snapshot));
+   CuAssertIntEquals(tc, -1, os_stat_getSnapshot(0, 0));
+}
+
+static void test_os_stat_dump(CuTest* tc)
+{
+   FILE *fp;
+   char output[MAX_OUTPUT_LEN];
+   size_t len;
+   os_stat_reset();
+   os_stat_record(4, OS_STAT_FIRE_LATENCY, 2000u);
+   os_stat_record(4, OS_STAT_FIRE_LATENCY, 4000u);
+   fp = tmpfile();
+   CuAssertPtrNotNull(tc, fp);
+   os_stat_dump(fp);
+   rewind(fp);
+   len = fread(output, 1, MAX_OUTPUT_LEN-1, fp);
+   output[len] = '\0';
+   fclose(fp);
+   CuAssertPtrNotNull(tc, strstr(output, "[OS_STAT] event kind"));
+   CuAssertPtrNotNull(tc, strstr(output, "[OS_STAT]     4 fire latency          2          2          3          2          4          4\n"));
+   CuAssertPtrEquals(tc, 0, strstr(output, "queue wait"));
+}
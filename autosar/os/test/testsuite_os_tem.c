@@ -104,9 +104,7 @@ THREAD_PROTO(Test_Task, arg)
 #endif
       {
          uint16_t eventType;
-         SPINLOCK_ENTER(self->lock);
-         rbfu16_remove(&self->eventQueue, &eventType);
-         SPINLOCK_LEAVE(self->lock);
+         rbf32_remove(&self->eventQueue, (uint8_t*) &eventType);
          switch (eventType)
          {
          case Os_Event_Shutdown_Task:
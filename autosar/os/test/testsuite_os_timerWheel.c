@@ -0,0 +1,273 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "os_timerWheel.h"
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define NUM_RANDOM_NODES 200
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void test_os_timerWheel_expire(CuTest* tc);
+static void test_os_timerWheel_nextTick(CuTest* tc);
+static void test_os_timerWheel_remove(CuTest* tc);
+static void test_os_timerWheel_longDelay(CuTest* tc);
+static void test_os_timerWheel_periodic(CuTest* tc);
+static void test_os_timerWheel_almostOneRotation(CuTest* tc);
+static void test_os_timerWheel_random(CuTest* tc);
+static int32_t countList(os_timerWheelNode_t *node);
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_os_timerWheel(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, test_os_timerWheel_expire);
+   SUITE_ADD_TEST(suite, test_os_timerWheel_nextTick);
+   SUITE_ADD_TEST(suite, test_os_timerWheel_remove);
+   SUITE_ADD_TEST(suite, test_os_timerWheel_longDelay);
+   SUITE_ADD_TEST(suite, test_os_timerWheel_periodic);
+   SUITE_ADD_TEST(suite, test_os_timerWheel_almostOneRotation);
+   SUITE_ADD_TEST(suite, test_os_timerWheel_random);
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+static void test_os_timerWheel_expire(CuTest* tc)
+{
+   os_timerWheel_t wheel;
+   os_timerWheelNode_t node1;
+   os_timerWheelNode_t node2;
+   os_timerWheelNode_t node3;
+   os_timerWheelNode_t *expired;
+   os_timerWheel_create(&wheel, 0);
+   os_timerWheel_insert(&wheel, &node1, 10);
+   os_timerWheel_insert(&wheel, &node2, 5);
+   os_timerWheel_insert(&wheel, &node3, 100);
+   CuAssertUIntEquals(tc, 3, os_timerWheel_length(&wheel));
+   CuAssertPtrEquals(tc, 0, os_timerWheel_advance(&wheel, 4));
+   expired = os_timerWheel_advance(&wheel, 10);
+   CuAssertPtrEquals(tc, &node2, expired);
+   CuAssertPtrEquals(tc, &node1, expired->next);
+   CuAssertPtrEquals(tc, 0, node1.next);
+   CuAssertUIntEquals(tc, 1, os_timerWheel_length(&wheel));
+   CuAssertPtrEquals(tc, 0, os_timerWheel_advance(&wheel, 99));
+   CuAssertPtrEquals(tc, &node3, os_timerWheel_advance(&wheel, 100));
+   CuAssertUIntEquals(tc, 0, os_timerWheel_length(&wheel));
+   //overdue nodes expire on next advance
+   os_timerWheel_insert(&wheel, &node1, 50);
+   CuAssertPtrEquals(tc, &node1, os_timerWheel_advance(&wheel, 101));
+}
+
+static void test_os_timerWheel_nextTick(CuTest* tc)
+{
+   os_timerWheel_t wheel;
+   os_timerWheelNode_t node1;
+   os_timerWheelNode_t node2;
+   os_timerWheel_create(&wheel, 1000);
+   CuAssertTrue(tc, os_timerWheel_nextTick(&wheel) == OS_TIMER_WHEEL_NO_TICK);
+   os_timerWheel_insert(&wheel, &node1, 1010);
+   CuAssertTrue(tc, os_timerWheel_nextTick(&wheel) == 1010);
+   //far away nodes are moved down a level at a slot boundary before they expire
+   os_timerWheel_create(&wheel, 0);
+   os_timerWheel_insert(&wheel, &node2, 5000);
+   CuAssertTrue(tc, os_timerWheel_nextTick(&wheel) == 4096);
+   CuAssertPtrEquals(tc, 0, os_timerWheel_advance(&wheel, 4096));
+   CuAssertTrue(tc, os_timerWheel_nextTick(&wheel) == 4992);
+   CuAssertPtrEquals(tc, 0, os_timerWheel_advance(&wheel, 4992));
+   CuAssertTrue(tc, os_timerWheel_nextTick(&wheel) == 5000);
+   CuAssertPtrEquals(tc, &node2, os_timerWheel_advance(&wheel, 6000));
+}
+
+static void test_os_timerWheel_remove(CuTest* tc)
+{
+   os_timerWheel_t wheel;
+   os_timerWheelNode_t node1;
+   os_timerWheelNode_t node2;
+   os_timerWheel_create(&wheel, 0);
+   os_timerWheel_insert(&wheel, &node1, 300);
+   os_timerWheel_insert(&wheel, &node2, 310);
+   os_timerWheel_remove(&wheel, &node1);
+   CuAssertIntEquals(tc, -1, node1.slotIndex);
+   CuAssertUIntEquals(tc, 1, os_timerWheel_length(&wheel));
+   os_timerWheel_remove(&wheel, &node1);
+   CuAssertUIntEquals(tc, 1, os_timerWheel_length(&wheel));
+   CuAssertTrue(tc, os_timerWheel_nextTick(&wheel) == 256);
+   os_timerWheel_remove(&wheel, &node2);
+   CuAssertTrue(tc, os_timerWheel_nextTick(&wheel) == OS_TIMER_WHEEL_NO_TICK);
+   CuAssertPtrEquals(tc, 0, os_timerWheel_advance(&wheel, 1000));
+}
+
+static void test_os_timerWheel_longDelay(CuTest* tc)
+{
+   os_timerWheel_t wheel;
+   os_timerWheelNode_t node;
+   uint64_t startTick = ((uint64_t) 1u) << 35; //beyond 32-bit milliseconds
+   uint64_t expireTick = startTick + 100000000u; //~28 hours at 1ms ticks, out of range of the top level
+   uint64_t tick;
+   int32_t numWakeups = 0;
+   os_timerWheel_create(&wheel, startTick);
+   os_timerWheel_insert(&wheel, &node, expireTick);
+   for (;;)
+   {
+      os_timerWheelNode_t *expired;
+      tick = os_timerWheel_nextTick(&wheel);
+      CuAssertTrue(tc, tick <= expireTick);
+      expired = os_timerWheel_advance(&wheel, tick);
+      numWakeups++;
+      if (expired != 0)
+      {
+         CuAssertPtrEquals(tc, &node, expired);
+         break;
+      }
+   }
+   CuAssertTrue(tc, tick == expireTick);
+   CuAssertTrue(tc, numWakeups < 20);
+}
+
+static void test_os_timerWheel_periodic(CuTest* tc)
+{
+   os_timerWheel_t wheel;
+   os_timerWheelNode_t node;
+   uint64_t expected = 7;
+   int32_t count = 0;
+   os_timerWheel_create(&wheel, 0);
+   os_timerWheel_insert(&wheel, &node, expected);
+   while (count < 1000)
+   {
+      uint64_t tick = os_timerWheel_nextTick(&wheel);
+      os_timerWheelNode_t *expired = os_timerWheel_advance(&wheel, tick);
+      if (expired != 0)
+      {
+         CuAssertTrue(tc, tick == expected);
+         CuAssertTrue(tc, expired->expireTick == expected);
+         expected += 333;
+         os_timerWheel_insert(&wheel, expired, expected);
+         count++;
+      }
+   }
+}
+
+/**
+ * periods between 2^24-2^18 and 2^24 ticks often expire in the current top level slot of the next rotation
+ */
+static void test_os_timerWheel_almostOneRotation(CuTest* tc)
+{
+   os_timerWheel_t wheel;
+   os_timerWheelNode_t node;
+   uint64_t period = (((uint64_t) 1u) << 24) - (((uint64_t) 1u) << 17) + 5u;
+   uint64_t expected = 1000u + period;
+   int32_t count = 0;
+   int32_t numWakeups = 0;
+   os_timerWheel_create(&wheel, 1000u);
+   os_timerWheel_insert(&wheel, &node, expected);
+   while ( (count < 100) && (numWakeups < 2000) )
+   {
+      uint64_t tick = os_timerWheel_nextTick(&wheel);
+      os_timerWheelNode_t *expired;
+      CuAssertTrue(tc, tick <= expected);
+      expired = os_timerWheel_advance(&wheel, tick);
+      numWakeups++;
+      if (expired != 0)
+      {
+         CuAssertTrue(tc, tick == expected);
+         CuAssertPtrEquals(tc, &node, expired);
+         expected += period;
+         os_timerWheel_insert(&wheel, expired, expected);
+         count++;
+      }
+   }
+   CuAssertIntEquals(tc, 100, count);
+}
+
+static void test_os_timerWheel_random(CuTest* tc)
+{
+   os_timerWheel_t wheel;
+   os_timerWheelNode_t nodes[NUM_RANDOM_NODES];
+   int32_t i;
+   int32_t numExpired = 0;
+   uint64_t now = 12345;
+   srand(1);
+   os_timerWheel_create(&wheel, now);
+   for (i = 0; i < NUM_RANDOM_NODES; i++)
+   {
+      uint64_t delay = (uint64_t) (rand() % 100000);
+      if ( (i % 10) == 0)
+      {
+         delay *= 1000u;
+      }
+      os_timerWheel_insert(&wheel, &nodes[i], now + delay);
+   }
+   while (os_timerWheel_length(&wheel) > 0)
+   {
+      os_timerWheelNode_t *expired;
+      uint64_t step = (uint64_t) (rand() % 5000) + 1u;
+      uint64_t nextTick = os_timerWheel_nextTick(&wheel);
+      if ( (step < 4000) && (nextTick > now) )
+      {
+         now = nextTick; //tickless wakeup
+      }
+      else
+      {
+         now += step; //late wakeup
+      }
+      expired = os_timerWheel_advance(&wheel, now);
+      numExpired += countList(expired);
+      while (expired != 0)
+      {
+         CuAssertTrue(tc, expired->expireTick <= now);
+         expired = expired->next;
+      }
+      nextTick = os_timerWheel_nextTick(&wheel);
+      for (i = 0; i < NUM_RANDOM_NODES; i++)
+      {
+         if (nodes[i].slotIndex >= 0)
+         {
+            CuAssertTrue(tc, nodes[i].expireTick > now);
+            CuAssertTrue(tc, nodes[i].expireTick >= nextTick);
+         }
+      }
+   }
+   CuAssertIntEquals(tc, NUM_RANDOM_NODES, numExpired);
+}
+
+static int32_t countList(os_timerWheelNode_t *node)
+{
+   int32_t count = 0;
+   while (node != 0)
+   {
+      count++;
+      node = node->next;
+   }
+   return count;
+}
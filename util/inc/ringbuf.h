@@ -81,6 +81,25 @@ typedef struct rbfu16_t   //ring buffer (fixed block size) -
 } rbfu16_t;
 #endif
 
+//RBF32: Ringbuffers with power of two number of elements of equal size
+//Read and write indices are free-running, the element position is the index masked with u32Mask.
+//With RBF32_ATOMIC_ENABLE one producer thread may call insert/insertN/writeSpan/commit while one consumer thread calls
+//remove/removeN/peek/peekSpan/consume without any locking. Multiple producers must use rbf32_mpsc_insert.
+//Without RBF32_ATOMIC_ENABLE the indices are plain volatile variables: producers must be serialized by the caller and
+//the consumer must synchronize with them (e.g. through the semaphore that announces new elements).
+#if(RBF32_ENABLE)
+typedef struct rbf32_tag
+{
+   uint8_t* u8Buffer;
+   uint32_t u32Mask; //number of elements - 1
+   uint32_t u32ElemSize;
+   volatile uint32_t u32WriteIdx; //elements before this index are visible to the consumer
+   volatile uint32_t u32ReadIdx;
+   volatile uint32_t u32ReserveIdx; //next slot claimed by rbf32_mpsc_insert
+   uint32_t u32PeakNumElem; // = 0 unless RBF32_PEAK_ENABLE
+} rbf32_t;
+#endif
+
 /***************** Public Function Declarations *******************/
 #if(RBFS_ENABLE)
 void rbfs_create(rbfs_t* rbf, uint8_t* u8Buffer, uint16_t u32NumElem, uint8_t u8ElemSize);
@@ -115,5 +134,35 @@ uint8_t rbfu16_peek(rbfu16_t* rbf, uint16_t* u16Data);
 uint16_t rbfu16_length(rbfu16_t* rbf);
 #endif
 
+#if(RBF32_ENABLE)
+// returns E_BUF_OK or E_BUF_NOT_OK when u32NumElem is not a power of two
+uint8_t rbf32_create(rbf32_t* rbf, uint8_t* u8Buffer, uint32_t u32NumElem, uint32_t u32ElemSize);
+// returns smallest power of two >= u32MinNumElem
+uint32_t rbf32_calcNumElem(uint32_t u32MinNumElem);
+// returns E_BUF_OK or E_BUF_OVERFLOW
+uint8_t rbf32_insert(rbf32_t* rbf, const uint8_t* u8Data);
+// returns E_BUF_OK or E_BUF_UNDERFLOW
+uint8_t rbf32_remove(rbf32_t* rbf, uint8_t* u8Data);
+uint8_t rbf32_peek(const rbf32_t* rbf, uint8_t* u8Data);
+// bulk operations, returns number of elements actually inserted/removed
+uint32_t rbf32_insertN(rbf32_t* rbf, const uint8_t* u8Data, uint32_t u32NumElem);
+uint32_t rbf32_removeN(rbf32_t* rbf, uint8_t* u8Data, uint32_t u32MaxNumElem);
+// zero-copy access, returns number of contiguous elements available at *u8Span
+uint32_t rbf32_peekSpan(const rbf32_t* rbf, uint8_t** u8Span);
+void rbf32_consume(rbf32_t* rbf, uint32_t u32NumElem);
+uint32_t rbf32_writeSpan(const rbf32_t* rbf, uint8_t** u8Span);
+void rbf32_commit(rbf32_t* rbf, uint32_t u32NumElem);
+uint32_t rbf32_size(const rbf32_t* rbf);
+uint32_t rbf32_free(const rbf32_t* rbf);
+uint32_t rbf32_capacity(const rbf32_t* rbf);
+// must not be called while other threads access rbf
+void rbf32_clear(rbf32_t* rbf);
+#if(RBF32_ATOMIC_ENABLE)
+// multiple producer insert, returns E_BUF_OK or E_BUF_OVERFLOW.
+// Not lock-free: a producer waits until all producers that claimed earlier slots have published theirs.
+uint8_t rbf32_mpsc_insert(rbf32_t* rbf, const uint8_t* u8Data);
+#endif
+#endif
+
 #endif
 
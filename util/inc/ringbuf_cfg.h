@@ -29,5 +29,18 @@
 #define RBFS_ENABLE 1    //ringbuffer static (fixed sized blocks)
 #define RBFD_ENABLE 0    //ringbuffer dynamic (dynamically sized blocks)
 #define RBFU16_ENABLE 1  //special ringbuffer for uint16 values
+#define RBF32_ENABLE 1   //ringbuffer with 32-bit capacity (power of two number of elements) and bulk operations
+//rbf32 index access with acquire/release atomics (GCC builtins or Interlocked functions) and rbf32_mpsc_insert.
+//Enabled by default on hosted targets only, bare-metal builds get plain volatile indices.
+#ifndef RBF32_ATOMIC_ENABLE
+#if defined(_MSC_VER) || defined(__linux__) || defined(__APPLE__) || defined(__CYGWIN__) || defined(__MINGW32__)
+#define RBF32_ATOMIC_ENABLE 1
+#else
+#define RBF32_ATOMIC_ENABLE 0
+#endif
+#endif
+#ifndef RBF32_PEAK_ENABLE
+#define RBF32_PEAK_ENABLE 0 //track u32PeakNumElem in rbf32_insertN
+#endif
 
 #endif //RINGBUF_CFG_H__
@@ -29,9 +29,31 @@
 #endif
 
 #include "ringbuf.h"
+#if(RBF32_ENABLE)
+#include <string.h>
+#if(RBF32_ATOMIC_ENABLE)
+#ifdef _MSC_VER
+#include <Windows.h>
+#define RBF32_LOAD_ACQUIRE(x) ((uint32_t) InterlockedOr((volatile LONG*) &(x), 0))
+#define RBF32_STORE_RELEASE(x, v) InterlockedExchange((volatile LONG*) &(x), (LONG) (v))
+#define RBF32_CAS(x, expected, desired) (InterlockedCompareExchange((volatile LONG*) &(x), (LONG) (desired), (LONG) (expected)) == (LONG) (expected))
+#else
+#define RBF32_LOAD_ACQUIRE(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define RBF32_STORE_RELEASE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define RBF32_CAS(x, expected, desired) __sync_bool_compare_and_swap(&(x), (expected), (desired))
+#endif
+#else
+#define RBF32_LOAD_ACQUIRE(x) (x)
+#define RBF32_STORE_RELEASE(x, v) ((x) = (v))
+#endif
+#endif
 
 
 /**************** Private Function Declarations *******************/
+#if(RBF32_ENABLE)
+static void rbf32_copyIn(rbf32_t* rbf, uint32_t u32WriteIdx, const uint8_t* u8Data, uint32_t u32NumElem);
+static void rbf32_copyOut(const rbf32_t* rbf, uint32_t u32ReadIdx, uint8_t* u8Data, uint32_t u32NumElem);
+#endif
 
 
 /**************** Private Variable Declarations *******************/
@@ -115,33 +137,32 @@ uint8_t rbfs_remove(rbfs_t* u8Rbf, uint8_t* u8Data)
 
 uint8_t rbfs_exists(const rbfs_t* u8Rbf, const uint8_t* u8Data)
 {
-   uint8_t found = E_BUF_UNDERFLOW;
    uint8_t u8j;
    uint16_t u16i;
-   uint8_t* u8ReadPtr = u8Rbf->u8ReadPtr;
-   uint8_t* u8EndPtr = u8Rbf->u8Buffer + (u8Rbf->u16MaxNumElem * u8Rbf->u8ElemSize);
+   const uint8_t* u8ReadPtr = u8Rbf->u8ReadPtr;
+   const uint8_t* u8EndPtr = u8Rbf->u8Buffer + (u8Rbf->u16MaxNumElem * u8Rbf->u8ElemSize);
 
    for (u16i = 0; u16i < u8Rbf->u16NumElem; ++u16i)
    {
-      found = E_BUF_OK;
+      uint8_t found = E_BUF_OK;
       for (u8j = 0; u8j < u8Rbf->u8ElemSize; ++u8j)
       {
-         if (*(u8Data++) != *(u8ReadPtr++))
+         if (u8Data[u8j] != *(u8ReadPtr++))
          {
             found = E_BUF_UNDERFLOW;
          }
+         if (u8ReadPtr >= u8EndPtr)
+         {
+            //rewind
+            u8ReadPtr = u8Rbf->u8Buffer;
+         }
       }
       if (found == E_BUF_OK)
       {
-         break;
-      }
-      if (u8ReadPtr >= u8EndPtr)
-      {
-         //rewind
-         u8ReadPtr = u8Rbf->u8Buffer;
+         return E_BUF_OK;
       }
    }
-   return found;
+   return E_BUF_UNDERFLOW;
 }
 
 uint16_t rbfs_size(const rbfs_t* u8Rbf)
@@ -375,3 +396,209 @@ uint16_t rbfu16_length(rbfu16_t* rbf){
    return 0;
 }
 #endif
+
+#if(RBF32_ENABLE)
+uint8_t rbf32_create(rbf32_t* rbf, uint8_t* u8Buffer, uint32_t u32NumElem, uint32_t u32ElemSize)
+{
+   if ( (rbf == 0) || (u8Buffer == 0) || (u32NumElem == 0) || ( (u32NumElem & (u32NumElem - 1)) != 0) ||
+        (u32NumElem > 0x80000000u) || (u32ElemSize == 0) )
+   {
+      return E_BUF_NOT_OK;
+   }
+   rbf->u8Buffer = u8Buffer;
+   rbf->u32Mask = u32NumElem - 1;
+   rbf->u32ElemSize = u32ElemSize;
+   rbf->u32WriteIdx = 0;
+   rbf->u32ReadIdx = 0;
+   rbf->u32ReserveIdx = 0;
+   rbf->u32PeakNumElem = 0;
+   return E_BUF_OK;
+}
+
+uint32_t rbf32_calcNumElem(uint32_t u32MinNumElem)
+{
+   uint32_t u32NumElem = 1;
+   while ( (u32NumElem < u32MinNumElem) && (u32NumElem < 0x80000000u) )
+   {
+      u32NumElem <<= 1;
+   }
+   return u32NumElem;
+}
+
+uint8_t rbf32_insert(rbf32_t* rbf, const uint8_t* u8Data)
+{
+   return (rbf32_insertN(rbf, u8Data, 1) == 1)? E_BUF_OK : E_BUF_OVERFLOW;
+}
+
+uint8_t rbf32_remove(rbf32_t* rbf, uint8_t* u8Data)
+{
+   return (rbf32_removeN(rbf, u8Data, 1) == 1)? E_BUF_OK : E_BUF_UNDERFLOW;
+}
+
+uint8_t rbf32_peek(const rbf32_t* rbf, uint8_t* u8Data)
+{
+   uint32_t u32ReadIdx = rbf->u32ReadIdx;
+   if (RBF32_LOAD_ACQUIRE(rbf->u32WriteIdx) == u32ReadIdx)
+   {
+      return E_BUF_UNDERFLOW;
+   }
+   rbf32_copyOut(rbf, u32ReadIdx, u8Data, 1);
+   return E_BUF_OK;
+}
+
+uint32_t rbf32_insertN(rbf32_t* rbf, const uint8_t* u8Data, uint32_t u32NumElem)
+{
+   uint32_t u32WriteIdx = rbf->u32WriteIdx;
+   uint32_t u32Free = (rbf->u32Mask + 1) - (u32WriteIdx - RBF32_LOAD_ACQUIRE(rbf->u32ReadIdx));
+   if (u32NumElem > u32Free)
+   {
+      u32NumElem = u32Free;
+   }
+   if (u32NumElem > 0)
+   {
+      rbf32_copyIn(rbf, u32WriteIdx, u8Data, u32NumElem);
+      RBF32_STORE_RELEASE(rbf->u32WriteIdx, u32WriteIdx + u32NumElem);
+#if(RBF32_PEAK_ENABLE)
+      if ( (u32WriteIdx + u32NumElem - rbf->u32ReadIdx) > rbf->u32PeakNumElem)
+      {
+         rbf->u32PeakNumElem = u32WriteIdx + u32NumElem - rbf->u32ReadIdx;
+      }
+#endif
+   }
+   return u32NumElem;
+}
+
+uint32_t rbf32_removeN(rbf32_t* rbf, uint8_t* u8Data, uint32_t u32MaxNumElem)
+{
+   uint32_t u32ReadIdx = rbf->u32ReadIdx;
+   uint32_t u32Size = RBF32_LOAD_ACQUIRE(rbf->u32WriteIdx) - u32ReadIdx;
+   if (u32MaxNumElem > u32Size)
+   {
+      u32MaxNumElem = u32Size;
+   }
+   if (u32MaxNumElem > 0)
+   {
+      rbf32_copyOut(rbf, u32ReadIdx, u8Data, u32MaxNumElem);
+      RBF32_STORE_RELEASE(rbf->u32ReadIdx, u32ReadIdx + u32MaxNumElem);
+   }
+   return u32MaxNumElem;
+}
+
+/**
+ * Sets *u8Span to the oldest element and returns how many elements can be read from there without wrapping.
+ * Call rbf32_consume when done with them.
+ */
+uint32_t rbf32_peekSpan(const rbf32_t* rbf, uint8_t** u8Span)
+{
+   uint32_t u32ReadIdx = rbf->u32ReadIdx;
+   uint32_t u32Size = RBF32_LOAD_ACQUIRE(rbf->u32WriteIdx) - u32ReadIdx;
+   uint32_t u32Pos = u32ReadIdx & rbf->u32Mask;
+   uint32_t u32ToEnd = (rbf->u32Mask + 1) - u32Pos;
+   *u8Span = &rbf->u8Buffer[u32Pos * rbf->u32ElemSize];
+   return (u32Size < u32ToEnd)? u32Size : u32ToEnd;
+}
+
+void rbf32_consume(rbf32_t* rbf, uint32_t u32NumElem)
+{
+   RBF32_STORE_RELEASE(rbf->u32ReadIdx, rbf->u32ReadIdx + u32NumElem);
+}
+
+/**
+ * Sets *u8Span to the next free element and returns how many elements can be written from there without wrapping.
+ * Call rbf32_commit to make written elements visible to the consumer.
+ */
+uint32_t rbf32_writeSpan(const rbf32_t* rbf, uint8_t** u8Span)
+{
+   uint32_t u32WriteIdx = rbf->u32WriteIdx;
+   uint32_t u32Free = (rbf->u32Mask + 1) - (u32WriteIdx - RBF32_LOAD_ACQUIRE(rbf->u32ReadIdx));
+   uint32_t u32Pos = u32WriteIdx & rbf->u32Mask;
+   uint32_t u32ToEnd = (rbf->u32Mask + 1) - u32Pos;
+   *u8Span = &rbf->u8Buffer[u32Pos * rbf->u32ElemSize];
+   return (u32Free < u32ToEnd)? u32Free : u32ToEnd;
+}
+
+void rbf32_commit(rbf32_t* rbf, uint32_t u32NumElem)
+{
+   RBF32_STORE_RELEASE(rbf->u32WriteIdx, rbf->u32WriteIdx + u32NumElem);
+}
+
+uint32_t rbf32_size(const rbf32_t* rbf)
+{
+   return RBF32_LOAD_ACQUIRE(rbf->u32WriteIdx) - RBF32_LOAD_ACQUIRE(rbf->u32ReadIdx);
+}
+
+uint32_t rbf32_free(const rbf32_t* rbf)
+{
+   return rbf32_capacity(rbf) - rbf32_size(rbf);
+}
+
+uint32_t rbf32_capacity(const rbf32_t* rbf)
+{
+   return rbf->u32Mask + 1;
+}
+
+void rbf32_clear(rbf32_t* rbf)
+{
+   rbf->u32WriteIdx = 0;
+   rbf->u32ReadIdx = 0;
+   rbf->u32ReserveIdx = 0;
+}
+
+#if(RBF32_ATOMIC_ENABLE)
+/**
+ * Producers first claim a slot by advancing u32ReserveIdx, then publish it in claim order by advancing u32WriteIdx.
+ * Claiming never blocks, but publishing spins until every producer with an earlier slot has published. A producer that
+ * is preempted between claim and publish therefore stalls the other producers (the consumer is never blocked).
+ */
+uint8_t rbf32_mpsc_insert(rbf32_t* rbf, const uint8_t* u8Data)
+{
+   uint32_t u32Idx;
+   do
+   {
+      u32Idx = RBF32_LOAD_ACQUIRE(rbf->u32ReserveIdx);
+      if ( (u32Idx - RBF32_LOAD_ACQUIRE(rbf->u32ReadIdx)) > rbf->u32Mask)
+      {
+         return E_BUF_OVERFLOW;
+      }
+   } while (!RBF32_CAS(rbf->u32ReserveIdx, u32Idx, u32Idx + 1));
+   rbf32_copyIn(rbf, u32Idx, u8Data, 1);
+   while (RBF32_LOAD_ACQUIRE(rbf->u32WriteIdx) != u32Idx)
+   {
+      //wait for producers that claimed earlier slots
+   }
+   RBF32_STORE_RELEASE(rbf->u32WriteIdx, u32Idx + 1);
+   return E_BUF_OK;
+}
+#endif
+
+/****************** Private Function Definitions *******************/
+static void rbf32_copyIn(rbf32_t* rbf, uint32_t u32WriteIdx, const uint8_t* u8Data, uint32_t u32NumElem)
+{
+   uint32_t u32Pos = u32WriteIdx & rbf->u32Mask;
+   uint32_t u32First = (rbf->u32Mask + 1) - u32Pos;
+   if (u32First > u32NumElem)
+   {
+      u32First = u32NumElem;
+   }
+   memcpy(&rbf->u8Buffer[u32Pos * rbf->u32ElemSize], u8Data, u32First * rbf->u32ElemSize);
+   if (u32First < u32NumElem)
+   {
+      memcpy(rbf->u8Buffer, u8Data + (u32First * rbf->u32ElemSize), (u32NumElem - u32First) * rbf->u32ElemSize);
+   }
+}
+
+static void rbf32_copyOut(const rbf32_t* rbf, uint32_t u32ReadIdx, uint8_t* u8Data, uint32_t u32NumElem)
+{
+   uint32_t u32Pos = u32ReadIdx & rbf->u32Mask;
+   uint32_t u32First = (rbf->u32Mask + 1) - u32Pos;
+   if (u32First > u32NumElem)
+   {
+      u32First = u32NumElem;
+   }
+   memcpy(u8Data, &rbf->u8Buffer[u32Pos * rbf->u32ElemSize], u32First * rbf->u32ElemSize);
+   if (u32First < u32NumElem)
+   {
+      memcpy(u8Data + (u32First * rbf->u32ElemSize), rbf->u8Buffer, (u32NumElem - u32First) * rbf->u32ElemSize);
+   }
+}
+#endif
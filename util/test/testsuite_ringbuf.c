@@ -0,0 +1,270 @@
+//////////////////////////////////////////////////////////////////////////////
+// INCLUDES
+//////////////////////////////////////////////////////////////////////////////
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "CuTest.h"
+#include "ringbuf.h"
+#if(RBF32_ATOMIC_ENABLE) && !defined(_MSC_VER)
+#include <pthread.h>
+#endif
+#ifdef MEM_LEAK_CHECK
+#include "CMemLeak.h"
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// CONSTANTS AND DATA TYPES
+//////////////////////////////////////////////////////////////////////////////
+#define MPSC_NUM_PRODUCERS 4
+#define MPSC_NUM_ELEM_PER_PRODUCER 10000
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTION PROTOTYPES
+//////////////////////////////////////////////////////////////////////////////
+static void testsuite_rbf32_create(CuTest* tc);
+static void testsuite_rbf32_insertRemove(CuTest* tc);
+static void testsuite_rbf32_insertNRemoveN(CuTest* tc);
+static void testsuite_rbf32_spans(CuTest* tc);
+static void testsuite_rbfs_exists(CuTest* tc);
+#if(RBF32_ATOMIC_ENABLE) && !defined(_MSC_VER)
+static void testsuite_rbf32_mpsc(CuTest* tc);
+static void *mpscProducerTask(void *arg);
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL VARIABLES
+//////////////////////////////////////////////////////////////////////////////
+
+
+//////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+
+
+CuSuite* testsuite_ringbuf(void)
+{
+   CuSuite* suite = CuSuiteNew();
+
+   SUITE_ADD_TEST(suite, testsuite_rbf32_create);
+   SUITE_ADD_TEST(suite, testsuite_rbf32_insertRemove);
+   SUITE_ADD_TEST(suite, testsuite_rbf32_insertNRemoveN);
+   SUITE_ADD_TEST(suite, testsuite_rbf32_spans);
+   SUITE_ADD_TEST(suite, testsuite_rbfs_exists);
+#if(RBF32_ATOMIC_ENABLE) && !defined(_MSC_VER)
+   SUITE_ADD_TEST(suite, testsuite_rbf32_mpsc);
+#endif
+
+   return suite;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LOCAL FUNCTIONS
+//////////////////////////////////////////////////////////////////////////////
+static void testsuite_rbf32_create(CuTest* tc)
+{
+   rbf32_t rbf;
+   uint8_t buf[64];
+   CuAssertUIntEquals(tc, E_BUF_NOT_OK, rbf32_create(&rbf, buf, 0, 4));
+   CuAssertUIntEquals(tc, E_BUF_NOT_OK, rbf32_create(&rbf, buf, 10, 4));
+   CuAssertUIntEquals(tc, E_BUF_NOT_OK, rbf32_create(&rbf, buf, 16, 0));
+   CuAssertUIntEquals(tc, E_BUF_OK, rbf32_create(&rbf, buf, 16, 4));
+   CuAssertUIntEquals(tc, 16, rbf32_capacity(&rbf));
+   CuAssertUIntEquals(tc, 0, rbf32_size(&rbf));
+   CuAssertUIntEquals(tc, 16, rbf32_free(&rbf));
+   CuAssertUIntEquals(tc, 1, rbf32_calcNumElem(0));
+   CuAssertUIntEquals(tc, 1, rbf32_calcNumElem(1));
+   CuAssertUIntEquals(tc, 16, rbf32_calcNumElem(10));
+   CuAssertUIntEquals(tc, 1024, rbf32_calcNumElem(1000));
+   CuAssertUIntEquals(tc, 1024, rbf32_calcNumElem(1024));
+}
+
+static void testsuite_rbf32_insertRemove(CuTest* tc)
+{
+   rbf32_t rbf;
+   uint32_t buf[4];
+   uint32_t value;
+   uint32_t i;
+   CuAssertUIntEquals(tc, E_BUF_OK, rbf32_create(&rbf, (uint8_t*) buf, 4, sizeof(uint32_t)));
+   CuAssertUIntEquals(tc, E_BUF_UNDERFLOW, rbf32_remove(&rbf, (uint8_t*) &value));
+   //run several laps around the buffer
+   for (i = 0; i < 10; i++)
+   {
+      value = i*3;
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_insert(&rbf, (const uint8_t*) &value));
+      value = i*3+1;
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_insert(&rbf, (const uint8_t*) &value));
+      value = i*3+2;
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_insert(&rbf, (const uint8_t*) &value));
+      CuAssertUIntEquals(tc, 3, rbf32_size(&rbf));
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_peek(&rbf, (uint8_t*) &value));
+      CuAssertUIntEquals(tc, i*3, value);
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_remove(&rbf, (uint8_t*) &value));
+      CuAssertUIntEquals(tc, i*3, value);
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_remove(&rbf, (uint8_t*) &value));
+      CuAssertUIntEquals(tc, i*3+1, value);
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_remove(&rbf, (uint8_t*) &value));
+      CuAssertUIntEquals(tc, i*3+2, value);
+   }
+   for (i = 0; i < 4; i++)
+   {
+      CuAssertUIntEquals(tc, E_BUF_OK, rbf32_insert(&rbf, (const uint8_t*) &i));
+   }
+   CuAssertUIntEquals(tc, E_BUF_OVERFLOW, rbf32_insert(&rbf, (const uint8_t*) &i));
+   CuAssertUIntEquals(tc, 0, rbf32_free(&rbf));
+   rbf32_clear(&rbf);
+   CuAssertUIntEquals(tc, 0, rbf32_size(&rbf));
+}
+
+static void testsuite_rbf32_insertNRemoveN(CuTest* tc)
+{
+   rbf32_t rbf;
+   uint16_t buf[8];
+   uint16_t data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+   uint16_t result[10];
+   CuAssertUIntEquals(tc, E_BUF_OK, rbf32_create(&rbf, (uint8_t*) buf, 8, sizeof(uint16_t)));
+   CuAssertUIntEquals(tc, 5, rbf32_insertN(&rbf, (const uint8_t*) data, 5));
+   CuAssertUIntEquals(tc, 3, rbf32_removeN(&rbf, (uint8_t*) result, 3));
+   CuAssertUIntEquals(tc, 1, result[0]);
+   CuAssertUIntEquals(tc, 3, result[2]);
+   //wraps around the end of the buffer and is truncated to the free space
+   CuAssertUIntEquals(tc, 6, rbf32_insertN(&rbf, (const uint8_t*) &data[4], 6));
+   CuAssertUIntEquals(tc, 8, rbf32_size(&rbf));
+   memset(result, 0, sizeof(result));
+   CuAssertUIntEquals(tc, 8, rbf32_removeN(&rbf, (uint8_t*) result, 10));
+   CuAssertUIntEquals(tc, 4, result[0]);
+   CuAssertUIntEquals(tc, 5, result[1]);
+   CuAssertUIntEquals(tc, 5, result[2]);
+   CuAssertUIntEquals(tc, 10, result[7]);
+   CuAssertUIntEquals(tc, 0, rbf32_removeN(&rbf, (uint8_t*) result, 10));
+}
+
+static void testsuite_rbf32_spans(CuTest* tc)
+{
+   rbf32_t rbf;
+   uint8_t buf[8];
+   uint8_t *span;
+   uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+   uint8_t result[6];
+   CuAssertUIntEquals(tc, E_BUF_OK, rbf32_create(&rbf, buf, 8, 1));
+   CuAssertUIntEquals(tc, 0, rbf32_peekSpan(&rbf, &span));
+   CuAssertUIntEquals(tc, 8, rbf32_writeSpan(&rbf, &span));
+   CuAssertPtrEquals(tc, buf, span);
+   memcpy(span, data, 6);
+   rbf32_commit(&rbf, 6);
+   CuAssertUIntEquals(tc, 6, rbf32_peekSpan(&rbf, &span));
+   CuAssertPtrEquals(tc, buf, span);
+   rbf32_consume(&rbf, 4);
+   //only the elements up to the end of the buffer are contiguous
+   CuAssertUIntEquals(tc, 2, rbf32_writeSpan(&rbf, &span));
+   CuAssertPtrEquals(tc, &buf[6], span);
+   CuAssertUIntEquals(tc, 6, rbf32_insertN(&rbf, data, 6));
+   CuAssertUIntEquals(tc, 4, rbf32_peekSpan(&rbf, &span));
+   CuAssertPtrEquals(tc, &buf[4], span);
+   CuAssertUIntEquals(tc, 5, span[0]);
+   rbf32_consume(&rbf, 4);
+   CuAssertUIntEquals(tc, 4, rbf32_peekSpan(&rbf, &span));
+   CuAssertPtrEquals(tc, buf, span);
+   CuAssertUIntEquals(tc, 4, rbf32_removeN(&rbf, result, 6));
+   CuAssertUIntEquals(tc, 3, result[0]);
+   CuAssertUIntEquals(tc, 6, result[3]);
+}
+
+static void testsuite_rbfs_exists(CuTest* tc)
+{
+   rbfs_t rbf;
+   uint8_t buf[3*4];
+   uint8_t elem[3];
+   uint8_t i;
+   rbfs_create(&rbf, buf, 4, sizeof(elem));
+   elem[0] = 0; elem[1] = 1; elem[2] = 2;
+   CuAssertUIntEquals(tc, E_BUF_UNDERFLOW, rbfs_exists(&rbf, elem));
+   //move the read pointer so that the stored elements wrap around the end of the buffer
+   for (i = 0; i < 3; i++)
+   {
+      elem[0] = i;
+      CuAssertUIntEquals(tc, E_BUF_OK, rbfs_insert(&rbf, elem));
+      CuAssertUIntEquals(tc, E_BUF_OK, rbfs_remove(&rbf, elem));
+   }
+   for (i = 0; i < 4; i++)
+   {
+      elem[0] = (uint8_t) (10u + i); elem[1] = 1; elem[2] = 2;
+      CuAssertUIntEquals(tc, E_BUF_OK, rbfs_insert(&rbf, elem));
+   }
+   for (i = 0; i < 4; i++)
+   {
+      elem[0] = (uint8_t) (10u + i);
+      CuAssertUIntEquals(tc, E_BUF_OK, rbfs_exists(&rbf, elem));
+   }
+   elem[0] = 14;
+   CuAssertUIntEquals(tc, E_BUF_UNDERFLOW, rbfs_exists(&rbf, elem));
+   elem[0] = 11; elem[2] = 3;
+   CuAssertUIntEquals(tc, E_BUF_UNDERFLOW, rbfs_exists(&rbf, elem));
+}
+
+#if(RBF32_ATOMIC_ENABLE) && !defined(_MSC_VER)
+typedef struct mpscProducerArg_tag
+{
+   rbf32_t *rbf;
+   uint32_t producerId;
+}mpscProducerArg_t;
+
+static void testsuite_rbf32_mpsc(CuTest* tc)
+{
+   rbf32_t rbf;
+   uint32_t buf[64];
+   uint32_t value;
+   uint32_t numReceived = 0;
+   uint32_t nextExpected[MPSC_NUM_PRODUCERS];
+   pthread_t threads[MPSC_NUM_PRODUCERS];
+   mpscProducerArg_t args[MPSC_NUM_PRODUCERS];
+   int i;
+   CuAssertUIntEquals(tc, E_BUF_OK, rbf32_create(&rbf, (uint8_t*) buf, 64, sizeof(uint32_t)));
+   for (i = 0; i < MPSC_NUM_PRODUCERS; i++)
+   {
+      nextExpected[i] = 0;
+      args[i].rbf = &rbf;
+      args[i].producerId = (uint32_t) i;
+      CuAssertIntEquals(tc, 0, pthread_create(&threads[i], 0, mpscProducerTask, &args[i]));
+   }
+   while (numReceived < MPSC_NUM_PRODUCERS*MPSC_NUM_ELEM_PER_PRODUCER)
+   {
+      if (rbf32_remove(&rbf, (uint8_t*) &value) == E_BUF_OK)
+      {
+         uint32_t producerId = value >> 24;
+         CuAssertTrue(tc, producerId < MPSC_NUM_PRODUCERS);
+         //elements of each producer arrive in order
+         CuAssertUIntEquals(tc, nextExpected[producerId], value & 0xFFFFFF);
+         nextExpected[producerId]++;
+         numReceived++;
+      }
+   }
+   for (i = 0; i < MPSC_NUM_PRODUCERS; i++)
+   {
+      pthread_join(threads[i], 0);
+   }
+   CuAssertUIntEquals(tc, 0, rbf32_size(&rbf));
+}
+
+static void *mpscProducerTask(void *arg)
+{
+   mpscProducerArg_t *producerArg = (mpscProducerArg_t*) arg;
+   uint32_t i;
+   for (i = 0; i < MPSC_NUM_ELEM_PER_PRODUCER; i++)
+   {
+      uint32_t value = (producerArg->producerId << 24) | i;
+      while (rbf32_mpsc_insert(producerArg->rbf, (const uint8_t*) &value) != E_BUF_OK)
+      {
+         //queue full, retry
+      }
+   }
+   return 0;
+}
+#endif